@@ -0,0 +1,193 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <string>
+
+#include "base/bind.h"
+#include "base/macros.h"
+#include "base/single_thread_task_runner.h"
+#include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/thread.h"
+#include "base/time/time.h"
+#include "media/audio/fake_audio_worker.h"
+#include "media/base/audio_bus.h"
+#include "media/base/audio_fifo.h"
+#include "media/base/audio_parameters.h"
+#include "media/base/lock_free_audio_fifo.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace media {
+
+static const int kBenchmarkCallbacks = 1000;
+static const int kFifoBuffers = 8;
+
+// AudioFifo guarded by a lock, as callers of the thread-unsafe FIFOs had to.
+class LockedFifo {
+ public:
+  LockedFifo(int channels, int frames) : fifo_(channels, frames) {}
+
+  bool Push(const AudioBus* source) {
+    base::AutoLock auto_lock(lock_);
+    if (fifo_.frames() + source->frames() > fifo_.max_frames())
+      return false;
+    fifo_.Push(source);
+    return true;
+  }
+
+  bool Consume(AudioBus* destination, int frames) {
+    base::AutoLock auto_lock(lock_);
+    if (fifo_.frames() < frames)
+      return false;
+    fifo_.Consume(destination, 0, frames);
+    return true;
+  }
+
+ private:
+  base::Lock lock_;
+  AudioFifo fifo_;
+
+  DISALLOW_COPY_AND_ASSIGN(LockedFifo);
+};
+
+// Adapts LockFreeAudioFifo to the LockedFifo interface.
+class UnlockedFifo {
+ public:
+  UnlockedFifo(int channels, int frames) : fifo_(channels, frames) {}
+
+  bool Push(const AudioBus* source) { return fifo_.Push(source); }
+  bool Consume(AudioBus* destination, int frames) {
+    return fifo_.Consume(destination, 0, frames);
+  }
+
+ private:
+  LockFreeAudioFifo fifo_;
+
+  DISALLOW_COPY_AND_ASSIGN(UnlockedFifo);
+};
+
+// Drives a FIFO from a FakeAudioWorker callback, standing in for a real-time
+// capture callback, while the test thread drains it as fast as it can.
+// Records how long each Push() takes and how regularly the callbacks run.
+template <typename Fifo>
+class FifoJitterBenchmark {
+ public:
+  explicit FifoJitterBenchmark(const AudioParameters& params)
+      : params_(params),
+        fifo_(params.channels(), params.frames_per_buffer() * kFifoBuffers),
+        source_(AudioBus::Create(params)),
+        callbacks_(0),
+        max_push_time_(),
+        total_push_time_(),
+        interval_sum_us_(0),
+        interval_sum_squares_us_(0),
+        dropped_buffers_(0),
+        done_(base::WaitableEvent::ResetPolicy::MANUAL,
+              base::WaitableEvent::InitialState::NOT_SIGNALED) {
+    source_->Zero();
+  }
+
+  void Run(const std::string& trace_name) {
+    base::Thread worker_thread("FakeAudioWorker");
+    base::Thread::Options options;
+    options.priority = base::ThreadPriority::REALTIME_AUDIO;
+    ASSERT_TRUE(worker_thread.StartWithOptions(options));
+
+    FakeAudioWorker worker(worker_thread.task_runner(), params_);
+    worker.Start(base::Bind(&FifoJitterBenchmark::OnWorkerCallback,
+                            base::Unretained(this)));
+
+    std::unique_ptr<AudioBus> dest = AudioBus::Create(params_);
+    while (!done_.IsSignaled()) {
+      if (!fifo_.Consume(dest.get(), dest->frames()))
+        base::PlatformThread::YieldCurrentThread();
+    }
+
+    worker.Stop();
+    worker_thread.Stop();
+
+    // Exclude the first callback, which has no preceding interval.
+    const int intervals = kBenchmarkCallbacks - 1;
+    const double mean_interval_us = interval_sum_us_ / intervals;
+    const double jitter_us = std::sqrt(std::max(
+        0.0, interval_sum_squares_us_ / intervals -
+                 mean_interval_us * mean_interval_us));
+
+    perf_test::PrintResult("audio_fifo_push_time", "_max", trace_name,
+                           max_push_time_.InMicrosecondsF(), "us", true);
+    perf_test::PrintResult(
+        "audio_fifo_push_time", "_mean", trace_name,
+        total_push_time_.InMicrosecondsF() / kBenchmarkCallbacks, "us", true);
+    perf_test::PrintResult("audio_fifo_callback_jitter", "", trace_name,
+                           jitter_us, "us", true);
+    perf_test::PrintResult("audio_fifo_dropped_buffers", "", trace_name,
+                           static_cast<size_t>(dropped_buffers_), "buffers",
+                           true);
+  }
+
+ private:
+  // Called on |worker_thread| by FakeAudioWorker.
+  void OnWorkerCallback() {
+    if (callbacks_ >= kBenchmarkCallbacks)
+      return;
+
+    const base::TimeTicks start = base::TimeTicks::Now();
+    if (!fifo_.Push(source_.get()))
+      ++dropped_buffers_;
+    const base::TimeDelta push_time = base::TimeTicks::Now() - start;
+    max_push_time_ = std::max(max_push_time_, push_time);
+    total_push_time_ += push_time;
+
+    if (!last_callback_time_.is_null()) {
+      const double interval_us =
+          (start - last_callback_time_).InMicrosecondsF();
+      interval_sum_us_ += interval_us;
+      interval_sum_squares_us_ += interval_us * interval_us;
+    }
+    last_callback_time_ = start;
+
+    if (++callbacks_ == kBenchmarkCallbacks)
+      done_.Signal();
+  }
+
+  const AudioParameters params_;
+  Fifo fifo_;
+  std::unique_ptr<AudioBus> source_;
+
+  // Only accessed on the worker thread until |done_| is signaled.
+  int callbacks_;
+  base::TimeTicks last_callback_time_;
+  base::TimeDelta max_push_time_;
+  base::TimeDelta total_push_time_;
+  double interval_sum_us_;
+  double interval_sum_squares_us_;
+  int dropped_buffers_;
+
+  base::WaitableEvent done_;
+
+  DISALLOW_COPY_AND_ASSIGN(FifoJitterBenchmark);
+};
+
+// Compares a lock-guarded AudioFifo with LockFreeAudioFifo when the consumer
+// is continuously contending for the FIFO.
+TEST(AudioFifoPerfTest, PushJitter) {
+  // Small buffers give frequent callbacks, which is where contention matters.
+  const AudioParameters params(AudioParameters::AUDIO_FAKE,
+                               CHANNEL_LAYOUT_STEREO, 48000, 16, 128);
+  {
+    FifoJitterBenchmark<LockedFifo> benchmark(params);
+    benchmark.Run("locked_audio_fifo");
+  }
+  {
+    FifoJitterBenchmark<UnlockedFifo> benchmark(params);
+    benchmark.Run("lock_free_audio_fifo");
+  }
+}
+
+}  // namespace media
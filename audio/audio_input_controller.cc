@@ -18,12 +18,17 @@
 #include "base/time/time.h"
 #include "base/trace_event/trace_event.h"
 #include "media/audio/audio_input_writer.h"
+#include "media/base/lock_free_audio_fifo.h"
 #include "media/base/user_input_monitor.h"
 
 namespace {
 
 const int kMaxInputChannels = 3;
 
+// Number of OnData() buffers which can be queued for the audio thread when
+// there is no SyncWriter before further data is dropped.
+const int kDataFifoBuffers = 16;
+
 #if defined(AUDIO_POWER_MONITORING)
 // Time in seconds between two successive measurements of audio power levels.
 const int kPowerMonitorLogIntervalSeconds = 15;
@@ -107,7 +112,10 @@ AudioInputController::AudioInputController(
       silence_state_(SILENCE_STATE_NO_MEASUREMENT),
 #endif
       prev_key_down_count_(0),
-      debug_writer_(std::move(debug_writer)) {
+      debug_writer_(std::move(debug_writer)),
+      data_buffer_frames_(0),
+      drain_pending_(0),
+      dropped_frames_(0) {
   DCHECK(creator_task_runner_.get());
 }
 
@@ -496,25 +504,49 @@ void AudioInputController::OnData(AudioInputStream* stream,
     return;
   }
 
-  // TODO(henrika): Investigate if we can avoid the extra copy here.
-  // (see http://crbug.com/249316 for details). AFAIK, this scope is only
-  // active for WebSpeech clients.
-  std::unique_ptr<AudioBus> audio_data =
-      AudioBus::Create(source->channels(), source->frames());
-  source->CopyTo(audio_data.get());
-
-  // Ownership of the audio buffer will be with the callback until it is run,
-  // when ownership is passed to the callback function.
-  task_runner_->PostTask(
-      FROM_HERE,
-      base::Bind(
-          &AudioInputController::DoOnData, this, base::Passed(&audio_data)));
+  // Queue the data for the audio thread without allocating or blocking here;
+  // this scope is only active for WebSpeech clients.  The FIFO is created once,
+  // on the first callback, since the buffer size isn't known before then.
+  if (!data_fifo_) {
+    data_buffer_frames_ = source->frames();
+    data_fifo_.reset(new LockFreeAudioFifo(
+        source->channels(), source->frames() * kDataFifoBuffers));
+  }
+  if (!data_fifo_->Push(source))
+    base::subtle::NoBarrier_AtomicIncrement(&dropped_frames_, source->frames());
+
+  // Pairs with the barrier in DoDrainData(): either the pending drain sees the
+  // data pushed above, or it has already cleared |drain_pending_| and a new
+  // drain is posted.
+  base::subtle::MemoryBarrier();
+  if (base::subtle::NoBarrier_AtomicExchange(&drain_pending_, 1) == 0) {
+    task_runner_->PostTask(
+        FROM_HERE, base::Bind(&AudioInputController::DoDrainData, this));
+  }
 }
 
-void AudioInputController::DoOnData(std::unique_ptr<AudioBus> data) {
+void AudioInputController::DoDrainData() {
   DCHECK(task_runner_->BelongsToCurrentThread());
-  if (handler_)
-    handler_->OnData(this, data.get());
+
+  // Clear the flag before draining so that data pushed from here on posts
+  // another drain.
+  base::subtle::NoBarrier_Store(&drain_pending_, 0);
+  base::subtle::MemoryBarrier();
+
+  if (!drain_bus_) {
+    drain_bus_ = AudioBus::Create(data_fifo_->channels(), data_buffer_frames_);
+  }
+  while (data_fifo_->Consume(drain_bus_.get(), 0, drain_bus_->frames())) {
+    if (handler_)
+      handler_->OnData(this, drain_bus_.get());
+  }
+
+  const int dropped_frames =
+      base::subtle::NoBarrier_AtomicExchange(&dropped_frames_, 0);
+  if (dropped_frames > 0 && handler_) {
+    handler_->OnLog(this, "AIC::DoDrainData: dropped " +
+                              base::IntToString(dropped_frames) + " frames");
+  }
 }
 
 void AudioInputController::DoLogAudioLevels(float level_dbfs,
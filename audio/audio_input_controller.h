@@ -82,6 +82,7 @@ namespace media {
 #endif
 
 class AudioInputWriter;
+class LockFreeAudioFifo;
 class UserInputMonitor;
 
 class MEDIA_EXPORT AudioInputController
@@ -306,7 +307,7 @@ class MEDIA_EXPORT AudioInputController
   void DoClose();
   void DoReportError();
   void DoSetVolume(double volume);
-  void DoOnData(std::unique_ptr<AudioBus> data);
+  void DoDrainData();
   void DoLogAudioLevels(float level_dbfs, int microphone_volume_percent);
 
   // Helper method that stops, closes, and NULL:s |*stream_|.
@@ -394,6 +395,25 @@ class MEDIA_EXPORT AudioInputController
   // Used for audio debug recordings. Accessed on audio thread.
   const std::unique_ptr<AudioInputWriter> debug_writer_;
 
+  // Hands captured audio from OnData() to DoDrainData() on the audio thread
+  // when there is no SyncWriter, without allocating or locking on the
+  // real-time thread.  Created by the first OnData() call and sized from its
+  // buffer; afterwards OnData() is the only producer and DoDrainData() the
+  // only consumer.
+  std::unique_ptr<LockFreeAudioFifo> data_fifo_;
+  int data_buffer_frames_;
+
+  // Destination for DoDrainData(); only used on the audio thread.
+  std::unique_ptr<AudioBus> drain_bus_;
+
+  // Non-zero while a DoDrainData() task is pending, so that OnData() posts at
+  // most one at a time.
+  base::subtle::Atomic32 drain_pending_;
+
+  // Frames dropped by OnData() because |data_fifo_| was full; reported and
+  // reset by DoDrainData().
+  base::subtle::Atomic32 dropped_frames_;
+
  private:
   DISALLOW_COPY_AND_ASSIGN(AudioInputController);
 };
@@ -22,6 +22,11 @@
 
 namespace media {
 
+// Maximum number of inputs rendered before being mixed into the destination.
+// Bounds the scratch memory used for mixing while still letting each
+// destination sample be accumulated from many inputs at once.
+static const int kMaxInputBatchSize = 8;
+
 AudioConverter::AudioConverter(const AudioParameters& input_params,
                                const AudioParameters& output_params,
                                bool disable_fifo)
@@ -88,9 +93,10 @@ void AudioConverter::AddInput(InputCallback* input) {
 }
 
 void AudioConverter::RemoveInput(InputCallback* input) {
-  DCHECK(std::find(transform_inputs_.begin(), transform_inputs_.end(), input) !=
-         transform_inputs_.end());
-  transform_inputs_.remove(input);
+  InputCallbackSet::iterator it =
+      std::find(transform_inputs_.begin(), transform_inputs_.end(), input);
+  DCHECK(it != transform_inputs_.end());
+  transform_inputs_.erase(it);
 
   if (transform_inputs_.empty())
     Reset();
@@ -162,12 +168,6 @@ void AudioConverter::Convert(AudioBus* dest) {
 void AudioConverter::SourceCallback(int fifo_frame_delay, AudioBus* dest) {
   const bool needs_downmix = channel_mixer_ && downmix_early_;
 
-  if (!mixer_input_audio_bus_ ||
-      mixer_input_audio_bus_->frames() != dest->frames()) {
-    mixer_input_audio_bus_ =
-        AudioBus::Create(input_channel_count_, dest->frames());
-  }
-
   // If we're downmixing early we need a temporary AudioBus which matches
   // the the input channel count and input frame size since we're passing
   // |unmixed_audio_| directly to the |source_callback_|.
@@ -177,8 +177,7 @@ void AudioConverter::SourceCallback(int fifo_frame_delay, AudioBus* dest) {
   AudioBus* const temp_dest = needs_downmix ? unmixed_audio_.get() : dest;
 
   // Sanity check our inputs.
-  DCHECK_EQ(temp_dest->frames(), mixer_input_audio_bus_->frames());
-  DCHECK_EQ(temp_dest->channels(), mixer_input_audio_bus_->channels());
+  DCHECK_EQ(temp_dest->channels(), input_channel_count_);
 
   // |total_frames_delayed| is reported to the *input* source in terms of the
   // *input* sample rate. |initial_frames_delayed_| is given in terms of the
@@ -197,40 +196,60 @@ void AudioConverter::SourceCallback(int fifo_frame_delay, AudioBus* dest) {
   }
 
   // If we only have a single input, avoid an extra copy.
-  AudioBus* const provide_input_dest =
-      transform_inputs_.size() == 1 ? temp_dest : mixer_input_audio_bus_.get();
-
-  // Have each mixer render its data into an output buffer then mix the result.
-  for (auto* input : transform_inputs_) {
-    const float volume =
-        input->ProvideInput(provide_input_dest, total_frames_delayed);
+  if (transform_inputs_.size() == 1) {
+    const float volume = transform_inputs_.front()->ProvideInput(
+        temp_dest, total_frames_delayed);
     // Optimize the most common single input, full volume case.
-    if (input == transform_inputs_.front()) {
-      if (volume == 1.0f) {
-        if (temp_dest != provide_input_dest)
-          provide_input_dest->CopyTo(temp_dest);
-      } else if (volume > 0) {
-        for (int i = 0; i < provide_input_dest->channels(); ++i) {
-          vector_math::FMUL(
-              provide_input_dest->channel(i), volume,
-              provide_input_dest->frames(), temp_dest->channel(i));
-        }
-      } else {
-        // Zero |temp_dest| otherwise, so we're mixing into a clean buffer.
-        temp_dest->Zero();
+    if (volume == 1.0f) {
+      // Nothing to do, the input rendered directly into |temp_dest|.
+    } else if (volume > 0) {
+      for (int i = 0; i < temp_dest->channels(); ++i) {
+        vector_math::FMUL(temp_dest->channel(i), volume, temp_dest->frames(),
+                          temp_dest->channel(i));
       }
-
-      continue;
+    } else {
+      temp_dest->Zero();
+    }
+  } else {
+    const size_t batch_buses = std::min(
+        transform_inputs_.size(), static_cast<size_t>(kMaxInputBatchSize));
+    if (!mixer_input_audio_buses_.empty() &&
+        mixer_input_audio_buses_.front()->frames() != temp_dest->frames()) {
+      mixer_input_audio_buses_.clear();
+    }
+    while (mixer_input_audio_buses_.size() < batch_buses) {
+      mixer_input_audio_buses_.push_back(
+          AudioBus::Create(input_channel_count_, temp_dest->frames()));
     }
 
-    // Volume adjust and mix each mixer input into |temp_dest| after rendering.
-    if (volume > 0) {
-      for (int i = 0; i < mixer_input_audio_bus_->channels(); ++i) {
-        vector_math::FMAC(
-            mixer_input_audio_bus_->channel(i), volume,
-            mixer_input_audio_bus_->frames(), temp_dest->channel(i));
+    // Have each input render its data into the next free batch slot, then mix
+    // the batch into |temp_dest| once it fills up.  Silent inputs cost nothing
+    // beyond ProvideInput() since their slot is simply reused.
+    float volumes[kMaxInputBatchSize];
+    int batch_size = 0;
+    bool dest_is_empty = true;
+    for (auto* input : transform_inputs_) {
+      const float volume = input->ProvideInput(
+          mixer_input_audio_buses_[batch_size].get(), total_frames_delayed);
+      if (volume <= 0)
+        continue;
+
+      volumes[batch_size++] = volume;
+      if (batch_size == kMaxInputBatchSize) {
+        MixInputBatch(batch_size, volumes, dest_is_empty, temp_dest);
+        dest_is_empty = false;
+        batch_size = 0;
       }
     }
+
+    if (batch_size > 0) {
+      MixInputBatch(batch_size, volumes, dest_is_empty, temp_dest);
+      dest_is_empty = false;
+    }
+
+    // Zero |temp_dest| if every input was silent.
+    if (dest_is_empty)
+      temp_dest->Zero();
   }
 
   if (needs_downmix) {
@@ -239,6 +258,40 @@ void AudioConverter::SourceCallback(int fifo_frame_delay, AudioBus* dest) {
   }
 }
 
+void AudioConverter::MixInputBatch(int count,
+                                   const float* volumes,
+                                   bool dest_is_empty,
+                                   AudioBus* dest) {
+  DCHECK_GT(count, 0);
+  DCHECK_LE(count, kMaxInputBatchSize);
+
+  // Write the first input directly when there's nothing to accumulate into.
+  int first_input = 0;
+  if (dest_is_empty) {
+    AudioBus* const input_bus = mixer_input_audio_buses_[0].get();
+    if (volumes[0] == 1.0f) {
+      input_bus->CopyTo(dest);
+    } else {
+      for (int i = 0; i < dest->channels(); ++i) {
+        vector_math::FMUL(input_bus->channel(i), volumes[0], dest->frames(),
+                          dest->channel(i));
+      }
+    }
+    first_input = 1;
+  }
+
+  if (first_input == count)
+    return;
+
+  const float* sources[kMaxInputBatchSize];
+  for (int i = 0; i < dest->channels(); ++i) {
+    for (int j = first_input; j < count; ++j)
+      sources[j - first_input] = mixer_input_audio_buses_[j]->channel(i);
+    vector_math::FMACBatch(sources, volumes + first_input, count - first_input,
+                           dest->frames(), dest->channel(i));
+  }
+}
+
 void AudioConverter::ProvideInput(int resampler_frame_delay, AudioBus* dest) {
   resampler_frames_delayed_ = resampler_frame_delay;
   if (audio_fifo_)
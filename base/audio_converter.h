@@ -18,8 +18,8 @@
 #ifndef MEDIA_BASE_AUDIO_CONVERTER_H_
 #define MEDIA_BASE_AUDIO_CONVERTER_H_
 
-#include <list>
 #include <memory>
+#include <vector>
 
 #include "base/callback.h"
 #include "base/macros.h"
@@ -110,8 +110,17 @@ class MEDIA_EXPORT AudioConverter {
   // (Re)creates the temporary |unmixed_audio_| buffer if necessary.
   void CreateUnmixedAudioIfNecessary(int frames);
 
-  // Set of inputs for Convert().
-  typedef std::list<InputCallback*> InputCallbackSet;
+  // Mixes the first |count| buffers of |mixer_input_audio_buses_| into |dest|
+  // using the matching |volumes|.  If |dest_is_empty| the first buffer is
+  // written rather than accumulated.
+  void MixInputBatch(int count,
+                     const float* volumes,
+                     bool dest_is_empty,
+                     AudioBus* dest);
+
+  // Set of inputs for Convert().  Kept in a flat array since it's walked once
+  // per render on the audio thread.
+  typedef std::vector<InputCallback*> InputCallbackSet;
   InputCallbackSet transform_inputs_;
 
   // Used to buffer data between the client and the output device in cases where
@@ -127,8 +136,11 @@ class MEDIA_EXPORT AudioConverter {
   std::unique_ptr<ChannelMixer> channel_mixer_;
   std::unique_ptr<AudioBus> unmixed_audio_;
 
-  // Temporary AudioBus destination for mixing inputs.
-  std::unique_ptr<AudioBus> mixer_input_audio_bus_;
+  // Temporary AudioBus destinations for mixing inputs.  Inputs are rendered
+  // in batches of up to kMaxInputBatchSize and then mixed together with a
+  // single pass over the destination; inputs which return a volume of zero
+  // don't take up a slot and are never mixed.
+  std::vector<std::unique_ptr<AudioBus>> mixer_input_audio_buses_;
 
   // Since resampling is expensive, figure out if we should downmix channels
   // before resampling.
@@ -3,7 +3,10 @@
 // found in the LICENSE file.
 
 #include <memory>
+#include <vector>
 
+#include "base/memory/ptr_util.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/time/time.h"
 #include "media/base/audio_converter.h"
 #include "media/base/fake_audio_render_callback.h"
@@ -13,17 +16,22 @@
 namespace media {
 
 static const int kBenchmarkIterations = 200000;
+static const int kMixBenchmarkIterations = 20000;
 
 // InputCallback that zero's out the provided AudioBus.
 class NullInputProvider : public AudioConverter::InputCallback {
  public:
-  NullInputProvider() {}
+  NullInputProvider() : volume_(1) {}
+  explicit NullInputProvider(double volume) : volume_(volume) {}
   ~NullInputProvider() override {}
 
   double ProvideInput(AudioBus* audio_bus, uint32_t frames_delayed) override {
     audio_bus->Zero();
-    return 1;
+    return volume_;
   }
+
+ private:
+  const double volume_;
 };
 
 void RunConvertBenchmark(const AudioParameters& in_params,
@@ -50,6 +58,34 @@ void RunConvertBenchmark(const AudioParameters& in_params,
       "audio_converter", "", trace_name, runs_per_second, "runs/s", true);
 }
 
+// Mixes |inputs| inputs at the output parameters, as AudioRendererMixer does
+// for its master converter.  Every |silent_interval|'th input returns a volume
+// of zero; pass 0 to keep all inputs audible.
+void RunMixBenchmark(const AudioParameters& params,
+                     int inputs,
+                     int silent_interval,
+                     const std::string& trace_name) {
+  std::vector<std::unique_ptr<NullInputProvider>> fake_inputs;
+  std::unique_ptr<AudioBus> output_bus = AudioBus::Create(params);
+
+  AudioConverter converter(params, params, true);
+  for (int i = 0; i < inputs; ++i) {
+    const bool silent = silent_interval && i % silent_interval == 0;
+    fake_inputs.push_back(
+        base::MakeUnique<NullInputProvider>(silent ? 0.0 : 0.5));
+    converter.AddInput(fake_inputs.back().get());
+  }
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kMixBenchmarkIterations; ++i)
+    converter.Convert(output_bus.get());
+  double runs_per_second = kMixBenchmarkIterations /
+                           (base::TimeTicks::Now() - start).InSecondsF();
+  perf_test::PrintResult("audio_converter_mix",
+                         "_inputs_" + base::IntToString(inputs), trace_name,
+                         runs_per_second, "runs/s", true);
+}
+
 TEST(AudioConverterPerfTest, ConvertBenchmark) {
   // Create input and output parameters to convert between the two most common
   // sets of parameters (as indicated via UMA data).
@@ -77,4 +113,18 @@ TEST(AudioConverterPerfTest, ConvertBenchmarkFIFO) {
                       "convert_pass_through");
 }
 
+TEST(AudioConverterPerfTest, MixBenchmark) {
+  // Typical output device parameters; mixing cost scales with the number of
+  // inputs rather than with any conversion.
+  AudioParameters params(
+      AudioParameters::AUDIO_PCM_LOW_LATENCY, CHANNEL_LAYOUT_STEREO, 48000, 16,
+      480);
+
+  static const int kInputCounts[] = {1, 8, 50, 100, 200};
+  for (int inputs : kInputCounts) {
+    RunMixBenchmark(params, inputs, 0, "audible");
+    RunMixBenchmark(params, inputs, 2, "half_silent");
+  }
+}
+
 } // namespace media
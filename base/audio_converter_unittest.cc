@@ -26,6 +26,11 @@ namespace media {
 static const int kConvertInputs = 8;
 static const int kConvertCycles = 3;
 
+// Parameters which control the batched mixing test; enough audible inputs to
+// span more than one mixing batch, interleaved with silent inputs.
+static const int kBatchedConvertInputs = 20;
+static const float kBatchedInputVolume = 1.0f / 16;
+
 // Parameters used for testing.
 static const int kBitsPerChannel = 32;
 static const ChannelLayout kChannelLayout = CHANNEL_LAYOUT_STEREO;
@@ -256,6 +261,19 @@ TEST_P(AudioConverterTest, ManyInputs) {
   RunTest(kConvertInputs);
 }
 
+TEST_P(AudioConverterTest, ManyInputsWithSilence) {
+  InitializeInputs(kBatchedConvertInputs);
+
+  float total_scale = 0;
+  for (size_t i = 0; i < fake_callbacks_.size(); ++i) {
+    const float volume = i % 2 ? kBatchedInputVolume : 0;
+    total_scale += volume;
+    fake_callbacks_[i]->set_volume(volume);
+  }
+  for (int i = 0; i < kConvertCycles; ++i)
+    ASSERT_TRUE(RenderAndValidateAudioData(total_scale));
+}
+
 INSTANTIATE_TEST_CASE_P(
     AudioConverterTest, AudioConverterTest, testing::Values(
         // No resampling. No channel mixing.
@@ -4,23 +4,32 @@
 
 #include "media/base/byte_queue.h"
 
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+
 #include "base/logging.h"
 
 namespace media {
 
-// Default starting size for the queue.
+// Default starting size for a chunk. Small appends are packed into the spare
+// capacity of the last chunk rather than each getting their own allocation.
 enum { kDefaultQueueSize = 1024 };
 
-ByteQueue::ByteQueue()
-    : buffer_(new uint8_t[kDefaultQueueSize]),
-      size_(kDefaultQueueSize),
-      offset_(0),
-      used_(0) {}
+ByteQueue::Chunk::Chunk(size_t capacity)
+    : data(new uint8_t[capacity]), capacity(capacity), begin(0), end(0) {}
+
+ByteQueue::Chunk::Chunk(Chunk&& other) = default;
+
+ByteQueue::Chunk::~Chunk() {}
+
+ByteQueue::ByteQueue() : used_(0), bytes_copied_(0) {}
 
 ByteQueue::~ByteQueue() {}
 
 void ByteQueue::Reset() {
-  offset_ = 0;
+  chunks_.clear();
   used_ = 0;
 }
 
@@ -28,58 +37,95 @@ void ByteQueue::Push(const uint8_t* data, int size) {
   DCHECK(data);
   DCHECK_GT(size, 0);
 
-  size_t size_needed = used_ + size;
-
-  // Check to see if we need a bigger buffer.
-  if (size_needed > size_) {
-    size_t new_size = 2 * size_;
-    while (size_needed > new_size && new_size > size_)
-      new_size *= 2;
-
-    // Sanity check to make sure we didn't overflow.
-    CHECK_GT(new_size, size_);
-
-    std::unique_ptr<uint8_t[]> new_buffer(new uint8_t[new_size]);
-
-    // Copy the data from the old buffer to the start of the new one.
-    if (used_ > 0)
-      memcpy(new_buffer.get(), front(), used_);
+  // Sanity check to make sure we don't overflow.
+  CHECK_LE(size, std::numeric_limits<int>::max() - used_);
 
-    buffer_ = std::move(new_buffer);
-    size_ = new_size;
-    offset_ = 0;
-  } else if ((offset_ + used_ + size) > size_) {
-    // The buffer is big enough, but we need to move the data in the queue.
-    memmove(buffer_.get(), front(), used_);
-    offset_ = 0;
+  if (chunks_.empty() ||
+      chunks_.back().capacity - chunks_.back().end <
+          static_cast<size_t>(size)) {
+    chunks_.emplace_back(
+        std::max(static_cast<size_t>(size),
+                 static_cast<size_t>(kDefaultQueueSize)));
   }
 
-  memcpy(front() + used_, data, size);
+  Chunk& tail = chunks_.back();
+  memcpy(tail.data.get() + tail.end, data, size);
+  tail.end += size;
   used_ += size;
+  bytes_copied_ += size;
 }
 
-void ByteQueue::Peek(const uint8_t** data, int* size) const {
+void ByteQueue::Peek(const uint8_t** data, int* size) {
+  PeekAtLeast(used_, data, size);
+}
+
+void ByteQueue::PeekAtLeast(int min_size, const uint8_t** data, int* size) {
   DCHECK(data);
   DCHECK(size);
-  *data = front();
-  *size = used_;
+  DCHECK_GE(min_size, 0);
+
+  if (used_ == 0) {
+    *data = nullptr;
+    *size = 0;
+    return;
+  }
+
+  const size_t needed = std::min(min_size, used_);
+  if (chunks_.front().available() < needed)
+    Coalesce(needed);
+
+  const Chunk& front = chunks_.front();
+  *data = front.data.get() + front.begin;
+  *size = front.available();
 }
 
 void ByteQueue::Pop(int count) {
   DCHECK_LE(count, used_);
-
-  offset_ += count;
   used_ -= count;
 
-  // Move the offset back to 0 if we have reached the end of the buffer.
-  if (offset_ == size_) {
-    DCHECK_EQ(used_, 0);
-    offset_ = 0;
+  size_t remaining = count;
+  while (remaining > 0) {
+    Chunk& front = chunks_.front();
+    const size_t popped = std::min(remaining, front.available());
+    front.begin += popped;
+    remaining -= popped;
+
+    if (front.begin < front.end)
+      continue;
+
+    // Keep the storage of the last chunk around so that a steady stream of
+    // small appends and pops does not reallocate.
+    if (chunks_.size() == 1) {
+      DCHECK_EQ(used_, 0);
+      front.begin = front.end = 0;
+    } else {
+      chunks_.pop_front();
+    }
   }
 }
 
-uint8_t* ByteQueue::front() const {
-  return buffer_.get() + offset_;
+void ByteQueue::Coalesce(size_t min_size) {
+  DCHECK_LE(min_size, static_cast<size_t>(used_));
+
+  // When the whole queue is being coalesced the new chunk becomes the tail,
+  // so leave room for future appends to keep Push() + Peek() amortized.
+  const bool whole_queue = min_size == static_cast<size_t>(used_);
+  Chunk merged(std::max(whole_queue ? 2 * min_size : min_size,
+                        static_cast<size_t>(kDefaultQueueSize)));
+
+  while (merged.end < min_size) {
+    Chunk& front = chunks_.front();
+    const size_t copied = std::min(min_size - merged.end, front.available());
+    memcpy(merged.data.get() + merged.end, front.data.get() + front.begin,
+           copied);
+    merged.end += copied;
+    front.begin += copied;
+    if (front.begin == front.end)
+      chunks_.pop_front();
+  }
+
+  bytes_copied_ += min_size;
+  chunks_.push_front(std::move(merged));
 }
 
 }  // namespace media
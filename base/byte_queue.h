@@ -8,6 +8,7 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <deque>
 #include <memory>
 
 #include "base/macros.h"
@@ -17,9 +18,14 @@ namespace media {
 
 // Represents a queue of bytes.
 // Data is added to the end of the queue via an Push() call and removed via
-// Pop(). The contents of the queue can be observed via the Peek() method.
-// This class manages the underlying storage of the queue and tries to minimize
-// the number of buffer copies when data is appended and removed.
+// Pop(). The contents of the queue can be observed via the Peek() and
+// PeekAtLeast() methods.
+//
+// Storage is segmented: each Push() either fills the spare capacity of the
+// last chunk or appends a new chunk, so previously queued bytes are never
+// moved or reallocated on append. Bytes are only copied again when a caller
+// asks for a contiguous view that spans a chunk boundary, and then only the
+// bytes needed to satisfy the request are coalesced.
 class MEDIA_EXPORT ByteQueue {
  public:
   ByteQueue();
@@ -31,29 +37,62 @@ class MEDIA_EXPORT ByteQueue {
   // Appends new bytes onto the end of the queue.
   void Push(const uint8_t* data, int size);
 
-  // Get a pointer to the front of the queue and the queue size.
-  // These values are only valid until the next Push() or
-  // Pop() call.
-  void Peek(const uint8_t** data, int* size) const;
+  // Get a pointer to the front of the queue and the queue size. The whole
+  // queue is made contiguous, which may require a copy if it currently spans
+  // several chunks. Prefer PeekAtLeast() when the caller consumes the queue in
+  // bounded units. These values are only valid until the next Push(),
+  // Pop(), Peek() or PeekAtLeast() call.
+  void Peek(const uint8_t** data, int* size);
+
+  // Get a pointer to a contiguous run of bytes at the front of the queue and
+  // the length of that run. The run holds at least |min_size| bytes, or the
+  // whole queue if fewer bytes are queued; it may be longer than |min_size|.
+  // Only bytes spanning a chunk boundary within the first |min_size| bytes
+  // are copied. These values are only valid until the next Push(), Pop(),
+  // Peek() or PeekAtLeast() call.
+  void PeekAtLeast(int min_size, const uint8_t** data, int* size);
 
   // Remove |count| bytes from the front of the queue.
   void Pop(int count);
 
+  // Number of bytes stored in the queue.
+  int size() const { return used_; }
+
+  // Total number of bytes copied into queue storage since construction,
+  // including the initial copy made by Push(). Used to measure copy overhead.
+  int64_t bytes_copied() const { return bytes_copied_; }
+
  private:
-  // Returns a pointer to the front of the queue.
-  uint8_t* front() const;
+  struct Chunk {
+    explicit Chunk(size_t capacity);
+    Chunk(Chunk&& other);
+    ~Chunk();
+
+    size_t available() const { return end - begin; }
 
-  std::unique_ptr<uint8_t[]> buffer_;
+    std::unique_ptr<uint8_t[]> data;
 
-  // Size of |buffer_|.
-  size_t size_;
+    // Size of |data|.
+    size_t capacity;
 
-  // Offset from the start of |buffer_| that marks the front of the queue.
-  size_t offset_;
+    // Offset of the first unread byte in |data|.
+    size_t begin;
+
+    // Offset one past the last written byte in |data|.
+    size_t end;
+  };
+
+  // Ensures the first chunk holds at least |min_size| bytes by moving the
+  // leading |min_size| bytes of the queue into a new front chunk.
+  void Coalesce(size_t min_size);
+
+  std::deque<Chunk> chunks_;
 
   // Number of bytes stored in the queue.
   int used_;
 
+  int64_t bytes_copied_;
+
   DISALLOW_COPY_AND_ASSIGN(ByteQueue);
 };
 
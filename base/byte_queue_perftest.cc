@@ -0,0 +1,73 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include "base/time/time.h"
+#include "media/base/byte_queue.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace media {
+
+static const int kBenchmarkIterations = 20;
+static const int kAppendSize = 2 * 1024 * 1024;
+static const int kAppendsPerIteration = 16;
+
+// Size of a MPEG-2 TS packet; a typical fixed-size unit consumed by parsers.
+static const int kParseUnitSize = 188;
+
+// Appends |kAppendsPerIteration| chunks of |kAppendSize| bytes and consumes
+// them in |kParseUnitSize| units, either through bounded PeekAtLeast() views
+// or through whole-queue Peek() calls (the pattern all parsers used before the
+// queue was segmented).
+static void RunByteQueueBenchmark(bool bounded_views,
+                                  const std::string& trace_name) {
+  std::vector<uint8_t> append(kAppendSize, 0x47);
+  ByteQueue queue;
+  int64_t bytes_appended = 0;
+  uint32_t checksum = 0;
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kBenchmarkIterations; ++i) {
+    for (int j = 0; j < kAppendsPerIteration; ++j) {
+      queue.Push(append.data(), append.size());
+      bytes_appended += append.size();
+
+      for (;;) {
+        const uint8_t* data;
+        int size;
+        if (bounded_views)
+          queue.PeekAtLeast(kParseUnitSize, &data, &size);
+        else
+          queue.Peek(&data, &size);
+        if (size < kParseUnitSize)
+          break;
+        checksum += data[0];
+        queue.Pop(kParseUnitSize);
+      }
+    }
+  }
+  double total_time_milliseconds =
+      (base::TimeTicks::Now() - start).InMillisecondsF();
+  EXPECT_NE(0u, checksum);
+
+  perf_test::PrintResult(
+      "byte_queue_bytes_copied_per_appended_byte", "", trace_name,
+      static_cast<double>(queue.bytes_copied()) / bytes_appended, "bytes",
+      true);
+  perf_test::PrintResult("byte_queue_throughput", "", trace_name,
+                         bytes_appended / (1000 * total_time_milliseconds),
+                         "MB/s", true);
+}
+
+TEST(ByteQueuePerfTest, AppendAndConsume) {
+  RunByteQueueBenchmark(false, "whole_queue_peek");
+  RunByteQueueBenchmark(true, "bounded_peek");
+}
+
+}  // namespace media
@@ -0,0 +1,158 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdint.h>
+#include <string.h>
+
+#include <vector>
+
+#include "media/base/byte_queue.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+
+static std::vector<uint8_t> MakeData(int size, uint8_t first_value) {
+  std::vector<uint8_t> data(size);
+  for (int i = 0; i < size; ++i)
+    data[i] = static_cast<uint8_t>(first_value + i);
+  return data;
+}
+
+TEST(ByteQueueTest, Empty) {
+  ByteQueue queue;
+  const uint8_t* data = nullptr;
+  int size = -1;
+  queue.Peek(&data, &size);
+  EXPECT_EQ(0, size);
+  EXPECT_EQ(0, queue.size());
+}
+
+TEST(ByteQueueTest, PushPeekPop) {
+  ByteQueue queue;
+  std::vector<uint8_t> input = MakeData(100, 0);
+  queue.Push(input.data(), input.size());
+
+  const uint8_t* data = nullptr;
+  int size = 0;
+  queue.Peek(&data, &size);
+  ASSERT_EQ(100, size);
+  EXPECT_EQ(0, memcmp(data, input.data(), size));
+
+  queue.Pop(40);
+  queue.Peek(&data, &size);
+  ASSERT_EQ(60, size);
+  EXPECT_EQ(40, data[0]);
+
+  queue.Pop(60);
+  queue.Peek(&data, &size);
+  EXPECT_EQ(0, size);
+}
+
+// Small appends are packed into a single chunk and never copied again.
+TEST(ByteQueueTest, SmallAppendsShareChunk) {
+  ByteQueue queue;
+  std::vector<uint8_t> input = MakeData(256, 0);
+  for (int i = 0; i < 4; ++i)
+    queue.Push(input.data() + i * 64, 64);
+
+  const uint8_t* data = nullptr;
+  int size = 0;
+  queue.Peek(&data, &size);
+  ASSERT_EQ(256, size);
+  EXPECT_EQ(0, memcmp(data, input.data(), size));
+  EXPECT_EQ(256, queue.bytes_copied());
+}
+
+// Large appends land in their own chunk; a view that fits in the front chunk
+// must not copy anything.
+TEST(ByteQueueTest, PeekAtLeastWithinChunkDoesNotCopy) {
+  ByteQueue queue;
+  std::vector<uint8_t> first = MakeData(4096, 0);
+  std::vector<uint8_t> second = MakeData(4096, 7);
+  queue.Push(first.data(), first.size());
+  queue.Push(second.data(), second.size());
+  EXPECT_EQ(8192, queue.size());
+  EXPECT_EQ(8192, queue.bytes_copied());
+
+  const uint8_t* data = nullptr;
+  int size = 0;
+  queue.PeekAtLeast(188, &data, &size);
+  EXPECT_EQ(4096, size);
+  EXPECT_EQ(0, memcmp(data, first.data(), size));
+  EXPECT_EQ(8192, queue.bytes_copied());
+}
+
+// A view spanning a chunk boundary only copies the requested bytes.
+TEST(ByteQueueTest, PeekAtLeastAcrossChunks) {
+  ByteQueue queue;
+  std::vector<uint8_t> first = MakeData(4096, 0);
+  std::vector<uint8_t> second = MakeData(4096, 3);
+  queue.Push(first.data(), first.size());
+  queue.Push(second.data(), second.size());
+  queue.Pop(4000);
+
+  const uint8_t* data = nullptr;
+  int size = 0;
+  queue.PeekAtLeast(188, &data, &size);
+  ASSERT_EQ(188, size);
+  EXPECT_EQ(0, memcmp(data, first.data() + 4000, 96));
+  EXPECT_EQ(0, memcmp(data + 96, second.data(), 92));
+  EXPECT_EQ(8192 + 188, queue.bytes_copied());
+
+  // The remainder of the second chunk is still addressed in place.
+  queue.Pop(188);
+  queue.PeekAtLeast(188, &data, &size);
+  ASSERT_EQ(4096 - 92, size);
+  EXPECT_EQ(0, memcmp(data, second.data() + 92, size));
+  EXPECT_EQ(8192 + 188, queue.bytes_copied());
+}
+
+// Requests larger than the queue return everything that is queued.
+TEST(ByteQueueTest, PeekAtLeastMoreThanQueued) {
+  ByteQueue queue;
+  std::vector<uint8_t> first = MakeData(2000, 0);
+  std::vector<uint8_t> second = MakeData(2000, 1);
+  queue.Push(first.data(), first.size());
+  queue.Push(second.data(), second.size());
+
+  const uint8_t* data = nullptr;
+  int size = 0;
+  queue.PeekAtLeast(10000, &data, &size);
+  ASSERT_EQ(4000, size);
+  EXPECT_EQ(0, memcmp(data, first.data(), 2000));
+  EXPECT_EQ(0, memcmp(data + 2000, second.data(), 2000));
+}
+
+TEST(ByteQueueTest, PopAcrossChunks) {
+  ByteQueue queue;
+  std::vector<uint8_t> first = MakeData(2000, 0);
+  std::vector<uint8_t> second = MakeData(2000, 9);
+  queue.Push(first.data(), first.size());
+  queue.Push(second.data(), second.size());
+  queue.Pop(2500);
+  EXPECT_EQ(1500, queue.size());
+
+  const uint8_t* data = nullptr;
+  int size = 0;
+  queue.Peek(&data, &size);
+  ASSERT_EQ(1500, size);
+  EXPECT_EQ(0, memcmp(data, second.data() + 500, size));
+}
+
+TEST(ByteQueueTest, Reset) {
+  ByteQueue queue;
+  std::vector<uint8_t> input = MakeData(3000, 0);
+  queue.Push(input.data(), input.size());
+  queue.Reset();
+  EXPECT_EQ(0, queue.size());
+
+  queue.Push(input.data(), 10);
+  const uint8_t* data = nullptr;
+  int size = 0;
+  queue.Peek(&data, &size);
+  ASSERT_EQ(10, size);
+  EXPECT_EQ(0, memcmp(data, input.data(), size));
+}
+
+}  // namespace media
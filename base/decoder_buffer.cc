@@ -8,11 +8,8 @@ namespace media {
 
 // Allocates a block of memory which is padded for use with the SIMD
 // optimizations used by FFmpeg.
-static uint8_t* AllocateFFmpegSafeBlock(size_t size) {
-  uint8_t* const block = reinterpret_cast<uint8_t*>(base::AlignedAlloc(
-      size + DecoderBuffer::kPaddingSize, DecoderBuffer::kAlignmentSize));
-  memset(block + size, 0, DecoderBuffer::kPaddingSize);
-  return block;
+static DecoderBufferPool::ScopedBlock AllocateFFmpegSafeBlock(size_t size) {
+  return DecoderBufferPool::GetInstance()->Allocate(size);
 }
 
 DecoderBuffer::DecoderBuffer(size_t size)
@@ -47,9 +44,9 @@ DecoderBuffer::DecoderBuffer(const uint8_t* data,
 DecoderBuffer::~DecoderBuffer() {}
 
 void DecoderBuffer::Initialize() {
-  data_.reset(AllocateFFmpegSafeBlock(size_));
+  data_ = AllocateFFmpegSafeBlock(size_);
   if (side_data_size_ > 0)
-    side_data_.reset(AllocateFFmpegSafeBlock(side_data_size_));
+    side_data_ = AllocateFFmpegSafeBlock(side_data_size_);
   splice_timestamp_ = kNoTimestamp;
 }
 
@@ -137,7 +134,7 @@ void DecoderBuffer::CopySideDataFrom(const uint8_t* side_data,
                                      size_t side_data_size) {
   if (side_data_size > 0) {
     side_data_size_ = side_data_size;
-    side_data_.reset(AllocateFFmpegSafeBlock(side_data_size_));
+    side_data_ = AllocateFFmpegSafeBlock(side_data_size_);
     memcpy(side_data_.get(), side_data, side_data_size_);
   } else {
     side_data_.reset();
@@ -145,4 +142,11 @@ void DecoderBuffer::CopySideDataFrom(const uint8_t* side_data,
   }
 }
 
+uint8_t* DecoderBuffer::AllocateSideData(size_t side_data_size) {
+  DCHECK_GT(side_data_size, 0u);
+  side_data_size_ = side_data_size;
+  side_data_ = AllocateFFmpegSafeBlock(side_data_size_);
+  return side_data_.get();
+}
+
 }  // namespace media
@@ -18,6 +18,7 @@
 #include "base/memory/ref_counted.h"
 #include "base/time/time.h"
 #include "build/build_config.h"
+#include "media/base/decoder_buffer_pool.h"
 #include "media/base/decrypt_config.h"
 #include "media/base/media_export.h"
 #include "media/base/timestamp_constants.h"
@@ -29,6 +30,7 @@ namespace media {
 // Specifically ensures that data is aligned and padded as necessary by the
 // underlying decoding framework.  On desktop platforms this means memory is
 // allocated using FFmpeg with particular alignment and padding requirements.
+// The memory is drawn from, and returned to, DecoderBufferPool::GetInstance().
 //
 // Also includes decoder specific functionality for decryption.
 //
@@ -182,6 +184,10 @@ class MEDIA_EXPORT DecoderBuffer
   // Replaces any existing side data with data copied from |side_data|.
   void CopySideDataFrom(const uint8_t* side_data, size_t side_data_size);
 
+  // Replaces any existing side data with |side_data_size| > 0 bytes for the
+  // caller to fill, and returns them.
+  uint8_t* AllocateSideData(size_t side_data_size);
+
  protected:
   friend class base::RefCountedThreadSafe<DecoderBuffer>;
 
@@ -200,9 +206,9 @@ class MEDIA_EXPORT DecoderBuffer
   base::TimeDelta duration_;
 
   size_t size_;
-  std::unique_ptr<uint8_t, base::AlignedFreeDeleter> data_;
+  DecoderBufferPool::ScopedBlock data_;
   size_t side_data_size_;
-  std::unique_ptr<uint8_t, base::AlignedFreeDeleter> side_data_;
+  DecoderBufferPool::ScopedBlock side_data_;
   std::unique_ptr<DecryptConfig> decrypt_config_;
   DiscardPadding discard_padding_;
   base::TimeDelta splice_timestamp_;
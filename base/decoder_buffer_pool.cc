@@ -0,0 +1,209 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/base/decoder_buffer_pool.h"
+
+#include <string.h>
+
+#include <utility>
+
+#include "base/bind.h"
+#include "base/bits.h"
+#include "base/lazy_instance.h"
+#include "base/logging.h"
+#include "base/memory/aligned_memory.h"
+#include "base/trace_event/trace_event.h"
+#include "media/base/decoder_buffer.h"
+
+namespace media {
+
+namespace {
+
+void IgnoreMemoryPressure(
+    base::MemoryPressureListener::MemoryPressureLevel memory_pressure_level) {}
+
+// Holds the pool returned by DecoderBufferPool::GetInstance(), and purges it
+// under memory pressure. The pool is thread-safe, so it is purged on whichever
+// thread signals the pressure; that also works if the pool is created on a
+// thread without a task runner, to which asynchronous notifications couldn't
+// be posted.
+struct DefaultPool {
+  DefaultPool()
+      : pool(new DecoderBufferPool(DecoderBufferPool::kDefaultMaxBytesHeld)),
+        memory_pressure_listener(
+            base::Bind(&IgnoreMemoryPressure),
+            base::Bind(&DecoderBufferPool::Purge, pool)) {}
+
+  const scoped_refptr<DecoderBufferPool> pool;
+  base::MemoryPressureListener memory_pressure_listener;
+};
+
+base::LazyInstance<DefaultPool>::Leaky g_default_pool =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+DecoderBufferPool::Stats::Stats()
+    : hits(0),
+      misses(0),
+      evictions(0),
+      blocks_held(0),
+      bytes_held(0),
+      blocks_in_use(0),
+      bytes_in_use(0) {}
+
+DecoderBufferPool::BlockDeleter::BlockDeleter() : block_size_(0) {}
+
+DecoderBufferPool::BlockDeleter::BlockDeleter(
+    scoped_refptr<DecoderBufferPool> pool,
+    size_t block_size)
+    : pool_(std::move(pool)), block_size_(block_size) {}
+
+DecoderBufferPool::BlockDeleter::BlockDeleter(const BlockDeleter& other) =
+    default;
+
+DecoderBufferPool::BlockDeleter::~BlockDeleter() {}
+
+void DecoderBufferPool::BlockDeleter::operator()(uint8_t* block) const {
+  DCHECK(pool_);
+  pool_->Release(block, block_size_);
+}
+
+DecoderBufferPool::DecoderBufferPool(size_t max_bytes_held)
+    : max_bytes_held_(max_bytes_held) {}
+
+DecoderBufferPool::~DecoderBufferPool() {
+  DCHECK_EQ(0u, stats_.blocks_in_use);
+  for (const auto& size_and_blocks : free_blocks_) {
+    for (uint8_t* block : size_and_blocks.second)
+      base::AlignedFree(block);
+  }
+}
+
+// static
+DecoderBufferPool* DecoderBufferPool::GetInstance() {
+  return g_default_pool.Get().pool.get();
+}
+
+// static
+size_t DecoderBufferPool::GetBlockSize(size_t size) {
+  if (size <= kMinBlockSize)
+    return kMinBlockSize;
+  if (size > kMaxPooledBlockSize)
+    return size;
+
+  // For 2^k < |size| <= 2^(k+1), the size classes are 2^k plus one to four
+  // quarters of 2^k.
+  const int order = base::bits::Log2Floor(static_cast<uint32_t>(size - 1));
+  const size_t quarter = (static_cast<size_t>(1) << order) / 4;
+  return (size + quarter - 1) / quarter * quarter;
+}
+
+DecoderBufferPool::ScopedBlock DecoderBufferPool::Allocate(size_t size) {
+  const size_t block_size = GetBlockSize(size);
+  uint8_t* block = nullptr;
+  Stats stats;
+  {
+    base::AutoLock auto_lock(lock_);
+    auto it = free_blocks_.find(block_size);
+    if (it != free_blocks_.end() && !it->second.empty()) {
+      block = it->second.back();
+      it->second.pop_back();
+      ++stats_.hits;
+      --stats_.blocks_held;
+      stats_.bytes_held -= block_size;
+    } else {
+      ++stats_.misses;
+    }
+    ++stats_.blocks_in_use;
+    stats_.bytes_in_use += block_size;
+    stats = stats_;
+  }
+  TraceStats(stats);
+
+  if (!block) {
+    block = reinterpret_cast<uint8_t*>(
+        base::AlignedAlloc(block_size + DecoderBuffer::kPaddingSize,
+                           DecoderBuffer::kAlignmentSize));
+  }
+  memset(block + size, 0, DecoderBuffer::kPaddingSize);
+  return ScopedBlock(block, BlockDeleter(this, block_size));
+}
+
+DecoderBufferPool::Stats DecoderBufferPool::GetStats() const {
+  base::AutoLock auto_lock(lock_);
+  return stats_;
+}
+
+void DecoderBufferPool::Release(uint8_t* block, size_t block_size) {
+  bool pooled = false;
+  Stats stats;
+  {
+    base::AutoLock auto_lock(lock_);
+    DCHECK_GT(stats_.blocks_in_use, 0u);
+    --stats_.blocks_in_use;
+    stats_.bytes_in_use -= block_size;
+    if (block_size <= kMaxPooledBlockSize &&
+        stats_.bytes_held + block_size <= max_bytes_held_) {
+      free_blocks_[block_size].push_back(block);
+      ++stats_.blocks_held;
+      stats_.bytes_held += block_size;
+      pooled = true;
+    } else {
+      ++stats_.evictions;
+    }
+    stats = stats_;
+  }
+  TraceStats(stats);
+
+  if (!pooled)
+    base::AlignedFree(block);
+}
+
+void DecoderBufferPool::Purge(
+    base::MemoryPressureListener::MemoryPressureLevel memory_pressure_level) {
+  std::vector<uint8_t*> purged_blocks;
+  Stats stats;
+  {
+    base::AutoLock auto_lock(lock_);
+    size_t target_bytes_held = 0;
+    switch (memory_pressure_level) {
+      case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_NONE:
+        return;
+      case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE:
+        target_bytes_held = stats_.bytes_held / 2;
+        break;
+      case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL:
+        break;
+    }
+
+    // Large blocks are the least likely to be reused soon, e.g. those of key
+    // frames, so they go first.
+    for (auto it = free_blocks_.rbegin();
+         it != free_blocks_.rend() && stats_.bytes_held > target_bytes_held;
+         ++it) {
+      std::vector<uint8_t*>& blocks = it->second;
+      while (!blocks.empty() && stats_.bytes_held > target_bytes_held) {
+        purged_blocks.push_back(blocks.back());
+        blocks.pop_back();
+        --stats_.blocks_held;
+        stats_.bytes_held -= it->first;
+      }
+    }
+    stats = stats_;
+  }
+  TraceStats(stats);
+
+  for (uint8_t* block : purged_blocks)
+    base::AlignedFree(block);
+}
+
+void DecoderBufferPool::TraceStats(const Stats& stats) const {
+  TRACE_COUNTER_ID2("media", "DecoderBufferPool bytes", this, "held",
+                    stats.bytes_held, "in_use", stats.bytes_in_use);
+  TRACE_COUNTER_ID2("media", "DecoderBufferPool allocations", this, "hits",
+                    stats.hits, "misses", stats.misses);
+}
+
+}  // namespace media
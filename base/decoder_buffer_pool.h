@@ -0,0 +1,138 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_BASE_DECODER_BUFFER_POOL_H_
+#define MEDIA_BASE_DECODER_BUFFER_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/memory/memory_pressure_listener.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/lock.h"
+#include "media/base/media_export.h"
+
+namespace media {
+
+// Pool of the padded and aligned memory blocks which hold the data of
+// DecoderBuffers. Demuxers create a DecoderBuffer for every compressed frame,
+// so rather than returning each block to the allocator when its buffer is
+// destroyed, blocks are kept on a free list per size class and handed out
+// again for the next buffers of similar size.
+//
+// Sizes are rounded up to a size class, with four classes per power of two,
+// so at most a fifth of a block is wasted. Blocks larger than the largest
+// class aren't pooled. Once the free blocks take more than the pool's memory
+// limit, released blocks are freed rather than pooled. The process-wide pool
+// also frees its blocks under memory pressure; see Purge().
+//
+// May be used on any thread, and blocks may be released on another thread
+// than they were allocated on. Blocks keep their pool alive.
+class MEDIA_EXPORT DecoderBufferPool
+    : public base::RefCountedThreadSafe<DecoderBufferPool> {
+ public:
+  struct MEDIA_EXPORT Stats {
+    Stats();
+
+    // Allocate() calls which reused a free block, and which didn't.
+    size_t hits;
+    size_t misses;
+
+    // Released blocks freed rather than pooled, to keep within the memory
+    // limit or because they are too large.
+    size_t evictions;
+
+    // Free blocks in the pool, and the memory they hold.
+    size_t blocks_held;
+    size_t bytes_held;
+
+    // Blocks allocated and not yet released, and the memory they hold.
+    size_t blocks_in_use;
+    size_t bytes_in_use;
+  };
+
+  // Releases a block to the pool it was allocated from.
+  class MEDIA_EXPORT BlockDeleter {
+   public:
+    BlockDeleter();
+    BlockDeleter(scoped_refptr<DecoderBufferPool> pool, size_t block_size);
+    BlockDeleter(const BlockDeleter& other);
+    ~BlockDeleter();
+
+    void operator()(uint8_t* block) const;
+
+   private:
+    scoped_refptr<DecoderBufferPool> pool_;
+    size_t block_size_;
+  };
+
+  typedef std::unique_ptr<uint8_t, BlockDeleter> ScopedBlock;
+
+  // The memory limit of the pool returned by GetInstance(). Enough for a few
+  // seconds of high bitrate video in flight between demuxing and decoding;
+  // the pool is shared by all players in the process.
+  enum { kDefaultMaxBytesHeld = 8 * 1024 * 1024 };
+
+  // The smallest and largest size classes.
+  enum {
+    kMinBlockSize = 256,
+    kMaxPooledBlockSize = 4 * 1024 * 1024,
+  };
+
+  // Creates a pool which keeps at most |max_bytes_held| bytes of free blocks.
+  explicit DecoderBufferPool(size_t max_bytes_held);
+
+  // Returns the process-wide pool DecoderBuffers allocate from.
+  static DecoderBufferPool* GetInstance();
+
+  // Returns a block with room for |size| bytes of data, followed by
+  // DecoderBuffer::kPaddingSize zeroed bytes, and aligned to
+  // DecoderBuffer::kAlignmentSize. Reused blocks are not otherwise zeroed.
+  ScopedBlock Allocate(size_t size);
+
+  // Frees free blocks in response to memory pressure: all of them if
+  // |memory_pressure_level| is critical, and those of the largest size classes
+  // until at most half of the memory is held if it is moderate. Blocks in use
+  // are not affected. The pool returned by GetInstance() is purged whenever
+  // memory pressure is signaled.
+  void Purge(
+      base::MemoryPressureListener::MemoryPressureLevel memory_pressure_level);
+
+  // Returns a snapshot of the pool's statistics. The memory held by blocks
+  // includes rounding up to their size class, but not the padding.
+  Stats GetStats() const;
+
+  // Returns the size of the block Allocate() returns for |size| bytes.
+  static size_t GetBlockSize(size_t size);
+
+ private:
+  friend class base::RefCountedThreadSafe<DecoderBufferPool>;
+  ~DecoderBufferPool();
+
+  // Called by BlockDeleter to return |block| of |block_size| to the pool.
+  void Release(uint8_t* block, size_t block_size);
+
+  // Emits the statistics as trace counters.
+  void TraceStats(const Stats& stats) const;
+
+  const size_t max_bytes_held_;
+
+  mutable base::Lock lock_;
+
+  // Free blocks of each size, most recently released last.
+  std::map<size_t, std::vector<uint8_t*>> free_blocks_;
+
+  Stats stats_;
+
+  DISALLOW_COPY_AND_ASSIGN(DecoderBufferPool);
+};
+
+}  // namespace media
+
+#endif  // MEDIA_BASE_DECODER_BUFFER_POOL_H_
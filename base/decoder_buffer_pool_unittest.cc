@@ -0,0 +1,174 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/base/decoder_buffer_pool.h"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "base/macros.h"
+#include "base/memory/memory_pressure_listener.h"
+#include "media/base/decoder_buffer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+
+class DecoderBufferPoolTest : public ::testing::Test {
+ public:
+  DecoderBufferPoolTest() : pool_(new DecoderBufferPool(kMaxBytesHeld)) {}
+
+ protected:
+  enum { kMaxBytesHeld = 64 * 1024 };
+
+  scoped_refptr<DecoderBufferPool> pool_;
+};
+
+TEST_F(DecoderBufferPoolTest, GetBlockSize) {
+  EXPECT_EQ(256u, DecoderBufferPool::GetBlockSize(0));
+  EXPECT_EQ(256u, DecoderBufferPool::GetBlockSize(256));
+  EXPECT_EQ(320u, DecoderBufferPool::GetBlockSize(257));
+  EXPECT_EQ(1024u, DecoderBufferPool::GetBlockSize(1000));
+  EXPECT_EQ(1280u, DecoderBufferPool::GetBlockSize(1025));
+  EXPECT_EQ(1792u, DecoderBufferPool::GetBlockSize(1537));
+  EXPECT_EQ(3670016u, DecoderBufferPool::GetBlockSize(3500000));
+
+  // Blocks too large to pool aren't rounded up.
+  const size_t kLargeSize = 4 * 1024 * 1024 + 1;
+  EXPECT_EQ(kLargeSize, DecoderBufferPool::GetBlockSize(kLargeSize));
+}
+
+TEST_F(DecoderBufferPoolTest, BlocksAlignedAndPadded) {
+  const size_t kSize = 1000;
+  DecoderBufferPool::ScopedBlock block = pool_->Allocate(kSize);
+  EXPECT_EQ(0u, reinterpret_cast<uintptr_t>(block.get()) %
+                    DecoderBuffer::kAlignmentSize);
+
+  // Dirty the whole block, then check a reused block is padded again.
+  uint8_t* const address = block.get();
+  memset(address, 0xff, 1024 + DecoderBuffer::kPaddingSize);
+  block.reset();
+  block = pool_->Allocate(kSize - 100);
+  ASSERT_EQ(address, block.get());
+  for (size_t i = 0; i < DecoderBuffer::kPaddingSize; ++i)
+    EXPECT_EQ(0, block.get()[kSize - 100 + i]);
+}
+
+TEST_F(DecoderBufferPoolTest, ReusesBlocksOfSameSizeClass) {
+  DecoderBufferPool::ScopedBlock block = pool_->Allocate(1000);
+  uint8_t* const address = block.get();
+  block.reset();
+
+  DecoderBufferPool::Stats stats = pool_->GetStats();
+  EXPECT_EQ(0u, stats.hits);
+  EXPECT_EQ(1u, stats.misses);
+  EXPECT_EQ(1u, stats.blocks_held);
+  EXPECT_EQ(1024u, stats.bytes_held);
+  EXPECT_EQ(0u, stats.blocks_in_use);
+
+  // A block of another size class isn't reused.
+  DecoderBufferPool::ScopedBlock other_block = pool_->Allocate(1100);
+  EXPECT_NE(address, other_block.get());
+
+  block = pool_->Allocate(1020);
+  EXPECT_EQ(address, block.get());
+
+  stats = pool_->GetStats();
+  EXPECT_EQ(1u, stats.hits);
+  EXPECT_EQ(2u, stats.misses);
+  EXPECT_EQ(0u, stats.blocks_held);
+  EXPECT_EQ(0u, stats.bytes_held);
+  EXPECT_EQ(2u, stats.blocks_in_use);
+  EXPECT_EQ(1024u + 1280u, stats.bytes_in_use);
+}
+
+TEST_F(DecoderBufferPoolTest, KeepsWithinMemoryLimit) {
+  const size_t kSize = 16 * 1024;
+  DecoderBufferPool::ScopedBlock blocks[6];
+  for (DecoderBufferPool::ScopedBlock& block : blocks)
+    block = pool_->Allocate(kSize);
+  for (DecoderBufferPool::ScopedBlock& block : blocks)
+    block.reset();
+
+  DecoderBufferPool::Stats stats = pool_->GetStats();
+  EXPECT_EQ(kMaxBytesHeld / kSize, stats.blocks_held);
+  EXPECT_EQ(static_cast<size_t>(kMaxBytesHeld), stats.bytes_held);
+  EXPECT_EQ(6 - kMaxBytesHeld / kSize, stats.evictions);
+}
+
+TEST_F(DecoderBufferPoolTest, LargeBlocksNotPooled) {
+  DecoderBufferPool::ScopedBlock block =
+      pool_->Allocate(DecoderBufferPool::kMaxPooledBlockSize + 1);
+  block.reset();
+
+  DecoderBufferPool::Stats stats = pool_->GetStats();
+  EXPECT_EQ(0u, stats.blocks_held);
+  EXPECT_EQ(1u, stats.evictions);
+}
+
+TEST_F(DecoderBufferPoolTest, PurgeUnderMemoryPressure) {
+  // 4 + 8 + 16 + 32 KB of free blocks.
+  const size_t kSizes[] = {4 * 1024, 8 * 1024, 16 * 1024, 32 * 1024};
+  DecoderBufferPool::ScopedBlock blocks[arraysize(kSizes)];
+  for (size_t i = 0; i < arraysize(kSizes); ++i)
+    blocks[i] = pool_->Allocate(kSizes[i]);
+  DecoderBufferPool::ScopedBlock block_in_use = pool_->Allocate(1000);
+  for (DecoderBufferPool::ScopedBlock& block : blocks)
+    block.reset();
+  EXPECT_EQ(60u * 1024, pool_->GetStats().bytes_held);
+
+  pool_->Purge(base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_NONE);
+  EXPECT_EQ(60u * 1024, pool_->GetStats().bytes_held);
+
+  // Moderate pressure frees the largest blocks until at most half is held.
+  pool_->Purge(base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE);
+  DecoderBufferPool::Stats stats = pool_->GetStats();
+  EXPECT_EQ(3u, stats.blocks_held);
+  EXPECT_EQ(28u * 1024, stats.bytes_held);
+
+  // Critical pressure frees all of them, but not the blocks in use.
+  pool_->Purge(base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL);
+  stats = pool_->GetStats();
+  EXPECT_EQ(0u, stats.blocks_held);
+  EXPECT_EQ(0u, stats.bytes_held);
+  EXPECT_EQ(1u, stats.blocks_in_use);
+  EXPECT_EQ(0u, stats.evictions);
+
+  // The pool still works afterwards.
+  blocks[0] = pool_->Allocate(kSizes[0]);
+  blocks[0].reset();
+  EXPECT_EQ(kSizes[0], pool_->GetStats().bytes_held);
+}
+
+TEST_F(DecoderBufferPoolTest, BlocksOutlivePool) {
+  DecoderBufferPool::ScopedBlock block = pool_->Allocate(1000);
+  pool_ = nullptr;
+  block.get()[999] = 1;
+  block.reset();
+}
+
+TEST_F(DecoderBufferPoolTest, DecoderBuffersUseDefaultPool) {
+  DecoderBufferPool* const pool = DecoderBufferPool::GetInstance();
+  const uint8_t kData[] = "hello";
+  scoped_refptr<DecoderBuffer> buffer(
+      DecoderBuffer::CopyFrom(kData, sizeof(kData)));
+  const size_t blocks_in_use = pool->GetStats().blocks_in_use;
+  EXPECT_GT(blocks_in_use, 0u);
+
+  buffer = nullptr;
+  EXPECT_EQ(blocks_in_use - 1, pool->GetStats().blocks_in_use);
+}
+
+TEST_F(DecoderBufferPoolTest, DefaultPoolPurgedUnderMemoryPressure) {
+  DecoderBufferPool* const pool = DecoderBufferPool::GetInstance();
+  DecoderBufferPool::ScopedBlock block = pool->Allocate(1000);
+  block.reset();
+  EXPECT_GT(pool->GetStats().blocks_held, 0u);
+
+  base::MemoryPressureListener::SimulatePressureNotification(
+      base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL);
+  EXPECT_EQ(0u, pool->GetStats().blocks_held);
+}
+
+}  // namespace media
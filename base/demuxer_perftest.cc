@@ -9,6 +9,7 @@
 #include "base/at_exit.h"
 #include "base/bind.h"
 #include "base/macros.h"
+#include "base/memory/ptr_util.h"
 #include "base/message_loop/message_loop.h"
 #include "base/run_loop.h"
 #include "base/strings/string_number_conversions.h"
@@ -22,6 +23,10 @@
 #include "media/base/timestamp_constants.h"
 #include "media/filters/ffmpeg_demuxer.h"
 #include "media/filters/file_data_source.h"
+
+#if defined(USE_PROPRIETARY_CODECS)
+#include "media/filters/progressive_mp4_demuxer.h"
+#endif
 #include "testing/gtest/include/gtest/gtest.h"
 #include "testing/perf/perf_test.h"
 
@@ -37,13 +42,19 @@ class DemuxerHostImpl : public media::DemuxerHost {
   // DemuxerHost implementation.
   void OnBufferedTimeRangesChanged(
       const Ranges<base::TimeDelta>& ranges) override {}
-  void SetDuration(base::TimeDelta duration) override {}
+  void SetDuration(base::TimeDelta duration) override {
+    duration_ = duration;
+  }
   void OnDemuxerError(media::PipelineStatus error) override {}
   void AddTextStream(media::DemuxerStream* text_stream,
                      const media::TextTrackConfig& config) override {}
   void RemoveTextStream(media::DemuxerStream* text_stream) override {}
 
+  base::TimeDelta duration() const { return duration_; }
+
  private:
+  base::TimeDelta duration_;
+
   DISALLOW_COPY_AND_ASSIGN(DemuxerHostImpl);
 };
 
@@ -184,7 +195,31 @@ int StreamReader::GetNextStreamIndexToRead() {
   return index;
 }
 
-static void RunDemuxerBenchmark(const std::string& filename) {
+enum class DemuxerType { FFMPEG, PROGRESSIVE_MP4 };
+
+static std::unique_ptr<Demuxer> CreateDemuxer(
+    DemuxerType type,
+    base::MessageLoop* message_loop,
+    DataSource* data_source) {
+  Demuxer::MediaTracksUpdatedCB tracks_updated_cb =
+      base::Bind(&OnMediaTracksUpdated);
+#if defined(USE_PROPRIETARY_CODECS)
+  if (type == DemuxerType::PROGRESSIVE_MP4) {
+    return base::MakeUnique<ProgressiveMP4Demuxer>(
+        message_loop->task_runner(), data_source, tracks_updated_cb,
+        new MediaLog());
+  }
+#endif
+  CHECK(type == DemuxerType::FFMPEG);
+  Demuxer::EncryptedMediaInitDataCB encrypted_media_init_data_cb =
+      base::Bind(&OnEncryptedMediaInitData);
+  return base::MakeUnique<FFmpegDemuxer>(
+      message_loop->task_runner(), data_source, encrypted_media_init_data_cb,
+      tracks_updated_cb, new MediaLog());
+}
+
+static void RunDemuxerBenchmark(const std::string& filename,
+                                DemuxerType type) {
   base::FilePath file_path(GetTestDataFilePath(filename));
   double total_time = 0.0;
   for (int i = 0; i < kBenchmarkIterations; ++i) {
@@ -194,19 +229,14 @@ static void RunDemuxerBenchmark(const std::string& filename) {
     FileDataSource data_source;
     ASSERT_TRUE(data_source.Initialize(file_path));
 
-    Demuxer::EncryptedMediaInitDataCB encrypted_media_init_data_cb =
-        base::Bind(&OnEncryptedMediaInitData);
-    Demuxer::MediaTracksUpdatedCB tracks_updated_cb =
-        base::Bind(&OnMediaTracksUpdated);
-    FFmpegDemuxer demuxer(message_loop.task_runner(), &data_source,
-                          encrypted_media_init_data_cb, tracks_updated_cb,
-                          new MediaLog());
-
-    demuxer.Initialize(&demuxer_host,
-                       base::Bind(&QuitLoopWithStatus, &message_loop),
-                       false);
+    std::unique_ptr<Demuxer> demuxer =
+        CreateDemuxer(type, &message_loop, &data_source);
+
+    demuxer->Initialize(&demuxer_host,
+                        base::Bind(&QuitLoopWithStatus, &message_loop),
+                        false);
     base::RunLoop().Run();
-    StreamReader stream_reader(&demuxer, false);
+    StreamReader stream_reader(demuxer.get(), false);
 
     // Benchmark.
     base::TimeTicks start = base::TimeTicks::Now();
@@ -215,37 +245,97 @@ static void RunDemuxerBenchmark(const std::string& filename) {
     }
     base::TimeTicks end = base::TimeTicks::Now();
     total_time += (end - start).InSecondsF();
-    demuxer.Stop();
+    demuxer->Stop();
     QuitLoopWithStatus(&message_loop, PIPELINE_OK);
     base::RunLoop().Run();
   }
 
   perf_test::PrintResult("demuxer_bench",
-                         "",
+                         type == DemuxerType::PROGRESSIVE_MP4
+                             ? "_progressive_mp4"
+                             : "",
                          filename,
                          kBenchmarkIterations / total_time,
                          "runs/s",
                          true);
 }
 
+// Measures what starting playback in the middle of |filename| costs: opening
+// the file, initializing the demuxer, seeking to the middle and reading the
+// first buffer of each stream.
+static void RunColdSeekBenchmark(const std::string& filename,
+                                 DemuxerType type) {
+  base::FilePath file_path(GetTestDataFilePath(filename));
+  double total_time = 0.0;
+  for (int i = 0; i < kBenchmarkIterations; ++i) {
+    base::MessageLoop message_loop;
+    DemuxerHostImpl demuxer_host;
+    FileDataSource data_source;
+
+    base::TimeTicks start = base::TimeTicks::Now();
+    ASSERT_TRUE(data_source.Initialize(file_path));
+    std::unique_ptr<Demuxer> demuxer =
+        CreateDemuxer(type, &message_loop, &data_source);
+    demuxer->Initialize(&demuxer_host,
+                        base::Bind(&QuitLoopWithStatus, &message_loop),
+                        false);
+    base::RunLoop().Run();
+
+    const base::TimeDelta seek_time = demuxer_host.duration() / 2;
+    demuxer->StartWaitingForSeek(seek_time);
+    demuxer->Seek(seek_time, base::Bind(&QuitLoopWithStatus, &message_loop));
+    base::RunLoop().Run();
+
+    // Streams which haven't been read yet are read first.
+    StreamReader stream_reader(demuxer.get(), false);
+    for (int j = 0; j < stream_reader.number_of_streams(); ++j)
+      stream_reader.Read();
+    base::TimeTicks end = base::TimeTicks::Now();
+    total_time += (end - start).InSecondsF();
+
+    demuxer->Stop();
+    QuitLoopWithStatus(&message_loop, PIPELINE_OK);
+    base::RunLoop().Run();
+  }
+
+  perf_test::PrintResult("demuxer_cold_seek",
+                         type == DemuxerType::PROGRESSIVE_MP4
+                             ? "_progressive_mp4"
+                             : "",
+                         filename,
+                         total_time * 1000 / kBenchmarkIterations,
+                         "ms",
+                         true);
+}
+
 #if defined(OS_WIN)
 // http://crbug.com/399002
 #define MAYBE_Demuxer DISABLED_Demuxer
+#define MAYBE_Demuxer_ColdSeek DISABLED_Demuxer_ColdSeek
 #else
 #define MAYBE_Demuxer Demuxer
+#define MAYBE_Demuxer_ColdSeek Demuxer_ColdSeek
 #endif
 TEST(DemuxerPerfTest, MAYBE_Demuxer) {
-  RunDemuxerBenchmark("bear.ogv");
-  RunDemuxerBenchmark("bear-640x360.webm");
-  RunDemuxerBenchmark("sfx_s16le.wav");
-  RunDemuxerBenchmark("bear.flac");
+  RunDemuxerBenchmark("bear.ogv", DemuxerType::FFMPEG);
+  RunDemuxerBenchmark("bear-640x360.webm", DemuxerType::FFMPEG);
+  RunDemuxerBenchmark("sfx_s16le.wav", DemuxerType::FFMPEG);
+  RunDemuxerBenchmark("bear.flac", DemuxerType::FFMPEG);
 #if defined(USE_PROPRIETARY_CODECS)
-  RunDemuxerBenchmark("bear-1280x720.mp4");
-  RunDemuxerBenchmark("sfx.mp3");
+  RunDemuxerBenchmark("bear-1280x720.mp4", DemuxerType::FFMPEG);
+  RunDemuxerBenchmark("bear-1280x720.mp4", DemuxerType::PROGRESSIVE_MP4);
+  RunDemuxerBenchmark("sfx.mp3", DemuxerType::FFMPEG);
 #endif
 #if defined(USE_PROPRIETARY_CODECS) && defined(OS_CHROMEOS)
-  RunDemuxerBenchmark("bear.avi");
+  RunDemuxerBenchmark("bear.avi", DemuxerType::FFMPEG);
 #endif
 }
 
+#if defined(USE_PROPRIETARY_CODECS)
+TEST(DemuxerPerfTest, MAYBE_Demuxer_ColdSeek) {
+  RunColdSeekBenchmark("bear-1280x720.mp4", DemuxerType::FFMPEG);
+  RunColdSeekBenchmark("bear-1280x720.mp4", DemuxerType::PROGRESSIVE_MP4);
+}
+#endif
+
 }  // namespace media
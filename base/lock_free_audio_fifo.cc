@@ -0,0 +1,132 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/base/lock_free_audio_fifo.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+
+#include "base/logging.h"
+
+namespace media {
+
+LockFreeAudioFifo::LockFreeAudioFifo(int channels, int frames)
+    : audio_bus_(AudioBus::Create(channels, frames)), max_frames_(frames) {
+  // Indices run up to 2 * |max_frames_|, which must fit in an Atomic32.
+  CHECK_LE(frames, std::numeric_limits<base::subtle::Atomic32>::max() / 2);
+  write_index_.value = 0;
+  read_index_.value = 0;
+}
+
+LockFreeAudioFifo::~LockFreeAudioFifo() {}
+
+bool LockFreeAudioFifo::Push(const AudioBus* source) {
+  DCHECK(source);
+  DCHECK_EQ(source->channels(), audio_bus_->channels());
+
+  // Only this thread writes |write_index_|, so a plain load is sufficient; the
+  // acquire on |read_index_| ensures the consumer is done with the space it
+  // has released before it's overwritten.
+  const base::subtle::Atomic32 write_index =
+      base::subtle::NoBarrier_Load(&write_index_.value);
+  const base::subtle::Atomic32 read_index =
+      base::subtle::Acquire_Load(&read_index_.value);
+
+  const int source_size = source->frames();
+  if (source_size > max_frames_ - FramesBetween(read_index, write_index))
+    return false;
+
+  // Copy all channels from the source to the FIFO, wrapping around if needed.
+  const int write_pos = PositionOf(write_index);
+  const int append_size = std::min(source_size, max_frames_ - write_pos);
+  const int wrap_size = source_size - append_size;
+  for (int ch = 0; ch < source->channels(); ++ch) {
+    float* dest = audio_bus_->channel(ch);
+    const float* src = source->channel(ch);
+    memcpy(&dest[write_pos], &src[0], append_size * sizeof(src[0]));
+    if (wrap_size > 0)
+      memcpy(&dest[0], &src[append_size], wrap_size * sizeof(src[0]));
+  }
+
+  // Publish the new frames to the consumer.
+  base::subtle::Release_Store(&write_index_.value,
+                              AdvanceIndex(write_index, source_size));
+  return true;
+}
+
+int LockFreeAudioFifo::GetUnfilledFrames() const {
+  return max_frames_ -
+         FramesBetween(base::subtle::Acquire_Load(&read_index_.value),
+                       base::subtle::NoBarrier_Load(&write_index_.value));
+}
+
+bool LockFreeAudioFifo::Consume(AudioBus* destination,
+                                int start_frame,
+                                int frames_to_consume) {
+  DCHECK(destination);
+  DCHECK_EQ(destination->channels(), audio_bus_->channels());
+  DCHECK_LE(frames_to_consume + start_frame, destination->frames());
+
+  // The acquire on |write_index_| ensures the producer's copy into the FIFO is
+  // visible before it's read back out.
+  const base::subtle::Atomic32 read_index =
+      base::subtle::NoBarrier_Load(&read_index_.value);
+  const base::subtle::Atomic32 write_index =
+      base::subtle::Acquire_Load(&write_index_.value);
+
+  if (frames_to_consume > FramesBetween(read_index, write_index))
+    return false;
+
+  // Copy all channels from the FIFO to |destination|, wrapping around if
+  // needed.
+  const int read_pos = PositionOf(read_index);
+  const int consume_size = std::min(frames_to_consume, max_frames_ - read_pos);
+  const int wrap_size = frames_to_consume - consume_size;
+  for (int ch = 0; ch < destination->channels(); ++ch) {
+    float* dest = destination->channel(ch);
+    const float* src = audio_bus_->channel(ch);
+    memcpy(&dest[start_frame], &src[read_pos], consume_size * sizeof(src[0]));
+    if (wrap_size > 0) {
+      memcpy(&dest[start_frame + consume_size], &src[0],
+             wrap_size * sizeof(src[0]));
+    }
+  }
+
+  // Hand the space back to the producer.
+  base::subtle::Release_Store(&read_index_.value,
+                              AdvanceIndex(read_index, frames_to_consume));
+  return true;
+}
+
+void LockFreeAudioFifo::Clear() {
+  base::subtle::Release_Store(&read_index_.value,
+                              base::subtle::Acquire_Load(&write_index_.value));
+}
+
+int LockFreeAudioFifo::frames() const {
+  return FramesBetween(base::subtle::NoBarrier_Load(&read_index_.value),
+                       base::subtle::Acquire_Load(&write_index_.value));
+}
+
+int LockFreeAudioFifo::FramesBetween(base::subtle::Atomic32 read_index,
+                                     base::subtle::Atomic32 write_index) const {
+  const int frames = write_index - read_index;
+  return frames < 0 ? frames + 2 * max_frames_ : frames;
+}
+
+base::subtle::Atomic32 LockFreeAudioFifo::AdvanceIndex(
+    base::subtle::Atomic32 index,
+    int frames) const {
+  DCHECK_LE(frames, max_frames_);
+  index += frames;
+  return index >= 2 * max_frames_ ? index - 2 * max_frames_ : index;
+}
+
+int LockFreeAudioFifo::PositionOf(base::subtle::Atomic32 index) const {
+  return index >= max_frames_ ? index - max_frames_ : index;
+}
+
+}  // namespace media
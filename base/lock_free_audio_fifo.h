@@ -0,0 +1,103 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_BASE_LOCK_FREE_AUDIO_FIFO_H_
+#define MEDIA_BASE_LOCK_FREE_AUDIO_FIFO_H_
+
+#include <memory>
+
+#include "base/atomicops.h"
+#include "base/macros.h"
+#include "media/base/audio_bus.h"
+#include "media/base/media_export.h"
+
+namespace media {
+
+// Single-producer, single-consumer variant of AudioFifo.  One thread may call
+// the producer methods while another calls the consumer methods, without any
+// locking; both sides are wait-free, so it's safe to use from a real-time
+// audio callback.  Storage is a planar AudioBus used as a ring buffer, sized
+// at construction.
+//
+// Unlike AudioFifo, Push() and Consume() never crash on overflow or underflow;
+// they return false and leave the FIFO untouched so the real-time side can
+// decide whether to drop or pad.
+class MEDIA_EXPORT LockFreeAudioFifo {
+ public:
+  // Creates a new LockFreeAudioFifo and allocates |channels| of length
+  // |frames|.
+  LockFreeAudioFifo(int channels, int frames);
+  ~LockFreeAudioFifo();
+
+  // Producer methods.
+
+  // Pushes all frames of |source| into the FIFO.  Returns false, pushing
+  // nothing, if there isn't space for all of them.
+  bool Push(const AudioBus* source);
+
+  // Number of frames which can currently be pushed.  Only grows until the
+  // next Push(), since the consumer can only free space.
+  int GetUnfilledFrames() const;
+
+  // Consumer methods.
+
+  // Consumes |frames_to_consume| frames into |destination| starting at
+  // |start_frame|.  Returns false, consuming nothing, if fewer frames are
+  // available.  |destination| must have room for the frames.
+  bool Consume(AudioBus* destination, int start_frame, int frames_to_consume);
+
+  // Discards every frame currently in the FIFO.
+  void Clear();
+
+  // Number of frames which can currently be consumed.  Only grows until the
+  // next Consume() or Clear(), since the producer can only add frames.
+  int frames() const;
+
+  int channels() const { return audio_bus_->channels(); }
+  int max_frames() const { return max_frames_; }
+
+ private:
+  // Returns the number of frames between |read_index| and |write_index|.
+  int FramesBetween(base::subtle::Atomic32 read_index,
+                    base::subtle::Atomic32 write_index) const;
+
+  // Advances |index| by |frames|, wrapping at 2 * |max_frames_|.  Indices run
+  // over twice the capacity so that a full FIFO can be told apart from an
+  // empty one without a shared frame count.
+  base::subtle::Atomic32 AdvanceIndex(base::subtle::Atomic32 index,
+                                      int frames) const;
+
+  // Ring buffer position of |index|.
+  int PositionOf(base::subtle::Atomic32 index) const;
+
+  // Assumed size of a cache line.
+  enum { kCacheLineSize = 64 };
+
+  // An index preceded by enough padding that it never shares a cache line with
+  // the members before it; keeps the producer's and consumer's writes from
+  // bouncing a line between the two threads.
+  struct PaddedIndex {
+    char padding[kCacheLineSize - sizeof(base::subtle::Atomic32)];
+    base::subtle::Atomic32 value;
+  };
+
+  // The actual FIFO storage.  The producer only writes the region the consumer
+  // can't see yet, and vice versa.
+  const std::unique_ptr<AudioBus> audio_bus_;
+
+  // Maximum number of frames the FIFO can contain.
+  const int max_frames_;
+
+  // Written only by the producer, published with release semantics.
+  PaddedIndex write_index_;
+
+  // Written only by the consumer, published with release semantics.
+  PaddedIndex read_index_;
+
+  DISALLOW_COPY_AND_ASSIGN(LockFreeAudioFifo);
+};
+
+}  // namespace media
+
+#endif  // MEDIA_BASE_LOCK_FREE_AUDIO_FIFO_H_
@@ -0,0 +1,204 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <algorithm>
+#include <memory>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/macros.h"
+#include "base/single_thread_task_runner.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/platform_thread.h"
+#include "base/threading/thread.h"
+#include "media/base/lock_free_audio_fifo.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+
+static const int kChannels = 2;
+static const int kMaxFrameCount = 128;
+
+// Fills |bus| with consecutive values starting at |first_value|, the same
+// sequence on every channel.
+static void FillRamp(AudioBus* bus, int frames, float first_value) {
+  for (int ch = 0; ch < bus->channels(); ++ch) {
+    for (int i = 0; i < frames; ++i)
+      bus->channel(ch)[i] = first_value + i;
+  }
+}
+
+TEST(LockFreeAudioFifoTest, Construct) {
+  LockFreeAudioFifo fifo(kChannels, kMaxFrameCount);
+  EXPECT_EQ(0, fifo.frames());
+  EXPECT_EQ(kMaxFrameCount, fifo.GetUnfilledFrames());
+  EXPECT_EQ(kChannels, fifo.channels());
+  EXPECT_EQ(kMaxFrameCount, fifo.max_frames());
+}
+
+// Verify that overflow and underflow are rejected without changing the FIFO.
+TEST(LockFreeAudioFifoTest, RejectOverflowAndUnderflow) {
+  LockFreeAudioFifo fifo(kChannels, kMaxFrameCount);
+  std::unique_ptr<AudioBus> bus =
+      AudioBus::Create(kChannels, kMaxFrameCount * 3 / 4);
+  bus->Zero();
+
+  EXPECT_FALSE(fifo.Consume(bus.get(), 0, 1));
+  EXPECT_TRUE(fifo.Push(bus.get()));
+  EXPECT_EQ(bus->frames(), fifo.frames());
+
+  EXPECT_FALSE(fifo.Push(bus.get()));
+  EXPECT_EQ(bus->frames(), fifo.frames());
+  EXPECT_EQ(kMaxFrameCount - bus->frames(), fifo.GetUnfilledFrames());
+
+  EXPECT_FALSE(fifo.Consume(bus.get(), 0, bus->frames() + 1));
+  EXPECT_EQ(bus->frames(), fifo.frames());
+
+  EXPECT_TRUE(fifo.Consume(bus.get(), 0, bus->frames()));
+  EXPECT_EQ(0, fifo.frames());
+}
+
+// Fill the FIFO completely, then drain and refill it across the wrap point to
+// verify the full and empty states are told apart.
+TEST(LockFreeAudioFifoTest, FullAndWrap) {
+  LockFreeAudioFifo fifo(kChannels, kMaxFrameCount);
+  std::unique_ptr<AudioBus> full_bus =
+      AudioBus::Create(kChannels, kMaxFrameCount);
+  std::unique_ptr<AudioBus> out_bus =
+      AudioBus::Create(kChannels, kMaxFrameCount);
+
+  FillRamp(full_bus.get(), kMaxFrameCount, 0);
+  EXPECT_TRUE(fifo.Push(full_bus.get()));
+  EXPECT_EQ(kMaxFrameCount, fifo.frames());
+  EXPECT_EQ(0, fifo.GetUnfilledFrames());
+
+  // Consume a partial block to move the read position off zero.
+  static const int kPartial = kMaxFrameCount / 3;
+  EXPECT_TRUE(fifo.Consume(out_bus.get(), 0, kPartial));
+  EXPECT_EQ(0, out_bus->channel(0)[0]);
+  EXPECT_EQ(kPartial - 1, out_bus->channel(1)[kPartial - 1]);
+
+  // Push into the freed space, which wraps around the end of the ring.
+  std::unique_ptr<AudioBus> partial_bus = AudioBus::Create(kChannels, kPartial);
+  FillRamp(partial_bus.get(), kPartial, kMaxFrameCount);
+  EXPECT_TRUE(fifo.Push(partial_bus.get()));
+  EXPECT_EQ(kMaxFrameCount, fifo.frames());
+
+  // Everything should come back out in order, spanning the wrap point.
+  EXPECT_TRUE(fifo.Consume(out_bus.get(), 0, kMaxFrameCount));
+  for (int ch = 0; ch < kChannels; ++ch) {
+    for (int i = 0; i < kMaxFrameCount; ++i)
+      ASSERT_EQ(kPartial + i, out_bus->channel(ch)[i]) << "i=" << i;
+  }
+  EXPECT_EQ(0, fifo.frames());
+}
+
+// Verify that Consume() honors |start_frame| and Clear() drops all frames.
+TEST(LockFreeAudioFifoTest, ConsumeWithStartFrameAndClear) {
+  LockFreeAudioFifo fifo(kChannels, kMaxFrameCount);
+  std::unique_ptr<AudioBus> in_bus = AudioBus::Create(kChannels, 16);
+  std::unique_ptr<AudioBus> out_bus = AudioBus::Create(kChannels, 32);
+  out_bus->Zero();
+
+  FillRamp(in_bus.get(), in_bus->frames(), 1);
+  EXPECT_TRUE(fifo.Push(in_bus.get()));
+  EXPECT_TRUE(fifo.Consume(out_bus.get(), 8, 8));
+  EXPECT_EQ(0, out_bus->channel(0)[7]);
+  EXPECT_EQ(1, out_bus->channel(0)[8]);
+  EXPECT_EQ(8, out_bus->channel(1)[15]);
+
+  fifo.Clear();
+  EXPECT_EQ(0, fifo.frames());
+  EXPECT_EQ(kMaxFrameCount, fifo.GetUnfilledFrames());
+}
+
+// Producer which pushes a continuous ramp in varying buffer sizes from its own
+// thread.  Frames are only pushed when they fit; nothing is ever dropped.
+class RampProducer {
+ public:
+  RampProducer(LockFreeAudioFifo* fifo, int total_frames)
+      : fifo_(fifo),
+        total_frames_(total_frames),
+        bus_(AudioBus::Create(fifo->channels(), kMaxFrameCount / 2)) {}
+
+  void Run(base::WaitableEvent* done) {
+    std::unique_ptr<AudioBus> wrapper =
+        AudioBus::CreateWrapper(bus_->channels());
+    for (int ch = 0; ch < bus_->channels(); ++ch)
+      wrapper->SetChannelData(ch, bus_->channel(ch));
+
+    int next_value = 0;
+    int buffer_index = 0;
+    while (next_value < total_frames_) {
+      // Cycle through a handful of buffer sizes so pushes straddle the wrap
+      // point at different offsets.
+      const int frames = std::min(total_frames_ - next_value,
+                                  1 + (buffer_index * 13) % bus_->frames());
+      wrapper->set_frames(frames);
+      FillRamp(wrapper.get(), frames, next_value);
+
+      if (!fifo_->Push(wrapper.get())) {
+        base::PlatformThread::YieldCurrentThread();
+        continue;
+      }
+      next_value += frames;
+      ++buffer_index;
+    }
+    done->Signal();
+  }
+
+ private:
+  LockFreeAudioFifo* const fifo_;
+  const int total_frames_;
+  std::unique_ptr<AudioBus> bus_;
+
+  DISALLOW_COPY_AND_ASSIGN(RampProducer);
+};
+
+// Push and consume concurrently from two threads and verify that every frame
+// comes out exactly once and in order.
+TEST(LockFreeAudioFifoTest, ConcurrentProducerAndConsumer) {
+  static const int kTotalFrames = 1 << 20;
+  LockFreeAudioFifo fifo(kChannels, kMaxFrameCount);
+  RampProducer producer(&fifo, kTotalFrames);
+
+  base::Thread producer_thread("LockFreeAudioFifoProducer");
+  ASSERT_TRUE(producer_thread.Start());
+  base::WaitableEvent done(base::WaitableEvent::ResetPolicy::MANUAL,
+                           base::WaitableEvent::InitialState::NOT_SIGNALED);
+  producer_thread.task_runner()->PostTask(
+      FROM_HERE, base::Bind(&RampProducer::Run, base::Unretained(&producer),
+                            base::Unretained(&done)));
+
+  std::unique_ptr<AudioBus> out_bus =
+      AudioBus::Create(kChannels, kMaxFrameCount / 2);
+  int expected_value = 0;
+  int consume_index = 0;
+  int mismatched_frames = 0;
+  while (expected_value < kTotalFrames) {
+    const int frames =
+        std::min(kTotalFrames - expected_value,
+                 1 + (consume_index * 17) % out_bus->frames());
+    if (!fifo.Consume(out_bus.get(), 0, frames)) {
+      base::PlatformThread::YieldCurrentThread();
+      continue;
+    }
+    // Keep draining on a mismatch so the producer can always finish.
+    for (int ch = 0; ch < kChannels; ++ch) {
+      for (int i = 0; i < frames; ++i) {
+        if (out_bus->channel(ch)[i] != expected_value + i)
+          ++mismatched_frames;
+      }
+    }
+    expected_value += frames;
+    ++consume_index;
+  }
+
+  done.Wait();
+  producer_thread.Stop();
+  EXPECT_EQ(0, mismatched_frames);
+  EXPECT_EQ(0, fifo.frames());
+}
+
+}  // namespace media
@@ -10,7 +10,10 @@
 #include "base/metrics/field_trial.h"
 #include "base/trace_event/trace_event.h"
 #include "media/base/media_switches.h"
+#include "media/base/sinc_resampler.h"
+#include "media/base/vector_math.h"
 #include "media/base/yuv_convert.h"
+#include "media/filters/annex_b_scanner.h"
 
 #if defined(OS_ANDROID)
 #include "base/android/build_info.h"
@@ -41,6 +44,9 @@ class MediaInitializer {
 
     // Perform initialization of libraries which require runtime CPU detection.
     InitializeCPUSpecificYUVConversions();
+    SincResampler::InitializeCPUSpecificFeatures();
+    vector_math::InitializeCPUSpecificFeatures();
+    annex_b::InitializeCPUSpecificFeatures();
 
 #if !defined(MEDIA_DISABLE_FFMPEG)
     // Initialize CPU flags outside of the sandbox as this may query /proc for
@@ -0,0 +1,113 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/base/parallel_row_bands.h"
+
+#include <algorithm>
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/task_runner.h"
+
+namespace media {
+
+namespace {
+
+// Target number of output bytes per band.
+const size_t kRowBandBytes = 256 * 1024;
+
+// The bands of one RunInParallelRowBands() call. Owned jointly by the calling
+// thread and the posted tasks, since tasks may outlive the call.
+class RowBands : public base::RefCountedThreadSafe<RowBands> {
+ public:
+  RowBands(int height, int rows_per_band, const RowBandCB& process_rows)
+      : height_(height),
+        rows_per_band_(rows_per_band),
+        num_bands_((height + rows_per_band - 1) / rows_per_band),
+        process_rows_(process_rows),
+        next_band_(0),
+        bands_left_(num_bands_),
+        done_(base::WaitableEvent::ResetPolicy::MANUAL,
+              base::WaitableEvent::InitialState::NOT_SIGNALED) {}
+
+  // Processes bands until every band has been claimed.
+  void ProcessBands() {
+    while (true) {
+      const int band = base::subtle::NoBarrier_AtomicIncrement(&next_band_, 1) -
+                       1;
+      if (band >= num_bands_)
+        return;
+      const int begin_row = band * rows_per_band_;
+      process_rows_.Run(begin_row,
+                        std::min(begin_row + rows_per_band_, height_));
+      if (base::subtle::Barrier_AtomicIncrement(&bands_left_, -1) == 0)
+        done_.Signal();
+    }
+  }
+
+  // Blocks until every band has been processed.
+  void WaitUntilDone() { done_.Wait(); }
+
+ private:
+  friend class base::RefCountedThreadSafe<RowBands>;
+  ~RowBands() {}
+
+  const int height_;
+  const int rows_per_band_;
+  const int num_bands_;
+  const RowBandCB process_rows_;
+  base::subtle::Atomic32 next_band_;
+  base::subtle::Atomic32 bands_left_;
+  base::WaitableEvent done_;
+
+  DISALLOW_COPY_AND_ASSIGN(RowBands);
+};
+
+int GetRowsPerBand(size_t row_bytes, int row_alignment) {
+  DCHECK_GT(row_alignment, 0);
+  const int rows = static_cast<int>(
+      std::max<size_t>(1, kRowBandBytes / std::max<size_t>(1, row_bytes)));
+  return std::max(row_alignment, rows - rows % row_alignment);
+}
+
+}  // namespace
+
+int GetNumberOfRowBands(int height, size_t row_bytes, int row_alignment) {
+  const int rows_per_band = GetRowsPerBand(row_bytes, row_alignment);
+  return (height + rows_per_band - 1) / rows_per_band;
+}
+
+void RunInParallelRowBands(int height,
+                           size_t row_bytes,
+                           int row_alignment,
+                           base::TaskRunner* task_runner,
+                           int max_tasks,
+                           const RowBandCB& process_rows) {
+  if (height <= 0)
+    return;
+
+  const int rows_per_band = GetRowsPerBand(row_bytes, row_alignment);
+  const int num_bands = (height + rows_per_band - 1) / rows_per_band;
+  const int num_tasks = std::min(max_tasks, num_bands - 1);
+  if (!task_runner || num_tasks <= 0) {
+    process_rows.Run(0, height);
+    return;
+  }
+
+  scoped_refptr<RowBands> bands(
+      new RowBands(height, rows_per_band, process_rows));
+  for (int i = 0; i < num_tasks; ++i) {
+    task_runner->PostTask(FROM_HERE,
+                          base::Bind(&RowBands::ProcessBands, bands));
+  }
+  bands->ProcessBands();
+  bands->WaitUntilDone();
+}
+
+}  // namespace media
@@ -0,0 +1,50 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_BASE_PARALLEL_ROW_BANDS_H_
+#define MEDIA_BASE_PARALLEL_ROW_BANDS_H_
+
+#include <stddef.h>
+
+#include "base/callback.h"
+#include "media/base/media_export.h"
+
+namespace base {
+class TaskRunner;
+}
+
+namespace media {
+
+// Processes rows [begin_row, end_row) of an image.
+typedef base::Callback<void(int begin_row, int end_row)> RowBandCB;
+
+// Returns the number of bands RunInParallelRowBands() splits |height| rows of
+// |row_bytes| output bytes each into.
+MEDIA_EXPORT int GetNumberOfRowBands(int height,
+                                     size_t row_bytes,
+                                     int row_alignment);
+
+// Runs |process_rows| over rows [0, |height|) of an image with |row_bytes|
+// output bytes per row, split into bands of about 256 KB of output each, so
+// that a band's source and destination rows fit in a core's L2 cache. Bands
+// start on multiples of |row_alignment|. The bands are run by the calling
+// thread and by up to |max_tasks| tasks posted to |task_runner|, which take
+// the next unprocessed band until none are left. Returns once every band has
+// been processed, so |process_rows| may refer to the caller's stack; it must
+// be safe to run on different bands concurrently.
+//
+// Tasks which only start once the calling thread has claimed every band
+// return without running anything, so |task_runner| may be busy, or even run
+// tasks on the calling thread, without risk of deadlock. If |task_runner| is
+// null or |max_tasks| is zero, everything runs on the calling thread.
+MEDIA_EXPORT void RunInParallelRowBands(int height,
+                                        size_t row_bytes,
+                                        int row_alignment,
+                                        base::TaskRunner* task_runner,
+                                        int max_tasks,
+                                        const RowBandCB& process_rows);
+
+}  // namespace media
+
+#endif  // MEDIA_BASE_PARALLEL_ROW_BANDS_H_
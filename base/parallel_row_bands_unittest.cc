@@ -0,0 +1,101 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <vector>
+
+#include "base/atomicops.h"
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/macros.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/thread.h"
+#include "media/base/parallel_row_bands.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+
+// A 4K ARGB row, so that a frame is split into many bands.
+static const size_t kRowBytes = 3840 * 4;
+
+class ParallelRowBandsTest : public testing::Test {
+ public:
+  ParallelRowBandsTest() : thread_("ParallelRowBandsTest") {
+    CHECK(thread_.Start());
+  }
+
+  // Records that rows [begin_row, end_row) have been processed.
+  void ProcessRows(int row_alignment, int begin_row, int end_row) {
+    EXPECT_EQ(0, begin_row % row_alignment);
+    EXPECT_LT(begin_row, end_row);
+    for (int row = begin_row; row < end_row; ++row)
+      base::subtle::NoBarrier_AtomicIncrement(&row_counts_[row], 1);
+    base::subtle::NoBarrier_AtomicIncrement(&num_bands_, 1);
+  }
+
+  void Run(int height,
+           int row_alignment,
+           base::TaskRunner* task_runner,
+           int max_tasks) {
+    row_counts_.assign(height, 0);
+    num_bands_ = 0;
+    RunInParallelRowBands(
+        height, kRowBytes, row_alignment, task_runner, max_tasks,
+        base::Bind(&ParallelRowBandsTest::ProcessRows, base::Unretained(this),
+                   row_alignment));
+    for (int row = 0; row < height; ++row)
+      EXPECT_EQ(1, row_counts_[row]) << "row " << row;
+  }
+
+ protected:
+  base::Thread thread_;
+  std::vector<base::subtle::Atomic32> row_counts_;
+  base::subtle::Atomic32 num_bands_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ParallelRowBandsTest);
+};
+
+TEST_F(ParallelRowBandsTest, NumberOfRowBands) {
+  EXPECT_EQ(0, GetNumberOfRowBands(0, kRowBytes, 1));
+  EXPECT_EQ(1, GetNumberOfRowBands(1, kRowBytes, 1));
+  EXPECT_EQ(1, GetNumberOfRowBands(16, kRowBytes, 1));
+  EXPECT_LT(1, GetNumberOfRowBands(2160, kRowBytes, 1));
+
+  // Bands hold at least one aligned group of rows, however wide the rows.
+  EXPECT_EQ(5, GetNumberOfRowBands(10, 1024 * 1024, 2));
+}
+
+TEST_F(ParallelRowBandsTest, RunsInlineWithoutTaskRunner) {
+  Run(2160, 2, nullptr, 3);
+  EXPECT_EQ(1, num_bands_);
+}
+
+TEST_F(ParallelRowBandsTest, RunsInlineWithoutTasks) {
+  Run(2160, 2, thread_.task_runner().get(), 0);
+  EXPECT_EQ(1, num_bands_);
+}
+
+TEST_F(ParallelRowBandsTest, ProcessesEveryRowOnce) {
+  Run(2160, 1, thread_.task_runner().get(), 3);
+  EXPECT_EQ(GetNumberOfRowBands(2160, kRowBytes, 1), num_bands_);
+
+  Run(2161, 2, thread_.task_runner().get(), 3);
+  EXPECT_EQ(GetNumberOfRowBands(2161, kRowBytes, 2), num_bands_);
+}
+
+TEST_F(ParallelRowBandsTest, BusyTaskRunner) {
+  base::WaitableEvent unblock(base::WaitableEvent::ResetPolicy::MANUAL,
+                              base::WaitableEvent::InitialState::NOT_SIGNALED);
+  thread_.task_runner()->PostTask(
+      FROM_HERE,
+      base::Bind(&base::WaitableEvent::Wait, base::Unretained(&unblock)));
+
+  // The calling thread processes every band itself rather than waiting for
+  // the blocked thread.
+  Run(2160, 2, thread_.task_runner().get(), 3);
+  unblock.Signal();
+  thread_.Stop();
+}
+
+}  // namespace media
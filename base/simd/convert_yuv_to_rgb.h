@@ -104,6 +104,47 @@ MEDIA_EXPORT void LinearScaleYUVToRGB32RowWithRange_C(
     int source_dx,
     const int16_t* convert_table);
 
+// Fixed point coefficients of the high bit depth row converters. Byte |i| of
+// each output pixel is
+//   (y * y_coeffs[i] + u * u_coeffs[i] + v * v_coeffs[i] + biases[i]) >> shift
+// clamped to [0, 255], where y, u and v are the samples masked with
+// |sample_mask|. The fourth byte is always 255.
+struct HighBitDepthYUVToRGBCoefficients {
+  int16_t y_coeffs[3];
+  int16_t u_coeffs[3];
+  int16_t v_coeffs[3];
+  int32_t biases[3];
+  int shift;
+  uint16_t sample_mask;
+};
+
+// Populates |coefficients| for converting |bit_depth| YUV with a normalized
+// YUV->RGB matrix, see ConvertHighBitDepthYUVToARGB().
+MEDIA_EXPORT void PopulateHighBitDepthYUVToRGBCoefficients(
+    const double matrix[3][4],
+    int bit_depth,
+    HighBitDepthYUVToRGBCoefficients* coefficients);
+
+// Converts one row of 9 to 12 bit YUV. Chroma is horizontally subsampled by
+// two if |uv_width_shift| is 1.
+MEDIA_EXPORT void ConvertHighBitDepthYUVToARGBRow_C(
+    const uint16_t* y_buf,
+    const uint16_t* u_buf,
+    const uint16_t* v_buf,
+    uint8_t* rgb_buf,
+    ptrdiff_t width,
+    int uv_width_shift,
+    const HighBitDepthYUVToRGBCoefficients* coefficients);
+
+MEDIA_EXPORT void ConvertHighBitDepthYUVToARGBRow_SSE2(
+    const uint16_t* y_buf,
+    const uint16_t* u_buf,
+    const uint16_t* v_buf,
+    uint8_t* rgb_buf,
+    ptrdiff_t width,
+    int uv_width_shift,
+    const HighBitDepthYUVToRGBCoefficients* coefficients);
+
 }  // namespace media
 
 // Assembly functions are declared without namespace.
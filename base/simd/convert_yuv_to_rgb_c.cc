@@ -5,6 +5,10 @@
 #include <stddef.h>
 #include <stdint.h>
 
+#include <algorithm>
+#include <cmath>
+
+#include "base/logging.h"
 #include "build/build_config.h"
 #include "media/base/simd/convert_yuv_to_rgb.h"
 
@@ -216,6 +220,68 @@ void LinearScaleYUVToRGB32RowWithRange_C(const uint8_t* y_buf,
   }
 }
 
+void PopulateHighBitDepthYUVToRGBCoefficients(
+    const double matrix[3][4],
+    int bit_depth,
+    HighBitDepthYUVToRGBCoefficients* coefficients) {
+  // Results get 5 more fraction bits than the samples have bits, so that the
+  // coefficients, which also absorb the 255 << (bit_depth - 8) normalization,
+  // are the matrix elements with 13 fraction bits whatever the bit depth. That
+  // fits elements of up to 4 in an int16_t, and keeps the sums of products of
+  // 12 bit samples well within an int32_t.
+  const int shift = bit_depth + 5;
+  const double kCoefficientScale = 1 << 13;
+
+  for (int i = 0; i < 3; ++i) {
+#if defined(OS_ANDROID)
+    // Android is RGBA.
+    const double* row = matrix[i];
+#else
+    // Other platforms are BGRA.
+    const double* row = matrix[2 - i];
+#endif
+    int16_t* coeffs[3] = {&coefficients->y_coeffs[i],
+                          &coefficients->u_coeffs[i],
+                          &coefficients->v_coeffs[i]};
+    for (int j = 0; j < 3; ++j) {
+      DCHECK_LT(std::abs(row[j]), 4.0);
+      *coeffs[j] = static_cast<int16_t>(std::max(
+          -32768.0, std::min(32767.0, row[j] * kCoefficientScale + 0.5)));
+    }
+    coefficients->biases[i] =
+        static_cast<int32_t>(std::floor(row[3] * 255 * (1 << shift) + 0.5)) +
+        (1 << (shift - 1));
+  }
+  coefficients->shift = shift;
+  coefficients->sample_mask = (1 << bit_depth) - 1;
+}
+
+void ConvertHighBitDepthYUVToARGBRow_C(
+    const uint16_t* y_buf,
+    const uint16_t* u_buf,
+    const uint16_t* v_buf,
+    uint8_t* rgb_buf,
+    ptrdiff_t width,
+    int uv_width_shift,
+    const HighBitDepthYUVToRGBCoefficients* coefficients) {
+  const int mask = coefficients->sample_mask;
+  for (ptrdiff_t x = 0; x < width; ++x) {
+    const int y = y_buf[x] & mask;
+    const int u = u_buf[x >> uv_width_shift] & mask;
+    const int v = v_buf[x >> uv_width_shift] & mask;
+    for (int i = 0; i < 3; ++i) {
+      const int value = (y * coefficients->y_coeffs[i] +
+                         u * coefficients->u_coeffs[i] +
+                         v * coefficients->v_coeffs[i] +
+                         coefficients->biases[i]) >>
+                        coefficients->shift;
+      rgb_buf[i] = packuswb(value);
+    }
+    rgb_buf[3] = 255;
+    rgb_buf += 4;
+  }
+}
+
 void ConvertYUVToRGB32_C(const uint8_t* yplane,
                          const uint8_t* uplane,
                          const uint8_t* vplane,
@@ -0,0 +1,112 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <emmintrin.h>
+#endif
+
+#include "media/base/simd/convert_yuv_to_rgb.h"
+
+namespace media {
+
+namespace {
+
+// Returns the 32 bit lanes of (y, u) pairs multiplied by the (y, u)
+// coefficients of one channel, plus the (v, 0) pairs multiplied by its v
+// coefficient, plus its bias, shifted down to 8 bit precision.
+inline __m128i ConvertChannel(__m128i yu,
+                              __m128i v0,
+                              __m128i yu_coeffs,
+                              __m128i v_coeff,
+                              __m128i bias,
+                              __m128i shift) {
+  __m128i value = _mm_add_epi32(_mm_madd_epi16(yu, yu_coeffs),
+                                _mm_madd_epi16(v0, v_coeff));
+  return _mm_sra_epi32(_mm_add_epi32(value, bias), shift);
+}
+
+}  // namespace
+
+void ConvertHighBitDepthYUVToARGBRow_SSE2(
+    const uint16_t* y_buf,
+    const uint16_t* u_buf,
+    const uint16_t* v_buf,
+    uint8_t* rgb_buf,
+    ptrdiff_t width,
+    int uv_width_shift,
+    const HighBitDepthYUVToRGBCoefficients* coefficients) {
+  const __m128i zero = _mm_setzero_si128();
+  const __m128i alpha = _mm_set1_epi16(255);
+  const __m128i mask = _mm_set1_epi16(coefficients->sample_mask);
+  const __m128i shift = _mm_cvtsi32_si128(coefficients->shift);
+  __m128i yu_coeffs[3];
+  __m128i v_coeffs[3];
+  __m128i biases[3];
+  for (int i = 0; i < 3; ++i) {
+    yu_coeffs[i] = _mm_set1_epi32(
+        (static_cast<uint16_t>(coefficients->u_coeffs[i]) << 16) |
+        static_cast<uint16_t>(coefficients->y_coeffs[i]));
+    v_coeffs[i] =
+        _mm_set1_epi32(static_cast<uint16_t>(coefficients->v_coeffs[i]));
+    biases[i] = _mm_set1_epi32(coefficients->biases[i]);
+  }
+
+  // Eight pixels per iteration. The masked samples are at most 12 bits, so
+  // the products accumulate exactly as in the C version.
+  ptrdiff_t x = 0;
+  for (; x + 8 <= width; x += 8) {
+    const __m128i y = _mm_and_si128(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(y_buf + x)), mask);
+    __m128i u;
+    __m128i v;
+    if (uv_width_shift) {
+      u = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(u_buf + x / 2));
+      v = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(v_buf + x / 2));
+      u = _mm_unpacklo_epi16(u, u);
+      v = _mm_unpacklo_epi16(v, v);
+    } else {
+      u = _mm_loadu_si128(reinterpret_cast<const __m128i*>(u_buf + x));
+      v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(v_buf + x));
+    }
+    u = _mm_and_si128(u, mask);
+    v = _mm_and_si128(v, mask);
+
+    const __m128i yu_lo = _mm_unpacklo_epi16(y, u);
+    const __m128i yu_hi = _mm_unpackhi_epi16(y, u);
+    const __m128i v0_lo = _mm_unpacklo_epi16(v, zero);
+    const __m128i v0_hi = _mm_unpackhi_epi16(v, zero);
+
+    __m128i channels[3];
+    for (int i = 0; i < 3; ++i) {
+      channels[i] = _mm_packs_epi32(
+          ConvertChannel(yu_lo, v0_lo, yu_coeffs[i], v_coeffs[i], biases[i],
+                         shift),
+          ConvertChannel(yu_hi, v0_hi, yu_coeffs[i], v_coeffs[i], biases[i],
+                         shift));
+    }
+
+    // Clamp to bytes and interleave the channels and alpha into pixels.
+    const __m128i c0c2 = _mm_packus_epi16(channels[0], channels[2]);
+    const __m128i c1a = _mm_packus_epi16(channels[1], alpha);
+    const __m128i c0c1 = _mm_unpacklo_epi8(c0c2, c1a);
+    const __m128i c2a = _mm_unpackhi_epi8(c0c2, c1a);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(rgb_buf + x * 4),
+                     _mm_unpacklo_epi16(c0c1, c2a));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(rgb_buf + x * 4 + 16),
+                     _mm_unpackhi_epi16(c0c1, c2a));
+  }
+
+  if (x < width) {
+    ConvertHighBitDepthYUVToARGBRow_C(
+        y_buf + x, u_buf + (x >> uv_width_shift), v_buf + (x >> uv_width_shift),
+        rgb_buf + x * 4, width - x, uv_width_shift, coefficients);
+  }
+}
+
+}  // namespace media
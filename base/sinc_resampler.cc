@@ -72,6 +72,18 @@
 //
 // Note: we're glossing over how the sub-sample handling works with
 // |virtual_source_idx_|, etc.
+//
+// Kernels depend only on the sample rate ratio and are shared between all
+// resamplers through a process-wide cache, so creating a resampler (or one per
+// channel of a MultiChannelResampler) for an already used ratio does no kernel
+// work at all.  When the ratio is a fraction p / q with a small q, as it is for
+// conversions between the usual sample rates, output frame n lands exactly on
+// sub-sample offset (n * p mod q) / q.  A kernel is precomputed for each of
+// those q offsets and convolved directly, skipping the interpolation between
+// two kernel offsets that arbitrary ratios need.
+//
+// SetRatio() may run on the real-time audio thread, so it never uses the
+// cache; it rebuilds a private copy of the interpolated kernels in place.
 
 // MSVC++ requires this to be set before any other includes to get M_PI.
 #define _USE_MATH_DEFINES
@@ -80,22 +92,215 @@
 
 #include <cmath>
 #include <limits>
+#include <map>
+#include <tuple>
 
+#include "base/lazy_instance.h"
 #include "base/logging.h"
+#include "base/synchronization/lock.h"
 #include "build/build_config.h"
 
 #if defined(ARCH_CPU_X86_FAMILY)
+#include <immintrin.h>
 #include <xmmintrin.h>
+
+#include "base/cpu.h"
 #define CONVOLVE_FUNC Convolve_SSE
+#define CONVOLVE_SINGLE_FUNC ConvolveSingle_SSE
+
+// GCC and clang only emit AVX instructions inside functions that explicitly
+// target AVX; MSVC accepts the intrinsics anywhere.
+#if defined(COMPILER_MSVC)
+#define TARGET_AVX
+#else
+#define TARGET_AVX __attribute__((target("avx")))
+#endif
 #elif defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
 #include <arm_neon.h>
 #define CONVOLVE_FUNC Convolve_NEON
+#define CONVOLVE_SINGLE_FUNC ConvolveSingle_NEON
 #else
 #define CONVOLVE_FUNC Convolve_C
+#define CONVOLVE_SINGLE_FUNC ConvolveSingle_C
 #endif
 
 namespace media {
 
+SincResampler::ConvolveProc SincResampler::convolve_proc_ =
+    SincResampler::CONVOLVE_FUNC;
+SincResampler::ConvolveSingleProc SincResampler::convolve_single_proc_ =
+    SincResampler::CONVOLVE_SINGLE_FUNC;
+
+// static
+void SincResampler::InitializeCPUSpecificFeatures() {
+#if defined(ARCH_CPU_X86_FAMILY)
+  base::CPU cpu;
+  if (cpu.has_avx()) {
+    convolve_proc_ = Convolve_AVX;
+    convolve_single_proc_ = ConvolveSingle_AVX;
+  }
+#endif
+}
+
+// |count| windowed sinc() kernels of kKernelSize taps each, the i-th shifted
+// by i / |divisor| samples.
+class SincResampler::Kernel : public base::RefCountedThreadSafe<Kernel> {
+ public:
+  Kernel(double sinc_scale_factor, int divisor, int count)
+      : sinc_scale_factor_(sinc_scale_factor),
+        storage_(static_cast<float*>(
+            base::AlignedAlloc(sizeof(float) * kKernelSize * count, 16))) {
+    // Blackman window parameters.
+    static const double kAlpha = 0.16;
+    static const double kA0 = 0.5 * (1.0 - kAlpha);
+    static const double kA1 = 0.5;
+    static const double kA2 = 0.5 * kAlpha;
+
+    for (int offset_idx = 0; offset_idx < count; ++offset_idx) {
+      const float subsample_offset = static_cast<float>(offset_idx) / divisor;
+
+      for (int i = 0; i < kKernelSize; ++i) {
+        const int idx = i + offset_idx * kKernelSize;
+        const float pre_sinc =
+            static_cast<float>(M_PI * (i - kKernelSize / 2 - subsample_offset));
+
+        // Compute Blackman window, matching the offset of the sinc().
+        const float x = (i - subsample_offset) / kKernelSize;
+        const float window = static_cast<float>(
+            kA0 - kA1 * cos(2.0 * M_PI * x) + kA2 * cos(4.0 * M_PI * x));
+
+        // Compute the sinc with offset, then window the sinc() function and
+        // store at the correct offset.
+        storage_[idx] = static_cast<float>(
+            window * (pre_sinc ? sin(sinc_scale_factor * pre_sinc) / pre_sinc
+                               : sinc_scale_factor));
+      }
+    }
+  }
+
+  const float* data() const { return storage_.get(); }
+  double sinc_scale_factor() const { return sinc_scale_factor_; }
+
+ private:
+  friend class base::RefCountedThreadSafe<Kernel>;
+  ~Kernel() {}
+
+  const double sinc_scale_factor_;
+  std::unique_ptr<float[], base::AlignedFreeDeleter> storage_;
+
+  DISALLOW_COPY_AND_ASSIGN(Kernel);
+};
+
+namespace {
+
+// Process-wide cache of the kernels in use by any SincResampler.  Entries are
+// kept until a later lookup finds no resampler holds them anymore.  Lookups
+// lock and may build kernels, so they only happen during construction.
+class KernelCache {
+ public:
+  KernelCache() {}
+
+  scoped_refptr<const SincResampler::Kernel>
+  Get(double sinc_scale_factor, int divisor, int count) {
+    const Key key(sinc_scale_factor, divisor, count);
+    base::AutoLock auto_lock(lock_);
+    auto it = kernels_.find(key);
+    if (it != kernels_.end())
+      return it->second;
+
+    // Drop kernels nobody uses anymore before adding another, so a resampler
+    // which changes ratio continuously doesn't grow the cache without bound.
+    for (it = kernels_.begin(); it != kernels_.end();) {
+      if (it->second->HasOneRef())
+        it = kernels_.erase(it);
+      else
+        ++it;
+    }
+
+    scoped_refptr<const SincResampler::Kernel> kernel(
+        new SincResampler::Kernel(sinc_scale_factor, divisor, count));
+    kernels_[key] = kernel;
+    return kernel;
+  }
+
+ private:
+  typedef std::tuple<double, int, int> Key;
+
+  base::Lock lock_;
+  std::map<Key, scoped_refptr<const SincResampler::Kernel>> kernels_;
+
+  DISALLOW_COPY_AND_ASSIGN(KernelCache);
+};
+
+base::LazyInstance<KernelCache>::Leaky g_kernel_cache =
+    LAZY_INSTANCE_INITIALIZER;
+
+// The parts of the kKernelOffsetCount + 1 interpolated kernels which don't
+// depend on the ratio.  Lets SetRatio() rebuild kernels with a third of the
+// work.
+struct KernelTables {
+  KernelTables() {
+    // Blackman window parameters.
+    static const double kAlpha = 0.16;
+    static const double kA0 = 0.5 * (1.0 - kAlpha);
+    static const double kA1 = 0.5;
+    static const double kA2 = 0.5 * kAlpha;
+
+    for (int offset_idx = 0; offset_idx <= SincResampler::kKernelOffsetCount;
+         ++offset_idx) {
+      const float subsample_offset =
+          static_cast<float>(offset_idx) / SincResampler::kKernelOffsetCount;
+
+      for (int i = 0; i < SincResampler::kKernelSize; ++i) {
+        const int idx = i + offset_idx * SincResampler::kKernelSize;
+        pre_sinc[idx] = static_cast<float>(
+            M_PI * (i - SincResampler::kKernelSize / 2 - subsample_offset));
+
+        // Compute Blackman window, matching the offset of the sinc().
+        const float x = (i - subsample_offset) / SincResampler::kKernelSize;
+        window[idx] = static_cast<float>(kA0 - kA1 * cos(2.0 * M_PI * x) +
+                                         kA2 * cos(4.0 * M_PI * x));
+      }
+    }
+  }
+
+  float pre_sinc[SincResampler::kKernelStorageSize];
+  float window[SincResampler::kKernelStorageSize];
+};
+
+base::LazyInstance<KernelTables>::Leaky g_kernel_tables =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+// Returns true if |io_ratio| is |numerator| / |denominator|.  The tolerance
+// only absorbs the rounding of computing the ratio from two integer sample
+// rates.
+static bool IsFixedRatio(double io_ratio, int numerator, int denominator) {
+  static const double kTolerance = 1e-12;
+  return fabs(io_ratio * denominator - numerator) <= kTolerance * numerator;
+}
+
+// Returns true if |io_ratio| is |*numerator| / |*denominator| in lowest terms
+// with a denominator of at most kMaxFixedRatioPhases.
+static bool GetFixedRatio(double io_ratio, int* numerator, int* denominator) {
+  if (io_ratio <= 0 ||
+      io_ratio * SincResampler::kMaxFixedRatioPhases >
+          std::numeric_limits<int>::max()) {
+    return false;
+  }
+
+  for (int q = 1; q <= SincResampler::kMaxFixedRatioPhases; ++q) {
+    const int p = static_cast<int>(std::round(io_ratio * q));
+    if (p > 0 && IsFixedRatio(io_ratio, p, q)) {
+      *numerator = p;
+      *denominator = q;
+      return true;
+    }
+  }
+  return false;
+}
+
 static double SincScaleFactor(double io_ratio) {
   // |sinc_scale_factor| is basically the normalized cutoff frequency of the
   // low-pass filter.
@@ -123,13 +328,14 @@ SincResampler::SincResampler(double io_sample_rate_ratio,
       read_cb_(read_cb),
       request_frames_(request_frames),
       input_buffer_size_(request_frames_ + kKernelSize),
-      // Create input buffers with a 16-byte alignment for SSE optimizations.
+      // Create buffers with a 16-byte alignment for SSE optimizations.
       kernel_storage_(static_cast<float*>(
           base::AlignedAlloc(sizeof(float) * kKernelStorageSize, 16))),
-      kernel_pre_sinc_storage_(static_cast<float*>(
-          base::AlignedAlloc(sizeof(float) * kKernelStorageSize, 16))),
-      kernel_window_storage_(static_cast<float*>(
-          base::AlignedAlloc(sizeof(float) * kKernelStorageSize, 16))),
+      kernel_storage_scale_factor_(0),
+      current_kernel_(nullptr),
+      fixed_ratio_enabled_(false),
+      fixed_ratio_numerator_(0),
+      fixed_ratio_denominator_(0),
       input_buffer_(static_cast<float*>(
           base::AlignedAlloc(sizeof(float) * input_buffer_size_, 16))),
       r1_(input_buffer_.get()),
@@ -139,14 +345,7 @@ SincResampler::SincResampler(double io_sample_rate_ratio,
   CHECK_GT(block_size_, kKernelSize)
       << "block_size must be greater than kKernelSize!";
 
-  memset(kernel_storage_.get(), 0,
-         sizeof(*kernel_storage_.get()) * kKernelStorageSize);
-  memset(kernel_pre_sinc_storage_.get(), 0,
-         sizeof(*kernel_pre_sinc_storage_.get()) * kKernelStorageSize);
-  memset(kernel_window_storage_.get(), 0,
-         sizeof(*kernel_window_storage_.get()) * kKernelStorageSize);
-
-  InitializeKernel();
+  InitializeKernels();
 }
 
 SincResampler::~SincResampler() {}
@@ -168,39 +367,24 @@ void SincResampler::UpdateRegions(bool second_load) {
   CHECK_LT(r2_, r3_);
 }
 
-void SincResampler::InitializeKernel() {
-  // Blackman window parameters.
-  static const double kAlpha = 0.16;
-  static const double kA0 = 0.5 * (1.0 - kAlpha);
-  static const double kA1 = 0.5;
-  static const double kA2 = 0.5 * kAlpha;
-
-  // Generates a set of windowed sinc() kernels.
-  // We generate a range of sub-sample offsets from 0.0 to 1.0.
+void SincResampler::InitializeKernels() {
+  // Kernels built for a ratio are reused by every other ratio with the same
+  // |sinc_scale_factor|; e.g. all upsampling ratios share the same kernels.
   const double sinc_scale_factor = SincScaleFactor(io_sample_rate_ratio_);
-  for (int offset_idx = 0; offset_idx <= kKernelOffsetCount; ++offset_idx) {
-    const float subsample_offset =
-        static_cast<float>(offset_idx) / kKernelOffsetCount;
-
-    for (int i = 0; i < kKernelSize; ++i) {
-      const int idx = i + offset_idx * kKernelSize;
-      const float pre_sinc =
-          static_cast<float>(M_PI * (i - kKernelSize / 2 - subsample_offset));
-      kernel_pre_sinc_storage_[idx] = pre_sinc;
-
-      // Compute Blackman window, matching the offset of the sinc().
-      const float x = (i - subsample_offset) / kKernelSize;
-      const float window = static_cast<float>(kA0 - kA1 * cos(2.0 * M_PI * x) +
-          kA2 * cos(4.0 * M_PI * x));
-      kernel_window_storage_[idx] = window;
-
-      // Compute the sinc with offset, then window the sinc() function and store
-      // at the correct offset.
-      kernel_storage_[idx] = static_cast<float>(
-          window * (pre_sinc ? sin(sinc_scale_factor * pre_sinc) / pre_sinc
-                             : sinc_scale_factor));
-    }
+  kernel_ = g_kernel_cache.Get().Get(sinc_scale_factor, kKernelOffsetCount,
+                                     kKernelOffsetCount + 1);
+  current_kernel_ = kernel_->data();
+
+  if (GetFixedRatio(io_sample_rate_ratio_, &fixed_ratio_numerator_,
+                    &fixed_ratio_denominator_)) {
+    phase_kernels_ = g_kernel_cache.Get().Get(
+        sinc_scale_factor, fixed_ratio_denominator_, fixed_ratio_denominator_);
+    fixed_ratio_enabled_ = true;
   }
+
+  // Build the ratio independent tables now rather than on the first
+  // SetRatio().
+  g_kernel_tables.Get();
 }
 
 void SincResampler::SetRatio(double io_sample_rate_ratio) {
@@ -212,31 +396,60 @@ void SincResampler::SetRatio(double io_sample_rate_ratio) {
   io_sample_rate_ratio_ = io_sample_rate_ratio;
   chunk_size_ = CalculateChunkSize(block_size_, io_sample_rate_ratio_);
 
-  // Optimize reinitialization by reusing values which are independent of
-  // |sinc_scale_factor|.  Provides a 3x speedup.
+  // This may be called on the real-time audio thread (e.g. by AudioShifter for
+  // every Pull()), so it mustn't take locks, allocate or release the shared
+  // kernels.  Only the ratio the phase kernels were built for can use them.
+  fixed_ratio_enabled_ =
+      phase_kernels_ && IsFixedRatio(io_sample_rate_ratio_,
+                                     fixed_ratio_numerator_,
+                                     fixed_ratio_denominator_);
+
   const double sinc_scale_factor = SincScaleFactor(io_sample_rate_ratio_);
-  for (int offset_idx = 0; offset_idx <= kKernelOffsetCount; ++offset_idx) {
-    for (int i = 0; i < kKernelSize; ++i) {
-      const int idx = i + offset_idx * kKernelSize;
-      const float window = kernel_window_storage_[idx];
-      const float pre_sinc = kernel_pre_sinc_storage_[idx];
-
-      kernel_storage_[idx] = static_cast<float>(
-          window * (pre_sinc ? sin(sinc_scale_factor * pre_sinc) / pre_sinc
-                             : sinc_scale_factor));
-    }
+  if (sinc_scale_factor == kernel_->sinc_scale_factor()) {
+    current_kernel_ = kernel_->data();
+    return;
+  }
+  current_kernel_ = kernel_storage_.get();
+  if (sinc_scale_factor == kernel_storage_scale_factor_)
+    return;
+
+  // Rebuild |kernel_storage_| in place, reusing the values which are
+  // independent of |sinc_scale_factor|.  Provides a 3x speedup.
+  const KernelTables& tables = g_kernel_tables.Get();
+  for (int idx = 0; idx < kKernelStorageSize; ++idx) {
+    const float window = tables.window[idx];
+    const float pre_sinc = tables.pre_sinc[idx];
+
+    kernel_storage_[idx] = static_cast<float>(
+        window * (pre_sinc ? sin(sinc_scale_factor * pre_sinc) / pre_sinc
+                           : sinc_scale_factor));
   }
+  kernel_storage_scale_factor_ = sinc_scale_factor;
 }
 
-void SincResampler::Resample(int frames, float* destination) {
-  int remaining_frames = frames;
+const float* SincResampler::get_kernel_for_testing() const {
+  return current_kernel_;
+}
+
+void SincResampler::DisableFixedRatioForTesting() {
+  fixed_ratio_enabled_ = false;
+}
 
+void SincResampler::Resample(int frames, float* destination) {
   // Step (1) -- Prime the input buffer at the start of the input stream.
-  if (!buffer_primed_ && remaining_frames) {
+  if (!buffer_primed_ && frames) {
     read_cb_.Run(request_frames_, r0_);
     buffer_primed_ = true;
   }
 
+  if (fixed_ratio_enabled_) {
+    ResampleFixedRatio(frames, destination);
+    return;
+  }
+
+  const float* const kernel_storage = current_kernel_;
+  int remaining_frames = frames;
+
   // Step (2) -- Resample!
   while (remaining_frames) {
     while (virtual_source_idx_ < block_size_) {
@@ -249,7 +462,7 @@ void SincResampler::Resample(int frames, float* destination) {
 
       // We'll compute "convolutions" for the two kernels which straddle
       // |virtual_source_idx_|.
-      const float* k1 = kernel_storage_.get() + offset_idx * kKernelSize;
+      const float* k1 = kernel_storage + offset_idx * kKernelSize;
       const float* k2 = k1 + kKernelSize;
 
       // Ensure |k1|, |k2| are 16-byte aligned for SIMD usage.  Should always be
@@ -264,7 +477,7 @@ void SincResampler::Resample(int frames, float* destination) {
       const double kernel_interpolation_factor =
           virtual_offset_idx - offset_idx;
       *destination++ =
-          CONVOLVE_FUNC(input_ptr, k1, k2, kernel_interpolation_factor);
+          convolve_proc_(input_ptr, k1, k2, kernel_interpolation_factor);
 
       // Advance the virtual index.
       virtual_source_idx_ += io_sample_rate_ratio_;
@@ -275,20 +488,70 @@ void SincResampler::Resample(int frames, float* destination) {
     // Wrap back around to the start.
     DCHECK_GE(virtual_source_idx_, block_size_);
     virtual_source_idx_ -= block_size_;
+    LoadNextBlock();
+  }
+}
 
-    // Step (3) -- Copy r3_, r4_ to r1_, r2_.
-    // This wraps the last input frames back to the start of the buffer.
-    memcpy(r1_, r3_, sizeof(*input_buffer_.get()) * kKernelSize);
+void SincResampler::ResampleFixedRatio(int frames, float* destination) {
+  // Split |virtual_source_idx_| into a whole source frame and a phase in units
+  // of 1 / |fixed_ratio_denominator_|.  While the fixed ratio is in use it's
+  // always a multiple of that, so the split is exact and nothing drifts.
+  const int phase_count = fixed_ratio_denominator_;
+  const int source_step = fixed_ratio_numerator_ / phase_count;
+  const int phase_step = fixed_ratio_numerator_ % phase_count;
+  int source_idx = static_cast<int>(virtual_source_idx_);
+  int phase = static_cast<int>(
+      std::round((virtual_source_idx_ - source_idx) * phase_count));
+  if (phase == phase_count) {
+    phase = 0;
+    ++source_idx;
+  }
 
-    // Step (4) -- Reinitialize regions if necessary.
-    if (r0_ == r2_)
-      UpdateRegions(true);
+  const float* const phase_kernels = phase_kernels_->data();
+  int remaining_frames = frames;
 
-    // Step (5) -- Refresh the buffer with more input.
-    read_cb_.Run(request_frames_, r0_);
+  // Step (2) -- Resample!
+  while (remaining_frames) {
+    while (source_idx < block_size_) {
+      const float* k = phase_kernels + phase * kKernelSize;
+      DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(k) & 0x0F);
+      *destination++ = convolve_single_proc_(r1_ + source_idx, k);
+
+      source_idx += source_step;
+      phase += phase_step;
+      if (phase >= phase_count) {
+        phase -= phase_count;
+        ++source_idx;
+      }
+
+      if (!--remaining_frames) {
+        virtual_source_idx_ =
+            source_idx + static_cast<double>(phase) / phase_count;
+        return;
+      }
+    }
+
+    // Wrap back around to the start.  |virtual_source_idx_| is kept current
+    // since |read_cb_| may call BufferedFrames().
+    source_idx -= block_size_;
+    virtual_source_idx_ = source_idx + static_cast<double>(phase) / phase_count;
+    LoadNextBlock();
   }
 }
 
+void SincResampler::LoadNextBlock() {
+  // Step (3) -- Copy r3_, r4_ to r1_, r2_.
+  // This wraps the last input frames back to the start of the buffer.
+  memcpy(r1_, r3_, sizeof(*input_buffer_.get()) * kKernelSize);
+
+  // Step (4) -- Reinitialize regions if necessary.
+  if (r0_ == r2_)
+    UpdateRegions(true);
+
+  // Step (5) -- Refresh the buffer with more input.
+  read_cb_.Run(request_frames_, r0_);
+}
+
 void SincResampler::PrimeWithSilence() {
   // By enforcing the buffer hasn't been primed, we ensure the input buffer has
   // already been zeroed during construction or by a previous Flush() call.
@@ -328,6 +591,16 @@ float SincResampler::Convolve_C(const float* input_ptr, const float* k1,
       kernel_interpolation_factor * sum2);
 }
 
+float SincResampler::ConvolveSingle_C(const float* input_ptr, const float* k) {
+  float sum = 0;
+
+  int n = kKernelSize;
+  while (n--)
+    sum += *input_ptr++ * *k++;
+
+  return sum;
+}
+
 #if defined(ARCH_CPU_X86_FAMILY)
 float SincResampler::Convolve_SSE(const float* input_ptr, const float* k1,
                                   const float* k2,
@@ -367,6 +640,82 @@ float SincResampler::Convolve_SSE(const float* input_ptr, const float* k1,
 
   return result;
 }
+
+float SincResampler::ConvolveSingle_SSE(const float* input_ptr,
+                                        const float* k) {
+  __m128 m_sums = _mm_setzero_ps();
+
+  // Based on |input_ptr| alignment, we need to use loadu or load.
+  if (reinterpret_cast<uintptr_t>(input_ptr) & 0x0F) {
+    for (int i = 0; i < kKernelSize; i += 4) {
+      m_sums = _mm_add_ps(m_sums, _mm_mul_ps(_mm_loadu_ps(input_ptr + i),
+                                             _mm_load_ps(k + i)));
+    }
+  } else {
+    for (int i = 0; i < kKernelSize; i += 4) {
+      m_sums = _mm_add_ps(m_sums, _mm_mul_ps(_mm_load_ps(input_ptr + i),
+                                             _mm_load_ps(k + i)));
+    }
+  }
+
+  // Sum components together.
+  float result;
+  m_sums = _mm_add_ps(_mm_movehl_ps(m_sums, m_sums), m_sums);
+  _mm_store_ss(&result,
+               _mm_add_ss(m_sums, _mm_shuffle_ps(m_sums, m_sums, 1)));
+
+  return result;
+}
+
+// static
+TARGET_AVX float SincResampler::Convolve_AVX(
+    const float* input_ptr,
+    const float* k1,
+    const float* k2,
+    double kernel_interpolation_factor) {
+  __m256 m_input;
+  __m256 m_sums1 = _mm256_setzero_ps();
+  __m256 m_sums2 = _mm256_setzero_ps();
+
+  // Unaligned loads are as fast as aligned ones on AVX hardware when the data
+  // happens to be aligned, so there is no need for separate loops here.
+  for (int i = 0; i < kKernelSize; i += 8) {
+    m_input = _mm256_loadu_ps(input_ptr + i);
+    m_sums1 = _mm256_add_ps(m_sums1,
+                            _mm256_mul_ps(m_input, _mm256_loadu_ps(k1 + i)));
+    m_sums2 = _mm256_add_ps(m_sums2,
+                            _mm256_mul_ps(m_input, _mm256_loadu_ps(k2 + i)));
+  }
+
+  // Linearly interpolate the two "convolutions".
+  m_sums1 = _mm256_mul_ps(m_sums1, _mm256_set1_ps(static_cast<float>(
+                                       1.0 - kernel_interpolation_factor)));
+  m_sums2 = _mm256_mul_ps(
+      m_sums2, _mm256_set1_ps(static_cast<float>(kernel_interpolation_factor)));
+  m_sums1 = _mm256_add_ps(m_sums1, m_sums2);
+
+  // Sum components together.
+  __m128 m_sum = _mm_add_ps(_mm256_castps256_ps128(m_sums1),
+                            _mm256_extractf128_ps(m_sums1, 1));
+  m_sum = _mm_add_ps(_mm_movehl_ps(m_sum, m_sum), m_sum);
+  return _mm_cvtss_f32(_mm_add_ss(m_sum, _mm_shuffle_ps(m_sum, m_sum, 1)));
+}
+
+// static
+TARGET_AVX float SincResampler::ConvolveSingle_AVX(const float* input_ptr,
+                                                   const float* k) {
+  __m256 m_sums = _mm256_setzero_ps();
+  for (int i = 0; i < kKernelSize; i += 8) {
+    m_sums = _mm256_add_ps(m_sums, _mm256_mul_ps(_mm256_loadu_ps(input_ptr + i),
+                                                 _mm256_loadu_ps(k + i)));
+  }
+
+  // Sum components together.
+  __m128 m_sum = _mm_add_ps(_mm256_castps256_ps128(m_sums),
+                            _mm256_extractf128_ps(m_sums, 1));
+  m_sum = _mm_add_ps(_mm_movehl_ps(m_sum, m_sum), m_sum);
+  return _mm_cvtss_f32(_mm_add_ss(m_sum, _mm_shuffle_ps(m_sum, m_sum, 1)));
+}
 #elif defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
 float SincResampler::Convolve_NEON(const float* input_ptr, const float* k1,
                                    const float* k2,
@@ -394,6 +743,22 @@ float SincResampler::Convolve_NEON(const float* input_ptr, const float* k1,
   float32x2_t m_half = vadd_f32(vget_high_f32(m_sums1), vget_low_f32(m_sums1));
   return vget_lane_f32(vpadd_f32(m_half, m_half), 0);
 }
+
+float SincResampler::ConvolveSingle_NEON(const float* input_ptr,
+                                         const float* k) {
+  float32x4_t m_sums = vmovq_n_f32(0);
+
+  const float* upper = input_ptr + kKernelSize;
+  for (; input_ptr < upper; ) {
+    m_sums = vmlaq_f32(m_sums, vld1q_f32(input_ptr), vld1q_f32(k));
+    input_ptr += 4;
+    k += 4;
+  }
+
+  // Sum components together.
+  float32x2_t m_half = vadd_f32(vget_high_f32(m_sums), vget_low_f32(m_sums));
+  return vget_lane_f32(vpadd_f32(m_half, m_half), 0);
+}
 #endif
 
 }  // namespace media
@@ -11,6 +11,7 @@
 #include "base/gtest_prod_util.h"
 #include "base/macros.h"
 #include "base/memory/aligned_memory.h"
+#include "base/memory/ref_counted.h"
 #include "build/build_config.h"
 #include "media/base/media_export.h"
 
@@ -34,13 +35,30 @@ class MEDIA_EXPORT SincResampler {
     // at the expense of allocating more memory.
     kKernelOffsetCount = 32,
     kKernelStorageSize = kKernelSize * (kKernelOffsetCount + 1),
+
+    // Largest denominator for which a rational |io_sample_rate_ratio| gets a
+    // kernel per output phase instead of interpolated kernels.  Covers most
+    // conversions between the common sample rates; e.g. 44.1kHz to 48kHz is
+    // 147 / 160.
+    kMaxFixedRatioPhases = 1024,
   };
 
+  // An immutable set of windowed sinc() kernels.  Kernels depend only on the
+  // sample rate ratio, so they're built once and shared by every resampler
+  // (and every MultiChannelResampler channel) constructed with the same ratio.
+  // Defined in the .cc file.
+  class Kernel;
+
   // Callback type for providing more data into the resampler.  Expects |frames|
   // of data to be rendered into |destination|; zero padded if not enough frames
   // are available to satisfy the request.
   typedef base::Callback<void(int frames, float* destination)> ReadCB;
 
+  // Selects the fastest Convolve() implementation for the current CPU. Until
+  // this is called the baseline SSE (x86) or NEON (ARM) version is used.
+  // Called by InitializeMediaLibrary(); must not race with Resample().
+  static void InitializeCPUSpecificFeatures();
+
   // Constructs a SincResampler with the specified |read_cb|, which is used to
   // acquire audio data for resampling.  |io_sample_rate_ratio| is the ratio
   // of input / output sample rates.  |request_frames| controls the size in
@@ -71,12 +89,21 @@ class MEDIA_EXPORT SincResampler {
   // previously called it must be called again after the Flush().
   void Flush();
 
-  // Update |io_sample_rate_ratio_|.  SetRatio() will cause a reconstruction of
-  // the kernels used for resampling.  Not thread safe, do not call while
-  // Resample() is in progress.
+  // Update |io_sample_rate_ratio_|.  SetRatio() will recalculate the kernels
+  // in place unless the new ratio can use the ones picked at construction; it
+  // never locks or allocates, so it's safe to call on the real-time audio
+  // thread.  Not thread safe, do not call while Resample() is in progress.
   void SetRatio(double io_sample_rate_ratio);
 
-  float* get_kernel_for_testing() { return kernel_storage_.get(); }
+  // Returns the kKernelStorageSize interpolated kernels for the current ratio.
+  const float* get_kernel_for_testing() const;
+
+  // Whether Resample() is using per-phase kernels for a rational ratio; see
+  // kMaxFixedRatioPhases.  Only the ratio given at construction can use them.
+  // DisableFixedRatioForTesting() forces interpolated kernels until the next
+  // SetRatio().
+  bool IsFixedRatioForTesting() const { return fixed_ratio_enabled_; }
+  void DisableFixedRatioForTesting();
 
   // Return number of input frames consumed by a callback but not yet processed.
   // Since input/output ratio can be fractional, so can this value.
@@ -85,14 +112,31 @@ class MEDIA_EXPORT SincResampler {
 
  private:
   FRIEND_TEST_ALL_PREFIXES(SincResamplerTest, Convolve);
+  FRIEND_TEST_ALL_PREFIXES(SincResamplerTest, ConvolveSingle);
   FRIEND_TEST_ALL_PREFIXES(SincResamplerPerfTest, Convolve);
 
-  void InitializeKernel();
+  // Picks up the shared kernels for |io_sample_rate_ratio_| and decides
+  // whether the fixed ratio path can be used.
+  void InitializeKernels();
   void UpdateRegions(bool second_load);
 
+  // Steps (3) - (5) of the algorithm in the .cc file: wraps the tail of the
+  // input buffer to the start and refills it via |read_cb_|.
+  void LoadNextBlock();
+
+  // Resample() for a ratio of |fixed_ratio_numerator_| /
+  // |fixed_ratio_denominator_|.  Every output frame lands exactly on one of
+  // the |phase_kernels_|, so no kernel interpolation is needed.
+  void ResampleFixedRatio(int frames, float* destination);
+
+  typedef float (*ConvolveProc)(const float* input_ptr,
+                                const float* k1,
+                                const float* k2,
+                                double kernel_interpolation_factor);
+
   // Compute convolution of |k1| and |k2| over |input_ptr|, resultant sums are
   // linearly interpolated using |kernel_interpolation_factor|.  On x86, the
-  // underlying implementation is chosen at run time based on SSE support.  On
+  // underlying implementation is chosen at run time based on AVX support.  On
   // ARM, NEON support is chosen at compile time based on compilation flags.
   static float Convolve_C(const float* input_ptr, const float* k1,
                           const float* k2, double kernel_interpolation_factor);
@@ -100,12 +144,31 @@ class MEDIA_EXPORT SincResampler {
   static float Convolve_SSE(const float* input_ptr, const float* k1,
                             const float* k2,
                             double kernel_interpolation_factor);
+  static float Convolve_AVX(const float* input_ptr, const float* k1,
+                            const float* k2,
+                            double kernel_interpolation_factor);
 #elif defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
   static float Convolve_NEON(const float* input_ptr, const float* k1,
                              const float* k2,
                              double kernel_interpolation_factor);
 #endif
 
+  typedef float (*ConvolveSingleProc)(const float* input_ptr, const float* k);
+
+  // Compute the convolution of a single kernel |k| over |input_ptr|.  Used by
+  // the fixed ratio path; implementations are chosen as for Convolve().
+  static float ConvolveSingle_C(const float* input_ptr, const float* k);
+#if defined(ARCH_CPU_X86_FAMILY)
+  static float ConvolveSingle_SSE(const float* input_ptr, const float* k);
+  static float ConvolveSingle_AVX(const float* input_ptr, const float* k);
+#elif defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
+  static float ConvolveSingle_NEON(const float* input_ptr, const float* k);
+#endif
+
+  // Convolve() implementations selected by InitializeCPUSpecificFeatures().
+  static ConvolveProc convolve_proc_;
+  static ConvolveSingleProc convolve_single_proc_;
+
   // The ratio of input / output sample rates.
   double io_sample_rate_ratio_;
 
@@ -132,12 +195,30 @@ class MEDIA_EXPORT SincResampler {
   // The size (in samples) of the internal buffer used by the resampler.
   const int input_buffer_size_;
 
-  // Contains kKernelOffsetCount kernels back-to-back, each of size kKernelSize.
-  // The kernel offsets are sub-sample shifts of a windowed sinc shifted from
-  // 0.0 to 1.0 sample.
+  // Contains kKernelOffsetCount + 1 kernels back-to-back, each of size
+  // kKernelSize.  The kernel offsets are sub-sample shifts of a windowed sinc
+  // shifted from 0.0 to 1.0 sample.  Shared kernels for the ratio given at
+  // construction.
+  scoped_refptr<const Kernel> kernel_;
+
+  // Private kernels, laid out like |kernel_|, which SetRatio() rebuilds in
+  // place for ratios that can't use |kernel_|.
   std::unique_ptr<float[], base::AlignedFreeDeleter> kernel_storage_;
-  std::unique_ptr<float[], base::AlignedFreeDeleter> kernel_pre_sinc_storage_;
-  std::unique_ptr<float[], base::AlignedFreeDeleter> kernel_window_storage_;
+  double kernel_storage_scale_factor_;
+
+  // Either |kernel_| or |kernel_storage_|, whichever matches
+  // |io_sample_rate_ratio_|.
+  const float* current_kernel_;
+
+  // When the ratio given at construction is |fixed_ratio_numerator_| /
+  // |fixed_ratio_denominator_|, contains |fixed_ratio_denominator_| kernels
+  // shifted by consecutive multiples of 1 / |fixed_ratio_denominator_|.  Null
+  // otherwise.  Resample() uses them while |fixed_ratio_enabled_|, i.e. while
+  // |io_sample_rate_ratio_| is still that ratio.
+  scoped_refptr<const Kernel> phase_kernels_;
+  bool fixed_ratio_enabled_;
+  int fixed_ratio_numerator_;
+  int fixed_ratio_denominator_;
 
   // Data from the source is copied into this buffer for each processing pass.
   std::unique_ptr<float[], base::AlignedFreeDeleter> input_buffer_;
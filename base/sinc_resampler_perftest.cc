@@ -2,8 +2,14 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <string.h>
+
+#include <memory>
+#include <string>
+
 #include "base/bind.h"
 #include "base/bind_helpers.h"
+#include "base/cpu.h"
 #include "base/time/time.h"
 #include "build/build_config.h"
 #include "media/base/sinc_resampler.h"
@@ -66,8 +72,78 @@ TEST(SincResamplerPerfTest, Convolve) {
   RunConvolveBenchmark(
       &resampler, SincResampler::CONVOLVE_FUNC, false, "optimized_unaligned");
 #endif
+
+#if defined(ARCH_CPU_X86_FAMILY)
+  if (base::CPU().has_avx()) {
+    RunConvolveBenchmark(
+        &resampler, SincResampler::Convolve_AVX, true, "avx_aligned");
+    RunConvolveBenchmark(
+        &resampler, SincResampler::Convolve_AVX, false, "avx_unaligned");
+  }
+#endif
 }
 
 #undef CONVOLVE_FUNC
 
+static const int kResampleBenchmarkFrames = 48000 * 60;
+static const int kConstructBenchmarkIterations = 10000;
+
+// Provides silence; the kernels don't care what the input is.
+static void ProvideSilence(int frames, float* destination) {
+  memset(destination, 0, frames * sizeof(*destination));
+}
+
+static void RunResampleBenchmark(SincResampler* resampler,
+                                 const std::string& trace_name) {
+  std::unique_ptr<float[]> destination(
+      new float[SincResampler::kDefaultRequestSize]);
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kResampleBenchmarkFrames;
+       i += SincResampler::kDefaultRequestSize) {
+    resampler->Resample(SincResampler::kDefaultRequestSize, destination.get());
+  }
+  double total_time_milliseconds =
+      (base::TimeTicks::Now() - start).InMillisecondsF();
+  perf_test::PrintResult("sinc_resampler_resample", "", trace_name,
+                         kResampleBenchmarkFrames / total_time_milliseconds,
+                         "frames/ms", true);
+}
+
+// Benchmark the fixed ratio path against interpolated kernels for a common
+// conversion.
+TEST(SincResamplerPerfTest, Resample) {
+  static const double kRatio = 44100.0 / 48000;
+
+  SincResampler fixed_resampler(kRatio, SincResampler::kDefaultRequestSize,
+                                base::Bind(&ProvideSilence));
+  ASSERT_TRUE(fixed_resampler.IsFixedRatioForTesting());
+  RunResampleBenchmark(&fixed_resampler, "fixed_ratio");
+
+  SincResampler interpolated_resampler(kRatio,
+                                       SincResampler::kDefaultRequestSize,
+                                       base::Bind(&ProvideSilence));
+  interpolated_resampler.DisableFixedRatioForTesting();
+  RunResampleBenchmark(&interpolated_resampler, "interpolated");
+}
+
+// Benchmark creating resamplers, e.g. for each channel of a
+// MultiChannelResampler, once the kernels for the ratio are in use elsewhere.
+TEST(SincResamplerPerfTest, Construct) {
+  SincResampler kernel_owner(kSampleRateRatio,
+                             SincResampler::kDefaultRequestSize,
+                             base::Bind(&DoNothing));
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  for (int i = 0; i < kConstructBenchmarkIterations; ++i) {
+    SincResampler resampler(kSampleRateRatio,
+                            SincResampler::kDefaultRequestSize,
+                            base::Bind(&DoNothing));
+  }
+  double total_time_milliseconds =
+      (base::TimeTicks::Now() - start).InMillisecondsF();
+  perf_test::PrintResult(
+      "sinc_resampler_construct", "", "shared_kernels",
+      kConstructBenchmarkIterations / total_time_milliseconds, "runs/ms", true);
+}
+
 } // namespace media
@@ -5,11 +5,13 @@
 // MSVC++ requires this to be set before any other includes to get M_PI.
 #define _USE_MATH_DEFINES
 
+#include <algorithm>
 #include <cmath>
 #include <memory>
 
 #include "base/bind.h"
 #include "base/bind_helpers.h"
+#include "base/cpu.h"
 #include "base/macros.h"
 #include "base/strings/string_number_conversions.h"
 #include "base/time/time.h"
@@ -41,6 +43,24 @@ ACTION(FillBuffer) {
   memset(arg1, 64, arg0 * sizeof(float));
 }
 
+// Provides a 1kHz sine wave at 48kHz * |io_ratio|.
+class SinusoidalSource {
+ public:
+  explicit SinusoidalSource(double io_ratio)
+      : step_(2 * M_PI * 1000 / (48000 * io_ratio)), phase_(0) {}
+
+  void ProvideInput(int frames, float* destination) {
+    for (int i = 0; i < frames; ++i, phase_ += step_)
+      destination[i] = static_cast<float>(sin(phase_));
+  }
+
+ private:
+  const double step_;
+  double phase_;
+
+  DISALLOW_COPY_AND_ASSIGN(SinusoidalSource);
+};
+
 // Test requesting multiples of ChunkSize() frames results in the proper number
 // of callbacks.
 TEST(SincResamplerTest, ChunkedResample) {
@@ -146,7 +166,7 @@ TEST(SincResamplerTest, DISABLED_SetRatioBench) {
 
   base::TimeTicks start = base::TimeTicks::Now();
   for (int i = 1; i < 10000; ++i)
-    resampler.SetRatio(1.0 / i);
+    resampler.SetRatio(1.0 + 1.0 / i);
   double total_time_c_ms = (base::TimeTicks::Now() - start).InMillisecondsF();
   printf("SetRatio() took %.2fms.\n", total_time_c_ms);
 }
@@ -178,25 +198,161 @@ TEST(SincResamplerTest, Convolve) {
 
   // Use a kernel from SincResampler as input and kernel data, this has the
   // benefit of already being properly sized and aligned for Convolve_SSE().
-  double result = resampler.Convolve_C(
-      resampler.kernel_storage_.get(), resampler.kernel_storage_.get(),
-      resampler.kernel_storage_.get(), kKernelInterpolationFactor);
-  double result2 = resampler.CONVOLVE_FUNC(
-      resampler.kernel_storage_.get(), resampler.kernel_storage_.get(),
-      resampler.kernel_storage_.get(), kKernelInterpolationFactor);
+  const float* kernel = resampler.get_kernel_for_testing();
+  double result = resampler.Convolve_C(kernel, kernel, kernel,
+                                       kKernelInterpolationFactor);
+  double result2 = resampler.CONVOLVE_FUNC(kernel, kernel, kernel,
+                                           kKernelInterpolationFactor);
   EXPECT_NEAR(result2, result, kEpsilon);
 
   // Test Convolve() w/ unaligned input pointer.
-  result = resampler.Convolve_C(
-      resampler.kernel_storage_.get() + 1, resampler.kernel_storage_.get(),
-      resampler.kernel_storage_.get(), kKernelInterpolationFactor);
-  result2 = resampler.CONVOLVE_FUNC(
-      resampler.kernel_storage_.get() + 1, resampler.kernel_storage_.get(),
-      resampler.kernel_storage_.get(), kKernelInterpolationFactor);
+  result = resampler.Convolve_C(kernel + 1, kernel, kernel,
+                                kKernelInterpolationFactor);
+  result2 = resampler.CONVOLVE_FUNC(kernel + 1, kernel, kernel,
+                                    kKernelInterpolationFactor);
   EXPECT_NEAR(result2, result, kEpsilon);
+
+#if defined(ARCH_CPU_X86_FAMILY)
+  if (!base::CPU().has_avx())
+    return;
+
+  // Test Convolve_AVX() w/ aligned and unaligned input pointers.
+  result = resampler.Convolve_C(kernel, kernel, kernel,
+                                kKernelInterpolationFactor);
+  result2 = resampler.Convolve_AVX(kernel, kernel, kernel,
+                                   kKernelInterpolationFactor);
+  EXPECT_NEAR(result2, result, kEpsilon);
+
+  result = resampler.Convolve_C(kernel + 1, kernel, kernel,
+                                kKernelInterpolationFactor);
+  result2 = resampler.Convolve_AVX(kernel + 1, kernel, kernel,
+                                   kKernelInterpolationFactor);
+  EXPECT_NEAR(result2, result, kEpsilon);
+#endif
+}
+
+// Ensure the optimized ConvolveSingle() methods match ConvolveSingle_C().
+TEST(SincResamplerTest, ConvolveSingle) {
+  MockSource mock_source;
+  SincResampler resampler(
+      kSampleRateRatio, SincResampler::kDefaultRequestSize,
+      base::Bind(&MockSource::ProvideInput, base::Unretained(&mock_source)));
+  static const double kEpsilon = 0.00000005;
+
+  const float* kernel = resampler.get_kernel_for_testing();
+  for (int offset = 0; offset < 4; ++offset) {
+    const double result = resampler.ConvolveSingle_C(kernel + offset, kernel);
+#if defined(ARCH_CPU_X86_FAMILY)
+    EXPECT_NEAR(resampler.ConvolveSingle_SSE(kernel + offset, kernel), result,
+                kEpsilon);
+    if (base::CPU().has_avx()) {
+      EXPECT_NEAR(resampler.ConvolveSingle_AVX(kernel + offset, kernel),
+                  result, kEpsilon);
+    }
+#else
+    EXPECT_NEAR(resampler.ConvolveSingle_NEON(kernel + offset, kernel), result,
+                kEpsilon);
+#endif
+  }
 }
 #endif
 
+// Verify resamplers with the same sample rate ratio share their kernels, and
+// that every upsampling ratio uses the same interpolated kernels.
+TEST(SincResamplerTest, SharedKernels) {
+  MockSource mock_source;
+  const SincResampler::ReadCB read_cb =
+      base::Bind(&MockSource::ProvideInput, base::Unretained(&mock_source));
+
+  SincResampler resampler(kSampleRateRatio, SincResampler::kDefaultRequestSize,
+                          read_cb);
+  SincResampler same_ratio_resampler(kSampleRateRatio, 128, read_cb);
+  EXPECT_EQ(resampler.get_kernel_for_testing(),
+            same_ratio_resampler.get_kernel_for_testing());
+
+  SincResampler upsampler(44100.0 / 48000, SincResampler::kDefaultRequestSize,
+                          read_cb);
+  SincResampler other_upsampler(8000.0 / 44100,
+                                SincResampler::kDefaultRequestSize, read_cb);
+  EXPECT_EQ(upsampler.get_kernel_for_testing(),
+            other_upsampler.get_kernel_for_testing());
+  EXPECT_NE(resampler.get_kernel_for_testing(),
+            upsampler.get_kernel_for_testing());
+
+  // SetRatio() never touches the cache: it rebuilds private kernels, which
+  // match the shared ones for that ratio, and switches back to the shared
+  // kernels for ratios they cover.
+  const float* const shared_kernel = resampler.get_kernel_for_testing();
+  resampler.SetRatio(44100.0 / 48000);
+  EXPECT_NE(upsampler.get_kernel_for_testing(),
+            resampler.get_kernel_for_testing());
+  EXPECT_EQ(0, memcmp(upsampler.get_kernel_for_testing(),
+                      resampler.get_kernel_for_testing(),
+                      sizeof(float) * SincResampler::kKernelStorageSize));
+  resampler.SetRatio(kSampleRateRatio);
+  EXPECT_EQ(shared_kernel, resampler.get_kernel_for_testing());
+  upsampler.SetRatio(32000.0 / 48000);
+  EXPECT_EQ(other_upsampler.get_kernel_for_testing(),
+            upsampler.get_kernel_for_testing());
+}
+
+// Verify the fixed ratio path is only used for suitable ratios and produces
+// the same output as interpolating kernels, minus the interpolation error.
+TEST(SincResamplerTest, FixedRatio) {
+  static const double kRatio = 44100.0 / 48000;
+  static const int kFrames = 4096;
+
+  // Two identical sources, one for each resampler.
+  SinusoidalSource fixed_source(kRatio);
+  SinusoidalSource interpolated_source(kRatio);
+  SincResampler fixed_resampler(
+      kRatio, SincResampler::kDefaultRequestSize,
+      base::Bind(&SinusoidalSource::ProvideInput,
+                 base::Unretained(&fixed_source)));
+  SincResampler interpolated_resampler(
+      kRatio, SincResampler::kDefaultRequestSize,
+      base::Bind(&SinusoidalSource::ProvideInput,
+                 base::Unretained(&interpolated_source)));
+  ASSERT_TRUE(fixed_resampler.IsFixedRatioForTesting());
+  interpolated_resampler.DisableFixedRatioForTesting();
+  ASSERT_FALSE(interpolated_resampler.IsFixedRatioForTesting());
+
+  // Use odd sized requests so output frames straddle the block boundaries.
+  std::unique_ptr<float[]> fixed_output(new float[kFrames]);
+  std::unique_ptr<float[]> interpolated_output(new float[kFrames]);
+  for (int i = 0; i < kFrames;) {
+    const int frames = std::min(kFrames - i, 333);
+    fixed_resampler.Resample(frames, fixed_output.get() + i);
+    interpolated_resampler.Resample(frames, interpolated_output.get() + i);
+    EXPECT_NEAR(interpolated_resampler.BufferedFrames(),
+                fixed_resampler.BufferedFrames(), 0.000001);
+    i += frames;
+  }
+
+  static const float kEpsilon = 0.001f;
+  for (int i = 0; i < kFrames; ++i)
+    ASSERT_NEAR(interpolated_output[i], fixed_output[i], kEpsilon) << i;
+
+  // Irrational and overly fine ratios need interpolated kernels, as does any
+  // ratio other than the one given at construction once SetRatio() is used.
+  fixed_resampler.SetRatio(M_PI);
+  EXPECT_FALSE(fixed_resampler.IsFixedRatioForTesting());
+  fixed_resampler.SetRatio(2.0);
+  EXPECT_FALSE(fixed_resampler.IsFixedRatioForTesting());
+  fixed_resampler.SetRatio(kRatio);
+  EXPECT_TRUE(fixed_resampler.IsFixedRatioForTesting());
+
+  SincResampler fine_resampler(11025.0 / 96000,
+                               SincResampler::kDefaultRequestSize,
+                               base::Bind(&SinusoidalSource::ProvideInput,
+                                          base::Unretained(&fixed_source)));
+  EXPECT_FALSE(fine_resampler.IsFixedRatioForTesting());
+  SincResampler integer_resampler(2.0, SincResampler::kDefaultRequestSize,
+                                  base::Bind(&SinusoidalSource::ProvideInput,
+                                             base::Unretained(&fixed_source)));
+  EXPECT_TRUE(integer_resampler.IsFixedRatioForTesting());
+}
+
 // Fake audio source for testing the resampler.  Generates a sinusoidal linear
 // chirp (http://en.wikipedia.org/wiki/Chirp) which can be tuned to stress the
 // resampler for the specific sample rate conversion being used.
@@ -41,6 +41,16 @@ scoped_refptr<StreamParserBuffer> StreamParserBuffer::CopyFrom(
                              is_key_frame, type, track_id));
 }
 
+scoped_refptr<StreamParserBuffer> StreamParserBuffer::Create(
+    int data_size,
+    bool is_key_frame,
+    Type type,
+    TrackId track_id) {
+  DCHECK_GT(data_size, 0);
+  return make_scoped_refptr(
+      new StreamParserBuffer(data_size, is_key_frame, type, track_id));
+}
+
 DecodeTimestamp StreamParserBuffer::GetDecodeTimestamp() const {
   if (decode_timestamp_ == kNoDecodeTimestamp())
     return DecodeTimestamp::FromPresentationTime(timestamp());
@@ -77,6 +87,21 @@ StreamParserBuffer::StreamParserBuffer(const uint8_t* data,
     set_is_key_frame(true);
 }
 
+StreamParserBuffer::StreamParserBuffer(int data_size,
+                                       bool is_key_frame,
+                                       Type type,
+                                       TrackId track_id)
+    : DecoderBuffer(data_size),
+      decode_timestamp_(kNoDecodeTimestamp()),
+      config_id_(kInvalidConfigId),
+      type_(type),
+      track_id_(track_id),
+      is_duration_estimated_(false) {
+  set_duration(kNoTimestamp);
+  if (is_key_frame)
+    set_is_key_frame(true);
+}
+
 StreamParserBuffer::~StreamParserBuffer() {}
 
 int StreamParserBuffer::GetConfigId() const {
@@ -125,6 +125,14 @@ class MEDIA_EXPORT StreamParserBuffer : public DecoderBuffer {
                                                     Type type,
                                                     TrackId track_id);
 
+  // Allocates a buffer of |data_size| > 0 bytes, for the caller to fill
+  // through writable_data(). Lets parsers which transform the data write it
+  // straight into the buffer rather than into a temporary to copy from.
+  static scoped_refptr<StreamParserBuffer> Create(int data_size,
+                                                  bool is_key_frame,
+                                                  Type type,
+                                                  TrackId track_id);
+
   // Decode timestamp. If not explicitly set, or set to kNoTimestamp, the
   // value will be taken from the normal timestamp.
   DecodeTimestamp GetDecodeTimestamp() const;
@@ -174,6 +182,10 @@ class MEDIA_EXPORT StreamParserBuffer : public DecoderBuffer {
                      bool is_key_frame,
                      Type type,
                      TrackId track_id);
+  StreamParserBuffer(int data_size,
+                     bool is_key_frame,
+                     Type type,
+                     TrackId track_id);
   ~StreamParserBuffer() override;
 
   DecodeTimestamp decode_timestamp_;
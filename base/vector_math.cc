@@ -12,7 +12,18 @@
 
 // NaCl does not allow intrinsics.
 #if defined(ARCH_CPU_X86_FAMILY) && !defined(OS_NACL)
+#include <immintrin.h>
 #include <xmmintrin.h>
+
+#include "base/cpu.h"
+
+// GCC and clang only emit AVX instructions inside functions that explicitly
+// target AVX; MSVC accepts the intrinsics anywhere.
+#if defined(COMPILER_MSVC)
+#define TARGET_AVX
+#else
+#define TARGET_AVX __attribute__((target("avx")))
+#endif
 // Don't use custom SSE versions where the auto-vectorized C version performs
 // better, which is anywhere clang is used.
 #if !defined(__clang__)
@@ -22,26 +33,64 @@
 #define FMAC_FUNC FMAC_C
 #define FMUL_FUNC FMUL_C
 #endif
+#define FMACBatch_FUNC FMACBatch_SSE
 #define EWMAAndMaxPower_FUNC EWMAAndMaxPower_SSE
 #elif defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
 #include <arm_neon.h>
 #define FMAC_FUNC FMAC_NEON
 #define FMUL_FUNC FMUL_NEON
+#define FMACBatch_FUNC FMACBatch_NEON
 #define EWMAAndMaxPower_FUNC EWMAAndMaxPower_NEON
 #else
 #define FMAC_FUNC FMAC_C
 #define FMUL_FUNC FMUL_C
+#define FMACBatch_FUNC FMACBatch_C
 #define EWMAAndMaxPower_FUNC EWMAAndMaxPower_C
 #endif
 
 namespace media {
 namespace vector_math {
 
+typedef void (*VectorScaleProc)(const float src[],
+                                float scale,
+                                int len,
+                                float dest[]);
+typedef void (*FMACBatchProc)(const float* const src[],
+                              const float scale[],
+                              int count,
+                              int len,
+                              float dest[]);
+typedef void (*CrossfadeProc)(const float src[], int len, float dest[]);
+typedef std::pair<float, float> (*EWMAAndMaxPowerProc)(float initial_value,
+                                                        const float src[],
+                                                        int len,
+                                                        float smoothing_factor);
+
+// Implementations selected by InitializeCPUSpecificFeatures().
+static VectorScaleProc g_fmac_proc_ = FMAC_FUNC;
+static VectorScaleProc g_fmul_proc_ = FMUL_FUNC;
+static FMACBatchProc g_fmac_batch_proc_ = FMACBatch_FUNC;
+static CrossfadeProc g_crossfade_proc_ = Crossfade_C;
+static EWMAAndMaxPowerProc g_ewma_and_max_power_proc_ = EWMAAndMaxPower_FUNC;
+
+void InitializeCPUSpecificFeatures() {
+#if defined(ARCH_CPU_X86_FAMILY) && !defined(OS_NACL)
+  base::CPU cpu;
+  if (cpu.has_avx()) {
+    g_fmac_proc_ = FMAC_AVX;
+    g_fmac_batch_proc_ = FMACBatch_AVX;
+    g_fmul_proc_ = FMUL_AVX;
+    g_crossfade_proc_ = Crossfade_AVX;
+    g_ewma_and_max_power_proc_ = EWMAAndMaxPower_AVX;
+  }
+#endif
+}
+
 void FMAC(const float src[], float scale, int len, float dest[]) {
   // Ensure |src| and |dest| are 16-byte aligned.
   DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(src) & (kRequiredAlignment - 1));
   DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(dest) & (kRequiredAlignment - 1));
-  return FMAC_FUNC(src, scale, len, dest);
+  return g_fmac_proc_(src, scale, len, dest);
 }
 
 void FMAC_C(const float src[], float scale, int len, float dest[]) {
@@ -49,11 +98,38 @@ void FMAC_C(const float src[], float scale, int len, float dest[]) {
     dest[i] += src[i] * scale;
 }
 
+void FMACBatch(const float* const src[],
+               const float scale[],
+               int count,
+               int len,
+               float dest[]) {
+  // Ensure each |src| and |dest| are 16-byte aligned.
+  DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(dest) & (kRequiredAlignment - 1));
+  for (int k = 0; k < count; ++k) {
+    DCHECK_EQ(0u,
+              reinterpret_cast<uintptr_t>(src[k]) & (kRequiredAlignment - 1));
+  }
+  return g_fmac_batch_proc_(src, scale, count, len, dest);
+}
+
+void FMACBatch_C(const float* const src[],
+                 const float scale[],
+                 int count,
+                 int len,
+                 float dest[]) {
+  for (int i = 0; i < len; ++i) {
+    float sum = dest[i];
+    for (int k = 0; k < count; ++k)
+      sum += src[k][i] * scale[k];
+    dest[i] = sum;
+  }
+}
+
 void FMUL(const float src[], float scale, int len, float dest[]) {
   // Ensure |src| and |dest| are 16-byte aligned.
   DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(src) & (kRequiredAlignment - 1));
   DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(dest) & (kRequiredAlignment - 1));
-  return FMUL_FUNC(src, scale, len, dest);
+  return g_fmul_proc_(src, scale, len, dest);
 }
 
 void FMUL_C(const float src[], float scale, int len, float dest[]) {
@@ -62,6 +138,10 @@ void FMUL_C(const float src[], float scale, int len, float dest[]) {
 }
 
 void Crossfade(const float src[], int len, float dest[]) {
+  return g_crossfade_proc_(src, len, dest);
+}
+
+void Crossfade_C(const float src[], int len, float dest[]) {
   float cf_ratio = 0;
   const float cf_increment = 1.0f / len;
   for (int i = 0; i < len; ++i, cf_ratio += cf_increment)
@@ -72,7 +152,7 @@ std::pair<float, float> EWMAAndMaxPower(
     float initial_value, const float src[], int len, float smoothing_factor) {
   // Ensure |src| is 16-byte aligned.
   DCHECK_EQ(0u, reinterpret_cast<uintptr_t>(src) & (kRequiredAlignment - 1));
-  return EWMAAndMaxPower_FUNC(initial_value, src, len, smoothing_factor);
+  return g_ewma_and_max_power_proc_(initial_value, src, len, smoothing_factor);
 }
 
 std::pair<float, float> EWMAAndMaxPower_C(
@@ -116,6 +196,52 @@ void FMAC_SSE(const float src[], float scale, int len, float dest[]) {
     dest[i] += src[i] * scale;
 }
 
+void FMACBatch_SSE(const float* const src[],
+                   const float scale[],
+                   int count,
+                   int len,
+                   float dest[]) {
+  // Each source term added to a destination vector depends on the previous
+  // one, so keep four independent vectors in flight to hide the add latency.
+  const int unrolled_last_index = len - len % 16;
+  const int last_index = len - len % 4;
+  int i = 0;
+  for (; i < unrolled_last_index; i += 16) {
+    __m128 m_sum0 = _mm_load_ps(dest + i);
+    __m128 m_sum1 = _mm_load_ps(dest + i + 4);
+    __m128 m_sum2 = _mm_load_ps(dest + i + 8);
+    __m128 m_sum3 = _mm_load_ps(dest + i + 12);
+    for (int k = 0; k < count; ++k) {
+      const float* const s = src[k] + i;
+      const __m128 m_scale = _mm_set_ps1(scale[k]);
+      m_sum0 = _mm_add_ps(m_sum0, _mm_mul_ps(_mm_load_ps(s), m_scale));
+      m_sum1 = _mm_add_ps(m_sum1, _mm_mul_ps(_mm_load_ps(s + 4), m_scale));
+      m_sum2 = _mm_add_ps(m_sum2, _mm_mul_ps(_mm_load_ps(s + 8), m_scale));
+      m_sum3 = _mm_add_ps(m_sum3, _mm_mul_ps(_mm_load_ps(s + 12), m_scale));
+    }
+    _mm_store_ps(dest + i, m_sum0);
+    _mm_store_ps(dest + i + 4, m_sum1);
+    _mm_store_ps(dest + i + 8, m_sum2);
+    _mm_store_ps(dest + i + 12, m_sum3);
+  }
+  for (; i < last_index; i += 4) {
+    __m128 m_sum = _mm_load_ps(dest + i);
+    for (int k = 0; k < count; ++k) {
+      m_sum = _mm_add_ps(m_sum, _mm_mul_ps(_mm_load_ps(src[k] + i),
+                                           _mm_set_ps1(scale[k])));
+    }
+    _mm_store_ps(dest + i, m_sum);
+  }
+
+  // Handle any remaining values that wouldn't fit in an SSE pass.
+  for (; i < len; ++i) {
+    float sum = dest[i];
+    for (int k = 0; k < count; ++k)
+      sum += src[k][i] * scale[k];
+    dest[i] = sum;
+  }
+}
+
 // Convenience macro to extract float 0 through 3 from the vector |a|.  This is
 // needed because compilers other than clang don't support access via
 // operator[]().
@@ -192,6 +318,175 @@ std::pair<float, float> EWMAAndMaxPower_SSE(
 
   return result;
 }
+
+TARGET_AVX void FMUL_AVX(const float src[], float scale, int len,
+                         float dest[]) {
+  const int rem = len % 8;
+  const int last_index = len - rem;
+  __m256 m_scale = _mm256_set1_ps(scale);
+  for (int i = 0; i < last_index; i += 8) {
+    _mm256_storeu_ps(dest + i,
+                     _mm256_mul_ps(_mm256_loadu_ps(src + i), m_scale));
+  }
+
+  // Handle any remaining values that wouldn't fit in an AVX pass.
+  for (int i = last_index; i < len; ++i)
+    dest[i] = src[i] * scale;
+}
+
+TARGET_AVX void FMAC_AVX(const float src[], float scale, int len,
+                         float dest[]) {
+  const int rem = len % 8;
+  const int last_index = len - rem;
+  __m256 m_scale = _mm256_set1_ps(scale);
+  for (int i = 0; i < last_index; i += 8) {
+    _mm256_storeu_ps(
+        dest + i, _mm256_add_ps(_mm256_loadu_ps(dest + i),
+                                _mm256_mul_ps(_mm256_loadu_ps(src + i),
+                                              m_scale)));
+  }
+
+  // Handle any remaining values that wouldn't fit in an AVX pass.
+  for (int i = last_index; i < len; ++i)
+    dest[i] += src[i] * scale;
+}
+
+TARGET_AVX void FMACBatch_AVX(const float* const src[],
+                              const float scale[],
+                              int count,
+                              int len,
+                              float dest[]) {
+  // Same strategy as FMACBatch_SSE(), with four 8-wide vectors in flight.
+  const int unrolled_last_index = len - len % 32;
+  const int last_index = len - len % 8;
+  int i = 0;
+  for (; i < unrolled_last_index; i += 32) {
+    __m256 m_sum0 = _mm256_loadu_ps(dest + i);
+    __m256 m_sum1 = _mm256_loadu_ps(dest + i + 8);
+    __m256 m_sum2 = _mm256_loadu_ps(dest + i + 16);
+    __m256 m_sum3 = _mm256_loadu_ps(dest + i + 24);
+    for (int k = 0; k < count; ++k) {
+      const float* const s = src[k] + i;
+      const __m256 m_scale = _mm256_set1_ps(scale[k]);
+      m_sum0 = _mm256_add_ps(m_sum0,
+                             _mm256_mul_ps(_mm256_loadu_ps(s), m_scale));
+      m_sum1 = _mm256_add_ps(m_sum1,
+                             _mm256_mul_ps(_mm256_loadu_ps(s + 8), m_scale));
+      m_sum2 = _mm256_add_ps(m_sum2,
+                             _mm256_mul_ps(_mm256_loadu_ps(s + 16), m_scale));
+      m_sum3 = _mm256_add_ps(m_sum3,
+                             _mm256_mul_ps(_mm256_loadu_ps(s + 24), m_scale));
+    }
+    _mm256_storeu_ps(dest + i, m_sum0);
+    _mm256_storeu_ps(dest + i + 8, m_sum1);
+    _mm256_storeu_ps(dest + i + 16, m_sum2);
+    _mm256_storeu_ps(dest + i + 24, m_sum3);
+  }
+  for (; i < last_index; i += 8) {
+    __m256 m_sum = _mm256_loadu_ps(dest + i);
+    for (int k = 0; k < count; ++k) {
+      m_sum = _mm256_add_ps(
+          m_sum, _mm256_mul_ps(_mm256_loadu_ps(src[k] + i),
+                               _mm256_set1_ps(scale[k])));
+    }
+    _mm256_storeu_ps(dest + i, m_sum);
+  }
+
+  // Handle any remaining values that wouldn't fit in an AVX pass.
+  for (; i < len; ++i) {
+    float sum = dest[i];
+    for (int k = 0; k < count; ++k)
+      sum += src[k][i] * scale[k];
+    dest[i] = sum;
+  }
+}
+
+TARGET_AVX void Crossfade_AVX(const float src[], int len, float dest[]) {
+  const int rem = len % 8;
+  const int last_index = len - rem;
+  const float cf_increment = 1.0f / len;
+  const __m256 m_increment = _mm256_set1_ps(cf_increment);
+  const __m256 m_one = _mm256_set1_ps(1.0f);
+  const __m256 m_eight = _mm256_set1_ps(8.0f);
+  // Sample indices are exact in float up to 2^24, so each ratio is computed
+  // directly rather than accumulated.
+  __m256 m_index = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+  for (int i = 0; i < last_index; i += 8) {
+    const __m256 m_ratio = _mm256_mul_ps(m_index, m_increment);
+    _mm256_storeu_ps(
+        dest + i,
+        _mm256_add_ps(
+            _mm256_mul_ps(_mm256_sub_ps(m_one, m_ratio),
+                          _mm256_loadu_ps(src + i)),
+            _mm256_mul_ps(m_ratio, _mm256_loadu_ps(dest + i))));
+    m_index = _mm256_add_ps(m_index, m_eight);
+  }
+
+  // Handle any remaining values that wouldn't fit in an AVX pass.
+  for (int i = last_index; i < len; ++i) {
+    const float cf_ratio = i * cf_increment;
+    dest[i] = (1.0f - cf_ratio) * src[i] + cf_ratio * dest[i];
+  }
+}
+
+TARGET_AVX std::pair<float, float> EWMAAndMaxPower_AVX(
+    float initial_value, const float src[], int len, float smoothing_factor) {
+  // Same strategy as EWMAAndMaxPower_SSE(), but with 8 lanes of evaluation:
+  // lane 7 computes z[n], lane 6 computes z[n-1], ... and lane 0 computes
+  // z[n-7], where z[n] = a(S[n]^2) + (1-a)^8(z[n-8]) + ...
+  const int rem = len % 8;
+  const int last_index = len - rem;
+
+  const __m256 smoothing_factor_x8 = _mm256_set1_ps(smoothing_factor);
+  const float weight_prev = 1.0f - smoothing_factor;
+  const float weight_prev_squared = weight_prev * weight_prev;
+  const float weight_prev_4th = weight_prev_squared * weight_prev_squared;
+  const __m256 weight_prev_8th_x8 =
+      _mm256_set1_ps(weight_prev_4th * weight_prev_4th);
+
+  __m256 max_x8 = _mm256_setzero_ps();
+  __m256 ewma_x8 = _mm256_setr_ps(0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f, 0.0f,
+                                  initial_value);
+  int i;
+  for (i = 0; i < last_index; i += 8) {
+    ewma_x8 = _mm256_mul_ps(ewma_x8, weight_prev_8th_x8);
+    const __m256 sample_x8 = _mm256_loadu_ps(src + i);
+    const __m256 sample_squared_x8 = _mm256_mul_ps(sample_x8, sample_x8);
+    max_x8 = _mm256_max_ps(max_x8, sample_squared_x8);
+    ewma_x8 = _mm256_add_ps(
+        ewma_x8, _mm256_mul_ps(sample_squared_x8, smoothing_factor_x8));
+  }
+
+  // y[n] = z[n] + (1-a)^1(z[n-1]) + ... + (1-a)^7(z[n-7])
+  float lanes[8];
+  _mm256_storeu_ps(lanes, ewma_x8);
+  float ewma = lanes[7];
+  float weight = 1.0f;
+  for (int lane = 6; lane >= 0; --lane) {
+    weight *= weight_prev;
+    ewma += lanes[lane] * weight;
+  }
+
+  // Fold the maximums together to get the overall maximum.
+  __m128 max_x4 = _mm_max_ps(_mm256_castps256_ps128(max_x8),
+                             _mm256_extractf128_ps(max_x8, 1));
+  max_x4 = _mm_max_ps(max_x4,
+                      _mm_shuffle_ps(max_x4, max_x4, _MM_SHUFFLE(3, 3, 1, 1)));
+  max_x4 = _mm_max_ss(max_x4, _mm_shuffle_ps(max_x4, max_x4, 2));
+
+  std::pair<float, float> result(ewma, _mm_cvtss_f32(max_x4));
+
+  // Handle remaining values at the end of |src|.
+  for (; i < len; ++i) {
+    result.first *= weight_prev;
+    const float sample = src[i];
+    const float sample_squared = sample * sample;
+    result.first += sample_squared * smoothing_factor;
+    result.second = std::max(result.second, sample_squared);
+  }
+
+  return result;
+}
 #endif
 
 #if defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
@@ -209,6 +504,48 @@ void FMAC_NEON(const float src[], float scale, int len, float dest[]) {
     dest[i] += src[i] * scale;
 }
 
+void FMACBatch_NEON(const float* const src[],
+                    const float scale[],
+                    int count,
+                    int len,
+                    float dest[]) {
+  // Same strategy as FMACBatch_SSE().
+  const int unrolled_last_index = len - len % 16;
+  const int last_index = len - len % 4;
+  int i = 0;
+  for (; i < unrolled_last_index; i += 16) {
+    float32x4_t m_sum0 = vld1q_f32(dest + i);
+    float32x4_t m_sum1 = vld1q_f32(dest + i + 4);
+    float32x4_t m_sum2 = vld1q_f32(dest + i + 8);
+    float32x4_t m_sum3 = vld1q_f32(dest + i + 12);
+    for (int k = 0; k < count; ++k) {
+      const float* const s = src[k] + i;
+      m_sum0 = vmlaq_n_f32(m_sum0, vld1q_f32(s), scale[k]);
+      m_sum1 = vmlaq_n_f32(m_sum1, vld1q_f32(s + 4), scale[k]);
+      m_sum2 = vmlaq_n_f32(m_sum2, vld1q_f32(s + 8), scale[k]);
+      m_sum3 = vmlaq_n_f32(m_sum3, vld1q_f32(s + 12), scale[k]);
+    }
+    vst1q_f32(dest + i, m_sum0);
+    vst1q_f32(dest + i + 4, m_sum1);
+    vst1q_f32(dest + i + 8, m_sum2);
+    vst1q_f32(dest + i + 12, m_sum3);
+  }
+  for (; i < last_index; i += 4) {
+    float32x4_t m_sum = vld1q_f32(dest + i);
+    for (int k = 0; k < count; ++k)
+      m_sum = vmlaq_n_f32(m_sum, vld1q_f32(src[k] + i), scale[k]);
+    vst1q_f32(dest + i, m_sum);
+  }
+
+  // Handle any remaining values that wouldn't fit in an NEON pass.
+  for (; i < len; ++i) {
+    float sum = dest[i];
+    for (int k = 0; k < count; ++k)
+      sum += src[k][i] * scale[k];
+    dest[i] = sum;
+  }
+}
+
 void FMUL_NEON(const float src[], float scale, int len, float dest[]) {
   const int rem = len % 4;
   const int last_index = len - rem;
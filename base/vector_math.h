@@ -12,13 +12,32 @@
 namespace media {
 namespace vector_math {
 
-// Required alignment for inputs and outputs to all vector math functions
+// Required alignment for inputs and outputs to all vector math functions.
+// The AVX implementations use unaligned loads and stores, so this remains
+// 16 even where 32-byte vectors are in use.
 enum { kRequiredAlignment = 16 };
 
+// Selects the fastest implementation of each function for the current CPU.
+// Until this is called the baseline SSE (x86) or NEON (ARM) versions are
+// used. Called by InitializeMediaLibrary(); must not race with other calls
+// into vector_math.
+MEDIA_EXPORT void InitializeCPUSpecificFeatures();
+
 // Multiply each element of |src| (up to |len|) by |scale| and add to |dest|.
 // |src| and |dest| must be aligned by kRequiredAlignment.
 MEDIA_EXPORT void FMAC(const float src[], float scale, int len, float dest[]);
 
+// Equivalent to calling FMAC(src[k], scale[k], len, dest) for each k in
+// [0, count), but loads and stores each element of |dest| only once,
+// accumulating all |count| sources in registers in between.  Per element the
+// operations happen in the same order as in the sequential FMAC() calls.  Each
+// |src[k]| and |dest| must be aligned by kRequiredAlignment.
+MEDIA_EXPORT void FMACBatch(const float* const src[],
+                            const float scale[],
+                            int count,
+                            int len,
+                            float dest[]);
+
 // Multiply each element of |src| by |scale| and store in |dest|.  |src| and
 // |dest| must be aligned by kRequiredAlignment.
 MEDIA_EXPORT void FMUL(const float src[], float scale, int len, float dest[]);
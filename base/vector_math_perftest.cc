@@ -4,6 +4,7 @@
 
 #include <memory>
 
+#include "base/cpu.h"
 #include "base/macros.h"
 #include "base/memory/aligned_memory.h"
 #include "base/time/time.h"
@@ -83,7 +84,7 @@ class VectorMathPerfTest : public testing::Test {
 };
 
 // Define platform dependent function names for SIMD optimized methods.
-#if defined(ARCH_CPU_X86_FAMILY)
+#if defined(ARCH_CPU_X86_FAMILY) && !defined(OS_NACL)
 #define FMAC_FUNC FMAC_SSE
 #define FMUL_FUNC FMUL_SSE
 #define EWMAAndMaxPower_FUNC EWMAAndMaxPower_SSE
@@ -110,6 +111,50 @@ TEST_F(VectorMathPerfTest, FMAC) {
   RunBenchmark(
       vector_math::FMAC_FUNC, true, "vector_math_fmac", "optimized_aligned");
 #endif
+#if defined(ARCH_CPU_X86_FAMILY) && !defined(OS_NACL)
+  if (base::CPU().has_avx()) {
+    RunBenchmark(
+        vector_math::FMAC_AVX, false, "vector_math_fmac", "avx_unaligned");
+    RunBenchmark(
+        vector_math::FMAC_AVX, true, "vector_math_fmac", "avx_aligned");
+  }
+#endif
+}
+
+// Benchmark mixing eight sources with vector_math::FMACBatch() against eight
+// sequential vector_math::FMAC() calls.
+TEST_F(VectorMathPerfTest, FMACBatch) {
+  static const int kSources = 8;
+  static const int kBatchIterations = kBenchmarkIterations / kSources;
+  const float* sources[kSources];
+  float scales[kSources];
+  for (int k = 0; k < kSources; ++k) {
+    sources[k] = input_vector_.get();
+    scales[k] = kScale / (k + 1);
+  }
+
+  TimeTicks start = TimeTicks::Now();
+  for (int i = 0; i < kBatchIterations; ++i) {
+    for (int k = 0; k < kSources; ++k) {
+      vector_math::FMAC(sources[k], scales[k], kVectorSize,
+                        output_vector_.get());
+    }
+  }
+  double total_time_milliseconds =
+      (TimeTicks::Now() - start).InMillisecondsF();
+  perf_test::PrintResult("vector_math_fmac_batch", "", "sequential_fmac",
+                         kBatchIterations / total_time_milliseconds, "runs/ms",
+                         true);
+
+  start = TimeTicks::Now();
+  for (int i = 0; i < kBatchIterations; ++i) {
+    vector_math::FMACBatch(sources, scales, kSources, kVectorSize,
+                           output_vector_.get());
+  }
+  total_time_milliseconds = (TimeTicks::Now() - start).InMillisecondsF();
+  perf_test::PrintResult("vector_math_fmac_batch", "", "batch",
+                         kBatchIterations / total_time_milliseconds, "runs/ms",
+                         true);
 }
 
 // Benchmark for each optimized vector_math::FMUL() method.
@@ -129,6 +174,14 @@ TEST_F(VectorMathPerfTest, FMUL) {
   RunBenchmark(
       vector_math::FMUL_FUNC, true, "vector_math_fmul", "optimized_aligned");
 #endif
+#if defined(ARCH_CPU_X86_FAMILY) && !defined(OS_NACL)
+  if (base::CPU().has_avx()) {
+    RunBenchmark(
+        vector_math::FMUL_AVX, false, "vector_math_fmul", "avx_unaligned");
+    RunBenchmark(
+        vector_math::FMUL_AVX, true, "vector_math_fmul", "avx_aligned");
+  }
+#endif
 }
 
 // Benchmark for each optimized vector_math::EWMAAndMaxPower() method.
@@ -154,6 +207,18 @@ TEST_F(VectorMathPerfTest, EWMAAndMaxPower) {
                "vector_math_ewma_and_max_power",
                "optimized_aligned");
 #endif
+#if defined(ARCH_CPU_X86_FAMILY) && !defined(OS_NACL)
+  if (base::CPU().has_avx()) {
+    RunBenchmark(vector_math::EWMAAndMaxPower_AVX,
+                 kVectorSize - 1,
+                 "vector_math_ewma_and_max_power",
+                 "avx_unaligned");
+    RunBenchmark(vector_math::EWMAAndMaxPower_AVX,
+                 kVectorSize,
+                 "vector_math_ewma_and_max_power",
+                 "avx_aligned");
+  }
+#endif
 }
 
 } // namespace media
@@ -16,6 +16,12 @@ namespace vector_math {
 // Optimized versions exposed for testing.  See vector_math.h for details.
 MEDIA_EXPORT void FMAC_C(const float src[], float scale, int len, float dest[]);
 MEDIA_EXPORT void FMUL_C(const float src[], float scale, int len, float dest[]);
+MEDIA_EXPORT void FMACBatch_C(const float* const src[],
+                              const float scale[],
+                              int count,
+                              int len,
+                              float dest[]);
+MEDIA_EXPORT void Crossfade_C(const float src[], int len, float dest[]);
 MEDIA_EXPORT std::pair<float, float> EWMAAndMaxPower_C(
     float initial_value, const float src[], int len, float smoothing_factor);
 
@@ -24,8 +30,27 @@ MEDIA_EXPORT void FMAC_SSE(const float src[], float scale, int len,
                            float dest[]);
 MEDIA_EXPORT void FMUL_SSE(const float src[], float scale, int len,
                            float dest[]);
+MEDIA_EXPORT void FMACBatch_SSE(const float* const src[],
+                                const float scale[],
+                                int count,
+                                int len,
+                                float dest[]);
 MEDIA_EXPORT std::pair<float, float> EWMAAndMaxPower_SSE(
     float initial_value, const float src[], int len, float smoothing_factor);
+
+// Callers must check base::CPU::has_avx() before using these.
+MEDIA_EXPORT void FMAC_AVX(const float src[], float scale, int len,
+                           float dest[]);
+MEDIA_EXPORT void FMUL_AVX(const float src[], float scale, int len,
+                           float dest[]);
+MEDIA_EXPORT void FMACBatch_AVX(const float* const src[],
+                                const float scale[],
+                                int count,
+                                int len,
+                                float dest[]);
+MEDIA_EXPORT void Crossfade_AVX(const float src[], int len, float dest[]);
+MEDIA_EXPORT std::pair<float, float> EWMAAndMaxPower_AVX(
+    float initial_value, const float src[], int len, float smoothing_factor);
 #endif
 
 #if defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
@@ -33,6 +58,11 @@ MEDIA_EXPORT void FMAC_NEON(const float src[], float scale, int len,
                             float dest[]);
 MEDIA_EXPORT void FMUL_NEON(const float src[], float scale, int len,
                             float dest[]);
+MEDIA_EXPORT void FMACBatch_NEON(const float* const src[],
+                                 const float scale[],
+                                 int count,
+                                 int len,
+                                 float dest[]);
 MEDIA_EXPORT std::pair<float, float> EWMAAndMaxPower_NEON(
     float initial_value, const float src[], int len, float smoothing_factor);
 #endif
@@ -8,6 +8,7 @@
 
 #include <memory>
 
+#include "base/cpu.h"
 #include "base/macros.h"
 #include "base/memory/aligned_memory.h"
 #include "base/strings/string_number_conversions.h"
@@ -76,7 +77,7 @@ TEST_F(VectorMathTest, FMAC) {
     VerifyOutput(kResult);
   }
 
-#if defined(ARCH_CPU_X86_FAMILY)
+#if defined(ARCH_CPU_X86_FAMILY) && !defined(OS_NACL)
   {
     SCOPED_TRACE("FMAC_SSE");
     FillTestVectors(kInputFillValue, kOutputFillValue);
@@ -84,6 +85,14 @@ TEST_F(VectorMathTest, FMAC) {
         input_vector_.get(), kScale, kVectorSize, output_vector_.get());
     VerifyOutput(kResult);
   }
+
+  if (base::CPU().has_avx()) {
+    SCOPED_TRACE("FMAC_AVX");
+    FillTestVectors(kInputFillValue, kOutputFillValue);
+    vector_math::FMAC_AVX(
+        input_vector_.get(), kScale, kVectorSize, output_vector_.get());
+    VerifyOutput(kResult);
+  }
 #endif
 
 #if defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
@@ -97,6 +106,70 @@ TEST_F(VectorMathTest, FMAC) {
 #endif
 }
 
+// Ensure each vector_math::FMACBatch() method matches repeated FMAC() calls.
+TEST_F(VectorMathTest, FMACBatch) {
+  static const int kSources = 3;
+  static const float kScales[kSources] = {kScale, kScale / 3, kScale / 7};
+  const float* sources[kSources] = {input_vector_.get(), input_vector_.get(),
+                                    input_vector_.get()};
+
+  // Use non-trivial values so that any change in the order of operations
+  // shows up in the low bits.
+  FillTestVectors(0, 0);
+  for (int i = 0; i < kVectorSize; ++i)
+    input_vector_[i] = sinf(i * 0.01f);
+  std::unique_ptr<float[], base::AlignedFreeDeleter> expected(
+      static_cast<float*>(base::AlignedAlloc(
+          sizeof(float) * kVectorSize, vector_math::kRequiredAlignment)));
+  for (int i = 0; i < kVectorSize; ++i)
+    expected[i] = kOutputFillValue + cosf(i * 0.01f);
+  for (int k = 0; k < kSources; ++k) {
+    vector_math::FMAC_C(sources[k], kScales[k], kVectorSize,
+                        expected.get());
+  }
+
+  // Runs |fn| over all but the last element so the SIMD tail is covered too.
+  auto verify = [&](void (*fn)(const float* const[], const float[], int, int,
+                               float[])) {
+    for (int i = 0; i < kVectorSize; ++i)
+      output_vector_[i] = kOutputFillValue + cosf(i * 0.01f);
+    const float last = output_vector_[kVectorSize - 1];
+    fn(sources, kScales, kSources, kVectorSize - 1, output_vector_.get());
+    for (int i = 0; i < kVectorSize - 1; ++i)
+      ASSERT_FLOAT_EQ(expected[i], output_vector_[i]) << "i=" << i;
+    ASSERT_FLOAT_EQ(last, output_vector_[kVectorSize - 1]);
+  };
+
+  {
+    SCOPED_TRACE("FMACBatch");
+    verify(vector_math::FMACBatch);
+  }
+
+  {
+    SCOPED_TRACE("FMACBatch_C");
+    verify(vector_math::FMACBatch_C);
+  }
+
+#if defined(ARCH_CPU_X86_FAMILY) && !defined(OS_NACL)
+  {
+    SCOPED_TRACE("FMACBatch_SSE");
+    verify(vector_math::FMACBatch_SSE);
+  }
+
+  if (base::CPU().has_avx()) {
+    SCOPED_TRACE("FMACBatch_AVX");
+    verify(vector_math::FMACBatch_AVX);
+  }
+#endif
+
+#if defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
+  {
+    SCOPED_TRACE("FMACBatch_NEON");
+    verify(vector_math::FMACBatch_NEON);
+  }
+#endif
+}
+
 // Ensure each optimized vector_math::FMUL() method returns the same value.
 TEST_F(VectorMathTest, FMUL) {
   static const float kResult = kInputFillValue * kScale;
@@ -117,7 +190,7 @@ TEST_F(VectorMathTest, FMUL) {
     VerifyOutput(kResult);
   }
 
-#if defined(ARCH_CPU_X86_FAMILY)
+#if defined(ARCH_CPU_X86_FAMILY) && !defined(OS_NACL)
   {
     SCOPED_TRACE("FMUL_SSE");
     FillTestVectors(kInputFillValue, kOutputFillValue);
@@ -125,6 +198,14 @@ TEST_F(VectorMathTest, FMUL) {
         input_vector_.get(), kScale, kVectorSize, output_vector_.get());
     VerifyOutput(kResult);
   }
+
+  if (base::CPU().has_avx()) {
+    SCOPED_TRACE("FMUL_AVX");
+    FillTestVectors(kInputFillValue, kOutputFillValue);
+    vector_math::FMUL_AVX(
+        input_vector_.get(), kScale, kVectorSize, output_vector_.get());
+    VerifyOutput(kResult);
+  }
 #endif
 
 #if defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
@@ -139,13 +220,42 @@ TEST_F(VectorMathTest, FMUL) {
 }
 
 TEST_F(VectorMathTest, Crossfade) {
-  FillTestVectors(0, 1);
-  vector_math::Crossfade(
-      input_vector_.get(), kVectorSize, output_vector_.get());
-  for (int i = 0; i < kVectorSize; ++i) {
-    ASSERT_FLOAT_EQ(i / static_cast<float>(kVectorSize), output_vector_[i])
-        << "i=" << i;
+  {
+    SCOPED_TRACE("Crossfade");
+    FillTestVectors(0, 1);
+    vector_math::Crossfade(
+        input_vector_.get(), kVectorSize, output_vector_.get());
+    for (int i = 0; i < kVectorSize; ++i) {
+      ASSERT_FLOAT_EQ(i / static_cast<float>(kVectorSize), output_vector_[i])
+          << "i=" << i;
+    }
   }
+
+  {
+    SCOPED_TRACE("Crossfade_C");
+    FillTestVectors(0, 1);
+    vector_math::Crossfade_C(
+        input_vector_.get(), kVectorSize, output_vector_.get());
+    for (int i = 0; i < kVectorSize; ++i) {
+      ASSERT_FLOAT_EQ(i / static_cast<float>(kVectorSize), output_vector_[i])
+          << "i=" << i;
+    }
+  }
+
+#if defined(ARCH_CPU_X86_FAMILY) && !defined(OS_NACL)
+  if (base::CPU().has_avx()) {
+    SCOPED_TRACE("Crossfade_AVX");
+    // Use an unaligned size to cover the scalar tail.
+    FillTestVectors(0, 1);
+    vector_math::Crossfade_AVX(
+        input_vector_.get(), kVectorSize - 1, output_vector_.get());
+    for (int i = 0; i < kVectorSize - 1; ++i) {
+      ASSERT_FLOAT_EQ(i / static_cast<float>(kVectorSize - 1),
+                      output_vector_[i])
+          << "i=" << i;
+    }
+  }
+#endif
 }
 
 class EWMATestScenario {
@@ -225,7 +335,7 @@ class EWMATestScenario {
       EXPECT_NEAR(expected_max_, result.second, 0.0000001f);
     }
 
-#if defined(ARCH_CPU_X86_FAMILY)
+#if defined(ARCH_CPU_X86_FAMILY) && !defined(OS_NACL)
     {
       SCOPED_TRACE("EWMAAndMaxPower_SSE");
       const std::pair<float, float>& result = vector_math::EWMAAndMaxPower_SSE(
@@ -233,6 +343,14 @@ class EWMATestScenario {
       EXPECT_NEAR(expected_final_avg_, result.first, 0.0000001f);
       EXPECT_NEAR(expected_max_, result.second, 0.0000001f);
     }
+
+    if (base::CPU().has_avx()) {
+      SCOPED_TRACE("EWMAAndMaxPower_AVX");
+      const std::pair<float, float>& result = vector_math::EWMAAndMaxPower_AVX(
+          initial_value_, data_.get(), data_len_, smoothing_factor_);
+      EXPECT_NEAR(expected_final_avg_, result.first, 0.0000001f);
+      EXPECT_NEAR(expected_max_, result.second, 0.0000001f);
+    }
 #endif
 
 #if defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
@@ -4,19 +4,65 @@
 
 #include "media/base/video_frame_pool.h"
 
-#include <list>
+#include <stdint.h>
 
+#include <deque>
+#include <map>
+#include <tuple>
+#include <utility>
+
+#include "base/atomicops.h"
 #include "base/bind.h"
+#include "base/logging.h"
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
 #include "base/synchronization/lock.h"
+#include "base/time/time.h"
 
 namespace media {
 
+namespace {
+
+// The number of independently locked shards the free lists are spread over.
+enum { kNumShards = 8 };
+
+// Free frames are interchangeable if they have the same format and coded
+// size; the visible rect and natural size are set on the wrapper.
+struct FrameKey {
+  FrameKey(VideoPixelFormat format, const gfx::Size& coded_size)
+      : format(format), width(coded_size.width()),
+        height(coded_size.height()) {}
+
+  bool operator<(const FrameKey& other) const {
+    return std::tie(format, width, height) <
+           std::tie(other.format, other.width, other.height);
+  }
+
+  VideoPixelFormat format;
+  int width;
+  int height;
+};
+
+struct FreeFrame {
+  scoped_refptr<VideoFrame> frame;
+  size_t bytes;
+  // Position of the release among all releases to the pool. Unlike a release
+  // time, it is unique, so the least recently released frame is well defined.
+  uintptr_t release_sequence;
+};
+
+// Returns true if release sequence |a| comes before |b|, allowing for the
+// sequence wrapping around.
+bool ReleasedBefore(uintptr_t a, uintptr_t b) {
+  return static_cast<intptr_t>(a - b) < 0;
+}
+
+}  // namespace
+
 class VideoFramePool::PoolImpl
     : public base::RefCountedThreadSafe<VideoFramePool::PoolImpl> {
  public:
-  PoolImpl();
+  explicit PoolImpl(size_t max_bytes_held);
 
   // See VideoFramePool::CreateFrame() for usage.
   scoped_refptr<VideoFrame> CreateFrame(VideoPixelFormat format,
@@ -25,33 +71,74 @@ class VideoFramePool::PoolImpl
                                         const gfx::Size& natural_size,
                                         base::TimeDelta timestamp);
 
-  // Shuts down the frame pool and releases all frames in |frames_|.
-  // Once this is called frames will no longer be inserted back into
-  // |frames_|.
+  // Shuts down the frame pool and releases all free frames. Once this is
+  // called frames will no longer be returned to the pool.
   void Shutdown();
 
-  size_t GetPoolSizeForTesting() const { return frames_.size(); }
+  Stats GetStats() const;
 
  private:
   friend class base::RefCountedThreadSafe<VideoFramePool::PoolImpl>;
   ~PoolImpl();
 
+  // Free frames of each key, least recently released first.
+  using FreeFrameMap = std::map<FrameKey, std::deque<FreeFrame>>;
+
+  struct Shard {
+    Shard() : is_shutdown(false), hits(0), misses(0), evictions(0) {}
+
+    base::Lock lock;
+    bool is_shutdown;
+    FreeFrameMap free_frames;
+    size_t hits;
+    size_t misses;
+    size_t evictions;
+  };
+
+  Shard& ShardFor(const FrameKey& key);
+
   // Called when the frame wrapper gets destroyed.
   // |frame| is the actual frame that was wrapped and is placed
-  // in |frames_| by this function so it can be reused.
-  void FrameReleased(const scoped_refptr<VideoFrame>& frame);
+  // in the free frames for |key| by this function so it can be reused.
+  void FrameReleased(const FrameKey& key,
+                     const scoped_refptr<VideoFrame>& frame);
+
+  // Destroys the least recently released free frames, across all shards,
+  // until they hold no more than |max_bytes_held_|.
+  void TrimToLimit();
 
-  base::Lock lock_;
-  bool is_shutdown_;
-  std::list<scoped_refptr<VideoFrame> > frames_;
+  const size_t max_bytes_held_;
+
+  // Total size of the free frames in all shards.
+  base::subtle::AtomicWord bytes_held_;
+
+  // Release sequence of the most recently released frame.
+  base::subtle::AtomicWord release_sequence_;
+
+  // Serializes TrimToLimit(), which visits every shard.
+  base::Lock trim_lock_;
+
+  mutable Shard shards_[kNumShards];
 
   DISALLOW_COPY_AND_ASSIGN(PoolImpl);
 };
 
-VideoFramePool::PoolImpl::PoolImpl() : is_shutdown_(false) {}
+VideoFramePool::PoolImpl::PoolImpl(size_t max_bytes_held)
+    : max_bytes_held_(max_bytes_held), bytes_held_(0), release_sequence_(0) {}
 
 VideoFramePool::PoolImpl::~PoolImpl() {
-  DCHECK(is_shutdown_);
+#if DCHECK_IS_ON()
+  for (const Shard& shard : shards_)
+    DCHECK(shard.is_shutdown);
+#endif
+}
+
+VideoFramePool::PoolImpl::Shard& VideoFramePool::PoolImpl::ShardFor(
+    const FrameKey& key) {
+  const uint32_t hash = (static_cast<uint32_t>(key.format) * 0x9E3779B1u) ^
+                        (static_cast<uint32_t>(key.width) * 0x85EBCA6Bu) ^
+                        (static_cast<uint32_t>(key.height) * 0xC2B2AE35u);
+  return shards_[(hash >> 16) % kNumShards];
 }
 
 scoped_refptr<VideoFrame> VideoFramePool::PoolImpl::CreateFrame(
@@ -60,28 +147,45 @@ scoped_refptr<VideoFrame> VideoFramePool::PoolImpl::CreateFrame(
     const gfx::Rect& visible_rect,
     const gfx::Size& natural_size,
     base::TimeDelta timestamp) {
-  base::AutoLock auto_lock(lock_);
-  DCHECK(!is_shutdown_);
+  // Frames are pooled by coded size alone, so check the rest of the
+  // parameters here rather than relying on frame creation to.
+  if (!VideoFrame::IsValidConfig(format, VideoFrame::STORAGE_OWNED_MEMORY,
+                                 coded_size, visible_rect, natural_size)) {
+    LOG(ERROR) << "Failed to create a video frame";
+    return nullptr;
+  }
 
+  const FrameKey key(format, coded_size);
+  Shard& shard = ShardFor(key);
   scoped_refptr<VideoFrame> frame;
-  while (!frame.get() && !frames_.empty()) {
-      scoped_refptr<VideoFrame> pool_frame = frames_.front();
-      frames_.pop_front();
-
-      if (pool_frame->format() == format &&
-          pool_frame->coded_size() == coded_size &&
-          pool_frame->visible_rect() == visible_rect &&
-          pool_frame->natural_size() == natural_size) {
-        frame = pool_frame;
-        frame->set_timestamp(timestamp);
-        frame->metadata()->Clear();
-        break;
-      }
+  {
+    base::AutoLock auto_lock(shard.lock);
+    DCHECK(!shard.is_shutdown);
+
+    FreeFrameMap::iterator it = shard.free_frames.find(key);
+    if (it != shard.free_frames.end()) {
+      // Reuse the most recently released frame, which is the most likely to
+      // still be in cache.
+      DCHECK(!it->second.empty());
+      frame = std::move(it->second.back().frame);
+      base::subtle::NoBarrier_AtomicIncrement(
+          &bytes_held_, -static_cast<intptr_t>(it->second.back().bytes));
+      it->second.pop_back();
+      if (it->second.empty())
+        shard.free_frames.erase(it);
+      ++shard.hits;
+    } else {
+      ++shard.misses;
+    }
   }
 
-  if (!frame.get()) {
+  if (frame) {
+    frame->set_timestamp(timestamp);
+    frame->metadata()->Clear();
+  } else {
+    // Allocate outside the lock; zeroing a large frame takes a while.
     frame = VideoFrame::CreateZeroInitializedFrame(
-        format, coded_size, visible_rect, natural_size, timestamp);
+        format, coded_size, gfx::Rect(coded_size), coded_size, timestamp);
     // This can happen if the arguments are not valid.
     if (!frame) {
       LOG(ERROR) << "Failed to create a video frame";
@@ -90,30 +194,132 @@ scoped_refptr<VideoFrame> VideoFramePool::PoolImpl::CreateFrame(
   }
 
   scoped_refptr<VideoFrame> wrapped_frame = VideoFrame::WrapVideoFrame(
-      frame, frame->format(), frame->visible_rect(), frame->natural_size());
+      frame, frame->format(), visible_rect, natural_size);
   wrapped_frame->AddDestructionObserver(
-      base::Bind(&VideoFramePool::PoolImpl::FrameReleased, this, frame));
+      base::Bind(&VideoFramePool::PoolImpl::FrameReleased, this, key, frame));
   return wrapped_frame;
 }
 
 void VideoFramePool::PoolImpl::Shutdown() {
-  base::AutoLock auto_lock(lock_);
-  is_shutdown_ = true;
-  frames_.clear();
+  for (Shard& shard : shards_) {
+    FreeFrameMap free_frames;
+    {
+      base::AutoLock auto_lock(shard.lock);
+      shard.is_shutdown = true;
+      free_frames.swap(shard.free_frames);
+    }
+    // Destroy the frames outside the lock.
+  }
+  base::subtle::NoBarrier_Store(&bytes_held_, 0);
+}
+
+VideoFramePool::Stats VideoFramePool::PoolImpl::GetStats() const {
+  Stats stats;
+  for (Shard& shard : shards_) {
+    base::AutoLock auto_lock(shard.lock);
+    stats.hits += shard.hits;
+    stats.misses += shard.misses;
+    stats.evictions += shard.evictions;
+    for (const auto& key_frames : shard.free_frames) {
+      stats.frames_held += key_frames.second.size();
+      for (const FreeFrame& free_frame : key_frames.second)
+        stats.bytes_held += free_frame.bytes;
+    }
+  }
+  return stats;
 }
 
 void VideoFramePool::PoolImpl::FrameReleased(
+    const FrameKey& key,
     const scoped_refptr<VideoFrame>& frame) {
-  base::AutoLock auto_lock(lock_);
-  if (is_shutdown_)
-    return;
+  const size_t bytes =
+      VideoFrame::AllocationSize(frame->format(), frame->coded_size());
+  size_t bytes_held;
+  {
+    Shard& shard = ShardFor(key);
+    base::AutoLock auto_lock(shard.lock);
+    if (shard.is_shutdown)
+      return;
+
+    FreeFrame free_frame;
+    free_frame.frame = frame;
+    free_frame.bytes = bytes;
+    // Taken under the shard lock, so each free list stays in release order.
+    free_frame.release_sequence = static_cast<uintptr_t>(
+        base::subtle::NoBarrier_AtomicIncrement(&release_sequence_, 1));
+    shard.free_frames[key].push_back(free_frame);
+
+    // Count the frame under the lock, so it's always counted before it can
+    // be taken again and |bytes_held_| never goes negative.
+    bytes_held = static_cast<size_t>(base::subtle::NoBarrier_AtomicIncrement(
+        &bytes_held_, static_cast<intptr_t>(bytes)));
+  }
 
-  frames_.push_back(frame);
+  if (bytes_held > max_bytes_held_)
+    TrimToLimit();
 }
 
-VideoFramePool::VideoFramePool() : pool_(new PoolImpl()) {
+void VideoFramePool::PoolImpl::TrimToLimit() {
+  base::AutoLock trim_lock(trim_lock_);
+  while (static_cast<size_t>(base::subtle::NoBarrier_Load(&bytes_held_)) >
+         max_bytes_held_) {
+    // Find the shard whose oldest free frame is oldest overall. Each free
+    // list is in release order, so only its front needs looking at.
+    Shard* oldest_shard = nullptr;
+    uintptr_t oldest_sequence = 0;
+    for (Shard& shard : shards_) {
+      base::AutoLock auto_lock(shard.lock);
+      for (const auto& key_frames : shard.free_frames) {
+        const uintptr_t release_sequence =
+            key_frames.second.front().release_sequence;
+        if (!oldest_shard ||
+            ReleasedBefore(release_sequence, oldest_sequence)) {
+          oldest_shard = &shard;
+          oldest_sequence = release_sequence;
+        }
+      }
+    }
+    // Everything may have been reused or shut down meanwhile.
+    if (!oldest_shard)
+      return;
+
+    scoped_refptr<VideoFrame> evicted_frame;
+    {
+      base::AutoLock auto_lock(oldest_shard->lock);
+      // Other threads may have taken frames since the shard was searched, so
+      // evict whatever is oldest in it now.
+      FreeFrameMap::iterator oldest = oldest_shard->free_frames.end();
+      for (FreeFrameMap::iterator it = oldest_shard->free_frames.begin();
+           it != oldest_shard->free_frames.end(); ++it) {
+        if (oldest == oldest_shard->free_frames.end() ||
+            ReleasedBefore(it->second.front().release_sequence,
+                           oldest->second.front().release_sequence)) {
+          oldest = it;
+        }
+      }
+      if (oldest == oldest_shard->free_frames.end())
+        continue;
+
+      evicted_frame = std::move(oldest->second.front().frame);
+      base::subtle::NoBarrier_AtomicIncrement(
+          &bytes_held_, -static_cast<intptr_t>(oldest->second.front().bytes));
+      oldest->second.pop_front();
+      if (oldest->second.empty())
+        oldest_shard->free_frames.erase(oldest);
+      ++oldest_shard->evictions;
+    }
+    // |evicted_frame| is destroyed outside the shard lock.
+  }
 }
 
+VideoFramePool::Stats::Stats()
+    : hits(0), misses(0), evictions(0), frames_held(0), bytes_held(0) {}
+
+VideoFramePool::VideoFramePool() : VideoFramePool(kDefaultMaxBytesHeld) {}
+
+VideoFramePool::VideoFramePool(size_t max_bytes_held)
+    : pool_(new PoolImpl(max_bytes_held)) {}
+
 VideoFramePool::~VideoFramePool() {
   pool_->Shutdown();
 }
@@ -128,8 +334,12 @@ scoped_refptr<VideoFrame> VideoFramePool::CreateFrame(
                             timestamp);
 }
 
+VideoFramePool::Stats VideoFramePool::GetStats() const {
+  return pool_->GetStats();
+}
+
 size_t VideoFramePool::GetPoolSizeForTesting() const {
-  return pool_->GetPoolSizeForTesting();
+  return pool_->GetStats().frames_held;
 }
 
 }  // namespace media
@@ -13,31 +13,62 @@
 
 namespace media {
 
-// Simple VideoFrame pool used to avoid unnecessarily allocating and destroying
+// VideoFrame pool used to avoid unnecessarily allocating and destroying
 // VideoFrame objects. The pool manages the memory for the VideoFrame
 // returned by CreateFrame(). When one of these VideoFrames is destroyed,
 // the memory is returned to the pool for use by a subsequent CreateFrame()
-// call. The memory in the pool is retained for the life of the
-// VideoFramePool object. If the parameters passed to CreateFrame() change
-// during the life of this object, then the memory used by frames with the old
-// parameter values will be purged from the pool.
+// call with the same format and coded size.
+//
+// Free frames are kept in a separate list for each format and coded size, so
+// one pool may be shared by decoders and scalers producing different kinds of
+// frame, on any threads. The lists are spread over several independently
+// locked shards so that users of different kinds of frame don't contend.
+// Once the free frames take more than the pool's memory limit, the least
+// recently released ones are destroyed, whatever their kind.
 class MEDIA_EXPORT VideoFramePool {
  public:
+  struct MEDIA_EXPORT Stats {
+    Stats();
+
+    // CreateFrame() calls which reused a free frame, and which didn't.
+    size_t hits;
+    size_t misses;
+
+    // Free frames destroyed to keep within the memory limit.
+    size_t evictions;
+
+    // Free frames in the pool, and the memory they hold.
+    size_t frames_held;
+    size_t bytes_held;
+  };
+
+  // The memory limit used by the default constructor.
+  enum { kDefaultMaxBytesHeld = 64 * 1024 * 1024 };
+
   VideoFramePool();
+
+  // Creates a pool which keeps at most |max_bytes_held| bytes of free frames.
+  explicit VideoFramePool(size_t max_bytes_held);
+
   ~VideoFramePool();
 
   // Returns a frame from the pool that matches the specified
   // parameters or creates a new frame if no suitable frame exists in
-  // the pool. The pool is drained if no matching frame is found.
-  // The buffer for the new frame will be zero initialized.  Reused frames will
-  // not be zero initialized.
+  // the pool. Frames are reused for any |visible_rect| and |natural_size| with
+  // the same |format| and |coded_size|. The buffer for the new frame will be
+  // zero initialized.  Reused frames will not be zero initialized.
+  //
+  // May be called on any thread.
   scoped_refptr<VideoFrame> CreateFrame(VideoPixelFormat format,
                                         const gfx::Size& coded_size,
                                         const gfx::Rect& visible_rect,
                                         const gfx::Size& natural_size,
                                         base::TimeDelta timestamp);
 
-protected:
+  // Returns a snapshot of the pool's statistics. May be called on any thread.
+  Stats GetStats() const;
+
+ protected:
   friend class VideoFramePoolTest;
 
   // Returns the number of frames in the pool for testing purposes.
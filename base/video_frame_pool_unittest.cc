@@ -5,7 +5,13 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <memory>
+#include <vector>
 
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/memory/ptr_util.h"
+#include "base/single_thread_task_runner.h"
+#include "base/threading/thread.h"
 #include "media/base/video_frame_pool.h"
 #include "testing/gmock/include/gmock/gmock.h"
 
@@ -74,10 +80,125 @@ TEST_F(VideoFramePoolTest, SimpleFormatChange) {
   // Verify that both frames are in the pool.
   CheckPoolSize(2u);
 
-  // Verify that requesting a frame with a different format causes the pool
-  // to get drained.
+  // Verify that requesting a frame with a different format leaves the free
+  // frames of the old format in the pool.
   scoped_refptr<VideoFrame> new_frame = CreateFrame(PIXEL_FORMAT_YV12A, 10);
-  CheckPoolSize(0u);
+  CheckPoolSize(2u);
+
+  VideoFramePool::Stats stats = pool_->GetStats();
+  EXPECT_EQ(0u, stats.hits);
+  EXPECT_EQ(3u, stats.misses);
+  EXPECT_EQ(2 * VideoFrame::AllocationSize(PIXEL_FORMAT_YV12,
+                                           gfx::Size(320, 240)),
+            stats.bytes_held);
+
+  // And that they're still reused.
+  new_frame = CreateFrame(PIXEL_FORMAT_YV12, 10);
+  CheckPoolSize(1u);
+  EXPECT_EQ(1u, pool_->GetStats().hits);
+}
+
+TEST_F(VideoFramePoolTest, ReuseWithDifferentVisibleRect) {
+  const gfx::Size coded_size(320, 240);
+  scoped_refptr<VideoFrame> frame = pool_->CreateFrame(
+      PIXEL_FORMAT_YV12, coded_size, gfx::Rect(coded_size), coded_size,
+      base::TimeDelta());
+  const uint8_t* old_y_data = frame->data(VideoFrame::kYPlane);
+  frame = NULL;
+
+  // Frames with the same format and coded size share memory whatever their
+  // visible rect and natural size.
+  const gfx::Rect visible_rect(8, 8, 300, 200);
+  const gfx::Size natural_size(600, 400);
+  frame = pool_->CreateFrame(PIXEL_FORMAT_YV12, coded_size, visible_rect,
+                             natural_size, base::TimeDelta());
+  EXPECT_EQ(old_y_data, frame->data(VideoFrame::kYPlane));
+  EXPECT_EQ(visible_rect, frame->visible_rect());
+  EXPECT_EQ(natural_size, frame->natural_size());
+  EXPECT_EQ(1u, pool_->GetStats().hits);
+
+  // Invalid parameters are rejected without creating a frame.
+  EXPECT_FALSE(pool_->CreateFrame(PIXEL_FORMAT_YV12, coded_size,
+                                  gfx::Rect(0, 0, 640, 480), natural_size,
+                                  base::TimeDelta()));
+}
+
+TEST_F(VideoFramePoolTest, TrimsLeastRecentlyReleased) {
+  const gfx::Size small_size(160, 120);
+  const gfx::Size large_size(320, 240);
+  const size_t small_bytes =
+      VideoFrame::AllocationSize(PIXEL_FORMAT_YV12, small_size);
+  const size_t large_bytes =
+      VideoFrame::AllocationSize(PIXEL_FORMAT_YV12, large_size);
+  pool_.reset(new VideoFramePool(2 * large_bytes));
+
+  scoped_refptr<VideoFrame> small_frame = pool_->CreateFrame(
+      PIXEL_FORMAT_YV12, small_size, gfx::Rect(small_size), small_size,
+      base::TimeDelta());
+  scoped_refptr<VideoFrame> large_frame_a = pool_->CreateFrame(
+      PIXEL_FORMAT_YV12, large_size, gfx::Rect(large_size), large_size,
+      base::TimeDelta());
+  scoped_refptr<VideoFrame> large_frame_b = pool_->CreateFrame(
+      PIXEL_FORMAT_YV12, large_size, gfx::Rect(large_size), large_size,
+      base::TimeDelta());
+
+  // Release the small frame first, so it's the least recently released when
+  // the second large frame takes the pool over its limit.
+  ASSERT_LT(small_bytes, large_bytes);
+  small_frame = NULL;
+  large_frame_a = NULL;
+  CheckPoolSize(2u);
+  large_frame_b = NULL;
+  CheckPoolSize(2u);
+
+  VideoFramePool::Stats stats = pool_->GetStats();
+  EXPECT_EQ(1u, stats.evictions);
+  EXPECT_EQ(2u, stats.frames_held);
+  EXPECT_EQ(2 * large_bytes, stats.bytes_held);
+}
+
+// Creates and releases |count| frames of |coded_size| from |pool|, holding a
+// few at a time as a decoder would.
+static void CreateAndReleaseFrames(VideoFramePool* pool,
+                                   const gfx::Size& coded_size,
+                                   int count) {
+  std::vector<scoped_refptr<VideoFrame>> frames;
+  for (int i = 0; i < count; ++i) {
+    frames.push_back(pool->CreateFrame(PIXEL_FORMAT_YV12, coded_size,
+                                       gfx::Rect(coded_size), coded_size,
+                                       base::TimeDelta()));
+    if (frames.size() > 3)
+      frames.erase(frames.begin());
+  }
+}
+
+// Share one pool between threads making frames of different sizes, which
+// live in different shards, and the same size, which contend for one.
+TEST_F(VideoFramePoolTest, ConcurrentCreateAndRelease) {
+  static const int kThreads = 4;
+  static const int kFramesPerThread = 500;
+  const size_t max_bytes_held =
+      4 * VideoFrame::AllocationSize(PIXEL_FORMAT_YV12, gfx::Size(352, 288));
+  pool_.reset(new VideoFramePool(max_bytes_held));
+
+  std::vector<std::unique_ptr<base::Thread>> threads;
+  for (int i = 0; i < kThreads; ++i) {
+    threads.push_back(base::MakeUnique<base::Thread>("VideoFramePoolTest"));
+    ASSERT_TRUE(threads.back()->Start());
+    const gfx::Size coded_size(320 + 16 * (i % 3), 240);
+    threads.back()->task_runner()->PostTask(
+        FROM_HERE,
+        base::Bind(&CreateAndReleaseFrames, base::Unretained(pool_.get()),
+                   coded_size, kFramesPerThread));
+  }
+  for (const auto& thread : threads)
+    thread->Stop();
+
+  VideoFramePool::Stats stats = pool_->GetStats();
+  EXPECT_EQ(static_cast<size_t>(kThreads * kFramesPerThread),
+            stats.hits + stats.misses);
+  EXPECT_GT(stats.hits, stats.misses);
+  EXPECT_LE(stats.bytes_held, max_bytes_held);
 }
 
 TEST_F(VideoFramePoolTest, FrameValidAfterPoolDestruction) {
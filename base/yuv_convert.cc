@@ -21,6 +21,7 @@
 
 #include <algorithm>
 
+#include "base/bind.h"
 #include "base/cpu.h"
 #include "base/lazy_instance.h"
 #include "base/logging.h"
@@ -28,6 +29,7 @@
 #include "base/memory/aligned_memory.h"
 #include "base/third_party/dynamic_annotations/dynamic_annotations.h"
 #include "build/build_config.h"
+#include "media/base/parallel_row_bands.h"
 #include "media/base/simd/convert_rgb_to_yuv.h"
 #include "media/base/simd/convert_yuv_to_rgb.h"
 #include "media/base/simd/filter_yuv.h"
@@ -105,6 +107,15 @@ typedef void (*ScaleYUVToRGB32RowProc)(const uint8_t*,
                                        ptrdiff_t,
                                        const int16_t*);
 
+typedef void (*ConvertHighBitDepthYUVToARGBRowProc)(
+    const uint16_t*,
+    const uint16_t*,
+    const uint16_t*,
+    uint8_t*,
+    ptrdiff_t,
+    int,
+    const HighBitDepthYUVToRGBCoefficients*);
+
 static FilterYUVRowsProc g_filter_yuv_rows_proc_ = NULL;
 static ConvertYUVToRGB32RowProc g_convert_yuv_to_rgb32_row_proc_ = NULL;
 static ScaleYUVToRGB32RowProc g_scale_yuv_to_rgb32_row_proc_ = NULL;
@@ -113,6 +124,8 @@ static ConvertRGBToYUVProc g_convert_rgb32_to_yuv_proc_ = NULL;
 static ConvertRGBToYUVProc g_convert_rgb24_to_yuv_proc_ = NULL;
 static ConvertYUVToRGB32Proc g_convert_yuv_to_rgb32_proc_ = NULL;
 static ConvertYUVAToARGBProc g_convert_yuva_to_argb_proc_ = NULL;
+static ConvertHighBitDepthYUVToARGBRowProc
+    g_convert_high_bit_depth_yuv_to_argb_row_proc_ = NULL;
 
 static const int kYUVToRGBTableSize = 256 * 4 * 4 * sizeof(int16_t);
 
@@ -232,6 +245,7 @@ void InitializeCPUSpecificYUVConversions() {
   CHECK(!g_convert_rgb24_to_yuv_proc_);
   CHECK(!g_convert_yuv_to_rgb32_proc_);
   CHECK(!g_convert_yuva_to_argb_proc_);
+  CHECK(!g_convert_high_bit_depth_yuv_to_argb_row_proc_);
   CHECK(!g_empty_register_state_proc_);
 
   g_filter_yuv_rows_proc_ = FilterYUVRows_C;
@@ -242,6 +256,8 @@ void InitializeCPUSpecificYUVConversions() {
   g_convert_rgb24_to_yuv_proc_ = ConvertRGB24ToYUV_C;
   g_convert_yuv_to_rgb32_proc_ = ConvertYUVToRGB32_C;
   g_convert_yuva_to_argb_proc_ = ConvertYUVAToARGB_C;
+  g_convert_high_bit_depth_yuv_to_argb_row_proc_ =
+      ConvertHighBitDepthYUVToARGBRow_C;
   g_empty_register_state_proc_ = EmptyRegisterStateStub;
 
   // Assembly code confuses MemorySanitizer. Also not available in iOS builds.
@@ -260,6 +276,8 @@ void InitializeCPUSpecificYUVConversions() {
 
   g_filter_yuv_rows_proc_ = FilterYUVRows_SSE2;
   g_convert_rgb32_to_yuv_proc_ = ConvertRGB32ToYUV_SSE2;
+  g_convert_high_bit_depth_yuv_to_argb_row_proc_ =
+      ConvertHighBitDepthYUVToARGBRow_SSE2;
 
 #if defined(ARCH_CPU_X86_64)
   g_scale_yuv_to_rgb32_row_proc_ = ScaleYUVToRGB32Row_SSE2_X64;
@@ -320,6 +338,141 @@ const int kFractionBits = 16;
 const int kFractionMax = 1 << kFractionBits;
 const int kFractionMask = ((1 << kFractionBits) - 1);
 
+// 4096 allows 3 buffers to fit in 12k.
+// Helps performance on CPU with 16K L1 cache.
+// Large enough for 3830x2160 and 30" displays which are 2560x1600.
+const int kFilterBufferSize = 4096;
+
+// The ScaleYUVToRGB32() state shared by all destination rows, with rotation
+// and mirroring folded into the source pointers and pitches.
+struct ScaleYUVToRGB32Params {
+  const uint8_t* y_buf;
+  const uint8_t* u_buf;
+  const uint8_t* v_buf;
+  uint8_t* rgb_buf;
+  int source_width;
+  int source_height;
+  int width;
+  int y_pitch;
+  int uv_pitch;
+  int rgb_pitch;
+  unsigned int y_shift;
+  int source_dx;
+  int source_y_subpixel_start;
+  int source_y_subpixel_delta;
+  ScaleFilter filter;
+  const int16_t* lookup_table;
+};
+
+// Scales destination rows [begin_row, end_row).
+static void ScaleYUVToRGB32Rows(const ScaleYUVToRGB32Params* params,
+                                int begin_row,
+                                int end_row) {
+  const uint8_t* const y_buf = params->y_buf;
+  const uint8_t* const u_buf = params->u_buf;
+  const uint8_t* const v_buf = params->v_buf;
+  uint8_t* const rgb_buf = params->rgb_buf;
+  const int source_width = params->source_width;
+  const int source_height = params->source_height;
+  const int width = params->width;
+  const int y_pitch = params->y_pitch;
+  const int uv_pitch = params->uv_pitch;
+  const int rgb_pitch = params->rgb_pitch;
+  const unsigned int y_shift = params->y_shift;
+  const int source_dx = params->source_dx;
+  const int source_y_subpixel_start = params->source_y_subpixel_start;
+  const int source_y_subpixel_delta = params->source_y_subpixel_delta;
+  const ScaleFilter filter = params->filter;
+  const int16_t* const lookup_table = params->lookup_table;
+
+  // Need padding because FilterRows() will write 1 to 16 extra pixels
+  // after the end for SSE2 version.
+  uint8_t yuvbuf[16 + kFilterBufferSize * 3 + 16];
+  uint8_t* ybuf = reinterpret_cast<uint8_t*>(
+      reinterpret_cast<uintptr_t>(yuvbuf + 15) & ~15);
+  uint8_t* ubuf = ybuf + kFilterBufferSize;
+  uint8_t* vbuf = ubuf + kFilterBufferSize;
+
+  for (int y = begin_row; y < end_row; ++y) {
+    uint8_t* dest_pixel = rgb_buf + y * rgb_pitch;
+    int source_y_subpixel =
+        source_y_subpixel_start + y * source_y_subpixel_delta;
+    if (source_y_subpixel < 0)
+      source_y_subpixel = 0;
+    else if (source_y_subpixel > ((source_height - 1) << kFractionBits))
+      source_y_subpixel = (source_height - 1) << kFractionBits;
+
+    const uint8_t* y_ptr = NULL;
+    const uint8_t* u_ptr = NULL;
+    const uint8_t* v_ptr = NULL;
+    // Apply vertical filtering if necessary.
+    // TODO(fbarchard): Remove memcpy when not necessary.
+    if (filter & media::FILTER_BILINEAR_V) {
+      int source_y = source_y_subpixel >> kFractionBits;
+      y_ptr = y_buf + source_y * y_pitch;
+      u_ptr = u_buf + (source_y >> y_shift) * uv_pitch;
+      v_ptr = v_buf + (source_y >> y_shift) * uv_pitch;
+
+      // Vertical scaler uses 16.8 fixed point.
+      uint8_t source_y_fraction = (source_y_subpixel & kFractionMask) >> 8;
+      if (source_y_fraction != 0) {
+        g_filter_yuv_rows_proc_(
+            ybuf, y_ptr, y_ptr + y_pitch, source_width, source_y_fraction);
+      } else {
+        memcpy(ybuf, y_ptr, source_width);
+      }
+      y_ptr = ybuf;
+      ybuf[source_width] = ybuf[source_width - 1];
+
+      int uv_source_width = (source_width + 1) / 2;
+      uint8_t source_uv_fraction;
+
+      // For formats with half-height UV planes, each even-numbered pixel row
+      // should not interpolate, since the next row to interpolate from should
+      // be a duplicate of the current row.
+      if (y_shift && (source_y & 0x1) == 0)
+        source_uv_fraction = 0;
+      else
+        source_uv_fraction = source_y_fraction;
+
+      if (source_uv_fraction != 0) {
+        g_filter_yuv_rows_proc_(
+            ubuf, u_ptr, u_ptr + uv_pitch, uv_source_width, source_uv_fraction);
+        g_filter_yuv_rows_proc_(
+            vbuf, v_ptr, v_ptr + uv_pitch, uv_source_width, source_uv_fraction);
+      } else {
+        memcpy(ubuf, u_ptr, uv_source_width);
+        memcpy(vbuf, v_ptr, uv_source_width);
+      }
+      u_ptr = ubuf;
+      v_ptr = vbuf;
+      ubuf[uv_source_width] = ubuf[uv_source_width - 1];
+      vbuf[uv_source_width] = vbuf[uv_source_width - 1];
+    } else {
+      // Offset by 1/2 pixel for center sampling.
+      int source_y = (source_y_subpixel + (kFractionMax / 2)) >> kFractionBits;
+      y_ptr = y_buf + source_y * y_pitch;
+      u_ptr = u_buf + (source_y >> y_shift) * uv_pitch;
+      v_ptr = v_buf + (source_y >> y_shift) * uv_pitch;
+    }
+    if (source_dx == kFractionMax) {  // Not scaled
+      g_convert_yuv_to_rgb32_row_proc_(y_ptr, u_ptr, v_ptr, dest_pixel, width,
+                                       lookup_table);
+    } else {
+      if (filter & FILTER_BILINEAR_H) {
+        g_linear_scale_yuv_to_rgb32_row_proc_(y_ptr, u_ptr, v_ptr, dest_pixel,
+                                              width, source_dx,
+                                              lookup_table);
+      } else {
+        g_scale_yuv_to_rgb32_row_proc_(y_ptr, u_ptr, v_ptr, dest_pixel, width,
+                                       source_dx, lookup_table);
+      }
+    }
+  }
+
+  g_empty_register_state_proc_();
+}
+
 // Scale a frame of YUV to 32 bit ARGB.
 void ScaleYUVToRGB32(const uint8_t* y_buf,
                      const uint8_t* u_buf,
@@ -335,6 +488,28 @@ void ScaleYUVToRGB32(const uint8_t* y_buf,
                      YUVType yuv_type,
                      Rotate view_rotate,
                      ScaleFilter filter) {
+  ScaleYUVToRGB32InRowBands(y_buf, u_buf, v_buf, rgb_buf, source_width,
+                            source_height, width, height, y_pitch, uv_pitch,
+                            rgb_pitch, yuv_type, view_rotate, filter, nullptr,
+                            0);
+}
+
+void ScaleYUVToRGB32InRowBands(const uint8_t* y_buf,
+                               const uint8_t* u_buf,
+                               const uint8_t* v_buf,
+                               uint8_t* rgb_buf,
+                               int source_width,
+                               int source_height,
+                               int width,
+                               int height,
+                               int y_pitch,
+                               int uv_pitch,
+                               int rgb_pitch,
+                               YUVType yuv_type,
+                               Rotate view_rotate,
+                               ScaleFilter filter,
+                               base::TaskRunner* task_runner,
+                               int max_tasks) {
   // Handle zero sized sources and destinations.
   if ((yuv_type == YV12 && (source_width < 2 || source_height < 2)) ||
       (yuv_type == YV16 && (source_width < 2 || source_height < 1)) ||
@@ -343,10 +518,6 @@ void ScaleYUVToRGB32(const uint8_t* y_buf,
 
   const int16_t* lookup_table = GetLookupTable(yuv_type);
 
-  // 4096 allows 3 buffers to fit in 12k.
-  // Helps performance on CPU with 16K L1 cache.
-  // Large enough for 3830x2160 and 30" displays which are 2560x1600.
-  const int kFilterBufferSize = 4096;
   // Disable filtering if the screen is too big (to avoid buffer overflows).
   // This should never happen to regular users: they don't have monitors
   // wider than 4096 pixels.
@@ -399,14 +570,6 @@ void ScaleYUVToRGB32(const uint8_t* y_buf,
     }
   }
 
-  // Need padding because FilterRows() will write 1 to 16 extra pixels
-  // after the end for SSE2 version.
-  uint8_t yuvbuf[16 + kFilterBufferSize * 3 + 16];
-  uint8_t* ybuf = reinterpret_cast<uint8_t*>(
-      reinterpret_cast<uintptr_t>(yuvbuf + 15) & ~15);
-  uint8_t* ubuf = ybuf + kFilterBufferSize;
-  uint8_t* vbuf = ubuf + kFilterBufferSize;
-
   // TODO(fbarchard): Fixed point math is off by 1 on negatives.
 
   // We take a y-coordinate in [0,1] space in the source image space, and
@@ -416,91 +579,35 @@ void ScaleYUVToRGB32(const uint8_t* y_buf,
   // 0.75.  The formula is as follows (in fixed-point arithmetic):
   //   y_dst = dst_height * ((y_src + 0.5) / src_height)
   //   dst_pixel = clamp([0, dst_height - 1], floor(y_dst - 0.5))
-  // Implement this here as an accumulator + delta, to avoid expensive math
-  // in the loop.
-  int source_y_subpixel_accum =
+  // Implement this here as a start + delta, to avoid expensive math in the
+  // loop.
+  int source_y_subpixel_start =
       ((kFractionMax / 2) * source_height) / height - (kFractionMax / 2);
   int source_y_subpixel_delta = ((1 << kFractionBits) * source_height) / height;
 
-  // TODO(fbarchard): Split this into separate function for better efficiency.
-  for (int y = 0; y < height; ++y) {
-    uint8_t* dest_pixel = rgb_buf + y * rgb_pitch;
-    int source_y_subpixel = source_y_subpixel_accum;
-    source_y_subpixel_accum += source_y_subpixel_delta;
-    if (source_y_subpixel < 0)
-      source_y_subpixel = 0;
-    else if (source_y_subpixel > ((source_height - 1) << kFractionBits))
-      source_y_subpixel = (source_height - 1) << kFractionBits;
-
-    const uint8_t* y_ptr = NULL;
-    const uint8_t* u_ptr = NULL;
-    const uint8_t* v_ptr = NULL;
-    // Apply vertical filtering if necessary.
-    // TODO(fbarchard): Remove memcpy when not necessary.
-    if (filter & media::FILTER_BILINEAR_V) {
-      int source_y = source_y_subpixel >> kFractionBits;
-      y_ptr = y_buf + source_y * y_pitch;
-      u_ptr = u_buf + (source_y >> y_shift) * uv_pitch;
-      v_ptr = v_buf + (source_y >> y_shift) * uv_pitch;
-
-      // Vertical scaler uses 16.8 fixed point.
-      uint8_t source_y_fraction = (source_y_subpixel & kFractionMask) >> 8;
-      if (source_y_fraction != 0) {
-        g_filter_yuv_rows_proc_(
-            ybuf, y_ptr, y_ptr + y_pitch, source_width, source_y_fraction);
-      } else {
-        memcpy(ybuf, y_ptr, source_width);
-      }
-      y_ptr = ybuf;
-      ybuf[source_width] = ybuf[source_width - 1];
-
-      int uv_source_width = (source_width + 1) / 2;
-      uint8_t source_uv_fraction;
-
-      // For formats with half-height UV planes, each even-numbered pixel row
-      // should not interpolate, since the next row to interpolate from should
-      // be a duplicate of the current row.
-      if (y_shift && (source_y & 0x1) == 0)
-        source_uv_fraction = 0;
-      else
-        source_uv_fraction = source_y_fraction;
-
-      if (source_uv_fraction != 0) {
-        g_filter_yuv_rows_proc_(
-            ubuf, u_ptr, u_ptr + uv_pitch, uv_source_width, source_uv_fraction);
-        g_filter_yuv_rows_proc_(
-            vbuf, v_ptr, v_ptr + uv_pitch, uv_source_width, source_uv_fraction);
-      } else {
-        memcpy(ubuf, u_ptr, uv_source_width);
-        memcpy(vbuf, v_ptr, uv_source_width);
-      }
-      u_ptr = ubuf;
-      v_ptr = vbuf;
-      ubuf[uv_source_width] = ubuf[uv_source_width - 1];
-      vbuf[uv_source_width] = vbuf[uv_source_width - 1];
-    } else {
-      // Offset by 1/2 pixel for center sampling.
-      int source_y = (source_y_subpixel + (kFractionMax / 2)) >> kFractionBits;
-      y_ptr = y_buf + source_y * y_pitch;
-      u_ptr = u_buf + (source_y >> y_shift) * uv_pitch;
-      v_ptr = v_buf + (source_y >> y_shift) * uv_pitch;
-    }
-    if (source_dx == kFractionMax) {  // Not scaled
-      g_convert_yuv_to_rgb32_row_proc_(y_ptr, u_ptr, v_ptr, dest_pixel, width,
-                                       lookup_table);
-    } else {
-      if (filter & FILTER_BILINEAR_H) {
-        g_linear_scale_yuv_to_rgb32_row_proc_(y_ptr, u_ptr, v_ptr, dest_pixel,
-                                              width, source_dx,
-                                              lookup_table);
-      } else {
-        g_scale_yuv_to_rgb32_row_proc_(y_ptr, u_ptr, v_ptr, dest_pixel, width,
-                                       source_dx, lookup_table);
-      }
-    }
-  }
+  const ScaleYUVToRGB32Params params = {
+      y_buf,
+      u_buf,
+      v_buf,
+      rgb_buf,
+      source_width,
+      source_height,
+      width,
+      y_pitch,
+      uv_pitch,
+      rgb_pitch,
+      y_shift,
+      source_dx,
+      source_y_subpixel_start,
+      source_y_subpixel_delta,
+      filter,
+      lookup_table,
+  };
 
-  g_empty_register_state_proc_();
+  // Destination rows are independent, so bands may start on any row.
+  RunInParallelRowBands(height, static_cast<size_t>(width) * 4, 1,
+                        task_runner, max_tasks,
+                        base::Bind(&ScaleYUVToRGB32Rows, &params));
 }
 
 // Scale a frame of YV12 to 32 bit ARGB for a specific rectangle.
@@ -715,6 +822,51 @@ void ConvertYUVToRGB32(const uint8_t* yplane,
                                yuv_type);
 }
 
+// Converts rows [begin_row, end_row) of a ConvertYUVToRGB32() frame.
+static void ConvertYUVToRGB32Rows(const uint8_t* yplane,
+                                  const uint8_t* uplane,
+                                  const uint8_t* vplane,
+                                  uint8_t* rgbframe,
+                                  int width,
+                                  int ystride,
+                                  int uvstride,
+                                  int rgbstride,
+                                  YUVType yuv_type,
+                                  int begin_row,
+                                  int end_row) {
+  const int uv_begin_row = begin_row >> GetVerticalShift(yuv_type);
+  g_convert_yuv_to_rgb32_proc_(yplane + begin_row * ystride,
+                               uplane + uv_begin_row * uvstride,
+                               vplane + uv_begin_row * uvstride,
+                               rgbframe + begin_row * rgbstride,
+                               width,
+                               end_row - begin_row,
+                               ystride,
+                               uvstride,
+                               rgbstride,
+                               yuv_type);
+}
+
+void ConvertYUVToRGB32InRowBands(const uint8_t* yplane,
+                                 const uint8_t* uplane,
+                                 const uint8_t* vplane,
+                                 uint8_t* rgbframe,
+                                 int width,
+                                 int height,
+                                 int ystride,
+                                 int uvstride,
+                                 int rgbstride,
+                                 YUVType yuv_type,
+                                 base::TaskRunner* task_runner,
+                                 int max_tasks) {
+  // Bands start on rows with their own chroma row.
+  RunInParallelRowBands(
+      height, static_cast<size_t>(width) * 4, 1 << GetVerticalShift(yuv_type),
+      task_runner, max_tasks,
+      base::Bind(&ConvertYUVToRGB32Rows, yplane, uplane, vplane, rgbframe,
+                 width, ystride, uvstride, rgbstride, yuv_type));
+}
+
 void ConvertYUVAToARGB(const uint8_t* yplane,
                        const uint8_t* uplane,
                        const uint8_t* vplane,
@@ -741,4 +893,41 @@ void ConvertYUVAToARGB(const uint8_t* yplane,
                                yuv_type);
 }
 
+void ConvertHighBitDepthYUVToARGB(const uint16_t* yplane,
+                                  const uint16_t* uplane,
+                                  const uint16_t* vplane,
+                                  uint8_t* rgbframe,
+                                  int width,
+                                  int height,
+                                  int ystride,
+                                  int uvstride,
+                                  int rgbstride,
+                                  int uv_width_shift,
+                                  int uv_height_shift,
+                                  int bit_depth,
+                                  const double yuv_to_rgb_matrix[3][4]) {
+  DCHECK_GE(bit_depth, 8);
+  DCHECK_LE(bit_depth, 12);
+  DCHECK(uv_width_shift == 0 || uv_width_shift == 1);
+  DCHECK(uv_height_shift == 0 || uv_height_shift == 1);
+
+  HighBitDepthYUVToRGBCoefficients coefficients;
+  PopulateHighBitDepthYUVToRGBCoefficients(yuv_to_rgb_matrix, bit_depth,
+                                           &coefficients);
+
+  const uint8_t* y_row = reinterpret_cast<const uint8_t*>(yplane);
+  const uint8_t* u_plane = reinterpret_cast<const uint8_t*>(uplane);
+  const uint8_t* v_plane = reinterpret_cast<const uint8_t*>(vplane);
+  for (int y = 0; y < height; ++y) {
+    const int uv_offset = (y >> uv_height_shift) * uvstride;
+    g_convert_high_bit_depth_yuv_to_argb_row_proc_(
+        reinterpret_cast<const uint16_t*>(y_row),
+        reinterpret_cast<const uint16_t*>(u_plane + uv_offset),
+        reinterpret_cast<const uint16_t*>(v_plane + uv_offset), rgbframe,
+        width, uv_width_shift, &coefficients);
+    y_row += ystride;
+    rgbframe += rgbstride;
+  }
+}
+
 }  // namespace media
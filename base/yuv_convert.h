@@ -10,6 +10,10 @@
 #include "build/build_config.h"
 #include "media/base/media_export.h"
 
+namespace base {
+class TaskRunner;
+}
+
 // Visual Studio 2010 does not support MMX intrinsics on x64.
 // Some win64 yuv_convert code paths use SSE+MMX yasm, so without rewriting
 // them, we use yasm EmptyRegisterState_MMX in place of _mm_empty() or
@@ -73,6 +77,23 @@ MEDIA_EXPORT void ConvertYUVToRGB32(const uint8_t* yplane,
                                     int rgbstride,
                                     YUVType yuv_type);
 
+// Like ConvertYUVToRGB32(), but large frames are split into bands of rows
+// which are converted in parallel by up to |max_tasks| tasks posted to
+// |task_runner| as well as by the calling thread, see RunInParallelRowBands().
+// Returns once the whole frame is converted; the output is identical.
+MEDIA_EXPORT void ConvertYUVToRGB32InRowBands(const uint8_t* yplane,
+                                              const uint8_t* uplane,
+                                              const uint8_t* vplane,
+                                              uint8_t* rgbframe,
+                                              int width,
+                                              int height,
+                                              int ystride,
+                                              int uvstride,
+                                              int rgbstride,
+                                              YUVType yuv_type,
+                                              base::TaskRunner* task_runner,
+                                              int max_tasks);
+
 // Convert a frame of YUVA to 32 bit ARGB.
 // Pass in YV12A
 MEDIA_EXPORT void ConvertYUVAToARGB(const uint8_t* yplane,
@@ -88,6 +109,28 @@ MEDIA_EXPORT void ConvertYUVAToARGB(const uint8_t* yplane,
                                     int rgbstride,
                                     YUVType yuv_type);
 
+// Convert a frame of 9 to 12 bit YUV, each sample in the low bits of a
+// uint16_t, to 32 bit ARGB in one pass.
+// |yuv_to_rgb_matrix| maps normalized Y, U, V and 1 to normalized R, G and B,
+// where samples are normalized by dividing them by 255 << (bit_depth - 8), so
+// that e.g. 10 bit 64 and 940 map to 16 / 255 and 235 / 255. The chroma planes
+// are subsampled by 1 << |uv_width_shift| horizontally and 1 <<
+// |uv_height_shift| vertically. Strides are in bytes.
+MEDIA_EXPORT void ConvertHighBitDepthYUVToARGB(
+    const uint16_t* yplane,
+    const uint16_t* uplane,
+    const uint16_t* vplane,
+    uint8_t* rgbframe,
+    int width,
+    int height,
+    int ystride,
+    int uvstride,
+    int rgbstride,
+    int uv_width_shift,
+    int uv_height_shift,
+    int bit_depth,
+    const double yuv_to_rgb_matrix[3][4]);
+
 // Scale a frame of YUV to 32 bit ARGB.
 // Supports rotation and mirroring.
 MEDIA_EXPORT void ScaleYUVToRGB32(const uint8_t* yplane,
@@ -105,6 +148,27 @@ MEDIA_EXPORT void ScaleYUVToRGB32(const uint8_t* yplane,
                                   Rotate view_rotate,
                                   ScaleFilter filter);
 
+// Like ScaleYUVToRGB32(), but split into bands of destination rows which are
+// scaled in parallel by up to |max_tasks| tasks posted to |task_runner| as
+// well as by the calling thread. Returns once the whole frame is scaled; the
+// output is identical.
+MEDIA_EXPORT void ScaleYUVToRGB32InRowBands(const uint8_t* yplane,
+                                            const uint8_t* uplane,
+                                            const uint8_t* vplane,
+                                            uint8_t* rgbframe,
+                                            int source_width,
+                                            int source_height,
+                                            int width,
+                                            int height,
+                                            int ystride,
+                                            int uvstride,
+                                            int rgbstride,
+                                            YUVType yuv_type,
+                                            Rotate view_rotate,
+                                            ScaleFilter filter,
+                                            base::TaskRunner* task_runner,
+                                            int max_tasks);
+
 // Biliner Scale a frame of YV12 to 32 bits ARGB on a specified rectangle.
 // |yplane|, etc and |rgbframe| should point to the top-left pixels of the
 // source and destination buffers.
@@ -12,6 +12,8 @@
 #include "base/logging.h"
 #include "base/macros.h"
 #include "base/path_service.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/worker_pool.h"
 #include "base/time/time.h"
 #include "build/build_config.h"
 #include "media/base/simd/convert_yuv_to_rgb.h"
@@ -219,4 +221,67 @@ TEST_F(YUVConvertPerfTest, LinearScaleYUVToRGB32Row_SSE) {
 
 #endif  // !defined(ARCH_CPU_ARM_FAMILY) && !defined(ARCH_CPU_MIPS_FAMILY)
 
+// Size of the frames converted in row bands.
+static const int kBandedWidth = 3840;
+static const int kBandedHeight = 2160;
+static const int kBandedIterations = 50;
+
+// Maximum number of threads converting a frame in row bands.
+static const int kMaxBandedThreads = 4;
+
+// Converts a 4K YV12 frame to ARGB on 1 to kMaxBandedThreads threads.
+TEST(YUVConvertBandedPerfTest, ConvertYUVToRGB32InRowBands) {
+  const int y_size = kBandedWidth * kBandedHeight;
+  std::unique_ptr<uint8_t[]> yuv_bytes(new uint8_t[y_size * 3 / 2]);
+  for (int i = 0; i < y_size * 3 / 2; ++i)
+    yuv_bytes[i] = static_cast<uint8_t>(i * 7);
+  std::unique_ptr<uint8_t[]> rgb_bytes(new uint8_t[y_size * 4]);
+
+  for (int threads = 1; threads <= kMaxBandedThreads; ++threads) {
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int i = 0; i < kBandedIterations; ++i) {
+      ConvertYUVToRGB32InRowBands(
+          yuv_bytes.get(), yuv_bytes.get() + y_size,
+          yuv_bytes.get() + y_size * 5 / 4, rgb_bytes.get(), kBandedWidth,
+          kBandedHeight, kBandedWidth, kBandedWidth / 2, kBandedWidth * 4,
+          YV12, base::WorkerPool::GetTaskRunner(true).get(), threads - 1);
+    }
+    double total_time_seconds = (base::TimeTicks::Now() - start).InSecondsF();
+    perf_test::PrintResult(
+        "yuv_convert_perftest", "",
+        base::StringPrintf("ConvertYUVToRGB32InRowBands_%d_threads", threads),
+        kBandedIterations / total_time_seconds, "runs/s", true);
+  }
+}
+
+// Scales a 1080p YV12 frame to a 4K ARGB frame on 1 to kMaxBandedThreads
+// threads.
+TEST(YUVConvertBandedPerfTest, ScaleYUVToRGB32InRowBands) {
+  const int source_width = kBandedWidth / 2;
+  const int source_height = kBandedHeight / 2;
+  const int y_size = source_width * source_height;
+  std::unique_ptr<uint8_t[]> yuv_bytes(new uint8_t[y_size * 3 / 2]);
+  for (int i = 0; i < y_size * 3 / 2; ++i)
+    yuv_bytes[i] = static_cast<uint8_t>(i * 7);
+  std::unique_ptr<uint8_t[]> rgb_bytes(
+      new uint8_t[kBandedWidth * kBandedHeight * 4]);
+
+  for (int threads = 1; threads <= kMaxBandedThreads; ++threads) {
+    base::TimeTicks start = base::TimeTicks::Now();
+    for (int i = 0; i < kBandedIterations; ++i) {
+      ScaleYUVToRGB32InRowBands(
+          yuv_bytes.get(), yuv_bytes.get() + y_size,
+          yuv_bytes.get() + y_size * 5 / 4, rgb_bytes.get(), source_width,
+          source_height, kBandedWidth, kBandedHeight, source_width,
+          source_width / 2, kBandedWidth * 4, YV12, ROTATE_0, FILTER_BILINEAR,
+          base::WorkerPool::GetTaskRunner(true).get(), threads - 1);
+    }
+    double total_time_seconds = (base::TimeTicks::Now() - start).InSecondsF();
+    perf_test::PrintResult(
+        "yuv_convert_perftest", "",
+        base::StringPrintf("ScaleYUVToRGB32InRowBands_%d_threads", threads),
+        kBandedIterations / total_time_seconds, "runs/s", true);
+  }
+}
+
 }  // namespace media
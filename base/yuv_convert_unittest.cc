@@ -14,6 +14,7 @@
 #include "base/files/file_util.h"
 #include "base/logging.h"
 #include "base/path_service.h"
+#include "base/threading/thread.h"
 #include "build/build_config.h"
 #include "media/base/djb2.h"
 #include "media/base/simd/convert_rgb_to_yuv.h"
@@ -132,6 +133,31 @@ TEST(YUVConvertTest, YV12) {
   EXPECT_EQ(2413171226u, rgb_hash);
 }
 
+TEST(YUVConvertTest, YV12InRowBands) {
+  std::unique_ptr<uint8_t[]> yuv_bytes;
+  std::unique_ptr<uint8_t[]> rgb_converted_bytes(
+      new uint8_t[kRGBSizeConverted]);
+  ReadYV12Data(&yuv_bytes);
+
+  base::Thread thread("YV12InRowBands");
+  ASSERT_TRUE(thread.Start());
+
+  // Banding must not change the output.
+  media::ConvertYUVToRGB32InRowBands(
+      yuv_bytes.get(), yuv_bytes.get() + kSourceUOffset,
+      yuv_bytes.get() + kSourceVOffset, rgb_converted_bytes.get(),
+      kSourceWidth, kSourceHeight, kSourceWidth, kSourceWidth / 2,
+      kSourceWidth * kBpp, media::YV12, thread.task_runner().get(), 3);
+
+#if defined(OS_ANDROID)
+  SwapRedAndBlueChannels(rgb_converted_bytes.get(), kRGBSizeConverted);
+#endif
+
+  uint32_t rgb_hash =
+      DJB2Hash(rgb_converted_bytes.get(), kRGBSizeConverted, kDJB2HashSeed);
+  EXPECT_EQ(2413171226u, rgb_hash);
+}
+
 TEST(YUVConvertTest, YV16) {
   // Allocate all surfaces.
   std::unique_ptr<uint8_t[]> yuv_bytes;
@@ -260,6 +286,25 @@ TEST_P(YUVScaleTest, Normal) {
   EXPECT_EQ(GetParam().rgb_hash, rgb_hash);
 }
 
+TEST_P(YUVScaleTest, NormalInRowBands) {
+  base::Thread thread("NormalInRowBands");
+  ASSERT_TRUE(thread.Start());
+
+  // Banding must not change the output.
+  media::ScaleYUVToRGB32InRowBands(
+      y_plane(), u_plane(), v_plane(), rgb_bytes_.get(), kSourceWidth,
+      kSourceHeight, kScaledWidth, kScaledHeight, kSourceWidth,
+      kSourceWidth / 2, kScaledWidth * kBpp, GetParam().yuv_type,
+      media::ROTATE_0, GetParam().scale_filter, thread.task_runner().get(), 3);
+
+#if defined(OS_ANDROID)
+  SwapRedAndBlueChannels(rgb_bytes_.get(), kRGBSizeScaled);
+#endif
+
+  uint32_t rgb_hash = DJB2Hash(rgb_bytes_.get(), kRGBSizeScaled, kDJB2HashSeed);
+  EXPECT_EQ(GetParam().rgb_hash, rgb_hash);
+}
+
 TEST_P(YUVScaleTest, ZeroSourceSize) {
   media::ScaleYUVToRGB32(y_plane(),                    // Y
                          u_plane(),                    // U
@@ -674,6 +719,50 @@ TEST(YUVConvertTest, ConvertYUVToRGB32Row_SSE) {
                       kWidth * kBpp));
 }
 
+TEST(YUVConvertTest, ConvertHighBitDepthYUVToARGBRow_SSE2) {
+  base::CPU cpu;
+  if (!cpu.has_sse2()) {
+    LOG(WARNING) << "System not supported. Test skipped.";
+    return;
+  }
+
+  // Rec. 709 limited range, in terms of normalized samples.
+  const double kRec709Matrix[3][4] = {
+      {1.164, 0.0, 1.793, -0.973},
+      {1.164, -0.213, -0.533, 0.301},
+      {1.164, 2.112, 0.0, -1.133},
+  };
+
+  // Use every bit of the samples to check that the bits above the bit depth
+  // are ignored, and an odd width to exercise the C tail.
+  const int kWidth = 167;
+  std::unique_ptr<uint16_t[]> samples(new uint16_t[kWidth * 3]);
+  for (int i = 0; i < kWidth * 3; ++i)
+    samples[i] = static_cast<uint16_t>(i * 40503u);
+  const uint16_t* y_row = samples.get();
+  const uint16_t* u_row = samples.get() + kWidth;
+  const uint16_t* v_row = samples.get() + kWidth * 2;
+
+  std::unique_ptr<uint8_t[]> rgb_bytes_reference(new uint8_t[kWidth * kBpp]);
+  std::unique_ptr<uint8_t[]> rgb_bytes_converted(new uint8_t[kWidth * kBpp]);
+  for (int bit_depth : {9, 10, 12}) {
+    HighBitDepthYUVToRGBCoefficients coefficients;
+    PopulateHighBitDepthYUVToRGBCoefficients(kRec709Matrix, bit_depth,
+                                             &coefficients);
+    for (int uv_width_shift = 0; uv_width_shift <= 1; ++uv_width_shift) {
+      ConvertHighBitDepthYUVToARGBRow_C(y_row, u_row, v_row,
+                                        rgb_bytes_reference.get(), kWidth,
+                                        uv_width_shift, &coefficients);
+      ConvertHighBitDepthYUVToARGBRow_SSE2(y_row, u_row, v_row,
+                                           rgb_bytes_converted.get(), kWidth,
+                                           uv_width_shift, &coefficients);
+      EXPECT_EQ(0, memcmp(rgb_bytes_reference.get(),
+                          rgb_bytes_converted.get(), kWidth * kBpp))
+          << "bit_depth=" << bit_depth << " uv_width_shift=" << uv_width_shift;
+    }
+  }
+}
+
 // 64-bit release + component builds on Windows are too smart and optimizes
 // away the function being tested.
 #if defined(OS_WIN) && (defined(ARCH_CPU_X86) || !defined(COMPONENT_BUILD))
@@ -2,12 +2,14 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <algorithm>
 #include <utility>
 
 #include "media/blink/multibuffer.h"
 
 #include "base/bind.h"
 #include "base/location.h"
+#include "media/blink/multibuffer_spill_store.h"
 
 namespace media {
 
@@ -18,6 +20,10 @@ enum {
   kBlocksPrunedPerInterval = 80,
 };
 
+// Blocks close to a reader are passed over when freeing blocks. To keep
+// freeing cheap, at most this many blocks are passed over per call.
+const size_t kMaxSparedBlocks = 100;
+
 // Returns the block ID closest to (but less or equal than) |pos| from |index|.
 template <class T>
 static MultiBuffer::BlockId ClosestPreviousEntry(
@@ -53,6 +59,7 @@ static MultiBuffer::BlockId ClosestNextEntry(
 MultiBuffer::GlobalLRU::GlobalLRU(
     const scoped_refptr<base::SingleThreadTaskRunner>& task_runner)
     : max_size_(0),
+      budget_(0),
       data_size_(0),
       background_pruning_pending_(false),
       task_runner_(task_runner) {}
@@ -103,8 +110,25 @@ void MultiBuffer::GlobalLRU::IncrementMaxSize(int64_t blocks) {
   SchedulePrune();
 }
 
+void MultiBuffer::GlobalLRU::SetBudget(int64_t blocks) {
+  DCHECK_GE(blocks, 0);
+  budget_ = blocks;
+  SchedulePrune();
+}
+
+void MultiBuffer::GlobalLRU::SetSpillStore(
+    std::unique_ptr<MultiBufferSpillStore> spill_store) {
+  spill_store_ = std::move(spill_store);
+}
+
+int64_t MultiBuffer::GlobalLRU::EffectiveMaxSize() const {
+  if (budget_)
+    return std::min(max_size_, budget_);
+  return max_size_;
+}
+
 bool MultiBuffer::GlobalLRU::Pruneable() const {
-  return data_size_ > max_size_ && !lru_.Empty();
+  return data_size_ > EffectiveMaxSize() && !lru_.Empty();
 }
 
 void MultiBuffer::GlobalLRU::SchedulePrune() {
@@ -123,19 +147,52 @@ void MultiBuffer::GlobalLRU::PruneTask() {
 }
 
 void MultiBuffer::GlobalLRU::Prune(int64_t max_to_free) {
+  // Blocks over the budget are not subject to the rate limit.
+  if (budget_ && data_size_ > budget_)
+    max_to_free = std::max(max_to_free, data_size_ - budget_);
+  FreeBlocks(std::min(max_to_free, data_size_ - EffectiveMaxSize()), true);
+}
+
+void MultiBuffer::GlobalLRU::TryFree(int64_t max_to_free) {
+  FreeBlocks(max_to_free, false);
+}
+
+void MultiBuffer::GlobalLRU::TryFreeAll() {
+  FreeBlocks(lru_.Size(), false);
+}
+
+void MultiBuffer::GlobalLRU::FreeBlocks(int64_t max_to_free, bool spill) {
   // We group the blocks by multibuffer so that we can free as many blocks as
   // possible in one call. This reduces the number of callbacks to clients
   // when their available ranges change.
   std::map<MultiBuffer*, std::vector<MultiBufferBlockId>> to_free;
+  // Blocks close to a reader are likely to be read again soon, e.g. after a
+  // short seek backwards, so they are only freed if there is nothing else
+  // left to free.
+  std::vector<GlobalBlockId> spared;
   int64_t freed = 0;
-  while (data_size_ - freed > max_size_ && !lru_.Empty() &&
-         freed < max_to_free) {
+  while (freed < max_to_free && !lru_.Empty()) {
     GlobalBlockId block_id = lru_.Pop();
+    if (spared.size() < kMaxSparedBlocks &&
+        block_id.first->IsNearReader(block_id.second)) {
+      spared.push_back(block_id);
+      continue;
+    }
     to_free[block_id.first].push_back(block_id.second);
     freed++;
   }
+  auto spared_block = spared.begin();
+  for (; spared_block != spared.end() && freed < max_to_free; ++spared_block) {
+    to_free[spared_block->first].push_back(spared_block->second);
+    freed++;
+  }
+  // The remaining spared blocks go back to the LRU as its most recently used
+  // blocks, in their original order.
+  for (; spared_block != spared.end(); ++spared_block)
+    lru_.Insert(*spared_block);
+
   for (const auto& to_free_pair : to_free) {
-    to_free_pair.first->ReleaseBlocks(to_free_pair.second);
+    to_free_pair.first->ReleaseBlocks(to_free_pair.second, spill);
   }
 }
 
@@ -148,7 +205,10 @@ int64_t MultiBuffer::GlobalLRU::Size() const {
 //
 MultiBuffer::MultiBuffer(int32_t block_size_shift,
                          const scoped_refptr<GlobalLRU>& global_lru)
-    : max_size_(0), block_size_shift_(block_size_shift), lru_(global_lru) {}
+    : max_size_(0),
+      block_size_shift_(block_size_shift),
+      lru_(global_lru),
+      weak_factory_(this) {}
 
 MultiBuffer::~MultiBuffer() {
   CHECK(pinned_.empty());
@@ -157,6 +217,8 @@ MultiBuffer::~MultiBuffer() {
   for (const auto& i : data_) {
     lru_->Remove(this, i.first);
   }
+  if (lru_->spill_store())
+    lru_->spill_store()->RemoveAll(this);
   lru_->IncrementDataSize(-static_cast<int64_t>(data_.size()));
   lru_->IncrementMaxSize(-max_size_);
 }
@@ -170,6 +232,10 @@ void MultiBuffer::AddReader(const BlockId& pos, Reader* reader) {
     return;
   }
 
+  // Spilled blocks are read back rather than fetched again.
+  if (TryRestore(pos))
+    return;
+
   // We may need to create a new data provider to service this request.
   // Look for an existing data provider first.
   DataProvider* provider = nullptr;
@@ -250,12 +316,18 @@ void MultiBuffer::NotifyAvailableRange(
   }
 }
 
-void MultiBuffer::ReleaseBlocks(const std::vector<MultiBufferBlockId>& blocks) {
+void MultiBuffer::ReleaseBlocks(const std::vector<MultiBufferBlockId>& blocks,
+                                bool spill) {
+  MultiBufferSpillStore* spill_store = spill ? lru_->spill_store() : nullptr;
   IntervalMap<BlockId, int32_t> freed;
   for (MultiBufferBlockId to_free : blocks) {
     DCHECK(data_[to_free]);
     DCHECK_EQ(pinned_[to_free], 0);
     DCHECK_EQ(present_[to_free], 1);
+    if (spill_store) {
+      spill_store->Spill(MultiBufferGlobalBlockId(this, to_free),
+                         data_[to_free]);
+    }
     data_.erase(to_free);
     freed.IncrementInterval(to_free, to_free + 1, 1);
     present_.IncrementInterval(to_free, to_free + 1, -1);
@@ -297,6 +369,71 @@ void MultiBuffer::ReleaseBlocks(const std::vector<MultiBufferBlockId>& blocks) {
     OnEmpty();
 }
 
+bool MultiBuffer::IsNearReader(const BlockId& pos) const {
+  MultiBufferBlockId next_reader_pos = ClosestNextEntry(readers_, pos);
+  if (next_reader_pos != std::numeric_limits<MultiBufferBlockId>::max() &&
+      next_reader_pos - pos <= kMaxWaitForReaderOffset) {
+    return true;
+  }
+  MultiBufferBlockId previous_reader_pos = ClosestPreviousEntry(readers_, pos);
+  if (previous_reader_pos == std::numeric_limits<MultiBufferBlockId>::min())
+    return false;
+  return pos - previous_reader_pos <= kMaxWaitForWriterOffset;
+}
+
+bool MultiBuffer::TryRestore(const BlockId& pos) {
+  if (restoring_[pos])
+    return true;
+  MultiBufferSpillStore* spill_store = lru_->spill_store();
+  if (!spill_store ||
+      !spill_store->Contains(MultiBufferGlobalBlockId(this, pos))) {
+    return false;
+  }
+
+  // Readers usually go on reading, so restore the spilled blocks following
+  // |pos| as well. Read completions arrive in order.
+  BlockId end = pos;
+  while (end - pos < kMaxWaitForReaderOffset && !Contains(end) &&
+         spill_store->Contains(MultiBufferGlobalBlockId(this, end))) {
+    spill_store->Restore(MultiBufferGlobalBlockId(this, end),
+                         base::Bind(&MultiBuffer::OnBlockRestored,
+                                    weak_factory_.GetWeakPtr(), end));
+    ++end;
+  }
+  restoring_.SetInterval(pos, end, 1);
+  return true;
+}
+
+void MultiBuffer::OnBlockRestored(const BlockId& pos,
+                                  const scoped_refptr<DataBuffer>& data) {
+  restoring_.SetInterval(pos, pos + 1, 0);
+  if (!data) {
+    // Fetch the block for the readers waiting for it instead.
+    auto i = readers_.find(pos);
+    if (i == readers_.end())
+      return;
+    std::set<Reader*> readers;
+    readers.swap(i->second);
+    readers_.erase(i);
+    for (Reader* reader : readers)
+      AddReader(pos, reader);
+    return;
+  }
+
+  // A data provider may have provided the block in the meantime.
+  if (Contains(pos))
+    return;
+
+  data_[pos] = data;
+  if (!pinned_[pos])
+    lru_->Use(this, pos);
+  present_.SetInterval(pos, pos + 1, 1);
+  Interval<BlockId> expanded_range = present_.find(pos).interval();
+  NotifyAvailableRange(expanded_range, expanded_range);
+  lru_->IncrementDataSize(1);
+  Prune(kMaxFreesPerAdd + 1);
+}
+
 void MultiBuffer::OnEmpty() {}
 
 void MultiBuffer::AddProvider(std::unique_ptr<DataProvider> provider) {
@@ -368,6 +505,7 @@ void MultiBuffer::OnDataProviderEvent(DataProvider* provider_tmp) {
   BlockId pos = start_pos;
   bool eof = false;
   int64_t blocks_before = data_.size();
+  MultiBufferSpillStore* spill_store = lru_->spill_store();
 
   while (!ProviderCollision(pos) && !eof) {
     if (!provider->Available()) {
@@ -377,6 +515,8 @@ void MultiBuffer::OnDataProviderEvent(DataProvider* provider_tmp) {
     DCHECK_GE(pos, 0);
     scoped_refptr<DataBuffer> data = provider->Read();
     data_[pos] = data;
+    if (spill_store)
+      spill_store->Remove(MultiBufferGlobalBlockId(this, pos));
     eof = data->end_of_stream();
     if (!pinned_[pos])
       lru_->Use(this, pos);
@@ -19,6 +19,7 @@
 #include "base/hash.h"
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
 #include "base/single_thread_task_runner.h"
 #include "build/build_config.h"
 #include "media/base/data_buffer.h"
@@ -33,6 +34,7 @@ namespace media {
 // is 1 << (15 + 31) = 64Tb
 typedef int32_t MultiBufferBlockId;
 class MultiBuffer;
+class MultiBufferSpillStore;
 
 // This type is used to identify a block in the LRU, which is shared between
 // multibuffers.
@@ -81,7 +83,6 @@ const int kMaxWaitForReaderOffset = 50;
 // size.
 //
 // Users should inherit this class and implement CreateWriter().
-// TODO(hubbe): Make the multibuffer respond to memory pressure.
 class MEDIA_BLINK_EXPORT MultiBuffer {
  public:
   // Interface for clients wishing to read data out of this cache.
@@ -132,7 +133,12 @@ class MEDIA_BLINK_EXPORT MultiBuffer {
 
   // Multibuffers use a global shared LRU to free memory.
   // This effectively means that recently used multibuffers can
-  // borrow memory from less recently used ones.
+  // borrow memory from less recently used ones. "Global" means shared by the
+  // multibuffers which use the same instance, e.g. those of every UrlIndex
+  // with the same block size.
+  // Blocks close to a reader are freed after other blocks, and blocks pruned
+  // to keep within the cache size are written to the spill store, if there is
+  // one, so that they can be restored without fetching them again.
   class MEDIA_BLINK_EXPORT GlobalLRU : public base::RefCounted<GlobalLRU> {
    public:
     typedef MultiBufferGlobalBlockId GlobalBlockId;
@@ -140,10 +146,25 @@ class MEDIA_BLINK_EXPORT MultiBuffer {
         const scoped_refptr<base::SingleThreadTaskRunner>& task_runner);
 
     // Free elements from cache if needed and possible.
-    // Don't free more than |max_to_free| blocks.
+    // Don't free more than |max_to_free| blocks, unless more blocks
+    // than the budget are in use.
     // Virtual for testing purposes.
     void Prune(int64_t max_to_free);
 
+    // Free up to |max_to_free| blocks, even if the cache isn't full.
+    // Used to respond to memory pressure, so the blocks are dropped rather
+    // than spilled: spilling would keep them in memory until written.
+    void TryFree(int64_t max_to_free);
+
+    // Free all blocks which are not pinned, without spilling them.
+    void TryFreeAll();
+
+    // Caps the number of blocks used by all multibuffers, no matter how
+    // much memory has been registered with IncrementMaxSize(). Blocks over
+    // the budget are freed as soon as they are added; only pinned blocks
+    // can exceed it. Zero means no budget.
+    void SetBudget(int64_t blocks);
+
     // Returns true if there are prunable blocks.
     bool Pruneable() const;
 
@@ -165,10 +186,21 @@ class MEDIA_BLINK_EXPORT MultiBuffer {
     bool Contains(MultiBuffer* multibuffer, MultiBufferBlockId id);
     int64_t Size() const;
 
+    // Pruned blocks are spilled to |spill_store|, which may be null.
+    void SetSpillStore(std::unique_ptr<MultiBufferSpillStore> spill_store);
+    MultiBufferSpillStore* spill_store() const { return spill_store_.get(); }
+
    private:
     friend class base::RefCounted<GlobalLRU>;
     ~GlobalLRU();
 
+    // Returns the number of blocks the cache may hold before pruning.
+    int64_t EffectiveMaxSize() const;
+
+    // Free up to |max_to_free| blocks from the LRU, spilling them to the
+    // spill store, if there is one, if |spill| is true.
+    void FreeBlocks(int64_t max_to_free, bool spill);
+
     // Schedule background pruning, if needed.
     void SchedulePrune();
 
@@ -178,6 +210,9 @@ class MEDIA_BLINK_EXPORT MultiBuffer {
     // Max number of blocks.
     int64_t max_size_;
 
+    // Hard cap on the number of blocks, zero if there is none.
+    int64_t budget_;
+
     // Sum of all multibuffer::data_.size().
     int64_t data_size_;
 
@@ -191,6 +226,8 @@ class MEDIA_BLINK_EXPORT MultiBuffer {
     // Where we run our tasks.
     scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
 
+    std::unique_ptr<MultiBufferSpillStore> spill_store_;
+
     DISALLOW_COPY_AND_ASSIGN(GlobalLRU);
   };
 
@@ -305,8 +342,23 @@ class MEDIA_BLINK_EXPORT MultiBuffer {
   virtual void Prune(size_t max_to_free);
 
   // Remove the given blocks from the multibuffer, called from
-  // GlobalLRU::Prune().
-  void ReleaseBlocks(const std::vector<MultiBufferBlockId>& blocks);
+  // GlobalLRU::Prune(). If |spill| is true they are written to the spill
+  // store, if there is one.
+  void ReleaseBlocks(const std::vector<MultiBufferBlockId>& blocks,
+                     bool spill);
+
+  // Returns true if |pos| is in the look-behind or look-ahead region of a
+  // reader, which makes it likely to be read soon.
+  bool IsNearReader(const BlockId& pos) const;
+
+  // Starts restoring the spilled blocks at and after |pos|. Returns false if
+  // block |pos| is neither spilled nor being restored.
+  bool TryRestore(const BlockId& pos);
+
+  // Called when spilled block |pos| has been read back. |data| is null if
+  // that failed.
+  void OnBlockRestored(const BlockId& pos,
+                       const scoped_refptr<DataBuffer>& data);
 
   // Figure out what state a writer at |pos| should be in.
   ProviderState SuggestProviderState(const BlockId& pos) const;
@@ -349,6 +401,12 @@ class MEDIA_BLINK_EXPORT MultiBuffer {
   // ranges of available/unavailable blocks without iterating.
   IntervalMap<BlockId, int32_t> present_;
 
+  // restoring_[block] is 1 for all blocks being read back from the spill
+  // store, and 0 for all others.
+  IntervalMap<BlockId, int32_t> restoring_;
+
+  base::WeakPtrFactory<MultiBuffer> weak_factory_;
+
   DISALLOW_COPY_AND_ASSIGN(MultiBuffer);
 };
 
@@ -4,6 +4,9 @@
 
 #include "media/blink/multibuffer_data_source.h"
 
+#include <stdlib.h>
+
+#include <algorithm>
 #include <utility>
 
 #include "base/bind.h"
@@ -48,6 +51,35 @@ const int64_t kTargetSecondsBufferedAhead = 10;
 // Keep this many seconds of data for going back by default.
 const int64_t kTargetSecondsBufferedBehind = 2;
 
+// When data arrives slower than it is played, preload enough to keep
+// playing for this many seconds before running out of data.
+const int64_t kTargetSecondsToStall = 30;
+
+// Only count on this fraction of the measured download throughput, as it
+// varies over time.
+const double kThroughputSafetyFactor = 0.75;
+
+// Maximum preload buffer when data arrives slower than it is played.
+const int64_t kMaxBufferPreloadWhenStalling = 100 << 20;  // 100 Mb
+
+// Update the buffer sizes every this many progress callbacks, so that they
+// follow changes in the download throughput.
+const int kUpdateBufferSizeFrequency = 32;
+
+// Reads which jump at least this far from the current position are
+// treated as seeks.
+const int64_t kMinSeekDistance = 1 << 20;  // 1 Mb
+
+// Two seeks are assumed to follow a pattern, like a user repeatedly
+// skipping ahead, if their distances differ by at most this fraction.
+const double kSeekDistanceTolerance = 0.25;
+
+// Prefetch this much around the predicted target of the next seek. Seeks
+// land on the keyframe before the target, so some data before it is
+// prefetched as well.
+const int64_t kSeekPrefetchBehind = 256 << 10;  // 256 Kb
+const int64_t kSeekPrefetchAhead = 2 << 20;     // 2 Mb
+
 }  // namespace
 
 namespace media {
@@ -119,6 +151,7 @@ MultibufferDataSource::MultibufferDataSource(
       render_task_runner_(task_runner),
       url_index_(url_index),
       frame_(frame),
+      last_seek_distance_(0),
       stop_signal_received_(false),
       media_has_played_(false),
       buffering_strategy_(BUFFERING_STRATEGY_NORMAL),
@@ -127,6 +160,7 @@ MultibufferDataSource::MultibufferDataSource(
       preload_(AUTO),
       bitrate_(0),
       playback_rate_(0.0),
+      buffer_size_update_counter_(0),
       media_log_(media_log),
       host_(host),
       downloading_cb_(downloading_cb),
@@ -212,6 +246,7 @@ void MultibufferDataSource::OnRedirect(
     single_origin_ = false;
   }
   reader_.reset(nullptr);
+  seek_prefetch_reader_.reset();
   url_data_ = destination;
 
   if (url_data_) {
@@ -397,7 +432,10 @@ void MultibufferDataSource::ReadTask() {
   if (!reader_) {
     CreateResourceLoader(read_op_->position(), kPositionNotSpecified);
   } else {
+    int64_t distance = read_op_->position() - reader_->Tell();
     reader_->Seek(read_op_->position());
+    if (std::abs(distance) >= kMinSeekDistance)
+      OnSeek(distance);
   }
 
   int64_t available = reader_->Available();
@@ -446,6 +484,7 @@ void MultibufferDataSource::StopInternal_Locked() {
 void MultibufferDataSource::StopLoader() {
   DCHECK(render_task_runner_->BelongsToCurrentThread());
   reader_.reset(nullptr);
+  seek_prefetch_reader_.reset();
 }
 
 void MultibufferDataSource::SetBitrateTask(int bitrate) {
@@ -525,6 +564,11 @@ void MultibufferDataSource::ProgressCallback(int64_t begin, int64_t end) {
   if (assume_fully_buffered())
     return;
 
+  if (++buffer_size_update_counter_ >= kUpdateBufferSizeFrequency) {
+    buffer_size_update_counter_ = 0;
+    UpdateBufferSizes();
+  }
+
   base::AutoLock auto_lock(lock_);
 
   if (end > begin) {
@@ -607,8 +651,25 @@ void MultibufferDataSource::UpdateBufferSizes() {
   int64_t bytes_per_second = (bitrate / 8.0) * playback_rate;
 
   // Preload 10 seconds of data, clamped to some min/max value.
-  int64_t preload = clamp(kTargetSecondsBufferedAhead * bytes_per_second,
-                          kMinBufferPreload, kMaxBufferPreload);
+  int64_t preload_target = kTargetSecondsBufferedAhead * bytes_per_second;
+  int64_t preload = clamp(preload_target, kMinBufferPreload, kMaxBufferPreload);
+
+  // If data arrives slower than we play it, we run out of data once the
+  // preloaded data has been played. Preload enough to put that off for
+  // kTargetSecondsToStall.
+  int64_t throughput = url_data_->DownloadBytesPerSecond();
+  if (throughput) {
+    int64_t deficit =
+        bytes_per_second -
+        static_cast<int64_t>(throughput * kThroughputSafetyFactor);
+    if (deficit > 0) {
+      int64_t stall_preload = std::min(kTargetSecondsToStall * deficit,
+                                       kMaxBufferPreloadWhenStalling);
+      preload_target = std::max(preload_target, stall_preload);
+      preload = std::max(preload, stall_preload);
+    }
+  }
+
   // We preload this much, then we stop unil we read |preload| before resuming.
   int64_t preload_high = preload + kPreloadHighExtra;
 
@@ -622,14 +683,15 @@ void MultibufferDataSource::UpdateBufferSizes() {
   // away right before we need it.
   int64_t pin_forward = std::max(preload_high, kDefaultPinSize);
 
+  // The buffer holds the data we aim to preload, and a few seconds behind the
+  // reading position, so that preloaded data isn't pruned before it's read.
   // Note that the buffer size is advisory as only non-pinned data is allowed
   // to be thrown away. Most of the time we pin a region that is larger than
   // |buffer_size|, which only makes sense because most of the time, some of
   // the data in pinned region is not present in the cache.
-  int64_t buffer_size =
-      std::min((kTargetSecondsBufferedAhead + kTargetSecondsBufferedBehind) *
-                   bytes_per_second,
-               preload_high + pin_backward);
+  int64_t buffer_size = std::min(
+      preload_target + kTargetSecondsBufferedBehind * bytes_per_second,
+      preload_high + pin_backward);
   reader_->SetMaxBuffer(buffer_size);
   reader_->SetPinRange(pin_backward, pin_forward);
 
@@ -640,4 +702,40 @@ void MultibufferDataSource::UpdateBufferSizes() {
   }
 }
 
+void MultibufferDataSource::OnSeek(int64_t distance) {
+  DCHECK(render_task_runner_->BelongsToCurrentThread());
+  DCHECK(reader_);
+  int64_t last_distance = last_seek_distance_;
+  last_seek_distance_ = distance;
+
+  // We just got to the data we prefetched, or guessed wrong.
+  seek_prefetch_reader_.reset();
+
+  // Prefetching needs range requests, and isn't worth it unless we are
+  // going to play.
+  if (preload_ == METADATA || IsStreaming() || !url_data_->range_supported())
+    return;
+  if ((distance > 0) != (last_distance > 0) ||
+      std::abs(distance - last_distance) >
+          std::abs(last_distance) * kSeekDistanceTolerance) {
+    return;
+  }
+
+  int64_t target = reader_->Tell() + distance;
+  if (target < 0 ||
+      (url_data_->length() != kPositionNotSpecified &&
+       target >= url_data_->length())) {
+    return;
+  }
+  int64_t start = std::max<int64_t>(target - kSeekPrefetchBehind, 0);
+  int64_t end = target + kSeekPrefetchAhead;
+  DVLOG(1) << __func__ << " prefetching " << start << " - " << end;
+  seek_prefetch_reader_.reset(new MultiBufferReader(
+      url_data_->multibuffer(), start, end,
+      base::Callback<void(int64_t, int64_t)>()));
+  seek_prefetch_reader_->SetMaxBuffer(end - start);
+  seek_prefetch_reader_->SetPinRange(0, end - start);
+  seek_prefetch_reader_->SetPreload(end - start, end - start);
+}
+
 }  // namespace media
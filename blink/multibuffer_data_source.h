@@ -174,6 +174,11 @@ class MEDIA_BLINK_EXPORT MultibufferDataSource : public DataSource {
   // Update |reader_|'s preload and buffer settings.
   void UpdateBufferSizes();
 
+  // Called after |reader_| seeked |distance| bytes to serve a read. Starts
+  // prefetching around the next seek target if the recent seeks follow a
+  // pattern.
+  void OnSeek(int64_t distance);
+
   // crossorigin attribute on the corresponding HTML media element, if any.
   UrlData::CORSMode cors_mode_;
 
@@ -208,6 +213,12 @@ class MEDIA_BLINK_EXPORT MultibufferDataSource : public DataSource {
   // A resource reader for the media resource.
   std::unique_ptr<MultiBufferReader> reader_;
 
+  // Preloads data around the predicted next seek target, see OnSeek().
+  std::unique_ptr<MultiBufferReader> seek_prefetch_reader_;
+
+  // Distance of the last seek, 0 if there hasn't been one.
+  int64_t last_seek_distance_;
+
   // Callback method from the pipeline for initialization.
   InitializeCB init_cb_;
 
@@ -246,6 +257,9 @@ class MEDIA_BLINK_EXPORT MultibufferDataSource : public DataSource {
   // Current playback rate.
   double playback_rate_;
 
+  // Number of progress callbacks since the buffer sizes were last updated.
+  int buffer_size_update_counter_;
+
   scoped_refptr<MediaLog> media_log_;
 
   // Host object to report buffered byte range changes to.
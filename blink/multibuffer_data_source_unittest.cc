@@ -10,6 +10,7 @@
 #include "base/message_loop/message_loop.h"
 #include "base/run_loop.h"
 #include "base/strings/string_number_conversions.h"
+#include "base/test/simple_test_tick_clock.h"
 #include "media/base/media_log.h"
 #include "media/base/mock_filters.h"
 #include "media/base/test_helpers.h"
@@ -25,6 +26,7 @@
 #include "third_party/WebKit/public/web/WebView.h"
 
 using ::testing::_;
+using ::testing::AnyNumber;
 using ::testing::Assign;
 using ::testing::DoAll;
 using ::testing::Invoke;
@@ -331,6 +333,17 @@ class MultibufferDataSourceTest : public testing::Test {
     base::RunLoop().RunUntilIdle();
   }
 
+  // Receives |size| bytes in kDataSize chunks, as fast as a network with the
+  // given throughput would deliver them.
+  void ReceiveDataAtRate(int64_t size, int64_t bytes_per_second) {
+    for (int64_t received = 0; received < size; received += kDataSize) {
+      clock_.Advance(base::TimeDelta::FromMicroseconds(
+          kDataSize * base::Time::kMicrosecondsPerSecond / bytes_per_second));
+      ReceiveDataLow(kDataSize);
+    }
+    base::RunLoop().RunUntilIdle();
+  }
+
   void FinishLoading() {
     EXPECT_TRUE(url_loader());
     if (!url_loader())
@@ -423,6 +436,9 @@ class MultibufferDataSourceTest : public testing::Test {
 
   // Accessors for private variables on |data_source_|.
   MultiBufferReader* loader() { return data_source_->reader_.get(); }
+  MultiBufferReader* seek_prefetch_reader() {
+    return data_source_->seek_prefetch_reader_.get();
+  }
 
   TestResourceMultiBuffer* multibuffer() {
     return url_index_->last_url_data()->test_multibuffer();
@@ -491,6 +507,8 @@ class MultibufferDataSourceTest : public testing::Test {
 
   StrictMock<MockBufferedDataSourceHost> host_;
 
+  base::SimpleTestTickClock clock_;
+
   // Used for calling MultibufferDataSource::Read().
   uint8_t buffer_[kDataSize * 2];
 
@@ -1598,6 +1616,73 @@ TEST_F(MultibufferDataSourceTest, CheckBufferSizes) {
   EXPECT_EQ(71 << 20, buffer_size());
 }
 
+TEST_F(MultibufferDataSourceTest, PreloadFollowsThroughput) {
+  Initialize(kHttpUrl, true);
+  url_data()->set_tick_clock_for_testing(&clock_);
+  EXPECT_CALL(host_, SetTotalBytes(response_generator_->content_length()));
+  EXPECT_CALL(host_, AddBufferedByteRange(_, _)).Times(AnyNumber());
+  Respond(response_generator_->Generate206(0));
+
+  // At 512 kb/s, 8 mbit/s content is played faster than it's downloaded.
+  // Preload enough that playback lasts 30 seconds before it runs out of data,
+  // which is more than the usual 10 seconds of data.
+  ReceiveDataAtRate(1 << 20, 512 << 10);
+  data_source_->SetBitrate(8 << 20);
+  base::RunLoop().RunUntilIdle();
+  const int64_t kDeficit = (1 << 20) - (512 << 10) * 3 / 4;
+  EXPECT_EQ(30 * kDeficit, preload_low());
+  EXPECT_EQ(30 * kDeficit + (1 << 20), preload_high());
+  // The cache keeps all of that, and 2 seconds behind the read position.
+  EXPECT_EQ(30 * kDeficit + (2 << 20), buffer_size());
+
+  // Once the network speeds up, the usual preload is enough.
+  ReceiveDataAtRate(3 << 20, 4 << 20);
+  data_source_->SetBitrate(8 << 20);
+  base::RunLoop().RunUntilIdle();
+  EXPECT_EQ(10 << 20, preload_low());
+  EXPECT_EQ(11 << 20, preload_high());
+  EXPECT_EQ(12 << 20, buffer_size());
+
+  Stop();
+}
+
+TEST_F(MultibufferDataSourceTest, PrefetchesPredictedSeekTarget) {
+  InitializeWith206Response();
+  EXPECT_CALL(host_, AddBufferedByteRange(_, _)).Times(AnyNumber());
+  const int64_t kSeekDistance = kDataSize * 40;
+
+  // A single seek doesn't make a pattern.
+  int64_t position = kSeekDistance;
+  EXPECT_CALL(*this, ReadCallback(kDataSize));
+  ReadAt(position);
+  Respond(response_generator_->Generate206(position));
+  ReceiveData(kDataSize);
+  EXPECT_FALSE(seek_prefetch_reader());
+
+  // Seeking the same distance again, we expect another seek like it and
+  // prefetch around its target.
+  position += kDataSize + kSeekDistance;
+  ReadAt(position);
+  ASSERT_TRUE(seek_prefetch_reader());
+  const int64_t kPrefetchStart = position + kSeekDistance - (256 << 10);
+  EXPECT_EQ(kPrefetchStart, seek_prefetch_reader()->Tell());
+
+  // One provider loads the data for the pending read, the other one the
+  // prefetched data.
+  EXPECT_EQ(2U, test_data_providers.size());
+  bool prefetching = false;
+  for (TestMultiBufferDataProvider* provider : test_data_providers) {
+    prefetching |= provider->Tell() == kPrefetchStart / kDataSize &&
+                   provider->loading();
+  }
+  EXPECT_TRUE(prefetching);
+
+  EXPECT_CALL(*this, ReadCallback(media::DataSource::kReadError));
+  data_source_->Stop();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_FALSE(seek_prefetch_reader());
+}
+
 // Provoke an edge case where the loading state may not end up transitioning
 // back to "idle" when we're done loading.
 TEST_F(MultibufferDataSourceTest, Http_CheckLoadingTransition) {
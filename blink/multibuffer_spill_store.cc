@@ -0,0 +1,153 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/blink/multibuffer_spill_store.h"
+
+#include <utility>
+
+#include "base/bind.h"
+#include "base/location.h"
+#include "base/logging.h"
+#include "base/task_runner_util.h"
+
+namespace media {
+
+// Owns the file blocks are spilled to. Only used on the file task runner.
+class MultiBufferSpillStore::SpillFile {
+ public:
+  explicit SpillFile(base::File file)
+      : file_(std::move(file)), failed_(false) {}
+
+  void Write(int64_t offset, const scoped_refptr<DataBuffer>& data) {
+    if (failed_)
+      return;
+    int written = file_.Write(offset,
+                              reinterpret_cast<const char*>(data->data()),
+                              data->data_size());
+    // A partially written block may be read back later, so stop using the
+    // file altogether.
+    if (written != data->data_size()) {
+      DLOG(ERROR) << "Failed to spill multibuffer block";
+      failed_ = true;
+    }
+  }
+
+  scoped_refptr<DataBuffer> Read(int64_t offset, int size) {
+    if (failed_)
+      return nullptr;
+    scoped_refptr<DataBuffer> data(new DataBuffer(size));
+    if (file_.Read(offset, reinterpret_cast<char*>(data->writable_data()),
+                   size) != size) {
+      return nullptr;
+    }
+    data->set_data_size(size);
+    return data;
+  }
+
+ private:
+  base::File file_;
+  bool failed_;
+
+  DISALLOW_COPY_AND_ASSIGN(SpillFile);
+};
+
+MultiBufferSpillStore::MultiBufferSpillStore(
+    base::File file,
+    int32_t block_size_shift,
+    int64_t max_blocks,
+    const scoped_refptr<base::SequencedTaskRunner>& file_task_runner)
+    : block_size_shift_(block_size_shift),
+      max_blocks_(max_blocks),
+      next_slot_(0),
+      file_(new SpillFile(std::move(file))),
+      file_task_runner_(file_task_runner) {
+  DCHECK_GE(max_blocks_, 0);
+}
+
+MultiBufferSpillStore::~MultiBufferSpillStore() {
+  file_task_runner_->DeleteSoon(FROM_HERE, file_);
+}
+
+void MultiBufferSpillStore::Spill(const GlobalBlockId& id,
+                                  const scoped_refptr<DataBuffer>& data) {
+  if (data->end_of_stream() || data->data_size() == 0 ||
+      data->data_size() > (1 << block_size_shift_) || max_blocks_ == 0) {
+    return;
+  }
+  if (Contains(id))
+    Release(id);
+
+  Entry entry;
+  entry.slot = AllocateSlot();
+  entry.size = data->data_size();
+  entries_[id] = entry;
+  lru_.Insert(id);
+
+  // DataBuffers are not modified once they are in a multibuffer, so the
+  // block can be written without copying it.
+  file_task_runner_->PostTask(
+      FROM_HERE,
+      base::Bind(&SpillFile::Write, base::Unretained(file_),
+                 entry.slot << block_size_shift_, data));
+}
+
+bool MultiBufferSpillStore::Contains(const GlobalBlockId& id) const {
+  return entries_.find(id) != entries_.end();
+}
+
+void MultiBufferSpillStore::Restore(const GlobalBlockId& id,
+                                    const RestoreCB& restore_cb) {
+  auto i = entries_.find(id);
+  DCHECK(i != entries_.end());
+  const Entry entry = i->second;
+  Release(id);
+
+  // The slot may be reused right away: the read is sequenced before any
+  // write to it.
+  base::PostTaskAndReplyWithResult(
+      file_task_runner_.get(), FROM_HERE,
+      base::Bind(&SpillFile::Read, base::Unretained(file_),
+                 entry.slot << block_size_shift_, entry.size),
+      restore_cb);
+}
+
+void MultiBufferSpillStore::Remove(const GlobalBlockId& id) {
+  if (Contains(id))
+    Release(id);
+}
+
+void MultiBufferSpillStore::RemoveAll(MultiBuffer* multibuffer) {
+  std::vector<GlobalBlockId> to_remove;
+  for (const auto& entry : entries_) {
+    if (entry.first.first == multibuffer)
+      to_remove.push_back(entry.first);
+  }
+  for (const GlobalBlockId& id : to_remove)
+    Release(id);
+}
+
+int64_t MultiBufferSpillStore::Size() const {
+  return entries_.size();
+}
+
+int64_t MultiBufferSpillStore::AllocateSlot() {
+  if (free_slots_.empty()) {
+    if (next_slot_ < max_blocks_)
+      return next_slot_++;
+    Release(lru_.Peek());
+  }
+  int64_t slot = free_slots_.back();
+  free_slots_.pop_back();
+  return slot;
+}
+
+void MultiBufferSpillStore::Release(const GlobalBlockId& id) {
+  auto i = entries_.find(id);
+  DCHECK(i != entries_.end());
+  free_slots_.push_back(i->second.slot);
+  entries_.erase(i);
+  lru_.Remove(id);
+}
+
+}  // namespace media
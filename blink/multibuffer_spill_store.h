@@ -0,0 +1,105 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_BLINK_MULTIBUFFER_SPILL_STORE_H_
+#define MEDIA_BLINK_MULTIBUFFER_SPILL_STORE_H_
+
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/containers/hash_tables.h"
+#include "base/files/file.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/sequenced_task_runner.h"
+#include "media/base/data_buffer.h"
+#include "media/blink/lru.h"
+#include "media/blink/media_blink_export.h"
+#include "media/blink/multibuffer.h"
+
+namespace media {
+
+// Keeps blocks evicted from multibuffers in a file, so that a multibuffer can
+// restore them instead of fetching them again when a reader comes back to
+// them, e.g. after seeking back into a region that was already played.
+//
+// The file is divided into slots of one block each. When all slots are in
+// use, the block which was spilled the longest time ago is dropped to make
+// room. Reads and writes happen on |file_task_runner|, everything else on the
+// thread the multibuffers live on.
+class MEDIA_BLINK_EXPORT MultiBufferSpillStore {
+ public:
+  typedef MultiBufferGlobalBlockId GlobalBlockId;
+  typedef base::Callback<void(const scoped_refptr<DataBuffer>&)> RestoreCB;
+
+  // |file| must be opened for reading and writing. The store uses at most
+  // |max_blocks| slots of 1 << |block_size_shift| bytes.
+  MultiBufferSpillStore(
+      base::File file,
+      int32_t block_size_shift,
+      int64_t max_blocks,
+      const scoped_refptr<base::SequencedTaskRunner>& file_task_runner);
+  ~MultiBufferSpillStore();
+
+  // Writes a copy of |data| to the store. End of stream blocks and blocks
+  // larger than a slot are not stored.
+  void Spill(const GlobalBlockId& id, const scoped_refptr<DataBuffer>& data);
+
+  // Returns true if block |id| can be restored.
+  bool Contains(const GlobalBlockId& id) const;
+
+  // Reads block |id| back and removes it from the store. |restore_cb| is run
+  // on the calling thread with the block, or with null if it couldn't be
+  // read. |id| must be in the store.
+  void Restore(const GlobalBlockId& id, const RestoreCB& restore_cb);
+
+  // Removes block |id| from the store, if it's there.
+  void Remove(const GlobalBlockId& id);
+
+  // Removes all blocks of |multibuffer| from the store.
+  void RemoveAll(MultiBuffer* multibuffer);
+
+  // Returns the number of blocks in the store.
+  int64_t Size() const;
+
+ private:
+  class SpillFile;
+
+  struct Entry {
+    int64_t slot;
+    int size;
+  };
+
+  // Returns a free slot, dropping the oldest block if there is none.
+  int64_t AllocateSlot();
+
+  // Forgets block |id| and frees its slot. |id| must be in the store.
+  void Release(const GlobalBlockId& id);
+
+  const int32_t block_size_shift_;
+  const int64_t max_blocks_;
+
+  // Slots which were used before and are free again. Slots at or after
+  // |next_slot_| have never been used.
+  std::vector<int64_t> free_slots_;
+  int64_t next_slot_;
+
+  base::hash_map<GlobalBlockId, Entry> entries_;
+
+  // All blocks in the store, in the order they were spilled.
+  LRU<GlobalBlockId> lru_;
+
+  // Owned, and deleted on |file_task_runner_|.
+  SpillFile* file_;
+  scoped_refptr<base::SequencedTaskRunner> file_task_runner_;
+
+  DISALLOW_COPY_AND_ASSIGN(MultiBufferSpillStore);
+};
+
+}  // namespace media
+
+#endif  // MEDIA_BLINK_MULTIBUFFER_SPILL_STORE_H_
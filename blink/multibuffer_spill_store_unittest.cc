@@ -0,0 +1,177 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdint.h>
+#include <string.h>
+
+#include <memory>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/macros.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "media/blink/multibuffer_spill_store.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+
+namespace {
+
+const int kBlockSizeShift = 4;
+const int kBlockSize = 1 << kBlockSizeShift;
+
+// Multibuffers are only used as keys.
+MultiBuffer* const kMultiBuffer1 = reinterpret_cast<MultiBuffer*>(0x1000);
+MultiBuffer* const kMultiBuffer2 = reinterpret_cast<MultiBuffer*>(0x2000);
+
+scoped_refptr<DataBuffer> CreateBlock(uint8_t value, int size) {
+  scoped_refptr<DataBuffer> block(new DataBuffer(size));
+  memset(block->writable_data(), value, size);
+  block->set_data_size(size);
+  return block;
+}
+
+void SaveBlock(scoped_refptr<DataBuffer>* block_out,
+               const scoped_refptr<DataBuffer>& block) {
+  *block_out = block;
+}
+
+}  // namespace
+
+class MultiBufferSpillStoreTest : public testing::Test {
+ public:
+  MultiBufferSpillStoreTest() {}
+
+  void SetUp() override { ASSERT_TRUE(base::CreateTemporaryFile(&path_)); }
+
+  void TearDown() override {
+    // The file is closed on the task runner.
+    store_.reset();
+    base::RunLoop().RunUntilIdle();
+    base::DeleteFile(path_, false);
+  }
+
+  void CreateStore(int64_t max_blocks) {
+    base::File file(path_, base::File::FLAG_OPEN | base::File::FLAG_READ |
+                               base::File::FLAG_WRITE);
+    ASSERT_TRUE(file.IsValid());
+    store_.reset(new MultiBufferSpillStore(std::move(file), kBlockSizeShift,
+                                           max_blocks,
+                                           message_loop_.task_runner()));
+  }
+
+  scoped_refptr<DataBuffer> Restore(MultiBuffer* multibuffer,
+                                    MultiBufferBlockId block_id) {
+    scoped_refptr<DataBuffer> block;
+    store_->Restore(MultiBufferGlobalBlockId(multibuffer, block_id),
+                    base::Bind(&SaveBlock, &block));
+    base::RunLoop().RunUntilIdle();
+    return block;
+  }
+
+  void ExpectBlock(const scoped_refptr<DataBuffer>& block,
+                   uint8_t value,
+                   int size) {
+    ASSERT_TRUE(block);
+    ASSERT_EQ(size, block->data_size());
+    for (int i = 0; i < size; ++i)
+      EXPECT_EQ(value, block->data()[i]);
+  }
+
+  bool Contains(MultiBuffer* multibuffer, MultiBufferBlockId block_id) {
+    return store_->Contains(MultiBufferGlobalBlockId(multibuffer, block_id));
+  }
+
+ protected:
+  base::MessageLoop message_loop_;
+  base::FilePath path_;
+  std::unique_ptr<MultiBufferSpillStore> store_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(MultiBufferSpillStoreTest);
+};
+
+TEST_F(MultiBufferSpillStoreTest, SpillAndRestore) {
+  CreateStore(4);
+  store_->Spill(MultiBufferGlobalBlockId(kMultiBuffer1, 0),
+                CreateBlock(1, kBlockSize));
+  store_->Spill(MultiBufferGlobalBlockId(kMultiBuffer1, 1),
+                CreateBlock(2, kBlockSize - 3));
+  store_->Spill(MultiBufferGlobalBlockId(kMultiBuffer2, 0),
+                CreateBlock(3, kBlockSize));
+  EXPECT_EQ(3, store_->Size());
+
+  ExpectBlock(Restore(kMultiBuffer1, 1), 2, kBlockSize - 3);
+  ExpectBlock(Restore(kMultiBuffer2, 0), 3, kBlockSize);
+  ExpectBlock(Restore(kMultiBuffer1, 0), 1, kBlockSize);
+
+  // Restored blocks leave the store.
+  EXPECT_EQ(0, store_->Size());
+  EXPECT_FALSE(Contains(kMultiBuffer1, 0));
+}
+
+TEST_F(MultiBufferSpillStoreTest, SkipsUnsuitableBlocks) {
+  CreateStore(4);
+  store_->Spill(MultiBufferGlobalBlockId(kMultiBuffer1, 0),
+                DataBuffer::CreateEOSBuffer());
+  store_->Spill(MultiBufferGlobalBlockId(kMultiBuffer1, 1),
+                CreateBlock(1, kBlockSize + 1));
+  store_->Spill(MultiBufferGlobalBlockId(kMultiBuffer1, 2),
+                new DataBuffer(kBlockSize));
+  EXPECT_EQ(0, store_->Size());
+}
+
+TEST_F(MultiBufferSpillStoreTest, DropsOldestBlockWhenFull) {
+  CreateStore(2);
+  store_->Spill(MultiBufferGlobalBlockId(kMultiBuffer1, 0),
+                CreateBlock(1, kBlockSize));
+  store_->Spill(MultiBufferGlobalBlockId(kMultiBuffer1, 1),
+                CreateBlock(2, kBlockSize));
+  store_->Spill(MultiBufferGlobalBlockId(kMultiBuffer1, 2),
+                CreateBlock(3, kBlockSize));
+  EXPECT_EQ(2, store_->Size());
+  EXPECT_FALSE(Contains(kMultiBuffer1, 0));
+
+  // The slot of the dropped block holds the new one.
+  ExpectBlock(Restore(kMultiBuffer1, 1), 2, kBlockSize);
+  ExpectBlock(Restore(kMultiBuffer1, 2), 3, kBlockSize);
+}
+
+TEST_F(MultiBufferSpillStoreTest, ReusesSlotOfRestoredBlock) {
+  CreateStore(1);
+  store_->Spill(MultiBufferGlobalBlockId(kMultiBuffer1, 0),
+                CreateBlock(1, kBlockSize));
+
+  // The read of the first block is sequenced before the write of the second,
+  // which goes to the same slot.
+  scoped_refptr<DataBuffer> block;
+  store_->Restore(MultiBufferGlobalBlockId(kMultiBuffer1, 0),
+                  base::Bind(&SaveBlock, &block));
+  store_->Spill(MultiBufferGlobalBlockId(kMultiBuffer1, 1),
+                CreateBlock(2, kBlockSize));
+  base::RunLoop().RunUntilIdle();
+  ExpectBlock(block, 1, kBlockSize);
+  ExpectBlock(Restore(kMultiBuffer1, 1), 2, kBlockSize);
+}
+
+TEST_F(MultiBufferSpillStoreTest, RemoveAll) {
+  CreateStore(4);
+  store_->Spill(MultiBufferGlobalBlockId(kMultiBuffer1, 0),
+                CreateBlock(1, kBlockSize));
+  store_->Spill(MultiBufferGlobalBlockId(kMultiBuffer2, 0),
+                CreateBlock(2, kBlockSize));
+  store_->Spill(MultiBufferGlobalBlockId(kMultiBuffer1, 1),
+                CreateBlock(3, kBlockSize));
+  store_->RemoveAll(kMultiBuffer1);
+  EXPECT_EQ(1, store_->Size());
+  EXPECT_TRUE(Contains(kMultiBuffer2, 0));
+
+  store_->Remove(MultiBufferGlobalBlockId(kMultiBuffer2, 0));
+  EXPECT_EQ(0, store_->Size());
+}
+
+}  // namespace media
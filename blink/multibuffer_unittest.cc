@@ -11,12 +11,18 @@
 
 #include "base/bind.h"
 #include "base/callback_helpers.h"
+#include "base/files/file.h"
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/memory/ptr_util.h"
 #include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
 #include "base/test/simple_test_tick_clock.h"
 #include "media/base/fake_single_thread_task_runner.h"
 #include "media/base/test_random.h"
 #include "media/blink/multibuffer.h"
 #include "media/blink/multibuffer_reader.h"
+#include "media/blink/multibuffer_spill_store.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
 const int kBlockSizeShift = 8;
@@ -448,6 +454,179 @@ TEST_F(MultiBufferTest, LRUTestExpirationTest) {
   EXPECT_FALSE(lru_->Pruneable());
 }
 
+TEST_F(MultiBufferTest, LRUTestBudget) {
+  int64_t max_size = 1000;
+  lru_->IncrementMaxSize(max_size);
+  lru_->SetBudget(10);
+
+  multibuffer_.SetMaxWriters(1);
+  size_t pos = 0;
+  size_t end = 10000;
+  multibuffer_.SetFileSize(10000);
+  MultiBufferReader reader(&multibuffer_, pos, end,
+                           base::Callback<void(int64_t, int64_t)>());
+  reader.SetPreload(10000, 10000);
+  while (AdvanceAll()) {
+  }
+  // Blocks over the budget are freed as they come in, no matter how much
+  // memory has been registered.
+  EXPECT_EQ(10, lru_->Size());
+  lru_->IncrementMaxSize(-max_size);
+}
+
+TEST_F(MultiBufferTest, LRUTestTryFree) {
+  int64_t max_size = 1000;
+  lru_->IncrementMaxSize(max_size);
+
+  multibuffer_.SetMaxWriters(1);
+  size_t pos = 0;
+  size_t end = 10000;
+  multibuffer_.SetFileSize(10000);
+  MultiBufferReader reader(&multibuffer_, pos, end,
+                           base::Callback<void(int64_t, int64_t)>());
+  reader.SetPreload(10000, 10000);
+  while (AdvanceAll()) {
+  }
+  int64_t current_size = lru_->Size();
+  EXPECT_FALSE(lru_->Pruneable());
+
+  // Memory pressure frees blocks even though the cache isn't full.
+  lru_->TryFree(5);
+  current_size -= 5;
+  EXPECT_EQ(current_size, lru_->Size());
+  lru_->TryFreeAll();
+  EXPECT_EQ(0, lru_->Size());
+  lru_->IncrementMaxSize(-max_size);
+}
+
+TEST_F(MultiBufferTest, LRUTestSparesBlocksNearReaders) {
+  int64_t max_size = 1000;
+  lru_->IncrementMaxSize(max_size);
+  size_t end = 1 << 20;
+  multibuffer_.SetFileSize(end);
+
+  // Load some blocks for a reader far into the file first, so that they are
+  // the least recently used blocks.
+  MultiBufferReader reader(&multibuffer_, 2000 * kBlockSize, end,
+                           base::Callback<void(int64_t, int64_t)>());
+  reader.SetPreload(10 * kBlockSize, 10 * kBlockSize);
+  while (AdvanceAll()) {
+  }
+  int64_t reader_blocks = lru_->Size();
+  EXPECT_GT(reader_blocks, 0);
+
+  // Then load blocks at the start of the file for a reader which goes away.
+  {
+    MultiBufferReader other_reader(&multibuffer_, 0, end,
+                                   base::Callback<void(int64_t, int64_t)>());
+    other_reader.SetPreload(10 * kBlockSize, 10 * kBlockSize);
+    while (AdvanceAll()) {
+    }
+  }
+  int64_t other_blocks = lru_->Size() - reader_blocks;
+  EXPECT_GT(other_blocks, 0);
+
+  // The blocks nobody is reading go first, even though they were used more
+  // recently.
+  lru_->IncrementMaxSize(-max_size);
+  lru_->Prune(other_blocks);
+  EXPECT_EQ(reader_blocks, lru_->Size());
+  EXPECT_FALSE(multibuffer_.Contains(0));
+  EXPECT_TRUE(multibuffer_.Contains(2000));
+}
+
+TEST_F(MultiBufferTest, RestoreSpilledBlocks) {
+  base::FilePath path;
+  ASSERT_TRUE(base::CreateTemporaryFile(&path));
+  base::File file(path, base::File::FLAG_OPEN | base::File::FLAG_READ |
+                            base::File::FLAG_WRITE);
+  ASSERT_TRUE(file.IsValid());
+  lru_->SetSpillStore(base::MakeUnique<MultiBufferSpillStore>(
+      std::move(file), kBlockSizeShift, 100, message_loop_.task_runner()));
+
+  int64_t max_size = 1000;
+  lru_->IncrementMaxSize(max_size);
+  multibuffer_.SetMaxWriters(1);
+  size_t end = 10000;
+  multibuffer_.SetFileSize(10000);
+  {
+    MultiBufferReader reader(&multibuffer_, 0, end,
+                             base::Callback<void(int64_t, int64_t)>());
+    reader.SetPreload(10000, 10000);
+    while (AdvanceAll()) {
+    }
+  }
+  int32_t writers_created = multibuffer_.writers_created();
+
+  // Pruned blocks, all but the end of stream marker, go to the spill store.
+  lru_->IncrementMaxSize(-max_size);
+  lru_->Prune(max_size);
+  lru_->IncrementMaxSize(max_size);
+  EXPECT_EQ(0, lru_->Size());
+  EXPECT_EQ(40, lru_->spill_store()->Size());
+  base::RunLoop().RunUntilIdle();
+
+  {
+    // A new reader gets the blocks back from the spill store, without any
+    // new writer fetching them.
+    MultiBufferReader reader(&multibuffer_, 0, end,
+                             base::Callback<void(int64_t, int64_t)>());
+    reader.SetPreload(10000, 10000);
+    base::RunLoop().RunUntilIdle();
+    EXPECT_EQ(0, lru_->spill_store()->Size());
+
+    size_t pos = 0;
+    uint8_t buffer[1000];
+    ASSERT_EQ(1000, reader.TryRead(buffer, sizeof(buffer)));
+    for (; pos < sizeof(buffer); pos++) {
+      uint8_t expected = static_cast<uint8_t>((pos * 15485863) >> 16);
+      EXPECT_EQ(expected, buffer[pos]) << " pos = " << pos;
+    }
+    EXPECT_EQ(writers_created, multibuffer_.writers_created());
+  }
+
+  lru_->IncrementMaxSize(-max_size);
+  lru_->SetSpillStore(nullptr);
+  base::RunLoop().RunUntilIdle();
+  base::DeleteFile(path, false);
+}
+
+TEST_F(MultiBufferTest, MemoryPressureDropsBlocksWithoutSpilling) {
+  base::FilePath path;
+  ASSERT_TRUE(base::CreateTemporaryFile(&path));
+  base::File file(path, base::File::FLAG_OPEN | base::File::FLAG_READ |
+                            base::File::FLAG_WRITE);
+  ASSERT_TRUE(file.IsValid());
+  lru_->SetSpillStore(base::MakeUnique<MultiBufferSpillStore>(
+      std::move(file), kBlockSizeShift, 100, message_loop_.task_runner()));
+
+  int64_t max_size = 1000;
+  lru_->IncrementMaxSize(max_size);
+  multibuffer_.SetMaxWriters(1);
+  size_t end = 10000;
+  multibuffer_.SetFileSize(10000);
+  {
+    MultiBufferReader reader(&multibuffer_, 0, end,
+                             base::Callback<void(int64_t, int64_t)>());
+    reader.SetPreload(10000, 10000);
+    while (AdvanceAll()) {
+    }
+  }
+  EXPECT_GT(lru_->Size(), 0);
+
+  lru_->TryFree(5);
+  EXPECT_EQ(0, lru_->spill_store()->Size());
+  lru_->TryFreeAll();
+  EXPECT_EQ(0, lru_->Size());
+  EXPECT_EQ(0, lru_->spill_store()->Size());
+  EXPECT_FALSE(multibuffer_.Contains(0));
+
+  lru_->IncrementMaxSize(-max_size);
+  lru_->SetSpillStore(nullptr);
+  base::RunLoop().RunUntilIdle();
+  base::DeleteFile(path, false);
+}
+
 class ReadHelper {
  public:
   ReadHelper(size_t end,
@@ -164,6 +164,9 @@ void ResourceMultiBufferDataProvider::SetDeferred(bool deferred) {
   if (!active_loader_ || active_loader_->deferred() == deferred)
     return;
   active_loader_->SetDeferred(deferred);
+  // Time spent deferred doesn't count towards the download throughput.
+  last_receive_time_ =
+      deferred ? base::TimeTicks() : url_data_->tick_clock()->NowTicks();
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -226,6 +229,11 @@ void ResourceMultiBufferDataProvider::didReceiveResponse(
 #endif
   DCHECK(active_loader_);
 
+  // Download throughput is measured from here on, so that the time it takes
+  // to connect isn't counted.
+  if (!active_loader_->deferred())
+    last_receive_time_ = url_data_->tick_clock()->NowTicks();
+
   scoped_refptr<UrlData> destination_url_data(url_data_);
 
   UrlIndex* url_index = url_data_->url_index();
@@ -377,6 +385,12 @@ void ResourceMultiBufferDataProvider::didReceiveData(const char* data,
   // When we receive data, we allow more retries.
   retries_ = 0;
 
+  if (!last_receive_time_.is_null()) {
+    base::TimeTicks now = url_data_->tick_clock()->NowTicks();
+    url_data_->AddDownloadSample(data_length, now - last_receive_time_);
+    last_receive_time_ = now;
+  }
+
   while (data_length) {
     if (fifo_.empty() || fifo_.back()->data_size() == block_size()) {
       fifo_.push_back(new DataBuffer(block_size()));
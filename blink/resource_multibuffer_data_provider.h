@@ -12,6 +12,7 @@
 
 #include "base/callback.h"
 #include "base/memory/weak_ptr.h"
+#include "base/time/time.h"
 #include "media/blink/active_loader.h"
 #include "media/blink/media_blink_export.h"
 #include "media/blink/multibuffer.h"
@@ -119,6 +120,10 @@ class MEDIA_BLINK_EXPORT ResourceMultiBufferDataProvider
   // When we encounter a redirect, this is the source of the redirect.
   GURL redirects_to_;
 
+  // When we last received data, or started waiting for it. Null while we
+  // are not expecting any data.
+  base::TimeTicks last_receive_time_;
+
   base::WeakPtrFactory<ResourceMultiBufferDataProvider> weak_factory_;
 };
 
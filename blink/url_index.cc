@@ -2,14 +2,21 @@
 // Use of this source code is governed by a BSD-style license that can be
 // found in the LICENSE file.
 
+#include <math.h>
+
+#include <map>
 #include <set>
 #include <utility>
 
 #include "base/bind.h"
+#include "base/lazy_instance.h"
 #include "base/location.h"
+#include "base/memory/memory_pressure_listener.h"
+#include "base/memory/ptr_util.h"
 #include "base/single_thread_task_runner.h"
 #include "base/threading/thread_task_runner_handle.h"
 #include "base/time/time.h"
+#include "media/blink/multibuffer_spill_store.h"
 #include "media/blink/resource_multibuffer_data_provider.h"
 #include "media/blink/url_index.h"
 
@@ -18,6 +25,17 @@ namespace media {
 const int kBlockSizeShift = 15;  // 1<<15 == 32kb
 const int kUrlMappingTimeoutSeconds = 300;
 
+// Total size of the blocks cached by all players of all frames, unless they
+// are pinned.
+const int64_t kCacheBudgetBytes = 256 << 20;
+
+// Download samples lose half their weight after this many seconds of
+// downloading.
+const double kDownloadHalfLifeSeconds = 5.0;
+
+// Don't estimate throughput from less than this much download time.
+const double kMinDownloadSeconds = 1.0;
+
 ResourceMultiBuffer::ResourceMultiBuffer(UrlData* url_data, int block_shift)
     : MultiBuffer(block_shift, url_data->url_index_->lru_),
       url_data_(url_data) {}
@@ -52,7 +70,10 @@ UrlData::UrlData(const GURL& url,
       cacheable_(false),
       last_used_(),
       multibuffer_(this, url_index_->block_shift_),
-      frame_(url_index->frame()) {}
+      frame_(url_index->frame()),
+      download_bytes_(0),
+      download_seconds_(0),
+      tick_clock_(&default_tick_clock_) {}
 
 UrlData::~UrlData() {}
 
@@ -123,6 +144,24 @@ void UrlData::OnRedirect(const RedirectCB& cb) {
   redirect_callbacks_.push_back(cb);
 }
 
+void UrlData::AddDownloadSample(int64_t bytes, base::TimeDelta elapsed) {
+  DCHECK(thread_checker_.CalledOnValidThread());
+  DCHECK_GE(bytes, 0);
+  double seconds = elapsed.InSecondsF();
+  if (seconds < 0)
+    return;
+  double decay = pow(0.5, seconds / kDownloadHalfLifeSeconds);
+  download_bytes_ = download_bytes_ * decay + bytes;
+  download_seconds_ = download_seconds_ * decay + seconds;
+}
+
+int64_t UrlData::DownloadBytesPerSecond() const {
+  DCHECK(thread_checker_.CalledOnValidThread());
+  if (download_seconds_ < kMinDownloadSeconds)
+    return 0;
+  return static_cast<int64_t>(download_bytes_ / download_seconds_);
+}
+
 void UrlData::Use() {
   DCHECK(thread_checker_.CalledOnValidThread());
   last_used_ = base::Time::Now();
@@ -187,16 +226,102 @@ size_t UrlData::CachedSize() {
   return multibuffer()->map().size();
 }
 
+// The LRU and cache budget shared by every UrlIndex with the same block size,
+// so that all frames together cache at most kCacheBudgetBytes. It lives for
+// as long as some UrlIndex uses it; the LRU itself lives on until the last
+// multibuffer using it is gone.
+class SharedBlockCache : public base::RefCounted<SharedBlockCache> {
+ public:
+  // Returns the cache for blocks of 1 << |block_shift| bytes, creating it if
+  // there is none. Must be called on the thread the cache is used on.
+  static scoped_refptr<SharedBlockCache> Get(int block_shift);
+
+  const scoped_refptr<MultiBuffer::GlobalLRU>& lru() const { return lru_; }
+
+ private:
+  friend class base::RefCounted<SharedBlockCache>;
+  explicit SharedBlockCache(int block_shift);
+  ~SharedBlockCache();
+
+  // Frees cached blocks which are not in use when memory is low, without
+  // spilling them.
+  void OnMemoryPressure(
+      base::MemoryPressureListener::MemoryPressureLevel memory_pressure_level);
+
+  const int block_shift_;
+  scoped_refptr<MultiBuffer::GlobalLRU> lru_;
+  base::MemoryPressureListener memory_pressure_listener_;
+
+  DISALLOW_COPY_AND_ASSIGN(SharedBlockCache);
+};
+
+namespace {
+
+// The SharedBlockCache of each block size in use, by block shift.
+base::LazyInstance<std::map<int, SharedBlockCache*>>::Leaky g_shared_caches =
+    LAZY_INSTANCE_INITIALIZER;
+
+}  // namespace
+
+// static
+scoped_refptr<SharedBlockCache> SharedBlockCache::Get(int block_shift) {
+  auto i = g_shared_caches.Get().find(block_shift);
+  if (i != g_shared_caches.Get().end())
+    return i->second;
+  return new SharedBlockCache(block_shift);
+}
+
+SharedBlockCache::SharedBlockCache(int block_shift)
+    : block_shift_(block_shift),
+      lru_(new MultiBuffer::GlobalLRU(base::ThreadTaskRunnerHandle::Get())),
+      memory_pressure_listener_(base::Bind(&SharedBlockCache::OnMemoryPressure,
+                                           base::Unretained(this))) {
+  lru_->SetBudget(kCacheBudgetBytes >> block_shift_);
+  g_shared_caches.Get()[block_shift_] = this;
+}
+
+SharedBlockCache::~SharedBlockCache() {
+  g_shared_caches.Get().erase(block_shift_);
+}
+
+// Blocks freed here are dropped rather than spilled, as writing them out would
+// keep them in memory until the file I/O is done.
+void SharedBlockCache::OnMemoryPressure(
+    base::MemoryPressureListener::MemoryPressureLevel memory_pressure_level) {
+  switch (memory_pressure_level) {
+    case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_NONE:
+      break;
+    case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_MODERATE:
+      lru_->TryFree(lru_->Size() / 2);
+      break;
+    case base::MemoryPressureListener::MEMORY_PRESSURE_LEVEL_CRITICAL:
+      lru_->TryFreeAll();
+      break;
+  }
+}
+
 UrlIndex::UrlIndex(blink::WebFrame* frame) : UrlIndex(frame, kBlockSizeShift) {}
 
 UrlIndex::UrlIndex(blink::WebFrame* frame, int block_shift)
     : frame_(frame),
-      lru_(new MultiBuffer::GlobalLRU(base::ThreadTaskRunnerHandle::Get())),
+      shared_cache_(SharedBlockCache::Get(block_shift)),
+      lru_(shared_cache_->lru()),
       block_shift_(block_shift),
       weak_factory_(this) {}
 
 UrlIndex::~UrlIndex() {}
 
+void UrlIndex::EnableSpillStore(
+    base::File file,
+    int64_t max_bytes,
+    const scoped_refptr<base::SequencedTaskRunner>& file_task_runner) {
+  if (lru_->spill_store())
+    return;
+  lru_->SetSpillStore(base::MakeUnique<MultiBufferSpillStore>(
+      std::move(file), block_shift_, max_bytes >> block_shift_,
+      file_task_runner));
+}
+
 void UrlIndex::RemoveUrlDataIfEmpty(const scoped_refptr<UrlData>& url_data) {
   if (!url_data->multibuffer()->map().empty())
     return;
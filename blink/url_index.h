@@ -11,10 +11,15 @@
 #include <map>
 #include <vector>
 
+#include "base/files/file.h"
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
 #include "base/memory/weak_ptr.h"
+#include "base/sequenced_task_runner.h"
 #include "base/threading/thread_checker.h"
+#include "base/time/default_tick_clock.h"
+#include "base/time/tick_clock.h"
+#include "base/time/time.h"
 #include "media/blink/lru.h"
 #include "media/blink/media_blink_export.h"
 #include "media/blink/multibuffer.h"
@@ -25,6 +30,7 @@ namespace media {
 
 const int64_t kPositionNotSpecified = -1;
 
+class SharedBlockCache;
 class UrlData;
 
 // A multibuffer for loading media resources which knows
@@ -139,6 +145,20 @@ class MEDIA_BLINK_EXPORT UrlData : public base::RefCounted<UrlData> {
   // Accessor
   blink::WebFrame* frame() const { return frame_; }
 
+  // Records that |bytes| were received over |elapsed| while loading this
+  // resource, not counting time spent deferred.
+  void AddDownloadSample(int64_t bytes, base::TimeDelta elapsed);
+
+  // Returns the recent download throughput in bytes per second, or 0 if too
+  // little has been downloaded to tell.
+  int64_t DownloadBytesPerSecond() const;
+
+  // Clock used to time downloads.
+  base::TickClock* tick_clock() const { return tick_clock_; }
+  void set_tick_clock_for_testing(base::TickClock* tick_clock) {
+    tick_clock_ = tick_clock;
+  }
+
  protected:
   UrlData(const GURL& url,
           CORSMode cors_mode,
@@ -199,11 +219,22 @@ class MEDIA_BLINK_EXPORT UrlData : public base::RefCounted<UrlData> {
 
   blink::WebFrame* frame_;
 
+  // Exponentially decaying sums of the bytes downloaded and of the time it
+  // took to download them. Older samples count for less, so the throughput
+  // follows changing network conditions.
+  double download_bytes_;
+  double download_seconds_;
+
+  base::DefaultTickClock default_tick_clock_;
+  base::TickClock* tick_clock_;
+
   base::ThreadChecker thread_checker_;
   DISALLOW_COPY_AND_ASSIGN(UrlData);
 };
 
-// The UrlIndex lets you look up UrlData instances by url.
+// The UrlIndex lets you look up UrlData instances by url. There is one
+// UrlIndex per frame, but the cache budget and LRU of its multibuffers are
+// shared with the UrlIndexes of all other frames.
 class MEDIA_BLINK_EXPORT UrlIndex {
  public:
   explicit UrlIndex(blink::WebFrame*);
@@ -233,9 +264,21 @@ class MEDIA_BLINK_EXPORT UrlIndex {
   // TODO(hubbe): Add etag support.
   scoped_refptr<UrlData> TryInsert(const scoped_refptr<UrlData>& url_data);
 
+  // Makes the cache spill evicted blocks to |file|, which must be opened for
+  // reading and writing, instead of dropping them. At most |max_bytes| of
+  // |file| are used. File I/O happens on |file_task_runner|. The spill store
+  // is shared like the cache, so if another frame's UrlIndex already enabled
+  // one, |file| is closed unused.
+  void EnableSpillStore(
+      base::File file,
+      int64_t max_bytes,
+      const scoped_refptr<base::SequencedTaskRunner>& file_task_runner);
+
   blink::WebFrame* frame() const { return frame_; }
   int block_shift() const { return block_shift_; }
 
+  MultiBuffer::GlobalLRU* lru_for_testing() const { return lru_.get(); }
+
  private:
   friend class UrlData;
   friend class ResourceMultiBuffer;
@@ -247,12 +290,14 @@ class MEDIA_BLINK_EXPORT UrlIndex {
 
   std::map<UrlData::KeyType, scoped_refptr<UrlData>> by_url_;
   blink::WebFrame* frame_;
+  scoped_refptr<SharedBlockCache> shared_cache_;
   scoped_refptr<MultiBuffer::GlobalLRU> lru_;
 
   // log2 of block size in multibuffer cache. Defaults to kBlockSizeShift.
   // Currently only changed for testing purposes.
   const int block_shift_;
 
+
  protected:
   base::WeakPtrFactory<UrlIndex> weak_factory_;
 };
@@ -156,4 +156,17 @@ TEST_F(UrlIndexTest, TryInsert) {
   EXPECT_EQ(b, GetByUrl(url, UrlData::CORS_UNSPECIFIED));
 }
 
+// All frames' UrlIndexes share one cache budget, so that many frames playing
+// media don't each cache up to the budget.
+TEST_F(UrlIndexTest, SharedCache) {
+  UrlIndex other_frame_url_index(nullptr);
+  EXPECT_EQ(url_index_.lru_for_testing(),
+            other_frame_url_index.lru_for_testing());
+
+  // Blocks of different sizes can't share a budget counted in blocks.
+  UrlIndex small_block_url_index(nullptr, 0);
+  EXPECT_NE(url_index_.lru_for_testing(),
+            small_block_url_index.lru_for_testing());
+}
+
 }  // namespace media
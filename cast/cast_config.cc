@@ -36,7 +36,9 @@ FrameSenderConfig::FrameSenderConfig()
       min_bitrate(0),
       start_bitrate(0),
       max_frame_rate(kDefaultMaxFrameRate),
-      codec(CODEC_UNKNOWN) {}
+      codec(CODEC_UNKNOWN),
+      enable_fec(false),
+      congestion_control(CONGESTION_CONTROL_ADAPTIVE) {}
 
 FrameSenderConfig::FrameSenderConfig(const FrameSenderConfig& other) = default;
 
@@ -63,6 +63,15 @@ enum class RtpPayloadType {
   LAST = REMOTE_VIDEO
 };
 
+// Selects how a video sender adapts its bitrate to the network.
+enum CongestionControlType {
+  // Adapts to how quickly frames are acknowledged by the receiver.
+  CONGESTION_CONTROL_ADAPTIVE,
+  // Adapts to the queuing delay of packets, measured from the receiver's logs
+  // of when it received them. See DelayBasedCongestionControl.
+  CONGESTION_CONTROL_DELAY_BASED,
+};
+
 // TODO(miu): Eliminate these after moving "default config" into the top-level
 // media/cast directory.  http://crbug.com/530839
 enum SuggestedDefaults {
@@ -193,6 +202,14 @@ struct FrameSenderConfig {
   std::string aes_key;
   std::string aes_iv_mask;
 
+  // If true, send forward error correction (FEC) repair packets, which let the
+  // receiver recover lost packets without waiting for retransmission.
+  bool enable_fec;
+
+  // How the bitrate adapts to the network, if it is not fixed. Only used for
+  // video streams encoded with the built-in software encoders.
+  CongestionControlType congestion_control;
+
   // These are codec specific parameters for video streams only.
   VideoCodecParams video_codec_params;
 };
@@ -6,10 +6,12 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 
 #include "base/big_endian.h"
+#include "base/logging.h"
 #include "third_party/zlib/zlib.h"
 
 using media::cast::FrameEventMap;
@@ -23,11 +25,9 @@ using media::cast::proto::LogMetadata;
 
 namespace {
 
-// Use 60MB of temp buffer to hold uncompressed data if |compress| is true.
-// This is double the size of temp buffer used during compression (30MB)
-// since the there are two streams in the blob.
-// Keep in sync with media/cast/logging/log_serializer.cc.
-const int kMaxUncompressedBytes = 60 * 1000 * 1000;
+// Size of the buffer the decompressor writes to before its output is
+// deserialized.
+const int kUncompressedBufferBytes = 64 * 1024;
 
 void MergePacketEvent(const AggregatedPacketEvent& from,
     linked_ptr<AggregatedPacketEvent> to) {
@@ -68,65 +68,196 @@ void MergeFrameEvent(const AggregatedFrameEvent& from,
     to->set_target_bitrate(from.target_bitrate());
 }
 
-bool PopulateDeserializedLog(base::BigEndianReader* reader,
-                             media::cast::DeserializedLog* log) {
-  FrameEventMap frame_event_map;
-  PacketEventMap packet_event_map;
+}  // namespace
+
+namespace media {
+namespace cast {
+
+bool DeserializeEvents(const char* data,
+                       int data_bytes,
+                       bool compressed,
+                       DeserializedLog* audio_log,
+                       DeserializedLog* video_log) {
+  DCHECK_GT(data_bytes, 0);
+
+  StreamingLogDeserializer deserializer(compressed, audio_log, video_log);
+  return deserializer.Append(data, data_bytes) && deserializer.Finish();
+}
+
+DeserializedLog::DeserializedLog() {}
+DeserializedLog::~DeserializedLog() {}
+
+StreamingLogDeserializer::StreamState::StreamState()
+    : log(nullptr), started(false), first_rtp_timestamp(0) {}
+
+StreamingLogDeserializer::StreamingLogDeserializer(bool compressed,
+                                                   DeserializedLog* audio_log,
+                                                   DeserializedLog* video_log)
+    : compressed_(compressed),
+      failed_(false),
+      stream_ended_(false),
+      stream_state_(nullptr),
+      frame_events_left_(0),
+      packet_events_left_(0) {
+  audio_.log = audio_log;
+  video_.log = video_log;
+  if (!compressed_)
+    return;
+  stream_.reset(new z_stream());
+  // 16 is added to read in gzip format.
+  int result = inflateInit2(stream_.get(), MAX_WBITS + 16);
+  DCHECK_EQ(Z_OK, result);
+  uncompressed_buffer_.reset(new char[kUncompressedBufferBytes]);
+  stream_->next_out = reinterpret_cast<uint8_t*>(uncompressed_buffer_.get());
+  stream_->avail_out = kUncompressedBufferBytes;
+}
+
+StreamingLogDeserializer::~StreamingLogDeserializer() {
+  if (stream_)
+    inflateEnd(stream_.get());
+}
+
+bool StreamingLogDeserializer::Append(const char* data, int data_bytes) {
+  if (failed_)
+    return false;
+  if (!compressed_) {
+    pending_.append(data, data_bytes);
+    failed_ = !ParsePendingData();
+    return !failed_;
+  }
+
+  stream_->next_in = reinterpret_cast<uint8_t*>(const_cast<char*>(data));
+  stream_->avail_in = data_bytes;
+  // Inflate until all of |data| is consumed and the output buffer is no longer
+  // filled up, i.e. no output is left pending in the decompressor.
+  while (stream_->avail_in > 0 || stream_->avail_out == 0) {
+    // The data may hold several gzip streams back to back, e.g. one per
+    // media stream.
+    if (stream_ended_) {
+      if (stream_->avail_in == 0)
+        break;
+      int result = inflateReset(stream_.get());
+      DCHECK_EQ(Z_OK, result);
+      stream_ended_ = false;
+    }
+    stream_->next_out = reinterpret_cast<uint8_t*>(uncompressed_buffer_.get());
+    stream_->avail_out = kUncompressedBufferBytes;
+    const int result = inflate(stream_.get(), Z_NO_FLUSH);
+    // Z_BUF_ERROR only means that no progress was possible, e.g. because the
+    // output buffer was filled exactly by the last call.
+    if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+      DVLOG(2) << "inflate() failed. Result: " << result;
+      failed_ = true;
+      return false;
+    }
+    stream_ended_ = result == Z_STREAM_END;
+    pending_.append(uncompressed_buffer_.get(),
+                    kUncompressedBufferBytes - stream_->avail_out);
+    if (!ParsePendingData()) {
+      failed_ = true;
+      return false;
+    }
+  }
+  return true;
+}
+
+bool StreamingLogDeserializer::Finish() {
+  if (failed_ || !pending_.empty() || frame_events_left_ > 0 ||
+      packet_events_left_ > 0) {
+    return false;
+  }
+  return !compressed_ || stream_ended_;
+}
 
-  int num_frame_events = log->metadata.num_frame_events();
-  RtpTimeTicks relative_rtp_timestamp;
+bool StreamingLogDeserializer::ParsePendingData() {
+  base::BigEndianReader reader(pending_.data(), pending_.size());
   uint16_t proto_size = 0;
-  for (int i = 0; i < num_frame_events; i++) {
-    if (!reader->ReadU16(&proto_size))
+  while (reader.remaining() >= static_cast<int>(sizeof(proto_size))) {
+    base::BigEndianReader proto_reader(reader.ptr(), reader.remaining());
+    proto_reader.ReadU16(&proto_size);
+    if (proto_reader.remaining() < proto_size)
+      break;
+    if (!ParseProto(proto_reader.ptr(), proto_size))
       return false;
+    reader.Skip(sizeof(proto_size) + proto_size);
+  }
+  pending_.erase(0, pending_.size() - reader.remaining());
+  return true;
+}
 
-    linked_ptr<AggregatedFrameEvent> frame_event(new AggregatedFrameEvent);
-    if (!frame_event->ParseFromArray(reader->ptr(), proto_size))
+bool StreamingLogDeserializer::ParseProto(const char* data, int size) {
+  if (!stream_state_) {
+    LogMetadata metadata;
+    if (!metadata.ParseFromArray(data, size))
       return false;
-    if (!reader->Skip(proto_size))
+    stream_state_ = metadata.is_audio() ? &audio_ : &video_;
+    frame_events_left_ = metadata.num_frame_events();
+    packet_events_left_ = metadata.num_packet_events();
+    frame_rtp_timestamp_ = RtpTimeTicks();
+    packet_rtp_timestamp_ = RtpTimeTicks();
+    if (frame_events_left_ == 0 && packet_events_left_ == 0) {
+      // The first RTP timestamp of a section without events is meaningless.
+      if (!stream_state_->started)
+        stream_state_->log->metadata = metadata;
+    } else if (!stream_state_->started) {
+      stream_state_->started = true;
+      stream_state_->log->metadata = metadata;
+      stream_state_->first_rtp_timestamp = metadata.first_rtp_timestamp();
+    } else {
+      // Events of later sections are made relative to the first RTP timestamp
+      // of the first section.
+      stream_state_->rtp_timestamp_offset += RtpTimeDelta::FromTicks(
+          static_cast<int32_t>(metadata.first_rtp_timestamp() -
+                               stream_state_->first_rtp_timestamp));
+      LogMetadata* const log_metadata = &stream_state_->log->metadata;
+      log_metadata->set_num_frame_events(log_metadata->num_frame_events() +
+                                         metadata.num_frame_events());
+      log_metadata->set_num_packet_events(log_metadata->num_packet_events() +
+                                          metadata.num_packet_events());
+      stream_state_->first_rtp_timestamp = metadata.first_rtp_timestamp();
+    }
+  } else if (frame_events_left_ > 0) {
+    linked_ptr<AggregatedFrameEvent> frame_event(new AggregatedFrameEvent);
+    if (!frame_event->ParseFromArray(data, size))
       return false;
+    --frame_events_left_;
 
     // During serialization the RTP timestamp in proto is relative to previous
     // frame.
     // Adjust RTP timestamp back to value relative to first RTP timestamp.
-    relative_rtp_timestamp +=
+    frame_rtp_timestamp_ +=
         RtpTimeDelta::FromTicks(frame_event->relative_rtp_timestamp());
+    const RtpTimeTicks relative_rtp_timestamp =
+        frame_rtp_timestamp_ + stream_state_->rtp_timestamp_offset;
     frame_event->set_relative_rtp_timestamp(
         relative_rtp_timestamp.lower_32_bits());
 
-    FrameEventMap::iterator it = frame_event_map.find(relative_rtp_timestamp);
-    if (it == frame_event_map.end()) {
-      frame_event_map.insert(
-          std::make_pair(relative_rtp_timestamp, frame_event));
+    FrameEventMap* const frame_events = &stream_state_->log->frame_events;
+    FrameEventMap::iterator it = frame_events->find(relative_rtp_timestamp);
+    if (it == frame_events->end()) {
+      frame_events->insert(std::make_pair(relative_rtp_timestamp, frame_event));
     } else {
       // Events for the same frame might have been split into more than one
       // proto. Merge them.
       MergeFrameEvent(*frame_event, it->second);
     }
-  }
-
-  log->frame_events.swap(frame_event_map);
-
-  int num_packet_events = log->metadata.num_packet_events();
-  relative_rtp_timestamp = RtpTimeTicks();
-  for (int i = 0; i < num_packet_events; i++) {
-    if (!reader->ReadU16(&proto_size))
-      return false;
-
+  } else if (packet_events_left_ > 0) {
     linked_ptr<AggregatedPacketEvent> packet_event(new AggregatedPacketEvent);
-    if (!packet_event->ParseFromArray(reader->ptr(), proto_size))
-      return false;
-    if (!reader->Skip(proto_size))
+    if (!packet_event->ParseFromArray(data, size))
       return false;
+    --packet_events_left_;
 
-    relative_rtp_timestamp +=
+    packet_rtp_timestamp_ +=
         RtpTimeDelta::FromTicks(packet_event->relative_rtp_timestamp());
+    const RtpTimeTicks relative_rtp_timestamp =
+        packet_rtp_timestamp_ + stream_state_->rtp_timestamp_offset;
     packet_event->set_relative_rtp_timestamp(
         relative_rtp_timestamp.lower_32_bits());
 
-    PacketEventMap::iterator it = packet_event_map.find(relative_rtp_timestamp);
-    if (it == packet_event_map.end()) {
-      packet_event_map.insert(
+    PacketEventMap* const packet_events = &stream_state_->log->packet_events;
+    PacketEventMap::iterator it = packet_events->find(relative_rtp_timestamp);
+    if (it == packet_events->end()) {
+      packet_events->insert(
           std::make_pair(relative_rtp_timestamp, packet_event));
     } else {
       // Events for the same frame might have been split into more than one
@@ -135,120 +266,10 @@ bool PopulateDeserializedLog(base::BigEndianReader* reader,
     }
   }
 
-  log->packet_events.swap(packet_event_map);
-
-  return true;
-}
-
-bool DoDeserializeEvents(const char* data,
-                         int data_bytes,
-                         media::cast::DeserializedLog* audio_log,
-                         media::cast::DeserializedLog* video_log) {
-  bool got_audio = false;
-  bool got_video = false;
-  base::BigEndianReader reader(data, data_bytes);
-
-  LogMetadata metadata;
-  uint16_t proto_size = 0;
-  while (reader.remaining() > 0) {
-    if (!reader.ReadU16(&proto_size))
-      return false;
-    if (!metadata.ParseFromArray(reader.ptr(), proto_size))
-      return false;
-    reader.Skip(proto_size);
-
-    if (metadata.is_audio()) {
-      if (got_audio) {
-        VLOG(1) << "Got audio data twice.";
-        return false;
-      }
-
-      got_audio = true;
-      audio_log->metadata = metadata;
-      if (!PopulateDeserializedLog(&reader, audio_log))
-        return false;
-    } else {
-      if (got_video) {
-        VLOG(1) << "Got duplicate video log.";
-        return false;
-      }
-
-      got_video = true;
-      video_log->metadata = metadata;
-      if (!PopulateDeserializedLog(&reader, video_log))
-        return false;
-    }
-  }
+  if (frame_events_left_ == 0 && packet_events_left_ == 0)
+    stream_state_ = nullptr;
   return true;
 }
 
-bool Uncompress(const char* data,
-                int data_bytes,
-                int max_uncompressed_bytes,
-                char* uncompressed,
-                int* uncompressed_bytes) {
-  z_stream stream = {0};
-
-  stream.next_in = reinterpret_cast<uint8_t*>(const_cast<char*>(data));
-  stream.avail_in = data_bytes;
-  stream.next_out = reinterpret_cast<uint8_t*>(uncompressed);
-  stream.avail_out = max_uncompressed_bytes;
-
-  bool success = false;
-  while (stream.avail_in > 0 && stream.avail_out > 0) {
-    // 16 is added to read in gzip format.
-    int result = inflateInit2(&stream, MAX_WBITS + 16);
-    DCHECK_EQ(Z_OK, result);
-
-    result = inflate(&stream, Z_FINISH);
-    success = (result == Z_STREAM_END);
-    if (!success) {
-      DVLOG(2) << "inflate() failed. Result: " << result;
-      break;
-    }
-
-    result = inflateEnd(&stream);
-    DCHECK(result == Z_OK);
-  }
-
-  if (stream.avail_in == 0) {
-    success = true;
-    *uncompressed_bytes = max_uncompressed_bytes - stream.avail_out;
-  }
-  return success;
-}
-
-}  // namespace
-
-namespace media {
-namespace cast {
-
-bool DeserializeEvents(const char* data,
-                       int data_bytes,
-                       bool compressed,
-                       DeserializedLog* audio_log,
-                       DeserializedLog* video_log) {
-  DCHECK_GT(data_bytes, 0);
-
-  if (compressed) {
-    std::unique_ptr<char[]> uncompressed(new char[kMaxUncompressedBytes]);
-    int uncompressed_bytes = 0;
-    if (!Uncompress(data,
-                    data_bytes,
-                    kMaxUncompressedBytes,
-                    uncompressed.get(),
-                    &uncompressed_bytes))
-      return false;
-
-    return DoDeserializeEvents(
-        uncompressed.get(), uncompressed_bytes, audio_log, video_log);
-  } else {
-    return DoDeserializeEvents(data, data_bytes, audio_log, video_log);
-  }
-}
-
-DeserializedLog::DeserializedLog() {}
-DeserializedLog::~DeserializedLog() {}
-
 }  // namespace cast
 }  // namespace media
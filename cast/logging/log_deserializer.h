@@ -5,13 +5,19 @@
 #ifndef MEDIA_CAST_LOGGING_LOG_DESERIALIZER_H_
 #define MEDIA_CAST_LOGGING_LOG_DESERIALIZER_H_
 
+#include <stdint.h>
+
 #include <map>
+#include <memory>
 #include <string>
 
+#include "base/macros.h"
 #include "base/memory/linked_ptr.h"
 #include "media/cast/logging/logging_defines.h"
 #include "media/cast/logging/proto/raw_events.pb.h"
 
+struct z_stream_s;
+
 namespace media {
 namespace cast {
 
@@ -33,7 +39,9 @@ struct DeserializedLog {
 
 // This function takes the output of LogSerializer and deserializes it into
 // its original format. Returns true if deserialization is successful. All
-// output arguments are valid if this function returns true.
+// output arguments are valid if this function returns true. Events of a stream
+// that were serialized in several sections, e.g. by StreamingLogSerializer,
+// are merged.
 // |data|: Serialized event logs with length |data_bytes|.
 // |compressed|: true if |data| is compressed in gzip format.
 // |log_metadata|: This will be populated with deserialized LogMetadata proto.
@@ -45,6 +53,74 @@ bool DeserializeEvents(const char* data,
                        DeserializedLog* audio_log,
                        DeserializedLog* video_log);
 
+// Deserializes the output of LogSerializer piece by piece, e.g. as it is read
+// from a file, so that only a partial proto of the serialized data is held in
+// memory besides the deserialized events.
+class StreamingLogDeserializer {
+ public:
+  // |compressed|: true if the data is compressed in gzip format.
+  // |audio_log|, |video_log|: These will be populated with deserialized
+  // log data for audio and video streams, respectively. They must outlive
+  // this object.
+  StreamingLogDeserializer(bool compressed,
+                           DeserializedLog* audio_log,
+                           DeserializedLog* video_log);
+  ~StreamingLogDeserializer();
+
+  // Deserializes the next |data_bytes| of serialized data. Returns false if
+  // they are invalid.
+  bool Append(const char* data, int data_bytes);
+
+  // Returns true if the serialized data ended after a complete log.
+  bool Finish();
+
+ private:
+  // Where the events of a stream are merged to.
+  struct StreamState {
+    StreamState();
+
+    DeserializedLog* log;
+    bool started;
+    // The first RTP timestamp of the last section of the stream, and how far
+    // it is from that of the first section.
+    uint32_t first_rtp_timestamp;
+    RtpTimeDelta rtp_timestamp_offset;
+  };
+
+  // Deserializes all the complete protos in |pending_|.
+  bool ParsePendingData();
+
+  // Deserializes a proto of |size| bytes, of the kind expected next.
+  bool ParseProto(const char* data, int size);
+
+  const bool compressed_;
+  bool failed_;
+
+  // Uncompressed data that does not yet hold a complete proto.
+  std::string pending_;
+
+  // The decompressor, and whether it has reached the end of a gzip stream.
+  std::unique_ptr<z_stream_s> stream_;
+  bool stream_ended_;
+  std::unique_ptr<char[]> uncompressed_buffer_;
+
+  StreamState audio_;
+  StreamState video_;
+
+  // The stream of the current section, or null if a LogMetadata proto is
+  // expected next, and the number of its events left to deserialize.
+  StreamState* stream_state_;
+  int frame_events_left_;
+  int packet_events_left_;
+
+  // RTP timestamps of the last frame and packet events deserialized in the
+  // current section, relative to its first RTP timestamp.
+  RtpTimeTicks frame_rtp_timestamp_;
+  RtpTimeTicks packet_rtp_timestamp_;
+
+  DISALLOW_COPY_AND_ASSIGN(StreamingLogDeserializer);
+};
+
 }  // namespace cast
 }  // namespace media
 
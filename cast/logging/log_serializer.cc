@@ -4,25 +4,29 @@
 //
 // The serialization format is as follows:
 //   16-bit integer describing the following LogMetadata proto size in bytes.
-//   The LogMetadata proto.
-//   32-bit integer describing number of frame events.
+//   The LogMetadata proto, which holds the number of frame and packet events
+//   that follow.
 //   (The following repeated for number of frame events):
 //     16-bit integer describing the following AggregatedFrameEvent proto size
 //         in bytes.
 //     The AggregatedFrameEvent proto.
-//   32-bit integer describing number of packet events.
 //   (The following repeated for number of packet events):
 //     16-bit integer describing the following AggregatedPacketEvent proto
 //         size in bytes.
 //     The AggregatedPacketEvent proto.
+//
+// Such a section may be followed by more, for the same or another stream. The
+// RTP timestamps of a section's events are relative to the first RTP timestamp
+// in its LogMetadata, and, within the section, each is stored relative to the
+// previous event of the same kind.
 
 #include "media/cast/logging/log_serializer.h"
 
 #include <stdint.h>
-
-#include <memory>
+#include <string.h>
 
 #include "base/big_endian.h"
+#include "base/bind.h"
 #include "base/logging.h"
 #include "third_party/zlib/zlib.h"
 
@@ -35,33 +39,70 @@ using media::cast::proto::AggregatedFrameEvent;
 using media::cast::proto::AggregatedPacketEvent;
 using media::cast::proto::LogMetadata;
 
-// Use 30MB of temp buffer to hold uncompressed data if |compress| is true.
-const int kMaxUncompressedBytes = 30 * 1000 * 1000;
-
 // The maximum allowed size per serialized proto.
 const int kMaxSerializedProtoBytes = (1 << 16) - 1;
-bool DoSerializeEvents(const LogMetadata& metadata,
-                       const FrameEventList& frame_events,
-                       const PacketEventList& packet_events,
-                       const int max_output_bytes,
-                       char* output,
-                       int* output_bytes) {
-  base::BigEndianWriter writer(output, max_output_bytes);
-
-  int proto_size = metadata.ByteSize();
-  DCHECK(proto_size <= kMaxSerializedProtoBytes);
-  if (!writer.WriteU16(static_cast<uint16_t>(proto_size)))
-    return false;
-  if (!metadata.SerializeToArray(writer.ptr(), writer.remaining()))
+
+// Size of the buffer the compressor writes to before its output is handed to
+// the sink.
+const int kCompressedBufferBytes = 64 * 1024;
+
+// Appends |data| to |output|, which holds |*output_bytes| of
+// |max_output_bytes|.
+bool AppendToBuffer(char* output,
+                    int max_output_bytes,
+                    int* output_bytes,
+                    const char* data,
+                    int data_bytes) {
+  if (data_bytes > max_output_bytes - *output_bytes)
     return false;
-  if (!writer.Skip(proto_size))
+  memcpy(output + *output_bytes, data, data_bytes);
+  *output_bytes += data_bytes;
+  return true;
+}
+
+}  // namespace
+
+StreamingLogSerializer::StreamingLogSerializer(bool compress,
+                                               const WriteCallback& write_cb)
+    : compress_(compress),
+      write_cb_(write_cb),
+      failed_(false),
+      finished_(false),
+      proto_buffer_(new char[sizeof(uint16_t) + kMaxSerializedProtoBytes]) {
+  if (!compress_)
+    return;
+  stream_.reset(new z_stream());
+  int result = deflateInit2(stream_.get(),
+                            Z_DEFAULT_COMPRESSION,
+                            Z_DEFLATED,
+                            // 16 is added to produce a gzip header + trailer.
+                            MAX_WBITS + 16,
+                            8,  // memLevel = 8 is default.
+                            Z_DEFAULT_STRATEGY);
+  DCHECK_EQ(Z_OK, result);
+  compressed_buffer_.reset(new char[kCompressedBufferBytes]);
+  stream_->next_out = reinterpret_cast<uint8_t*>(compressed_buffer_.get());
+  stream_->avail_out = kCompressedBufferBytes;
+}
+
+StreamingLogSerializer::~StreamingLogSerializer() {
+  if (stream_) {
+    int result = deflateEnd(stream_.get());
+    DCHECK(result == Z_OK || result == Z_DATA_ERROR);
+  }
+}
+
+bool StreamingLogSerializer::AppendEvents(
+    const LogMetadata& log_metadata,
+    const FrameEventList& frame_events,
+    const PacketEventList& packet_events) {
+  DCHECK(!finished_);
+  if (!WriteProto(log_metadata))
     return false;
 
   RtpTimeTicks prev_rtp_timestamp;
-  for (media::cast::FrameEventList::const_iterator it = frame_events.begin();
-       it != frame_events.end();
-       ++it) {
-    media::cast::proto::AggregatedFrameEvent frame_event(**it);
+  for (const linked_ptr<AggregatedFrameEvent>& event : frame_events) {
+    AggregatedFrameEvent frame_event(*event);
 
     // Adjust relative RTP timestamp so that it is relative to previous frame,
     // rather than relative to first RTP timestamp.
@@ -72,24 +113,13 @@ bool DoSerializeEvents(const LogMetadata& metadata,
         (rtp_timestamp - prev_rtp_timestamp).lower_32_bits());
     prev_rtp_timestamp = rtp_timestamp;
 
-    proto_size = frame_event.ByteSize();
-    DCHECK(proto_size <= kMaxSerializedProtoBytes);
-
-    // Write size of the proto, then write the proto.
-    if (!writer.WriteU16(static_cast<uint16_t>(proto_size)))
-      return false;
-    if (!frame_event.SerializeToArray(writer.ptr(), writer.remaining()))
-      return false;
-    if (!writer.Skip(proto_size))
+    if (!WriteProto(frame_event))
       return false;
   }
 
-  // Write packet events.
   prev_rtp_timestamp = RtpTimeTicks();
-  for (media::cast::PacketEventList::const_iterator it = packet_events.begin();
-       it != packet_events.end();
-       ++it) {
-    media::cast::proto::AggregatedPacketEvent packet_event(**it);
+  for (const linked_ptr<AggregatedPacketEvent>& event : packet_events) {
+    AggregatedPacketEvent packet_event(*event);
 
     const RtpTimeTicks rtp_timestamp =
         prev_rtp_timestamp.Expand(packet_event.relative_rtp_timestamp());
@@ -97,60 +127,85 @@ bool DoSerializeEvents(const LogMetadata& metadata,
         (rtp_timestamp - prev_rtp_timestamp).lower_32_bits());
     prev_rtp_timestamp = rtp_timestamp;
 
-    proto_size = packet_event.ByteSize();
-    DCHECK(proto_size <= kMaxSerializedProtoBytes);
-
-    // Write size of the proto, then write the proto.
-    if (!writer.WriteU16(static_cast<uint16_t>(proto_size)))
-      return false;
-    if (!packet_event.SerializeToArray(writer.ptr(), writer.remaining()))
-      return false;
-    if (!writer.Skip(proto_size))
+    if (!WriteProto(packet_event))
       return false;
   }
-
-  *output_bytes = max_output_bytes - writer.remaining();
   return true;
 }
 
-bool Compress(char* uncompressed_buffer,
-              int uncompressed_bytes,
-              int max_output_bytes,
-              char* output,
-              int* output_bytes) {
-  z_stream stream = {0};
-  int result = deflateInit2(&stream,
-                            Z_DEFAULT_COMPRESSION,
-                            Z_DEFLATED,
-                            // 16 is added to produce a gzip header + trailer.
-                            MAX_WBITS + 16,
-                            8,  // memLevel = 8 is default.
-                            Z_DEFAULT_STRATEGY);
-  DCHECK_EQ(Z_OK, result);
-
-  stream.next_in = reinterpret_cast<uint8_t*>(uncompressed_buffer);
-  stream.avail_in = uncompressed_bytes;
-  stream.next_out = reinterpret_cast<uint8_t*>(output);
-  stream.avail_out = max_output_bytes;
-
-  // Do a one-shot compression. This will return Z_STREAM_END only if |output|
-  // is large enough to hold all compressed data.
-  result = deflate(&stream, Z_FINISH);
-  bool success = (result == Z_STREAM_END);
-
-  if (!success)
-    DVLOG(2) << "deflate() failed. Result: " << result;
+bool StreamingLogSerializer::AppendEvents(EncodingEventSubscriber* subscriber) {
+  LogMetadata log_metadata;
+  FrameEventList frame_events;
+  PacketEventList packet_events;
+  subscriber->GetEventsAndReset(&log_metadata, &frame_events, &packet_events);
+  return AppendEvents(log_metadata, frame_events, packet_events);
+}
 
-  result = deflateEnd(&stream);
-  DCHECK(result == Z_OK || result == Z_DATA_ERROR);
+bool StreamingLogSerializer::Finish() {
+  DCHECK(!finished_);
+  finished_ = true;
+  if (failed_)
+    return false;
+  if (compress_ && !Deflate(Z_FINISH)) {
+    failed_ = true;
+    return false;
+  }
+  return true;
+}
 
-  if (success)
-    *output_bytes = max_output_bytes - stream.avail_out;
+template <typename ProtoType>
+bool StreamingLogSerializer::WriteProto(const ProtoType& proto) {
+  const int proto_size = proto.ByteSize();
+  DCHECK_LE(proto_size, kMaxSerializedProtoBytes);
+  base::BigEndianWriter writer(proto_buffer_.get(),
+                               sizeof(uint16_t) + kMaxSerializedProtoBytes);
+  if (!writer.WriteU16(static_cast<uint16_t>(proto_size)) ||
+      !proto.SerializeToArray(writer.ptr(), writer.remaining())) {
+    // Fail the whole stream rather than leave a record out of it.
+    failed_ = true;
+    return false;
+  }
+  return Write(proto_buffer_.get(), sizeof(uint16_t) + proto_size);
+}
 
-  return success;
+bool StreamingLogSerializer::Write(const char* data, int data_bytes) {
+  if (failed_)
+    return false;
+  if (compress_) {
+    stream_->next_in = reinterpret_cast<uint8_t*>(const_cast<char*>(data));
+    stream_->avail_in = data_bytes;
+    failed_ = !Deflate(Z_NO_FLUSH);
+  } else {
+    failed_ = !write_cb_.Run(data, data_bytes);
+  }
+  return !failed_;
 }
 
-}  // namespace
+bool StreamingLogSerializer::Deflate(int flush) {
+  while (true) {
+    const int result = deflate(stream_.get(), flush);
+    if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR) {
+      DVLOG(2) << "deflate() failed. Result: " << result;
+      return false;
+    }
+
+    // Hand the output to the sink once the buffer is full, or everything has
+    // been compressed when ending the stream.
+    const bool done = flush == Z_FINISH ? result == Z_STREAM_END
+                                        : stream_->avail_in == 0;
+    if (stream_->avail_out == 0 || (done && flush == Z_FINISH)) {
+      const int output_bytes = kCompressedBufferBytes - stream_->avail_out;
+      if (output_bytes > 0 &&
+          !write_cb_.Run(compressed_buffer_.get(), output_bytes)) {
+        return false;
+      }
+      stream_->next_out = reinterpret_cast<uint8_t*>(compressed_buffer_.get());
+      stream_->avail_out = kCompressedBufferBytes;
+    }
+    if (done)
+      return true;
+  }
+}
 
 bool SerializeEvents(const LogMetadata& log_metadata,
                      const FrameEventList& frame_events,
@@ -163,32 +218,16 @@ bool SerializeEvents(const LogMetadata& log_metadata,
   DCHECK(output);
   DCHECK(output_bytes);
 
-  if (compress) {
-    // Allocate a reasonably large temp buffer to hold uncompressed data.
-    std::unique_ptr<char[]> uncompressed_buffer(
-        new char[kMaxUncompressedBytes]);
-    int uncompressed_bytes;
-    bool success = DoSerializeEvents(log_metadata,
-                                     frame_events,
-                                     packet_events,
-                                     kMaxUncompressedBytes,
-                                     uncompressed_buffer.get(),
-                                     &uncompressed_bytes);
-    if (!success)
-      return false;
-    return Compress(uncompressed_buffer.get(),
-                    uncompressed_bytes,
-                    max_output_bytes,
-                    output,
-                    output_bytes);
-  } else {
-    return DoSerializeEvents(log_metadata,
-                             frame_events,
-                             packet_events,
-                             max_output_bytes,
-                             output,
-                             output_bytes);
+  int bytes_written = 0;
+  StreamingLogSerializer serializer(
+      compress, base::Bind(&AppendToBuffer, output, max_output_bytes,
+                           &bytes_written));
+  if (!serializer.AppendEvents(log_metadata, frame_events, packet_events) ||
+      !serializer.Finish()) {
+    return false;
   }
+  *output_bytes = bytes_written;
+  return true;
 }
 
 }  // namespace cast
@@ -5,10 +5,15 @@
 #ifndef MEDIA_CAST_LOGGING_LOG_SERIALIZER_H_
 #define MEDIA_CAST_LOGGING_LOG_SERIALIZER_H_
 
+#include <memory>
 #include <string>
 
+#include "base/callback.h"
+#include "base/macros.h"
 #include "media/cast/logging/encoding_event_subscriber.h"
 
+struct z_stream_s;
+
 namespace media {
 namespace cast {
 
@@ -31,6 +36,63 @@ bool SerializeEvents(const media::cast::proto::LogMetadata& log_metadata,
                      char* output,
                      int* output_bytes);
 
+// Serializes events incrementally, in the same format as SerializeEvents(),
+// and hands the output to a sink as it goes. Each call to AppendEvents()
+// writes another section of events, so a long session can be logged by
+// periodically draining its EncodingEventSubscribers, without holding all of
+// its events, or their serialized form, in memory. The deserializers merge
+// the sections of each stream back together.
+class StreamingLogSerializer {
+ public:
+  // Called with each piece of output. Returns false if it could not be
+  // written, which fails the serialization.
+  typedef base::Callback<bool(const char* data, int data_bytes)> WriteCallback;
+
+  // If |compress| is true, the output is a single gzip stream.
+  StreamingLogSerializer(bool compress, const WriteCallback& write_cb);
+  ~StreamingLogSerializer();
+
+  // Serializes a section of events, as returned by
+  // EncodingEventSubscriber::GetEventsAndReset().
+  bool AppendEvents(const media::cast::proto::LogMetadata& log_metadata,
+                    const FrameEventList& frame_events,
+                    const PacketEventList& packet_events);
+
+  // Serializes the events |subscriber| has received since it was last reset,
+  // and resets it.
+  bool AppendEvents(EncodingEventSubscriber* subscriber);
+
+  // Ends the output, flushing the compressed stream. No events may be
+  // appended afterwards.
+  bool Finish();
+
+ private:
+  // Writes the size of |proto|, then |proto|.
+  template <typename ProtoType>
+  bool WriteProto(const ProtoType& proto);
+
+  bool Write(const char* data, int data_bytes);
+
+  // Runs the compressor with |flush| and hands its output to the sink.
+  bool Deflate(int flush);
+
+  const bool compress_;
+  const WriteCallback write_cb_;
+
+  // Set once a write has failed, and once the output has ended.
+  bool failed_;
+  bool finished_;
+
+  // Holds one size-prefixed proto at a time.
+  std::unique_ptr<char[]> proto_buffer_;
+
+  // The compressor, and the buffer for its output.
+  std::unique_ptr<z_stream_s> stream_;
+  std::unique_ptr<char[]> compressed_buffer_;
+
+  DISALLOW_COPY_AND_ASSIGN(StreamingLogSerializer);
+};
+
 }  // namespace cast
 }  // namespace media
 
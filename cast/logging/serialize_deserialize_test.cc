@@ -7,9 +7,13 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <memory>
+#include <string>
 
+#include "base/bind.h"
 #include "base/macros.h"
+#include "media/cast/logging/encoding_event_subscriber.h"
 #include "media/cast/logging/log_deserializer.h"
 #include "media/cast/logging/log_serializer.h"
 #include "media/cast/logging/logging_defines.h"
@@ -41,6 +45,11 @@ const int kIdealizedBitratePercentUtilized[] = {9, 9, 9, 15, 36, 38, 35, 40};
 
 const int kMaxSerializedBytes = 10000;
 
+bool AppendToString(std::string* output, const char* data, int data_bytes) {
+  output->append(data, data_bytes);
+  return true;
+}
+
 }
 
 namespace media {
@@ -143,6 +152,70 @@ class SerializeDeserializeTest : public ::testing::Test {
     EXPECT_TRUE(packet_event_list_.empty());
   }
 
+  // Serializes the events in two sections, the second with its own first RTP
+  // timestamp, then deserializes them a few bytes at a time.
+  void StreamInTwoSections(bool compressed, DeserializedLog* video_log) {
+    const int kFirstSectionEvents = 5;
+    const int kRtpTimestampShift = 450;
+
+    LogMetadata first_metadata(metadata_);
+    first_metadata.set_num_frame_events(kFirstSectionEvents);
+    first_metadata.set_num_packet_events(kFirstSectionEvents);
+    LogMetadata second_metadata(metadata_);
+    second_metadata.set_first_rtp_timestamp(metadata_.first_rtp_timestamp() +
+                                            kRtpTimestampShift);
+    second_metadata.set_num_frame_events(metadata_.num_frame_events() -
+                                         kFirstSectionEvents);
+    second_metadata.set_num_packet_events(metadata_.num_packet_events() -
+                                          kFirstSectionEvents);
+
+    FrameEventList first_frame_events(
+        frame_event_list_.begin(),
+        frame_event_list_.begin() + kFirstSectionEvents);
+    FrameEventList second_frame_events;
+    for (size_t i = kFirstSectionEvents; i < frame_event_list_.size(); ++i) {
+      linked_ptr<AggregatedFrameEvent> frame_event(
+          new AggregatedFrameEvent(*frame_event_list_[i]));
+      frame_event->set_relative_rtp_timestamp(
+          frame_event->relative_rtp_timestamp() - kRtpTimestampShift);
+      second_frame_events.push_back(frame_event);
+    }
+    PacketEventList first_packet_events(
+        packet_event_list_.begin(),
+        packet_event_list_.begin() + kFirstSectionEvents);
+    PacketEventList second_packet_events;
+    for (size_t i = kFirstSectionEvents; i < packet_event_list_.size(); ++i) {
+      linked_ptr<AggregatedPacketEvent> packet_event(
+          new AggregatedPacketEvent(*packet_event_list_[i]));
+      packet_event->set_relative_rtp_timestamp(
+          packet_event->relative_rtp_timestamp() - kRtpTimestampShift);
+      second_packet_events.push_back(packet_event);
+    }
+
+    std::string serialized;
+    StreamingLogSerializer serializer(
+        compressed, base::Bind(&AppendToString, &serialized));
+    ASSERT_TRUE(serializer.AppendEvents(first_metadata, first_frame_events,
+                                        first_packet_events));
+    ASSERT_TRUE(serializer.AppendEvents(second_metadata, second_frame_events,
+                                        second_packet_events));
+    ASSERT_TRUE(serializer.Finish());
+
+    const int kPieceBytes = 7;
+    DeserializedLog audio_log;
+    StreamingLogDeserializer deserializer(compressed, &audio_log, video_log);
+    for (size_t offset = 0; offset < serialized.size();
+         offset += kPieceBytes) {
+      const int piece_bytes = std::min(
+          kPieceBytes, static_cast<int>(serialized.size() - offset));
+      ASSERT_TRUE(deserializer.Append(serialized.data() + offset,
+                                      piece_bytes));
+    }
+    ASSERT_TRUE(deserializer.Finish());
+    EXPECT_TRUE(audio_log.frame_events.empty());
+    EXPECT_TRUE(audio_log.packet_events.empty());
+  }
+
   LogMetadata metadata_;
   FrameEventList frame_event_list_;
   PacketEventList packet_event_list_;
@@ -224,5 +297,127 @@ TEST_F(SerializeDeserializeTest, CompressedInsufficientSpace) {
   EXPECT_EQ(0, output_bytes_);
 }
 
+TEST_F(SerializeDeserializeTest, UncompressedStreaming) {
+  Init();
+  DeserializedLog video_log;
+  StreamInTwoSections(false, &video_log);
+  Verify(video_log);
+}
+
+TEST_F(SerializeDeserializeTest, CompressedStreaming) {
+  Init();
+  DeserializedLog video_log;
+  StreamInTwoSections(true, &video_log);
+  Verify(video_log);
+}
+
+TEST_F(SerializeDeserializeTest, StreamingMatchesSerializeEvents) {
+  Init();
+  bool success = SerializeEvents(metadata_,
+                                 frame_event_list_,
+                                 packet_event_list_,
+                                 false,
+                                 kMaxSerializedBytes,
+                                 serialized_.get(),
+                                 &output_bytes_);
+  ASSERT_TRUE(success);
+
+  std::string streamed;
+  StreamingLogSerializer serializer(false,
+                                    base::Bind(&AppendToString, &streamed));
+  ASSERT_TRUE(serializer.AppendEvents(metadata_, frame_event_list_,
+                                      packet_event_list_));
+  ASSERT_TRUE(serializer.Finish());
+  EXPECT_EQ(std::string(serialized_.get(), output_bytes_), streamed);
+}
+
+TEST_F(SerializeDeserializeTest, StreamingPeriodicDrains) {
+  // Each drain takes fewer events than the subscriber can hold, but all of
+  // them together take more.
+  const int kMaxFrames = 10;
+  const int kNumDrains = 4;
+  const int kFramesPerDrain = 8;
+  const uint32_t kFirstRtpTimestamp = 12345678 * 90;
+
+  EncodingEventSubscriber subscriber(VIDEO_EVENT, kMaxFrames);
+  std::string serialized;
+  StreamingLogSerializer serializer(true,
+                                    base::Bind(&AppendToString, &serialized));
+  int64_t event_time_ms = 0;
+  for (int i = 0; i < kNumDrains; ++i) {
+    for (int j = 0; j < kFramesPerDrain; ++j) {
+      const int frame = i * kFramesPerDrain + j;
+      const RtpTimeTicks rtp_timestamp =
+          RtpTimeTicks().Expand(kFirstRtpTimestamp + frame * 90);
+
+      FrameEvent frame_event;
+      frame_event.timestamp =
+          base::TimeTicks() + base::TimeDelta::FromMilliseconds(event_time_ms);
+      frame_event.type = FRAME_ENCODED;
+      frame_event.media_type = VIDEO_EVENT;
+      frame_event.rtp_timestamp = rtp_timestamp;
+      frame_event.frame_id = FrameId::first() + frame;
+      frame_event.size =
+          kEncodedFrameSize[frame % arraysize(kEncodedFrameSize)];
+      frame_event.key_frame = frame == 0;
+      subscriber.OnReceiveFrameEvent(frame_event);
+
+      PacketEvent packet_event;
+      packet_event.timestamp = frame_event.timestamp;
+      packet_event.type = PACKET_SENT_TO_NETWORK;
+      packet_event.media_type = VIDEO_EVENT;
+      packet_event.rtp_timestamp = rtp_timestamp;
+      packet_event.frame_id = frame_event.frame_id;
+      packet_event.max_packet_id = 0;
+      packet_event.packet_id = 0;
+      packet_event.size = frame_event.size;
+      subscriber.OnReceivePacketEvent(packet_event);
+
+      event_time_ms += 33;
+    }
+    ASSERT_TRUE(serializer.AppendEvents(&subscriber));
+  }
+  ASSERT_TRUE(serializer.Finish());
+
+  DeserializedLog audio_log;
+  DeserializedLog video_log;
+  ASSERT_TRUE(DeserializeEvents(serialized.data(), serialized.size(), true,
+                                &audio_log, &video_log));
+  EXPECT_TRUE(audio_log.frame_events.empty());
+  EXPECT_TRUE(audio_log.packet_events.empty());
+
+  // All the events are there, relative to the first RTP timestamp of the
+  // session.
+  const int kNumFrames = kNumDrains * kFramesPerDrain;
+  EXPECT_FALSE(video_log.metadata.is_audio());
+  EXPECT_EQ(kFirstRtpTimestamp, video_log.metadata.first_rtp_timestamp());
+  EXPECT_EQ(kNumFrames, video_log.metadata.num_frame_events());
+  EXPECT_EQ(kNumFrames, video_log.metadata.num_packet_events());
+  ASSERT_EQ(static_cast<size_t>(kNumFrames), video_log.frame_events.size());
+  ASSERT_EQ(static_cast<size_t>(kNumFrames), video_log.packet_events.size());
+
+  int frame = 0;
+  for (const auto& it : video_log.frame_events) {
+    const AggregatedFrameEvent& event = *it.second;
+    EXPECT_EQ(static_cast<uint32_t>(frame * 90),
+              event.relative_rtp_timestamp());
+    EXPECT_EQ(kEncodedFrameSize[frame % arraysize(kEncodedFrameSize)],
+              event.encoded_frame_size());
+    ASSERT_EQ(1, event.event_timestamp_ms_size());
+    EXPECT_EQ(frame * 33, event.event_timestamp_ms(0));
+    ++frame;
+  }
+  frame = 0;
+  for (const auto& it : video_log.packet_events) {
+    const AggregatedPacketEvent& event = *it.second;
+    EXPECT_EQ(static_cast<uint32_t>(frame * 90),
+              event.relative_rtp_timestamp());
+    ASSERT_EQ(1, event.base_packet_event_size());
+    EXPECT_EQ(kEncodedFrameSize[frame % arraysize(kEncodedFrameSize)],
+              static_cast<int>(event.base_packet_event(0).size()));
+    ++frame;
+  }
+}
+
 }  // namespace cast
 }  // namespace media
@@ -68,6 +68,14 @@ class RtcpObserver {
 
   // Called on receiving RTP receiver logs.
   virtual void OnReceivedReceiverLog(const RtcpReceiverLogMessage& log) {}
+
+  // Called on receiving a report of the fraction of packets lost, in units of
+  // 1/256, from RTP receiver.
+  virtual void OnReceivedPacketLoss(uint8_t fraction_lost) {}
+
+  // Called with the send and arrival times of the packets which the RTP
+  // receiver logged as received, ordered by send time.
+  virtual void OnReceivedPacketTimings(const PacketTimingList& timings) {}
 };
 
 // The application should only trigger this class from the transport thread.
@@ -11,7 +11,8 @@ CastTransportRtpConfig::CastTransportRtpConfig()
     : rtp_stream_id(0),
       ssrc(0),
       feedback_ssrc(0),
-      rtp_payload_type(RtpPayloadType::UNKNOWN) {}
+      rtp_payload_type(RtpPayloadType::UNKNOWN),
+      enable_fec(false) {}
 
 CastTransportRtpConfig::~CastTransportRtpConfig() {}
 
@@ -41,6 +41,11 @@ struct CastTransportRtpConfig {
   // strings, crypto is not being used.
   std::string aes_key;
   std::string aes_iv_mask;
+
+  // If true, XOR repair packets are sent along with each frame so that the
+  // receiver can recover lost packets without retransmission. The overhead
+  // adapts to the packet loss reported by the receiver.
+  bool enable_fec;
 };
 
 // A combination of metadata and data for one encoded frame.  This can contain
@@ -130,6 +135,12 @@ class PacketTransport {
   // will return true indicating that the channel is not blocked.
   virtual bool SendPacket(PacketRef packet, const base::Closure& cb) = 0;
 
+  // Sends the packets a transport that batches datagrams may still hold from
+  // earlier SendPacket() calls. Called at the end of each burst of packets.
+  // Returns false, like SendPacket(), if the network is blocked and we should
+  // wait for |cb| to be called.
+  virtual bool FlushBatch(const base::Closure& cb) { return true; }
+
   // Returns the number of bytes ever sent.
   virtual int64_t GetBytesSent() = 0;
 
@@ -78,10 +78,19 @@ class CastTransportImpl::RtcpClient : public RtcpObserver {
 
   void OnReceivedReceiverLog(const RtcpReceiverLogMessage& log) override {
     cast_transport_impl_->OnReceivedLogMessage(media_type_, log);
+    PacketTimingList timings;
+    cast_transport_impl_->GetPacketTimings(rtp_sender_ssrc_, log, &timings);
+    if (!timings.empty())
+      rtcp_observer_->OnReceivedPacketTimings(timings);
   }
 
   void OnReceivedPli() override { rtcp_observer_->OnReceivedPli(); }
 
+  void OnReceivedPacketLoss(uint8_t fraction_lost) override {
+    rtcp_observer_->OnReceivedPacketLoss(fraction_lost);
+    cast_transport_impl_->OnReceivedPacketLoss(rtp_sender_ssrc_, fraction_lost);
+  }
+
  private:
   const uint32_t rtp_sender_ssrc_;
   const std::unique_ptr<RtcpObserver> rtcp_observer_;
@@ -372,6 +381,43 @@ void CastTransportImpl::OnReceivedLogMessage(
   }
 }
 
+void CastTransportImpl::OnReceivedPacketLoss(uint32_t ssrc,
+                                             uint8_t fraction_lost) {
+  auto it = sessions_.find(ssrc);
+  if (it == sessions_.end() || !it->second->rtp_sender)
+    return;
+  it->second->rtp_sender->OnReceivedPacketLoss(fraction_lost);
+}
+
+void CastTransportImpl::GetPacketTimings(uint32_t ssrc,
+                                         const RtcpReceiverLogMessage& log,
+                                         PacketTimingList* timings) {
+  auto it = sessions_.find(ssrc);
+  if (it == sessions_.end() || !it->second->rtp_sender)
+    return;
+  RtpSender* const rtp_sender = it->second->rtp_sender.get();
+
+  for (const RtcpReceiverFrameLogMessage& frame_log_message : log) {
+    for (const RtcpReceiverEventLogMessage& event_log_message :
+         frame_log_message.event_log_messages_) {
+      if (event_log_message.type != PACKET_RECEIVED)
+        continue;
+      PacketTiming timing;
+      if (!rtp_sender->GetPacketSendRecord(
+              frame_log_message.rtp_timestamp_, event_log_message.packet_id,
+              &timing.send_time, &timing.last_byte_sent)) {
+        continue;
+      }
+      timing.arrival_time = event_log_message.event_timestamp;
+      timings->push_back(timing);
+    }
+  }
+  std::sort(timings->begin(), timings->end(),
+            [](const PacketTiming& a, const PacketTiming& b) {
+              return a.last_byte_sent < b.last_byte_sent;
+            });
+}
+
 void CastTransportImpl::OnReceivedCastMessage(
     uint32_t ssrc,
     const RtcpCastMessage& cast_message) {
@@ -145,6 +145,16 @@ class CastTransportImpl final : public CastTransport {
   void OnReceivedCastMessage(uint32_t ssrc,
                              const RtcpCastMessage& cast_message);
 
+  // Called when a RTCP report of the fraction of packets lost is received.
+  void OnReceivedPacketLoss(uint32_t ssrc, uint8_t fraction_lost);
+
+  // Matches the packets of the stream identified by |ssrc| which |log| reports
+  // as received with the records of when they were sent, and sets |timings|
+  // to the result, ordered by send time.
+  void GetPacketTimings(uint32_t ssrc,
+                        const RtcpReceiverLogMessage& log,
+                        PacketTimingList* timings);
+
   base::TickClock* const clock_;  // Not owned by this class.
   const base::TimeDelta logging_flush_interval_;
   const std::unique_ptr<Client> transport_client_;
@@ -112,6 +112,17 @@ int64_t PacedSender::GetLastByteSentForPacket(const PacketKey& packet_key) {
   return it->second.last_byte_sent;
 }
 
+bool PacedSender::GetPacketSendRecord(const PacketKey& packet_key,
+                                      base::TimeTicks* send_time,
+                                      int64_t* last_byte_sent) {
+  PacketSendHistory::const_iterator it = send_history_.find(packet_key);
+  if (it == send_history_.end() || it->second.time.is_null())
+    return false;
+  *send_time = it->second.time;
+  *last_byte_sent = it->second.last_byte_sent;
+  return true;
+}
+
 int64_t PacedSender::GetLastByteSentForSsrc(uint32_t ssrc) {
   auto it = sessions_.find(ssrc);
   // Return 0 for unknown session.
@@ -234,10 +245,9 @@ bool PacedSender::SendRtcpPacket(uint32_t ssrc, PacketRef packet) {
     priority_packet_list_[key] = make_pair(PacketType_RTCP, packet);
   } else {
     // We pass the RTCP packets straight through.
-    if (!transport_->SendPacket(
-            packet,
-            base::Bind(&PacedSender::SendStoredPackets,
-                       weak_factory_.GetWeakPtr()))) {
+    const base::Closure cb = base::Bind(&PacedSender::SendStoredPackets,
+                                        weak_factory_.GetWeakPtr());
+    if (!transport_->SendPacket(packet, cb) || !transport_->FlushBatch(cb)) {
       state_ = State_TransportBlocked;
     }
   }
@@ -377,6 +387,10 @@ void PacedSender::SendStoredPackets() {
                                 weak_factory_.GetWeakPtr());
   while (!empty()) {
     if (current_burst_size_ >= current_max_burst_size_) {
+      if (!transport_->FlushBatch(cb)) {
+        state_ = State_TransportBlocked;
+        return;
+      }
       transport_task_runner_->PostDelayedTask(FROM_HERE,
                                               cb,
                                               burst_end_ - now);
@@ -440,7 +454,8 @@ void PacedSender::SendStoredPackets() {
   }
   DCHECK_LE(send_history_buffer_.size(),
             max_burst_size_ * kMaxDedupeWindowMs / kPacingIntervalMs);
-  state_ = State_Unblocked;
+  state_ =
+      transport_->FlushBatch(cb) ? State_Unblocked : State_TransportBlocked;
 }
 
 void PacedSender::LogPacketEvent(const Packet& packet, CastLoggingEvent type) {
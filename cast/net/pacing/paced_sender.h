@@ -129,6 +129,13 @@ class PacedSender : public PacedPacketSender,
   // This function is currently only used by unittests.
   int64_t GetLastByteSentForPacket(const PacketKey& packet_key);
 
+  // Sets |send_time| to when the specified packet was last sent, and
+  // |last_byte_sent| to the total number of bytes sent to the socket just
+  // after. Returns false if the packet cannot be found or not yet sent.
+  bool GetPacketSendRecord(const PacketKey& packet_key,
+                           base::TimeTicks* send_time,
+                           int64_t* last_byte_sent);
+
   // Returns the total number of bytes sent to the socket when the last payload
   // identified by SSRC is just sent. Returns 0 for an unknown ssrc.
   // This function is currently only used by unittests.
@@ -7,6 +7,7 @@
 
 #include <algorithm>
 #include <deque>
+#include <vector>
 
 #include "base/big_endian.h"
 #include "base/macros.h"
@@ -40,7 +41,7 @@ const uint16_t kRtcpPacketIdMagic = UINT16_C(31611);
 
 class TestPacketSender : public PacketTransport {
  public:
-  TestPacketSender() : bytes_sent_(0) {}
+  TestPacketSender() : bytes_sent_(0), packets_since_flush_(0) {}
 
   bool SendPacket(PacketRef packet, const base::Closure& cb) final {
     EXPECT_FALSE(expected_packet_sizes_.empty());
@@ -61,6 +62,13 @@ class TestPacketSender : public PacketTransport {
     expected_packet_ids_.pop_front();
     EXPECT_EQ(expected_packet_id, packet_id);
 
+    ++packets_since_flush_;
+    return true;
+  }
+
+  bool FlushBatch(const base::Closure& cb) final {
+    flushed_burst_sizes_.push_back(packets_since_flush_);
+    packets_since_flush_ = 0;
     return true;
   }
 
@@ -82,10 +90,17 @@ class TestPacketSender : public PacketTransport {
 
   bool expecting_nothing_else() const { return expected_packet_sizes_.empty(); }
 
+  // The number of packets sent before each FlushBatch() call.
+  const std::vector<size_t>& flushed_burst_sizes() const {
+    return flushed_burst_sizes_;
+  }
+
  private:
   std::deque<int> expected_packet_sizes_;
   std::deque<uint16_t> expected_packet_ids_;
   int64_t bytes_sent_;
+  size_t packets_since_flush_;
+  std::vector<size_t> flushed_burst_sizes_;
 
   DISALLOW_COPY_AND_ASSIGN(TestPacketSender);
 };
@@ -236,6 +251,16 @@ TEST_F(PacedSenderTest, BasicPace) {
   }
 }
 
+TEST_F(PacedSenderTest, FlushesBatchAfterEachBurst) {
+  SendPacketVector packets = CreateSendPacketVector(kSize1, 27, false);
+  mock_transport_.AddExpectedSizesAndPacketIds(kSize1, UINT16_C(0), 27);
+  EXPECT_TRUE(paced_sender_->SendPackets(packets));
+  EXPECT_TRUE(RunUntilEmpty(5));
+
+  const std::vector<size_t> expected_burst_sizes = {10, 10, 7};
+  EXPECT_EQ(expected_burst_sizes, mock_transport_.flushed_burst_sizes());
+}
+
 TEST_F(PacedSenderTest, PaceWithNack) {
   // Testing what happen when we get multiple NACK requests for a fully lost
   // frames just as we sent the first packets in a frame.
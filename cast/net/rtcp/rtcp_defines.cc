@@ -34,6 +34,8 @@ RtcpReceiverReferenceTimeReport::~RtcpReceiverReferenceTimeReport() {}
 RtcpEvent::RtcpEvent() : type(UNKNOWN), packet_id(0u) {}
 RtcpEvent::~RtcpEvent() {}
 
+PacketTiming::PacketTiming() : last_byte_sent(0) {}
+
 RtpReceiverStatistics::RtpReceiverStatistics() :
     fraction_lost(0),
     cumulative_lost(0),
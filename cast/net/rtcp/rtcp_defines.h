@@ -126,6 +126,20 @@ struct RtcpEvent {
   uint16_t packet_id;
 };
 
+// When an RTP packet was sent, and when the receiver logged it as received.
+// The receiver only reports the lower 24 bits of its clock in milliseconds, so
+// only differences between the arrival times of nearby packets are meaningful.
+struct PacketTiming {
+  PacketTiming();
+
+  base::TimeTicks send_time;     // On the sender's clock.
+  base::TimeTicks arrival_time;  // On the receiver's clock.
+  // Total number of bytes sent to the socket just after the packet was sent.
+  int64_t last_byte_sent;
+};
+
+typedef std::vector<PacketTiming> PacketTimingList;
+
 // TODO(hubbe): Document members of this struct.
 struct RtpReceiverStatistics {
   RtpReceiverStatistics();
@@ -59,6 +59,9 @@ class RtcpParser {
   bool has_last_report() const { return has_last_report_; }
   uint32_t last_report() const { return last_report_; }
   uint32_t delay_since_last_report() const { return delay_since_last_report_; }
+  // The fraction of packets lost, in units of 1/256, from the same report
+  // block as last_report().
+  uint8_t fraction_lost() const { return fraction_lost_; }
 
   bool has_receiver_log() const { return !receiver_log_.empty(); }
   const RtcpReceiverLogMessage& receiver_log() const { return receiver_log_; }
@@ -110,6 +113,7 @@ class RtcpParser {
 
   uint32_t last_report_;
   uint32_t delay_since_last_report_;
+  uint8_t fraction_lost_;
   bool has_last_report_;
 
   // |receiver_log_| is a vector vector, no need for has_*.
@@ -132,6 +132,7 @@ bool SenderRtcpSession::IncomingRtcpPacket(const uint8_t* data, size_t length) {
     if (parser_.has_last_report()) {
       OnReceivedDelaySinceLastReport(parser_.last_report(),
                                      parser_.delay_since_last_report());
+      rtcp_observer_->OnReceivedPacketLoss(parser_.fraction_lost());
     }
     if (parser_.has_cast_message()) {
       rtcp_observer_->OnReceivedCastMessage(parser_.cast_message());
@@ -4,27 +4,83 @@
 
 #include "media/cast/net/rtp/frame_buffer.h"
 
+#include <string.h>
+
+#include <algorithm>
+
 #include "base/logging.h"
 
 namespace media {
 namespace cast {
 
+FramePayloadView::FramePayloadView() : size(0) {}
+
+FramePayloadView::~FramePayloadView() {}
+
+void FramePayloadView::CopyTo(std::string* data) const {
+  data->clear();
+  data->reserve(size);
+  for (const base::StringPiece& chunk : chunks)
+    data->append(chunk.data(), chunk.size());
+}
+
+FrameBuffer::FrameBuffer(PacketSlotPool* pool) : pool_(pool) {
+  DCHECK(pool_);
+  Reset();
+}
+
 FrameBuffer::FrameBuffer()
-    : max_packet_id_(0),
-      num_packets_received_(0),
-      max_seen_packet_id_(0),
-      new_playout_delay_ms_(0),
-      is_key_frame_(false),
-      total_data_size_(0),
-      packets_() {}
+    : owned_pool_(new PacketSlotPool()), pool_(owned_pool_.get()) {
+  Reset();
+}
 
-FrameBuffer::~FrameBuffer() {}
+FrameBuffer::~FrameBuffer() {
+  Reset();
+}
+
+void FrameBuffer::Reset() {
+  for (const PacketSlot& packet : packets_) {
+    if (packet.data)
+      pool_->Free(packet.data);
+  }
+  for (const RepairPacket& repair : repair_packets_)
+    pool_->Free(repair.payload.data);
+  packets_.clear();
+  repair_packets_.clear();
+
+  frame_id_ = FrameId();
+  max_packet_id_ = 0;
+  num_packets_received_ = 0;
+  max_seen_packet_id_ = 0;
+  new_playout_delay_ms_ = 0;
+  is_key_frame_ = false;
+  total_data_size_ = 0;
+  last_referenced_frame_id_ = FrameId();
+  rtp_timestamp_ = RtpTimeTicks();
+  num_packets_recovered_ = 0;
+}
+
+// static
+bool FrameBuffer::IsValidPacket(size_t payload_size,
+                                const RtpCastHeader& rtp_header) {
+  if (payload_size > PacketSlotPool::kSlotSize)
+    return false;
+  if (rtp_header.is_fec) {
+    return rtp_header.fec_num_packets != 0 &&
+           rtp_header.fec_first_packet_id + rtp_header.fec_num_packets - 1 <=
+               rtp_header.max_packet_id;
+  }
+  return rtp_header.packet_id <= rtp_header.max_packet_id;
+}
 
 bool FrameBuffer::InsertPacket(const uint8_t* payload_data,
                                size_t payload_size,
                                const RtpCastHeader& rtp_header) {
+  if (!IsValidPacket(payload_size, rtp_header))
+    return false;
+
   // Is this the first packet in the frame?
-  if (packets_.empty()) {
+  if (Empty()) {
     frame_id_ = rtp_header.frame_id;
     max_packet_id_ = rtp_header.max_packet_id;
     is_key_frame_ = rtp_header.is_key_frame;
@@ -33,36 +89,148 @@ bool FrameBuffer::InsertPacket(const uint8_t* payload_data,
       DCHECK_EQ(rtp_header.frame_id, rtp_header.reference_frame_id);
     last_referenced_frame_id_ = rtp_header.reference_frame_id;
     rtp_timestamp_ = rtp_header.rtp_timestamp;
+    packets_.assign(max_packet_id_ + 1, PacketSlot());
   }
   // Is this the correct frame?
   if (rtp_header.frame_id != frame_id_)
     return false;
 
-  // Insert every packet only once.
-  if (packets_.find(rtp_header.packet_id) != packets_.end()) {
+  // The first packet of the frame carries the playout delay extension, and so
+  // do repair packets, but either may be lost.
+  if (rtp_header.new_playout_delay_ms)
+    new_playout_delay_ms_ = rtp_header.new_playout_delay_ms;
+
+  if (rtp_header.is_fec)
+    return InsertRepairPacket(payload_data, payload_size, rtp_header);
+
+  if (rtp_header.packet_id > max_packet_id_)
     return false;
-  }
 
-  std::vector<uint8_t> data;
-  std::pair<PacketMap::iterator, bool> retval =
-      packets_.insert(make_pair(rtp_header.packet_id, data));
+  // Insert every packet only once.
+  PacketSlot& packet = packets_[rtp_header.packet_id];
+  if (packet.data)
+    return false;
 
   // Insert the packet.
-  retval.first->second.resize(payload_size);
-  std::copy(
-      payload_data, payload_data + payload_size, retval.first->second.begin());
-
+  packet = CopyToSlot(payload_data, payload_size);
   ++num_packets_received_;
   max_seen_packet_id_ = std::max(max_seen_packet_id_, rtp_header.packet_id);
   total_data_size_ += payload_size;
+
+  // This packet may complete the FEC group of a missing one.
+  RecoverPacket(rtp_header.packet_id);
   return true;
 }
 
+FrameBuffer::PacketSlot FrameBuffer::CopyToSlot(const uint8_t* data,
+                                                size_t size) {
+  DCHECK_LE(size, PacketSlotPool::kSlotSize);
+  PacketSlot slot;
+  slot.data = pool_->Allocate();
+  slot.size = static_cast<uint16_t>(size);
+  memcpy(slot.data, data, size);
+  return slot;
+}
+
+bool FrameBuffer::InsertRepairPacket(const uint8_t* payload_data,
+                                     size_t payload_size,
+                                     const RtpCastHeader& rtp_header) {
+  const uint16_t first_packet_id = rtp_header.fec_first_packet_id;
+  const int last_packet_id = first_packet_id + rtp_header.fec_num_packets - 1;
+  if (rtp_header.fec_num_packets == 0 || last_packet_id > max_packet_id_)
+    return false;
+  for (const RepairPacket& repair : repair_packets_) {
+    if (repair.first_packet_id == first_packet_id)
+      return false;
+  }
+
+  RepairPacket repair;
+  repair.first_packet_id = first_packet_id;
+  repair.num_packets = rtp_header.fec_num_packets;
+  repair.payload_size_xor = rtp_header.fec_payload_size_xor;
+  repair.payload = CopyToSlot(payload_data, payload_size);
+  repair_packets_.push_back(repair);
+
+  // A repair packet is sent after all packets of its group.
+  max_seen_packet_id_ =
+      std::max(max_seen_packet_id_, static_cast<uint16_t>(last_packet_id));
+
+  RecoverPacket(first_packet_id);
+  return true;
+}
+
+void FrameBuffer::RecoverPacket(uint16_t packet_id) {
+  const RepairPacket* repair = nullptr;
+  for (const RepairPacket& candidate : repair_packets_) {
+    if (packet_id >= candidate.first_packet_id &&
+        packet_id < candidate.first_packet_id + candidate.num_packets) {
+      repair = &candidate;
+      break;
+    }
+  }
+  if (!repair)
+    return;
+  const int first_packet_id = repair->first_packet_id;
+  const int end_packet_id = first_packet_id + repair->num_packets;
+
+  int missing_packet_id = -1;
+  size_t payload_size = repair->payload_size_xor;
+  for (int id = first_packet_id; id < end_packet_id; ++id) {
+    if (!packets_[id].data) {
+      if (missing_packet_id >= 0)
+        return;  // More than one packet is missing.
+      missing_packet_id = id;
+    } else if (packets_[id].size > repair->payload.size) {
+      return;  // Invalid repair packet.
+    } else {
+      payload_size ^= packets_[id].size;
+    }
+  }
+  if (missing_packet_id < 0 || payload_size > repair->payload.size)
+    return;
+
+  // XOR-ing the repair packet with all other packets of the group leaves the
+  // missing one.
+  PacketSlot recovered =
+      CopyToSlot(repair->payload.data, repair->payload.size);
+  for (int id = first_packet_id; id < end_packet_id; ++id) {
+    const PacketSlot& packet = packets_[id];
+    for (size_t i = 0; packet.data && i < packet.size; ++i)
+      recovered.data[i] ^= packet.data[i];
+  }
+  recovered.size = static_cast<uint16_t>(payload_size);
+
+  VLOG(2) << "Recovered frame " << frame_id_ << ", packet "
+          << missing_packet_id;
+  packets_[missing_packet_id] = recovered;
+  ++num_packets_received_;
+  total_data_size_ += payload_size;
+  ++num_packets_recovered_;
+}
+
 bool FrameBuffer::Complete() const {
   return num_packets_received_ - 1 == max_packet_id_;
 }
 
-bool FrameBuffer::AssembleEncodedFrame(EncodedFrame* frame) const {
+bool FrameBuffer::HasPacket(const RtpCastHeader& rtp_header) const {
+  if (Empty() || rtp_header.frame_id != frame_id_)
+    return false;
+  if (rtp_header.is_fec) {
+    for (const RepairPacket& repair : repair_packets_) {
+      if (repair.first_packet_id == rtp_header.fec_first_packet_id)
+        return true;
+    }
+    return false;
+  }
+  return rtp_header.packet_id <= max_packet_id_ &&
+         packets_[rtp_header.packet_id].data;
+}
+
+bool FrameBuffer::Empty() const {
+  return num_packets_received_ == 0 && repair_packets_.empty();
+}
+
+bool FrameBuffer::GetFrameMetadata(EncodedFrame* frame) const {
   if (!Complete())
     return false;
 
@@ -77,13 +245,36 @@ bool FrameBuffer::AssembleEncodedFrame(EncodedFrame* frame) const {
   frame->referenced_frame_id = last_referenced_frame_id_;
   frame->rtp_timestamp = rtp_timestamp_;
   frame->new_playout_delay_ms = new_playout_delay_ms_;
+  return true;
+}
+
+bool FrameBuffer::AssembleEncodedFrame(EncodedFrame* frame) const {
+  if (!GetFrameMetadata(frame))
+    return false;
 
   // Build the data vector.
   frame->data.clear();
   frame->data.reserve(total_data_size_);
-  PacketMap::const_iterator it;
-  for (it = packets_.begin(); it != packets_.end(); ++it)
-    frame->data.insert(frame->data.end(), it->second.begin(), it->second.end());
+  for (const PacketSlot& packet : packets_) {
+    frame->data.append(reinterpret_cast<const char*>(packet.data),
+                       packet.size);
+  }
+  return true;
+}
+
+bool FrameBuffer::GetEncodedFrameView(EncodedFrame* frame,
+                                      FramePayloadView* payload) const {
+  if (!GetFrameMetadata(frame))
+    return false;
+
+  frame->data.clear();
+  payload->chunks.clear();
+  payload->chunks.reserve(packets_.size());
+  for (const PacketSlot& packet : packets_) {
+    payload->chunks.push_back(base::StringPiece(
+        reinterpret_cast<const char*>(packet.data), packet.size));
+  }
+  payload->size = total_data_size_;
   return true;
 }
 
@@ -92,23 +283,13 @@ void FrameBuffer::GetMissingPackets(bool newest_frame,
   // Missing packets capped by max_seen_packet_id_.
   // (Iff it's the latest frame)
   int maximum = newest_frame ? max_seen_packet_id_ : max_packet_id_;
-  int packet = 0;
-  for (PacketMap::const_iterator i = packets_.begin();
-       i != packets_.end() && packet <= maximum;
-       ++i) {
-    int end = std::min<int>(i->first, maximum + 1);
-    while (packet < end) {
+  for (int packet = 0; packet <= maximum; ++packet) {
+    if (static_cast<size_t>(packet) >= packets_.size() ||
+        !packets_[packet].data) {
       missing_packets->insert(packet);
-      packet++;
     }
-    packet++;
-  }
-  while (packet <= maximum) {
-    missing_packets->insert(packet);
-    packet++;
   }
 }
 
-
 }  // namespace cast
 }  // namespace media
@@ -8,28 +8,68 @@
 #include <stddef.h>
 #include <stdint.h>
 
-#include <map>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "base/macros.h"
+#include "base/strings/string_piece.h"
 #include "media/cast/common/rtp_time.h"
 #include "media/cast/net/cast_transport_config.h"
+#include "media/cast/net/rtp/packet_slot_pool.h"
 #include "media/cast/net/rtp/rtp_defines.h"
 
 namespace media {
 namespace cast {
 
-typedef std::map<uint16_t, std::vector<uint8_t>> PacketMap;
+// A scatter/gather view of the data of a complete frame: the payloads of its
+// packets, in order. It points into the FrameBuffer, and is only valid until
+// the frame is released.
+struct FramePayloadView {
+  FramePayloadView();
+  ~FramePayloadView();
+
+  // Concatenates the chunks into |data|.
+  void CopyTo(std::string* data) const;
+
+  std::vector<base::StringPiece> chunks;
+  size_t size;
+};
 
 class FrameBuffer {
  public:
+  // Stores packets in slots from |pool|, which must outlive this object.
+  explicit FrameBuffer(PacketSlotPool* pool);
+  // Stores packets in slots from a pool of its own.
   FrameBuffer();
   ~FrameBuffer();
+
+  // Returns the buffer to its initial, empty state, and the slots of its
+  // packets to the pool, so that it can be reused for another frame.
+  void Reset();
+
+  // Returns false if a packet is invalid regardless of which frame it's
+  // inserted into, e.g. because its packet ID exceeds its own max packet ID.
+  static bool IsValidPacket(size_t payload_size,
+                            const RtpCastHeader& rtp_header);
+
+  // Inserts a packet of the frame. If |rtp_header| is that of an FEC repair
+  // packet, it is kept to recover the single missing packet of its group, if
+  // any, once the rest of the group has been received. Returns false if the
+  // packet belongs to another frame, was inserted already or is invalid.
+  // Inserting a valid packet into an empty buffer always succeeds.
   bool InsertPacket(const uint8_t* payload_data,
                     size_t payload_size,
                     const RtpCastHeader& rtp_header);
   bool Complete() const;
 
+  // True if the packet (or FEC repair packet) described by |rtp_header| has
+  // already been inserted or recovered.
+  bool HasPacket(const RtpCastHeader& rtp_header) const;
+
+  // True if no packet has been inserted since construction or Reset().
+  bool Empty() const;
+
   void GetMissingPackets(bool newest_frame, PacketIdSet* missing_packets) const;
 
   // If a frame is complete, sets the frame IDs and RTP timestamp in |frame|,
@@ -38,11 +78,48 @@ class FrameBuffer {
   // remains unchanged.
   bool AssembleEncodedFrame(EncodedFrame* frame) const;
 
+  // Like AssembleEncodedFrame(), but sets |payload| to a view of the data
+  // instead of copying it into |frame|, whose data is cleared.
+  bool GetEncodedFrameView(EncodedFrame* frame,
+                           FramePayloadView* payload) const;
+
   bool is_key_frame() const { return is_key_frame_; }
   FrameId last_referenced_frame_id() const { return last_referenced_frame_id_; }
   FrameId frame_id() const { return frame_id_; }
 
+  // Number of packets recovered from FEC repair packets.
+  int num_packets_recovered() const { return num_packets_recovered_; }
+
  private:
+  // A received payload, in a slot from |pool_|. |data| is null if the packet
+  // hasn't been received.
+  struct PacketSlot {
+    uint8_t* data;
+    uint16_t size;
+  };
+
+  struct RepairPacket {
+    uint16_t first_packet_id;
+    uint16_t num_packets;
+    uint16_t payload_size_xor;
+    PacketSlot payload;
+  };
+
+  // Sets the metadata of |frame| if the frame is complete.
+  bool GetFrameMetadata(EncodedFrame* frame) const;
+
+  PacketSlot CopyToSlot(const uint8_t* data, size_t size);
+  bool InsertRepairPacket(const uint8_t* payload_data,
+                          size_t payload_size,
+                          const RtpCastHeader& rtp_header);
+
+  // Recovers the missing packet of the FEC group which |packet_id| belongs to,
+  // if there is a repair packet for it and no other packet is missing.
+  void RecoverPacket(uint16_t packet_id);
+
+  std::unique_ptr<PacketSlotPool> owned_pool_;
+  PacketSlotPool* const pool_;
+
   FrameId frame_id_;
   uint16_t max_packet_id_;
   uint16_t num_packets_received_;
@@ -52,7 +129,10 @@ class FrameBuffer {
   size_t total_data_size_;
   FrameId last_referenced_frame_id_;
   RtpTimeTicks rtp_timestamp_;
-  PacketMap packets_;
+  // Indexed by packet ID. Its capacity is kept across Reset() calls.
+  std::vector<PacketSlot> packets_;
+  std::vector<RepairPacket> repair_packets_;
+  int num_packets_recovered_;
 
   DISALLOW_COPY_AND_ASSIGN(FrameBuffer);
 };
@@ -4,6 +4,8 @@
 
 #include <stdint.h>
 
+#include <string>
+
 #include "base/macros.h"
 #include "media/cast/net/cast_transport_defines.h"
 #include "media/cast/net/rtp/frame_buffer.h"
@@ -92,5 +94,91 @@ TEST_F(FrameBufferTest, IncompleteFrame) {
   EXPECT_TRUE(buffer_.Complete());
 }
 
+TEST_F(FrameBufferTest, RecoversPacketFromRepairPacket) {
+  // Packets 0 to 2 hold 3, 2 and 1 bytes.
+  const uint8_t kPackets[][3] = {{1, 2, 3}, {4, 5, 0}, {6, 0, 0}};
+  const uint8_t kRepair[] = {1 ^ 4 ^ 6, 2 ^ 5, 3};
+  rtp_header_.max_packet_id = 2;
+
+  // The repair packet may arrive before the packets it repairs.
+  RtpCastHeader repair_header = rtp_header_;
+  repair_header.packet_id = 3;
+  repair_header.is_fec = true;
+  repair_header.fec_first_packet_id = 0;
+  repair_header.fec_num_packets = 3;
+  repair_header.fec_payload_size_xor = 3 ^ 2 ^ 1;
+  EXPECT_TRUE(buffer_.InsertPacket(kRepair, sizeof(kRepair), repair_header));
+  EXPECT_FALSE(buffer_.InsertPacket(kRepair, sizeof(kRepair), repair_header));
+
+  rtp_header_.packet_id = 0;
+  EXPECT_TRUE(buffer_.InsertPacket(kPackets[0], 3, rtp_header_));
+  EXPECT_FALSE(buffer_.Complete());
+  rtp_header_.packet_id = 2;
+  EXPECT_TRUE(buffer_.InsertPacket(kPackets[2], 1, rtp_header_));
+  EXPECT_TRUE(buffer_.Complete());
+  EXPECT_EQ(1, buffer_.num_packets_recovered());
+
+  EncodedFrame frame;
+  EXPECT_TRUE(buffer_.AssembleEncodedFrame(&frame));
+  EXPECT_EQ(std::string("\x01\x02\x03\x04\x05\x06"), frame.data);
+
+  // The recovered packet is a duplicate once it arrives.
+  rtp_header_.packet_id = 1;
+  EXPECT_FALSE(buffer_.InsertPacket(kPackets[1], 2, rtp_header_));
+}
+
+TEST_F(FrameBufferTest, PayloadViewMatchesAssembledFrame) {
+  rtp_header_.max_packet_id = 1;
+  rtp_header_.packet_id = 1;
+  EXPECT_TRUE(buffer_.InsertPacket(
+      reinterpret_cast<const uint8_t*>("\x04\x05"), 2, rtp_header_));
+  EncodedFrame frame;
+  FramePayloadView payload;
+  EXPECT_FALSE(buffer_.GetEncodedFrameView(&frame, &payload));
+  rtp_header_.packet_id = 0;
+  EXPECT_TRUE(buffer_.InsertPacket(
+      reinterpret_cast<const uint8_t*>("\x01\x02\x03"), 3, rtp_header_));
+
+  frame.data = "stale";
+  EXPECT_TRUE(buffer_.GetEncodedFrameView(&frame, &payload));
+  EXPECT_TRUE(frame.data.empty());
+  ASSERT_EQ(2u, payload.chunks.size());
+  EXPECT_EQ("\x01\x02\x03", payload.chunks[0]);
+  EXPECT_EQ("\x04\x05", payload.chunks[1]);
+  EXPECT_EQ(5u, payload.size);
+
+  EncodedFrame assembled_frame;
+  EXPECT_TRUE(buffer_.AssembleEncodedFrame(&assembled_frame));
+  payload.CopyTo(&frame.data);
+  EXPECT_EQ(assembled_frame.data, frame.data);
+}
+
+TEST_F(FrameBufferTest, ResetReturnsSlotsToPool) {
+  PacketSlotPool pool;
+  FrameBuffer buffer(&pool);
+  rtp_header_.max_packet_id = 2;
+  for (int i = 0; i < 2; ++i) {
+    rtp_header_.packet_id = i;
+    EXPECT_TRUE(
+        buffer.InsertPacket(&payload_[0], payload_.size(), rtp_header_));
+  }
+  EXPECT_EQ(PacketSlotPool::kSlotsPerSlab, pool.num_slots());
+  EXPECT_EQ(PacketSlotPool::kSlotsPerSlab - 2, pool.num_free_slots());
+
+  buffer.Reset();
+  EXPECT_TRUE(buffer.Empty());
+  EXPECT_EQ(PacketSlotPool::kSlotsPerSlab, pool.num_free_slots());
+
+  // The buffer is reusable for another frame, from the same slots.
+  rtp_header_.frame_id = FrameId::first() + 1;
+  rtp_header_.max_packet_id = 0;
+  rtp_header_.packet_id = 0;
+  EXPECT_TRUE(buffer.InsertPacket(&payload_[0], payload_.size(), rtp_header_));
+  EXPECT_TRUE(buffer.Complete());
+  EXPECT_EQ(FrameId::first() + 1, buffer.frame_id());
+  EXPECT_EQ(PacketSlotPool::kSlotsPerSlab, pool.num_slots());
+  buffer.Reset();
+}
+
 }  // namespace media
 }  // namespace cast
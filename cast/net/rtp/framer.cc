@@ -4,6 +4,8 @@
 
 #include "media/cast/net/rtp/framer.h"
 
+#include <algorithm>
+
 #include "base/logging.h"
 #include "media/cast/constants.h"
 
@@ -16,6 +18,7 @@ Framer::Framer(base::TickClock* clock,
                bool decoder_faster_than_max_frame_rate,
                int max_unacked_frames)
     : decoder_faster_than_max_frame_rate_(decoder_faster_than_max_frame_rate),
+      num_frames_(0),
       cast_msg_builder_(clock,
                         incoming_payload_feedback,
                         this,
@@ -30,12 +33,23 @@ Framer::Framer(base::TickClock* clock,
 
 Framer::~Framer() {}
 
+// static
+const int Framer::kFrameRingSize;
+
 bool Framer::InsertPacket(const uint8_t* payload_data,
                           size_t payload_size,
                           const RtpCastHeader& rtp_header,
                           bool* duplicate) {
   *duplicate = false;
 
+  // Reject malformed packets before they affect any state; in particular
+  // AddFrame() may move the frame window and drop older frames.
+  if (!FrameBuffer::IsValidPacket(payload_size, rtp_header)) {
+    VLOG(3) << "Invalid packet, ignored: frame " << rtp_header.frame_id
+            << ", packet " << rtp_header.packet_id;
+    return false;
+  }
+
   if (rtp_header.is_key_frame && waiting_for_key_) {
     last_released_frame_ = rtp_header.frame_id - 1;
     waiting_for_key_ = false;
@@ -56,19 +70,23 @@ bool Framer::InsertPacket(const uint8_t* payload_data,
   }
 
   // Insert packet.
-  const auto it = frames_.find(rtp_header.frame_id);
-  FrameBuffer* buffer;
-  if (it == frames_.end()) {
-    buffer = new FrameBuffer();
-    frames_.insert(std::make_pair(rtp_header.frame_id,
-                                  std::unique_ptr<FrameBuffer>(buffer)));
-  } else {
-    buffer = it->second.get();
+  FrameBuffer* buffer = GetFrame(rtp_header.frame_id);
+  const bool new_frame = !buffer;
+  if (new_frame) {
+    buffer = AddFrame(rtp_header.frame_id);
+    if (!buffer) {
+      VLOG(3) << "Packet too old, ignored: frame " << rtp_header.frame_id;
+      return false;
+    }
   }
   if (!buffer->InsertPacket(payload_data, payload_size, rtp_header)) {
-    VLOG(3) << "Packet already received, ignored: frame " << rtp_header.frame_id
-            << ", packet " << rtp_header.packet_id;
-    *duplicate = true;
+    // Only packets which don't match the frame's earlier ones, e.g. in their
+    // max packet ID, are rejected here besides duplicates.
+    DCHECK(!new_frame);
+    *duplicate = buffer->HasPacket(rtp_header);
+    VLOG(3) << (*duplicate ? "Packet already received" : "Invalid packet")
+            << ", ignored: frame " << rtp_header.frame_id << ", packet "
+            << rtp_header.packet_id;
     return false;
   }
 
@@ -79,6 +97,19 @@ bool Framer::InsertPacket(const uint8_t* payload_data,
 bool Framer::GetEncodedFrame(EncodedFrame* frame,
                              bool* next_frame,
                              bool* have_multiple_decodable_frames) {
+  FramePayloadView payload;
+  if (!GetEncodedFrameView(frame, &payload, next_frame,
+                           have_multiple_decodable_frames)) {
+    return false;
+  }
+  payload.CopyTo(&frame->data);
+  return true;
+}
+
+bool Framer::GetEncodedFrameView(EncodedFrame* frame,
+                                 FramePayloadView* payload,
+                                 bool* next_frame,
+                                 bool* have_multiple_decodable_frames) {
   *have_multiple_decodable_frames = HaveMultipleDecodableFrames();
 
   // Find frame id.
@@ -97,7 +128,7 @@ bool Framer::GetEncodedFrame(EncodedFrame* frame,
     *next_frame = false;
   }
 
-  return buffer->AssembleEncodedFrame(frame);
+  return buffer->GetEncodedFrameView(frame, payload);
 }
 
 void Framer::AckFrame(FrameId frame_id) {
@@ -106,9 +137,17 @@ void Framer::AckFrame(FrameId frame_id) {
 }
 
 void Framer::ReleaseFrame(FrameId frame_id) {
-  const auto it = frames_.begin();
-  const bool skipped_old_frame = it->first < frame_id;
-  frames_.erase(it, frames_.upper_bound(frame_id));
+  bool skipped_old_frame = false;
+  for (FrameId id = first_frame_id_;
+       num_frames_ > 0 && id <= frame_id && id <= last_frame_id_; ++id) {
+    FrameBuffer* const buffer = GetFrame(id);
+    if (!buffer)
+      continue;
+    skipped_old_frame |= id < frame_id;
+    RemoveFrame(buffer);
+  }
+  if (frame_id >= first_frame_id_)
+    first_frame_id_ = frame_id + 1;
   last_released_frame_ = frame_id;
   if (skipped_old_frame)
     cast_msg_builder_.UpdateCastMessage();
@@ -122,26 +161,84 @@ void Framer::SendCastMessage() {
   cast_msg_builder_.UpdateCastMessage();
 }
 
+FrameBuffer* Framer::GetFrame(FrameId frame_id) const {
+  if (num_frames_ == 0 || frame_id < first_frame_id_ ||
+      frame_id > last_frame_id_) {
+    return nullptr;
+  }
+  FrameBuffer* const buffer = frame_ring_[frame_id.lower_8_bits()].get();
+  if (!buffer || buffer->Empty() || buffer->frame_id() != frame_id)
+    return nullptr;
+  return buffer;
+}
+
+FrameBuffer* Framer::AddFrame(FrameId frame_id) {
+  if (num_frames_ == 0) {
+    first_frame_id_ = last_frame_id_ = frame_id;
+  } else if (frame_id < first_frame_id_) {
+    if (last_frame_id_ - frame_id >= kFrameRingSize)
+      return nullptr;
+    first_frame_id_ = frame_id;
+  } else if (frame_id > last_frame_id_) {
+    // Drop the frames which don't fit in the ring anymore. These are far older
+    // than the sender keeps unacknowledged frames for.
+    const FrameId new_first_frame_id = frame_id - (kFrameRingSize - 1);
+    for (FrameId id = first_frame_id_;
+         num_frames_ > 0 && id < new_first_frame_id; ++id) {
+      FrameBuffer* const buffer = GetFrame(id);
+      if (buffer) {
+        VLOG(1) << "Dropping frame " << id << " to make room for frame "
+                << frame_id;
+        RemoveFrame(buffer);
+      }
+    }
+    if (num_frames_ == 0)
+      first_frame_id_ = frame_id;
+    else
+      first_frame_id_ = std::max(first_frame_id_, new_first_frame_id);
+    last_frame_id_ = frame_id;
+  }
+
+  std::unique_ptr<FrameBuffer>& buffer = frame_ring_[frame_id.lower_8_bits()];
+  if (!buffer)
+    buffer.reset(new FrameBuffer(&packet_pool_));
+  DCHECK(buffer->Empty());
+  ++num_frames_;
+  return buffer.get();
+}
+
+void Framer::RemoveFrame(FrameBuffer* buffer) {
+  DCHECK_GT(num_frames_, 0);
+  buffer->Reset();
+  --num_frames_;
+}
+
 FrameBuffer* Framer::FindNextFrameForRelease() {
-  for (const auto& entry : frames_) {
-    if (entry.second->Complete() && IsNextFrameForRelease(*entry.second))
-      return entry.second.get();
+  for (FrameId id = first_frame_id_; num_frames_ > 0 && id <= last_frame_id_;
+       ++id) {
+    FrameBuffer* const buffer = GetFrame(id);
+    if (buffer && buffer->Complete() && IsNextFrameForRelease(*buffer))
+      return buffer;
   }
   return nullptr;
 }
 
 FrameBuffer* Framer::FindOldestDecodableFrame() {
-  for (const auto& entry : frames_) {
-    if (entry.second->Complete() && IsDecodableFrame(*entry.second))
-      return entry.second.get();
+  for (FrameId id = first_frame_id_; num_frames_ > 0 && id <= last_frame_id_;
+       ++id) {
+    FrameBuffer* const buffer = GetFrame(id);
+    if (buffer && buffer->Complete() && IsDecodableFrame(*buffer))
+      return buffer;
   }
   return nullptr;
 }
 
 bool Framer::HaveMultipleDecodableFrames() const {
   bool found_one = false;
-  for (const auto& entry : frames_) {
-    if (entry.second->Complete() && IsDecodableFrame(*entry.second)) {
+  for (FrameId id = first_frame_id_; num_frames_ > 0 && id <= last_frame_id_;
+       ++id) {
+    FrameBuffer* const buffer = GetFrame(id);
+    if (buffer && buffer->Complete() && IsDecodableFrame(*buffer)) {
       if (found_one)
         return true;  // Found another.
       else
@@ -151,29 +248,31 @@ bool Framer::HaveMultipleDecodableFrames() const {
   return false;
 }
 
-bool Framer::Empty() const { return frames_.empty(); }
+bool Framer::Empty() const { return num_frames_ == 0; }
 
 int Framer::NumberOfCompleteFrames() const {
   int count = 0;
-  for (const auto& entry : frames_) {
-    if (entry.second->Complete())
+  for (FrameId id = first_frame_id_; num_frames_ > 0 && id <= last_frame_id_;
+       ++id) {
+    FrameBuffer* const buffer = GetFrame(id);
+    if (buffer && buffer->Complete())
       ++count;
   }
   return count;
 }
 
 bool Framer::FrameExists(FrameId frame_id) const {
-  return frames_.end() != frames_.find(frame_id);
+  return GetFrame(frame_id) != nullptr;
 }
 
 void Framer::GetMissingPackets(FrameId frame_id,
                                bool last_frame,
                                PacketIdSet* missing_packets) const {
-  const auto it = frames_.find(frame_id);
-  if (it == frames_.end())
+  const FrameBuffer* const buffer = GetFrame(frame_id);
+  if (!buffer)
     return;
 
-  it->second->GetMissingPackets(last_frame, missing_packets);
+  buffer->GetMissingPackets(last_frame, missing_packets);
 }
 
 bool Framer::IsNextFrameForRelease(const FrameBuffer& buffer) const {
@@ -8,7 +8,6 @@
 #include <stddef.h>
 #include <stdint.h>
 
-#include <map>
 #include <memory>
 
 #include "base/macros.h"
@@ -16,6 +15,7 @@
 #include "base/time/time.h"
 #include "media/cast/net/rtp/cast_message_builder.h"
 #include "media/cast/net/rtp/frame_buffer.h"
+#include "media/cast/net/rtp/packet_slot_pool.h"
 #include "media/cast/net/rtp/rtp_defines.h"
 
 namespace media {
@@ -47,6 +47,14 @@ class Framer {
                        bool* next_frame,
                        bool* have_multiple_complete_frames);
 
+  // Like GetEncodedFrame(), but leaves the data of |frame| empty and sets
+  // |payload| to a view of it instead, which is valid until the frame is
+  // released. This avoids copying the data of frames which are skipped.
+  bool GetEncodedFrameView(EncodedFrame* frame,
+                           FramePayloadView* payload,
+                           bool* next_frame,
+                           bool* have_multiple_complete_frames);
+
   // TODO(hubbe): Move this elsewhere.
   void AckFrame(FrameId frame_id);
 
@@ -67,6 +75,19 @@ class Framer {
                          PacketIdSet* missing_packets) const;
 
  private:
+  // Number of frames which can be held at once. The frames held are at most
+  // kFrameRingSize - 1 apart, so that a frame's buffer is indexed by the lower
+  // 8 bits of its ID, which is also what is sent on the wire.
+  static const int kFrameRingSize = 256;
+
+  // Returns the buffer of |frame_id|, or nullptr if it is not held.
+  FrameBuffer* GetFrame(FrameId frame_id) const;
+
+  // Returns an empty buffer for |frame_id|, dropping the oldest frames if
+  // necessary to make room for it, or nullptr if |frame_id| is too old.
+  FrameBuffer* AddFrame(FrameId frame_id);
+  void RemoveFrame(FrameBuffer* buffer);
+
   // Identifies the next frame to be released (rendered) and returns its
   // associated buffer, or returns nullptr there is none.
   FrameBuffer* FindNextFrameForRelease();
@@ -83,7 +104,19 @@ class Framer {
   bool IsDecodableFrame(const FrameBuffer& frame) const;
 
   const bool decoder_faster_than_max_frame_rate_;
-  std::map<FrameId, std::unique_ptr<FrameBuffer>> frames_;
+
+  // Holds the packets of all frames. Must outlive |frame_ring_|.
+  PacketSlotPool packet_pool_;
+
+  // The buffers of the frames being received, indexed by the lower 8 bits of
+  // their frame ID. Buffers are created on first use, and reused afterwards.
+  // The frames held are |num_frames_| of the frames from |first_frame_id_| to
+  // |last_frame_id_|.
+  std::unique_ptr<FrameBuffer> frame_ring_[kFrameRingSize];
+  FrameId first_frame_id_;
+  FrameId last_frame_id_;
+  int num_frames_;
+
   CastMessageBuilder cast_msg_builder_;
   bool waiting_for_key_;
   FrameId last_released_frame_;
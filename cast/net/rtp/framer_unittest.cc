@@ -4,6 +4,8 @@
 
 #include <stdint.h>
 
+#include <vector>
+
 #include "base/macros.h"
 #include "base/test/simple_test_tick_clock.h"
 #include "media/cast/net/cast_transport_defines.h"
@@ -453,5 +455,134 @@ TEST_F(FramerTest, SkipsMissingFramesWhenLaterKeyFramesAreAvailable) {
   framer_.ReleaseFrame(frame.frame_id);
 }
 
+TEST_F(FramerTest, GetEncodedFrameView) {
+  EncodedFrame frame;
+  FramePayloadView payload;
+  bool next_frame = false;
+  bool multiple = false;
+  bool duplicate = false;
+
+  rtp_header_.is_key_frame = true;
+  rtp_header_.max_packet_id = 1;
+  framer_.InsertPacket(&payload_[0], payload_.size(), rtp_header_, &duplicate);
+  rtp_header_.packet_id = 1;
+  EXPECT_TRUE(
+      framer_.InsertPacket(&payload_[0], 10, rtp_header_, &duplicate));
+  EXPECT_TRUE(framer_.GetEncodedFrameView(&frame, &payload, &next_frame,
+                                          &multiple));
+  EXPECT_TRUE(next_frame);
+  EXPECT_EQ(FrameId::first(), frame.frame_id);
+  EXPECT_TRUE(frame.data.empty());
+  ASSERT_EQ(2u, payload.chunks.size());
+  EXPECT_EQ(payload_.size(), payload.chunks[0].size());
+  EXPECT_EQ(10u, payload.chunks[1].size());
+  EXPECT_EQ(payload_.size() + 10, payload.size);
+
+  // GetEncodedFrame() returns the same frame, with its data copied.
+  EXPECT_TRUE(framer_.GetEncodedFrame(&frame, &next_frame, &multiple));
+  EXPECT_EQ(payload_.size() + 10, frame.data.size());
+  framer_.ReleaseFrame(frame.frame_id);
+  EXPECT_TRUE(framer_.Empty());
+}
+
+TEST_F(FramerTest, DropsFramesTooFarBehindNewestFrame) {
+  bool duplicate = false;
+
+  // Frame 0 is complete, frame 1 misses a packet.
+  rtp_header_.is_key_frame = true;
+  framer_.InsertPacket(&payload_[0], payload_.size(), rtp_header_, &duplicate);
+  rtp_header_.frame_id = FrameId::first() + 1;
+  rtp_header_.reference_frame_id = FrameId::first() + 1;
+  rtp_header_.max_packet_id = 1;
+  framer_.InsertPacket(&payload_[0], payload_.size(), rtp_header_, &duplicate);
+  EXPECT_TRUE(framer_.FrameExists(FrameId::first()));
+  EXPECT_TRUE(framer_.FrameExists(FrameId::first() + 1));
+
+  // A frame 256 frames ahead takes the place of frame 0 in the ring.
+  rtp_header_.frame_id = FrameId::first() + 256;
+  rtp_header_.reference_frame_id = FrameId::first() + 256;
+  rtp_header_.max_packet_id = 0;
+  EXPECT_TRUE(framer_.InsertPacket(&payload_[0], payload_.size(), rtp_header_,
+                                   &duplicate));
+  EXPECT_FALSE(framer_.FrameExists(FrameId::first()));
+  EXPECT_TRUE(framer_.FrameExists(FrameId::first() + 1));
+  EXPECT_TRUE(framer_.FrameExists(FrameId::first() + 256));
+  EXPECT_EQ(1, framer_.NumberOfCompleteFrames());
+
+  // Packets of frames which have been dropped are ignored.
+  rtp_header_.frame_id = FrameId::first();
+  rtp_header_.reference_frame_id = FrameId::first();
+  EXPECT_FALSE(framer_.InsertPacket(&payload_[0], payload_.size(), rtp_header_,
+                                    &duplicate));
+  EXPECT_FALSE(framer_.FrameExists(FrameId::first()));
+
+  // A frame far ahead drops all other frames.
+  rtp_header_.frame_id = FrameId::first() + 1000;
+  rtp_header_.reference_frame_id = FrameId::first() + 1000;
+  framer_.InsertPacket(&payload_[0], payload_.size(), rtp_header_, &duplicate);
+  EXPECT_FALSE(framer_.FrameExists(FrameId::first() + 1));
+  EXPECT_FALSE(framer_.FrameExists(FrameId::first() + 256));
+  EXPECT_EQ(1, framer_.NumberOfCompleteFrames());
+}
+
+TEST_F(FramerTest, InvalidPacketsAreNotDuplicatesAndKeepFrames) {
+  bool duplicate = false;
+
+  // Frame 0 is complete, frame 1 misses a packet.
+  rtp_header_.is_key_frame = true;
+  framer_.InsertPacket(&payload_[0], payload_.size(), rtp_header_, &duplicate);
+  rtp_header_.frame_id = FrameId::first() + 1;
+  rtp_header_.reference_frame_id = FrameId::first() + 1;
+  rtp_header_.max_packet_id = 1;
+  framer_.InsertPacket(&payload_[0], payload_.size(), rtp_header_, &duplicate);
+
+  // An invalid packet of a frame 256 frames ahead neither drops frame 0 nor
+  // becomes the newest frame.
+  rtp_header_.frame_id = FrameId::first() + 256;
+  rtp_header_.reference_frame_id = FrameId::first() + 256;
+  rtp_header_.packet_id = 2;
+  duplicate = true;
+  EXPECT_FALSE(framer_.InsertPacket(&payload_[0], payload_.size(), rtp_header_,
+                                    &duplicate));
+  EXPECT_FALSE(duplicate);
+  EXPECT_TRUE(framer_.FrameExists(FrameId::first()));
+  EXPECT_TRUE(framer_.FrameExists(FrameId::first() + 1));
+  EXPECT_FALSE(framer_.FrameExists(FrameId::first() + 256));
+  EXPECT_EQ(1, framer_.NumberOfCompleteFrames());
+
+  // Neither is a packet larger than any IP packet.
+  rtp_header_.packet_id = 0;
+  std::vector<uint8_t> oversized(kMaxIpPacketSize + 1);
+  EXPECT_FALSE(framer_.InsertPacket(&oversized[0], oversized.size(),
+                                    rtp_header_, &duplicate));
+  EXPECT_FALSE(duplicate);
+  EXPECT_TRUE(framer_.FrameExists(FrameId::first()));
+  EXPECT_FALSE(framer_.FrameExists(FrameId::first() + 256));
+
+  // A packet of frame 1 which doesn't match the frame's max packet ID is
+  // rejected, but isn't a duplicate either.
+  rtp_header_.frame_id = FrameId::first() + 1;
+  rtp_header_.reference_frame_id = FrameId::first() + 1;
+  rtp_header_.packet_id = 2;
+  rtp_header_.max_packet_id = 2;
+  EXPECT_FALSE(framer_.InsertPacket(&payload_[0], payload_.size(), rtp_header_,
+                                    &duplicate));
+  EXPECT_FALSE(duplicate);
+
+  // A packet which has been received already is.
+  rtp_header_.packet_id = 0;
+  rtp_header_.max_packet_id = 1;
+  EXPECT_FALSE(framer_.InsertPacket(&payload_[0], payload_.size(), rtp_header_,
+                                    &duplicate));
+  EXPECT_TRUE(duplicate);
+
+  // Frame 1 can still be completed.
+  rtp_header_.packet_id = 1;
+  EXPECT_TRUE(framer_.InsertPacket(&payload_[0], payload_.size(), rtp_header_,
+                                   &duplicate));
+  EXPECT_FALSE(duplicate);
+  EXPECT_EQ(2, framer_.NumberOfCompleteFrames());
+}
+
 }  // namespace cast
 }  // namespace media
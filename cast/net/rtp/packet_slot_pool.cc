@@ -0,0 +1,43 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/cast/net/rtp/packet_slot_pool.h"
+
+#include "base/logging.h"
+
+namespace media {
+namespace cast {
+
+// static
+const size_t PacketSlotPool::kSlotSize;
+const size_t PacketSlotPool::kSlotsPerSlab;
+
+PacketSlotPool::PacketSlotPool() {}
+
+PacketSlotPool::~PacketSlotPool() {
+  DCHECK_EQ(num_slots(), num_free_slots()) << "Slots still in use.";
+}
+
+uint8_t* PacketSlotPool::Allocate() {
+  if (free_slots_.empty()) {
+    uint8_t* const slab = new uint8_t[kSlotsPerSlab * kSlotSize];
+    slabs_.push_back(std::unique_ptr<uint8_t[]>(slab));
+    // Reserve room for all slots, so that Free() never allocates.
+    free_slots_.reserve(num_slots());
+    for (size_t i = kSlotsPerSlab; i > 0; --i)
+      free_slots_.push_back(slab + (i - 1) * kSlotSize);
+  }
+  uint8_t* const slot = free_slots_.back();
+  free_slots_.pop_back();
+  return slot;
+}
+
+void PacketSlotPool::Free(uint8_t* slot) {
+  DCHECK(slot);
+  DCHECK_LT(free_slots_.size(), num_slots());
+  free_slots_.push_back(slot);
+}
+
+}  // namespace cast
+}  // namespace media
@@ -0,0 +1,51 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_CAST_NET_RTP_PACKET_SLOT_POOL_H_
+#define MEDIA_CAST_NET_RTP_PACKET_SLOT_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <vector>
+
+#include "base/macros.h"
+#include "media/cast/net/cast_transport_defines.h"
+
+namespace media {
+namespace cast {
+
+// Hands out fixed size buffers, or slots, for the payloads of received
+// packets. Slots are carved out of slabs of kSlotsPerSlab slots, and freed
+// slots are reused, so that once the pool has grown to the number of packets
+// in flight, storing a packet doesn't allocate. Slots are reused last in,
+// first out, to reuse memory which is likely still cached.
+class PacketSlotPool {
+ public:
+  static const size_t kSlotSize = kMaxIpPacketSize;
+  static const size_t kSlotsPerSlab = 64;
+
+  PacketSlotPool();
+  // All slots must have been freed.
+  ~PacketSlotPool();
+
+  // Returns a slot of kSlotSize bytes.
+  uint8_t* Allocate();
+  void Free(uint8_t* slot);
+
+  size_t num_slots() const { return slabs_.size() * kSlotsPerSlab; }
+  size_t num_free_slots() const { return free_slots_.size(); }
+
+ private:
+  std::vector<std::unique_ptr<uint8_t[]>> slabs_;
+  std::vector<uint8_t*> free_slots_;
+
+  DISALLOW_COPY_AND_ASSIGN(PacketSlotPool);
+};
+
+}  // namespace cast
+}  // namespace media
+
+#endif  // MEDIA_CAST_NET_RTP_PACKET_SLOT_POOL_H_
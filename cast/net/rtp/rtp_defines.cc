@@ -15,7 +15,12 @@ RtpCastHeader::RtpCastHeader()
       is_key_frame(false),
       packet_id(0),
       max_packet_id(0),
-      new_playout_delay_ms(0) {}
+      new_playout_delay_ms(0),
+      num_extensions(0),
+      is_fec(false),
+      fec_first_packet_id(0),
+      fec_num_packets(0),
+      fec_payload_size_xor(0) {}
 
 RtpPayloadFeedback::~RtpPayloadFeedback() {}
 
@@ -27,6 +27,11 @@ static const uint8_t kCastExtensionCountmask = 0x3f;
 
 // Cast RTP extensions.
 static const uint8_t kCastRtpExtensionAdaptiveLatency = 1;
+static const uint8_t kCastRtpExtensionFec = 2;
+
+// Size of the FEC extension's data: the first packet ID and number of packets
+// of the repaired group, and the XOR of their payload sizes.
+static const uint16_t kCastFecExtensionLength = 6;
 
 struct RtpCastHeader {
   RtpCastHeader();
@@ -47,6 +52,16 @@ struct RtpCastHeader {
   FrameId reference_frame_id;
   uint16_t new_playout_delay_ms;
   uint8_t num_extensions;
+
+  // Set for forward error correction (FEC) repair packets, whose |packet_id|
+  // follows |max_packet_id|. The payload of a repair packet is the XOR of the
+  // payloads of packets [fec_first_packet_id, fec_first_packet_id +
+  // fec_num_packets), zero-padded to the longest one, and
+  // |fec_payload_size_xor| the XOR of their sizes.
+  bool is_fec;
+  uint16_t fec_first_packet_id;
+  uint16_t fec_num_packets;
+  uint16_t fec_payload_size_xor;
 };
 
 class RtpPayloadFeedback {
@@ -4,6 +4,7 @@
 
 #include "media/cast/net/rtp/rtp_packetizer.h"
 
+#include <algorithm>
 #include <string>
 
 #include "base/big_endian.h"
@@ -18,7 +19,8 @@ RtpPacketizerConfig::RtpPacketizerConfig()
     : payload_type(-1),
       max_payload_length(kMaxIpPacketSize - 28),  // Default is IP-v4/UDP.
       sequence_number(0),
-      ssrc(0) {}
+      ssrc(0),
+      fec_group_size(0) {}
 
 RtpPacketizerConfig::~RtpPacketizerConfig() {}
 
@@ -30,7 +32,8 @@ RtpPacketizer::RtpPacketizer(PacedSender* const transport,
       packet_storage_(packet_storage),
       sequence_number_(config_.sequence_number),
       send_packet_count_(0),
-      send_octet_count_(0) {
+      send_octet_count_(0),
+      send_fec_packet_count_(0) {
   DCHECK(transport) << "Invalid argument";
 }
 
@@ -43,11 +46,15 @@ uint16_t RtpPacketizer::NextSequenceNumber() {
 
 void RtpPacketizer::SendFrameAsPackets(const EncodedFrame& frame) {
   uint16_t rtp_header_length = kRtpHeaderLength + kCastHeaderLength;
+  // Repair packets are as large as the packets they repair, plus the FEC
+  // extension.
+  if (config_.fec_group_size > 0)
+    rtp_header_length += 2 + kCastFecExtensionLength;
   uint16_t max_length = config_.max_payload_length - rtp_header_length - 1;
 
   // Split the payload evenly (round number up).
   size_t num_packets = (frame.data.size() + max_length) / max_length;
-  size_t payload_length = (frame.data.size() + num_packets) / num_packets;
+  const size_t payload_length = (frame.data.size() + num_packets) / num_packets;
   DCHECK_LE(payload_length, max_length) << "Invalid argument";
 
   SendPacketVector packets;
@@ -63,46 +70,19 @@ void RtpPacketizer::SendFrameAsPackets(const EncodedFrame& frame) {
   while (remaining_size > 0) {
     PacketRef packet(new base::RefCountedData<Packet>);
 
-    if (remaining_size < payload_length) {
-      payload_length = remaining_size;
-    }
-    remaining_size -= payload_length;
+    const size_t length = std::min(payload_length, remaining_size);
+    remaining_size -= length;
     BuildCommonRTPheader(
         &packet->data, remaining_size == 0, frame.rtp_timestamp);
 
-    // Build Cast header.
-    // TODO(miu): Should we always set the ref frame bit and the ref_frame_id?
-    DCHECK_NE(frame.dependency, EncodedFrame::UNKNOWN_DEPENDENCY);
-    uint8_t byte0 = kCastReferenceFrameIdBitMask;
-    if (frame.dependency == EncodedFrame::KEY)
-      byte0 |= kCastKeyFrameBitMask;
     // Extensions only go on the first packet of the frame
     const uint16_t packet_id = static_cast<uint16_t>(packets.size());
-    if (packet_id == 0)
-      byte0 |= num_extensions;
-    packet->data.push_back(byte0);
-    packet->data.push_back(frame.frame_id.lower_8_bits());
-    size_t start_size = packet->data.size();
-    packet->data.resize(start_size + 4);
-    base::BigEndianWriter big_endian_writer(
-        reinterpret_cast<char*>(&(packet->data[start_size])), 4);
-    big_endian_writer.WriteU16(packet_id);
-    big_endian_writer.WriteU16(static_cast<uint16_t>(num_packets - 1));
-    packet->data.push_back(frame.referenced_frame_id.lower_8_bits());
-    // Add extension details only on the first packet of the frame
-    if (packet_id == 0 && frame.new_playout_delay_ms) {
-      packet->data.push_back(kCastRtpExtensionAdaptiveLatency << 2);
-      packet->data.push_back(2);  // 2 bytes
-      packet->data.push_back(
-          static_cast<uint8_t>(frame.new_playout_delay_ms >> 8));
-      packet->data.push_back(static_cast<uint8_t>(frame.new_playout_delay_ms));
-    }
+    BuildCastHeader(frame, packet_id, static_cast<uint16_t>(num_packets - 1),
+                    packet_id == 0 ? num_extensions : 0, &packet->data);
 
     // Copy payload data.
-    packet->data.insert(packet->data.end(),
-                        data_iter,
-                        data_iter + payload_length);
-    data_iter += payload_length;
+    packet->data.insert(packet->data.end(), data_iter, data_iter + length);
+    data_iter += length;
 
     packets.push_back(make_pair(PacketKey(frame.reference_time, config_.ssrc,
                                           frame.frame_id, packet_id),
@@ -110,16 +90,109 @@ void RtpPacketizer::SendFrameAsPackets(const EncodedFrame& frame) {
 
     // Update stats.
     ++send_packet_count_;
-    send_octet_count_ += payload_length;
+    send_octet_count_ += length;
   }
   DCHECK_EQ(num_packets, packets.size()) << "Invalid state";
 
+  // Only media packets are retransmitted; repair packets are sent once.
   packet_storage_->StoreFrame(frame.frame_id, packets);
+  if (config_.fec_group_size > 0)
+    AppendFecPackets(frame, payload_length, &packets);
 
   // Send to network.
   transport_->SendPackets(packets);
 }
 
+void RtpPacketizer::BuildCastHeader(const EncodedFrame& frame,
+                                    uint16_t packet_id,
+                                    uint16_t max_packet_id,
+                                    uint8_t num_extensions,
+                                    Packet* packet) {
+  // TODO(miu): Should we always set the ref frame bit and the ref_frame_id?
+  DCHECK_NE(frame.dependency, EncodedFrame::UNKNOWN_DEPENDENCY);
+  uint8_t byte0 = kCastReferenceFrameIdBitMask;
+  if (frame.dependency == EncodedFrame::KEY)
+    byte0 |= kCastKeyFrameBitMask;
+  byte0 |= num_extensions;
+  packet->push_back(byte0);
+  packet->push_back(frame.frame_id.lower_8_bits());
+  size_t start_size = packet->size();
+  packet->resize(start_size + 4);
+  base::BigEndianWriter big_endian_writer(
+      reinterpret_cast<char*>(&((*packet)[start_size])), 4);
+  big_endian_writer.WriteU16(packet_id);
+  big_endian_writer.WriteU16(max_packet_id);
+  packet->push_back(frame.referenced_frame_id.lower_8_bits());
+  if (num_extensions > 0 && frame.new_playout_delay_ms) {
+    packet->push_back(kCastRtpExtensionAdaptiveLatency << 2);
+    packet->push_back(2);  // 2 bytes
+    packet->push_back(static_cast<uint8_t>(frame.new_playout_delay_ms >> 8));
+    packet->push_back(static_cast<uint8_t>(frame.new_playout_delay_ms));
+  }
+}
+
+void RtpPacketizer::AppendFecPackets(const EncodedFrame& frame,
+                                     size_t payload_length,
+                                     SendPacketVector* packets) {
+  const size_t num_packets = packets->size();
+  const size_t group_size = static_cast<size_t>(config_.fec_group_size);
+  const uint16_t max_packet_id = static_cast<uint16_t>(num_packets - 1);
+  // Repair packets also carry the adaptive latency extension, so that it is
+  // not lost with the first packet of the frame.
+  const uint8_t num_extensions = frame.new_playout_delay_ms ? 2 : 1;
+  DCHECK_LE(num_packets + (num_packets + group_size - 1) / group_size,
+            UINT16_C(0xffff));
+
+  for (size_t first = 0; first < num_packets; first += group_size) {
+    const size_t group_packets = std::min(group_size, num_packets - first);
+    const uint16_t packet_id = static_cast<uint16_t>(packets->size());
+
+    PacketRef packet(new base::RefCountedData<Packet>);
+    BuildCommonRTPheader(&packet->data, false, frame.rtp_timestamp);
+    BuildCastHeader(frame, packet_id, max_packet_id, num_extensions,
+                    &packet->data);
+    packet->data.push_back(kCastRtpExtensionFec << 2);
+    packet->data.push_back(kCastFecExtensionLength);
+    const size_t extension_start = packet->data.size();
+
+    // Only the last packet of a frame is shorter than |payload_length|, so the
+    // first packet of the group is the longest one.
+    const size_t repair_length =
+        std::min(payload_length, frame.data.size() - first * payload_length);
+    packet->data.resize(extension_start + kCastFecExtensionLength +
+                        repair_length);
+    uint8_t* const repair_data =
+        &packet->data[extension_start + kCastFecExtensionLength];
+    uint16_t payload_size_xor = 0;
+    for (size_t i = first; i < first + group_packets; ++i) {
+      const size_t offset = i * payload_length;
+      const size_t length =
+          std::min(payload_length, frame.data.size() - offset);
+      const uint8_t* const data =
+          reinterpret_cast<const uint8_t*>(frame.data.data()) + offset;
+      for (size_t j = 0; j < length; ++j)
+        repair_data[j] ^= data[j];
+      payload_size_xor ^= static_cast<uint16_t>(length);
+    }
+
+    base::BigEndianWriter big_endian_writer(
+        reinterpret_cast<char*>(&packet->data[extension_start]),
+        kCastFecExtensionLength);
+    big_endian_writer.WriteU16(static_cast<uint16_t>(first));
+    big_endian_writer.WriteU16(static_cast<uint16_t>(group_packets));
+    big_endian_writer.WriteU16(payload_size_xor);
+
+    packets->push_back(make_pair(PacketKey(frame.reference_time, config_.ssrc,
+                                           frame.frame_id, packet_id),
+                                 packet));
+
+    // Update stats.
+    ++send_packet_count_;
+    ++send_fec_packet_count_;
+    send_octet_count_ += repair_length;
+  }
+}
+
 void RtpPacketizer::BuildCommonRTPheader(Packet* packet,
                                          bool marker_bit,
                                          RtpTimeTicks rtp_timestamp) {
@@ -32,6 +32,10 @@ struct RtpPacketizerConfig {
 
   // SSRC.
   unsigned int ssrc;
+
+  // Forward error correction: one XOR repair packet is sent for every group of
+  // up to |fec_group_size| packets of a frame. Zero disables FEC.
+  int fec_group_size;
 };
 
 // This object is only called from the main cast thread.
@@ -50,14 +54,38 @@ class RtpPacketizer {
   // incremental sequence numbers for every packet (including retransmissions).
   uint16_t NextSequenceNumber();
 
+  // Changes the FEC group size for the frames sent from now on, see
+  // RtpPacketizerConfig.
+  void set_fec_group_size(int fec_group_size) {
+    config_.fec_group_size = fec_group_size;
+  }
+  int fec_group_size() const { return config_.fec_group_size; }
+
   size_t send_packet_count() const { return send_packet_count_; }
   size_t send_octet_count() const { return send_octet_count_; }
+  size_t send_fec_packet_count() const { return send_fec_packet_count_; }
 
  private:
   void BuildCommonRTPheader(Packet* packet,
                             bool marker_bit,
                             RtpTimeTicks rtp_timestamp);
 
+  // Appends the Cast header and, if set, the adaptive latency extension of
+  // |frame| to |packet|. |num_extensions| counts the extensions of the packet,
+  // including the adaptive latency one.
+  void BuildCastHeader(const EncodedFrame& frame,
+                       uint16_t packet_id,
+                       uint16_t max_packet_id,
+                       uint8_t num_extensions,
+                       Packet* packet);
+
+  // Appends one repair packet per FEC group to |packets|, which holds the
+  // media packets of |frame|, each carrying |payload_length| bytes of it
+  // except for the last one.
+  void AppendFecPackets(const EncodedFrame& frame,
+                        size_t payload_length,
+                        SendPacketVector* packets);
+
   RtpPacketizerConfig config_;
   PacedSender* const transport_;  // Not owned by this class.
   PacketStorage* packet_storage_;
@@ -66,6 +94,7 @@ class RtpPacketizer {
 
   size_t send_packet_count_;
   size_t send_octet_count_;
+  size_t send_fec_packet_count_;
 };
 
 }  // namespace cast
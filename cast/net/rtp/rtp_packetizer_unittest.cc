@@ -8,11 +8,13 @@
 #include <stdint.h>
 
 #include <memory>
+#include <vector>
 
 #include "base/macros.h"
 #include "base/test/simple_test_tick_clock.h"
 #include "media/base/fake_single_thread_task_runner.h"
 #include "media/cast/net/pacing/paced_sender.h"
+#include "media/cast/net/rtp/frame_buffer.h"
 #include "media/cast/net/rtp/packet_storage.h"
 #include "media/cast/net/rtp/rtp_parser.h"
 #include "testing/gmock/include/gmock/gmock.h"
@@ -35,6 +37,7 @@ class TestRtpPacketTransport : public PacketTransport {
       : config_(config),
         sequence_number_(kSeqNum),
         packets_sent_(0),
+        fec_packets_sent_(0),
         expected_number_of_packets_(0),
         expected_packet_id_(0),
         expected_frame_id_(FrameId::first() + 1) {}
@@ -66,13 +69,22 @@ class TestRtpPacketTransport : public PacketTransport {
   }
 
   bool SendPacket(PacketRef packet, const base::Closure& cb) final {
-    ++packets_sent_;
+    sent_packets_.push_back(packet);
     RtpParser parser(kSsrc, kPayload);
     RtpCastHeader rtp_header;
     const uint8_t* payload_data;
     size_t payload_size;
-    parser.ParsePacket(&packet->data[0], packet->data.size(), &rtp_header,
-                       &payload_data, &payload_size);
+    EXPECT_TRUE(parser.ParsePacket(&packet->data[0], packet->data.size(),
+                                   &rtp_header, &payload_data, &payload_size));
+    if (rtp_header.is_fec) {
+      // Repair packets follow all packets of the frame.
+      ++fec_packets_sent_;
+      VerifyCommonRtpHeader(rtp_header);
+      EXPECT_EQ(expected_number_of_packets_, packets_sent_);
+      ++sequence_number_;
+      return true;
+    }
+    ++packets_sent_;
     VerifyRtpHeader(rtp_header);
     ++sequence_number_;
     ++expected_packet_id_;
@@ -87,6 +99,8 @@ class TestRtpPacketTransport : public PacketTransport {
   void StopReceiving() final {}
 
   size_t number_of_packets_received() const { return packets_sent_; }
+  size_t number_of_fec_packets_received() const { return fec_packets_sent_; }
+  const std::vector<PacketRef>& sent_packets() const { return sent_packets_; }
 
   void set_expected_number_of_packets(size_t expected_number_of_packets) {
     expected_number_of_packets_ = expected_number_of_packets;
@@ -99,6 +113,8 @@ class TestRtpPacketTransport : public PacketTransport {
   RtpPacketizerConfig config_;
   uint32_t sequence_number_;
   size_t packets_sent_;
+  size_t fec_packets_sent_;
+  std::vector<PacketRef> sent_packets_;
   size_t number_of_packets_;
   size_t expected_number_of_packets_;
   // Assuming packets arrive in sequence.
@@ -195,5 +211,56 @@ TEST_F(RtpPacketizerTest, Stats) {
   EXPECT_EQ(expected_num_of_packets, transport_->number_of_packets_received());
 }
 
+TEST_F(RtpPacketizerTest, FecRecoversLostPackets) {
+  for (size_t i = 0; i < video_frame_.data.size(); ++i)
+    video_frame_.data[i] = static_cast<char>(i * 7);
+  const size_t expected_num_of_packets = kFrameSize / kMaxPacketLength + 1;
+  transport_->set_expected_number_of_packets(expected_num_of_packets);
+  transport_->set_rtp_timestamp(video_frame_.rtp_timestamp);
+  rtp_packetizer_->set_fec_group_size(2);
+
+  testing_clock_.Advance(base::TimeDelta::FromMilliseconds(kTimestampMs));
+  video_frame_.reference_time = testing_clock_.NowTicks();
+  video_frame_.new_playout_delay_ms = 500;
+  rtp_packetizer_->SendFrameAsPackets(video_frame_);
+  RunTasks(33 + 1);
+  EXPECT_EQ(expected_num_of_packets, transport_->number_of_packets_received());
+  EXPECT_EQ(2u, transport_->number_of_fec_packets_received());
+  EXPECT_EQ(2u, rtp_packetizer_->send_fec_packet_count());
+
+  // Losing one packet of each group, including the first packet of the frame
+  // and the shorter last one, is repaired without retransmission. Losing two
+  // packets of a group is not.
+  const uint16_t kLostPackets[][2] = {{0, 2}, {1, 3}, {0, 1}};
+  for (const uint16_t* lost : kLostPackets) {
+    FrameBuffer buffer;
+    RtpParser parser(kSsrc, kPayload);
+    for (const PacketRef& packet : transport_->sent_packets()) {
+      RtpCastHeader rtp_header;
+      const uint8_t* payload_data;
+      size_t payload_size;
+      ASSERT_TRUE(parser.ParsePacket(&packet->data[0], packet->data.size(),
+                                     &rtp_header, &payload_data,
+                                     &payload_size));
+      if (!rtp_header.is_fec &&
+          (rtp_header.packet_id == lost[0] || rtp_header.packet_id == lost[1]))
+        continue;
+      EXPECT_TRUE(buffer.InsertPacket(payload_data, payload_size, rtp_header));
+    }
+
+    EncodedFrame frame;
+    if (lost[1] - lost[0] == 1) {
+      EXPECT_FALSE(buffer.Complete());
+      EXPECT_EQ(0, buffer.num_packets_recovered());
+      continue;
+    }
+    EXPECT_TRUE(buffer.Complete());
+    EXPECT_EQ(2, buffer.num_packets_recovered());
+    ASSERT_TRUE(buffer.AssembleEncodedFrame(&frame));
+    EXPECT_EQ(video_frame_.data, frame.data);
+    EXPECT_EQ(500, frame.new_playout_delay_ms);
+  }
+}
+
 }  // namespace cast
 }  // namespace media
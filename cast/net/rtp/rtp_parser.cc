@@ -85,9 +85,6 @@ bool RtpParser::ParsePacket(const uint8_t* packet,
       !reader.ReadU16(&header->max_packet_id)) {
     return false;
   }
-  // Sanity-check: Do the packet ID values make sense w.r.t. each other?
-  if (header->max_packet_id < header->packet_id)
-    return false;
   uint8_t truncated_reference_frame_id;
   if (!header->is_reference) {
     // By default, a key frame only references itself; and non-key frames
@@ -100,6 +97,7 @@ bool RtpParser::ParsePacket(const uint8_t* packet,
   }
 
   header->num_extensions = bits & kCastExtensionCountmask;
+  header->is_fec = false;
   for (int i = 0; i < header->num_extensions; i++) {
     uint16_t type_and_size;
     if (!reader.ReadU16(&type_and_size))
@@ -112,9 +110,32 @@ bool RtpParser::ParsePacket(const uint8_t* packet,
       case kCastRtpExtensionAdaptiveLatency:
         if (!chunk.ReadU16(&header->new_playout_delay_ms))
           return false;
+        break;
+      case kCastRtpExtensionFec:
+        if (!chunk.ReadU16(&header->fec_first_packet_id) ||
+            !chunk.ReadU16(&header->fec_num_packets) ||
+            !chunk.ReadU16(&header->fec_payload_size_xor)) {
+          return false;
+        }
+        header->is_fec = true;
+        break;
     }
   }
 
+  // Sanity-check: Do the packet ID values make sense w.r.t. each other?  FEC
+  // repair packets are numbered after the frame's last packet, and must repair
+  // packets within the frame.
+  if (header->is_fec) {
+    if (header->packet_id <= header->max_packet_id ||
+        header->fec_num_packets == 0 ||
+        header->fec_first_packet_id + header->fec_num_packets - 1 >
+            header->max_packet_id) {
+      return false;
+    }
+  } else if (header->max_packet_id < header->packet_id) {
+    return false;
+  }
+
   last_parsed_rtp_timestamp_ = header->rtp_timestamp;
 
   header->frame_id = last_parsed_frame_id_.Expand(truncated_frame_id);
@@ -4,6 +4,8 @@
 
 #include "media/cast/net/rtp/rtp_sender.h"
 
+#include <algorithm>
+
 #include "base/big_endian.h"
 #include "base/logging.h"
 #include "base/rand_util.h"
@@ -14,6 +16,14 @@ namespace cast {
 
 namespace {
 
+// FEC group sizes, i.e. the number of packets per repair packet. The group
+// size is chosen so that the overhead is about kFecLossMultiplier times the
+// reported loss, which keeps the chance of losing two packets of a group, which
+// can't be recovered without retransmission, low.
+const int kMinFecGroupSize = 2;
+const int kMaxFecGroupSize = 16;
+const int kFecLossMultiplier = 4;
+
 // If there is only one referecne to the packet then copy the
 // reference and return.
 // Otherwise return a deep copy of the packet.
@@ -29,7 +39,9 @@ RtpSender::RtpSender(
     const scoped_refptr<base::SingleThreadTaskRunner>& transport_task_runner,
     PacedSender* const transport)
     : transport_(transport),
+      fec_enabled_(false),
       transport_task_runner_(transport_task_runner),
+      last_sent_frame_id_(FrameId::first() - 1),
       weak_factory_(this) {
   // Randomly set sequence number start value.
   config_.sequence_number = base::RandInt(0, 65535);
@@ -47,6 +59,10 @@ bool RtpSender::Initialize(const CastTransportRtpConfig& config) {
     config_.payload_type = 127;
   else
     config_.payload_type = 96;
+  // Until the receiver reports packet loss, send a repair packet per maximum
+  // sized group.
+  fec_enabled_ = config.enable_fec;
+  config_.fec_group_size = fec_enabled_ ? kMaxFecGroupSize : 0;
   packetizer_.reset(new RtpPacketizer(transport_, &storage_, config_));
   return true;
 }
@@ -54,6 +70,8 @@ bool RtpSender::Initialize(const CastTransportRtpConfig& config) {
 void RtpSender::SendFrame(const EncodedFrame& frame) {
   DCHECK(packetizer_);
   packetizer_->SendFrameAsPackets(frame);
+  frame_rtp_timestamps_[frame.frame_id.lower_8_bits()] = frame.rtp_timestamp;
+  last_sent_frame_id_ = std::max(last_sent_frame_id_, frame.frame_id);
   LOG_IF(DFATAL, storage_.GetNumberOfStoredFrames() > kMaxUnackedFrames)
       << "Possible bug: Frames are not being actively released from storage.";
 }
@@ -146,6 +164,23 @@ void RtpSender::ResendFrameForKickstart(FrameId frame_id,
   ResendPackets(missing_frames_and_packets, false, dedup_info);
 }
 
+void RtpSender::OnReceivedPacketLoss(uint8_t fraction_lost) {
+  if (!fec_enabled_ || !packetizer_)
+    return;
+  int fec_group_size = 0;
+  if (fraction_lost > 0) {
+    fec_group_size = std::max(
+        kMinFecGroupSize,
+        std::min(kMaxFecGroupSize, 256 / (kFecLossMultiplier * fraction_lost)));
+  }
+  if (fec_group_size != packetizer_->fec_group_size()) {
+    VLOG(1) << "SSRC " << config_.ssrc << ": FEC group size "
+            << fec_group_size << " for " << fraction_lost * 100 / 256
+            << "% packet loss.";
+    packetizer_->set_fec_group_size(fec_group_size);
+  }
+}
+
 void RtpSender::UpdateSequenceNumber(Packet* packet) {
   // TODO(miu): This is an abstraction violation.  This needs to be a part of
   // the overall packet (de)serialization consolidation.
@@ -164,5 +199,33 @@ int64_t RtpSender::GetLastByteSentForFrame(FrameId frame_id) {
   return transport_->GetLastByteSentForPacket(last_packet_key);
 }
 
+bool RtpSender::GetPacketSendRecord(RtpTimeTicks rtp_timestamp,
+                                    uint16_t packet_id,
+                                    base::TimeTicks* send_time,
+                                    int64_t* last_byte_sent) {
+  // Only unacknowledged frames are stored, so the frame is a recent one. The
+  // upper bits of |rtp_timestamp| are expanded by the RTCP parser, and may
+  // differ from ours.
+  for (int i = 0; i < kMaxUnackedFrames; ++i) {
+    const FrameId frame_id = last_sent_frame_id_ - i;
+    if (frame_rtp_timestamps_[frame_id.lower_8_bits()].lower_32_bits() !=
+        rtp_timestamp.lower_32_bits()) {
+      continue;
+    }
+    const SendPacketVector* stored_packets =
+        storage_.GetFramePackets(frame_id);
+    if (!stored_packets)
+      return false;
+    for (const auto& packet : *stored_packets) {
+      if (packet.first.packet_id == packet_id) {
+        return transport_->GetPacketSendRecord(packet.first, send_time,
+                                               last_byte_sent);
+      }
+    }
+    return false;
+  }
+  return false;
+}
+
 }  //  namespace cast
 }  // namespace media
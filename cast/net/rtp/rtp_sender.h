@@ -55,16 +55,32 @@ class RtpSender {
   // partially.
   int64_t GetLastByteSentForFrame(FrameId frame_id);
 
+  // Looks up the send record of the packet |packet_id| of the frame with
+  // |rtp_timestamp|, see PacedSender::GetPacketSendRecord(). Returns false if
+  // the frame has been released from storage already, or the packet is not
+  // yet sent.
+  bool GetPacketSendRecord(RtpTimeTicks rtp_timestamp,
+                           uint16_t packet_id,
+                           base::TimeTicks* send_time,
+                           int64_t* last_byte_sent);
+
   void CancelSendingFrames(const std::vector<FrameId>& frame_ids);
 
   void ResendFrameForKickstart(FrameId frame_id, base::TimeDelta dedupe_window);
 
+  // Adapts the FEC overhead to the fraction of packets lost, in units of
+  // 1/256, as reported by the receiver. No-op if FEC is disabled.
+  void OnReceivedPacketLoss(uint8_t fraction_lost);
+
   size_t send_packet_count() const {
     return packetizer_ ? packetizer_->send_packet_count() : 0;
   }
   size_t send_octet_count() const {
     return packetizer_ ? packetizer_->send_octet_count() : 0;
   }
+  size_t send_fec_packet_count() const {
+    return packetizer_ ? packetizer_->send_fec_packet_count() : 0;
+  }
   uint32_t ssrc() const { return config_.ssrc; }
 
  private:
@@ -74,8 +90,14 @@ class RtpSender {
   PacketStorage storage_;
   std::unique_ptr<RtpPacketizer> packetizer_;
   PacedSender* const transport_;
+  bool fec_enabled_;
   scoped_refptr<base::SingleThreadTaskRunner> transport_task_runner_;
 
+  // The RTP timestamps of the frames sent, indexed by the lower 8 bits of
+  // their frame ID, to find the frames which receiver logs refer to.
+  RtpTimeTicks frame_rtp_timestamps_[256];
+  FrameId last_sent_frame_id_;
+
   // NOTE: Weak pointers must be invalidated before all other member variables.
   base::WeakPtrFactory<RtpSender> weak_factory_;
 
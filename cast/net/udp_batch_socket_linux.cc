@@ -0,0 +1,308 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/cast/net/udp_batch_socket_linux.h"
+
+#include <errno.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/callback_helpers.h"
+#include "base/logging.h"
+#include "base/posix/eintr_wrapper.h"
+#include "net/base/net_errors.h"
+
+// Defined by <linux/udp.h> since Linux 4.18, which older sysroots lack.
+#ifndef UDP_SEGMENT
+#define UDP_SEGMENT 103
+#endif
+
+namespace media {
+namespace cast {
+
+namespace {
+
+// The kernel limits a GSO message to 64 segments and a 64 KB payload.
+const size_t kMaxSegmentsPerMessage = 64;
+const size_t kMaxSegmentationOffloadBytes = 65507;
+
+bool IsWouldBlock(int error) {
+  return error == EAGAIN || error == EWOULDBLOCK;
+}
+
+}  // namespace
+
+// static
+const size_t UdpBatchSocket::kMaxBatchSize;
+
+UdpBatchSocket::UdpBatchSocket()
+    : address_family_(net::ADDRESS_FAMILY_UNSPECIFIED),
+      segmentation_offload_(false),
+      num_received_(0) {
+  memset(send_messages_, 0, sizeof(send_messages_));
+  memset(recv_messages_, 0, sizeof(recv_messages_));
+}
+
+UdpBatchSocket::~UdpBatchSocket() {
+  Close();
+}
+
+int UdpBatchSocket::Open(net::AddressFamily address_family) {
+  DCHECK(!socket_.is_valid());
+  const int domain =
+      address_family == net::ADDRESS_FAMILY_IPV6 ? AF_INET6 : AF_INET;
+  socket_.reset(
+      socket(domain, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, IPPROTO_UDP));
+  if (!socket_.is_valid())
+    return net::MapSystemError(errno);
+  address_family_ = address_family;
+  return net::OK;
+}
+
+int UdpBatchSocket::AllowAddressReuse() {
+  const int value = 1;
+  if (setsockopt(socket_.get(), SOL_SOCKET, SO_REUSEADDR, &value,
+                 sizeof(value)) < 0) {
+    return net::MapSystemError(errno);
+  }
+  return net::OK;
+}
+
+int UdpBatchSocket::Bind(const net::IPEndPoint& address) {
+  sockaddr_storage storage;
+  socklen_t length = sizeof(storage);
+  if (!address.ToSockAddr(reinterpret_cast<sockaddr*>(&storage), &length))
+    return net::ERR_ADDRESS_INVALID;
+  if (bind(socket_.get(), reinterpret_cast<sockaddr*>(&storage), length) < 0)
+    return net::MapSystemError(errno);
+  return net::OK;
+}
+
+int UdpBatchSocket::Connect(const net::IPEndPoint& address) {
+  sockaddr_storage storage;
+  socklen_t length = sizeof(storage);
+  if (!address.ToSockAddr(reinterpret_cast<sockaddr*>(&storage), &length))
+    return net::ERR_ADDRESS_INVALID;
+  if (HANDLE_EINTR(connect(socket_.get(), reinterpret_cast<sockaddr*>(&storage),
+                           length)) < 0) {
+    return net::MapSystemError(errno);
+  }
+  return net::OK;
+}
+
+int UdpBatchSocket::SetSendBufferSize(int32_t size) {
+  if (setsockopt(socket_.get(), SOL_SOCKET, SO_SNDBUF, &size, sizeof(size)) <
+      0) {
+    return net::MapSystemError(errno);
+  }
+  return net::OK;
+}
+
+int UdpBatchSocket::SetDiffServCodePoint(net::DiffServCodePoint dscp) {
+  if (dscp == net::DSCP_NO_CHANGE)
+    return net::OK;
+  // The two low bits of the traffic class are ECN, which is left cleared.
+  const int traffic_class = dscp << 2;
+  const int result =
+      address_family_ == net::ADDRESS_FAMILY_IPV6
+          ? setsockopt(socket_.get(), IPPROTO_IPV6, IPV6_TCLASS,
+                       &traffic_class, sizeof(traffic_class))
+          : setsockopt(socket_.get(), IPPROTO_IP, IP_TOS, &traffic_class,
+                       sizeof(traffic_class));
+  if (result < 0)
+    return net::MapSystemError(errno);
+  return net::OK;
+}
+
+void UdpBatchSocket::Close() {
+  read_watcher_.reset();
+  write_watcher_.reset();
+  read_callback_.Reset();
+  write_callback_.Reset();
+  socket_.reset();
+}
+
+bool UdpBatchSocket::EnableSegmentationOffload() {
+  // Kernels without GSO reject the socket option, whereas they would silently
+  // ignore the control message and send each message as one large datagram.
+  const int segment_size = 0;
+  if (setsockopt(socket_.get(), IPPROTO_UDP, UDP_SEGMENT, &segment_size,
+                 sizeof(segment_size)) < 0) {
+    return false;
+  }
+  segmentation_offload_ = true;
+  return true;
+}
+
+size_t UdpBatchSocket::BuildSendMessages(const PacketRef* packets,
+                                         size_t num_packets,
+                                         const net::IPEndPoint* address) {
+  socklen_t address_length = 0;
+  if (address) {
+    address_length = sizeof(send_address_);
+    if (!address->ToSockAddr(reinterpret_cast<sockaddr*>(&send_address_),
+                             &address_length)) {
+      return 0;
+    }
+  }
+
+  size_t num_messages = 0;
+  size_t packet_index = 0;
+  while (packet_index < num_packets) {
+    mmsghdr* const message = &send_messages_[num_messages];
+    memset(message, 0, sizeof(*message));
+    if (address) {
+      message->msg_hdr.msg_name = &send_address_;
+      message->msg_hdr.msg_namelen = address_length;
+    }
+    message->msg_hdr.msg_iov = &send_iovecs_[packet_index];
+
+    // With segmentation offload, a message holds a run of packets of the
+    // first packet's size, the last of which may be shorter.
+    const size_t segment_size = packets[packet_index]->data.size();
+    size_t message_bytes = 0;
+    size_t message_packets = 0;
+    while (packet_index + message_packets < num_packets) {
+      const Packet& packet = packets[packet_index + message_packets]->data;
+      if (message_packets > 0 &&
+          (!segmentation_offload_ ||
+           message_packets == kMaxSegmentsPerMessage ||
+           packet.size() > segment_size ||
+           message_bytes + packet.size() > kMaxSegmentationOffloadBytes)) {
+        break;
+      }
+      iovec* const iov = &send_iovecs_[packet_index + message_packets];
+      iov->iov_base = const_cast<uint8_t*>(packet.data());
+      iov->iov_len = packet.size();
+      message_bytes += packet.size();
+      ++message_packets;
+      if (packet.size() < segment_size)
+        break;
+    }
+    message->msg_hdr.msg_iovlen = message_packets;
+
+    if (message_packets > 1) {
+      message->msg_hdr.msg_control = send_control_[num_messages];
+      message->msg_hdr.msg_controllen = sizeof(send_control_[num_messages]);
+      cmsghdr* const control = CMSG_FIRSTHDR(&message->msg_hdr);
+      control->cmsg_level = IPPROTO_UDP;
+      control->cmsg_type = UDP_SEGMENT;
+      control->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+      const uint16_t gso_size = static_cast<uint16_t>(segment_size);
+      memcpy(CMSG_DATA(control), &gso_size, sizeof(gso_size));
+    }
+
+    message_packets_[num_messages] = message_packets;
+    packet_index += message_packets;
+    ++num_messages;
+  }
+  return num_messages;
+}
+
+int UdpBatchSocket::SendPackets(const PacketRef* packets,
+                                size_t num_packets,
+                                const net::IPEndPoint* address,
+                                const base::Closure& callback) {
+  DCHECK(socket_.is_valid());
+  DCHECK(write_callback_.is_null());
+  DCHECK_GT(num_packets, 0u);
+  num_packets = std::min(num_packets, kMaxBatchSize);
+
+  const size_t num_messages = BuildSendMessages(packets, num_packets, address);
+  if (!num_messages)
+    return net::ERR_ADDRESS_INVALID;
+
+  const int result = HANDLE_EINTR(
+      sendmmsg(socket_.get(), send_messages_, num_messages, 0));
+  if (result < 0) {
+    const int error = errno;
+    if (IsWouldBlock(error)) {
+      write_callback_ = callback;
+      write_watcher_ = base::FileDescriptorWatcher::WatchWritable(
+          socket_.get(),
+          base::Bind(&UdpBatchSocket::OnWritable, base::Unretained(this)));
+      return net::ERR_IO_PENDING;
+    }
+    if (segmentation_offload_ && message_packets_[0] > 1 &&
+        (error == EINVAL || error == EIO)) {
+      LOG(WARNING) << "UDP segmentation offload unsupported, disabling it.";
+      segmentation_offload_ = false;
+      return SendPackets(packets, num_packets, address, callback);
+    }
+    return net::MapSystemError(error);
+  }
+
+  size_t packets_sent = 0;
+  for (int i = 0; i < result; ++i)
+    packets_sent += message_packets_[i];
+  return static_cast<int>(packets_sent);
+}
+
+int UdpBatchSocket::ReceivePackets(const base::Closure& callback) {
+  DCHECK(socket_.is_valid());
+  DCHECK(read_callback_.is_null());
+
+  // Refill the slots whose packets were taken, and rearm the others.
+  for (size_t i = 0; i < kMaxBatchSize; ++i) {
+    if (!recv_packets_[i])
+      recv_packets_[i].reset(new Packet(kMaxIpPacketSize));
+    else
+      recv_packets_[i]->resize(kMaxIpPacketSize);
+    recv_iovecs_[i].iov_base = recv_packets_[i]->data();
+    recv_iovecs_[i].iov_len = kMaxIpPacketSize;
+    memset(&recv_messages_[i], 0, sizeof(recv_messages_[i]));
+    recv_messages_[i].msg_hdr.msg_name = &recv_addresses_[i];
+    recv_messages_[i].msg_hdr.msg_namelen = sizeof(recv_addresses_[i]);
+    recv_messages_[i].msg_hdr.msg_iov = &recv_iovecs_[i];
+    recv_messages_[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  num_received_ = 0;
+  const int result = HANDLE_EINTR(
+      recvmmsg(socket_.get(), recv_messages_, kMaxBatchSize, 0, nullptr));
+  if (result < 0) {
+    if (IsWouldBlock(errno)) {
+      read_callback_ = callback;
+      read_watcher_ = base::FileDescriptorWatcher::WatchReadable(
+          socket_.get(),
+          base::Bind(&UdpBatchSocket::OnReadable, base::Unretained(this)));
+      return net::ERR_IO_PENDING;
+    }
+    return net::MapSystemError(errno);
+  }
+  num_received_ = result;
+  return result;
+}
+
+std::unique_ptr<Packet> UdpBatchSocket::TakeReceivedPacket(
+    size_t index,
+    net::IPEndPoint* address) {
+  DCHECK_LT(index, num_received_);
+  DCHECK(recv_packets_[index]);
+  const msghdr& header = recv_messages_[index].msg_hdr;
+  if (!address->FromSockAddr(reinterpret_cast<const sockaddr*>(header.msg_name),
+                             header.msg_namelen)) {
+    *address = net::IPEndPoint();
+  }
+  recv_packets_[index]->resize(recv_messages_[index].msg_len);
+  return std::move(recv_packets_[index]);
+}
+
+void UdpBatchSocket::OnReadable() {
+  read_watcher_.reset();
+  base::ResetAndReturn(&read_callback_).Run();
+}
+
+void UdpBatchSocket::OnWritable() {
+  write_watcher_.reset();
+  base::ResetAndReturn(&write_callback_).Run();
+}
+
+}  // namespace cast
+}  // namespace media
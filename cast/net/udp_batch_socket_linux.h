@@ -0,0 +1,119 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_CAST_NET_UDP_BATCH_SOCKET_LINUX_H_
+#define MEDIA_CAST_NET_UDP_BATCH_SOCKET_LINUX_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+
+#include <memory>
+
+#include "base/callback.h"
+#include "base/files/file_descriptor_watcher_posix.h"
+#include "base/files/scoped_file.h"
+#include "base/macros.h"
+#include "media/cast/net/cast_transport_defines.h"
+#include "net/base/address_family.h"
+#include "net/base/ip_endpoint.h"
+#include "net/socket/diff_serv_code_point.h"
+
+namespace media {
+namespace cast {
+
+// A non-blocking UDP socket which sends and receives batches of datagrams
+// with one sendmmsg() or recvmmsg() system call each, rather than one call
+// per datagram as net::UDPSocket does. Optionally, runs of equally sized
+// packets are sent as single UDP generic segmentation offload (GSO) messages,
+// which the kernel or NIC splits into datagrams.
+//
+// Methods returning an int return a net error code, as their net::UDPSocket
+// counterparts do. Must be used on a thread with a
+// base::FileDescriptorWatcher.
+class UdpBatchSocket {
+ public:
+  // Maximum number of datagrams sent or received per system call.
+  static const size_t kMaxBatchSize = 64;
+
+  UdpBatchSocket();
+  ~UdpBatchSocket();
+
+  int Open(net::AddressFamily address_family);
+  int AllowAddressReuse();
+  int Bind(const net::IPEndPoint& address);
+  int Connect(const net::IPEndPoint& address);
+  int SetSendBufferSize(int32_t size);
+  int SetDiffServCodePoint(net::DiffServCodePoint dscp);
+  void Close();
+
+  // Sends runs of equally sized packets as GSO messages from now on. Returns
+  // false if the kernel doesn't support GSO. If sending a GSO message fails
+  // later on, e.g. because the route doesn't support checksum offload, falls
+  // back to one datagram per packet. Must be called after Open().
+  bool EnableSegmentationOffload();
+
+  // Sends the first |num_packets| of |packets|, up to kMaxBatchSize, to
+  // |address|, or to the connected address if |address| is null. Returns the
+  // number of packets sent, which may be fewer than requested, or a net error
+  // for the first packet. If the socket's send buffer is full, returns
+  // net::ERR_IO_PENDING and runs |callback| once it can be written to again.
+  int SendPackets(const PacketRef* packets,
+                  size_t num_packets,
+                  const net::IPEndPoint* address,
+                  const base::Closure& callback);
+
+  // Receives up to kMaxBatchSize datagrams into the receive ring. Returns the
+  // number received, or a net error. If no datagram is waiting, returns
+  // net::ERR_IO_PENDING and runs |callback| once one arrives.
+  int ReceivePackets(const base::Closure& callback);
+
+  // Takes the |index|th datagram received by the last ReceivePackets() call,
+  // and sets |address| to its source address. Its ring slot is refilled by the
+  // next ReceivePackets() call.
+  std::unique_ptr<Packet> TakeReceivedPacket(size_t index,
+                                             net::IPEndPoint* address);
+
+ private:
+  void OnReadable();
+  void OnWritable();
+
+  // Fills |send_messages_| with up to |num_packets| of |packets| and returns
+  // the number of messages.
+  size_t BuildSendMessages(const PacketRef* packets,
+                           size_t num_packets,
+                           const net::IPEndPoint* address);
+
+  base::ScopedFD socket_;
+  net::AddressFamily address_family_;
+  bool segmentation_offload_;
+
+  // State of the last SendPackets() call. |message_packets_| holds the
+  // number of packets in each message.
+  mmsghdr send_messages_[kMaxBatchSize];
+  iovec send_iovecs_[kMaxBatchSize];
+  size_t message_packets_[kMaxBatchSize];
+  char send_control_[kMaxBatchSize][CMSG_SPACE(sizeof(uint16_t))];
+  sockaddr_storage send_address_;
+
+  // The receive ring: one preallocated packet per datagram of a batch.
+  mmsghdr recv_messages_[kMaxBatchSize];
+  iovec recv_iovecs_[kMaxBatchSize];
+  sockaddr_storage recv_addresses_[kMaxBatchSize];
+  std::unique_ptr<Packet> recv_packets_[kMaxBatchSize];
+  size_t num_received_;
+
+  base::Closure read_callback_;
+  base::Closure write_callback_;
+  std::unique_ptr<base::FileDescriptorWatcher::Controller> read_watcher_;
+  std::unique_ptr<base::FileDescriptorWatcher::Controller> write_watcher_;
+
+  DISALLOW_COPY_AND_ASSIGN(UdpBatchSocket);
+};
+
+}  // namespace cast
+}  // namespace media
+
+#endif  // MEDIA_CAST_NET_UDP_BATCH_SOCKET_LINUX_H_
@@ -18,6 +18,10 @@
 #include "net/base/rand_callback.h"
 #include "net/log/net_log_source.h"
 
+#if defined(OS_LINUX)
+#include "media/cast/net/udp_batch_socket_linux.h"
+#endif
+
 namespace media {
 namespace cast {
 
@@ -27,6 +31,10 @@ const char kOptionDscp[] = "DSCP";
 #if defined(OS_WIN)
 const char kOptionDisableNonBlockingIO[] = "disable_non_blocking_io";
 #endif
+#if defined(OS_LINUX)
+const char kOptionBatchedIO[] = "batched_io";
+const char kOptionUdpGso[] = "udp_gso";
+#endif
 const char kOptionSendBufferMinSize[] = "send_buffer_min_size";
 const char kOptionPacerMaxBurstSize[] = "pacer_max_burst_size";
 
@@ -80,6 +88,9 @@ UdpTransport::UdpTransport(
                         media::cast::kMaxIpPacketSize),
       status_callback_(status_callback),
       bytes_sent_(0),
+#if defined(OS_LINUX)
+      segmentation_offload_(false),
+#endif
       weak_factory_(this) {
   DCHECK(!IsEmpty(local_end_point) || !IsEmpty(remote_end_point));
 }
@@ -90,6 +101,19 @@ void UdpTransport::StartReceiving(
     const PacketReceiverCallbackWithStatus& packet_receiver) {
   DCHECK(io_thread_proxy_->RunsTasksOnCurrentThread());
 
+#if defined(OS_LINUX)
+  if (batch_socket_) {
+    packet_receiver_ = packet_receiver;
+    if (!OpenBatchSocket()) {
+      batch_socket_.reset();
+      status_callback_.Run(TRANSPORT_SOCKET_ERROR);
+      return;
+    }
+    ScheduleReceiveNextPacket();
+    return;
+  }
+#endif
+
   if (!udp_socket_) {
     status_callback_.Run(TRANSPORT_SOCKET_ERROR);
     return;
@@ -148,6 +172,87 @@ void UdpTransport::UseNonBlockingIO() {
 }
 #endif
 
+#if defined(OS_LINUX)
+void UdpTransport::UseBatchedIO(bool segmentation_offload) {
+  DCHECK(io_thread_proxy_->RunsTasksOnCurrentThread());
+  DCHECK(packet_receiver_.is_null());
+  if (!udp_socket_)
+    return;
+  udp_socket_.reset();
+  batch_socket_.reset(new UdpBatchSocket());
+  segmentation_offload_ = segmentation_offload;
+}
+
+bool UdpTransport::OpenBatchSocket() {
+  if (!IsEmpty(local_addr_)) {
+    if (batch_socket_->Open(local_addr_.GetFamily()) < 0 ||
+        batch_socket_->AllowAddressReuse() < 0 ||
+        batch_socket_->Bind(local_addr_) < 0) {
+      LOG(ERROR) << "Failed to bind local address.";
+      return false;
+    }
+  } else if (!IsEmpty(remote_addr_)) {
+    if (batch_socket_->Open(remote_addr_.GetFamily()) < 0 ||
+        batch_socket_->AllowAddressReuse() < 0 ||
+        batch_socket_->Connect(remote_addr_) < 0) {
+      LOG(ERROR) << "Failed to connect to remote address.";
+      return false;
+    }
+    client_connected_ = true;
+  } else {
+    NOTREACHED() << "Either local or remote address has to be defined.";
+  }
+  if (batch_socket_->SetSendBufferSize(send_buffer_size_) != net::OK) {
+    LOG(WARNING) << "Failed to set socket send buffer size.";
+  }
+  if (segmentation_offload_ && !batch_socket_->EnableSegmentationOffload()) {
+    VLOG(1) << "UDP segmentation offload is not supported.";
+  }
+  return true;
+}
+
+void UdpTransport::ReceiveNextBatch() {
+  DCHECK(io_thread_proxy_->RunsTasksOnCurrentThread());
+
+  // Loop while packets are waiting.  When none are, break and expect this
+  // method to be called back in the future when a packet is ready.
+  while (!packet_receiver_.is_null() && batch_socket_) {
+    const int result = batch_socket_->ReceivePackets(base::Bind(
+        &UdpTransport::ReceiveNextBatch, weak_factory_.GetWeakPtr()));
+    if (result == net::ERR_IO_PENDING) {
+      receive_pending_ = true;
+      return;
+    }
+    if (result < 0) {
+      VLOG(1) << "Failed to receive packets: Status code is " << result;
+      receive_pending_ = false;
+      return;
+    }
+    for (int i = 0; i < result && !packet_receiver_.is_null(); ++i) {
+      net::IPEndPoint recv_addr;
+      std::unique_ptr<Packet> packet =
+          batch_socket_->TakeReceivedPacket(i, &recv_addr);
+      DeliverPacket(std::move(packet), recv_addr);
+    }
+  }
+}
+
+void UdpTransport::OnBatchWritable() {
+  DCHECK(io_thread_proxy_->RunsTasksOnCurrentThread());
+
+  send_pending_ = false;
+  const base::Closure cb = send_batch_cb_;
+  send_batch_cb_.Reset();
+  if (!FlushBatch(cb))
+    return;
+  ScheduleReceiveNextPacket();
+
+  if (!cb.is_null()) {
+    cb.Run();
+  }
+}
+#endif
+
 void UdpTransport::ScheduleReceiveNextPacket() {
   DCHECK(io_thread_proxy_->RunsTasksOnCurrentThread());
   if (!packet_receiver_.is_null() && !receive_pending_) {
@@ -162,6 +267,13 @@ void UdpTransport::ScheduleReceiveNextPacket() {
 void UdpTransport::ReceiveNextPacket(int length_or_status) {
   DCHECK(io_thread_proxy_->RunsTasksOnCurrentThread());
 
+#if defined(OS_LINUX)
+  if (batch_socket_) {
+    ReceiveNextBatch();
+    return;
+  }
+#endif
+
   if (packet_receiver_.is_null())
     return;
   if (!udp_socket_)
@@ -193,33 +305,71 @@ void UdpTransport::ReceiveNextPacket(int length_or_status) {
       return;
     }
 
-    // Confirm the packet has come from the expected remote address; otherwise,
-    // ignore it.  If this is the first packet being received and no remote
-    // address has been set, set the remote address and expect all future
-    // packets to come from the same one.
-    // TODO(hubbe): We should only do this if the caller used a valid ssrc.
-    if (IsEmpty(remote_addr_)) {
-      remote_addr_ = recv_addr_;
-      VLOG(1) << "Setting remote address from first received packet: "
-              << remote_addr_.ToString();
-      next_packet_->resize(length_or_status);
-      if (!packet_receiver_.Run(std::move(next_packet_))) {
-        VLOG(1) << "Packet was not valid, resetting remote address.";
-        remote_addr_ = net::IPEndPoint();
-      }
-    } else if (!(remote_addr_ == recv_addr_)) {
-      VLOG(1) << "Ignoring packet received from an unrecognized address: "
-              << recv_addr_.ToString() << ".";
-    } else {
-      next_packet_->resize(length_or_status);
-      packet_receiver_.Run(std::move(next_packet_));
-    }
+    next_packet_->resize(length_or_status);
+    DeliverPacket(std::move(next_packet_), recv_addr_);
     length_or_status = net::ERR_IO_PENDING;
   }
 }
 
+void UdpTransport::DeliverPacket(std::unique_ptr<Packet> packet,
+                                 const net::IPEndPoint& recv_addr) {
+  // Confirm the packet has come from the expected remote address; otherwise,
+  // ignore it.  If this is the first packet being received and no remote
+  // address has been set, set the remote address and expect all future
+  // packets to come from the same one.
+  // TODO(hubbe): We should only do this if the caller used a valid ssrc.
+  if (IsEmpty(remote_addr_)) {
+    remote_addr_ = recv_addr;
+    VLOG(1) << "Setting remote address from first received packet: "
+            << remote_addr_.ToString();
+    if (!packet_receiver_.Run(std::move(packet))) {
+      VLOG(1) << "Packet was not valid, resetting remote address.";
+      remote_addr_ = net::IPEndPoint();
+    }
+  } else if (!(remote_addr_ == recv_addr)) {
+    VLOG(1) << "Ignoring packet received from an unrecognized address: "
+            << recv_addr.ToString() << ".";
+  } else {
+    packet_receiver_.Run(std::move(packet));
+  }
+}
+
+void UdpTransport::UpdateDscp() {
+  if (next_dscp_value_ == net::DSCP_NO_CHANGE)
+    return;
+
+  int result = net::ERR_SOCKET_NOT_CONNECTED;
+#if defined(OS_LINUX)
+  if (batch_socket_)
+    result = batch_socket_->SetDiffServCodePoint(next_dscp_value_);
+  else
+#endif
+    result = udp_socket_->SetDiffServCodePoint(next_dscp_value_);
+  if (result != net::OK) {
+    VLOG(1) << "Unable to set DSCP: " << next_dscp_value_
+            << " to socket; Error: " << result;
+  }
+
+  if (result != net::ERR_SOCKET_NOT_CONNECTED) {
+    // Don't change DSCP in next send.
+    next_dscp_value_ = net::DSCP_NO_CHANGE;
+  }
+}
+
 bool UdpTransport::SendPacket(PacketRef packet, const base::Closure& cb) {
   DCHECK(io_thread_proxy_->RunsTasksOnCurrentThread());
+#if defined(OS_LINUX)
+  if (batch_socket_) {
+    // Increase byte count no matter the packet was sent or dropped.
+    bytes_sent_ += packet->data.size();
+
+    DCHECK(!send_pending_);
+    send_batch_.push_back(packet);
+    if (send_batch_.size() < UdpBatchSocket::kMaxBatchSize)
+      return true;
+    return FlushBatch(cb);
+  }
+#endif
   if (!udp_socket_)
     return true;
 
@@ -232,18 +382,7 @@ bool UdpTransport::SendPacket(PacketRef packet, const base::Closure& cb) {
     return true;
   }
 
-  if (next_dscp_value_ != net::DSCP_NO_CHANGE) {
-    int result = udp_socket_->SetDiffServCodePoint(next_dscp_value_);
-    if (result != net::OK) {
-      VLOG(1) << "Unable to set DSCP: " << next_dscp_value_
-              << " to socket; Error: " << result;
-    }
-
-    if (result != net::ERR_SOCKET_NOT_CONNECTED) {
-      // Don't change DSCP in next send.
-      next_dscp_value_ = net::DSCP_NO_CHANGE;
-    }
-  }
+  UpdateDscp();
 
   scoped_refptr<net::IOBuffer> buf =
       new net::WrappedIOBuffer(reinterpret_cast<char*>(&packet->data.front()));
@@ -279,6 +418,58 @@ bool UdpTransport::SendPacket(PacketRef packet, const base::Closure& cb) {
   return true;
 }
 
+bool UdpTransport::FlushBatch(const base::Closure& cb) {
+  DCHECK(io_thread_proxy_->RunsTasksOnCurrentThread());
+#if defined(OS_LINUX)
+  if (!batch_socket_ || send_batch_.empty())
+    return true;
+
+  DCHECK(!send_pending_);
+  if (send_pending_) {
+    VLOG(1) << "Cannot send because of pending IO.";
+    return true;
+  }
+
+  const net::IPEndPoint* address = nullptr;
+  if (!client_connected_) {
+    // If we called Connect() before we must not pass an address.
+    if (IsEmpty(remote_addr_)) {
+      VLOG(1) << "Failed to send packets; socket is neither bound nor "
+              << "connected.";
+      send_batch_.clear();
+      return true;
+    }
+    address = &remote_addr_;
+  }
+
+  UpdateDscp();
+
+  size_t packets_done = 0;
+  while (packets_done < send_batch_.size()) {
+    const int result = batch_socket_->SendPackets(
+        &send_batch_[packets_done], send_batch_.size() - packets_done, address,
+        base::Bind(&UdpTransport::OnBatchWritable,
+                   weak_factory_.GetWeakPtr()));
+    if (result == net::ERR_IO_PENDING) {
+      send_batch_.erase(send_batch_.begin(),
+                        send_batch_.begin() + packets_done);
+      send_pending_ = true;
+      send_batch_cb_ = cb;
+      return false;
+    }
+    if (result < 0) {
+      // Drop the packet which failed, as the unbatched path does.
+      VLOG(1) << "Failed to send packet: " << result << ".";
+      ++packets_done;
+    } else {
+      packets_done += result;
+    }
+  }
+  send_batch_.clear();
+#endif
+  return true;
+}
+
 int64_t UdpTransport::GetBytesSent() {
   return bytes_sent_;
 }
@@ -312,6 +503,13 @@ void UdpTransport::SetUdpOptions(const base::DictionaryValue& options) {
     UseNonBlockingIO();
   }
 #endif
+#if defined(OS_LINUX)
+  if (options.HasKey(kOptionUdpGso)) {
+    UseBatchedIO(true);
+  } else if (options.HasKey(kOptionBatchedIO)) {
+    UseBatchedIO(false);
+  }
+#endif
 }
 
 void UdpTransport::SetSendBufferSize(int32_t send_buffer_size) {
@@ -8,6 +8,7 @@
 #include <stdint.h>
 
 #include <memory>
+#include <vector>
 
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
@@ -30,6 +31,10 @@ class NetLog;
 namespace media {
 namespace cast {
 
+#if defined(OS_LINUX)
+class UdpBatchSocket;
+#endif
+
 // This class implements UDP transport mechanism for Cast.
 class UdpTransport : public PacketTransport {
  public:
@@ -70,6 +75,10 @@ class UdpTransport : public PacketTransport {
   //   "disable_non_blocking_io" (value ignored)
   //       - Windows only.  Turns off non-blocking IO for the socket.
   //         Note: Non-blocking IO is, by default, enabled on all platforms.
+  //   "batched_io" (value ignored)
+  //       - Linux only.  Turns on batched IO, see UseBatchedIO().
+  //   "udp_gso" (value ignored)
+  //       - Linux only.  Turns on batched IO with UDP segmentation offload.
   void SetUdpOptions(const base::DictionaryValue& options);
 
   // This has to be called before |StartReceiving()| to change the
@@ -81,8 +90,19 @@ class UdpTransport : public PacketTransport {
   void UseNonBlockingIO();
 #endif
 
+#if defined(OS_LINUX)
+  // Switch to batched IO: packets passed to SendPacket() are held until
+  // FlushBatch(), and then sent with one sendmmsg() call, and each wakeup
+  // receives all waiting packets, up to a limit, with one recvmmsg() call.
+  // If |segmentation_offload| is true, runs of equally sized packets are sent
+  // as UDP GSO messages where the kernel supports it. Must be called before
+  // StartReceiving().
+  void UseBatchedIO(bool segmentation_offload);
+#endif
+
   // PacketTransport implementations.
   bool SendPacket(PacketRef packet, const base::Closure& cb) final;
+  bool FlushBatch(const base::Closure& cb) final;
   int64_t GetBytesSent() final;
 
  private:
@@ -95,11 +115,31 @@ class UdpTransport : public PacketTransport {
   // Schedule packet receiving, if needed.
   void ScheduleReceiveNextPacket();
 
+  // Submits |packet|, received from |recv_addr|, to |packet_receiver_| if it
+  // came from the remote address.
+  void DeliverPacket(std::unique_ptr<Packet> packet,
+                     const net::IPEndPoint& recv_addr);
+
+  // Sets the next DSCP value on the socket, if there is one.
+  void UpdateDscp();
+
   void OnSent(const scoped_refptr<net::IOBuffer>& buf,
               PacketRef packet,
               const base::Closure& cb,
               int result);
 
+#if defined(OS_LINUX)
+  // Opens |batch_socket_| like StartReceiving() opens |udp_socket_|.
+  bool OpenBatchSocket();
+
+  // Receives batches of packets from |batch_socket_| until none are waiting.
+  void ReceiveNextBatch();
+
+  // Called once |batch_socket_| can be written to after FlushBatch() was
+  // blocked.
+  void OnBatchWritable();
+#endif
+
   const scoped_refptr<base::SingleThreadTaskRunner> io_thread_proxy_;
   const net::IPEndPoint local_addr_;
   net::IPEndPoint remote_addr_;
@@ -116,6 +156,17 @@ class UdpTransport : public PacketTransport {
   const CastTransportStatusCallback status_callback_;
   int bytes_sent_;
 
+#if defined(OS_LINUX)
+  // Replaces |udp_socket_| in batched IO mode.
+  std::unique_ptr<UdpBatchSocket> batch_socket_;
+  bool segmentation_offload_;
+
+  // Packets held until the next FlushBatch(), and the callback to run once
+  // they have been sent if it was blocked.
+  std::vector<PacketRef> send_batch_;
+  base::Closure send_batch_cb_;
+#endif
+
   // NOTE: Weak pointers must be invalidated before all other member variables.
   base::WeakPtrFactory<UdpTransport> weak_factory_;
 
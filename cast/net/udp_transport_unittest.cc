@@ -13,11 +13,16 @@
 #include "base/macros.h"
 #include "base/message_loop/message_loop.h"
 #include "base/run_loop.h"
+#include "build/build_config.h"
 #include "media/cast/net/cast_transport_config.h"
 #include "media/cast/test/utility/net_utility.h"
 #include "net/base/ip_address.h"
 #include "testing/gtest/include/gtest/gtest.h"
 
+#if defined(OS_LINUX)
+#include "base/files/file_descriptor_watcher_posix.h"
+#endif
+
 namespace media {
 namespace cast {
 
@@ -95,5 +100,90 @@ TEST(UdpTransport, SendAndReceive) {
       std::equal(packet.begin(), packet.end(), receiver2.packet().begin()));
 }
 
+#if defined(OS_LINUX)
+class CountingPacketReceiver {
+ public:
+  CountingPacketReceiver(size_t expected_packets, const base::Closure& done)
+      : expected_packets_(expected_packets), done_(done) {}
+
+  bool ReceivedPacket(std::unique_ptr<Packet> packet) {
+    packets_.push_back(*packet);
+    if (packets_.size() == expected_packets_)
+      done_.Run();
+    return true;
+  }
+
+  const std::vector<Packet>& packets() const { return packets_; }
+  PacketReceiverCallbackWithStatus packet_receiver() {
+    return base::Bind(&CountingPacketReceiver::ReceivedPacket,
+                      base::Unretained(this));
+  }
+
+ private:
+  const size_t expected_packets_;
+  const base::Closure done_;
+  std::vector<Packet> packets_;
+
+  DISALLOW_COPY_AND_ASSIGN(CountingPacketReceiver);
+};
+
+static bool IgnorePacket(std::unique_ptr<Packet> packet) {
+  return true;
+}
+
+void RunBatchedSendAndReceive(bool segmentation_offload) {
+  base::MessageLoopForIO message_loop;
+  base::FileDescriptorWatcher file_descriptor_watcher(&message_loop);
+
+  net::IPEndPoint free_local_port1 = test::GetFreeLocalPort();
+  net::IPEndPoint free_local_port2 = test::GetFreeLocalPort();
+
+  UdpTransport send_transport(NULL, message_loop.task_runner(),
+                              free_local_port1, free_local_port2,
+                              base::Bind(&UpdateCastTransportStatus));
+  send_transport.UseBatchedIO(segmentation_offload);
+  send_transport.SetSendBufferSize(1024 * 1024);
+  UdpTransport recv_transport(
+      NULL, message_loop.task_runner(), free_local_port2,
+      net::IPEndPoint(net::IPAddress::IPv4AllZeros(), 0),
+      base::Bind(&UpdateCastTransportStatus));
+  recv_transport.UseBatchedIO(segmentation_offload);
+
+  // More packets than fit in one batch, mostly of equal size so that they
+  // can be segmentation offloaded, ending with a short one.
+  const size_t kNumPackets = 100;
+  std::vector<Packet> packets;
+  for (size_t i = 0; i < kNumPackets; ++i) {
+    const size_t size = i == kNumPackets - 1 ? 100 : 1000;
+    packets.push_back(Packet(size, static_cast<uint8_t>(i)));
+  }
+
+  base::RunLoop run_loop;
+  CountingPacketReceiver receiver(kNumPackets, run_loop.QuitClosure());
+  send_transport.StartReceiving(base::Bind(&IgnorePacket));
+  recv_transport.StartReceiving(receiver.packet_receiver());
+
+  base::Closure cb;
+  for (const Packet& packet : packets) {
+    EXPECT_TRUE(send_transport.SendPacket(
+        new base::RefCountedData<Packet>(packet), cb));
+  }
+  EXPECT_TRUE(send_transport.FlushBatch(cb));
+  run_loop.Run();
+
+  EXPECT_TRUE(packets == receiver.packets());
+  EXPECT_EQ(static_cast<int64_t>((kNumPackets - 1) * 1000 + 100),
+            send_transport.GetBytesSent());
+}
+
+TEST(UdpTransport, BatchedSendAndReceive) {
+  RunBatchedSendAndReceive(false);
+}
+
+TEST(UdpTransport, BatchedSendAndReceiveWithSegmentationOffload) {
+  RunBatchedSendAndReceive(true);
+}
+#endif  // defined(OS_LINUX)
+
 }  // namespace cast
 }  // namespace media
@@ -12,6 +12,7 @@
 #include "base/logging.h"
 #include "base/message_loop/message_loop.h"
 #include "base/numerics/safe_conversions.h"
+#include "base/strings/string_piece.h"
 #include "media/cast/cast_config.h"
 #include "media/cast/cast_environment.h"
 #include "media/cast/constants.h"
@@ -205,15 +206,15 @@ void FrameReceiver::EmitAvailableEncodedFrames() {
   DCHECK(cast_environment_->CurrentlyOn(CastEnvironment::MAIN));
 
   while (!frame_request_queue_.empty()) {
-    // Attempt to peek at the next completed frame from the |framer_|.
-    // TODO(miu): We should only be peeking at the metadata, and not copying the
-    // payload yet!  Or, at least, peek using a StringPiece instead of a copy.
+    // Attempt to peek at the next completed frame from the |framer_|. Its
+    // payload is only copied out of the |framer_| once it is to be emitted.
     std::unique_ptr<EncodedFrame> encoded_frame(new EncodedFrame());
+    FramePayloadView payload;
     bool is_consecutively_next_frame = false;
     bool have_multiple_complete_frames = false;
-    if (!framer_.GetEncodedFrame(encoded_frame.get(),
-                                 &is_consecutively_next_frame,
-                                 &have_multiple_complete_frames)) {
+    if (!framer_.GetEncodedFrameView(encoded_frame.get(), &payload,
+                                     &is_consecutively_next_frame,
+                                     &have_multiple_complete_frames)) {
       VLOG(1) << "Wait for more packets to produce a completed frame.";
       return;  // ProcessParsedPacket() will invoke this method in the future.
     }
@@ -258,16 +259,24 @@ void FrameReceiver::EmitAvailableEncodedFrames() {
     framer_.AckFrame(encoded_frame->frame_id);
 
     // Decrypt the payload data in the frame, if crypto is being used.
+    // Single packet frames are decrypted straight from the |framer_|.
     if (decryptor_.is_activated()) {
-      std::string decrypted_data;
-      if (!decryptor_.Decrypt(encoded_frame->frame_id,
-                              encoded_frame->data,
-                              &decrypted_data)) {
+      std::string encrypted_data;
+      base::StringPiece ciphertext;
+      if (payload.chunks.size() == 1) {
+        ciphertext = payload.chunks[0];
+      } else {
+        payload.CopyTo(&encrypted_data);
+        ciphertext = encrypted_data;
+      }
+      if (!decryptor_.Decrypt(encoded_frame->frame_id, ciphertext,
+                              &encoded_frame->data)) {
         // Decryption failed.  Give up on this frame.
         framer_.ReleaseFrame(encoded_frame->frame_id);
         continue;
       }
-      encoded_frame->data.swap(decrypted_data);
+    } else {
+      payload.CopyTo(&encoded_frame->data);
     }
 
     // At this point, we have a decrypted EncodedFrame ready to be emitted.
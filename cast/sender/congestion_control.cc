@@ -22,6 +22,7 @@
 #include "base/macros.h"
 #include "base/trace_event/trace_event.h"
 #include "media/cast/constants.h"
+#include "media/cast/sender/delay_based_congestion_control.h"
 
 namespace media {
 namespace cast {
@@ -38,12 +39,14 @@ class AdaptiveCongestionControl : public CongestionControl {
   // CongestionControl implementation.
   void UpdateRtt(base::TimeDelta rtt) final;
   void UpdateTargetPlayoutDelay(base::TimeDelta delay) final;
+  void UpdatePacketLoss(uint8_t fraction_lost) final {}
   void SendFrameToTransport(FrameId frame_id,
                             size_t frame_size_in_bits,
                             base::TimeTicks when) final;
   void AckFrame(FrameId frame_id, base::TimeTicks when) final;
   void AckLaterFrames(std::vector<FrameId> received_frames,
                       base::TimeTicks when) final;
+  void OnPacketTimings(const PacketTimingList& timings) final {}
   int GetBitrate(base::TimeTicks playout_time,
                  base::TimeDelta playout_delay) final;
 
@@ -103,12 +106,14 @@ class FixedCongestionControl : public CongestionControl {
   // CongestionControl implementation.
   void UpdateRtt(base::TimeDelta rtt) final {}
   void UpdateTargetPlayoutDelay(base::TimeDelta delay) final {}
+  void UpdatePacketLoss(uint8_t fraction_lost) final {}
   void SendFrameToTransport(FrameId frame_id,
                             size_t frame_size_in_bits,
                             base::TimeTicks when) final {}
   void AckFrame(FrameId frame_id, base::TimeTicks when) final {}
   void AckLaterFrames(std::vector<FrameId> received_frames,
                       base::TimeTicks when) final {}
+  void OnPacketTimings(const PacketTimingList& timings) final {}
   int GetBitrate(base::TimeTicks playout_time,
                  base::TimeDelta playout_delay) final {
     return bitrate_;
@@ -136,6 +141,15 @@ CongestionControl* NewFixedCongestionControl(int bitrate) {
   return new FixedCongestionControl(bitrate);
 }
 
+CongestionControl* NewDelayBasedCongestionControl(
+    base::TickClock* clock,
+    int max_bitrate_configured,
+    int min_bitrate_configured,
+    int start_bitrate) {
+  return new DelayBasedCongestionControl(clock, max_bitrate_configured,
+                                         min_bitrate_configured, start_bitrate);
+}
+
 // This means that we *try* to keep our buffer 90% empty.
 // If it is less full, we increase the bandwidth, if it is more
 // we decrease the bandwidth. Making this smaller makes the
@@ -14,6 +14,7 @@
 #include "base/time/tick_clock.h"
 #include "base/time/time.h"
 #include "media/cast/common/frame_id.h"
+#include "media/cast/net/rtcp/rtcp_defines.h"
 
 namespace media {
 namespace cast {
@@ -28,6 +29,10 @@ class CongestionControl {
   // Called with an updated target playout delay value.
   virtual void UpdateTargetPlayoutDelay(base::TimeDelta delay) = 0;
 
+  // Called with the fraction of packets lost, in units of 1/256, reported by
+  // the receiver.
+  virtual void UpdatePacketLoss(uint8_t fraction_lost) = 0;
+
   // Called when an encoded frame is enqueued for transport.
   virtual void SendFrameToTransport(FrameId frame_id,
                                     size_t frame_size_in_bits,
@@ -41,6 +46,10 @@ class CongestionControl {
   virtual void AckLaterFrames(std::vector<FrameId> received_frames,
                               base::TimeTicks when) = 0;
 
+  // Called with the send and arrival times of packets the receiver logged as
+  // received, ordered by send time.
+  virtual void OnPacketTimings(const PacketTimingList& timings) = 0;
+
   // Returns the bitrate we should use for the next frame.
   virtual int GetBitrate(base::TimeTicks playout_time,
                          base::TimeDelta playout_delay) = 0;
@@ -54,6 +63,14 @@ CongestionControl* NewAdaptiveCongestionControl(
 
 CongestionControl* NewFixedCongestionControl(int bitrate);
 
+// Returns a CongestionControl that adapts to the queuing delay of packets; see
+// DelayBasedCongestionControl.
+CongestionControl* NewDelayBasedCongestionControl(
+    base::TickClock* clock,
+    int max_bitrate_configured,
+    int min_bitrate_configured,
+    int start_bitrate);
+
 }  // namespace cast
 }  // namespace media
 
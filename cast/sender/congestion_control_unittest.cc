@@ -4,6 +4,9 @@
 
 #include <stddef.h>
 #include <stdint.h>
+
+#include <algorithm>
+#include <deque>
 #include <vector>
 
 #include "base/bind.h"
@@ -143,5 +146,131 @@ TEST_F(CongestionControlTest, SimpleRun) {
               safe_bitrate * 0.05);
 }
 
+// Sends frames at the bitrate of a DelayBasedCongestionControl through a
+// simulated bottleneck link, and reports the packet timings back to it like a
+// receiver would.
+class DelayBasedCongestionControlTest : public ::testing::Test {
+ protected:
+  DelayBasedCongestionControlTest()
+      : congestion_control_(
+            NewDelayBasedCongestionControl(&testing_clock_,
+                                           kMaxBitrateConfigured,
+                                           kMinBitrateConfigured,
+                                           kStartBitrate)),
+        total_bytes_sent_(0),
+        num_frames_sent_(0) {
+    testing_clock_.Advance(
+        base::TimeDelta::FromMilliseconds(kStartMillisecond));
+  }
+
+  // Sends frames for |duration| through a link of |link_bitrate|, with a
+  // round trip time of |rtt|. Packet timings are reported every three frames.
+  void Run(int link_bitrate, base::TimeDelta duration, base::TimeDelta rtt) {
+    const base::TimeTicks end = testing_clock_.NowTicks() + duration;
+    while (testing_clock_.NowTicks() < end) {
+      const base::TimeTicks now = testing_clock_.NowTicks();
+      congestion_control_->UpdateRtt(rtt);
+      int64_t frame_size = congestion_control_->GetBitrate(now, rtt) *
+                           kFrameDelayMs / 8000;
+      while (frame_size > 0) {
+        const int64_t packet_size = std::min<int64_t>(frame_size, 1200);
+        frame_size -= packet_size;
+        link_free_time_ =
+            std::max(link_free_time_, now) +
+            base::TimeDelta::FromMicroseconds(
+                packet_size * 8 * base::Time::kMicrosecondsPerSecond /
+                link_bitrate);
+        total_bytes_sent_ += packet_size;
+        PacketTiming timing;
+        timing.send_time = now;
+        timing.arrival_time = link_free_time_ + rtt / 2;
+        timing.last_byte_sent = total_bytes_sent_;
+        in_flight_.push_back(timing);
+      }
+
+      testing_clock_.Advance(base::TimeDelta::FromMilliseconds(kFrameDelayMs));
+      if (++num_frames_sent_ % 3 == 0)
+        ReportPacketTimings();
+    }
+  }
+
+  int GetBitrate() {
+    return congestion_control_->GetBitrate(testing_clock_.NowTicks(),
+                                           base::TimeDelta());
+  }
+
+  base::TimeDelta queuing_delay() const {
+    return std::max(link_free_time_ - testing_clock_.NowTicks(),
+                    base::TimeDelta());
+  }
+
+ private:
+  // Reports the timings of the packets that have arrived, with arrival times
+  // on a receiver clock that has an arbitrary offset.
+  void ReportPacketTimings() {
+    PacketTimingList timings;
+    while (!in_flight_.empty() &&
+           in_flight_.front().arrival_time <= testing_clock_.NowTicks()) {
+      timings.push_back(in_flight_.front());
+      timings.back().arrival_time += base::TimeDelta::FromSeconds(1234);
+      in_flight_.pop_front();
+    }
+    if (!timings.empty())
+      congestion_control_->OnPacketTimings(timings);
+  }
+
+  static const int kStartBitrate = 1000000;
+
+  base::SimpleTestTickClock testing_clock_;
+  std::unique_ptr<CongestionControl> congestion_control_;
+  base::TimeTicks link_free_time_;
+  int64_t total_bytes_sent_;
+  int num_frames_sent_;
+  std::deque<PacketTiming> in_flight_;
+
+  DISALLOW_COPY_AND_ASSIGN(DelayBasedCongestionControlTest);
+};
+
+// Tests that the bitrate stays at its start value without packet timings.
+TEST_F(DelayBasedCongestionControlTest, HoldsBitrateWithoutPacketTimings) {
+  const int start_bitrate = GetBitrate();
+  congestion_control_->UpdateRtt(base::TimeDelta::FromMilliseconds(20));
+  congestion_control_->SendFrameToTransport(FrameId::first(), 10000 * 8,
+                                            testing_clock_.NowTicks());
+  testing_clock_.Advance(base::TimeDelta::FromSeconds(10));
+  congestion_control_->AckFrame(FrameId::first(), testing_clock_.NowTicks());
+  EXPECT_EQ(start_bitrate, GetBitrate());
+}
+
+// Tests that the bitrate ramps up to the capacity of the link without building
+// a queue, and backs off to the new capacity when it drops.
+TEST_F(DelayBasedCongestionControlTest, FollowsLinkCapacity) {
+  const base::TimeDelta rtt = base::TimeDelta::FromMilliseconds(20);
+  Run(3000000, base::TimeDelta::FromSeconds(20), rtt);
+  for (int i = 0; i < 100; ++i) {
+    Run(3000000, base::TimeDelta::FromMilliseconds(100), rtt);
+    EXPECT_LT(2400000, GetBitrate());
+    EXPECT_GT(3300000, GetBitrate());
+    EXPECT_GT(base::TimeDelta::FromMilliseconds(100), queuing_delay());
+  }
+
+  Run(1000000, base::TimeDelta::FromSeconds(5), rtt);
+  for (int i = 0; i < 50; ++i) {
+    Run(1000000, base::TimeDelta::FromMilliseconds(100), rtt);
+    EXPECT_LT(800000, GetBitrate());
+    EXPECT_GT(1150000, GetBitrate());
+    EXPECT_GT(base::TimeDelta::FromMilliseconds(100), queuing_delay());
+  }
+}
+
+// Tests that high packet loss cuts the bitrate, and low packet loss doesn't.
+TEST_F(DelayBasedCongestionControlTest, CutsBitrateOnHighPacketLoss) {
+  const int start_bitrate = GetBitrate();
+  congestion_control_->UpdatePacketLoss(10);  // 4%.
+  EXPECT_EQ(start_bitrate, GetBitrate());
+  congestion_control_->UpdatePacketLoss(64);  // 25%.
+  EXPECT_NEAR(start_bitrate * 0.875, GetBitrate(), 1);
+}
+
 }  // namespace cast
 }  // namespace media
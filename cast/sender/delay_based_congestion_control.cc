@@ -0,0 +1,359 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/cast/sender/delay_based_congestion_control.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "base/logging.h"
+#include "base/trace_event/trace_event.h"
+
+namespace media {
+namespace cast {
+
+namespace {
+
+// The receiver reports the lower 24 bits of its clock in milliseconds.
+const double kArrivalTimeWrapMs = 1 << 24;
+
+// The minimum one way delay is taken over this window, so that it follows
+// clock drift and route changes.
+const double kMinDelayWindowMs = 10000;
+
+// Packets sent within this time of the first packet of a group belong to it.
+const double kPacketGroupMs = 5;
+
+// Smoothing factor of the one way delay, and number of packet groups over
+// which its trend is estimated.
+const double kDelaySmoothing = 0.9;
+const size_t kDelayHistorySize = 20;
+
+// The delay trend is scaled by the number of packet groups it is estimated
+// over, up to kMaxTrendSamples, and by kTrendGain before it is compared to the
+// overuse threshold, which adapts to the trend at these rates per millisecond.
+const int kMaxTrendSamples = 60;
+const double kTrendGain = 4.0;
+const double kInitialThreshold = 12.5;
+const double kMinThreshold = 6;
+const double kMaxThreshold = 600;
+const double kThresholdIncreaseRate = 0.0087;
+const double kThresholdDecreaseRate = 0.039;
+
+// The trend must exceed the threshold for this long, and for more than one
+// packet group, to signal overuse.
+const double kOveruseTimeMs = 10;
+
+// The network is overused as well if the queuing delay exceeds this fraction
+// of the playout delay.
+const double kMaxQueuingDelayFraction = 0.25;
+
+// The delivery rate is measured over this window of arrival times, once it
+// spans at least kMinDeliveryRateSpanMs.
+const double kDeliveryRateWindowMs = 500;
+const double kMinDeliveryRateSpanMs = 100;
+
+// On overuse, the bitrate is cut to this fraction of the delivery rate, and
+// the link capacity estimate moves towards the delivery rate by this weight.
+const double kDecreaseFactor = 0.85;
+const double kLinkCapacityWeight = 0.05;
+
+// Away from the link capacity, the bitrate grows by this factor per second.
+// Close to it, it grows by one packet per round trip. Once the bitrate is well
+// beyond it, the link capacity estimate is stale and is discarded.
+const double kMultiplicativeIncreasePerSecond = 1.08;
+const double kNearLinkCapacityFraction = 0.9;
+const double kStaleLinkCapacityMultiple = 1.5;
+const double kPacketSizeInBits = 1200 * 8;
+
+// The bitrate never grows beyond this multiple of the delivery rate, plus
+// kMaxBitrateHeadroom, so that it isn't raised while the encoder undershoots.
+const double kMaxDeliveryRateMultiple = 1.5;
+const double kMaxBitrateHeadroom = 10000;
+
+// When more than this fraction of packets are lost, the bitrate is cut in
+// proportion to the loss.
+const double kHighPacketLoss = 0.1;
+
+double ToMilliseconds(base::TimeTicks time) {
+  return (time - base::TimeTicks()).InMillisecondsF();
+}
+
+}  // namespace
+
+DelayBasedCongestionControl::DelayBasedCongestionControl(
+    base::TickClock* clock,
+    int max_bitrate_configured,
+    int min_bitrate_configured,
+    int start_bitrate)
+    : clock_(clock),
+      max_bitrate_configured_(max_bitrate_configured),
+      min_bitrate_configured_(min_bitrate_configured),
+      bitrate_(std::max(min_bitrate_configured,
+                        std::min(start_bitrate, max_bitrate_configured))),
+      target_playout_delay_(base::TimeDelta::FromMilliseconds(400)),
+      have_last_packet_(false),
+      last_byte_sent_(0),
+      last_delay_ms_(0),
+      have_packet_group_(false),
+      packet_group_start_ms_(0),
+      packet_group_send_time_ms_(0),
+      packet_group_delay_ms_(0),
+      smoothed_delay_ms_(0),
+      num_delay_samples_(0),
+      threshold_(kInitialThreshold),
+      last_threshold_update_ms_(0),
+      overuse_start_ms_(0),
+      overuse_count_(0),
+      last_trend_(0),
+      delivery_rate_(0),
+      link_capacity_(0) {
+  DCHECK_GE(max_bitrate_configured, min_bitrate_configured) << "Invalid config";
+  DCHECK_GT(min_bitrate_configured, 0);
+}
+
+DelayBasedCongestionControl::~DelayBasedCongestionControl() {}
+
+void DelayBasedCongestionControl::UpdateRtt(base::TimeDelta rtt) {
+  rtt_ = (7 * rtt_ + rtt) / 8;
+}
+
+void DelayBasedCongestionControl::UpdateTargetPlayoutDelay(
+    base::TimeDelta delay) {
+  target_playout_delay_ = delay;
+}
+
+void DelayBasedCongestionControl::UpdatePacketLoss(uint8_t fraction_lost) {
+  const double loss = fraction_lost / 256.0;
+  if (loss <= kHighPacketLoss)
+    return;
+  bitrate_ = std::max<double>(bitrate_ * (1 - 0.5 * loss),
+                              min_bitrate_configured_);
+  last_decrease_time_ = clock_->NowTicks();
+  VLOG(2) << "Packet loss " << loss << ", bitrate cut to " << bitrate_;
+}
+
+void DelayBasedCongestionControl::SendFrameToTransport(
+    FrameId frame_id,
+    size_t frame_size_in_bits,
+    base::TimeTicks when) {}
+
+void DelayBasedCongestionControl::AckFrame(FrameId frame_id,
+                                           base::TimeTicks when) {}
+
+void DelayBasedCongestionControl::AckLaterFrames(
+    std::vector<FrameId> received_frames,
+    base::TimeTicks when) {}
+
+void DelayBasedCongestionControl::OnPacketTimings(
+    const PacketTimingList& timings) {
+  NetworkUsage usage = NETWORK_NORMAL;
+  bool updated = false;
+  for (const PacketTiming& timing : timings) {
+    if (have_last_packet_ && timing.last_byte_sent <= last_byte_sent_)
+      continue;  // Already processed, or reported late.
+
+    // Only the arrival time modulo kArrivalTimeWrapMs is known, so the delay is
+    // unwrapped to the one closest to that of the previous packet.
+    const double send_time_ms = ToMilliseconds(timing.send_time);
+    double delay_ms = fmod(ToMilliseconds(timing.arrival_time) - send_time_ms,
+                           kArrivalTimeWrapMs);
+    if (have_last_packet_) {
+      double delta_ms = delay_ms - last_delay_ms_;
+      delta_ms -=
+          kArrivalTimeWrapMs * floor(delta_ms / kArrivalTimeWrapMs + 0.5);
+      delay_ms = last_delay_ms_ + delta_ms;
+    }
+    have_last_packet_ = true;
+    last_byte_sent_ = timing.last_byte_sent;
+    last_delay_ms_ = delay_ms;
+    updated = true;
+
+    UpdateDeliveryRate(send_time_ms + delay_ms, timing.last_byte_sent);
+
+    if (have_packet_group_ &&
+        send_time_ms - packet_group_start_ms_ > kPacketGroupMs) {
+      usage = std::max(usage, UpdateDelay(packet_group_send_time_ms_,
+                                          packet_group_delay_ms_));
+      have_packet_group_ = false;
+    }
+    if (!have_packet_group_) {
+      have_packet_group_ = true;
+      packet_group_start_ms_ = send_time_ms;
+    }
+    packet_group_send_time_ms_ = send_time_ms;
+    packet_group_delay_ms_ = delay_ms;
+  }
+  if (updated)
+    UpdateBitrate(usage);
+}
+
+DelayBasedCongestionControl::NetworkUsage
+DelayBasedCongestionControl::UpdateDelay(double send_time_ms,
+                                         double delay_ms) {
+  const double arrival_time_ms = send_time_ms + delay_ms;
+
+  while (!min_delays_.empty() && min_delays_.back().second >= delay_ms)
+    min_delays_.pop_back();
+  min_delays_.push_back(std::make_pair(send_time_ms, delay_ms));
+  while (min_delays_.front().first < send_time_ms - kMinDelayWindowMs)
+    min_delays_.pop_front();
+  const double queuing_delay_ms = delay_ms - min_delays_.front().second;
+
+  smoothed_delay_ms_ = num_delay_samples_ == 0
+                           ? delay_ms
+                           : kDelaySmoothing * smoothed_delay_ms_ +
+                                 (1 - kDelaySmoothing) * delay_ms;
+  ++num_delay_samples_;
+  delay_history_.push_back(
+      std::make_pair(arrival_time_ms, smoothed_delay_ms_));
+  if (delay_history_.size() > kDelayHistorySize)
+    delay_history_.pop_front();
+  if (delay_history_.size() < kDelayHistorySize)
+    return NETWORK_NORMAL;
+
+  const double trend = GetDelayTrend();
+  const double modified_trend =
+      std::min(num_delay_samples_, kMaxTrendSamples) * trend * kTrendGain;
+
+  NetworkUsage usage = NETWORK_NORMAL;
+  if (modified_trend > threshold_) {
+    if (overuse_count_ == 0)
+      overuse_start_ms_ = arrival_time_ms;
+    ++overuse_count_;
+    if (arrival_time_ms - overuse_start_ms_ >= kOveruseTimeMs &&
+        overuse_count_ > 1 && trend >= last_trend_) {
+      usage = NETWORK_OVERUSED;
+    }
+  } else {
+    overuse_count_ = 0;
+    if (modified_trend < -threshold_)
+      usage = NETWORK_UNDERUSED;
+  }
+  last_trend_ = trend;
+  if (queuing_delay_ms >
+      target_playout_delay_.InMillisecondsF() * kMaxQueuingDelayFraction) {
+    usage = NETWORK_OVERUSED;
+  }
+
+  // The threshold follows the trend, slowly upwards and quickly downwards, so
+  // that a flow competing with loss-based flows isn't starved. Spikes are
+  // ignored.
+  const double abs_trend = fabs(modified_trend);
+  if (last_threshold_update_ms_ == 0)
+    last_threshold_update_ms_ = arrival_time_ms;
+  if (abs_trend < threshold_ + 15) {
+    const double rate = abs_trend < threshold_ ? kThresholdDecreaseRate
+                                               : kThresholdIncreaseRate;
+    const double elapsed_ms =
+        std::min(arrival_time_ms - last_threshold_update_ms_, 100.0);
+    threshold_ += rate * (abs_trend - threshold_) * std::max(elapsed_ms, 0.0);
+    threshold_ = std::max(kMinThreshold, std::min(threshold_, kMaxThreshold));
+  }
+  last_threshold_update_ms_ = arrival_time_ms;
+
+  VLOG(3) << "Queuing delay " << queuing_delay_ms << " ms, trend "
+          << modified_trend << ", threshold " << threshold_;
+  return usage;
+}
+
+double DelayBasedCongestionControl::GetDelayTrend() const {
+  double mean_x = 0;
+  double mean_y = 0;
+  for (const auto& sample : delay_history_) {
+    mean_x += sample.first;
+    mean_y += sample.second;
+  }
+  mean_x /= delay_history_.size();
+  mean_y /= delay_history_.size();
+  double numerator = 0;
+  double denominator = 0;
+  for (const auto& sample : delay_history_) {
+    numerator += (sample.first - mean_x) * (sample.second - mean_y);
+    denominator += (sample.first - mean_x) * (sample.first - mean_x);
+  }
+  return denominator > 0 ? numerator / denominator : 0;
+}
+
+void DelayBasedCongestionControl::UpdateDeliveryRate(double arrival_time_ms,
+                                                     int64_t last_byte_sent) {
+  arrivals_.push_back(std::make_pair(arrival_time_ms, last_byte_sent));
+  while (arrivals_.size() > 2 &&
+         arrivals_[1].first <= arrival_time_ms - kDeliveryRateWindowMs) {
+    arrivals_.pop_front();
+  }
+  const double span_ms = arrival_time_ms - arrivals_.front().first;
+  if (span_ms < kMinDeliveryRateSpanMs)
+    return;
+  delivery_rate_ =
+      8000.0 * (last_byte_sent - arrivals_.front().second) / span_ms;
+}
+
+void DelayBasedCongestionControl::UpdateBitrate(NetworkUsage usage) {
+  const base::TimeTicks now = clock_->NowTicks();
+  const base::TimeDelta elapsed =
+      last_bitrate_update_.is_null()
+          ? base::TimeDelta()
+          : std::min(now - last_bitrate_update_,
+                     base::TimeDelta::FromSeconds(1));
+  last_bitrate_update_ = now;
+
+  switch (usage) {
+    case NETWORK_OVERUSED:
+      // Only cut once per round trip, as it takes that long for a cut to
+      // drain the queue.
+      if (!last_decrease_time_.is_null() &&
+          now - last_decrease_time_ <
+              std::max(rtt_, base::TimeDelta::FromMilliseconds(100))) {
+        break;
+      }
+      if (delivery_rate_ > 0) {
+        link_capacity_ = link_capacity_ == 0
+                             ? delivery_rate_
+                             : (1 - kLinkCapacityWeight) * link_capacity_ +
+                                   kLinkCapacityWeight * delivery_rate_;
+        bitrate_ = kDecreaseFactor * delivery_rate_;
+      } else {
+        bitrate_ *= kDecreaseFactor;
+      }
+      last_decrease_time_ = now;
+      break;
+    case NETWORK_UNDERUSED:
+      // Queues are draining; hold the bitrate until they are empty.
+      break;
+    case NETWORK_NORMAL: {
+      if (delivery_rate_ > 0 &&
+          bitrate_ > kMaxDeliveryRateMultiple * delivery_rate_ +
+                         kMaxBitrateHeadroom) {
+        break;
+      }
+      if (bitrate_ > kStaleLinkCapacityMultiple * link_capacity_)
+        link_capacity_ = 0;
+      if (link_capacity_ == 0 ||
+          bitrate_ < kNearLinkCapacityFraction * link_capacity_) {
+        bitrate_ *= pow(kMultiplicativeIncreasePerSecond, elapsed.InSecondsF());
+      } else {
+        const base::TimeDelta response_time =
+            rtt_ + base::TimeDelta::FromMilliseconds(100);
+        bitrate_ += kPacketSizeInBits * elapsed.InSecondsF() /
+                    response_time.InSecondsF();
+      }
+      break;
+    }
+  }
+  bitrate_ = std::max<double>(min_bitrate_configured_,
+                              std::min<double>(bitrate_,
+                                               max_bitrate_configured_));
+}
+
+int DelayBasedCongestionControl::GetBitrate(base::TimeTicks playout_time,
+                                            base::TimeDelta playout_delay) {
+  VLOG(3) << " BR:" << (bitrate_ / 1E6) << " DR:" << (delivery_rate_ / 1E6);
+  TRACE_COUNTER_ID1("cast.stream", "Delivery Rate", this, delivery_rate_);
+  return static_cast<int>(bitrate_);
+}
+
+}  // namespace cast
+}  // namespace media
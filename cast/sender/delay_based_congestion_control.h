@@ -0,0 +1,141 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_CAST_SENDER_DELAY_BASED_CONGESTION_CONTROL_H_
+#define MEDIA_CAST_SENDER_DELAY_BASED_CONGESTION_CONTROL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <utility>
+#include <vector>
+
+#include "base/macros.h"
+#include "base/time/tick_clock.h"
+#include "base/time/time.h"
+#include "media/cast/sender/congestion_control.h"
+
+namespace media {
+namespace cast {
+
+// Adapts the bitrate to the queuing delay of packets, in the manner of Google
+// Congestion Control (GCC), rather than to how quickly frames are
+// acknowledged. The receiver's logs of when it received packets are matched up
+// with when they were sent, and:
+//
+// * The trend of the one way delay is estimated by a linear regression over
+//   recent packets. When the delay keeps growing faster than an adaptive
+//   threshold, or the queuing delay exceeds a fraction of the playout delay,
+//   the network is overused and the bitrate is cut to a fraction of the rate
+//   at which packets were delivered.
+// * Otherwise, the bitrate grows multiplicatively until it nears the link
+//   capacity, estimated from the delivery rates at which the network was
+//   overused, and additively there, to probe for more bandwidth.
+// * High packet loss cuts the bitrate too, so that the stream keeps its share
+//   of links whose queues are kept full by loss-based flows such as TCP.
+//
+// Without packet timings, e.g. if the receiver doesn't log received packets,
+// the bitrate stays at its start value.
+class DelayBasedCongestionControl : public CongestionControl {
+ public:
+  DelayBasedCongestionControl(base::TickClock* clock,
+                              int max_bitrate_configured,
+                              int min_bitrate_configured,
+                              int start_bitrate);
+  ~DelayBasedCongestionControl() final;
+
+  // CongestionControl implementation.
+  void UpdateRtt(base::TimeDelta rtt) final;
+  void UpdateTargetPlayoutDelay(base::TimeDelta delay) final;
+  void UpdatePacketLoss(uint8_t fraction_lost) final;
+  void SendFrameToTransport(FrameId frame_id,
+                            size_t frame_size_in_bits,
+                            base::TimeTicks when) final;
+  void AckFrame(FrameId frame_id, base::TimeTicks when) final;
+  void AckLaterFrames(std::vector<FrameId> received_frames,
+                      base::TimeTicks when) final;
+  void OnPacketTimings(const PacketTimingList& timings) final;
+  int GetBitrate(base::TimeTicks playout_time,
+                 base::TimeDelta playout_delay) final;
+
+ private:
+  enum NetworkUsage {
+    NETWORK_NORMAL,
+    NETWORK_UNDERUSED,
+    NETWORK_OVERUSED,
+  };
+
+  // Feeds the one way delay of a group of packets, in milliseconds and up to a
+  // constant clock offset, into the delay trend and returns the network usage.
+  NetworkUsage UpdateDelay(double send_time_ms, double delay_ms);
+
+  // Feeds the arrival of the packet which brought the total number of bytes
+  // sent to |last_byte_sent| into the delivery rate estimate.
+  void UpdateDeliveryRate(double arrival_time_ms, int64_t last_byte_sent);
+
+  // Returns the slope of the smoothed delay over the arrival time of recent
+  // packets.
+  double GetDelayTrend() const;
+
+  void UpdateBitrate(NetworkUsage usage);
+
+  base::TickClock* const clock_;  // Not owned by this class.
+  const int max_bitrate_configured_;
+  const int min_bitrate_configured_;
+  double bitrate_;
+
+  base::TimeDelta rtt_;
+  base::TimeDelta target_playout_delay_;
+
+  // The last packet timing processed. Timings of packets sent before it are
+  // ignored.
+  bool have_last_packet_;
+  int64_t last_byte_sent_;
+  double last_delay_ms_;
+
+  // Packets sent within a short time of each other, e.g. in one burst of the
+  // paced sender, are grouped, and only the delay of the last packet of each
+  // group is fed into the delay trend. Otherwise the delays growing within a
+  // burst, and shrinking at the start of the next, hide the trend.
+  bool have_packet_group_;
+  double packet_group_start_ms_;
+  double packet_group_send_time_ms_;
+  double packet_group_delay_ms_;
+
+  // Windowed minimum of the one way delay, as (send time, delay) pairs with
+  // increasing delays.
+  std::deque<std::pair<double, double>> min_delays_;
+
+  // Smoothed one way delay of recent packets, as (arrival time, delay) pairs.
+  double smoothed_delay_ms_;
+  std::deque<std::pair<double, double>> delay_history_;
+  int num_delay_samples_;
+
+  // Overuse detection.
+  double threshold_;
+  double last_threshold_update_ms_;
+  double overuse_start_ms_;
+  int overuse_count_;
+  double last_trend_;
+
+  // Recent arrivals, as (arrival time, last byte sent) pairs, and the rate at
+  // which they were delivered, in bits per second.
+  std::deque<std::pair<double, int64_t>> arrivals_;
+  double delivery_rate_;
+
+  // Average of the delivery rates at which the network was overused, or zero
+  // if unknown.
+  double link_capacity_;
+
+  base::TimeTicks last_bitrate_update_;
+  base::TimeTicks last_decrease_time_;
+
+  DISALLOW_COPY_AND_ASSIGN(DelayBasedCongestionControl);
+};
+
+}  // namespace cast
+}  // namespace media
+
+#endif  // MEDIA_CAST_SENDER_DELAY_BASED_CONGESTION_CONTROL_H_
@@ -53,6 +53,17 @@ void FrameSender::RtcpClient::OnReceivedPli() {
     frame_sender_->OnReceivedPli();
 }
 
+void FrameSender::RtcpClient::OnReceivedPacketLoss(uint8_t fraction_lost) {
+  if (frame_sender_)
+    frame_sender_->OnReceivedPacketLoss(fraction_lost);
+}
+
+void FrameSender::RtcpClient::OnReceivedPacketTimings(
+    const PacketTimingList& timings) {
+  if (frame_sender_)
+    frame_sender_->OnReceivedPacketTimings(timings);
+}
+
 FrameSender::FrameSender(scoped_refptr<CastEnvironment> cast_environment,
                          CastTransport* const transport_sender,
                          const FrameSenderConfig& config,
@@ -93,6 +104,7 @@ FrameSender::FrameSender(scoped_refptr<CastEnvironment> cast_environment,
   transport_config.rtp_payload_type = config.rtp_payload_type;
   transport_config.aes_key = config.aes_key;
   transport_config.aes_iv_mask = config.aes_iv_mask;
+  transport_config.enable_fec = config.enable_fec;
 
   transport_sender->InitializeStream(
       transport_config,
@@ -142,6 +154,16 @@ void FrameSender::OnMeasuredRoundTripTime(base::TimeDelta rtt) {
   current_round_trip_time_ = rtt;
 }
 
+void FrameSender::OnReceivedPacketLoss(uint8_t fraction_lost) {
+  DCHECK(cast_environment_->CurrentlyOn(CastEnvironment::MAIN));
+  congestion_control_->UpdatePacketLoss(fraction_lost);
+}
+
+void FrameSender::OnReceivedPacketTimings(const PacketTimingList& timings) {
+  DCHECK(cast_environment_->CurrentlyOn(CastEnvironment::MAIN));
+  congestion_control_->OnPacketTimings(timings);
+}
+
 void FrameSender::SetTargetPlayoutDelay(
     base::TimeDelta new_target_playout_delay) {
   if (send_target_playout_delay_ &&
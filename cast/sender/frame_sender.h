@@ -65,6 +65,8 @@ class FrameSender {
     void OnReceivedCastMessage(const RtcpCastMessage& cast_message) override;
     void OnReceivedRtt(base::TimeDelta round_trip_time) override;
     void OnReceivedPli() override;
+    void OnReceivedPacketLoss(uint8_t fraction_lost) override;
+    void OnReceivedPacketTimings(const PacketTimingList& timings) override;
 
    private:
     const base::WeakPtr<FrameSender> frame_sender_;
@@ -81,6 +83,11 @@ class FrameSender {
 
   void OnMeasuredRoundTripTime(base::TimeDelta rtt);
 
+  // Called when the receiver reports packet loss, or the send and arrival
+  // times of packets.
+  void OnReceivedPacketLoss(uint8_t fraction_lost);
+  void OnReceivedPacketTimings(const PacketTimingList& timings);
+
   const scoped_refptr<CastEnvironment> cast_environment_;
 
   // Sends encoded frames over the configured transport (e.g., UDP).  In
@@ -80,12 +80,32 @@ void LogVideoCaptureTimestamps(CastEnvironment* cast_environment,
   cast_environment->logger()->DispatchFrameEvent(std::move(capture_end_event));
 }
 
-}  // namespace
-
 // Note, we use a fixed bitrate value when external video encoder is used.
 // Some hardware encoder shows bad behavior if we set the bitrate too
 // frequently, e.g. quality drop, not abiding by target bitrate, etc.
 // See details: crbug.com/392086.
+CongestionControl* NewVideoCongestionControl(
+    CastEnvironment* cast_environment,
+    const FrameSenderConfig& video_config) {
+  if (video_config.use_external_encoder) {
+    return NewFixedCongestionControl(
+        (video_config.min_bitrate + video_config.max_bitrate) / 2);
+  }
+  switch (video_config.congestion_control) {
+    case CONGESTION_CONTROL_ADAPTIVE:
+      break;
+    case CONGESTION_CONTROL_DELAY_BASED:
+      return NewDelayBasedCongestionControl(
+          cast_environment->Clock(), video_config.max_bitrate,
+          video_config.min_bitrate, video_config.start_bitrate);
+  }
+  return NewAdaptiveCongestionControl(
+      cast_environment->Clock(), video_config.max_bitrate,
+      video_config.min_bitrate, video_config.max_frame_rate);
+}
+
+}  // namespace
+
 VideoSender::VideoSender(
     scoped_refptr<CastEnvironment> cast_environment,
     const FrameSenderConfig& video_config,
@@ -98,13 +118,7 @@ VideoSender::VideoSender(
           cast_environment,
           transport_sender,
           video_config,
-          video_config.use_external_encoder
-              ? NewFixedCongestionControl(
-                    (video_config.min_bitrate + video_config.max_bitrate) / 2)
-              : NewAdaptiveCongestionControl(cast_environment->Clock(),
-                                             video_config.max_bitrate,
-                                             video_config.min_bitrate,
-                                             video_config.max_frame_rate)),
+          NewVideoCongestionControl(cast_environment.get(), video_config)),
       frames_in_encoder_(0),
       last_bitrate_(0),
       playout_delay_change_cb_(playout_delay_change_cb),
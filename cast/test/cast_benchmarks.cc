@@ -20,6 +20,10 @@
 // $ export PROFILE_FILE=cast_benchmark.profile
 // Then after running the program, you can view the profile with:
 // $ pprof ./out/Release/cast_benchmarks $PROFILE_FILE --gv
+//
+// With --framer, this program instead measures the receiver's cost of
+// reassembling frames from packets: the time the Framer takes to insert the
+// packets of a frame, return the frame and release it, per packet.
 
 #include <math.h>
 #include <stddef.h>
@@ -44,6 +48,7 @@
 #include "base/test/simple_test_tick_clock.h"
 #include "base/threading/thread.h"
 #include "base/time/tick_clock.h"
+#include "base/time/time.h"
 #include "media/base/audio_bus.h"
 #include "media/base/fake_single_thread_task_runner.h"
 #include "media/base/video_frame.h"
@@ -51,11 +56,13 @@
 #include "media/cast/cast_environment.h"
 #include "media/cast/cast_receiver.h"
 #include "media/cast/cast_sender.h"
+#include "media/cast/constants.h"
 #include "media/cast/logging/simple_event_subscriber.h"
 #include "media/cast/net/cast_transport.h"
 #include "media/cast/net/cast_transport_config.h"
 #include "media/cast/net/cast_transport_defines.h"
 #include "media/cast/net/cast_transport_impl.h"
+#include "media/cast/net/rtp/framer.h"
 #include "media/cast/test/loopback_transport.h"
 #include "media/cast/test/skewed_single_thread_task_runner.h"
 #include "media/cast/test/skewed_tick_clock.h"
@@ -714,12 +721,86 @@ class CastBenchmark {
   base::Lock lock_;
 };
 
+// Feeds the packets of a stream of frames to a Framer, and takes each frame
+// out as soon as it is complete, as the FrameReceiver does.
+class FramerBenchmark : public RtpPayloadFeedback {
+ public:
+  FramerBenchmark() {}
+  ~FramerBenchmark() override {}
+
+  void CastFeedback(const RtcpCastMessage& cast_feedback) override {}
+
+  void Run() {
+    fprintf(stdout, "%-16s %10s %14s\n", "packets/frame", "copy", "ns/packet");
+    for (int packets_per_frame : {1, 8, 64}) {
+      for (bool copy : {false, true}) {
+        fprintf(stdout, "%-16d %10s %14.1f\n", packets_per_frame,
+                copy ? "yes" : "no", RunOnce(packets_per_frame, copy));
+        fflush(stdout);
+      }
+    }
+  }
+
+ private:
+  static const int kNumPackets = 1 << 20;
+  static const size_t kPacketSize = 1200;
+
+  // Returns the time per packet. If |copy| is true, the data of each frame is
+  // copied out of the Framer, otherwise only a view of it is taken.
+  double RunOnce(int packets_per_frame, bool copy) {
+    base::SimpleTestTickClock clock;
+    Framer framer(&clock, this, 1, true, kMaxUnackedFrames);
+    const std::vector<uint8_t> payload(kPacketSize, 0x42);
+    RtpCastHeader rtp_header;
+    rtp_header.max_packet_id = packets_per_frame - 1;
+    EncodedFrame frame;
+    FramePayloadView frame_payload;
+    size_t total_size = 0;
+
+    const base::TimeTicks start = base::TimeTicks::Now();
+    const int num_frames = kNumPackets / packets_per_frame;
+    for (int i = 0; i < num_frames; ++i) {
+      rtp_header.frame_id = FrameId::first() + i;
+      rtp_header.reference_frame_id = rtp_header.frame_id;
+      rtp_header.is_key_frame = i == 0;
+      for (int packet_id = 0; packet_id < packets_per_frame; ++packet_id) {
+        rtp_header.packet_id = packet_id;
+        bool duplicate = false;
+        framer.InsertPacket(&payload[0], payload.size(), rtp_header,
+                            &duplicate);
+      }
+
+      bool next_frame = false;
+      bool have_multiple_frames = false;
+      CHECK(framer.GetEncodedFrameView(&frame, &frame_payload, &next_frame,
+                                       &have_multiple_frames));
+      if (copy)
+        frame_payload.CopyTo(&frame.data);
+      total_size += frame_payload.size;
+      framer.AckFrame(frame.frame_id);
+      framer.ReleaseFrame(frame.frame_id);
+    }
+    const base::TimeDelta elapsed = base::TimeTicks::Now() - start;
+
+    CHECK_EQ(static_cast<size_t>(num_frames) * packets_per_frame * kPacketSize,
+             total_size);
+    return elapsed.InMicrosecondsF() * 1000 / (num_frames * packets_per_frame);
+  }
+
+  DISALLOW_COPY_AND_ASSIGN(FramerBenchmark);
+};
+
 }  // namespace cast
 }  // namespace media
 
 int main(int argc, char** argv) {
   base::AtExitManager at_exit;
   base::CommandLine::Init(argc, argv);
+  if (base::CommandLine::ForCurrentProcess()->HasSwitch("framer")) {
+    media::cast::FramerBenchmark benchmark;
+    benchmark.Run();
+    return 0;
+  }
   media::cast::CastBenchmark benchmark;
   if (getenv("PROFILE_FILE")) {
     std::string profile_file(getenv("PROFILE_FILE"));
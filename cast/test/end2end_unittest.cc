@@ -1181,6 +1181,25 @@ TEST_F(End2EndTest, EvilNetwork) {
   EXPECT_GT(1000, (video_ticks_.back().second - test_end).InMilliseconds());
 }
 
+// Tests that all frames are played out over a lossy network when the sender
+// sends FEC repair packets, which recover most lost packets.
+TEST_F(End2EndTest, LossyNetworkWithFec) {
+  Configure(CODEC_VIDEO_FAKE, CODEC_AUDIO_PCM16);
+  video_sender_config_.enable_fec = true;
+  sender_to_receiver_->SetPacketPipe(test::NewRandomDrop(0.03));
+  Create();
+  StartBasicPlayer();
+
+  for (int frames_counter = 0; frames_counter < kLongTestIterations;
+       ++frames_counter) {
+    SendVideoFrame(frames_counter, testing_clock_sender_->NowTicks());
+    RunTasks(kFrameTimerMs);
+  }
+  RunTasks(100 * kFrameTimerMs + 1);  // Empty the pipeline.
+
+  EXPECT_EQ(static_cast<size_t>(kLongTestIterations), video_ticks_.size());
+}
+
 // Tests that a system configured for 30 FPS drops frames when input is provided
 // at a much higher frame rate.
 TEST_F(End2EndTest, ShoveHighFrameRateDownYerThroat) {
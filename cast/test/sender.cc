@@ -24,6 +24,7 @@
 #include "base/strings/string_number_conversions.h"
 #include "base/threading/thread.h"
 #include "base/time/default_tick_clock.h"
+#include "base/timer/timer.h"
 #include "base/values.h"
 #include "media/base/media.h"
 #include "media/base/video_frame.h"
@@ -45,9 +46,6 @@
 
 namespace {
 
-// The max allowed size of serialized log.
-const int kMaxSerializedLogBytes = 10 * 1000 * 1000;
-
 // Flags for this program:
 //
 // --address=xx.xx.xx.xx
@@ -71,6 +69,10 @@ const char kSwitchSourceFile[] = "source-file";
 const char kSwitchFps[] = "fps";
 const char kSwitchVaryFrameSizes[] = "vary-frame-sizes";
 
+// How often the logged events are moved from the event subscribers to the log
+// files.
+const int kLogDrainIntervalSeconds = 1;
+
 void UpdateCastTransportStatus(
     media::cast::CastTransportStatus status) {
   VLOG(1) << "Transport status: " << status;
@@ -88,60 +90,78 @@ net::IPEndPoint CreateUDPAddress(const std::string& ip_str, uint16_t port) {
   return net::IPEndPoint(ip_address, port);
 }
 
-void DumpLoggingData(const media::cast::proto::LogMetadata& log_metadata,
-                     const media::cast::FrameEventList& frame_events,
-                     const media::cast::PacketEventList& packet_events,
-                     base::ScopedFILE log_file) {
-  VLOG(0) << "Frame map size: " << frame_events.size();
-  VLOG(0) << "Packet map size: " << packet_events.size();
-
-  std::unique_ptr<char[]> event_log(new char[kMaxSerializedLogBytes]);
-  int event_log_bytes;
-  if (!media::cast::SerializeEvents(log_metadata,
-                                    frame_events,
-                                    packet_events,
-                                    true,
-                                    kMaxSerializedLogBytes,
-                                    event_log.get(),
-                                    &event_log_bytes)) {
-    VLOG(0) << "Failed to serialize events.";
-    return;
+bool WriteToFile(FILE* log_file,
+                 int* total_bytes,
+                 const char* data,
+                 int data_bytes) {
+  if (fwrite(data, 1, data_bytes, log_file) !=
+      static_cast<size_t>(data_bytes)) {
+    return false;
   }
+  *total_bytes += data_bytes;
+  return true;
+}
 
-  VLOG(0) << "Events serialized length: " << event_log_bytes;
+// Logs the events of one stream to a file for the whole session. Every
+// kLogDrainIntervalSeconds the events the subscriber has collected are
+// serialized to the file and dropped, so neither the subscriber nor the
+// serializer ever holds more than that many seconds of events.
+class EventLogWriter {
+ public:
+  EventLogWriter(
+      const scoped_refptr<media::cast::CastEnvironment>& cast_environment,
+      media::cast::EventMediaType event_media_type,
+      base::ScopedFILE log_file)
+      : cast_environment_(cast_environment),
+        subscriber_(event_media_type, 10000),
+        log_file_(std::move(log_file)),
+        log_bytes_(0),
+        serializer_(true,
+                    base::Bind(&WriteToFile, log_file_.get(), &log_bytes_)) {
+    cast_environment_->logger()->Subscribe(&subscriber_);
+    drain_timer_.Start(
+        FROM_HERE, base::TimeDelta::FromSeconds(kLogDrainIntervalSeconds),
+        base::Bind(&EventLogWriter::Drain, base::Unretained(this)));
+  }
 
-  int ret = fwrite(event_log.get(), 1, event_log_bytes, log_file.get());
-  if (ret != event_log_bytes)
-    VLOG(0) << "Failed to write logs to file.";
-}
+  // Stops logging, writes the remaining events and ends the log. Must be
+  // called before destruction.
+  void Finish() {
+    drain_timer_.Stop();
+    cast_environment_->logger()->Unsubscribe(&subscriber_);
+    Drain();
+    if (!serializer_.Finish()) {
+      VLOG(0) << "Failed to serialize events and write them to file.";
+      return;
+    }
+    VLOG(0) << "Events serialized length: " << log_bytes_;
+  }
 
-void WriteLogsToFileAndDestroySubscribers(
-    const scoped_refptr<media::cast::CastEnvironment>& cast_environment,
-    std::unique_ptr<media::cast::EncodingEventSubscriber>
-        video_event_subscriber,
-    std::unique_ptr<media::cast::EncodingEventSubscriber>
-        audio_event_subscriber,
-    base::ScopedFILE video_log_file,
-    base::ScopedFILE audio_log_file) {
-  cast_environment->logger()->Unsubscribe(video_event_subscriber.get());
-  cast_environment->logger()->Unsubscribe(audio_event_subscriber.get());
-
-  VLOG(0) << "Dumping logging data for video stream.";
-  media::cast::proto::LogMetadata log_metadata;
-  media::cast::FrameEventList frame_events;
-  media::cast::PacketEventList packet_events;
-  video_event_subscriber->GetEventsAndReset(
-      &log_metadata, &frame_events, &packet_events);
-
-  DumpLoggingData(log_metadata, frame_events, packet_events,
-                  std::move(video_log_file));
-
-  VLOG(0) << "Dumping logging data for audio stream.";
-  audio_event_subscriber->GetEventsAndReset(
-      &log_metadata, &frame_events, &packet_events);
-
-  DumpLoggingData(log_metadata, frame_events, packet_events,
-                  std::move(audio_log_file));
+ private:
+  void Drain() {
+    if (!serializer_.AppendEvents(&subscriber_)) {
+      VLOG(0) << "Failed to serialize events and write them to file.";
+      drain_timer_.Stop();
+    }
+  }
+
+  const scoped_refptr<media::cast::CastEnvironment> cast_environment_;
+  media::cast::EncodingEventSubscriber subscriber_;
+  base::ScopedFILE log_file_;
+  int log_bytes_;
+  media::cast::StreamingLogSerializer serializer_;
+  base::RepeatingTimer drain_timer_;
+
+  DISALLOW_COPY_AND_ASSIGN(EventLogWriter);
+};
+
+void FinishLogsAndDestroyWriters(
+    std::unique_ptr<EventLogWriter> video_log_writer,
+    std::unique_ptr<EventLogWriter> audio_log_writer) {
+  VLOG(0) << "Finishing log of video stream.";
+  video_log_writer->Finish();
+  VLOG(0) << "Finishing log of audio stream.";
+  audio_log_writer->Finish();
 }
 
 void WriteStatsAndDestroySubscribers(
@@ -272,19 +292,10 @@ int main(int argc, char** argv) {
               remote_endpoint, base::Bind(&UpdateCastTransportStatus)),
           io_message_loop.task_runner());
 
-  // Set up event subscribers.
-  std::unique_ptr<media::cast::EncodingEventSubscriber> video_event_subscriber;
-  std::unique_ptr<media::cast::EncodingEventSubscriber> audio_event_subscriber;
   std::string video_log_file_name("/tmp/video_events.log.gz");
   std::string audio_log_file_name("/tmp/audio_events.log.gz");
   LOG(INFO) << "Logging audio events to: " << audio_log_file_name;
   LOG(INFO) << "Logging video events to: " << video_log_file_name;
-  video_event_subscriber.reset(new media::cast::EncodingEventSubscriber(
-      media::cast::VIDEO_EVENT, 10000));
-  audio_event_subscriber.reset(new media::cast::EncodingEventSubscriber(
-      media::cast::AUDIO_EVENT, 10000));
-  cast_environment->logger()->Subscribe(video_event_subscriber.get());
-  cast_environment->logger()->Subscribe(audio_event_subscriber.get());
 
   // Subscribers for stats.
   std::unique_ptr<media::cast::ReceiverTimeOffsetEstimatorImpl>
@@ -313,15 +324,18 @@ int main(int argc, char** argv) {
     exit(-1);
   }
 
+  // Set up event logging.
+  std::unique_ptr<EventLogWriter> video_log_writer(new EventLogWriter(
+      cast_environment, media::cast::VIDEO_EVENT, std::move(video_log_file)));
+  std::unique_ptr<EventLogWriter> audio_log_writer(new EventLogWriter(
+      cast_environment, media::cast::AUDIO_EVENT, std::move(audio_log_file)));
+
   const int logging_duration_seconds = 10;
   io_message_loop.task_runner()->PostDelayedTask(
       FROM_HERE,
-      base::Bind(&WriteLogsToFileAndDestroySubscribers,
-                 cast_environment,
-                 base::Passed(&video_event_subscriber),
-                 base::Passed(&audio_event_subscriber),
-                 base::Passed(&video_log_file),
-                 base::Passed(&audio_log_file)),
+      base::Bind(&FinishLogsAndDestroyWriters,
+                 base::Passed(&video_log_writer),
+                 base::Passed(&audio_log_writer)),
       base::TimeDelta::FromSeconds(logging_duration_seconds));
 
   io_message_loop.task_runner()->PostDelayedTask(
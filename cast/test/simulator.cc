@@ -29,15 +29,38 @@
 //   File path to write YUV decoded frames in YUV4MPEG2 format.
 // --no-simulation
 //   Do not run network simulation.
+// --fec
+//   Send forward error correction repair packets for video frames, whose
+//   overhead adapts to the packet loss of the simulated network.
+// --congestion-control=
+//   How the video bitrate adapts to the network: "adaptive", "delay-based",
+//   or "all" to run the simulation once with each, for comparison.
+//   Optional; default is "adaptive".
+// --min-bitrate-kbps=
+// --max-bitrate-kbps=
+//   Range of the video bitrate. Optional; defaults are 2000 and 2500.
+// --network-trace=
+//   Replays a recorded network link instead of the network simulation model.
+//   Each line of the file is the time, in milliseconds, of an opportunity to
+//   deliver a 1500 byte packet, as in mahimahi's trace format. The trace
+//   repeats with a period of its last line.
+// --trace-delay-ms=
+//   One way delay added to the recorded link, in milliseconds.
+//   Optional; default is 20.
 //
 // Output:
 // - Raw event log of the simulation session tagged with the unique test ID,
-//   written out to the specified file path.
+//   written out to the specified file path. With --congestion-control=all,
+//   the name of the congestion control is inserted before the extension of
+//   each output file path.
 
 #include <stddef.h>
 #include <stdint.h>
 
+#include <map>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "base/at_exit.h"
 #include "base/base_paths.h"
@@ -52,6 +75,7 @@
 #include "base/memory/ptr_util.h"
 #include "base/path_service.h"
 #include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
 #include "base/strings/stringprintf.h"
 #include "base/test/simple_test_tick_clock.h"
 #include "base/threading/thread_task_runner_handle.h"
@@ -92,19 +116,29 @@ using media::cast::proto::NetworkSimulationModelType;
 namespace media {
 namespace cast {
 namespace {
+const char kCongestionControl[] = "congestion-control";
+const char kFec[] = "fec";
 const char kLibDir[] = "lib-dir";
 const char kModelPath[] = "model";
 const char kMetricsOutputPath[] = "metrics-output";
 const char kOutputPath[] = "output";
+const char kMaxBitrate[] = "max-bitrate-kbps";
 const char kMaxFrameRate[] = "max-frame-rate";
+const char kMinBitrate[] = "min-bitrate-kbps";
+const char kNetworkTrace[] = "network-trace";
 const char kNoSimulation[] = "no-simulation";
 const char kRunTime[] = "run-time";
 const char kSimulationId[] = "sim-id";
 const char kSourcePath[] = "source";
 const char kSourceFrameRate[] = "source-frame-rate";
 const char kTargetDelay[] = "target-delay-ms";
+const char kTraceDelay[] = "trace-delay-ms";
 const char kYuvOutputPath[] = "yuv-output";
 
+// How often, in simulated time, the logged events are moved from the event
+// subscribers to the log file.
+const int kLogDrainIntervalSeconds = 10;
+
 int GetIntegerSwitchValue(const char* switch_name, int default_value) {
   const std::string as_str =
       base::CommandLine::ForCurrentProcess()->GetSwitchValueASCII(switch_name);
@@ -286,48 +320,88 @@ void GotAudioFrame(int* counter,
       base::Bind(&GotAudioFrame, counter, cast_receiver));
 }
 
-// Serialize |frame_events| and |packet_events| and append to the file
-// located at |output_path|.
-void AppendLogToFile(media::cast::proto::LogMetadata* metadata,
-                     const media::cast::FrameEventList& frame_events,
-                     const media::cast::PacketEventList& packet_events,
-                     const base::FilePath& output_path) {
+bool AppendDataToFile(const base::FilePath& output_path,
+                      const char* data,
+                      int data_bytes) {
+  return AppendToFile(output_path, data, data_bytes);
+}
+
+// What the log says about a video frame, merged over all the sections of the
+// log its events are in.
+struct VideoFrameStats {
+  VideoFrameStats()
+      : encoded(false), encoded_size(0), target_bitrate(0), delay_millis(0) {}
+
+  bool encoded;
+  int encoded_size;
+  int target_bitrate;
+  int64_t delay_millis;
+};
+
+// Video frame stats, keyed by RTP timestamp.
+typedef std::map<uint32_t, VideoFrameStats> VideoFrameStatsMap;
+
+// Moves the events |subscriber| has received since it was last drained to
+// |serializer|, as another section of the log. If |video_stats| is not null,
+// the stats of the frames are merged into it.
+bool DrainEventsToLog(const std::string& extra_data,
+                      EncodingEventSubscriber* subscriber,
+                      StreamingLogSerializer* serializer,
+                      VideoFrameStatsMap* video_stats) {
+  media::cast::proto::LogMetadata metadata;
+  media::cast::FrameEventList frame_events;
+  media::cast::PacketEventList packet_events;
+  subscriber->GetEventsAndReset(&metadata, &frame_events, &packet_events);
+
+  metadata.set_extra_data(extra_data);
   media::cast::proto::GeneralDescription* gen_desc =
-      metadata->mutable_general_description();
+      metadata.mutable_general_description();
   gen_desc->set_product("Cast Simulator");
   gen_desc->set_product_version("0.1");
 
-  std::unique_ptr<char[]> serialized_log(
-      new char[media::cast::kMaxSerializedBytes]);
-  int output_bytes;
-  bool success = media::cast::SerializeEvents(*metadata,
-                                              frame_events,
-                                              packet_events,
-                                              true,
-                                              media::cast::kMaxSerializedBytes,
-                                              serialized_log.get(),
-                                              &output_bytes);
-
-  if (!success) {
-    LOG(ERROR) << "Failed to serialize log.";
-    return;
+  if (video_stats) {
+    for (const linked_ptr<media::cast::proto::AggregatedFrameEvent>& event :
+         frame_events) {
+      VideoFrameStats& stats =
+          (*video_stats)[metadata.first_rtp_timestamp() +
+                         event->relative_rtp_timestamp()];
+      if (event->has_encoded_frame_size()) {
+        stats.encoded = true;
+        stats.encoded_size = event->encoded_frame_size();
+        stats.target_bitrate = event->target_bitrate();
+      }
+      if (event->has_delay_millis())
+        stats.delay_millis = event->delay_millis();
+    }
   }
 
-  if (!AppendToFile(output_path, serialized_log.get(), output_bytes)) {
-    LOG(ERROR) << "Failed to append to log.";
+  return serializer->AppendEvents(metadata, frame_events, packet_events);
+}
+
+const char* CongestionControlName(CongestionControlType congestion_control) {
+  switch (congestion_control) {
+    case CONGESTION_CONTROL_ADAPTIVE:
+      return "adaptive";
+    case CONGESTION_CONTROL_DELAY_BASED:
+      return "delay-based";
   }
+  return "";
 }
 
 // Run simulation once.
 //
 // |log_output_path| is the path to write serialized log.
 // |extra_data| is extra tagging information to write to log.
+// |delivery_times_ms| is the network trace to replay; if empty, |model| is
+// used instead.
 void RunSimulation(const base::FilePath& source_path,
                    const base::FilePath& log_output_path,
                    const base::FilePath& metrics_output_path,
                    const base::FilePath& yuv_output_path,
                    const std::string& extra_data,
-                   const NetworkSimulationModel& model) {
+                   const NetworkSimulationModel& model,
+                   const std::vector<int>& delivery_times_ms,
+                   CongestionControlType congestion_control) {
   // Fake clock. Make sure start time is non zero.
   base::SimpleTestTickClock testing_clock;
   testing_clock.Advance(base::TimeDelta::FromSeconds(1));
@@ -347,7 +421,8 @@ void RunSimulation(const base::FilePath& source_path,
                               new test::SkewedTickClock(&testing_clock)),
                           task_runner, task_runner, task_runner);
 
-  // Event subscriber. Store at most 1 hour of events.
+  // Event subscribers. They are drained into the log every
+  // kLogDrainIntervalSeconds, and can store an hour of events in between.
   EncodingEventSubscriber audio_event_subscriber(AUDIO_EVENT,
                                                  100 * 60 * 60);
   EncodingEventSubscriber video_event_subscriber(VIDEO_EVENT,
@@ -369,13 +444,19 @@ void RunSimulation(const base::FilePath& source_path,
 
   // Video sender config.
   FrameSenderConfig video_sender_config = GetDefaultVideoSenderConfig();
-  video_sender_config.max_bitrate = 2500000;
-  video_sender_config.min_bitrate = 2000000;
-  video_sender_config.start_bitrate = 2000000;
+  video_sender_config.max_bitrate =
+      GetIntegerSwitchValue(kMaxBitrate, 2500) * 1000;
+  video_sender_config.min_bitrate =
+      GetIntegerSwitchValue(kMinBitrate, 2000) * 1000;
+  CHECK_LE(video_sender_config.min_bitrate, video_sender_config.max_bitrate);
+  video_sender_config.start_bitrate = video_sender_config.min_bitrate;
   video_sender_config.min_playout_delay =
       video_sender_config.max_playout_delay =
           audio_sender_config.max_playout_delay;
   video_sender_config.max_frame_rate = GetIntegerSwitchValue(kMaxFrameRate, 30);
+  video_sender_config.enable_fec =
+      base::CommandLine::ForCurrentProcess()->HasSwitch(kFec);
+  video_sender_config.congestion_control = congestion_control;
 
   // Video receiver config.
   FrameReceiverConfig video_receiver_config =
@@ -412,7 +493,21 @@ void RunSimulation(const base::FilePath& source_path,
   const bool use_network_simulation =
       model.type() == media::cast::proto::INTERRUPTED_POISSON_PROCESS;
   std::unique_ptr<test::InterruptedPoissonProcess> ipp;
-  if (use_network_simulation) {
+  if (!delivery_times_ms.empty()) {
+    LOG(INFO) << "Replaying network trace.";
+    const double delay_seconds = GetIntegerSwitchValue(kTraceDelay, 20) / 1E3;
+    std::unique_ptr<test::PacketPipe> sender_to_receiver_pipe =
+        test::NewTraceDrivenBuffer(128 * 1024, delivery_times_ms);
+    sender_to_receiver_pipe->AppendToPipe(
+        test::NewConstantDelay(delay_seconds));
+    receiver_to_sender->Initialize(test::NewConstantDelay(delay_seconds),
+                                   transport_sender->PacketReceiverForTesting(),
+                                   task_runner, &testing_clock);
+    sender_to_receiver->Initialize(
+        std::move(sender_to_receiver_pipe),
+        transport_receiver->PacketReceiverForTesting(), task_runner,
+        &testing_clock);
+  } else if (use_network_simulation) {
     LOG(INFO) << "Running Poisson based network simulation.";
     const IPPModel& ipp_model = model.ipp();
     std::vector<double> average_rates(ipp_model.average_rate_size());
@@ -487,6 +582,22 @@ void RunSimulation(const base::FilePath& source_path,
     AppendToFile(yuv_output_path, header.data(), header.size());
   }
 
+  // Truncate the log file, then append the serialized events to it as the
+  // simulation runs. Both streams are logged through the same serializer, as
+  // their sections are interleaved in the one file.
+  {
+    base::ScopedFILE file(base::OpenFile(log_output_path, "wb"));
+    if (!file.get()) {
+      LOG(INFO) << "Cannot write to log.";
+      return;
+    }
+  }
+  LOG(INFO) << "Writing log: " << log_output_path.value();
+  StreamingLogSerializer log_serializer(
+      true, base::Bind(&AppendDataToFile, log_output_path));
+  bool log_failed = false;
+  VideoFrameStatsMap video_frame_stats;
+
   // Start sending.
   if (!source_path.empty()) {
     // 0 means using the FPS from the file.
@@ -499,6 +610,8 @@ void RunSimulation(const base::FilePath& source_path,
   // By default runs simulation for 3 minutes or the desired duration
   // by using --run-time= flag.
   base::TimeDelta elapsed_time;
+  base::TimeDelta next_log_drain_time =
+      base::TimeDelta::FromSeconds(kLogDrainIntervalSeconds);
   const base::TimeDelta desired_run_time =
       base::TimeDelta::FromSeconds(GetIntegerSwitchValue(kRunTime, 180));
   while (elapsed_time < desired_run_time) {
@@ -506,6 +619,15 @@ void RunSimulation(const base::FilePath& source_path,
     base::TimeDelta step = base::TimeDelta::FromMicroseconds(100);
     task_runner->Sleep(step);
     elapsed_time += step;
+
+    if (elapsed_time >= next_log_drain_time && !log_failed) {
+      log_failed = !DrainEventsToLog(extra_data, &video_event_subscriber,
+                                     &log_serializer, &video_frame_stats) ||
+                   !DrainEventsToLog(extra_data, &audio_event_subscriber,
+                                     &log_serializer, nullptr);
+      next_log_drain_time +=
+          base::TimeDelta::FromSeconds(kLogDrainIntervalSeconds);
+    }
   }
 
   // Unsubscribe from logging events.
@@ -514,16 +636,15 @@ void RunSimulation(const base::FilePath& source_path,
   if (quality_test)
     sender_env->logger()->Unsubscribe(video_frame_tracker.get());
 
-  // Get event logs for audio and video.
-  media::cast::proto::LogMetadata audio_metadata, video_metadata;
-  media::cast::FrameEventList audio_frame_events, video_frame_events;
-  media::cast::PacketEventList audio_packet_events, video_packet_events;
-  audio_metadata.set_extra_data(extra_data);
-  video_metadata.set_extra_data(extra_data);
-  audio_event_subscriber.GetEventsAndReset(
-      &audio_metadata, &audio_frame_events, &audio_packet_events);
-  video_event_subscriber.GetEventsAndReset(
-      &video_metadata, &video_frame_events, &video_packet_events);
+  // Write the remaining events and end the log.
+  if (log_failed ||
+      !DrainEventsToLog(extra_data, &video_event_subscriber, &log_serializer,
+                        &video_frame_stats) ||
+      !DrainEventsToLog(extra_data, &audio_event_subscriber, &log_serializer,
+                        nullptr) ||
+      !log_serializer.Finish()) {
+    LOG(ERROR) << "Failed to serialize log and append it to file.";
+  }
 
   // Print simulation results.
 
@@ -542,20 +663,19 @@ void RunSimulation(const base::FilePath& source_path,
   int64_t total_delay_of_late_frames_ms = 0;
   int64_t encoded_size = 0;
   int64_t target_bitrate = 0;
-  for (size_t i = 0; i < video_frame_events.size(); ++i) {
-    const media::cast::proto::AggregatedFrameEvent& event =
-        *video_frame_events[i];
+  for (const auto& frame : video_frame_stats) {
+    const VideoFrameStats& stats = frame.second;
     ++total_video_frames;
-    if (event.has_encoded_frame_size()) {
+    if (stats.encoded) {
       ++encoded_video_frames;
-      encoded_size += event.encoded_frame_size();
-      target_bitrate += event.target_bitrate();
+      encoded_size += stats.encoded_size;
+      target_bitrate += stats.target_bitrate;
     } else {
       ++dropped_video_frames;
     }
-    if (event.has_delay_millis() && event.delay_millis() < 0) {
+    if (stats.delay_millis < 0) {
       ++late_video_frames;
-      total_delay_of_late_frames_ms += -event.delay_millis();
+      total_delay_of_late_frames_ms += -stats.delay_millis;
     }
   }
 
@@ -571,6 +691,8 @@ void RunSimulation(const base::FilePath& source_path,
   double avg_target_bitrate =
       !encoded_video_frames ? 0 : target_bitrate / encoded_video_frames / 1000;
 
+  LOG(INFO) << "Congestion control: "
+            << CongestionControlName(congestion_control);
   LOG(INFO) << "Configured target playout delay (ms): "
             << video_receiver_config.rtp_max_delay_ms;
   LOG(INFO) << "Audio frame count: " << audio_frame_count;
@@ -586,20 +708,6 @@ void RunSimulation(const base::FilePath& source_path,
             << " ms)";
   LOG(INFO) << "Average encoded bitrate (kbps): " << avg_encoded_bitrate;
   LOG(INFO) << "Average target bitrate (kbps): " << avg_target_bitrate;
-  LOG(INFO) << "Writing log: " << log_output_path.value();
-
-  // Truncate file and then write serialized log.
-  {
-    base::ScopedFILE file(base::OpenFile(log_output_path, "wb"));
-    if (!file.get()) {
-      LOG(INFO) << "Cannot write to log.";
-      return;
-    }
-  }
-  AppendLogToFile(&video_metadata, video_frame_events, video_packet_events,
-                  log_output_path);
-  AppendLogToFile(&audio_metadata, audio_frame_events, audio_packet_events,
-                  log_output_path);
 
   // Write quality metrics.
   if (quality_test) {
@@ -641,6 +749,34 @@ NetworkSimulationModel DefaultModel() {
   return model;
 }
 
+// Loads a network trace in mahimahi's format: one delivery time in
+// milliseconds per line. Returns an empty trace on failure.
+std::vector<int> LoadNetworkTrace(const base::FilePath& trace_path) {
+  std::vector<int> delivery_times_ms;
+  std::string trace_str;
+  if (!base::ReadFileToString(trace_path, &trace_str)) {
+    LOG(ERROR) << "Failed to read network trace.";
+    return delivery_times_ms;
+  }
+  for (const base::StringPiece& line :
+       base::SplitStringPiece(trace_str, "\n", base::TRIM_WHITESPACE,
+                              base::SPLIT_WANT_NONEMPTY)) {
+    int delivery_time_ms;
+    if (!base::StringToInt(line, &delivery_time_ms) || delivery_time_ms < 0 ||
+        (!delivery_times_ms.empty() &&
+         delivery_time_ms < delivery_times_ms.back())) {
+      LOG(ERROR) << "Invalid network trace line: " << line;
+      return std::vector<int>();
+    }
+    delivery_times_ms.push_back(delivery_time_ms);
+  }
+  if (delivery_times_ms.empty() || delivery_times_ms.back() == 0) {
+    LOG(ERROR) << "Empty network trace.";
+    return std::vector<int>();
+  }
+  return delivery_times_ms;
+}
+
 bool IsModelValid(const NetworkSimulationModel& model) {
   if (!model.has_type())
     return false;
@@ -728,15 +864,48 @@ int main(int argc, char** argv) {
   NetworkSimulationModel model = media::cast::LoadModel(
       cmd->GetSwitchValuePath(media::cast::kModelPath));
 
-  base::DictionaryValue values;
-  values.SetBoolean("sim", true);
-  values.SetString("sim-id", sim_id);
+  std::vector<int> delivery_times_ms;
+  if (cmd->HasSwitch(media::cast::kNetworkTrace)) {
+    delivery_times_ms = media::cast::LoadNetworkTrace(
+        cmd->GetSwitchValuePath(media::cast::kNetworkTrace));
+    if (delivery_times_ms.empty())
+      return 1;
+  }
 
-  std::string extra_data;
-  base::JSONWriter::Write(values, &extra_data);
+  std::vector<media::cast::CongestionControlType> congestion_controls;
+  const std::string congestion_control =
+      cmd->GetSwitchValueASCII(media::cast::kCongestionControl);
+  if (congestion_control.empty() || congestion_control == "adaptive") {
+    congestion_controls.push_back(media::cast::CONGESTION_CONTROL_ADAPTIVE);
+  } else if (congestion_control == "delay-based") {
+    congestion_controls.push_back(media::cast::CONGESTION_CONTROL_DELAY_BASED);
+  } else if (congestion_control == "all") {
+    congestion_controls.push_back(media::cast::CONGESTION_CONTROL_ADAPTIVE);
+    congestion_controls.push_back(media::cast::CONGESTION_CONTROL_DELAY_BASED);
+  } else {
+    LOG(ERROR) << "Unknown congestion control: " << congestion_control;
+    return 1;
+  }
 
   // Run.
-  media::cast::RunSimulation(source_path, log_output_path, metrics_output_path,
-                             yuv_output_path, extra_data, model);
+  for (media::cast::CongestionControlType type : congestion_controls) {
+    const std::string name = media::cast::CongestionControlName(type);
+    base::DictionaryValue values;
+    values.SetBoolean("sim", true);
+    values.SetString("sim-id", sim_id);
+    values.SetString("congestion-control", name);
+
+    std::string extra_data;
+    base::JSONWriter::Write(values, &extra_data);
+
+    // Each run writes to its own files when comparing congestion controls.
+    const std::string suffix =
+        congestion_controls.size() > 1 ? "-" + name : std::string();
+    media::cast::RunSimulation(
+        source_path, log_output_path.InsertBeforeExtensionASCII(suffix),
+        metrics_output_path.InsertBeforeExtensionASCII(suffix),
+        yuv_output_path.InsertBeforeExtensionASCII(suffix), extra_data, model,
+        delivery_times_ms, type);
+  }
   return 0;
 }
@@ -0,0 +1,240 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+//
+// This program compares the throughput and CPU cost of UdpTransport's
+// per-packet and batched IO modes over loopback. Packets are sent in paced
+// sender sized bursts through a UDPProxy, which forwards them on its own
+// thread, to a receiving UdpTransport. To run the program, run:
+// $ ./out/Release/udp_transport_benchmark [--packets=N] [--packet-size=N]
+
+#include <stddef.h>
+#include <stdint.h>
+#include <time.h>
+
+#include <cstdio>
+#include <memory>
+#include <string>
+
+#include "base/at_exit.h"
+#include "base/bind.h"
+#include "base/command_line.h"
+#include "base/files/file_descriptor_watcher_posix.h"
+#include "base/logging.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/threading/thread_task_runner_handle.h"
+#include "base/time/time.h"
+#include "media/cast/net/cast_transport_config.h"
+#include "media/cast/net/pacing/paced_sender.h"
+#include "media/cast/net/udp_transport.h"
+#include "media/cast/test/utility/net_utility.h"
+#include "media/cast/test/utility/udp_proxy.h"
+#include "net/base/ip_address.h"
+
+namespace media {
+namespace cast {
+
+namespace {
+
+const char kSwitchPackets[] = "packets";
+const char kSwitchPacketSize[] = "packet-size";
+
+// The run ends once no packet has arrived for this long.
+const int kIdleTimeoutMs = 500;
+
+enum IOMode {
+  IO_MODE_PER_PACKET,
+  IO_MODE_BATCHED,
+  IO_MODE_BATCHED_GSO,
+};
+
+const char* IOModeName(IOMode mode) {
+  switch (mode) {
+    case IO_MODE_PER_PACKET:
+      return "per-packet";
+    case IO_MODE_BATCHED:
+      return "batched";
+    case IO_MODE_BATCHED_GSO:
+      return "batched+gso";
+  }
+  return "";
+}
+
+void UpdateCastTransportStatus(CastTransportStatus status) {
+  if (status == TRANSPORT_SOCKET_ERROR)
+    LOG(ERROR) << "Socket error.";
+}
+
+bool IgnorePacket(std::unique_ptr<Packet> packet) {
+  return true;
+}
+
+// Returns the CPU time used by this process, on all threads.
+base::TimeDelta ProcessCpuTime() {
+  timespec ts;
+  clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+  return base::TimeDelta::FromSeconds(ts.tv_sec) +
+         base::TimeDelta::FromMicroseconds(ts.tv_nsec / 1000);
+}
+
+// Sends |num_packets| packets of |packet_size| bytes in bursts of
+// kMaxBurstSize through a UDPProxy and counts the packets received.
+class BenchmarkRun {
+ public:
+  BenchmarkRun(IOMode mode, size_t num_packets, size_t packet_size)
+      : num_packets_(num_packets),
+        packet_(new base::RefCountedData<Packet>(Packet(packet_size, 0x42))),
+        packets_sent_(0),
+        packets_received_(0) {
+    const net::IPEndPoint sender_address = test::GetFreeLocalPort();
+    const net::IPEndPoint proxy_address = test::GetFreeLocalPort();
+    const net::IPEndPoint receiver_address = test::GetFreeLocalPort();
+
+    proxy_ = test::UDPProxy::Create(proxy_address, receiver_address, nullptr,
+                                    nullptr, nullptr);
+
+    const scoped_refptr<base::SingleThreadTaskRunner> task_runner =
+        base::ThreadTaskRunnerHandle::Get();
+    sender_.reset(new UdpTransport(nullptr, task_runner, sender_address,
+                                   proxy_address,
+                                   base::Bind(&UpdateCastTransportStatus)));
+    receiver_.reset(new UdpTransport(
+        nullptr, task_runner, receiver_address,
+        net::IPEndPoint(net::IPAddress::IPv4AllZeros(), 0),
+        base::Bind(&UpdateCastTransportStatus)));
+    sender_->SetSendBufferSize(kMaxBurstSize * kMaxIpPacketSize * 16);
+    if (mode != IO_MODE_PER_PACKET) {
+      sender_->UseBatchedIO(mode == IO_MODE_BATCHED_GSO);
+      receiver_->UseBatchedIO(mode == IO_MODE_BATCHED_GSO);
+    }
+  }
+
+  void Run() {
+    sender_->StartReceiving(base::Bind(&IgnorePacket));
+    receiver_->StartReceiving(
+        base::Bind(&BenchmarkRun::OnPacket, base::Unretained(this)));
+
+    const base::TimeTicks start = base::TimeTicks::Now();
+    const base::TimeDelta start_cpu = ProcessCpuTime();
+    base::ThreadTaskRunnerHandle::Get()->PostTask(
+        FROM_HERE,
+        base::Bind(&BenchmarkRun::SendBursts, base::Unretained(this)));
+    last_packet_time_ = start;
+    CheckIdle();
+    run_loop_.Run();
+    const base::TimeDelta elapsed = last_packet_time_ - start;
+    const base::TimeDelta cpu = ProcessCpuTime() - start_cpu;
+
+    receiver_->StopReceiving();
+    sender_->StopReceiving();
+
+    wall_time_ = elapsed;
+    cpu_time_ = cpu;
+  }
+
+  size_t packets_received() const { return packets_received_; }
+  base::TimeDelta wall_time() const { return wall_time_; }
+  base::TimeDelta cpu_time() const { return cpu_time_; }
+
+ private:
+  // Sends bursts until all packets are sent or the socket is blocked, in
+  // which case this is called again once it is writable.
+  void SendBursts() {
+    const base::Closure cb =
+        base::Bind(&BenchmarkRun::SendBursts, base::Unretained(this));
+    while (packets_sent_ < num_packets_) {
+      for (size_t i = 0; i < kMaxBurstSize && packets_sent_ < num_packets_;
+           ++i) {
+        ++packets_sent_;
+        if (!sender_->SendPacket(packet_, cb))
+          return;
+      }
+      if (!sender_->FlushBatch(cb))
+        return;
+    }
+  }
+
+  bool OnPacket(std::unique_ptr<Packet> packet) {
+    ++packets_received_;
+    last_packet_time_ = base::TimeTicks::Now();
+    if (packets_received_ == num_packets_)
+      run_loop_.Quit();
+    return true;
+  }
+
+  void CheckIdle() {
+    if (base::TimeTicks::Now() - last_packet_time_ >
+        base::TimeDelta::FromMilliseconds(kIdleTimeoutMs)) {
+      run_loop_.Quit();
+      return;
+    }
+    base::ThreadTaskRunnerHandle::Get()->PostDelayedTask(
+        FROM_HERE, base::Bind(&BenchmarkRun::CheckIdle, base::Unretained(this)),
+        base::TimeDelta::FromMilliseconds(kIdleTimeoutMs / 5));
+  }
+
+  const size_t num_packets_;
+  const PacketRef packet_;
+  std::unique_ptr<test::UDPProxy> proxy_;
+  std::unique_ptr<UdpTransport> sender_;
+  std::unique_ptr<UdpTransport> receiver_;
+  size_t packets_sent_;
+  size_t packets_received_;
+  base::TimeTicks last_packet_time_;
+  base::TimeDelta wall_time_;
+  base::TimeDelta cpu_time_;
+  base::RunLoop run_loop_;
+
+  DISALLOW_COPY_AND_ASSIGN(BenchmarkRun);
+};
+
+}  // namespace
+
+void RunBenchmark(size_t num_packets, size_t packet_size) {
+  printf("%-12s %10s %10s %14s %16s\n", "mode", "received", "loss %",
+         "packets/s", "cpu us/packet");
+  for (IOMode mode :
+       {IO_MODE_PER_PACKET, IO_MODE_BATCHED, IO_MODE_BATCHED_GSO}) {
+    BenchmarkRun run(mode, num_packets, packet_size);
+    run.Run();
+    const size_t received = run.packets_received();
+    printf("%-12s %10zu %10.2f %14.0f %16.2f\n", IOModeName(mode), received,
+           100.0 * (num_packets - received) / num_packets,
+           received / run.wall_time().InSecondsF(),
+           run.cpu_time().InMicrosecondsF() / num_packets);
+  }
+}
+
+}  // namespace cast
+}  // namespace media
+
+int main(int argc, char** argv) {
+  base::AtExitManager at_exit;
+  base::CommandLine::Init(argc, argv);
+  const base::CommandLine* command_line =
+      base::CommandLine::ForCurrentProcess();
+
+  size_t num_packets = 200000;
+  size_t packet_size = 1200;
+  if (command_line->HasSwitch(media::cast::kSwitchPackets)) {
+    base::StringToSizeT(
+        command_line->GetSwitchValueASCII(media::cast::kSwitchPackets),
+        &num_packets);
+  }
+  if (command_line->HasSwitch(media::cast::kSwitchPacketSize)) {
+    base::StringToSizeT(
+        command_line->GetSwitchValueASCII(media::cast::kSwitchPacketSize),
+        &packet_size);
+  }
+  CHECK_GT(num_packets, 0u);
+  CHECK_LE(packet_size, media::cast::kMaxIpPacketSize);
+
+  base::MessageLoopForIO message_loop;
+  base::FileDescriptorWatcher file_descriptor_watcher(&message_loop);
+  media::cast::RunBenchmark(num_packets, packet_size);
+  return 0;
+}
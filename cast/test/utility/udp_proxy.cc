@@ -6,6 +6,8 @@
 
 #include <math.h>
 #include <stdlib.h>
+
+#include <algorithm>
 #include <utility>
 #include <vector>
 
@@ -342,6 +344,115 @@ std::unique_ptr<PacketPipe> NewNetworkGlitchPipe(double average_work_time,
       new NetworkGlitchPipe(average_work_time, average_outage_time));
 }
 
+// Replays a recorded link, like mahimahi's link shells. Each delivery
+// opportunity lets up to kBytesPerDeliveryOpportunity bytes out of the buffer;
+// opportunities are wasted while the buffer is empty. The trace repeats with a
+// period of its last delivery time.
+class TraceDrivenBuffer : public PacketPipe {
+ public:
+  TraceDrivenBuffer(size_t buffer_size,
+                    const std::vector<int>& delivery_times_ms)
+      : buffer_size_(0),
+        max_buffer_size_(buffer_size),
+        delivery_times_ms_(delivery_times_ms),
+        cycle_(0),
+        index_(0),
+        bytes_to_send_(0),
+        weak_factory_(this) {
+    CHECK_GT(max_buffer_size_, 0UL);
+    CHECK(!delivery_times_ms_.empty());
+    CHECK(std::is_sorted(delivery_times_ms_.begin(), delivery_times_ms_.end()));
+    CHECK_GE(delivery_times_ms_.front(), 0);
+    CHECK_GT(delivery_times_ms_.back(), 0);
+  }
+
+  void Send(std::unique_ptr<Packet> packet) final {
+    if (start_time_.is_null())
+      start_time_ = clock_->NowTicks();
+    if (packet->size() + buffer_size_ <= max_buffer_size_) {
+      buffer_size_ += packet->size();
+      buffer_.push_back(linked_ptr<Packet>(packet.release()));
+      if (buffer_.size() == 1) {
+        FindNextDeliveryOpportunity();
+        Schedule();
+      }
+    }
+  }
+
+ private:
+  static const int64_t kBytesPerDeliveryOpportunity = 1500;
+
+  base::TimeTicks DeliveryTime() const {
+    return start_time_ + base::TimeDelta::FromMilliseconds(
+                             cycle_ * delivery_times_ms_.back() +
+                             delivery_times_ms_[index_]);
+  }
+
+  // Finds the first delivery opportunity no earlier than now.
+  void FindNextDeliveryOpportunity() {
+    const int64_t elapsed_ms =
+        (clock_->NowTicks() - start_time_).InMillisecondsRoundedUp();
+    cycle_ = elapsed_ms / delivery_times_ms_.back();
+    index_ = std::lower_bound(delivery_times_ms_.begin(),
+                              delivery_times_ms_.end(),
+                              elapsed_ms % delivery_times_ms_.back()) -
+             delivery_times_ms_.begin();
+    if (index_ == delivery_times_ms_.size()) {
+      ++cycle_;
+      index_ = 0;
+    }
+  }
+
+  void Schedule() {
+    task_runner_->PostDelayedTask(
+        FROM_HERE,
+        base::Bind(&TraceDrivenBuffer::ProcessBuffer,
+                   weak_factory_.GetWeakPtr()),
+        DeliveryTime() - clock_->NowTicks());
+  }
+
+  void ProcessBuffer() {
+    while (!buffer_.empty() && DeliveryTime() <= clock_->NowTicks()) {
+      bytes_to_send_ += kBytesPerDeliveryOpportunity;
+      if (++index_ == delivery_times_ms_.size()) {
+        ++cycle_;
+        index_ = 0;
+      }
+      while (!buffer_.empty() &&
+             static_cast<int64_t>(buffer_.front()->size()) <= bytes_to_send_) {
+        std::unique_ptr<Packet> packet(buffer_.front().release());
+        bytes_to_send_ -= packet->size();
+        buffer_size_ -= packet->size();
+        buffer_.pop_front();
+        pipe_->Send(std::move(packet));
+      }
+    }
+    if (buffer_.empty()) {
+      bytes_to_send_ = 0;
+      return;
+    }
+    Schedule();
+  }
+
+  std::deque<linked_ptr<Packet>> buffer_;
+  size_t buffer_size_;
+  const size_t max_buffer_size_;
+  const std::vector<int> delivery_times_ms_;
+  base::TimeTicks start_time_;
+  // The next delivery opportunity.
+  int64_t cycle_;
+  size_t index_;
+  // Unused bytes of the delivery opportunities taken so far.
+  int64_t bytes_to_send_;
+  base::WeakPtrFactory<TraceDrivenBuffer> weak_factory_;
+};
+
+std::unique_ptr<PacketPipe> NewTraceDrivenBuffer(
+    size_t buffer_size,
+    const std::vector<int>& delivery_times_ms) {
+  return std::unique_ptr<PacketPipe>(
+      new TraceDrivenBuffer(buffer_size, delivery_times_ms));
+}
 
 // Internal buffer object for a client of the IPP model.
 class InterruptedPoissonProcess::InternalBuffer : public PacketPipe {
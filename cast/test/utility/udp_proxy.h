@@ -167,6 +167,16 @@ std::unique_ptr<PacketPipe> NewRandomSortedDelay(
 std::unique_ptr<PacketPipe> NewNetworkGlitchPipe(double average_work_time,
                                                  double average_outage_time);
 
+// This PacketPipe emulates a buffer of a given size, emptied at the delivery
+// opportunities of a recorded link: each of |delivery_times_ms|, relative to
+// the first packet and repeating with a period of the last one, lets one
+// 1500 byte packet's worth out of the buffer. This is the trace format of
+// mahimahi's link shells. Packets entering the buffer will be dropped if there
+// is not enough room for them.
+std::unique_ptr<PacketPipe> NewTraceDrivenBuffer(
+    size_t buffer_size,
+    const std::vector<int>& delivery_times_ms);
+
 // This method builds a stack of PacketPipes to emulate a reasonably
 // good network. ~50mbit, ~3ms latency, no packet loss unless saturated.
 std::unique_ptr<PacketPipe> GoodNetwork();
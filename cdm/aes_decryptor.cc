@@ -4,22 +4,28 @@
 
 #include "media/cdm/aes_decryptor.h"
 
+#include <openssl/aes.h>
 #include <stddef.h>
+#include <string.h>
+
+#include <algorithm>
 #include <list>
 #include <utility>
 #include <vector>
 
+#include "base/bind.h"
 #include "base/logging.h"
 #include "base/macros.h"
 #include "base/strings/string_number_conversions.h"
-#include "crypto/encryptor.h"
-#include "crypto/symmetric_key.h"
+#include "base/sys_info.h"
+#include "base/threading/worker_pool.h"
 #include "media/base/audio_decoder_config.h"
 #include "media/base/cdm_key_information.h"
 #include "media/base/cdm_promise.h"
 #include "media/base/decoder_buffer.h"
 #include "media/base/decrypt_config.h"
 #include "media/base/limits.h"
+#include "media/base/parallel_row_bands.h"
 #include "media/base/video_decoder_config.h"
 #include "media/base/video_frame.h"
 #include "media/cdm/json_web_key.h"
@@ -112,121 +118,180 @@ void AesDecryptor::SessionIdDecryptionKeyMap::Erase(
 
 uint32_t AesDecryptor::next_session_id_ = 1;
 
-enum ClearBytesBufferSel {
-  kSrcContainsClearBytes,
-  kDstContainsClearBytes
+// Samples with fewer encrypted bytes than this are always decrypted on the
+// calling thread; handing them to other threads costs more than it saves.
+static const size_t kMinParallelDecryptSize = 512 * 1024;
+
+// The most threads, including the calling one, that decrypt a single sample.
+static const int kMaxDecryptThreads = 4;
+
+// A run of encrypted bytes in a sample. The encrypted bytes of all subsamples
+// are decrypted with one contiguous CTR keystream, which this run starts
+// |keystream_offset| bytes into.
+struct CypherRange {
+  const uint8_t* src;
+  uint8_t* dst;
+  size_t size;
+  size_t keystream_offset;
 };
 
-static void CopySubsamples(const std::vector<SubsampleEntry>& subsamples,
-                           const ClearBytesBufferSel sel,
-                           const uint8_t* src,
-                           uint8_t* dst) {
-  for (size_t i = 0; i < subsamples.size(); i++) {
-    const SubsampleEntry& subsample = subsamples[i];
-    if (sel == kSrcContainsClearBytes) {
-      src += subsample.clear_bytes;
-    } else {
-      dst += subsample.clear_bytes;
-    }
-    memcpy(dst, src, subsample.cypher_bytes);
-    src += subsample.cypher_bytes;
-    dst += subsample.cypher_bytes;
+// Sets |counter| to the counter block |blocks| blocks after |iv|, treating
+// both as 128-bit big-endian integers, as CTR mode increments them.
+static void AdvanceCounter(const std::string& iv,
+                           size_t blocks,
+                           uint8_t counter[AES_BLOCK_SIZE]) {
+  memcpy(counter, iv.data(), AES_BLOCK_SIZE);
+  uint64_t carry = blocks;
+  for (int i = AES_BLOCK_SIZE - 1; i >= 0 && carry; --i) {
+    carry += counter[i];
+    counter[i] = static_cast<uint8_t>(carry);
+    carry >>= 8;
+  }
+}
+
+// Decrypts the bytes of |ranges| which lie within [|begin|, |end|) of the
+// keystream, reading the input sample and writing the output buffer directly.
+// |begin| must be on a block boundary so the counter can be derived from it.
+static void DecryptCypherRanges(const AES_KEY* key,
+                                const std::string& iv,
+                                const std::vector<CypherRange>& ranges,
+                                size_t begin,
+                                size_t end) {
+  DCHECK_EQ(begin % AES_BLOCK_SIZE, 0u);
+
+  uint8_t counter[AES_BLOCK_SIZE];
+  AdvanceCounter(iv, begin / AES_BLOCK_SIZE, counter);
+  uint8_t keystream[AES_BLOCK_SIZE];
+  unsigned int keystream_used = 0;
+
+  for (const CypherRange& range : ranges) {
+    const size_t range_end = range.keystream_offset + range.size;
+    if (range_end <= begin)
+      continue;
+    if (range.keystream_offset >= end)
+      break;
+
+    // A range which ends away from a block boundary leaves the rest of the
+    // block's keystream in |keystream| for the start of the next range.
+    const size_t offset = std::max(begin, range.keystream_offset) -
+                          range.keystream_offset;
+    const size_t size = std::min(end, range_end) - range.keystream_offset -
+                        offset;
+    AES_ctr128_encrypt(range.src + offset, range.dst + offset, size, key,
+                       counter, keystream, &keystream_used);
   }
 }
 
+// Decrypts AES blocks [|begin_block|, |end_block|) of the keystream of a
+// sample with |encrypted_size| encrypted bytes.
+static void DecryptCypherBlocks(const AES_KEY* key,
+                                const std::string* iv,
+                                const std::vector<CypherRange>* ranges,
+                                size_t encrypted_size,
+                                int begin_block,
+                                int end_block) {
+  DecryptCypherRanges(
+      key, *iv, *ranges, begin_block * static_cast<size_t>(AES_BLOCK_SIZE),
+      std::min(end_block * static_cast<size_t>(AES_BLOCK_SIZE),
+               encrypted_size));
+}
+
 // Decrypts |input| using |key|.  Returns a DecoderBuffer with the decrypted
 // data if decryption succeeded or NULL if decryption failed.
+//
+// Samples with enough encrypted data are split into slices which are
+// decrypted by the calling thread and up to |max_tasks| tasks posted to
+// |task_runner|. Returns only once all slices are decrypted.
 static scoped_refptr<DecoderBuffer> DecryptData(const DecoderBuffer& input,
-                                                crypto::SymmetricKey* key) {
+                                                const AES_KEY* key,
+                                                base::TaskRunner* task_runner,
+                                                int max_tasks) {
   CHECK(input.data_size());
   CHECK(input.decrypt_config());
   CHECK(key);
 
-  crypto::Encryptor encryptor;
-  if (!encryptor.Init(key, crypto::Encryptor::CTR, "")) {
-    DVLOG(1) << "Could not initialize decryptor.";
-    return NULL;
-  }
-
-  DCHECK_EQ(input.decrypt_config()->iv().size(),
-            static_cast<size_t>(DecryptConfig::kDecryptionKeySize));
-  if (!encryptor.SetCounter(input.decrypt_config()->iv())) {
+  const std::string& iv = input.decrypt_config()->iv();
+  DCHECK_EQ(iv.size(), static_cast<size_t>(DecryptConfig::kDecryptionKeySize));
+  if (iv.size() != AES_BLOCK_SIZE) {
     DVLOG(1) << "Could not set counter block.";
     return NULL;
   }
 
-  const char* sample = reinterpret_cast<const char*>(input.data());
+  const uint8_t* sample = input.data();
   size_t sample_size = static_cast<size_t>(input.data_size());
 
   DCHECK_GT(sample_size, 0U) << "No sample data to be decrypted.";
   if (sample_size == 0)
     return NULL;
 
-  if (input.decrypt_config()->subsamples().empty()) {
-    std::string decrypted_text;
-    base::StringPiece encrypted_text(sample, sample_size);
-    if (!encryptor.Decrypt(encrypted_text, &decrypted_text)) {
-      DVLOG(1) << "Could not decrypt data.";
-      return NULL;
-    }
-
-    // TODO(xhwang): Find a way to avoid this data copy.
-    return DecoderBuffer::CopyFrom(
-        reinterpret_cast<const uint8_t*>(decrypted_text.data()),
-        decrypted_text.size());
-  }
-
   const std::vector<SubsampleEntry>& subsamples =
       input.decrypt_config()->subsamples();
 
-  size_t total_clear_size = 0;
   size_t total_encrypted_size = 0;
-  for (size_t i = 0; i < subsamples.size(); i++) {
-    total_clear_size += subsamples[i].clear_bytes;
-    total_encrypted_size += subsamples[i].cypher_bytes;
-    // Check for overflow. This check is valid because *_size is unsigned.
-    DCHECK(total_clear_size >= subsamples[i].clear_bytes);
-    if (total_encrypted_size < subsamples[i].cypher_bytes)
+  if (subsamples.empty()) {
+    total_encrypted_size = sample_size;
+  } else {
+    size_t total_clear_size = 0;
+    for (size_t i = 0; i < subsamples.size(); i++) {
+      total_clear_size += subsamples[i].clear_bytes;
+      total_encrypted_size += subsamples[i].cypher_bytes;
+      // Check for overflow. This check is valid because *_size is unsigned.
+      DCHECK(total_clear_size >= subsamples[i].clear_bytes);
+      if (total_encrypted_size < subsamples[i].cypher_bytes)
+        return NULL;
+    }
+    size_t total_size = total_clear_size + total_encrypted_size;
+    if (total_size < total_clear_size || total_size != sample_size) {
+      DVLOG(1) << "Subsample sizes do not equal input size";
       return NULL;
+    }
+
+    // No need to decrypt if there is no encrypted data.
+    if (total_encrypted_size <= 0)
+      return DecoderBuffer::CopyFrom(sample, sample_size);
   }
-  size_t total_size = total_clear_size + total_encrypted_size;
-  if (total_size < total_clear_size || total_size != sample_size) {
-    DVLOG(1) << "Subsample sizes do not equal input size";
-    return NULL;
-  }
 
-  // No need to decrypt if there is no encrypted data.
-  if (total_encrypted_size <= 0) {
-    return DecoderBuffer::CopyFrom(reinterpret_cast<const uint8_t*>(sample),
-                                   sample_size);
+  // Every output byte is written exactly once: clear bytes are copied and
+  // encrypted bytes are decrypted from |input| into |output| in place of the
+  // copy.
+  scoped_refptr<DecoderBuffer> output(new DecoderBuffer(sample_size));
+  uint8_t* dst = output->writable_data();
+
+  std::vector<CypherRange> ranges;
+  if (subsamples.empty()) {
+    ranges.push_back({sample, dst, sample_size, 0});
+  } else {
+    // The encrypted portions of all subsamples form a contiguous keystream,
+    // such that an encrypted subsample that ends away from a block boundary
+    // is immediately followed by the start of the next encrypted subsample.
+    ranges.reserve(subsamples.size());
+    size_t keystream_offset = 0;
+    for (const SubsampleEntry& subsample : subsamples) {
+      memcpy(dst, sample, subsample.clear_bytes);
+      sample += subsample.clear_bytes;
+      dst += subsample.clear_bytes;
+      if (subsample.cypher_bytes) {
+        ranges.push_back(
+            {sample, dst, subsample.cypher_bytes, keystream_offset});
+      }
+      sample += subsample.cypher_bytes;
+      dst += subsample.cypher_bytes;
+      keystream_offset += subsample.cypher_bytes;
+    }
   }
 
-  // The encrypted portions of all subsamples must form a contiguous block,
-  // such that an encrypted subsample that ends away from a block boundary is
-  // immediately followed by the start of the next encrypted subsample. We
-  // copy all encrypted subsamples to a contiguous buffer, decrypt them, then
-  // copy the decrypted bytes over the encrypted bytes in the output.
-  // TODO(strobe): attempt to reduce number of memory copies
-  std::unique_ptr<uint8_t[]> encrypted_bytes(new uint8_t[total_encrypted_size]);
-  CopySubsamples(subsamples, kSrcContainsClearBytes,
-                 reinterpret_cast<const uint8_t*>(sample),
-                 encrypted_bytes.get());
-
-  base::StringPiece encrypted_text(
-      reinterpret_cast<const char*>(encrypted_bytes.get()),
-      total_encrypted_size);
-  std::string decrypted_text;
-  if (!encryptor.Decrypt(encrypted_text, &decrypted_text)) {
-    DVLOG(1) << "Could not decrypt data.";
-    return NULL;
+  if (total_encrypted_size < kMinParallelDecryptSize) {
+    DecryptCypherRanges(key, iv, ranges, 0, total_encrypted_size);
+    return output;
   }
-  DCHECK_EQ(decrypted_text.size(), encrypted_text.size());
 
-  scoped_refptr<DecoderBuffer> output = DecoderBuffer::CopyFrom(
-      reinterpret_cast<const uint8_t*>(sample), sample_size);
-  CopySubsamples(subsamples, kDstContainsClearBytes,
-                 reinterpret_cast<const uint8_t*>(decrypted_text.data()),
-                 output->writable_data());
+  // Split the keystream into block-aligned slices of about 256 KB, treating
+  // each AES block as a row. Each slice derives its counter from its offset.
+  const int num_blocks = static_cast<int>(
+      (total_encrypted_size + AES_BLOCK_SIZE - 1) / AES_BLOCK_SIZE);
+  RunInParallelRowBands(num_blocks, AES_BLOCK_SIZE, 1, task_runner, max_tasks,
+                        base::Bind(&DecryptCypherBlocks, key, &iv, &ranges,
+                                   total_encrypted_size));
   return output;
 }
 
@@ -481,16 +546,30 @@ void AesDecryptor::Decrypt(StreamType stream_type,
     decrypted = DecoderBuffer::CopyFrom(encrypted->data(),
                                         encrypted->data_size());
   } else {
-    const std::string& key_id = encrypted->decrypt_config()->key_id();
-    base::AutoLock auto_lock(key_map_lock_);
-    DecryptionKey* key = GetKey_Locked(key_id);
-    if (!key) {
-      DVLOG(1) << "Could not find a matching key for the given key ID.";
-      decrypt_cb.Run(kNoKey, NULL);
-      return;
+    // Copy the key schedule so the lock isn't held while decrypting; the key
+    // may be removed or replaced meanwhile.
+    AES_KEY key_schedule;
+    {
+      const std::string& key_id = encrypted->decrypt_config()->key_id();
+      base::AutoLock auto_lock(key_map_lock_);
+      DecryptionKey* key = GetKey_Locked(key_id);
+      if (!key) {
+        DVLOG(1) << "Could not find a matching key for the given key ID.";
+        decrypt_cb.Run(kNoKey, NULL);
+        return;
+      }
+      key_schedule = *key->key_schedule();
     }
 
-    decrypted = DecryptData(*encrypted.get(), key->decryption_key());
+    int max_tasks = 0;
+    if (encrypted->data_size() >= static_cast<int>(kMinParallelDecryptSize)) {
+      max_tasks = std::min(base::SysInfo::NumberOfProcessors(),
+                           kMaxDecryptThreads) -
+                  1;
+    }
+    decrypted = DecryptData(*encrypted.get(), &key_schedule,
+                            base::WorkerPool::GetTaskRunner(true).get(),
+                            max_tasks);
     if (!decrypted) {
       DVLOG(1) << "Decryption failed.";
       decrypt_cb.Run(kError, NULL);
@@ -615,10 +694,12 @@ AesDecryptor::DecryptionKey::~DecryptionKey() {}
 
 bool AesDecryptor::DecryptionKey::Init() {
   CHECK(!secret_.empty());
-  decryption_key_ =
-      crypto::SymmetricKey::Import(crypto::SymmetricKey::AES, secret_);
-  if (!decryption_key_)
+  key_schedule_.reset(new AES_KEY());
+  if (AES_set_encrypt_key(reinterpret_cast<const uint8_t*>(secret_.data()),
+                          secret_.size() * 8, key_schedule_.get()) != 0) {
+    key_schedule_.reset();
     return false;
+  }
   return true;
 }
 
@@ -23,14 +23,17 @@
 
 class GURL;
 
-namespace crypto {
-class SymmetricKey;
-}
+// BoringSSL's AES_KEY.
+struct aes_key_st;
 
 namespace media {
 
 // Decrypts an AES encrypted buffer into an unencrypted buffer. The AES
 // encryption must be CTR with a key size of 128bits.
+//
+// Samples are decrypted straight from the encrypted buffer into the output
+// buffer, a subsample range at a time. Large samples, e.g. 4K key frames, are
+// split into keystream slices which are decrypted in parallel.
 class MEDIA_EXPORT AesDecryptor : public ContentDecryptionModule,
                                   public CdmContext,
                                   public Decryptor {
@@ -83,25 +86,26 @@ class MEDIA_EXPORT AesDecryptor : public ContentDecryptionModule,
   void DeinitializeDecoder(StreamType stream_type) override;
 
  private:
-  // TODO(fgalligan): Remove this and change KeyMap to use crypto::SymmetricKey
-  // as there are no decryptors that are performing an integrity check.
   // Helper class that manages the decryption key.
   class DecryptionKey {
    public:
     explicit DecryptionKey(const std::string& secret);
     ~DecryptionKey();
 
-    // Creates the encryption key.
+    // Expands the secret into the AES key schedule.
     bool Init();
 
-    crypto::SymmetricKey* decryption_key() { return decryption_key_.get(); }
+    // Returns the expanded key schedule. It's computed once when the key is
+    // added rather than on every Decrypt(), and is read-only afterwards.
+    const aes_key_st* key_schedule() const { return key_schedule_.get(); }
 
    private:
     // The base secret that is used to create the decryption key.
     const std::string secret_;
 
-    // The key used to decrypt the data.
-    std::unique_ptr<crypto::SymmetricKey> decryption_key_;
+    // The key schedule used to decrypt the data. CTR mode only ever runs the
+    // cipher forwards, so this is the encryption schedule.
+    std::unique_ptr<aes_key_st> key_schedule_;
 
     DISALLOW_COPY_AND_ASSIGN(DecryptionKey);
   };
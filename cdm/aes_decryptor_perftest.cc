@@ -0,0 +1,167 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/bind_helpers.h"
+#include "base/macros.h"
+#include "base/time/time.h"
+#include "media/base/cdm_callback_promise.h"
+#include "media/base/decoder_buffer.h"
+#include "media/base/decrypt_config.h"
+#include "media/base/mock_filters.h"
+#include "media/cdm/aes_decryptor.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "url/gurl.h"
+
+using ::testing::NiceMock;
+
+namespace media {
+
+// Each sample is decrypted until at least this many bytes have been
+// processed.
+static const double kBenchmarkBytes = 512.0 * 1024 * 1024;
+
+const uint8_t kKeyId[] = {0x00, 0x01, 0x02, 0x03};
+
+// A key for |kKeyId|.
+const char kKeyAsJWK[] =
+    "{"
+    "  \"keys\": ["
+    "    {"
+    "      \"kty\": \"oct\","
+    "      \"kid\": \"AAECAw\","
+    "      \"k\": \"BAUGBwgJCgsMDQ4PEBESEw\""
+    "    }"
+    "  ]"
+    "}";
+
+const uint8_t kIv[] = {0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27,
+                       0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+class AesDecryptorPerfTest : public testing::Test {
+ public:
+  AesDecryptorPerfTest()
+      : decryptor_(new AesDecryptor(
+            GURL::EmptyGURL(),
+            base::Bind(&MockCdmClient::OnSessionMessage,
+                       base::Unretained(&cdm_client_)),
+            base::Bind(&MockCdmClient::OnSessionClosed,
+                       base::Unretained(&cdm_client_)),
+            base::Bind(&MockCdmClient::OnSessionKeysChange,
+                       base::Unretained(&cdm_client_)))),
+        decrypted_bytes_(0) {}
+
+  void SetUp() override {
+    // AesDecryptor resolves its promises synchronously.
+    decryptor_->CreateSessionAndGenerateRequest(
+        CdmSessionType::TEMPORARY_SESSION, EmeInitDataType::WEBM,
+        std::vector<uint8_t>(kKeyId, kKeyId + arraysize(kKeyId)),
+        std::unique_ptr<NewSessionCdmPromise>(
+            new CdmCallbackPromise<std::string>(
+                base::Bind(&AesDecryptorPerfTest::OnSessionCreated,
+                           base::Unretained(this)),
+                base::Bind(&AesDecryptorPerfTest::OnReject,
+                           base::Unretained(this)))));
+    ASSERT_FALSE(session_id_.empty());
+
+    const std::string jwk(kKeyAsJWK);
+    decryptor_->UpdateSession(
+        session_id_, std::vector<uint8_t>(jwk.begin(), jwk.end()),
+        std::unique_ptr<SimpleCdmPromise>(new CdmCallbackPromise<>(
+            base::Bind(&base::DoNothing),
+            base::Bind(&AesDecryptorPerfTest::OnReject,
+                       base::Unretained(this)))));
+  }
+
+  // Decrypts a |sample_size| byte sample split into subsamples of
+  // |subsample_size| bytes, each with a 16 byte clear header, or without
+  // subsamples if |subsample_size| is zero. Reports the throughput in MB/s.
+  void RunDecryptBenchmark(size_t sample_size,
+                           size_t subsample_size,
+                           const std::string& trace_name) {
+    std::vector<SubsampleEntry> subsamples;
+    for (size_t offset = 0; subsample_size && offset < sample_size;
+         offset += subsample_size) {
+      const size_t size = std::min(subsample_size, sample_size - offset);
+      const uint32_t clear_bytes = std::min<uint32_t>(16, size);
+      subsamples.push_back(SubsampleEntry(clear_bytes, size - clear_bytes));
+    }
+
+    scoped_refptr<DecoderBuffer> encrypted(new DecoderBuffer(sample_size));
+    for (size_t i = 0; i < sample_size; ++i)
+      encrypted->writable_data()[i] = static_cast<uint8_t>(i * 31);
+    encrypted->set_decrypt_config(std::unique_ptr<DecryptConfig>(
+        new DecryptConfig(
+            std::string(reinterpret_cast<const char*>(kKeyId),
+                        arraysize(kKeyId)),
+            std::string(reinterpret_cast<const char*>(kIv), arraysize(kIv)),
+            subsamples)));
+
+    const Decryptor::DecryptCB decrypt_cb = base::Bind(
+        &AesDecryptorPerfTest::OnDecrypted, base::Unretained(this));
+    decrypted_bytes_ = 0;
+    double total_bytes = 0;
+    base::TimeTicks start = base::TimeTicks::Now();
+    while (total_bytes < kBenchmarkBytes) {
+      decryptor_->Decrypt(Decryptor::kVideo, encrypted, decrypt_cb);
+      total_bytes += sample_size;
+    }
+    const double total_time_seconds =
+        (base::TimeTicks::Now() - start).InSecondsF();
+
+    ASSERT_EQ(total_bytes, decrypted_bytes_);
+    perf_test::PrintResult("aes_decryptor_decrypt", "", trace_name,
+                           total_bytes / total_time_seconds / (1024 * 1024),
+                           "MB/s", true);
+  }
+
+ private:
+  void OnSessionCreated(const std::string& session_id) {
+    session_id_ = session_id;
+  }
+
+  void OnReject(CdmPromise::Exception exception_code,
+                uint32_t system_code,
+                const std::string& error_message) {
+    FAIL() << "Unexpectedly rejected with message: " << error_message;
+  }
+
+  void OnDecrypted(Decryptor::Status status,
+                   const scoped_refptr<DecoderBuffer>& decrypted) {
+    ASSERT_EQ(Decryptor::kSuccess, status);
+    decrypted_bytes_ += decrypted->data_size();
+  }
+
+  NiceMock<MockCdmClient> cdm_client_;
+  scoped_refptr<AesDecryptor> decryptor_;
+  std::string session_id_;
+  double decrypted_bytes_;
+
+  DISALLOW_COPY_AND_ASSIGN(AesDecryptorPerfTest);
+};
+
+// Audio sized samples, encrypted in full.
+TEST_F(AesDecryptorPerfTest, Audio) {
+  RunDecryptBenchmark(2 * 1024, 0, "audio_2KB");
+}
+
+// Video samples with a clear NALU header on each of a few slices. The 4 MB
+// sample, e.g. a 4K key frame, is large enough to be decrypted in parallel.
+TEST_F(AesDecryptorPerfTest, Video) {
+  RunDecryptBenchmark(32 * 1024, 8 * 1024, "video_32KB");
+  RunDecryptBenchmark(256 * 1024, 64 * 1024, "video_256KB");
+  RunDecryptBenchmark(4 * 1024 * 1024, 512 * 1024, "video_4MB");
+}
+
+}  // namespace media
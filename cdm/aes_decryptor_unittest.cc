@@ -15,6 +15,8 @@
 #include "base/macros.h"
 #include "base/run_loop.h"
 #include "base/values.h"
+#include "crypto/encryptor.h"
+#include "crypto/symmetric_key.h"
 #include "media/base/cdm_callback_promise.h"
 #include "media/base/cdm_config.h"
 #include "media/base/cdm_key_information.h"
@@ -117,6 +119,10 @@ const char kWrongSizedKeyAsJWK[] =
     "  ]"
     "}";
 
+// The key in kKeyAsJWK.
+const uint8_t kKey[] = {0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b,
+                        0x0c, 0x0d, 0x0e, 0x0f, 0x10, 0x11, 0x12, 0x13};
+
 const uint8_t kIv[] = {0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27,
                        0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
 
@@ -213,6 +219,44 @@ static scoped_refptr<DecoderBuffer> CreateEncryptedBuffer(
   return encrypted_buffer;
 }
 
+// Encrypts the cypher bytes of |subsample_entries| in |data| with kKey and
+// |iv|, as a single CTR stream.
+static std::vector<uint8_t> EncryptSubsamples(
+    const std::vector<uint8_t>& data,
+    const std::vector<uint8_t>& iv,
+    const std::vector<SubsampleEntry>& subsample_entries) {
+  std::unique_ptr<crypto::SymmetricKey> key = crypto::SymmetricKey::Import(
+      crypto::SymmetricKey::AES,
+      std::string(reinterpret_cast<const char*>(kKey), arraysize(kKey)));
+  crypto::Encryptor encryptor;
+  CHECK(encryptor.Init(key.get(), crypto::Encryptor::CTR, ""));
+  CHECK(encryptor.SetCounter(
+      std::string(reinterpret_cast<const char*>(&iv[0]), iv.size())));
+
+  std::string cypher_text;
+  size_t offset = 0;
+  for (const SubsampleEntry& subsample : subsample_entries) {
+    offset += subsample.clear_bytes;
+    cypher_text.append(reinterpret_cast<const char*>(&data[offset]),
+                       subsample.cypher_bytes);
+    offset += subsample.cypher_bytes;
+  }
+  std::string encrypted_text;
+  CHECK(encryptor.Encrypt(cypher_text, &encrypted_text));
+
+  std::vector<uint8_t> encrypted(data);
+  offset = 0;
+  size_t encrypted_offset = 0;
+  for (const SubsampleEntry& subsample : subsample_entries) {
+    offset += subsample.clear_bytes;
+    memcpy(&encrypted[offset], &encrypted_text[encrypted_offset],
+           subsample.cypher_bytes);
+    offset += subsample.cypher_bytes;
+    encrypted_offset += subsample.cypher_bytes;
+  }
+  return encrypted;
+}
+
 enum ExpectedResult { RESOLVED, REJECTED };
 
 // These tests only test decryption logic (no decoding). Parameter to this
@@ -691,6 +735,37 @@ TEST_P(AesDecryptorTest, SubsampleDecryptionWithOffset) {
   DecryptAndExpect(encrypted_buffer, original_data_, SUCCESS);
 }
 
+// Samples this large are decrypted in slices on several threads. Use
+// subsamples which don't end on block boundaries so the slices have to pick up
+// the keystream part way through a subsample.
+TEST_P(AesDecryptorTest, LargeSubsampleDecryption) {
+  std::string session_id = CreateSession(key_id_);
+  UpdateSessionAndExpect(session_id, kKeyAsJWK, RESOLVED, true);
+
+  std::vector<SubsampleEntry> subsample_entries;
+  size_t size = 0;
+  for (uint32_t i = 0; i < 64; ++i) {
+    subsample_entries.push_back(SubsampleEntry(7 + i, 65536 + 3 * i));
+    size += subsample_entries.back().clear_bytes +
+            subsample_entries.back().cypher_bytes;
+  }
+  std::vector<uint8_t> original_data(size);
+  for (size_t i = 0; i < size; ++i)
+    original_data[i] = static_cast<uint8_t>(i * 31 + (i >> 8));
+
+  scoped_refptr<DecoderBuffer> encrypted_buffer = CreateEncryptedBuffer(
+      EncryptSubsamples(original_data, iv_, subsample_entries), key_id_, iv_,
+      subsample_entries);
+  DecryptAndExpect(encrypted_buffer, original_data, SUCCESS);
+
+  // The same data without subsamples.
+  std::vector<SubsampleEntry> full_sample(1, SubsampleEntry(0, size));
+  encrypted_buffer = CreateEncryptedBuffer(
+      EncryptSubsamples(original_data, iv_, full_sample), key_id_, iv_,
+      std::vector<SubsampleEntry>());
+  DecryptAndExpect(encrypted_buffer, original_data, SUCCESS);
+}
+
 TEST_P(AesDecryptorTest, SubsampleWrongSize) {
   std::string session_id = CreateSession(key_id_);
   UpdateSessionAndExpect(session_id, kKeyAsJWK, RESOLVED, true);
@@ -0,0 +1,148 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/filters/annex_b_scanner.h"
+
+#include "build/build_config.h"
+#include "media/filters/annex_b_scanner_testing.h"
+
+#if defined(ARCH_CPU_X86_FAMILY)
+#include <immintrin.h>
+
+#include "base/cpu.h"
+
+// GCC and clang only emit AVX2 instructions inside functions that explicitly
+// target AVX2; MSVC accepts the intrinsics anywhere.
+#if defined(COMPILER_MSVC)
+#include <intrin.h>
+#define TARGET_AVX2
+#else
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#define FIND_ESCAPE_SEQUENCE_FUNC FindEscapeSequence_SSE2
+#elif defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
+#include <arm_neon.h>
+#define FIND_ESCAPE_SEQUENCE_FUNC FindEscapeSequence_NEON
+#else
+#define FIND_ESCAPE_SEQUENCE_FUNC FindEscapeSequence_C
+#endif
+
+namespace media {
+namespace annex_b {
+
+size_t FindEscapeSequence_C(const uint8_t* data, size_t size) {
+  // Look at the last byte of each candidate first: if it's greater than 0x03
+  // it can't be X, nor either zero, of any sequence overlapping it, so three
+  // candidates are ruled out at once.  In coded data that's the usual case.
+  size_t i = 0;
+  while (i + 2 < size) {
+    if (data[i + 2] > 0x03)
+      i += 3;
+    else if (data[i + 1] != 0x00)
+      i += 2;
+    else if (data[i] != 0x00)
+      i += 1;
+    else
+      return i;
+  }
+  return size;
+}
+
+#if defined(ARCH_CPU_X86_FAMILY)
+static int CountTrailingZeroBits(uint32_t mask) {
+#if defined(COMPILER_MSVC)
+  unsigned long index;
+  _BitScanForward(&index, mask);
+  return static_cast<int>(index);
+#else
+  return __builtin_ctz(mask);
+#endif
+}
+
+size_t FindEscapeSequence_SSE2(const uint8_t* data, size_t size) {
+  const __m128i m_zero = _mm_setzero_si128();
+  const __m128i m_three = _mm_set1_epi8(0x03);
+
+  // Each pass checks the 16 candidates starting in data[i, i + 16), which
+  // need two more bytes of lookahead.
+  size_t i = 0;
+  for (; i + 18 <= size; i += 16) {
+    const __m128i m_b0 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    const __m128i m_b1 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1));
+    const __m128i m_b2 =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 2));
+    const __m128i m_match = _mm_and_si128(
+        _mm_and_si128(_mm_cmpeq_epi8(m_b0, m_zero),
+                      _mm_cmpeq_epi8(m_b1, m_zero)),
+        _mm_cmpeq_epi8(_mm_min_epu8(m_b2, m_three), m_b2));
+    const int mask = _mm_movemask_epi8(m_match);
+    if (mask)
+      return i + CountTrailingZeroBits(mask);
+  }
+  return i + FindEscapeSequence_C(data + i, size - i);
+}
+
+TARGET_AVX2 size_t FindEscapeSequence_AVX2(const uint8_t* data, size_t size) {
+  const __m256i m_zero = _mm256_setzero_si256();
+  const __m256i m_three = _mm256_set1_epi8(0x03);
+
+  size_t i = 0;
+  for (; i + 34 <= size; i += 32) {
+    const __m256i m_b0 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+    const __m256i m_b1 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 1));
+    const __m256i m_b2 =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 2));
+    const __m256i m_match = _mm256_and_si256(
+        _mm256_and_si256(_mm256_cmpeq_epi8(m_b0, m_zero),
+                         _mm256_cmpeq_epi8(m_b1, m_zero)),
+        _mm256_cmpeq_epi8(_mm256_min_epu8(m_b2, m_three), m_b2));
+    const uint32_t mask = _mm256_movemask_epi8(m_match);
+    if (mask)
+      return i + CountTrailingZeroBits(mask);
+  }
+  return i + FindEscapeSequence_SSE2(data + i, size - i);
+}
+#elif defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
+size_t FindEscapeSequence_NEON(const uint8_t* data, size_t size) {
+  const uint8x16_t m_zero = vdupq_n_u8(0);
+  const uint8x16_t m_three = vdupq_n_u8(0x03);
+
+  // NEON has no movemask, so only test whether any candidate in the vector
+  // matches and leave finding which one to the C version.
+  size_t i = 0;
+  for (; i + 18 <= size; i += 16) {
+    const uint8x16_t m_match =
+        vandq_u8(vandq_u8(vceqq_u8(vld1q_u8(data + i), m_zero),
+                          vceqq_u8(vld1q_u8(data + i + 1), m_zero)),
+                 vcleq_u8(vld1q_u8(data + i + 2), m_three));
+    const uint64x2_t m_match64 = vreinterpretq_u64_u8(m_match);
+    if (vgetq_lane_u64(m_match64, 0) | vgetq_lane_u64(m_match64, 1))
+      return i + FindEscapeSequence_C(data + i, 18);
+  }
+  return i + FindEscapeSequence_C(data + i, size - i);
+}
+#endif
+
+typedef size_t (*FindEscapeSequenceProc)(const uint8_t* data, size_t size);
+static FindEscapeSequenceProc g_find_escape_sequence_proc =
+    FIND_ESCAPE_SEQUENCE_FUNC;
+
+void InitializeCPUSpecificFeatures() {
+#if defined(ARCH_CPU_X86_FAMILY)
+  base::CPU cpu;
+  if (cpu.has_avx2())
+    g_find_escape_sequence_proc = FindEscapeSequence_AVX2;
+#endif
+}
+
+size_t FindEscapeSequence(const uint8_t* data, size_t size) {
+  return g_find_escape_sequence_proc(data, size);
+}
+
+}  // namespace annex_b
+}  // namespace media
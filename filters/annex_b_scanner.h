@@ -0,0 +1,34 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_FILTERS_ANNEX_B_SCANNER_H_
+#define MEDIA_FILTERS_ANNEX_B_SCANNER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "media/base/media_export.h"
+
+namespace media {
+namespace annex_b {
+
+// Selects the fastest FindEscapeSequence() implementation for the current
+// CPU.  Until this is called the baseline SSE2 (x86) or NEON (ARM) version is
+// used.  Called by InitializeMediaLibrary().
+MEDIA_EXPORT void InitializeCPUSpecificFeatures();
+
+// Returns the offset of the first three byte sequence 0x00 0x00 X, with
+// X <= 0x03, which lies entirely within |data|, or |size| if there is none.
+//
+// Every Annex B start code prefix (0x00 0x00 0x01) and every emulation
+// prevention sequence (0x00 0x00 0x03) begins with one of these, and they
+// can't otherwise occur in H.264 or H.265 NALU payloads; so this is the only
+// scan needed to find either, and large runs of payload can be skipped a
+// vector at a time.
+MEDIA_EXPORT size_t FindEscapeSequence(const uint8_t* data, size_t size);
+
+}  // namespace annex_b
+}  // namespace media
+
+#endif  // MEDIA_FILTERS_ANNEX_B_SCANNER_H_
@@ -0,0 +1,114 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <string>
+
+#include "base/cpu.h"
+#include "base/files/memory_mapped_file.h"
+#include "base/time/time.h"
+#include "build/build_config.h"
+#include "media/base/test_data_util.h"
+#include "media/filters/annex_b_scanner.h"
+#include "media/filters/annex_b_scanner_testing.h"
+#include "media/filters/h264_parser.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace media {
+namespace annex_b {
+
+// Each stream is scanned until at least this many bytes have been processed.
+static const double kBenchmarkBytes = 2.0 * 1024 * 1024 * 1024;
+
+typedef size_t (*FindEscapeSequenceProc)(const uint8_t* data, size_t size);
+
+// Walks every escape sequence in |stream| with |proc|, the way the parsers
+// look for start codes, and reports the throughput in GB/s.
+static void RunScanBenchmark(const base::MemoryMappedFile& stream,
+                             FindEscapeSequenceProc proc,
+                             const std::string& stream_name,
+                             const std::string& trace_name) {
+  const uint8_t* const data = stream.data();
+  const size_t size = stream.length();
+  size_t escape_sequences = 0;
+  double total_bytes = 0;
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  while (total_bytes < kBenchmarkBytes) {
+    for (size_t pos = 0; pos < size;) {
+      pos += proc(data + pos, size - pos);
+      if (pos < size) {
+        ++escape_sequences;
+        ++pos;
+      }
+    }
+    total_bytes += size;
+  }
+  const double total_time_seconds =
+      (base::TimeTicks::Now() - start).InSecondsF();
+
+  // Keep the compiler from discarding the scan.
+  ASSERT_GT(escape_sequences, 0u);
+  perf_test::PrintResult("annex_b_scan_" + stream_name, "", trace_name,
+                         total_bytes / total_time_seconds / 1e9, "GB/s", true);
+}
+
+// Benchmarks walking every NALU with H264Parser, which also includes reading
+// each NALU header.
+static void RunParserBenchmark(const base::MemoryMappedFile& stream,
+                               const std::string& stream_name) {
+  size_t nalus = 0;
+  double total_bytes = 0;
+
+  base::TimeTicks start = base::TimeTicks::Now();
+  while (total_bytes < kBenchmarkBytes) {
+    H264Parser parser;
+    parser.SetStream(stream.data(), stream.length());
+    H264NALU nalu;
+    while (parser.AdvanceToNextNALU(&nalu) == H264Parser::kOk)
+      ++nalus;
+    total_bytes += stream.length();
+  }
+  const double total_time_seconds =
+      (base::TimeTicks::Now() - start).InSecondsF();
+
+  ASSERT_GT(nalus, 0u);
+  perf_test::PrintResult("h264_parser_advance_to_next_nalu", "", stream_name,
+                         total_bytes / total_time_seconds / 1e9, "GB/s", true);
+}
+
+static void RunBenchmarks(const std::string& file_name,
+                          const std::string& stream_name,
+                          bool is_h264) {
+  base::MemoryMappedFile stream;
+  ASSERT_TRUE(stream.Initialize(GetTestDataFilePath(file_name)))
+      << "Couldn't open stream file: " << file_name;
+
+  RunScanBenchmark(stream, FindEscapeSequence_C, stream_name, "unoptimized");
+#if defined(ARCH_CPU_X86_FAMILY)
+  RunScanBenchmark(stream, FindEscapeSequence_SSE2, stream_name, "sse2");
+  if (base::CPU().has_avx2())
+    RunScanBenchmark(stream, FindEscapeSequence_AVX2, stream_name, "avx2");
+#elif defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
+  RunScanBenchmark(stream, FindEscapeSequence_NEON, stream_name, "neon");
+#endif
+
+  if (is_h264)
+    RunParserBenchmark(stream, stream_name);
+}
+
+// Scan real H.264 and H.265 elementary streams.
+TEST(AnnexBScannerPerfTest, H264) {
+  RunBenchmarks("test-25fps.h264", "h264", true);
+}
+
+TEST(AnnexBScannerPerfTest, H265) {
+  RunBenchmarks("bear.hevc", "h265", false);
+}
+
+}  // namespace annex_b
+}  // namespace media
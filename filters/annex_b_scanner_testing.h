@@ -0,0 +1,34 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_FILTERS_ANNEX_B_SCANNER_TESTING_H_
+#define MEDIA_FILTERS_ANNEX_B_SCANNER_TESTING_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "build/build_config.h"
+#include "media/base/media_export.h"
+
+namespace media {
+namespace annex_b {
+
+// Optimized versions exposed for testing.  See annex_b_scanner.h for details.
+MEDIA_EXPORT size_t FindEscapeSequence_C(const uint8_t* data, size_t size);
+
+#if defined(ARCH_CPU_X86_FAMILY)
+MEDIA_EXPORT size_t FindEscapeSequence_SSE2(const uint8_t* data, size_t size);
+
+// Callers must check base::CPU::has_avx2() before using this.
+MEDIA_EXPORT size_t FindEscapeSequence_AVX2(const uint8_t* data, size_t size);
+#endif
+
+#if defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
+MEDIA_EXPORT size_t FindEscapeSequence_NEON(const uint8_t* data, size_t size);
+#endif
+
+}  // namespace annex_b
+}  // namespace media
+
+#endif  // MEDIA_FILTERS_ANNEX_B_SCANNER_TESTING_H_
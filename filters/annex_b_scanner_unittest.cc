@@ -0,0 +1,152 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+#include "base/cpu.h"
+#include "base/macros.h"
+#include "build/build_config.h"
+#include "media/filters/annex_b_scanner.h"
+#include "media/filters/annex_b_scanner_testing.h"
+#include "media/filters/h264_parser.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+namespace annex_b {
+
+// Long enough for several vectors plus a scalar tail on every implementation.
+static const size_t kBufferSize = 100;
+
+// Straightforward byte at a time reference implementation.
+static size_t FindEscapeSequenceReference(const uint8_t* data, size_t size) {
+  for (size_t i = 0; i + 2 < size; ++i) {
+    if (data[i] == 0x00 && data[i + 1] == 0x00 && data[i + 2] <= 0x03)
+      return i;
+  }
+  return size;
+}
+
+typedef size_t (*FindEscapeSequenceProc)(const uint8_t* data, size_t size);
+
+class AnnexBScannerTest : public testing::Test {
+ public:
+  AnnexBScannerTest() : buffer_(kBufferSize) {}
+
+ protected:
+  // Runs |proc| over every sub-range of |buffer_| and checks it against the
+  // reference implementation.
+  void VerifyAllRanges(FindEscapeSequenceProc proc, const std::string& name) {
+    for (size_t start = 0; start < kBufferSize; ++start) {
+      for (size_t size = 0; start + size <= kBufferSize; ++size) {
+        const uint8_t* data = &buffer_[start];
+        ASSERT_EQ(FindEscapeSequenceReference(data, size), proc(data, size))
+            << name << " start=" << start << " size=" << size;
+      }
+    }
+  }
+
+  void VerifyAllImplementations() {
+    VerifyAllRanges(FindEscapeSequence_C, "c");
+    VerifyAllRanges(FindEscapeSequence, "dispatched");
+#if defined(ARCH_CPU_X86_FAMILY)
+    VerifyAllRanges(FindEscapeSequence_SSE2, "sse2");
+    if (base::CPU().has_avx2())
+      VerifyAllRanges(FindEscapeSequence_AVX2, "avx2");
+#elif defined(ARCH_CPU_ARM_FAMILY) && defined(USE_NEON)
+    VerifyAllRanges(FindEscapeSequence_NEON, "neon");
+#endif
+  }
+
+  std::vector<uint8_t> buffer_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(AnnexBScannerTest);
+};
+
+TEST_F(AnnexBScannerTest, NoEscapeSequence) {
+  // Zero pairs followed by bytes just above the escape range, and bytes <= 3
+  // preceded by only a single zero.
+  for (size_t i = 0; i < kBufferSize; ++i)
+    buffer_[i] = i % 3 == 2 ? 0x04 : 0x00;
+  VerifyAllImplementations();
+
+  for (size_t i = 0; i < kBufferSize; ++i)
+    buffer_[i] = i % 2 ? 0x01 : 0x00;
+  VerifyAllImplementations();
+}
+
+// Place each kind of escape sequence at every position, so that it straddles
+// every vector boundary.
+TEST_F(AnnexBScannerTest, SingleEscapeSequence) {
+  for (uint8_t last_byte = 0x00; last_byte <= 0x04; ++last_byte) {
+    for (size_t pos = 0; pos + 3 <= kBufferSize; ++pos) {
+      memset(buffer_.data(), 0xff, kBufferSize);
+      buffer_[pos] = 0x00;
+      buffer_[pos + 1] = 0x00;
+      buffer_[pos + 2] = last_byte;
+      SCOPED_TRACE(testing::Message() << "last_byte=" << int(last_byte)
+                                      << " pos=" << pos);
+      VerifyAllImplementations();
+    }
+  }
+}
+
+// Runs of zeros of every length, as in zero stuffing and four byte start
+// codes.
+TEST_F(AnnexBScannerTest, ZeroRuns) {
+  for (size_t length = 1; length < 40; ++length) {
+    memset(buffer_.data(), 0x80, kBufferSize);
+    memset(&buffer_[20], 0x00, length);
+    buffer_[20 + length] = 0x01;
+    SCOPED_TRACE(testing::Message() << "length=" << length);
+    VerifyAllImplementations();
+  }
+}
+
+TEST_F(AnnexBScannerTest, RandomData) {
+  // Small values make escape sequences and near misses common.
+  uint32_t state = 1;
+  for (int iteration = 0; iteration < 20; ++iteration) {
+    for (size_t i = 0; i < kBufferSize; ++i) {
+      state = state * 1103515245 + 12345;
+      buffer_[i] = (state >> 16) % 6;
+    }
+    VerifyAllImplementations();
+  }
+}
+
+// H264Parser::FindStartCode() is built on FindEscapeSequence(); verify it
+// skips escape sequences which aren't start codes and still reports four byte
+// start codes and the first unconsidered byte correctly.
+TEST_F(AnnexBScannerTest, H264ParserFindStartCode) {
+  off_t offset;
+  off_t start_code_size;
+
+  const uint8_t kEmulationPreventionThenStartCode[] = {
+      0x65, 0x00, 0x00, 0x03, 0x01, 0x00, 0x00, 0x00, 0x00, 0x01, 0x09};
+  EXPECT_TRUE(H264Parser::FindStartCode(
+      kEmulationPreventionThenStartCode,
+      arraysize(kEmulationPreventionThenStartCode), &offset,
+      &start_code_size));
+  EXPECT_EQ(6, offset);
+  EXPECT_EQ(4, start_code_size);
+
+  const uint8_t kNoStartCode[] = {0x65, 0x00, 0x00, 0x03, 0x01, 0x00, 0x00};
+  EXPECT_FALSE(H264Parser::FindStartCode(kNoStartCode, arraysize(kNoStartCode),
+                                         &offset, &start_code_size));
+  EXPECT_EQ(static_cast<off_t>(arraysize(kNoStartCode) - 2), offset);
+  EXPECT_EQ(0, start_code_size);
+
+  EXPECT_FALSE(
+      H264Parser::FindStartCode(kNoStartCode, 2, &offset, &start_code_size));
+  EXPECT_EQ(0, offset);
+}
+
+}  // namespace annex_b
+}  // namespace media
@@ -5,28 +5,54 @@
 #include "media/filters/file_data_source.h"
 
 #include <algorithm>
+#include <limits>
 #include <utility>
 
 #include "base/logging.h"
+#include "build/build_config.h"
+
+#if defined(OS_POSIX)
+#include <sys/mman.h>
+
+#include "base/process/process_metrics.h"
+#endif
 
 namespace media {
 
+#if defined(ARCH_CPU_32_BITS)
+// Mapping a multi-gigabyte file whole would exhaust a 32-bit address space,
+// so larger files are mapped in windows of this size.
+static const int64_t kMaxMappingSize = 256 * 1024 * 1024;
+#else
+static const int64_t kMaxMappingSize = std::numeric_limits<int64_t>::max();
+#endif
+
+// How far ahead of sequential reads the kernel is asked to read. Scaled up
+// by SetBitrate() for high bitrate media. Must fit in an Atomic32.
+static const int32_t kMinReadaheadSize = 4 * 1024 * 1024;
+static const int32_t kMaxReadaheadSize = 32 * 1024 * 1024;
+static const int kReadaheadSeconds = 4;
+
 FileDataSource::FileDataSource()
-    : force_read_errors_(false),
+    : file_size_(0),
+      max_mapping_size_(kMaxMappingSize),
+      mapping_offset_(0),
+      next_read_position_(0),
+      sequential_(false),
+      readahead_end_(0),
+      readahead_size_(kMinReadaheadSize),
+      force_read_errors_(false),
       force_streaming_(false),
-      bytes_read_(0) {
-}
+      bytes_read_(0) {}
 
-FileDataSource::FileDataSource(base::File file)
-    : force_read_errors_(false),
-      force_streaming_(false),
-      bytes_read_(0) {
-  file_.Initialize(std::move(file));
+FileDataSource::FileDataSource(base::File file) : FileDataSource() {
+  InitializeFromFile(std::move(file));
 }
 
 bool FileDataSource::Initialize(const base::FilePath& file_path) {
-  DCHECK(!file_.IsValid());
-  return file_.Initialize(file_path);
+  DCHECK(!mapping_ && !file_.IsValid());
+  return InitializeFromFile(
+      base::File(file_path, base::File::FLAG_OPEN | base::File::FLAG_READ));
 }
 
 void FileDataSource::Stop() {}
@@ -37,29 +63,35 @@ void FileDataSource::Read(int64_t position,
                           int size,
                           uint8_t* data,
                           const DataSource::ReadCB& read_cb) {
-  if (force_read_errors_ || !file_.IsValid()) {
+  if (force_read_errors_ || (!mapping_ && !file_.IsValid())) {
     read_cb.Run(kReadError);
     return;
   }
 
-  int64_t file_size = file_.length();
-
-  CHECK_GE(file_size, 0);
+  CHECK_GE(file_size_, 0);
   CHECK_GE(position, 0);
   CHECK_GE(size, 0);
 
   // Cap position and size within bounds.
-  position = std::min(position, file_size);
+  position = std::min(position, file_size_);
   int64_t clamped_size =
-      std::min(static_cast<int64_t>(size), file_size - position);
-
-  memcpy(data, file_.data() + position, clamped_size);
+      std::min(static_cast<int64_t>(size), file_size_ - position);
+
+  if (clamped_size > 0) {
+    if (!MapRange(position, clamped_size)) {
+      read_cb.Run(kReadError);
+      return;
+    }
+    AdviseRead(position, clamped_size);
+    memcpy(data, mapping_->data() + (position - mapping_offset_),
+           clamped_size);
+  }
   bytes_read_ += clamped_size;
   read_cb.Run(clamped_size);
 }
 
 bool FileDataSource::GetSize(int64_t* size_out) {
-  *size_out = file_.length();
+  *size_out = file_size_;
   return true;
 }
 
@@ -67,8 +99,138 @@ bool FileDataSource::IsStreaming() {
   return force_streaming_;
 }
 
-void FileDataSource::SetBitrate(int bitrate) {}
+void FileDataSource::SetBitrate(int bitrate) {
+  // Keep a few seconds of media ahead of the reader. Called on the media
+  // thread while reads happen elsewhere, hence the atomic.
+  const int64_t readahead_size =
+      std::max<int64_t>(kMinReadaheadSize,
+                        std::min<int64_t>(kMaxReadaheadSize,
+                                          static_cast<int64_t>(bitrate) / 8 *
+                                              kReadaheadSeconds));
+  base::subtle::NoBarrier_Store(&readahead_size_,
+                                static_cast<int32_t>(readahead_size));
+}
 
 FileDataSource::~FileDataSource() {}
 
+bool FileDataSource::InitializeFromFile(base::File file) {
+  if (!file.IsValid())
+    return false;
+
+  const int64_t file_size = file.GetLength();
+  if (file_size < 0)
+    return false;
+
+  if (file_size > max_mapping_size_) {
+    // Windows are mapped on demand by MapRange().
+    file_ = std::move(file);
+    file_size_ = file_size;
+    return true;
+  }
+
+  std::unique_ptr<base::MemoryMappedFile> mapping(new base::MemoryMappedFile());
+  if (!mapping->Initialize(std::move(file)))
+    return false;
+  mapping_ = std::move(mapping);
+  file_size_ = mapping_->length();
+  return true;
+}
+
+bool FileDataSource::MapRange(int64_t position, int64_t size) {
+  if (mapping_ && position >= mapping_offset_ &&
+      position + size <= mapping_offset_ + static_cast<int64_t>(
+                                               mapping_->length())) {
+    return true;
+  }
+
+  // Whole file mappings contain every range.
+  DCHECK(file_.IsValid());
+
+  // Start the window a little before |position| so that short backwards
+  // seeks, e.g. to reparse a header, don't move it again.
+  const int64_t window_offset =
+      std::max<int64_t>(0, position - max_mapping_size_ / 8);
+  const int64_t window_size =
+      std::min(file_size_ - window_offset,
+               std::max(max_mapping_size_, position + size - window_offset));
+
+  // Unmap the old window first so that at most one is ever mapped.
+  mapping_.reset();
+  std::unique_ptr<base::MemoryMappedFile> mapping(new base::MemoryMappedFile());
+  base::MemoryMappedFile::Region region;
+  region.offset = window_offset;
+  region.size = window_size;
+  if (!mapping->Initialize(file_.Duplicate(), region)) {
+    DVLOG(1) << "Failed to map " << window_size << " bytes at "
+             << window_offset;
+    return false;
+  }
+  mapping_ = std::move(mapping);
+  mapping_offset_ = window_offset;
+
+  // Hints don't carry over to the new mapping.
+  sequential_ = false;
+  readahead_end_ = 0;
+  return true;
+}
+
+void FileDataSource::AdviseRead(int64_t position, int64_t size) {
+#if defined(OS_POSIX)
+  const int64_t end = position + size;
+  const int64_t mapping_end =
+      mapping_offset_ + static_cast<int64_t>(mapping_->length());
+
+  // Only read ahead once the reader is reading sequentially, so that probing
+  // and seeking, e.g. to an index at the end of the file, don't pull in data
+  // which won't be used.
+  if (position != next_read_position_) {
+    next_read_position_ = end;
+    readahead_end_ = 0;
+    if (sequential_) {
+      Advise(mapping_offset_, mapping_end, MADV_NORMAL);
+      sequential_ = false;
+    }
+    return;
+  }
+  next_read_position_ = end;
+
+  if (!sequential_) {
+    Advise(mapping_offset_, mapping_end, MADV_SEQUENTIAL);
+    sequential_ = true;
+  }
+
+  // Top up the readahead once the reader is halfway through it, so it's
+  // requested in large batches rather than on every read.
+  const int64_t readahead_size = base::subtle::NoBarrier_Load(&readahead_size_);
+  if (readahead_end_ - end > readahead_size / 2)
+    return;
+  const int64_t readahead_begin = std::max(readahead_end_, end);
+  const int64_t readahead_end = std::min(end + readahead_size, mapping_end);
+  if (readahead_end <= readahead_begin)
+    return;
+  Advise(readahead_begin, readahead_end, MADV_WILLNEED);
+  readahead_end_ = readahead_end;
+#endif
+}
+
+#if defined(OS_POSIX)
+void FileDataSource::Advise(int64_t begin, int64_t end, int advice) {
+  DCHECK_GE(begin, mapping_offset_);
+  DCHECK_LE(end, mapping_offset_ + static_cast<int64_t>(mapping_->length()));
+
+  // madvise() needs a page aligned address. The mapping itself starts on a
+  // page boundary, so rounding down stays within it.
+  const uintptr_t page_mask = base::GetPageSize() - 1;
+  const uintptr_t start = reinterpret_cast<uintptr_t>(
+      mapping_->data() + (begin - mapping_offset_));
+  const uintptr_t aligned_start = start & ~page_mask;
+  const size_t length =
+      static_cast<size_t>(end - begin) + (start - aligned_start);
+
+  // These are only hints, so failure is harmless.
+  if (madvise(reinterpret_cast<void*>(aligned_start), length, advice))
+    DPLOG(WARNING) << "madvise() failed";
+}
+#endif
+
 }  // namespace media
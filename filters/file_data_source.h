@@ -7,18 +7,26 @@
 
 #include <stdint.h>
 
+#include <memory>
 #include <string>
 
+#include "base/atomicops.h"
 #include "base/files/file.h"
 #include "base/files/file_path.h"
 #include "base/files/memory_mapped_file.h"
 #include "base/macros.h"
+#include "build/build_config.h"
 #include "media/base/data_source.h"
 
 namespace media {
 
 // Basic data source that treats the URL as a file path, and uses the file
 // system to read data for a media pipeline.
+//
+// The file is memory mapped. Files too large to map whole, which on 32-bit
+// builds includes long recordings, are mapped a window at a time around the
+// read position instead. While reads are sequential the kernel is told to read
+// ahead of them, so demuxing doesn't stall on page faults.
 class MEDIA_EXPORT FileDataSource : public DataSource {
  public:
   FileDataSource();
@@ -44,8 +52,53 @@ class MEDIA_EXPORT FileDataSource : public DataSource {
   uint64_t bytes_read_for_testing() { return bytes_read_; }
   void reset_bytes_read_for_testing() { bytes_read_ = 0; }
 
+  // Files larger than |size| are mapped in windows of |size| bytes. Must be
+  // called before the file is opened.
+  void set_max_mapping_size_for_testing(int64_t size) {
+    max_mapping_size_ = size;
+  }
+  int64_t mapping_size_for_testing() const {
+    return mapping_ ? mapping_->length() : 0;
+  }
+
  private:
-  base::MemoryMappedFile file_;
+  // Maps all of |file| if it's small enough, otherwise keeps it open so
+  // windows can be mapped as they're read.
+  bool InitializeFromFile(base::File file);
+
+  // Ensures [|position|, |position| + |size|) of the file is mapped, moving
+  // the window if necessary.
+  bool MapRange(int64_t position, int64_t size);
+
+  // Updates the kernel readahead hints for a read of [|position|,
+  // |position| + |size|).
+  void AdviseRead(int64_t position, int64_t size);
+
+#if defined(OS_POSIX)
+  // Applies the madvise() |advice| to [|begin|, |end|) of the file, which must
+  // be within |mapping_|.
+  void Advise(int64_t begin, int64_t end, int advice);
+#endif
+
+  // The file, kept open only when it's mapped a window at a time.
+  base::File file_;
+  int64_t file_size_;
+  int64_t max_mapping_size_;
+
+  // The mapped part of the file, which starts |mapping_offset_| bytes in.
+  std::unique_ptr<base::MemoryMappedFile> mapping_;
+  int64_t mapping_offset_;
+
+  // Where the next read starts if the reader is reading sequentially, whether
+  // the mapping is currently advised as being read sequentially, and how far
+  // into the file readahead has been requested.
+  int64_t next_read_position_;
+  bool sequential_;
+  int64_t readahead_end_;
+
+  // How far ahead of the reader to read. Set by SetBitrate() on the media
+  // thread and read by Read() on the demuxer's blocking thread.
+  base::subtle::Atomic32 readahead_size_;
 
   bool force_read_errors_;
   bool force_streaming_;
@@ -4,7 +4,10 @@
 
 #include <stdint.h>
 
+#include <algorithm>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "base/base_paths.h"
 #include "base/bind.h"
@@ -12,6 +15,7 @@
 #include "base/macros.h"
 #include "base/path_service.h"
 #include "base/strings/utf_string_conversions.h"
+#include "media/base/test_data_util.h"
 #include "media/base/test_helpers.h"
 #include "media/filters/file_data_source.h"
 
@@ -83,4 +87,62 @@ TEST(FileDataSourceTest, ReadData) {
   data_source.Stop();
 }
 
+// Reads from a file mapped in small windows should match reads from the whole
+// file mapping, whichever order they're made in.
+TEST(FileDataSourceTest, WindowedReads) {
+  static const int64_t kWindowSize = 16 * 1024;
+  static const int64_t kLargeReadPosition = 1000;
+  static const int64_t kLargeReadSize = 3 * kWindowSize;
+  const base::FilePath file_path = GetTestDataFilePath("bear-320x240.webm");
+
+  FileDataSource whole_source;
+  ASSERT_TRUE(whole_source.Initialize(file_path));
+  FileDataSource windowed_source;
+  windowed_source.set_max_mapping_size_for_testing(kWindowSize);
+  ASSERT_TRUE(windowed_source.Initialize(file_path));
+
+  int64_t size;
+  ASSERT_TRUE(windowed_source.GetSize(&size));
+  int64_t whole_size;
+  ASSERT_TRUE(whole_source.GetSize(&whole_size));
+  ASSERT_EQ(whole_size, size);
+  ASSERT_GT(size, 4 * kWindowSize);
+  EXPECT_EQ(0, windowed_source.mapping_size_for_testing());
+
+  // Sequential reads which straddle window boundaries, then seeks backwards
+  // and forwards, then a read larger than a window.
+  std::vector<std::pair<int64_t, int>> reads;
+  for (int64_t position = 0; position < size; position += 5000)
+    reads.push_back(std::make_pair(position, 5000));
+  reads.push_back(std::make_pair(size / 2, 4096));
+  reads.push_back(std::make_pair(size / 2 - 1000, 4096));
+  reads.push_back(std::make_pair(100, 10));
+  reads.push_back(std::make_pair(size - 100, 1000));
+  reads.push_back(std::make_pair(kLargeReadPosition,
+                                 static_cast<int>(kLargeReadSize)));
+
+  for (const auto& read : reads) {
+    std::vector<uint8_t> expected(read.second);
+    std::vector<uint8_t> actual(read.second);
+    ReadCBHandler handler;
+    const int expected_size =
+        static_cast<int>(std::min<int64_t>(read.second, size - read.first));
+    EXPECT_CALL(handler, ReadCB(expected_size)).Times(2);
+    whole_source.Read(read.first, read.second, &expected[0],
+                      base::Bind(&ReadCBHandler::ReadCB,
+                                 base::Unretained(&handler)));
+    windowed_source.Read(read.first, read.second, &actual[0],
+                         base::Bind(&ReadCBHandler::ReadCB,
+                                    base::Unretained(&handler)));
+    EXPECT_EQ(expected, actual) << "position=" << read.first;
+  }
+
+  // The oversized read is mapped on its own, along with the lead of an eighth
+  // of a window kept before every read, clamped to the start of the file.
+  EXPECT_EQ(kLargeReadPosition + kLargeReadSize -
+                std::max<int64_t>(0, kLargeReadPosition - kWindowSize / 8),
+            windowed_source.mapping_size_for_testing());
+  EXPECT_EQ(size, whole_source.mapping_size_for_testing());
+}
+
 }  // namespace media
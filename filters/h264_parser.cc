@@ -4,6 +4,7 @@
 
 #include "media/filters/h264_parser.h"
 
+#include <algorithm>
 #include <limits>
 #include <memory>
 
@@ -11,6 +12,7 @@
 #include "base/macros.h"
 #include "base/numerics/safe_math.h"
 #include "media/base/decrypt_config.h"
+#include "media/filters/annex_b_scanner.h"
 #include "ui/gfx/geometry/rect.h"
 #include "ui/gfx/geometry/size.h"
 
@@ -279,27 +281,29 @@ const H264SPS* H264Parser::GetSPS(int sps_id) const {
   return it->second.get();
 }
 
-static inline bool IsStartCode(const uint8_t* data) {
-  return data[0] == 0x00 && data[1] == 0x00 && data[2] == 0x01;
-}
-
 // static
 bool H264Parser::FindStartCode(const uint8_t* data,
                                off_t data_size,
                                off_t* offset,
                                off_t* start_code_size) {
   DCHECK_GE(data_size, 0);
-  off_t bytes_left = data_size;
+  off_t pos = 0;
+
+  // Every start code begins with an escape sequence; skip from one to the next
+  // until one turns out to be a start code.
+  while (data_size - pos >= 3) {
+    pos += annex_b::FindEscapeSequence(data + pos, data_size - pos);
+    if (data_size - pos < 3)
+      break;
 
-  while (bytes_left >= 3) {
-    if (IsStartCode(data)) {
+    if (data[pos + 2] == 0x01) {
       // Found three-byte start code, set pointer at its beginning.
-      *offset = data_size - bytes_left;
+      *offset = pos;
       *start_code_size = 3;
 
       // If there is a zero byte before this start code,
       // then it's actually a four-byte start code, so backtrack one byte.
-      if (*offset > 0 && *(data - 1) == 0x00) {
+      if (*offset > 0 && data[*offset - 1] == 0x00) {
         --(*offset);
         ++(*start_code_size);
       }
@@ -307,16 +311,15 @@ bool H264Parser::FindStartCode(const uint8_t* data,
       return true;
     }
 
-    ++data;
-    --bytes_left;
+    ++pos;
   }
 
   // End of data: offset is pointing to the first byte that was not considered
   // as a possible start of a start code.
   // Note: there is no security issue when receiving a negative |data_size|
-  // since in this case, |bytes_left| is equal to |data_size| and thus
-  // |*offset| is equal to 0 (valid offset).
-  *offset = data_size - bytes_left;
+  // since in this case the loop above is skipped and |*offset| is equal to 0
+  // (valid offset).
+  *offset = std::max<off_t>(0, std::min(pos, data_size - 2));
   *start_code_size = 0;
   return false;
 }
@@ -0,0 +1,844 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/filters/progressive_mp4_demuxer.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <limits>
+#include <set>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/callback_helpers.h"
+#include "base/logging.h"
+#include "base/single_thread_task_runner.h"
+#include "base/strings/string_number_conversions.h"
+#include "media/base/bind_to_current_loop.h"
+#include "media/base/data_source.h"
+#include "media/base/decoder_buffer.h"
+#include "media/base/encryption_scheme.h"
+#include "media/base/media_log.h"
+#include "media/base/media_tracks.h"
+#include "media/base/media_util.h"
+#include "media/base/timestamp_constants.h"
+#include "media/base/video_util.h"
+#include "media/formats/mp4/aac.h"
+#include "media/formats/mp4/bitstream_converter.h"
+#include "media/formats/mp4/box_definitions.h"
+#include "media/formats/mp4/box_reader.h"
+#include "media/formats/mp4/es_descriptor.h"
+#include "media/formats/mp4/sample_table_iterator.h"
+#include "media/formats/mp4/track_run_iterator.h"
+#include "media/formats/mpeg/adts_constants.h"
+
+namespace media {
+
+namespace {
+
+// The largest movie box read. Its sample tables take a few bytes per sample,
+// so this covers many hours of media.
+const int64_t kMaxMoovSize = 256 * 1024 * 1024;
+
+// The largest sample read, to guard against corrupt sample sizes.
+const uint32_t kMaxSampleSize = 64 * 1024 * 1024;
+
+// Returns the config of audio |track|, and the AAC config to write the ADTS
+// headers of its samples with, or an invalid config if the track isn't
+// supported.
+AudioDecoderConfig CreateAudioConfig(const mp4::Track& track,
+                                     const mp4::AAC** aac) {
+  const mp4::SampleDescription& description =
+      track.media.information.sample_table.description;
+  if (description.audio_entries.empty())
+    return AudioDecoderConfig();
+
+  // Changes of the sample description within a track are not supported.
+  const mp4::AudioSampleEntry& entry = description.audio_entries[0];
+  if (entry.format != mp4::FOURCC_MP4A ||
+      !mp4::ESDescriptor::IsAAC(entry.esds.object_type)) {
+    return AudioDecoderConfig();
+  }
+
+  SampleFormat sample_format;
+  if (entry.samplesize == 8) {
+    sample_format = kSampleFormatU8;
+  } else if (entry.samplesize == 16) {
+    sample_format = kSampleFormatS16;
+  } else if (entry.samplesize == 32) {
+    sample_format = kSampleFormatS32;
+  } else {
+    return AudioDecoderConfig();
+  }
+
+  const mp4::AAC& aac_config = entry.esds.aac;
+  std::vector<uint8_t> extra_data;
+#if defined(OS_ANDROID)
+  extra_data = aac_config.codec_specific_data();
+#endif
+  *aac = &aac_config;
+  return AudioDecoderConfig(kCodecAAC, sample_format,
+                            aac_config.GetChannelLayout(false),
+                            aac_config.GetOutputSamplesPerSecond(false),
+                            extra_data, Unencrypted());
+}
+
+// Returns the config of video |track|, or an invalid config if the track
+// isn't supported.
+VideoDecoderConfig CreateVideoConfig(const mp4::Track& track) {
+  const mp4::SampleDescription& description =
+      track.media.information.sample_table.description;
+  if (description.video_entries.empty())
+    return VideoDecoderConfig();
+
+  const mp4::VideoSampleEntry& entry = description.video_entries[0];
+  if (!entry.IsFormatValid() || entry.format == mp4::FOURCC_ENCV)
+    return VideoDecoderConfig();
+
+  gfx::Size coded_size(entry.width, entry.height);
+  gfx::Rect visible_rect(coded_size);
+  gfx::Size natural_size(visible_rect.size());
+  if (entry.pixel_aspect.h_spacing != 1 || entry.pixel_aspect.v_spacing != 1) {
+    natural_size =
+        GetNaturalSize(visible_rect.size(), entry.pixel_aspect.h_spacing,
+                       entry.pixel_aspect.v_spacing);
+  } else if (track.header.width && track.header.height) {
+    natural_size = gfx::Size(track.header.width, track.header.height);
+  }
+
+  // No decoder-specific buffer is needed: H.264 and HEVC parameter sets are
+  // inserted into the converted keyframes.
+  return VideoDecoderConfig(entry.video_codec, entry.video_codec_profile,
+                            PIXEL_FORMAT_YV12, COLOR_SPACE_HD_REC709,
+                            coded_size, visible_rect, natural_size,
+                            EmptyExtraData(), Unencrypted());
+}
+
+// Returns the rotation of |track|'s transformation matrix, which is what
+// FFmpeg reports as the "rotate" metadata of the stream. Transformations other
+// than rotations by multiples of 90 degrees aren't supported.
+VideoRotation GetVideoRotation(const mp4::Track& track) {
+  const int32_t* const matrix = track.header.display_matrix;
+  const int32_t a = matrix[0];
+  const int32_t b = matrix[1];
+  const int32_t c = matrix[3];
+  const int32_t d = matrix[4];
+  if (b == 0 && c == 0) {
+    if (a > 0 && d > 0)
+      return VIDEO_ROTATION_0;
+    if (a < 0 && d < 0)
+      return VIDEO_ROTATION_180;
+  } else if (a == 0 && d == 0) {
+    if (b > 0 && c < 0)
+      return VIDEO_ROTATION_90;
+    if (b < 0 && c > 0)
+      return VIDEO_ROTATION_270;
+  }
+  DVLOG(1) << "Unsupported transformation matrix in track "
+           << track.header.track_id;
+  return VIDEO_ROTATION_0;
+}
+
+}  // namespace
+
+//
+// ProgressiveMP4DemuxerStream
+//
+ProgressiveMP4DemuxerStream::ProgressiveMP4DemuxerStream(
+    ProgressiveMP4Demuxer* demuxer,
+    const mp4::Track& track,
+    std::unique_ptr<mp4::SampleTableIterator> iterator,
+    const AudioDecoderConfig& audio_config,
+    const VideoDecoderConfig& video_config,
+    scoped_refptr<mp4::BitstreamConverter> converter,
+    const mp4::AAC* aac)
+    : demuxer_(demuxer),
+      track_(track),
+      iterator_(std::move(iterator)),
+      type_(audio_config.IsValidConfig() ? AUDIO : VIDEO),
+      audio_config_(audio_config),
+      video_config_(video_config),
+      video_rotation_(GetVideoRotation(track)),
+      converter_(std::move(converter)),
+      aac_(aac),
+      is_enabled_(true),
+      stopped_(false) {
+  DCHECK(demuxer_);
+  DCHECK_NE(audio_config_.IsValidConfig(), video_config_.IsValidConfig());
+}
+
+ProgressiveMP4DemuxerStream::~ProgressiveMP4DemuxerStream() {
+  DCHECK(read_cb_.is_null());
+}
+
+DemuxerStream::Type ProgressiveMP4DemuxerStream::type() const {
+  return type_;
+}
+
+void ProgressiveMP4DemuxerStream::Read(const ReadCB& read_cb) {
+  CHECK(read_cb_.is_null()) << "Overlapping reads are not supported";
+  read_cb_ = BindToCurrentLoop(read_cb);
+
+  if (stopped_ || !is_enabled_ || !iterator_->IsValid()) {
+    base::ResetAndReturn(&read_cb_).Run(kOk, DecoderBuffer::CreateEOSBuffer());
+    return;
+  }
+  demuxer_->RequestSample(this);
+}
+
+AudioDecoderConfig ProgressiveMP4DemuxerStream::audio_decoder_config() {
+  DCHECK_EQ(type_, AUDIO);
+  return audio_config_;
+}
+
+VideoDecoderConfig ProgressiveMP4DemuxerStream::video_decoder_config() {
+  DCHECK_EQ(type_, VIDEO);
+  return video_config_;
+}
+
+bool ProgressiveMP4DemuxerStream::SupportsConfigChanges() {
+  return false;
+}
+
+VideoRotation ProgressiveMP4DemuxerStream::video_rotation() {
+  return video_rotation_;
+}
+
+bool ProgressiveMP4DemuxerStream::enabled() const {
+  return is_enabled_;
+}
+
+void ProgressiveMP4DemuxerStream::set_enabled(bool enabled,
+                                              base::TimeDelta timestamp) {
+  if (enabled == is_enabled_)
+    return;
+
+  is_enabled_ = enabled;
+  if (is_enabled_) {
+    // Resume from the keyframe before the current playback position.
+    iterator_->Seek(timestamp);
+  } else if (!read_cb_.is_null()) {
+    DVLOG(1) << "Read from disabled stream, returning EOS";
+    base::ResetAndReturn(&read_cb_).Run(kOk, DecoderBuffer::CreateEOSBuffer());
+    return;
+  }
+  if (!stream_status_change_cb_.is_null())
+    stream_status_change_cb_.Run(is_enabled_, timestamp);
+}
+
+void ProgressiveMP4DemuxerStream::SetStreamStatusChangeCB(
+    const StreamStatusChangeCB& cb) {
+  DCHECK(!cb.is_null());
+  stream_status_change_cb_ = cb;
+}
+
+bool ProgressiveMP4DemuxerStream::HasPendingRead() const {
+  return !read_cb_.is_null();
+}
+
+void ProgressiveMP4DemuxerStream::SatisfyPendingRead(
+    const scoped_refptr<DecoderBuffer>& buffer) {
+  DCHECK(!read_cb_.is_null());
+  if (!buffer->end_of_stream())
+    iterator_->Advance();
+  base::ResetAndReturn(&read_cb_).Run(kOk, buffer);
+}
+
+scoped_refptr<DecoderBuffer> ProgressiveMP4DemuxerStream::ConvertSample(
+    const uint8_t* sample,
+    size_t sample_size) {
+  DCHECK(converts_samples());
+  const bool is_keyframe = iterator_->is_keyframe();
+  std::vector<SubsampleEntry> subsamples;
+  scoped_refptr<DecoderBuffer> buffer;
+  if (converter_) {
+    size_t converted_size = 0;
+    if (!converter_->GetConvertedFrameSize(sample, sample_size, is_keyframe,
+                                           &converted_size)) {
+      return nullptr;
+    }
+    buffer = new DecoderBuffer(converted_size);
+    if (!converter_->WriteConvertedFrame(sample, sample_size, is_keyframe,
+                                         buffer->writable_data(),
+                                         converted_size, &subsamples)) {
+      return nullptr;
+    }
+  } else {
+    buffer = new DecoderBuffer(kADTSHeaderMinSize + sample_size);
+    if (!aac_->WriteADTSHeader(sample_size, buffer->writable_data()))
+      return nullptr;
+    memcpy(buffer->writable_data() + kADTSHeaderMinSize, sample, sample_size);
+  }
+  SetSampleProperties(buffer.get());
+  return buffer;
+}
+
+scoped_refptr<DecoderBuffer> ProgressiveMP4DemuxerStream::CreateSampleBuffer() {
+  DCHECK(!converts_samples());
+  scoped_refptr<DecoderBuffer> buffer(
+      new DecoderBuffer(iterator_->sample_size()));
+  SetSampleProperties(buffer.get());
+  return buffer;
+}
+
+void ProgressiveMP4DemuxerStream::Seek(base::TimeDelta time) {
+  if (!iterator_->Seek(time))
+    DVLOG(1) << "Track " << track_id() << " has no keyframe to seek to";
+}
+
+void ProgressiveMP4DemuxerStream::Abort() {
+  if (!read_cb_.is_null())
+    base::ResetAndReturn(&read_cb_).Run(DemuxerStream::kAborted, nullptr);
+}
+
+void ProgressiveMP4DemuxerStream::Stop() {
+  stopped_ = true;
+  if (!read_cb_.is_null()) {
+    base::ResetAndReturn(&read_cb_).Run(DemuxerStream::kOk,
+                                        DecoderBuffer::CreateEOSBuffer());
+  }
+}
+
+uint32_t ProgressiveMP4DemuxerStream::track_id() const {
+  return track_.header.track_id;
+}
+
+void ProgressiveMP4DemuxerStream::SetSampleProperties(
+    DecoderBuffer* buffer) const {
+  buffer->set_timestamp(iterator_->cts());
+  buffer->set_duration(iterator_->duration());
+  buffer->set_is_key_frame(iterator_->is_keyframe());
+}
+
+//
+// ProgressiveMP4Demuxer
+//
+ProgressiveMP4Demuxer::ProgressiveMP4Demuxer(
+    const scoped_refptr<base::SingleThreadTaskRunner>& task_runner,
+    DataSource* data_source,
+    const MediaTracksUpdatedCB& media_tracks_updated_cb,
+    const scoped_refptr<MediaLog>& media_log)
+    : host_(nullptr),
+      task_runner_(task_runner),
+      data_source_(data_source),
+      media_log_(media_log),
+      media_tracks_updated_cb_(media_tracks_updated_cb),
+      box_offset_(0),
+      pending_read_(false),
+      pending_read_size_(0),
+      cancel_pending_seek_factory_(this),
+      weak_factory_(this) {
+  DCHECK(task_runner_.get());
+  DCHECK(data_source_);
+  DCHECK(!media_tracks_updated_cb_.is_null());
+}
+
+ProgressiveMP4Demuxer::~ProgressiveMP4Demuxer() {
+  // NOTE: This class is not destroyed on |task_runner|, so we must ensure that
+  // there are no outstanding WeakPtrs by the time we reach here.
+  DCHECK(!weak_factory_.HasWeakPtrs());
+}
+
+std::string ProgressiveMP4Demuxer::GetDisplayName() const {
+  return "ProgressiveMP4Demuxer";
+}
+
+void ProgressiveMP4Demuxer::Initialize(DemuxerHost* host,
+                                       const PipelineStatusCB& status_cb,
+                                       bool enable_text_tracks) {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  host_ = host;
+  init_cb_ = status_cb;
+  weak_this_ = cancel_pending_seek_factory_.GetWeakPtr();
+  box_offset_ = 0;
+  ReadBoxHeader();
+}
+
+void ProgressiveMP4Demuxer::AbortPendingReads() {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+
+  // If Stop() has been called, then drop this call.
+  if (!data_source_)
+    return;
+
+  for (const auto& stream : streams_)
+    stream->Abort();
+
+  // Invalidate the completion callback of the aborted read, if any.
+  weak_factory_.InvalidateWeakPtrs();
+  data_source_->Abort();
+  pending_read_ = false;
+  pending_buffer_ = nullptr;
+  pending_streams_.clear();
+
+  if (!pending_seek_cb_.is_null())
+    CompleteSeek();
+}
+
+void ProgressiveMP4Demuxer::Stop() {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+
+  data_source_->Stop();
+  for (const auto& stream : streams_)
+    stream->Stop();
+  pending_streams_.clear();
+  data_source_ = nullptr;
+
+  // Invalidate WeakPtrs on |task_runner_|, destruction may happen on another
+  // thread.
+  weak_factory_.InvalidateWeakPtrs();
+  cancel_pending_seek_factory_.InvalidateWeakPtrs();
+}
+
+void ProgressiveMP4Demuxer::StartWaitingForSeek(base::TimeDelta seek_time) {}
+
+void ProgressiveMP4Demuxer::CancelPendingSeek(base::TimeDelta seek_time) {
+  if (task_runner_->BelongsToCurrentThread()) {
+    AbortPendingReads();
+  } else {
+    // Don't use GetWeakPtr() here since we are on the wrong thread.
+    task_runner_->PostTask(
+        FROM_HERE,
+        base::Bind(&ProgressiveMP4Demuxer::AbortPendingReads, weak_this_));
+  }
+}
+
+void ProgressiveMP4Demuxer::Seek(base::TimeDelta time,
+                                 const PipelineStatusCB& cb) {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  CHECK(pending_seek_cb_.is_null());
+
+  pending_seek_cb_ = cb;
+  pending_seek_time_ = time;
+
+  // Repositioning doesn't involve any I/O, but has to wait for the sample read
+  // in flight to land.
+  if (!pending_read_)
+    CompleteSeek();
+}
+
+base::Time ProgressiveMP4Demuxer::GetTimelineOffset() const {
+  return base::Time();
+}
+
+DemuxerStream* ProgressiveMP4Demuxer::GetStream(DemuxerStream::Type type) {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  for (const auto& stream : streams_) {
+    if (stream->type() == type && stream->enabled())
+      return stream.get();
+  }
+  return nullptr;
+}
+
+base::TimeDelta ProgressiveMP4Demuxer::GetStartTime() const {
+  return base::TimeDelta();
+}
+
+int64_t ProgressiveMP4Demuxer::GetMemoryUsage() const {
+  int64_t allocation_size = moov_buffer_.capacity() + sample_data_.capacity();
+  if (!moov_)
+    return allocation_size;
+  for (const mp4::Track& track : moov_->tracks) {
+    const mp4::SampleTable& table = track.media.information.sample_table;
+    allocation_size += table.decoding_time_to_sample.entries.capacity() +
+                       table.composition_offset.entries.capacity() +
+                       table.sync_sample.entries.capacity() +
+                       table.sample_to_chunk.entries.capacity() +
+                       table.sample_size.entries.capacity() +
+                       table.chunk_offset.entries.capacity() +
+                       table.chunk_large_offset.entries.capacity();
+  }
+  return allocation_size;
+}
+
+void ProgressiveMP4Demuxer::OnEnabledAudioTracksChanged(
+    const std::vector<MediaTrack::Id>& track_ids,
+    base::TimeDelta currTime) {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+
+  std::set<ProgressiveMP4DemuxerStream*> enabled_streams;
+  for (const auto& id : track_ids) {
+    ProgressiveMP4DemuxerStream* stream = track_id_to_demux_stream_map_[id];
+    DCHECK(stream);
+    DCHECK_EQ(DemuxerStream::AUDIO, stream->type());
+    enabled_streams.insert(stream);
+  }
+
+  // First disable all streams that need to be disabled and then enable streams
+  // that are enabled.
+  for (const auto& stream : streams_) {
+    if (stream->type() == DemuxerStream::AUDIO &&
+        enabled_streams.find(stream.get()) == enabled_streams.end()) {
+      stream->set_enabled(false, currTime);
+    }
+  }
+  for (ProgressiveMP4DemuxerStream* stream : enabled_streams)
+    stream->set_enabled(true, currTime);
+}
+
+void ProgressiveMP4Demuxer::OnSelectedVideoTrackChanged(
+    const std::vector<MediaTrack::Id>& track_ids,
+    base::TimeDelta currTime) {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  DCHECK_LE(track_ids.size(), 1u);
+
+  ProgressiveMP4DemuxerStream* selected_stream = nullptr;
+  if (!track_ids.empty()) {
+    selected_stream = track_id_to_demux_stream_map_[track_ids[0]];
+    DCHECK(selected_stream);
+    DCHECK_EQ(DemuxerStream::VIDEO, selected_stream->type());
+  }
+
+  for (const auto& stream : streams_) {
+    if (stream->type() == DemuxerStream::VIDEO &&
+        stream.get() != selected_stream) {
+      stream->set_enabled(false, currTime);
+    }
+  }
+  if (selected_stream)
+    selected_stream->set_enabled(true, currTime);
+}
+
+void ProgressiveMP4Demuxer::RequestSample(
+    ProgressiveMP4DemuxerStream* stream) {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  DCHECK(stream->HasPendingRead());
+  pending_streams_.push_back(stream);
+  ReadSampleIfNeeded();
+}
+
+void ProgressiveMP4Demuxer::ReadBoxHeader() {
+  data_source_->Read(
+      box_offset_, sizeof(box_header_), box_header_,
+      BindToCurrentLoop(base::Bind(&ProgressiveMP4Demuxer::OnBoxHeaderRead,
+                                   weak_factory_.GetWeakPtr())));
+}
+
+void ProgressiveMP4Demuxer::OnBoxHeaderRead(int bytes_read) {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  if (bytes_read == DataSource::kReadError) {
+    OnInitializeDone(PIPELINE_ERROR_READ);
+    return;
+  }
+
+  // Box headers are a 32-bit size and a FourCC, optionally followed by a
+  // 64-bit size.
+  mp4::BufferReader reader(box_header_, std::max(bytes_read, 0));
+  uint32_t size = 0;
+  mp4::FourCC type;
+  if (!reader.Read4(&size) || !reader.ReadFourCC(&type)) {
+    MEDIA_LOG(ERROR, media_log_) << GetDisplayName() << ": no moov box found";
+    OnInitializeDone(DEMUXER_ERROR_COULD_NOT_PARSE);
+    return;
+  }
+  uint64_t box_size = size;
+  if (size == 1 && !reader.Read8(&box_size)) {
+    OnInitializeDone(DEMUXER_ERROR_COULD_NOT_PARSE);
+    return;
+  }
+  const size_t header_size = reader.pos();
+
+  // Anything but an ISO BMFF file is left to other demuxers.
+  if (box_offset_ == 0 && type != mp4::FOURCC_FTYP) {
+    OnInitializeDone(DEMUXER_ERROR_COULD_NOT_PARSE);
+    return;
+  }
+
+  if (type != mp4::FOURCC_MOOV) {
+    if (size == 0 || box_size < static_cast<uint64_t>(header_size) ||
+        box_size > static_cast<uint64_t>(std::numeric_limits<int64_t>::max() -
+                                         box_offset_)) {
+      // The box runs to the end of the file, or is corrupt.
+      MEDIA_LOG(ERROR, media_log_) << GetDisplayName() << ": no moov box found";
+      OnInitializeDone(DEMUXER_ERROR_COULD_NOT_PARSE);
+      return;
+    }
+    box_offset_ += box_size;
+    ReadBoxHeader();
+    return;
+  }
+
+  int64_t file_size = 0;
+  if (size == 0 && data_source_->GetSize(&file_size) &&
+      file_size > box_offset_) {
+    box_size = file_size - box_offset_;
+  }
+  if (box_size < static_cast<uint64_t>(header_size) ||
+      box_size > static_cast<uint64_t>(kMaxMoovSize)) {
+    MEDIA_LOG(ERROR, media_log_) << GetDisplayName()
+                                 << ": unsupported moov box size " << box_size;
+    OnInitializeDone(DEMUXER_ERROR_COULD_NOT_PARSE);
+    return;
+  }
+
+  moov_buffer_.resize(box_size);
+  data_source_->Read(
+      box_offset_, moov_buffer_.size(), moov_buffer_.data(),
+      BindToCurrentLoop(base::Bind(&ProgressiveMP4Demuxer::OnMoovRead,
+                                   weak_factory_.GetWeakPtr())));
+}
+
+void ProgressiveMP4Demuxer::OnMoovRead(int bytes_read) {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  if (bytes_read != static_cast<int>(moov_buffer_.size())) {
+    OnInitializeDone(bytes_read == DataSource::kReadError
+                         ? PIPELINE_ERROR_READ
+                         : DEMUXER_ERROR_COULD_NOT_PARSE);
+    return;
+  }
+
+  bool err = false;
+  std::unique_ptr<mp4::BoxReader> reader(mp4::BoxReader::ReadTopLevelBox(
+      moov_buffer_.data(), moov_buffer_.size(), media_log_, &err));
+  moov_.reset(new mp4::Movie());
+  const bool parsed = reader && moov_->Parse(reader.get());
+  reader.reset();
+  // The parsed boxes hold copies of the sample tables.
+  std::vector<uint8_t>().swap(moov_buffer_);
+  if (!parsed) {
+    MEDIA_LOG(ERROR, media_log_) << GetDisplayName()
+                                 << ": failed to parse moov box";
+    OnInitializeDone(DEMUXER_ERROR_COULD_NOT_PARSE);
+    return;
+  }
+  if (moov_->fragmented) {
+    DVLOG(1) << "Fragmented MP4 files are left to other demuxers";
+    OnInitializeDone(DEMUXER_ERROR_COULD_NOT_PARSE);
+    return;
+  }
+
+  if (!CreateStreams()) {
+    OnInitializeDone(DEMUXER_ERROR_COULD_NOT_PARSE);
+    return;
+  }
+  if (streams_.empty()) {
+    MEDIA_LOG(ERROR, media_log_) << GetDisplayName()
+                                 << ": no supported streams";
+    OnInitializeDone(DEMUXER_ERROR_NO_SUPPORTED_STREAMS);
+    return;
+  }
+
+  base::TimeDelta duration = kInfiniteDuration;
+  const mp4::MovieHeader& header = moov_->header;
+  if (header.duration > 0 && header.timescale > 0 &&
+      header.duration != std::numeric_limits<uint32_t>::max() &&
+      header.duration != std::numeric_limits<uint64_t>::max()) {
+    duration = mp4::TimeDeltaFromRational(header.duration, header.timescale);
+  }
+  host_->SetDuration(duration);
+
+  int64_t file_size = 0;
+  if (duration != kInfiniteDuration && duration > base::TimeDelta() &&
+      data_source_->GetSize(&file_size)) {
+    data_source_->SetBitrate(
+        static_cast<int>(file_size * 8 / duration.InSecondsF()));
+  }
+
+  OnInitializeDone(PIPELINE_OK);
+}
+
+bool ProgressiveMP4Demuxer::CreateStreams() {
+  std::unique_ptr<MediaTracks> media_tracks(new MediaTracks());
+  for (const mp4::Track& track : moov_->tracks) {
+    if (track.media.handler.type != mp4::kAudio &&
+        track.media.handler.type != mp4::kVideo) {
+      continue;
+    }
+
+    const mp4::SampleDescription& description =
+        track.media.information.sample_table.description;
+    for (const mp4::AudioSampleEntry& entry : description.audio_entries) {
+      if (entry.sinf.info.track_encryption.is_encrypted) {
+        DVLOG(1) << "Encrypted tracks are left to other demuxers";
+        return false;
+      }
+    }
+    for (const mp4::VideoSampleEntry& entry : description.video_entries) {
+      if (entry.sinf.info.track_encryption.is_encrypted) {
+        DVLOG(1) << "Encrypted tracks are left to other demuxers";
+        return false;
+      }
+    }
+
+    const uint32_t track_id = track.header.track_id;
+    const mp4::AAC* aac = nullptr;
+    AudioDecoderConfig audio_config;
+    VideoDecoderConfig video_config;
+    scoped_refptr<mp4::BitstreamConverter> converter;
+    if (track.media.handler.type == mp4::kAudio) {
+      audio_config = CreateAudioConfig(track, &aac);
+      if (!audio_config.IsValidConfig()) {
+        MEDIA_LOG(DEBUG, media_log_) << GetDisplayName()
+                                     << ": skipping unsupported audio track "
+                                     << track_id;
+        continue;
+      }
+    } else {
+      video_config = CreateVideoConfig(track);
+      if (!video_config.IsValidConfig()) {
+        MEDIA_LOG(DEBUG, media_log_) << GetDisplayName()
+                                     << ": skipping unsupported video track "
+                                     << track_id;
+        continue;
+      }
+      converter =
+          track.media.information.sample_table.description.video_entries[0]
+              .frame_bitstream_converter;
+    }
+
+    std::unique_ptr<mp4::SampleTableIterator> iterator(
+        new mp4::SampleTableIterator(track));
+    if (!iterator->Init()) {
+      MEDIA_LOG(ERROR, media_log_) << GetDisplayName()
+                                   << ": malformed sample tables in track "
+                                   << track_id;
+      return false;
+    }
+
+    if (track_id_to_demux_stream_map_.count(base::UintToString(track_id))) {
+      MEDIA_LOG(ERROR, media_log_) << GetDisplayName()
+                                   << ": duplicate track id " << track_id;
+      return false;
+    }
+
+    streams_.emplace_back(new ProgressiveMP4DemuxerStream(
+        this, track, std::move(iterator), audio_config, video_config,
+        std::move(converter), aac));
+    MediaTrack* media_track;
+    if (audio_config.IsValidConfig()) {
+      media_track = media_tracks->AddAudioTrack(
+          audio_config, track_id, "main", track.media.handler.name,
+          track.media.header.language());
+    } else {
+      media_track = media_tracks->AddVideoTrack(
+          video_config, track_id, "main", track.media.handler.name,
+          track.media.header.language());
+    }
+    media_track->set_id(base::UintToString(track_id));
+    track_id_to_demux_stream_map_[media_track->id()] = streams_.back().get();
+  }
+
+  media_tracks_updated_cb_.Run(std::move(media_tracks));
+  return true;
+}
+
+void ProgressiveMP4Demuxer::OnInitializeDone(PipelineStatus status) {
+  base::ResetAndReturn(&init_cb_).Run(status);
+}
+
+void ProgressiveMP4Demuxer::ReadSampleIfNeeded() {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  if (pending_read_ || !pending_seek_cb_.is_null())
+    return;
+
+  // Skip streams whose reads were satisfied otherwise, e.g. by disabling
+  // them.
+  while (!pending_streams_.empty() &&
+         !pending_streams_.front()->HasPendingRead()) {
+    pending_streams_.pop_front();
+  }
+  if (pending_streams_.empty())
+    return;
+
+  ProgressiveMP4DemuxerStream* stream = pending_streams_.front();
+  const mp4::SampleTableIterator& iterator = stream->iterator();
+  if (!iterator.IsValid()) {
+    pending_streams_.pop_front();
+    stream->SatisfyPendingRead(DecoderBuffer::CreateEOSBuffer());
+    ReadSampleIfNeeded();
+    return;
+  }
+  if (iterator.sample_size() > kMaxSampleSize) {
+    MEDIA_LOG(ERROR, media_log_) << GetDisplayName() << ": sample of "
+                                 << iterator.sample_size() << " bytes";
+    OnDemuxerError(DEMUXER_ERROR_COULD_NOT_PARSE);
+    return;
+  }
+
+  // Samples which need no conversion are read straight into the buffer they
+  // are emitted in.
+  uint8_t* data;
+  pending_read_size_ = iterator.sample_size();
+  if (stream->converts_samples()) {
+    sample_data_.resize(pending_read_size_);
+    data = sample_data_.data();
+  } else {
+    pending_buffer_ = stream->CreateSampleBuffer();
+    data = pending_buffer_->writable_data();
+  }
+
+  pending_read_ = true;
+  data_source_->Read(
+      iterator.sample_offset(), pending_read_size_, data,
+      BindToCurrentLoop(base::Bind(&ProgressiveMP4Demuxer::OnSampleRead,
+                                   weak_factory_.GetWeakPtr())));
+}
+
+void ProgressiveMP4Demuxer::OnSampleRead(int bytes_read) {
+  DCHECK(task_runner_->BelongsToCurrentThread());
+  DCHECK(pending_read_);
+  pending_read_ = false;
+  scoped_refptr<DecoderBuffer> buffer = std::move(pending_buffer_);
+
+  if (bytes_read == DataSource::kReadError) {
+    MEDIA_LOG(ERROR, media_log_) << GetDisplayName() << ": data source error";
+    OnDemuxerError(PIPELINE_ERROR_READ);
+    return;
+  }
+
+  // A seek issued while the read was in flight discards its result.
+  if (!pending_seek_cb_.is_null()) {
+    CompleteSeek();
+    return;
+  }
+
+  DCHECK(!pending_streams_.empty());
+  ProgressiveMP4DemuxerStream* stream = pending_streams_.front();
+  pending_streams_.pop_front();
+  if (!stream->HasPendingRead()) {
+    ReadSampleIfNeeded();
+    return;
+  }
+
+  if (bytes_read != static_cast<int>(pending_read_size_)) {
+    // The file is truncated.
+    DVLOG(1) << "Short sample read in track " << stream->track_id();
+    stream->SatisfyPendingRead(DecoderBuffer::CreateEOSBuffer());
+    ReadSampleIfNeeded();
+    return;
+  }
+
+  if (stream->converts_samples()) {
+    buffer = stream->ConvertSample(sample_data_.data(), pending_read_size_);
+    if (!buffer) {
+      MEDIA_LOG(ERROR, media_log_) << GetDisplayName()
+                                   << ": failed to convert sample in track "
+                                   << stream->track_id();
+      OnDemuxerError(DEMUXER_ERROR_COULD_NOT_PARSE);
+      return;
+    }
+  }
+  stream->SatisfyPendingRead(buffer);
+  ReadSampleIfNeeded();
+}
+
+void ProgressiveMP4Demuxer::CompleteSeek() {
+  DCHECK(!pending_read_);
+  pending_streams_.clear();
+  for (const auto& stream : streams_) {
+    stream->Seek(pending_seek_time_);
+    // Reads issued during the seek are served from the new position.
+    if (stream->HasPendingRead())
+      pending_streams_.push_back(stream.get());
+  }
+  base::ResetAndReturn(&pending_seek_cb_).Run(PIPELINE_OK);
+  ReadSampleIfNeeded();
+}
+
+void ProgressiveMP4Demuxer::OnDemuxerError(PipelineStatus status) {
+  host_->OnDemuxerError(status);
+}
+
+}  // namespace media
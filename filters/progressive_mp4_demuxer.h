@@ -0,0 +1,239 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+// Implements the Demuxer interface for progressive (non-fragmented) MP4 files,
+// i.e. files whose samples are all described by the sample tables in their
+// 'moov' box. Unlike FFmpegDemuxer, no per-sample index is built: the sample
+// tables are kept in their compact on-disk form and are decoded lazily while
+// reading and seeking, and samples are read asynchronously straight from the
+// DataSource, one read in flight at a time, without a blocking thread.
+// The compact tables still take memory linear in the number of samples, e.g.
+// four bytes per sample for 'stsz', bounded by the size of the 'moov' box.
+//
+// H.264 and HEVC samples are converted to Annex B, and AAC samples get an
+// ADTS header, the same as for MP4 Media Source playback. Initialization fails
+// with DEMUXER_ERROR_COULD_NOT_PARSE for fragmented, encrypted or otherwise
+// unsupported files, so that callers can fall back to FFmpegDemuxer.
+
+#ifndef MEDIA_FILTERS_PROGRESSIVE_MP4_DEMUXER_H_
+#define MEDIA_FILTERS_PROGRESSIVE_MP4_DEMUXER_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <deque>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/memory/weak_ptr.h"
+#include "media/base/audio_decoder_config.h"
+#include "media/base/demuxer.h"
+#include "media/base/pipeline_status.h"
+#include "media/base/video_decoder_config.h"
+
+namespace base {
+class SingleThreadTaskRunner;
+}
+
+namespace media {
+
+class DataSource;
+class DecoderBuffer;
+class MediaLog;
+class ProgressiveMP4Demuxer;
+
+namespace mp4 {
+class AAC;
+class BitstreamConverter;
+class SampleTableIterator;
+struct Movie;
+struct Track;
+}
+
+class MEDIA_EXPORT ProgressiveMP4DemuxerStream : public DemuxerStream {
+ public:
+  // |track| must outlive the stream. |iterator| must have been initialized.
+  // |converter| and |aac| are null unless samples are converted to Annex B or
+  // get an ADTS header, respectively.
+  ProgressiveMP4DemuxerStream(
+      ProgressiveMP4Demuxer* demuxer,
+      const mp4::Track& track,
+      std::unique_ptr<mp4::SampleTableIterator> iterator,
+      const AudioDecoderConfig& audio_config,
+      const VideoDecoderConfig& video_config,
+      scoped_refptr<mp4::BitstreamConverter> converter,
+      const mp4::AAC* aac);
+  ~ProgressiveMP4DemuxerStream() override;
+
+  // DemuxerStream implementation.
+  Type type() const override;
+  void Read(const ReadCB& read_cb) override;
+  AudioDecoderConfig audio_decoder_config() override;
+  VideoDecoderConfig video_decoder_config() override;
+  bool SupportsConfigChanges() override;
+  VideoRotation video_rotation() override;
+  bool enabled() const override;
+  void set_enabled(bool enabled, base::TimeDelta timestamp) override;
+  void SetStreamStatusChangeCB(const StreamStatusChangeCB& cb) override;
+
+  // Returns whether a Read() is waiting for a sample.
+  bool HasPendingRead() const;
+
+  // Satisfies the pending Read() with |buffer|, or with an end of stream
+  // buffer once the track has no more samples, and advances to the next
+  // sample.
+  void SatisfyPendingRead(const scoped_refptr<DecoderBuffer>& buffer);
+
+  // Converts |sample| of |sample_size| bytes, the current sample, into the
+  // buffer to satisfy the pending read with. Returns null on failure.
+  scoped_refptr<DecoderBuffer> ConvertSample(const uint8_t* sample,
+                                             size_t sample_size);
+
+  // Returns a buffer for the current sample which samples that need no
+  // conversion are read into.
+  scoped_refptr<DecoderBuffer> CreateSampleBuffer();
+
+  // Repositions the stream at the last keyframe at or before |time|. Reads
+  // pending meanwhile are satisfied from the new position.
+  void Seek(base::TimeDelta time);
+
+  // Aborts the pending Read(), if any.
+  void Abort();
+
+  // Satisfies the pending Read(), if any, with end of stream, and stops
+  // issuing buffers.
+  void Stop();
+
+  const mp4::SampleTableIterator& iterator() const { return *iterator_; }
+  bool converts_samples() const { return converter_ || aac_; }
+  uint32_t track_id() const;
+
+ private:
+  // Sets the timestamps and flags of the current sample on |buffer|.
+  void SetSampleProperties(DecoderBuffer* buffer) const;
+
+  ProgressiveMP4Demuxer* demuxer_;
+  const mp4::Track& track_;
+  std::unique_ptr<mp4::SampleTableIterator> iterator_;
+  const Type type_;
+  const AudioDecoderConfig audio_config_;
+  const VideoDecoderConfig video_config_;
+  const VideoRotation video_rotation_;
+  const scoped_refptr<mp4::BitstreamConverter> converter_;
+  const mp4::AAC* const aac_;
+
+  bool is_enabled_;
+  bool stopped_;
+  ReadCB read_cb_;
+  StreamStatusChangeCB stream_status_change_cb_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProgressiveMP4DemuxerStream);
+};
+
+class MEDIA_EXPORT ProgressiveMP4Demuxer : public Demuxer {
+ public:
+  ProgressiveMP4Demuxer(
+      const scoped_refptr<base::SingleThreadTaskRunner>& task_runner,
+      DataSource* data_source,
+      const MediaTracksUpdatedCB& media_tracks_updated_cb,
+      const scoped_refptr<MediaLog>& media_log);
+  ~ProgressiveMP4Demuxer() override;
+
+  // Demuxer implementation.
+  std::string GetDisplayName() const override;
+  void Initialize(DemuxerHost* host,
+                  const PipelineStatusCB& status_cb,
+                  bool enable_text_tracks) override;
+  void AbortPendingReads() override;
+  void Stop() override;
+  void StartWaitingForSeek(base::TimeDelta seek_time) override;
+  void CancelPendingSeek(base::TimeDelta seek_time) override;
+  void Seek(base::TimeDelta time, const PipelineStatusCB& cb) override;
+  base::Time GetTimelineOffset() const override;
+  DemuxerStream* GetStream(DemuxerStream::Type type) override;
+  base::TimeDelta GetStartTime() const override;
+  int64_t GetMemoryUsage() const override;
+  void OnEnabledAudioTracksChanged(const std::vector<MediaTrack::Id>& track_ids,
+                                   base::TimeDelta currTime) override;
+  void OnSelectedVideoTrackChanged(const std::vector<MediaTrack::Id>& track_ids,
+                                   base::TimeDelta currTime) override;
+
+  // Called by |stream| when a Read() needs the stream's current sample.
+  void RequestSample(ProgressiveMP4DemuxerStream* stream);
+
+ private:
+  // Reads the header of the top-level box at |box_offset_|.
+  void ReadBoxHeader();
+  void OnBoxHeaderRead(int bytes_read);
+  void OnMoovRead(int bytes_read);
+
+  // Creates the streams of the supported tracks of |moov_|. Returns false if
+  // the file can't be played.
+  bool CreateStreams();
+
+  // Completes initialization with |status|.
+  void OnInitializeDone(PipelineStatus status);
+
+  // Starts reading the current sample of the first stream waiting for one,
+  // unless a read is in flight or a seek is pending.
+  void ReadSampleIfNeeded();
+  void OnSampleRead(int bytes_read);
+
+  // Repositions the streams and completes the pending Seek().
+  void CompleteSeek();
+
+  void OnDemuxerError(PipelineStatus status);
+
+  DemuxerHost* host_;
+
+  scoped_refptr<base::SingleThreadTaskRunner> task_runner_;
+  DataSource* data_source_;
+  scoped_refptr<MediaLog> media_log_;
+  MediaTracksUpdatedCB media_tracks_updated_cb_;
+
+  PipelineStatusCB init_cb_;
+  PipelineStatusCB pending_seek_cb_;
+  base::TimeDelta pending_seek_time_;
+
+  // Initialization state: the offset of the next top-level box, the buffer
+  // its header is read into and, once found, the buffer the movie box is read
+  // into.
+  int64_t box_offset_;
+  uint8_t box_header_[16];
+  std::vector<uint8_t> moov_buffer_;
+
+  // The parsed movie box, which the streams' sample tables live in.
+  std::unique_ptr<mp4::Movie> moov_;
+
+  std::vector<std::unique_ptr<ProgressiveMP4DemuxerStream>> streams_;
+  std::map<MediaTrack::Id, ProgressiveMP4DemuxerStream*>
+      track_id_to_demux_stream_map_;
+
+  // Streams waiting for a sample, in the order their reads arrived.
+  std::deque<ProgressiveMP4DemuxerStream*> pending_streams_;
+
+  // Whether a sample read is in flight, and where it's read into: the
+  // buffer emitted for samples that need no conversion, else |sample_data_|.
+  bool pending_read_;
+  size_t pending_read_size_;
+  scoped_refptr<DecoderBuffer> pending_buffer_;
+  std::vector<uint8_t> sample_data_;
+
+  // Used to post AbortPendingReads() from CancelPendingSeek(), which may be
+  // called on another thread.
+  base::WeakPtr<ProgressiveMP4Demuxer> weak_this_;
+  base::WeakPtrFactory<ProgressiveMP4Demuxer> cancel_pending_seek_factory_;
+  base::WeakPtrFactory<ProgressiveMP4Demuxer> weak_factory_;
+
+  DISALLOW_COPY_AND_ASSIGN(ProgressiveMP4Demuxer);
+};
+
+}  // namespace media
+
+#endif  // MEDIA_FILTERS_PROGRESSIVE_MP4_DEMUXER_H_
@@ -0,0 +1,271 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/filters/progressive_mp4_demuxer.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "base/bind.h"
+#include "base/macros.h"
+#include "base/message_loop/message_loop.h"
+#include "base/run_loop.h"
+#include "media/base/decoder_buffer.h"
+#include "media/base/media_log.h"
+#include "media/base/media_tracks.h"
+#include "media/base/mock_demuxer_host.h"
+#include "media/base/test_data_util.h"
+#include "media/base/test_helpers.h"
+#include "media/filters/file_data_source.h"
+#include "testing/gmock/include/gmock/gmock.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+using ::testing::AnyNumber;
+using ::testing::_;
+
+namespace media {
+
+namespace {
+
+// The first samples of bear-1280x720.mp4: an AAC frame of 263 bytes whose
+// composition time is 1024 / 44100 s, and a keyframe at 1001 / 30000 s.
+const int kFirstAudioSampleSize = 263;
+const int64_t kFirstAudioTimestampUs = 23219;
+const int64_t kFirstVideoTimestampUs = 33366;
+const int kAudioSampleCount = 119;
+const int kVideoSampleCount = 82;
+
+}  // namespace
+
+class ProgressiveMP4DemuxerTest : public testing::Test {
+ protected:
+  ProgressiveMP4DemuxerTest() {}
+
+  ~ProgressiveMP4DemuxerTest() override {
+    if (demuxer_)
+      demuxer_->Stop();
+  }
+
+  void CreateDemuxer(const std::string& name) {
+    EXPECT_CALL(host_, OnBufferedTimeRangesChanged(_)).Times(AnyNumber());
+
+    data_source_.reset(new FileDataSource());
+    ASSERT_TRUE(data_source_->Initialize(GetTestDataFilePath(name)));
+
+    demuxer_.reset(new ProgressiveMP4Demuxer(
+        message_loop_.task_runner(), data_source_.get(),
+        base::Bind(&ProgressiveMP4DemuxerTest::OnMediaTracksUpdated,
+                   base::Unretained(this)),
+        new MediaLog()));
+  }
+
+  void InitializeDemuxer(PipelineStatus expected_status) {
+    if (expected_status == PIPELINE_OK)
+      EXPECT_CALL(host_, SetDuration(_));
+    WaitableMessageLoopEvent event;
+    demuxer_->Initialize(&host_, event.GetPipelineStatusCB(), false);
+    event.RunAndWaitForStatus(expected_status);
+  }
+
+  void Seek(base::TimeDelta time) {
+    WaitableMessageLoopEvent event;
+    demuxer_->Seek(time, event.GetPipelineStatusCB());
+    event.RunAndWaitForStatus(PIPELINE_OK);
+  }
+
+  // Reads a buffer from |stream|, which is expected to succeed.
+  scoped_refptr<DecoderBuffer> ReadBuffer(DemuxerStream* stream) {
+    scoped_refptr<DecoderBuffer> buffer;
+    base::RunLoop run_loop;
+    stream->Read(base::Bind(&ProgressiveMP4DemuxerTest::OnReadDone,
+                            run_loop.QuitClosure(), &buffer));
+    run_loop.Run();
+    return buffer;
+  }
+
+  // Reads |stream| to its end, and returns the number of buffers read.
+  int ReadUntilEndOfStream(DemuxerStream* stream) {
+    int buffers = 0;
+    for (scoped_refptr<DecoderBuffer> buffer = ReadBuffer(stream);
+         buffer && !buffer->end_of_stream(); buffer = ReadBuffer(stream)) {
+      ++buffers;
+    }
+    return buffers;
+  }
+
+  void OnMediaTracksUpdated(std::unique_ptr<MediaTracks> tracks) {
+    media_tracks_ = std::move(tracks);
+  }
+
+  static void OnReadDone(const base::Closure& quit_closure,
+                         scoped_refptr<DecoderBuffer>* buffer_out,
+                         DemuxerStream::Status status,
+                         const scoped_refptr<DecoderBuffer>& buffer) {
+    EXPECT_EQ(DemuxerStream::kOk, status);
+    *buffer_out = buffer;
+    quit_closure.Run();
+  }
+
+  base::MessageLoop message_loop_;
+  MockDemuxerHost host_;
+  std::unique_ptr<FileDataSource> data_source_;
+  std::unique_ptr<ProgressiveMP4Demuxer> demuxer_;
+  std::unique_ptr<MediaTracks> media_tracks_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(ProgressiveMP4DemuxerTest);
+};
+
+TEST_F(ProgressiveMP4DemuxerTest, Initialize) {
+  CreateDemuxer("bear-1280x720.mp4");
+  InitializeDemuxer(PIPELINE_OK);
+
+  DemuxerStream* audio = demuxer_->GetStream(DemuxerStream::AUDIO);
+  ASSERT_TRUE(audio);
+  EXPECT_EQ(kCodecAAC, audio->audio_decoder_config().codec());
+  EXPECT_EQ(44100, audio->audio_decoder_config().samples_per_second());
+
+  DemuxerStream* video = demuxer_->GetStream(DemuxerStream::VIDEO);
+  ASSERT_TRUE(video);
+  EXPECT_EQ(kCodecH264, video->video_decoder_config().codec());
+  EXPECT_EQ(gfx::Size(1280, 720), video->video_decoder_config().coded_size());
+
+  ASSERT_TRUE(media_tracks_);
+  EXPECT_EQ(2u, media_tracks_->tracks().size());
+  EXPECT_GT(demuxer_->GetMemoryUsage(), 0);
+}
+
+TEST_F(ProgressiveMP4DemuxerTest, RejectsFragmentedFiles) {
+  CreateDemuxer("bear-1280x720-av_frag.mp4");
+  InitializeDemuxer(DEMUXER_ERROR_COULD_NOT_PARSE);
+}
+
+TEST_F(ProgressiveMP4DemuxerTest, RejectsOtherFormats) {
+  CreateDemuxer("bear-640x360.webm");
+  InitializeDemuxer(DEMUXER_ERROR_COULD_NOT_PARSE);
+}
+
+TEST_F(ProgressiveMP4DemuxerTest, ReadsConvertedSamples) {
+  CreateDemuxer("bear-1280x720.mp4");
+  InitializeDemuxer(PIPELINE_OK);
+
+  // AAC samples are prefixed with an ADTS header.
+  scoped_refptr<DecoderBuffer> audio_buffer =
+      ReadBuffer(demuxer_->GetStream(DemuxerStream::AUDIO));
+  ASSERT_TRUE(audio_buffer);
+  ASSERT_FALSE(audio_buffer->end_of_stream());
+  EXPECT_EQ(static_cast<size_t>(kFirstAudioSampleSize + 7),
+            audio_buffer->data_size());
+  EXPECT_EQ(0xFF, audio_buffer->data()[0]);
+  EXPECT_EQ(0xF0, audio_buffer->data()[1] & 0xF6);
+  EXPECT_EQ(kFirstAudioTimestampUs,
+            audio_buffer->timestamp().InMicroseconds());
+  EXPECT_TRUE(audio_buffer->is_key_frame());
+
+  // H.264 samples are converted to Annex B.
+  scoped_refptr<DecoderBuffer> video_buffer =
+      ReadBuffer(demuxer_->GetStream(DemuxerStream::VIDEO));
+  ASSERT_TRUE(video_buffer);
+  ASSERT_FALSE(video_buffer->end_of_stream());
+  ASSERT_GT(video_buffer->data_size(), 4u);
+  const uint8_t kStartCode[] = {0, 0, 0, 1};
+  EXPECT_EQ(0, memcmp(kStartCode, video_buffer->data(), sizeof(kStartCode)));
+  EXPECT_EQ(kFirstVideoTimestampUs,
+            video_buffer->timestamp().InMicroseconds());
+  EXPECT_TRUE(video_buffer->is_key_frame());
+}
+
+TEST_F(ProgressiveMP4DemuxerTest, ReadsUntilEndOfStream) {
+  CreateDemuxer("bear-1280x720.mp4");
+  InitializeDemuxer(PIPELINE_OK);
+
+  EXPECT_EQ(kAudioSampleCount,
+            ReadUntilEndOfStream(demuxer_->GetStream(DemuxerStream::AUDIO)));
+  EXPECT_EQ(kVideoSampleCount,
+            ReadUntilEndOfStream(demuxer_->GetStream(DemuxerStream::VIDEO)));
+
+  // Reads past the end keep returning end of stream.
+  scoped_refptr<DecoderBuffer> buffer =
+      ReadBuffer(demuxer_->GetStream(DemuxerStream::VIDEO));
+  ASSERT_TRUE(buffer);
+  EXPECT_TRUE(buffer->end_of_stream());
+}
+
+TEST_F(ProgressiveMP4DemuxerTest, Seek) {
+  CreateDemuxer("bear-1280x720.mp4");
+  InitializeDemuxer(PIPELINE_OK);
+  DemuxerStream* audio = demuxer_->GetStream(DemuxerStream::AUDIO);
+  DemuxerStream* video = demuxer_->GetStream(DemuxerStream::VIDEO);
+  ReadBuffer(audio);
+  ReadBuffer(video);
+
+  // Every audio sample is a sync sample; the first video sample is the only
+  // keyframe, so video restarts from the beginning.
+  Seek(base::TimeDelta::FromSeconds(1));
+  scoped_refptr<DecoderBuffer> audio_buffer = ReadBuffer(audio);
+  ASSERT_TRUE(audio_buffer);
+  EXPECT_EQ(44032 * base::Time::kMicrosecondsPerSecond / 44100,
+            audio_buffer->timestamp().InMicroseconds());
+  scoped_refptr<DecoderBuffer> video_buffer = ReadBuffer(video);
+  ASSERT_TRUE(video_buffer);
+  EXPECT_EQ(kFirstVideoTimestampUs,
+            video_buffer->timestamp().InMicroseconds());
+  EXPECT_TRUE(video_buffer->is_key_frame());
+}
+
+TEST_F(ProgressiveMP4DemuxerTest, Rotation) {
+  const struct {
+    const char* name;
+    VideoRotation rotation;
+  } kRotatedFiles[] = {
+      {"bear_rotate_0.mp4", VIDEO_ROTATION_0},
+      {"bear_rotate_90.mp4", VIDEO_ROTATION_90},
+      {"bear_rotate_180.mp4", VIDEO_ROTATION_180},
+      {"bear_rotate_270.mp4", VIDEO_ROTATION_270},
+  };
+  for (const auto& file : kRotatedFiles) {
+    SCOPED_TRACE(file.name);
+    CreateDemuxer(file.name);
+    InitializeDemuxer(PIPELINE_OK);
+    DemuxerStream* video = demuxer_->GetStream(DemuxerStream::VIDEO);
+    ASSERT_TRUE(video);
+    EXPECT_EQ(file.rotation, video->video_rotation());
+    demuxer_->Stop();
+    demuxer_.reset();
+  }
+}
+
+TEST_F(ProgressiveMP4DemuxerTest, AbortPendingReads) {
+  CreateDemuxer("bear-1280x720.mp4");
+  InitializeDemuxer(PIPELINE_OK);
+
+  DemuxerStream::Status status = DemuxerStream::kOk;
+  bool read_done = false;
+  demuxer_->GetStream(DemuxerStream::VIDEO)
+      ->Read(base::Bind(
+          [](DemuxerStream::Status* status_out, bool* read_done,
+             DemuxerStream::Status status,
+             const scoped_refptr<DecoderBuffer>& buffer) {
+            *status_out = status;
+            *read_done = true;
+          },
+          &status, &read_done));
+  demuxer_->AbortPendingReads();
+  base::RunLoop().RunUntilIdle();
+  EXPECT_TRUE(read_done);
+  EXPECT_EQ(DemuxerStream::kAborted, status);
+
+  // Reads resume after a seek.
+  Seek(base::TimeDelta());
+  scoped_refptr<DecoderBuffer> buffer =
+      ReadBuffer(demuxer_->GetStream(DemuxerStream::VIDEO));
+  ASSERT_TRUE(buffer);
+  EXPECT_EQ(kFirstVideoTimestampUs, buffer->timestamp().InMicroseconds());
+}
+
+}  // namespace media
@@ -22,6 +22,23 @@ static bool CompareStreamParserBufferToTimeDelta(
   return buffer->GetDecodeTimestamp() < decode_timestamp;
 }
 
+template <typename Entry>
+static bool CompareTimeDeltaToKeyframeEntry(
+    const DecodeTimestamp& decode_timestamp,
+    const Entry& entry) {
+  return decode_timestamp < entry.timestamp;
+}
+template <typename Entry>
+static bool CompareKeyframeEntryToTimeDelta(
+    const Entry& entry,
+    const DecodeTimestamp& decode_timestamp) {
+  return entry.timestamp < decode_timestamp;
+}
+
+SourceBufferRange::KeyframeEntry::KeyframeEntry(DecodeTimestamp timestamp,
+                                                int index)
+    : timestamp(timestamp), index(index), size_in_bytes(0) {}
+
 bool SourceBufferRange::IsUncommonSameTimestampSequence(
     bool prev_is_keyframe,
     bool current_is_keyframe) {
@@ -34,7 +51,7 @@ SourceBufferRange::SourceBufferRange(
     DecodeTimestamp range_start_time,
     const InterbufferDistanceCB& interbuffer_distance_cb)
     : gap_policy_(gap_policy),
-      keyframe_map_index_base_(0),
+      keyframe_index_base_(0),
       next_buffer_index_(-1),
       range_start_time_(range_start_time),
       interbuffer_distance_cb_(interbuffer_distance_cb),
@@ -45,6 +62,19 @@ SourceBufferRange::SourceBufferRange(
   AppendBuffersToEnd(new_buffers, range_start_time_);
 }
 
+SourceBufferRange::SourceBufferRange(
+    GapPolicy gap_policy,
+    DecodeTimestamp range_start_time,
+    const InterbufferDistanceCB& interbuffer_distance_cb)
+    : gap_policy_(gap_policy),
+      keyframe_index_base_(0),
+      next_buffer_index_(-1),
+      range_start_time_(range_start_time),
+      interbuffer_distance_cb_(interbuffer_distance_cb),
+      size_in_bytes_(0) {
+  DCHECK(!interbuffer_distance_cb.is_null());
+}
+
 SourceBufferRange::~SourceBufferRange() {}
 
 void SourceBufferRange::AppendBuffersToEnd(
@@ -60,15 +90,24 @@ void SourceBufferRange::AppendBuffersToEnd(
   for (BufferQueue::const_iterator itr = new_buffers.begin();
        itr != new_buffers.end();
        ++itr) {
-    DCHECK((*itr)->GetDecodeTimestamp() != kNoDecodeTimestamp());
+    const DecodeTimestamp decode_timestamp = (*itr)->GetDecodeTimestamp();
+    DCHECK(decode_timestamp != kNoDecodeTimestamp());
     buffers_.push_back(*itr);
     size_in_bytes_ += (*itr)->data_size();
 
-    if ((*itr)->is_key_frame()) {
-      keyframe_map_.insert(
-          std::make_pair((*itr)->GetDecodeTimestamp(),
-                         buffers_.size() - 1 + keyframe_map_index_base_));
+    // Only the first keyframe with a given timestamp starts a GOP; a later
+    // keyframe with the same timestamp joins the existing GOP.
+    if ((*itr)->is_key_frame() &&
+        (keyframe_index_.empty() ||
+         keyframe_index_.back().timestamp != decode_timestamp)) {
+      DCHECK(keyframe_index_.empty() ||
+             keyframe_index_.back().timestamp < decode_timestamp);
+      keyframe_index_.push_back(KeyframeEntry(
+          decode_timestamp, buffers_.size() - 1 + keyframe_index_base_));
     }
+
+    DCHECK(!keyframe_index_.empty());
+    keyframe_index_.back().size_in_bytes += (*itr)->data_size();
   }
 }
 
@@ -98,21 +137,21 @@ void SourceBufferRange::AdjustEstimatedDurationForNewAppend(
 
 void SourceBufferRange::Seek(DecodeTimestamp timestamp) {
   DCHECK(CanSeekTo(timestamp));
-  DCHECK(!keyframe_map_.empty());
+  DCHECK(!keyframe_index_.empty());
 
-  KeyframeMap::iterator result = GetFirstKeyframeAtOrBefore(timestamp);
-  next_buffer_index_ = result->second - keyframe_map_index_base_;
+  KeyframeIndex::iterator result = GetFirstKeyframeAtOrBefore(timestamp);
+  next_buffer_index_ = GetBufferIndex(*result);
   CHECK_LT(next_buffer_index_, static_cast<int>(buffers_.size()))
       << next_buffer_index_ << ", size = " << buffers_.size();
 }
 
 int SourceBufferRange::GetConfigIdAtTime(DecodeTimestamp timestamp) {
   DCHECK(CanSeekTo(timestamp));
-  DCHECK(!keyframe_map_.empty());
+  DCHECK(!keyframe_index_.empty());
 
-  KeyframeMap::iterator result = GetFirstKeyframeAtOrBefore(timestamp);
-  CHECK(result != keyframe_map_.end());
-  size_t buffer_index = result->second - keyframe_map_index_base_;
+  KeyframeIndex::iterator result = GetFirstKeyframeAtOrBefore(timestamp);
+  CHECK(result != keyframe_index_.end());
+  size_t buffer_index = GetBufferIndex(*result);
   CHECK_LT(buffer_index, buffers_.size()) << buffer_index
                                           << ", size = " << buffers_.size();
 
@@ -124,14 +163,14 @@ bool SourceBufferRange::SameConfigThruRange(DecodeTimestamp start,
   DCHECK(CanSeekTo(start));
   DCHECK(CanSeekTo(end));
   DCHECK(start <= end);
-  DCHECK(!keyframe_map_.empty());
+  DCHECK(!keyframe_index_.empty());
 
   if (start == end)
     return true;
 
-  KeyframeMap::const_iterator result = GetFirstKeyframeAtOrBefore(start);
-  CHECK(result != keyframe_map_.end());
-  size_t buffer_index = result->second - keyframe_map_index_base_;
+  KeyframeIndex::const_iterator result = GetFirstKeyframeAtOrBefore(start);
+  CHECK(result != keyframe_index_.end());
+  size_t buffer_index = GetBufferIndex(*result);
   CHECK_LT(buffer_index, buffers_.size()) << buffer_index
                                           << ", size = " << buffers_.size();
 
@@ -157,18 +196,18 @@ void SourceBufferRange::SeekAheadPast(DecodeTimestamp timestamp) {
 
 void SourceBufferRange::SeekAhead(DecodeTimestamp timestamp,
                                   bool skip_given_timestamp) {
-  DCHECK(!keyframe_map_.empty());
+  DCHECK(!keyframe_index_.empty());
 
-  KeyframeMap::iterator result =
+  KeyframeIndex::iterator result =
       GetFirstKeyframeAt(timestamp, skip_given_timestamp);
 
   // If there isn't a keyframe after |timestamp|, then seek to end and return
   // kNoTimestamp to signal such.
-  if (result == keyframe_map_.end()) {
+  if (result == keyframe_index_.end()) {
     next_buffer_index_ = -1;
     return;
   }
-  next_buffer_index_ = result->second - keyframe_map_index_base_;
+  next_buffer_index_ = GetBufferIndex(*result);
   DCHECK_LT(next_buffer_index_, static_cast<int>(buffers_.size()));
 }
 
@@ -181,38 +220,45 @@ SourceBufferRange* SourceBufferRange::SplitRange(DecodeTimestamp timestamp) {
   CHECK(!buffers_.empty());
 
   // Find the first keyframe at or after |timestamp|.
-  KeyframeMap::iterator new_beginning_keyframe =
+  KeyframeIndex::iterator new_beginning_keyframe =
       GetFirstKeyframeAt(timestamp, false);
 
   // If there is no keyframe after |timestamp|, we can't split the range.
-  if (new_beginning_keyframe == keyframe_map_.end())
+  if (new_beginning_keyframe == keyframe_index_.end())
     return NULL;
 
-  // Remove the data beginning at |keyframe_index| from |buffers_| and save it
-  // into |removed_buffers|.
-  int keyframe_index =
-      new_beginning_keyframe->second - keyframe_map_index_base_;
+  int keyframe_index = GetBufferIndex(*new_beginning_keyframe);
   DCHECK_LT(keyframe_index, static_cast<int>(buffers_.size()));
   BufferQueue::iterator starting_point = buffers_.begin() + keyframe_index;
-  BufferQueue removed_buffers(starting_point, buffers_.end());
 
   DecodeTimestamp new_range_start_timestamp = kNoDecodeTimestamp();
   if (GetStartTimestamp() < buffers_.front()->GetDecodeTimestamp() &&
-      timestamp < removed_buffers.front()->GetDecodeTimestamp()) {
+      timestamp < (*starting_point)->GetDecodeTimestamp()) {
     // The split is in the gap between |range_start_time_| and the first buffer
     // of the new range so we should set the start time of the new range to
     // |timestamp| so we preserve part of the gap in the new range.
     new_range_start_timestamp = timestamp;
   }
 
-  keyframe_map_.erase(new_beginning_keyframe, keyframe_map_.end());
-  FreeBufferRange(starting_point, buffers_.end());
-
-  // Create a new range with |removed_buffers|.
-  SourceBufferRange* split_range =
-      new SourceBufferRange(
-          gap_policy_, removed_buffers, new_range_start_timestamp,
-          interbuffer_distance_cb_);
+  // Move the data beginning at |keyframe_index| from |buffers_| and the GOPs
+  // that describe it into a new range. GOP sizes are carried over, so no
+  // per-buffer work beyond the move itself is needed.
+  SourceBufferRange* split_range = new SourceBufferRange(
+      gap_policy_, new_range_start_timestamp, interbuffer_distance_cb_);
+  split_range->buffers_.insert(split_range->buffers_.end(),
+                               std::make_move_iterator(starting_point),
+                               std::make_move_iterator(buffers_.end()));
+  for (KeyframeIndex::iterator itr = new_beginning_keyframe;
+       itr != keyframe_index_.end(); ++itr) {
+    KeyframeEntry entry = *itr;
+    entry.index = GetBufferIndex(*itr) - keyframe_index;
+    split_range->keyframe_index_.push_back(entry);
+    split_range->size_in_bytes_ += entry.size_in_bytes;
+  }
+  DCHECK_GE(size_in_bytes_, split_range->size_in_bytes_);
+  size_in_bytes_ -= split_range->size_in_bytes_;
+  keyframe_index_.erase(new_beginning_keyframe, keyframe_index_.end());
+  buffers_.erase(starting_point, buffers_.end());
 
   // If the next buffer position is now in |split_range|, update the state of
   // this range and |split_range| accordingly.
@@ -246,22 +292,26 @@ SourceBufferRange::BufferQueue::iterator SourceBufferRange::GetBufferItrAt(
                                 CompareStreamParserBufferToTimeDelta);
 }
 
-SourceBufferRange::KeyframeMap::iterator
+SourceBufferRange::KeyframeIndex::iterator
 SourceBufferRange::GetFirstKeyframeAt(DecodeTimestamp timestamp,
                                       bool skip_given_timestamp) {
-  return skip_given_timestamp ?
-      keyframe_map_.upper_bound(timestamp) :
-      keyframe_map_.lower_bound(timestamp);
+  return skip_given_timestamp
+             ? std::upper_bound(keyframe_index_.begin(), keyframe_index_.end(),
+                                timestamp,
+                                CompareTimeDeltaToKeyframeEntry<KeyframeEntry>)
+             : std::lower_bound(keyframe_index_.begin(), keyframe_index_.end(),
+                                timestamp,
+                                CompareKeyframeEntryToTimeDelta<KeyframeEntry>);
 }
 
-SourceBufferRange::KeyframeMap::iterator
+SourceBufferRange::KeyframeIndex::iterator
 SourceBufferRange::GetFirstKeyframeAtOrBefore(DecodeTimestamp timestamp) {
-  KeyframeMap::iterator result = keyframe_map_.lower_bound(timestamp);
+  KeyframeIndex::iterator result = GetFirstKeyframeAt(timestamp, false);
   // lower_bound() returns the first element >= |timestamp|, so we want the
   // previous element if it did not return the element exactly equal to
   // |timestamp|.
-  if (result != keyframe_map_.begin() &&
-      (result == keyframe_map_.end() || result->first != timestamp)) {
+  if (result != keyframe_index_.begin() &&
+      (result == keyframe_index_.end() || result->timestamp != timestamp)) {
     --result;
   }
   return result;
@@ -284,36 +334,30 @@ size_t SourceBufferRange::DeleteGOPFromFront(BufferQueue* deleted_buffers) {
   DCHECK(!buffers_.empty());
   DCHECK(!FirstGOPContainsNextBufferPosition());
   DCHECK(deleted_buffers);
+  DCHECK(!keyframe_index_.empty());
 
-  int buffers_deleted = 0;
-  size_t total_bytes_deleted = 0;
-
-  KeyframeMap::iterator front = keyframe_map_.begin();
-  DCHECK(front != keyframe_map_.end());
-
-  // Delete the keyframe at the start of |keyframe_map_|.
-  keyframe_map_.erase(front);
+  // Delete the keyframe at the start of |keyframe_index_|.
+  const size_t total_bytes_deleted = keyframe_index_.front().size_in_bytes;
+  keyframe_index_.pop_front();
 
   // Now we need to delete all the buffers that depend on the keyframe we've
   // just deleted.
-  int end_index = keyframe_map_.size() > 0 ?
-      keyframe_map_.begin()->second - keyframe_map_index_base_ :
-      buffers_.size();
+  int buffers_deleted = keyframe_index_.size() > 0
+                            ? GetBufferIndex(keyframe_index_.front())
+                            : buffers_.size();
 
-  // Delete buffers from the beginning of the buffered range up until (but not
+  // Move buffers from the beginning of the buffered range up until (but not
   // including) the next keyframe.
-  for (int i = 0; i < end_index; i++) {
-    size_t bytes_deleted = buffers_.front()->data_size();
-    DCHECK_GE(size_in_bytes_, bytes_deleted);
-    size_in_bytes_ -= bytes_deleted;
-    total_bytes_deleted += bytes_deleted;
-    deleted_buffers->push_back(buffers_.front());
-    buffers_.pop_front();
-    ++buffers_deleted;
-  }
+  BufferQueue::iterator gop_end = buffers_.begin() + buffers_deleted;
+  deleted_buffers->insert(deleted_buffers->end(),
+                          std::make_move_iterator(buffers_.begin()),
+                          std::make_move_iterator(gop_end));
+  buffers_.erase(buffers_.begin(), gop_end);
+  DCHECK_GE(size_in_bytes_, total_bytes_deleted);
+  size_in_bytes_ -= total_bytes_deleted;
 
-  // Update |keyframe_map_index_base_| to account for the deleted buffers.
-  keyframe_map_index_base_ += buffers_deleted;
+  // Update |keyframe_index_base_| to account for the deleted buffers.
+  keyframe_index_base_ += buffers_deleted;
 
   if (next_buffer_index_ > -1) {
     next_buffer_index_ -= buffers_deleted;
@@ -332,29 +376,24 @@ size_t SourceBufferRange::DeleteGOPFromBack(BufferQueue* deleted_buffers) {
   DCHECK(!buffers_.empty());
   DCHECK(!LastGOPContainsNextBufferPosition());
   DCHECK(deleted_buffers);
-
-  // Remove the last GOP's keyframe from the |keyframe_map_|.
-  KeyframeMap::iterator back = keyframe_map_.end();
-  DCHECK_GT(keyframe_map_.size(), 0u);
-  --back;
+  DCHECK_GT(keyframe_index_.size(), 0u);
 
   // The index of the first buffer in the last GOP is equal to the new size of
   // |buffers_| after that GOP is deleted.
-  size_t goal_size = back->second - keyframe_map_index_base_;
-  keyframe_map_.erase(back);
-
-  size_t total_bytes_deleted = 0;
-  while (buffers_.size() != goal_size) {
-    size_t bytes_deleted = buffers_.back()->data_size();
-    DCHECK_GE(size_in_bytes_, bytes_deleted);
-    size_in_bytes_ -= bytes_deleted;
-    total_bytes_deleted += bytes_deleted;
-    // We're removing buffers from the back, so push each removed buffer to the
-    // front of |deleted_buffers| so that |deleted_buffers| are in nondecreasing
-    // order.
-    deleted_buffers->push_front(buffers_.back());
-    buffers_.pop_back();
-  }
+  const KeyframeEntry& back = keyframe_index_.back();
+  const size_t total_bytes_deleted = back.size_in_bytes;
+  BufferQueue::iterator gop_start = buffers_.begin() + GetBufferIndex(back);
+  keyframe_index_.pop_back();
+
+  // We're removing buffers from the back, so put the removed buffers at the
+  // front of |deleted_buffers| so that |deleted_buffers| are in nondecreasing
+  // order.
+  deleted_buffers->insert(deleted_buffers->begin(),
+                          std::make_move_iterator(gop_start),
+                          std::make_move_iterator(buffers_.end()));
+  buffers_.erase(gop_start, buffers_.end());
+  DCHECK_GE(size_in_bytes_, total_bytes_deleted);
+  size_in_bytes_ -= total_bytes_deleted;
 
   return total_bytes_deleted;
 }
@@ -364,49 +403,36 @@ size_t SourceBufferRange::GetRemovalGOP(
     size_t total_bytes_to_free, DecodeTimestamp* removal_end_timestamp) {
   size_t bytes_removed = 0;
 
-  KeyframeMap::iterator gop_itr = GetFirstKeyframeAt(start_timestamp, false);
-  if (gop_itr == keyframe_map_.end())
+  KeyframeIndex::iterator gop_itr = GetFirstKeyframeAt(start_timestamp, false);
+  if (gop_itr == keyframe_index_.end())
     return 0;
-  int keyframe_index = gop_itr->second - keyframe_map_index_base_;
-  BufferQueue::iterator buffer_itr = buffers_.begin() + keyframe_index;
-  KeyframeMap::iterator gop_end = keyframe_map_.end();
+  KeyframeIndex::iterator gop_end = keyframe_index_.end();
   if (end_timestamp < GetBufferedEndTimestamp())
     gop_end = GetFirstKeyframeAtOrBefore(end_timestamp);
 
   // Check if the removal range is within a GOP and skip the loop if so.
   // [keyframe]...[start_timestamp]...[end_timestamp]...[keyframe]
-  KeyframeMap::iterator gop_itr_prev = gop_itr;
-  if (gop_itr_prev != keyframe_map_.begin() && --gop_itr_prev == gop_end)
+  KeyframeIndex::iterator gop_itr_prev = gop_itr;
+  if (gop_itr_prev != keyframe_index_.begin() && --gop_itr_prev == gop_end)
     gop_end = gop_itr;
 
   while (gop_itr != gop_end && bytes_removed < total_bytes_to_free) {
+    bytes_removed += gop_itr->size_in_bytes;
     ++gop_itr;
-
-    size_t gop_size = 0;
-    int next_gop_index = gop_itr == keyframe_map_.end() ?
-        buffers_.size() : gop_itr->second - keyframe_map_index_base_;
-    BufferQueue::iterator next_gop_start = buffers_.begin() + next_gop_index;
-    for (; buffer_itr != next_gop_start; ++buffer_itr) {
-      gop_size += (*buffer_itr)->data_size();
-    }
-
-    bytes_removed += gop_size;
   }
   if (bytes_removed > 0) {
-    *removal_end_timestamp = gop_itr == keyframe_map_.end() ?
-        GetBufferedEndTimestamp() : gop_itr->first;
+    *removal_end_timestamp = gop_itr == keyframe_index_.end() ?
+        GetBufferedEndTimestamp() : gop_itr->timestamp;
   }
   return bytes_removed;
 }
 
 bool SourceBufferRange::FirstGOPEarlierThanMediaTime(
     DecodeTimestamp media_time) const {
-  if (keyframe_map_.size() == 1u)
+  if (keyframe_index_.size() == 1u)
     return (GetBufferedEndTimestamp() <= media_time);
 
-  KeyframeMap::const_iterator second_gop = keyframe_map_.begin();
-  ++second_gop;
-  return second_gop->first <= media_time;
+  return keyframe_index_[1].timestamp <= media_time;
 }
 
 bool SourceBufferRange::FirstGOPContainsNextBufferPosition() const {
@@ -414,12 +440,10 @@ bool SourceBufferRange::FirstGOPContainsNextBufferPosition() const {
     return false;
 
   // If there is only one GOP, it must contain the next buffer position.
-  if (keyframe_map_.size() == 1u)
+  if (keyframe_index_.size() == 1u)
     return true;
 
-  KeyframeMap::const_iterator second_gop = keyframe_map_.begin();
-  ++second_gop;
-  return next_buffer_index_ < second_gop->second - keyframe_map_index_base_;
+  return next_buffer_index_ < GetBufferIndex(keyframe_index_[1]);
 }
 
 bool SourceBufferRange::LastGOPContainsNextBufferPosition() const {
@@ -427,24 +451,25 @@ bool SourceBufferRange::LastGOPContainsNextBufferPosition() const {
     return false;
 
   // If there is only one GOP, it must contain the next buffer position.
-  if (keyframe_map_.size() == 1u)
+  if (keyframe_index_.size() == 1u)
     return true;
 
-  KeyframeMap::const_iterator last_gop = keyframe_map_.end();
-  --last_gop;
-  return last_gop->second - keyframe_map_index_base_ <= next_buffer_index_;
+  return GetBufferIndex(keyframe_index_.back()) <= next_buffer_index_;
 }
 
-void SourceBufferRange::FreeBufferRange(
+size_t SourceBufferRange::FreeBufferRange(
     const BufferQueue::iterator& starting_point,
     const BufferQueue::iterator& ending_point) {
+  size_t bytes_freed = 0;
   for (BufferQueue::iterator itr = starting_point;
        itr != ending_point; ++itr) {
     size_t itr_data_size = static_cast<size_t>((*itr)->data_size());
     DCHECK_GE(size_in_bytes_, itr_data_size);
     size_in_bytes_ -= itr_data_size;
+    bytes_freed += itr_data_size;
   }
   buffers_.erase(starting_point, ending_point);
+  return bytes_freed;
 }
 
 bool SourceBufferRange::TruncateAt(
@@ -473,12 +498,24 @@ bool SourceBufferRange::TruncateAt(
   }
 
   // Remove keyframes from |starting_point| onward.
-  KeyframeMap::iterator starting_point_keyframe =
-      keyframe_map_.lower_bound((*starting_point)->GetDecodeTimestamp());
-  keyframe_map_.erase(starting_point_keyframe, keyframe_map_.end());
-
-  // Remove everything from |starting_point| onward.
-  FreeBufferRange(starting_point, buffers_.end());
+  KeyframeIndex::iterator starting_point_keyframe =
+      GetFirstKeyframeAt((*starting_point)->GetDecodeTimestamp(), false);
+  size_t bytes_in_removed_gops = 0;
+  for (KeyframeIndex::iterator itr = starting_point_keyframe;
+       itr != keyframe_index_.end(); ++itr) {
+    bytes_in_removed_gops += itr->size_in_bytes;
+  }
+  keyframe_index_.erase(starting_point_keyframe, keyframe_index_.end());
+
+  // Remove everything from |starting_point| onward. Whatever was not part of
+  // a removed GOP was the tail of the GOP that is now last in the range.
+  size_t bytes_freed = FreeBufferRange(starting_point, buffers_.end());
+  DCHECK_GE(bytes_freed, bytes_in_removed_gops);
+  if (!keyframe_index_.empty()) {
+    size_t bytes_freed_from_last_gop = bytes_freed - bytes_in_removed_gops;
+    DCHECK_GE(keyframe_index_.back().size_in_bytes, bytes_freed_from_last_gop);
+    keyframe_index_.back().size_in_bytes -= bytes_freed_from_last_gop;
+  }
   return buffers_.empty();
 }
 
@@ -524,15 +561,41 @@ void SourceBufferRange::ResetNextBufferPosition() {
   next_buffer_index_ = -1;
 }
 
-void SourceBufferRange::AppendRangeToEnd(const SourceBufferRange& range,
+void SourceBufferRange::AppendRangeToEnd(SourceBufferRange* range,
                                          bool transfer_current_position) {
-  DCHECK(CanAppendRangeToEnd(range));
+  CHECK(CanAppendRangeToEnd(*range));
   DCHECK(!buffers_.empty());
+  DCHECK(!range->buffers_.empty());
+
+  if (transfer_current_position && range->next_buffer_index_ >= 0)
+    next_buffer_index_ = range->next_buffer_index_ + buffers_.size();
+
+  AdjustEstimatedDurationForNewAppend(range->buffers_);
+
+  // Translate |range|'s GOPs into this range's index space. A leading keyframe
+  // with the same timestamp as our last keyframe joins our last GOP, matching
+  // what AppendBuffersToEnd() would do.
+  const int index_offset =
+      buffers_.size() + keyframe_index_base_ - range->keyframe_index_base_;
+  for (const KeyframeEntry& entry : range->keyframe_index_) {
+    if (keyframe_index_.back().timestamp == entry.timestamp) {
+      keyframe_index_.back().size_in_bytes += entry.size_in_bytes;
+      continue;
+    }
+    DCHECK(keyframe_index_.back().timestamp < entry.timestamp);
+    keyframe_index_.push_back(entry);
+    keyframe_index_.back().index += index_offset;
+  }
 
-  if (transfer_current_position && range.next_buffer_index_ >= 0)
-    next_buffer_index_ = range.next_buffer_index_ + buffers_.size();
+  buffers_.insert(buffers_.end(),
+                  std::make_move_iterator(range->buffers_.begin()),
+                  std::make_move_iterator(range->buffers_.end()));
+  size_in_bytes_ += range->size_in_bytes_;
 
-  AppendBuffersToEnd(range.buffers_, kNoDecodeTimestamp());
+  range->buffers_.clear();
+  range->keyframe_index_.clear();
+  range->size_in_bytes_ = 0;
+  range->ResetNextBufferPosition();
 }
 
 bool SourceBufferRange::CanAppendRangeToEnd(
@@ -563,7 +626,7 @@ bool SourceBufferRange::BelongsToRange(DecodeTimestamp timestamp) const {
 bool SourceBufferRange::CanSeekTo(DecodeTimestamp timestamp) const {
   DecodeTimestamp start_timestamp =
       std::max(DecodeTimestamp(), GetStartTimestamp() - GetFudgeRoom());
-  return !keyframe_map_.empty() && start_timestamp <= timestamp &&
+  return !keyframe_index_.empty() && start_timestamp <= timestamp &&
       timestamp < GetBufferedEndTimestamp();
 }
 
@@ -601,34 +664,34 @@ DecodeTimestamp SourceBufferRange::GetBufferedEndTimestamp() const {
 
 DecodeTimestamp SourceBufferRange::NextKeyframeTimestamp(
     DecodeTimestamp timestamp) {
-  DCHECK(!keyframe_map_.empty());
+  DCHECK(!keyframe_index_.empty());
 
   if (timestamp < GetStartTimestamp() || timestamp >= GetBufferedEndTimestamp())
     return kNoDecodeTimestamp();
 
-  KeyframeMap::iterator itr = GetFirstKeyframeAt(timestamp, false);
-  if (itr == keyframe_map_.end())
+  KeyframeIndex::iterator itr = GetFirstKeyframeAt(timestamp, false);
+  if (itr == keyframe_index_.end())
     return kNoDecodeTimestamp();
 
   // If the timestamp is inside the gap between the start of the coded frame
   // group and the first buffer, then just pretend there is a keyframe at the
   // specified timestamp.
-  if (itr == keyframe_map_.begin() && timestamp > range_start_time_ &&
-      timestamp < itr->first) {
+  if (itr == keyframe_index_.begin() && timestamp > range_start_time_ &&
+      timestamp < itr->timestamp) {
     return timestamp;
   }
 
-  return itr->first;
+  return itr->timestamp;
 }
 
 DecodeTimestamp SourceBufferRange::KeyframeBeforeTimestamp(
     DecodeTimestamp timestamp) {
-  DCHECK(!keyframe_map_.empty());
+  DCHECK(!keyframe_index_.empty());
 
   if (timestamp < GetStartTimestamp() || timestamp >= GetBufferedEndTimestamp())
     return kNoDecodeTimestamp();
 
-  return GetFirstKeyframeAtOrBefore(timestamp)->first;
+  return GetFirstKeyframeAtOrBefore(timestamp)->timestamp;
 }
 
 bool SourceBufferRange::IsNextInSequence(DecodeTimestamp timestamp) const {
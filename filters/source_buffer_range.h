@@ -7,7 +7,7 @@
 
 #include <stddef.h>
 
-#include <map>
+#include <deque>
 
 #include "base/callback.h"
 #include "base/macros.h"
@@ -75,7 +75,7 @@ class SourceBufferRange {
 
   ~SourceBufferRange();
 
-  // Appends |buffers| to the end of the range and updates |keyframe_map_| as
+  // Appends |buffers| to the end of the range and updates |keyframe_index_| as
   // it encounters new keyframes.
   // If |new_buffers_group_start_timestamp| is kNoDecodeTimestamp(), then the
   // first buffer in |buffers| must come directly after the last buffer in this
@@ -91,7 +91,8 @@ class SourceBufferRange {
       const BufferQueue& buffers,
       DecodeTimestamp new_buffers_group_start_timestamp) const;
 
-  // Appends the buffers from |range| into this range.
+  // Moves the buffers from |range| into this range, leaving |range| empty.
+  // The caller is expected to delete |range| afterwards.
   // The first buffer in |range| must come directly after the last buffer
   // in this range.
   // If |transfer_current_position| is true, |range|'s |next_buffer_index_|
@@ -99,7 +100,7 @@ class SourceBufferRange {
   // Note: Use these only to merge existing ranges. |range|'s first buffer
   // timestamp must be adjacent to this range. No group start timestamp
   // adjacency is involved in these methods.
-  void AppendRangeToEnd(const SourceBufferRange& range,
+  void AppendRangeToEnd(SourceBufferRange* range,
                         bool transfer_current_position);
   bool CanAppendRangeToEnd(const SourceBufferRange& range) const;
 
@@ -129,7 +130,7 @@ class SourceBufferRange {
   // Deletes the buffers from this range starting at |timestamp|, exclusive if
   // |is_exclusive| is true, inclusive otherwise.
   // Resets |next_buffer_index_| if the buffer at |next_buffer_index_| was
-  // deleted, and deletes the |keyframe_map_| entries for the buffers that
+  // deleted, and deletes the |keyframe_index_| entries for the buffers that
   // were removed.
   // |deleted_buffers| contains the buffers that were deleted from this range,
   // starting at the buffer that had been at |next_buffer_index_|.
@@ -142,7 +143,9 @@ class SourceBufferRange {
 
   // Deletes a GOP from the front or back of the range and moves these
   // buffers into |deleted_buffers|. Returns the number of bytes deleted from
-  // the range (i.e. the size in bytes of |deleted_buffers|).
+  // the range (i.e. the size in bytes of |deleted_buffers|). Runs in time
+  // proportional to the number of buffers in the GOP; the byte count comes
+  // from the keyframe index rather than from the buffers themselves.
   // This range must NOT be empty when these methods are called.
   // The GOP being deleted must NOT contain the next buffer position.
   size_t DeleteGOPFromFront(BufferQueue* deleted_buffers);
@@ -242,7 +245,32 @@ class SourceBufferRange {
   size_t size_in_bytes() const { return size_in_bytes_; }
 
  private:
-  typedef std::map<DecodeTimestamp, int> KeyframeMap;
+  // An entry in |keyframe_index_|, describing one GOP of this range.
+  struct KeyframeEntry {
+    KeyframeEntry(DecodeTimestamp timestamp, int index);
+
+    // Decode timestamp of the keyframe starting the GOP.
+    DecodeTimestamp timestamp;
+
+    // Position of the keyframe in |buffers_|, offset by
+    // |keyframe_index_base_|.
+    int index;
+
+    // Sum of data_size() over the buffers of this GOP, i.e. the buffers from
+    // this keyframe up to (but not including) the next entry's keyframe.
+    size_t size_in_bytes;
+  };
+
+  // Sorted by |timestamp|, with at most one entry per timestamp. Entries are
+  // only ever added at the back and removed from either end, so lookups are
+  // binary searches over contiguous storage.
+  typedef std::deque<KeyframeEntry> KeyframeIndex;
+
+  // Creates an empty range. Used by SplitRange() to move buffers and keyframe
+  // entries in bulk into a new range.
+  SourceBufferRange(GapPolicy gap_policy,
+                    DecodeTimestamp range_start_time,
+                    const InterbufferDistanceCB& interbuffer_distance_cb);
 
   // Called during AppendBuffersToEnd to adjust estimated duration at the
   // end of the last append to match the delta in timestamps between
@@ -261,15 +289,20 @@ class SourceBufferRange {
   BufferQueue::iterator GetBufferItrAt(
       DecodeTimestamp timestamp, bool skip_given_timestamp);
 
-  // Returns an iterator in |keyframe_map_| pointing to the next keyframe after
-  // |timestamp|. If |skip_given_timestamp| is true, this returns the first
-  // keyframe with a timestamp strictly greater than |timestamp|.
-  KeyframeMap::iterator GetFirstKeyframeAt(
+  // Returns an iterator in |keyframe_index_| pointing to the next keyframe
+  // after |timestamp|. If |skip_given_timestamp| is true, this returns the
+  // first keyframe with a timestamp strictly greater than |timestamp|.
+  KeyframeIndex::iterator GetFirstKeyframeAt(
       DecodeTimestamp timestamp, bool skip_given_timestamp);
 
-  // Returns an iterator in |keyframe_map_| pointing to the first keyframe
+  // Returns an iterator in |keyframe_index_| pointing to the first keyframe
   // before or at |timestamp|.
-  KeyframeMap::iterator GetFirstKeyframeAtOrBefore(DecodeTimestamp timestamp);
+  KeyframeIndex::iterator GetFirstKeyframeAtOrBefore(DecodeTimestamp timestamp);
+
+  // Returns the position in |buffers_| of the keyframe described by |entry|.
+  int GetBufferIndex(const KeyframeEntry& entry) const {
+    return entry.index - keyframe_index_base_;
+  }
 
   // Helper method to delete buffers in |buffers_| starting at
   // |starting_point|, an iterator in |buffers_|.
@@ -279,9 +312,10 @@ class SourceBufferRange {
                   BufferQueue* deleted_buffers);
 
   // Frees the buffers in |buffers_| from [|start_point|,|ending_point|) and
-  // updates the |size_in_bytes_| accordingly. Does not update |keyframe_map_|.
-  void FreeBufferRange(const BufferQueue::iterator& starting_point,
-                       const BufferQueue::iterator& ending_point);
+  // updates the |size_in_bytes_| accordingly. Does not update
+  // |keyframe_index_|. Returns the number of bytes freed.
+  size_t FreeBufferRange(const BufferQueue::iterator& starting_point,
+                         const BufferQueue::iterator& ending_point);
 
   // Returns the distance in time estimating how far from the beginning or end
   // of this range a buffer can be to considered in the range.
@@ -296,13 +330,14 @@ class SourceBufferRange {
   // An ordered list of buffers in this range.
   BufferQueue buffers_;
 
-  // Maps keyframe timestamps to its index position in |buffers_|.
-  KeyframeMap keyframe_map_;
+  // One entry per GOP, mapping keyframe timestamps to their index position in
+  // |buffers_| and to the size of the GOP.
+  KeyframeIndex keyframe_index_;
 
-  // Index base of all positions in |keyframe_map_|. In other words, the
-  // real position of entry |k| of |keyframe_map_| in the range is:
-  //   keyframe_map_[k] - keyframe_map_index_base_
-  int keyframe_map_index_base_;
+  // Index base of all positions in |keyframe_index_|. In other words, the
+  // real position of entry |k| of |keyframe_index_| in the range is:
+  //   keyframe_index_[k].index - keyframe_index_base_
+  int keyframe_index_base_;
 
   // Index into |buffers_| for the next buffer to be returned by
   // GetNextBuffer(), set to -1 before Seek().
@@ -1189,7 +1189,7 @@ void SourceBufferStream::MergeWithAdjacentRangeIfNecessary(
   DVLOG(3) << __func__ << " " << GetStreamTypeName() << " merging "
            << RangeToString(*range_with_new_buffers) << " into "
            << RangeToString(**next_range_itr);
-  range_with_new_buffers->AppendRangeToEnd(**next_range_itr,
+  range_with_new_buffers->AppendRangeToEnd(*next_range_itr,
                                            transfer_current_position);
   // Update |selected_range_| pointer if |range| has become selected after
   // merges.
@@ -0,0 +1,127 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include "base/time/time.h"
+#include "media/base/media_log.h"
+#include "media/base/stream_parser_buffer.h"
+#include "media/base/test_helpers.h"
+#include "media/filters/source_buffer_stream.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace media {
+
+// Simulates a live-DVR window of 30fps video with one keyframe per second:
+// 12000 GOPs is a little over three hours of content.
+static const int kFramesPerSecond = 30;
+static const int kFramesPerGop = 30;
+static const int kGopCount = 12000;
+static const int kBufferSize = 64;
+static const uint8_t kBufferData[kBufferSize] = {0};
+
+static base::TimeDelta FrameDuration() {
+  return base::TimeDelta::FromMicroseconds(base::Time::kMicrosecondsPerSecond /
+                                           kFramesPerSecond);
+}
+
+static StreamParser::BufferQueue CreateGop(int gop_index) {
+  StreamParser::BufferQueue gop;
+  for (int i = 0; i < kFramesPerGop; ++i) {
+    scoped_refptr<StreamParserBuffer> buffer = StreamParserBuffer::CopyFrom(
+        kBufferData, kBufferSize, i == 0, DemuxerStream::VIDEO, 0);
+    base::TimeDelta timestamp =
+        FrameDuration() * (gop_index * kFramesPerGop + i);
+    buffer->set_timestamp(timestamp);
+    buffer->SetDecodeTimestamp(DecodeTimestamp::FromPresentationTime(timestamp));
+    buffer->set_duration(FrameDuration());
+    gop.push_back(buffer);
+  }
+  return gop;
+}
+
+static std::unique_ptr<SourceBufferStream> CreateStream() {
+  std::unique_ptr<SourceBufferStream> stream(
+      new SourceBufferStream(TestVideoConfig::Normal(), new MediaLog()));
+  stream->OnStartOfCodedFrameGroup(DecodeTimestamp());
+  return stream;
+}
+
+static void PrintPerGopResult(const std::string& measurement,
+                              const std::string& trace,
+                              base::TimeDelta elapsed,
+                              int gops) {
+  perf_test::PrintResult(measurement, "", trace,
+                         elapsed.InMicrosecondsF() / gops, "us/gop", true);
+}
+
+// Appends |kGopCount| GOPs to a single range, one GOP per append.
+TEST(SourceBufferStreamPerfTest, AppendGops) {
+  std::unique_ptr<SourceBufferStream> stream = CreateStream();
+
+  base::TimeDelta elapsed;
+  for (int i = 0; i < kGopCount; ++i) {
+    StreamParser::BufferQueue gop = CreateGop(i);
+    base::TimeTicks start = base::TimeTicks::Now();
+    ASSERT_TRUE(stream->Append(gop));
+    elapsed += base::TimeTicks::Now() - start;
+  }
+  PrintPerGopResult("source_buffer_stream_append", "sequential", elapsed,
+                    kGopCount);
+}
+
+// Keeps a sliding window of |kGopCount| GOPs by appending one GOP and then
+// garbage collecting one GOP from the front on every iteration.
+TEST(SourceBufferStreamPerfTest, AppendAndEvictGops) {
+  std::unique_ptr<SourceBufferStream> stream = CreateStream();
+  stream->set_memory_limit(static_cast<size_t>(kGopCount) * kFramesPerGop *
+                           kBufferSize);
+  for (int i = 0; i < kGopCount; ++i)
+    ASSERT_TRUE(stream->Append(CreateGop(i)));
+
+  const int kEvictedGops = kGopCount / 4;
+  base::TimeDelta elapsed;
+  for (int i = kGopCount; i < kGopCount + kEvictedGops; ++i) {
+    StreamParser::BufferQueue gop = CreateGop(i);
+    DecodeTimestamp media_time = gop.front()->GetDecodeTimestamp();
+    base::TimeTicks start = base::TimeTicks::Now();
+    ASSERT_TRUE(stream->GarbageCollectIfNeeded(media_time,
+                                               kFramesPerGop * kBufferSize));
+    ASSERT_TRUE(stream->Append(gop));
+    elapsed += base::TimeTicks::Now() - start;
+  }
+  PrintPerGopResult("source_buffer_stream_append_and_evict", "sliding_window",
+                    elapsed, kEvictedGops);
+}
+
+// Repeatedly removes a GOP from the middle of a large range and appends it
+// back, which splits the range and merges the two halves again.
+TEST(SourceBufferStreamPerfTest, RemoveAndRefillGops) {
+  std::unique_ptr<SourceBufferStream> stream = CreateStream();
+  for (int i = 0; i < kGopCount; ++i)
+    ASSERT_TRUE(stream->Append(CreateGop(i)));
+
+  const int kIterations = 200;
+  const base::TimeDelta gop_duration = FrameDuration() * kFramesPerGop;
+  const base::TimeDelta duration = gop_duration * kGopCount;
+  base::TimeDelta elapsed;
+  for (int i = 0; i < kIterations; ++i) {
+    const int gop_index = kGopCount / 2 + (i % 16);
+    StreamParser::BufferQueue gop = CreateGop(gop_index);
+    base::TimeTicks start = base::TimeTicks::Now();
+    stream->Remove(gop_duration * gop_index, gop_duration * (gop_index + 1),
+                   duration);
+    stream->OnStartOfCodedFrameGroup(gop.front()->GetDecodeTimestamp());
+    ASSERT_TRUE(stream->Append(gop));
+    elapsed += base::TimeTicks::Now() - start;
+  }
+  PrintPerGopResult("source_buffer_stream_remove_and_refill", "middle_gop",
+                    elapsed, kIterations);
+}
+
+}  // namespace media
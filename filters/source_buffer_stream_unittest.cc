@@ -3987,6 +3987,77 @@ TEST_F(SourceBufferStreamTest, Remove_GapAtBeginningOfGroup) {
   CheckExpectedRangesByTimestamp("{ [120,180) }");
 }
 
+// The following tests check that the keyframe index of a range stays in step
+// with its buffers when the range is split, truncated, trimmed or merged:
+// seeking to a non-keyframe must land on the keyframe of its GOP.
+TEST_F(SourceBufferStreamTest, GOPIndex_SplitInMiddleOfGOP) {
+  Seek(0);
+  NewCodedFrameGroupAppend("0K 30 60 90K 120 150 180K 210 240");
+  CheckExpectedRangesByTimestamp("{ [0,270) }");
+
+  // Removing a buffer in the middle of the second GOP also removes the rest of
+  // that GOP, which splits the range before the next keyframe.
+  RemoveInMs(120, 150, 270);
+  CheckExpectedRangesByTimestamp("{ [0,120) [180,270) }");
+
+  CheckExpectedBuffers("0K 30 60 90K");
+  CheckNoNextBuffer();
+  SeekToTimestampMs(210);
+  CheckExpectedBuffers("180K 210 240");
+  CheckNoNextBuffer();
+}
+
+TEST_F(SourceBufferStreamTest, GOPIndex_AppendAfterTruncation) {
+  Seek(0);
+  NewCodedFrameGroupAppend("0K 30 60 90K 120 150 180K 210");
+  CheckExpectedRangesByTimestamp("{ [0,240) }");
+
+  RemoveInMs(120, 240, 240);
+  CheckExpectedRangesByTimestamp("{ [0,120) }");
+
+  // A coded frame group starting at the truncated end extends the range.
+  NewCodedFrameGroupAppend("120K 150 180 210K 240");
+  CheckExpectedRangesByTimestamp("{ [0,270) }");
+
+  CheckExpectedBuffers("0K 30 60 90K 120K 150 180 210K 240");
+  CheckNoNextBuffer();
+  SeekToTimestampMs(180);
+  CheckExpectedBuffers("120K 150 180 210K 240");
+  CheckNoNextBuffer();
+}
+
+TEST_F(SourceBufferStreamTest, GOPIndex_RemoveFromBothEnds) {
+  NewCodedFrameGroupAppend("0K 30 60 90K 120 150 180K 210 240");
+  CheckExpectedRangesByTimestamp("{ [0,270) }");
+
+  RemoveInMs(0, 90, 270);
+  CheckExpectedRangesByTimestamp("{ [90,270) }");
+
+  RemoveInMs(180, 270, 270);
+  CheckExpectedRangesByTimestamp("{ [90,180) }");
+
+  SeekToTimestampMs(150);
+  CheckExpectedBuffers("90K 120 150");
+  CheckNoNextBuffer();
+}
+
+TEST_F(SourceBufferStreamTest, GOPIndex_MergeAdjacentRanges) {
+  Seek(0);
+  NewCodedFrameGroupAppend("0K 30 60");
+  NewCodedFrameGroupAppend("180K 210");
+  CheckExpectedRangesByTimestamp("{ [0,90) [180,240) }");
+
+  // Filling the gap merges both ranges with the new data.
+  NewCodedFrameGroupAppend("90K 120 150");
+  CheckExpectedRangesByTimestamp("{ [0,240) }");
+
+  CheckExpectedBuffers("0K 30 60 90K 120 150 180K 210");
+  CheckNoNextBuffer();
+  SeekToTimestampMs(120);
+  CheckExpectedBuffers("90K 120 150 180K 210");
+  CheckNoNextBuffer();
+}
+
 TEST_F(SourceBufferStreamTest, Text_Append_SingleRange) {
   SetTextStream();
   NewCodedFrameGroupAppend("0K 500K 1000K");
@@ -15,6 +15,7 @@
 #include "media/base/stream_parser_buffer.h"
 #include "media/base/timestamp_constants.h"
 #include "media/base/video_frame.h"
+#include "media/filters/annex_b_scanner.h"
 #include "media/filters/h264_parser.h"
 #include "media/formats/common/offset_byte_queue.h"
 #include "media/formats/mp2t/mp2t_common.h"
@@ -40,18 +41,18 @@ const int kSampleAESPatternUnit =
 // Note: the EP3B always follows two zero bytes, so the value 0 can never be a
 // valid position.
 int FindEP3B(const uint8_t* buffer, int start_pos, int end_pos) {
-  const uint8_t* data = buffer + start_pos;
-  int data_size = end_pos - start_pos;
-  DCHECK_GE(data_size, 0);
-  int bytes_left = data_size;
-
-  while (bytes_left >= 4) {
-    if (data[0] == 0x00 && data[1] == 0x00 && data[2] == 0x03 &&
-        data[3] <= 0x03) {
-      return (data - buffer) + 2;
-    }
-    ++data;
-    --bytes_left;
+  DCHECK_GE(end_pos - start_pos, 0);
+  int pos = start_pos;
+
+  // An EP3B is the third byte of an escape sequence which is followed by a
+  // byte <= 0x03; skip from one escape sequence to the next.
+  while (end_pos - pos >= 4) {
+    pos += annex_b::FindEscapeSequence(buffer + pos, end_pos - pos);
+    if (end_pos - pos < 4)
+      break;
+    if (buffer[pos + 2] == 0x03 && buffer[pos + 3] <= 0x03)
+      return pos + 2;
+    ++pos;
   }
   return 0;
 }
@@ -4,11 +4,13 @@
 
 #include "media/formats/mp2t/mp2t_stream_parser.h"
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 
 #include "base/bind.h"
 #include "base/callback_helpers.h"
+#include "base/strings/string_number_conversions.h"
 #include "media/base/media_tracks.h"
 #include "media/base/stream_parser_buffer.h"
 #include "media/base/text_track_config.h"
@@ -35,6 +37,10 @@ namespace mp2t {
 
 namespace {
 
+// The most TS packets whose headers are parsed at once, before their
+// payloads are handed to the section parsers.
+const int kMaxTsPacketBatchSize = 64;
+
 #if BUILDFLAG(ENABLE_HLS_SAMPLE_AES)
 const int64_t kSampleAESPrivateDataIndicatorAVC = 0x7a617663;
 const int64_t kSampleAESPrivateDataIndicatorAAC = 0x61616364;
@@ -43,6 +49,13 @@ const int64_t kSampleAESPrivateDataIndicatorAAC = 0x61616364;
 // const int64_t kSampleAESPrivateDataIndicatorEAC3 = 0x65633364;
 #endif
 
+template <typename Config>
+bool HasValidConfig(const std::map<StreamParser::TrackId, Config>& configs,
+                    StreamParser::TrackId track_id) {
+  auto it = configs.find(track_id);
+  return it != configs.end() && it->second.IsValidConfig();
+}
+
 }  // namespace
 
 enum StreamType {
@@ -175,11 +188,11 @@ void PidState::ResetState() {
 
 Mp2tStreamParser::BufferQueueWithConfig::BufferQueueWithConfig(
     bool is_cfg_sent,
-    const AudioDecoderConfig& audio_cfg,
-    const VideoDecoderConfig& video_cfg)
+    const AudioConfigMap& audio_cfgs,
+    const VideoConfigMap& video_cfgs)
   : is_config_sent(is_cfg_sent),
-    audio_config(audio_cfg),
-    video_config(video_cfg) {
+    audio_configs(audio_cfgs),
+    video_configs(video_cfgs) {
 }
 
 Mp2tStreamParser::BufferQueueWithConfig::BufferQueueWithConfig(
@@ -190,8 +203,7 @@ Mp2tStreamParser::BufferQueueWithConfig::~BufferQueueWithConfig() {
 
 Mp2tStreamParser::Mp2tStreamParser(bool sbr_in_mimetype)
   : sbr_in_mimetype_(sbr_in_mimetype),
-    selected_audio_pid_(-1),
-    selected_video_pid_(-1),
+    multi_program_output_(false),
     is_initialized_(false),
     segment_started_(false) {
 }
@@ -199,6 +211,13 @@ Mp2tStreamParser::Mp2tStreamParser(bool sbr_in_mimetype)
 Mp2tStreamParser::~Mp2tStreamParser() {
 }
 
+void Mp2tStreamParser::EnableMultiProgramOutput(
+    const std::set<int>& pid_allow_list) {
+  DCHECK(pids_.empty());
+  multi_program_output_ = true;
+  pid_allow_list_ = pid_allow_list;
+}
+
 void Mp2tStreamParser::Init(
     const InitCB& init_cb,
     const NewConfigCB& config_cb,
@@ -235,6 +254,8 @@ void Mp2tStreamParser::Flush() {
     pid_pair.second->Flush();
   }
   pids_.clear();
+  program_numbers_.clear();
+  pes_pmt_pids_.clear();
 
   // Flush is invoked from SourceBuffer.abort/SourceState::ResetParserState, and
   // MSE spec prohibits emitting new configs in ResetParserState algorithm (see
@@ -267,11 +288,11 @@ void Mp2tStreamParser::Flush() {
   ts_byte_queue_.Reset();
 
   // Reset the selected PIDs.
-  selected_audio_pid_ = -1;
-  selected_video_pid_ = -1;
+  selected_audio_pids_.clear();
+  selected_video_pids_.clear();
 
-  // Reset the timestamp unroller.
-  timestamp_unroller_.Reset();
+  // Reset the timestamp unrollers.
+  timestamp_unrollers_.clear();
 }
 
 bool Mp2tStreamParser::Parse(const uint8_t* buf, int size) {
@@ -283,7 +304,8 @@ bool Mp2tStreamParser::Parse(const uint8_t* buf, int size) {
   while (true) {
     const uint8_t* ts_buffer;
     int ts_buffer_size;
-    ts_byte_queue_.Peek(&ts_buffer, &ts_buffer_size);
+    ts_byte_queue_.PeekAtLeast(TsPacket::kPacketSize, &ts_buffer,
+                               &ts_buffer_size);
     if (ts_buffer_size < TsPacket::kPacketSize)
       break;
 
@@ -296,52 +318,29 @@ bool Mp2tStreamParser::Parse(const uint8_t* buf, int size) {
       continue;
     }
 
-    // Parse the TS header, skipping 1 byte if the header is invalid.
-    std::unique_ptr<TsPacket> ts_packet(
-        TsPacket::Parse(ts_buffer, ts_buffer_size));
-    if (!ts_packet) {
-      DVLOG(1) << "Error: invalid TS packet";
-      ts_byte_queue_.Pop(1);
-      continue;
+    // Parse the headers of a batch of synchronized packets, stopping at the
+    // first invalid one.
+    const int num_packets =
+        std::min(kMaxTsPacketBatchSize,
+                 TsPacket::CountSyncedPackets(ts_buffer, ts_buffer_size));
+    TsPacket ts_packets[kMaxTsPacketBatchSize];
+    int num_parsed = 0;
+    while (num_parsed < num_packets &&
+           TsPacket::Parse(ts_buffer + num_parsed * TsPacket::kPacketSize,
+                           ts_buffer_size - num_parsed * TsPacket::kPacketSize,
+                           &ts_packets[num_parsed])) {
+      num_parsed++;
     }
-    DVLOG(LOG_LEVEL_TS)
-        << "Processing PID=" << ts_packet->pid()
-        << " start_unit=" << ts_packet->payload_unit_start_indicator();
-
-    // Parse the section.
-    auto it = pids_.find(ts_packet->pid());
-    if (it == pids_.end() &&
-        ts_packet->pid() == TsSection::kPidPat) {
-      // Create the PAT state here if needed.
-      std::unique_ptr<TsSection> pat_section_parser(new TsSectionPat(
-          base::Bind(&Mp2tStreamParser::RegisterPmt, base::Unretained(this))));
-      std::unique_ptr<PidState> pat_pid_state(new PidState(
-          ts_packet->pid(), PidState::kPidPat, std::move(pat_section_parser)));
-      pat_pid_state->Enable();
-      it = pids_
-               .insert(
-                   std::make_pair(ts_packet->pid(), std::move(pat_pid_state)))
-               .first;
-    }
-#if BUILDFLAG(ENABLE_HLS_SAMPLE_AES)
-    // We allow a CAT to appear as the first packet in the TS. This allows us to
-    // specify encryption metadata for HLS by injecting it as an extra TS packet
-    // at the front of the stream.
-    else if (it == pids_.end() && ts_packet->pid() == TsSection::kPidCat) {
-      it = pids_.insert(std::make_pair(TsSection::kPidCat, MakeCatPidState()))
-               .first;
-    }
-#endif
 
-    if (it != pids_.end()) {
-      if (!it->second->PushTsPacket(*ts_packet))
-        return false;
-    } else {
-      DVLOG(LOG_LEVEL_TS) << "Ignoring TS packet for pid: " << ts_packet->pid();
-    }
+    if (!ProcessTsPackets(ts_packets, num_parsed))
+      return false;
+    ts_byte_queue_.Pop(num_parsed * TsPacket::kPacketSize);
 
-    // Go to the next packet.
-    ts_byte_queue_.Pop(TsPacket::kPacketSize);
+    // Skip 1 byte if a header is invalid.
+    if (num_parsed < num_packets) {
+      DVLOG(1) << "Error: invalid TS packet";
+      ts_byte_queue_.Pop(1);
+    }
   }
 
   RCHECK(FinishInitializationIfNeeded());
@@ -350,16 +349,71 @@ bool Mp2tStreamParser::Parse(const uint8_t* buf, int size) {
   return EmitRemainingBuffers();
 }
 
+bool Mp2tStreamParser::ProcessTsPackets(const TsPacket* ts_packets,
+                                        int count) {
+  for (int i = 0; i < count;) {
+    // Look the PID up once for each run of packets on the same PID, which is
+    // the usual case for video. Section parsing can add and remove PIDs, but
+    // never the one being parsed.
+    const int pid = ts_packets[i].pid();
+    int run_end = i + 1;
+    while (run_end < count && ts_packets[run_end].pid() == pid)
+      run_end++;
+
+    PidState* pid_state = GetOrCreatePidState(pid);
+    if (!pid_state) {
+      DVLOG(LOG_LEVEL_TS) << "Ignoring " << run_end - i
+                          << " TS packets for pid: " << pid;
+      i = run_end;
+      continue;
+    }
+
+    for (; i < run_end; i++) {
+      DVLOG(LOG_LEVEL_TS)
+          << "Processing PID=" << pid
+          << " start_unit=" << ts_packets[i].payload_unit_start_indicator();
+      if (!pid_state->PushTsPacket(ts_packets[i]))
+        return false;
+    }
+  }
+  return true;
+}
+
+PidState* Mp2tStreamParser::GetOrCreatePidState(int pid) {
+  auto it = pids_.find(pid);
+  if (it == pids_.end() && pid == TsSection::kPidPat) {
+    // Create the PAT state here if needed.
+    std::unique_ptr<TsSection> pat_section_parser(new TsSectionPat(
+        base::Bind(&Mp2tStreamParser::RegisterPmt, base::Unretained(this)),
+        multi_program_output_));
+    std::unique_ptr<PidState> pat_pid_state(
+        new PidState(pid, PidState::kPidPat, std::move(pat_section_parser)));
+    pat_pid_state->Enable();
+    it = pids_.insert(std::make_pair(pid, std::move(pat_pid_state))).first;
+  }
+#if BUILDFLAG(ENABLE_HLS_SAMPLE_AES)
+  // We allow a CAT to appear as the first packet in the TS. This allows us to
+  // specify encryption metadata for HLS by injecting it as an extra TS packet
+  // at the front of the stream.
+  else if (it == pids_.end() && pid == TsSection::kPidCat) {
+    it = pids_.insert(std::make_pair(TsSection::kPidCat, MakeCatPidState()))
+             .first;
+  }
+#endif
+  return it != pids_.end() ? it->second.get() : nullptr;
+}
+
 void Mp2tStreamParser::RegisterPmt(int program_number, int pmt_pid) {
   DVLOG(1) << "RegisterPmt:"
            << " program_number=" << program_number
            << " pmt_pid=" << pmt_pid;
 
-  // Only one TS program is allowed. Ignore the incoming program map table,
-  // if there is already one registered.
+  // Only one TS program is allowed, unless outputting all of them. Ignore the
+  // incoming program map table, if there is already one registered.
   for (const auto& pid_pair : pids_) {
     PidState* pid_state = pid_pair.second.get();
-    if (pid_state->pid_type() == PidState::kPidPmt) {
+    if (pid_state->pid_type() == PidState::kPidPmt &&
+        (!multi_program_output_ || pmt_pid == pid_pair.first)) {
       DVLOG_IF(1, pmt_pid != pid_pair.first)
           << "More than one program is defined";
       return;
@@ -374,6 +428,7 @@ void Mp2tStreamParser::RegisterPmt(int program_number, int pmt_pid) {
       new PidState(pmt_pid, PidState::kPidPmt, std::move(pmt_section_parser)));
   pmt_pid_state->Enable();
   pids_.insert(std::make_pair(pmt_pid, std::move(pmt_pid_state)));
+  program_numbers_[pmt_pid] = program_number;
 
 #if BUILDFLAG(ENABLE_HLS_SAMPLE_AES)
   // Take the opportunity to clean up any PIDs that were involved in importing
@@ -398,6 +453,13 @@ void Mp2tStreamParser::RegisterPes(int pmt_pid,
   if (it != pids_.end())
     return;
 
+  // Never create a PID state for streams which aren't allowed, so that their
+  // packets are dropped without being reassembled.
+  if (!pid_allow_list_.empty() && !pid_allow_list_.count(pes_pid)) {
+    DVLOG(1) << "Ignoring PES pid not in the allow list: " << pes_pid;
+    return;
+  }
+
   // Create a stream parser corresponding to the stream type.
   bool is_audio = false;
   std::unique_ptr<EsParser> es_parser;
@@ -458,13 +520,30 @@ void Mp2tStreamParser::RegisterPes(int pmt_pid,
 
   // Create the PES state here.
   DVLOG(1) << "Create a new PES state";
+  std::unique_ptr<TimestampUnroller>& timestamp_unroller =
+      timestamp_unrollers_[pmt_pid];
+  if (!timestamp_unroller)
+    timestamp_unroller.reset(new TimestampUnroller());
   std::unique_ptr<TsSection> pes_section_parser(
-      new TsSectionPes(std::move(es_parser), &timestamp_unroller_));
+      new TsSectionPes(std::move(es_parser), timestamp_unroller.get()));
   PidState::PidType pid_type =
       is_audio ? PidState::kPidAudioPes : PidState::kPidVideoPes;
   std::unique_ptr<PidState> pes_pid_state(
       new PidState(pes_pid, pid_type, std::move(pes_section_parser)));
-  pids_.insert(std::make_pair(pes_pid, std::move(pes_pid_state)));
+  it = pids_.insert(std::make_pair(pes_pid, std::move(pes_pid_state))).first;
+  pes_pmt_pids_[pes_pid] = pmt_pid;
+
+  if (multi_program_output_) {
+    // Every stream is output, as a track identified by its PID.
+    DVLOG(1) << "Enable " << (is_audio ? "audio" : "video")
+             << " pid: " << pes_pid;
+    it->second->Enable();
+    if (is_audio)
+      selected_audio_pids_[pes_pid] = pes_pid;
+    else
+      selected_video_pids_[pes_pid] = pes_pid;
+    return;
+  }
 
   // A new PES pid has been added, the PID filter might change.
   UpdatePidFilter();
@@ -492,12 +571,14 @@ void Mp2tStreamParser::UpdatePidFilter() {
   if (lowest_audio_pid != pids_.end()) {
     DVLOG(1) << "Enable audio pid: " << lowest_audio_pid->first;
     lowest_audio_pid->second->Enable();
-    selected_audio_pid_ = lowest_audio_pid->first;
+    selected_audio_pids_.clear();
+    selected_audio_pids_[lowest_audio_pid->first] = kMp2tAudioTrackId;
   }
   if (lowest_video_pid != pids_.end()) {
     DVLOG(1) << "Enable video pid: " << lowest_video_pid->first;
     lowest_video_pid->second->Enable();
-    selected_video_pid_ = lowest_video_pid->first;
+    selected_video_pids_.clear();
+    selected_video_pids_[lowest_video_pid->first] = kMp2tVideoTrackId;
   }
 
   // Disable all the other audio and video PIDs.
@@ -514,21 +595,28 @@ void Mp2tStreamParser::OnVideoConfigChanged(
     int pes_pid,
     const VideoDecoderConfig& video_decoder_config) {
   DVLOG(1) << "OnVideoConfigChanged for pid=" << pes_pid;
-  DCHECK_EQ(pes_pid, selected_video_pid_);
   DCHECK(video_decoder_config.IsValidConfig());
+  auto selected_it = selected_video_pids_.find(pes_pid);
+  if (selected_it == selected_video_pids_.end()) {
+    NOTREACHED() << "Config for an unselected video pid: " << pes_pid;
+    return;
+  }
+  const TrackId track_id = selected_it->second;
 
   if (!buffer_queue_chain_.empty() &&
-      !buffer_queue_chain_.back().video_config.IsValidConfig()) {
+      !HasValidConfig(buffer_queue_chain_.back().video_configs, track_id)) {
     // No video has been received so far, can reuse the existing video queue.
-    DCHECK(buffer_queue_chain_.back().video_queue.empty());
-    buffer_queue_chain_.back().video_config = video_decoder_config;
+    DCHECK(!buffer_queue_chain_.back().buffer_queues.count(track_id));
+    buffer_queue_chain_.back().video_configs[track_id] = video_decoder_config;
   } else {
     // Create a new entry in |buffer_queue_chain_| with the updated configs.
     BufferQueueWithConfig buffer_queue_with_config(
         false,
         buffer_queue_chain_.empty()
-        ? AudioDecoderConfig() : buffer_queue_chain_.back().audio_config,
-        video_decoder_config);
+        ? AudioConfigMap() : buffer_queue_chain_.back().audio_configs,
+        buffer_queue_chain_.empty()
+        ? VideoConfigMap() : buffer_queue_chain_.back().video_configs);
+    buffer_queue_with_config.video_configs[track_id] = video_decoder_config;
     buffer_queue_chain_.push_back(buffer_queue_with_config);
   }
 
@@ -536,9 +624,9 @@ void Mp2tStreamParser::OnVideoConfigChanged(
   // This might happen if there was no available config before.
   for (std::list<BufferQueueWithConfig>::iterator it =
        buffer_queue_chain_.begin(); it != buffer_queue_chain_.end(); ++it) {
-    if (it->video_config.IsValidConfig())
+    if (HasValidConfig(it->video_configs, track_id))
       break;
-    it->video_config = video_decoder_config;
+    it->video_configs[track_id] = video_decoder_config;
   }
 }
 
@@ -546,21 +634,28 @@ void Mp2tStreamParser::OnAudioConfigChanged(
     int pes_pid,
     const AudioDecoderConfig& audio_decoder_config) {
   DVLOG(1) << "OnAudioConfigChanged for pid=" << pes_pid;
-  DCHECK_EQ(pes_pid, selected_audio_pid_);
   DCHECK(audio_decoder_config.IsValidConfig());
+  auto selected_it = selected_audio_pids_.find(pes_pid);
+  if (selected_it == selected_audio_pids_.end()) {
+    NOTREACHED() << "Config for an unselected audio pid: " << pes_pid;
+    return;
+  }
+  const TrackId track_id = selected_it->second;
 
   if (!buffer_queue_chain_.empty() &&
-      !buffer_queue_chain_.back().audio_config.IsValidConfig()) {
+      !HasValidConfig(buffer_queue_chain_.back().audio_configs, track_id)) {
     // No audio has been received so far, can reuse the existing audio queue.
-    DCHECK(buffer_queue_chain_.back().audio_queue.empty());
-    buffer_queue_chain_.back().audio_config = audio_decoder_config;
+    DCHECK(!buffer_queue_chain_.back().buffer_queues.count(track_id));
+    buffer_queue_chain_.back().audio_configs[track_id] = audio_decoder_config;
   } else {
     // Create a new entry in |buffer_queue_chain_| with the updated configs.
     BufferQueueWithConfig buffer_queue_with_config(
         false,
-        audio_decoder_config,
         buffer_queue_chain_.empty()
-        ? VideoDecoderConfig() : buffer_queue_chain_.back().video_config);
+        ? AudioConfigMap() : buffer_queue_chain_.back().audio_configs,
+        buffer_queue_chain_.empty()
+        ? VideoConfigMap() : buffer_queue_chain_.back().video_configs);
+    buffer_queue_with_config.audio_configs[track_id] = audio_decoder_config;
     buffer_queue_chain_.push_back(buffer_queue_with_config);
   }
 
@@ -568,29 +663,54 @@ void Mp2tStreamParser::OnAudioConfigChanged(
   // This might happen if there was no available config before.
   for (std::list<BufferQueueWithConfig>::iterator it =
        buffer_queue_chain_.begin(); it != buffer_queue_chain_.end(); ++it) {
-    if (it->audio_config.IsValidConfig())
+    if (HasValidConfig(it->audio_configs, track_id))
       break;
-    it->audio_config = audio_decoder_config;
+    it->audio_configs[track_id] = audio_decoder_config;
   }
 }
 
-std::unique_ptr<MediaTracks> GenerateMediaTrackInfo(
-    const AudioDecoderConfig& audio_config,
-    const VideoDecoderConfig& video_config) {
+std::unique_ptr<MediaTracks> Mp2tStreamParser::GenerateMediaTrackInfo(
+    const BufferQueueWithConfig& queue_with_config) const {
   std::unique_ptr<MediaTracks> media_tracks(new MediaTracks());
   // TODO(servolk): Implement proper sourcing of media track info as described
   // in crbug.com/590085
-  if (audio_config.IsValidConfig()) {
-    media_tracks->AddAudioTrack(audio_config, kMp2tAudioTrackId, "main", "",
-                                "");
+  std::map<TrackId, std::string> labels;
+  if (multi_program_output_) {
+    // Label each track with the number of the program it belongs to.
+    for (const auto& pes_pair : pes_pmt_pids_) {
+      auto program_it = program_numbers_.find(pes_pair.second);
+      if (program_it != program_numbers_.end())
+        labels[pes_pair.first] = base::IntToString(program_it->second);
+    }
+  }
+  for (const auto& config_pair : queue_with_config.audio_configs) {
+    if (config_pair.second.IsValidConfig()) {
+      media_tracks->AddAudioTrack(config_pair.second, config_pair.first,
+                                  "main", labels[config_pair.first], "");
+    }
   }
-  if (video_config.IsValidConfig()) {
-    media_tracks->AddVideoTrack(video_config, kMp2tVideoTrackId, "main", "",
-                                "");
+  for (const auto& config_pair : queue_with_config.video_configs) {
+    if (config_pair.second.IsValidConfig()) {
+      media_tracks->AddVideoTrack(config_pair.second, config_pair.first,
+                                  "main", labels[config_pair.first], "");
+    }
   }
   return media_tracks;
 }
 
+bool Mp2tStreamParser::HasAllConfigs(
+    const BufferQueueWithConfig& queue_with_config) const {
+  for (const auto& pid_pair : selected_audio_pids_) {
+    if (!HasValidConfig(queue_with_config.audio_configs, pid_pair.second))
+      return false;
+  }
+  for (const auto& pid_pair : selected_video_pids_) {
+    if (!HasValidConfig(queue_with_config.video_configs, pid_pair.second))
+      return false;
+  }
+  return true;
+}
+
 bool Mp2tStreamParser::FinishInitializationIfNeeded() {
   // Nothing to be done if already initialized.
   if (is_initialized_)
@@ -602,30 +722,25 @@ bool Mp2tStreamParser::FinishInitializationIfNeeded() {
 
   // Wait for more data to come if one of the config is not available.
   BufferQueueWithConfig& queue_with_config = buffer_queue_chain_.front();
-  if (selected_audio_pid_ > 0 &&
-      !queue_with_config.audio_config.IsValidConfig())
-    return true;
-  if (selected_video_pid_ > 0 &&
-      !queue_with_config.video_config.IsValidConfig())
+  if (!HasAllConfigs(queue_with_config))
     return true;
 
   // Pass the config before invoking the initialization callback.
-  std::unique_ptr<MediaTracks> media_tracks = GenerateMediaTrackInfo(
-      queue_with_config.audio_config, queue_with_config.video_config);
-  RCHECK(config_cb_.Run(std::move(media_tracks), TextTrackConfigMap()));
+  RCHECK(config_cb_.Run(GenerateMediaTrackInfo(queue_with_config),
+                        TextTrackConfigMap()));
   queue_with_config.is_config_sent = true;
 
   // For Mpeg2 TS, the duration is not known.
   DVLOG(1) << "Mpeg2TS stream parser initialization done";
 
   // TODO(wolenetz): If possible, detect and report track counts by type more
-  // accurately here. Currently, capped at max 1 each for audio and video, with
-  // assumption of 0 text tracks.
+  // accurately here. Currently, capped at max 1 each for audio and video
+  // unless outputting all programs, with assumption of 0 text tracks.
   InitParameters params(kInfiniteDuration);
   params.detected_audio_track_count =
-      queue_with_config.audio_config.IsValidConfig() ? 1 : 0;
+      static_cast<int>(queue_with_config.audio_configs.size());
   params.detected_video_track_count =
-      queue_with_config.video_config.IsValidConfig() ? 1 : 0;
+      static_cast<int>(queue_with_config.video_configs.size());
   base::ResetAndReturn(&init_cb_).Run(params);
   is_initialized_ = true;
 
@@ -635,7 +750,11 @@ bool Mp2tStreamParser::FinishInitializationIfNeeded() {
 void Mp2tStreamParser::OnEmitAudioBuffer(
     int pes_pid,
     scoped_refptr<StreamParserBuffer> stream_parser_buffer) {
-  DCHECK_EQ(pes_pid, selected_audio_pid_);
+  auto selected_it = selected_audio_pids_.find(pes_pid);
+  if (selected_it == selected_audio_pids_.end()) {
+    NOTREACHED() << "Buffer for an unselected audio pid: " << pes_pid;
+    return;
+  }
 
   DVLOG(LOG_LEVEL_ES)
       << "OnEmitAudioBuffer: "
@@ -654,13 +773,18 @@ void Mp2tStreamParser::OnEmitAudioBuffer(
     return;
   }
 
-  buffer_queue_chain_.back().audio_queue.push_back(stream_parser_buffer);
+  buffer_queue_chain_.back().buffer_queues[selected_it->second].push_back(
+      stream_parser_buffer);
 }
 
 void Mp2tStreamParser::OnEmitVideoBuffer(
     int pes_pid,
     scoped_refptr<StreamParserBuffer> stream_parser_buffer) {
-  DCHECK_EQ(pes_pid, selected_video_pid_);
+  auto selected_it = selected_video_pids_.find(pes_pid);
+  if (selected_it == selected_video_pids_.end()) {
+    NOTREACHED() << "Buffer for an unselected video pid: " << pes_pid;
+    return;
+  }
 
   DVLOG(LOG_LEVEL_ES)
       << "OnEmitVideoBuffer"
@@ -681,7 +805,8 @@ void Mp2tStreamParser::OnEmitVideoBuffer(
     return;
   }
 
-  buffer_queue_chain_.back().video_queue.push_back(stream_parser_buffer);
+  buffer_queue_chain_.back().buffer_queues[selected_it->second].push_back(
+      stream_parser_buffer);
 }
 
 bool Mp2tStreamParser::EmitRemainingBuffers() {
@@ -694,18 +819,14 @@ bool Mp2tStreamParser::EmitRemainingBuffers() {
   if (buffer_queue_chain_.empty())
     return true;
 
-  // Keep track of the last audio and video config sent.
-  AudioDecoderConfig last_audio_config =
-      buffer_queue_chain_.back().audio_config;
-  VideoDecoderConfig last_video_config =
-      buffer_queue_chain_.back().video_config;
-
   // Do not have all the configs, need more data.
-  if (selected_audio_pid_ >= 0 && !last_audio_config.IsValidConfig())
-    return true;
-  if (selected_video_pid_ >= 0 && !last_video_config.IsValidConfig())
+  if (!HasAllConfigs(buffer_queue_chain_.back()))
     return true;
 
+  // Keep track of the last audio and video configs sent.
+  AudioConfigMap last_audio_configs = buffer_queue_chain_.back().audio_configs;
+  VideoConfigMap last_video_configs = buffer_queue_chain_.back().video_configs;
+
   // Buffer emission.
   while (!buffer_queue_chain_.empty()) {
     // Start a segment if needed.
@@ -718,23 +839,15 @@ bool Mp2tStreamParser::EmitRemainingBuffers() {
     // Update the audio and video config if needed.
     BufferQueueWithConfig& queue_with_config = buffer_queue_chain_.front();
     if (!queue_with_config.is_config_sent) {
-      std::unique_ptr<MediaTracks> media_tracks = GenerateMediaTrackInfo(
-          queue_with_config.audio_config, queue_with_config.video_config);
-      if (!config_cb_.Run(std::move(media_tracks), TextTrackConfigMap()))
+      if (!config_cb_.Run(GenerateMediaTrackInfo(queue_with_config),
+                          TextTrackConfigMap()))
         return false;
       queue_with_config.is_config_sent = true;
     }
 
     // Add buffers.
-    BufferQueueMap buffer_queue_map;
-    if (!queue_with_config.audio_queue.empty())
-      buffer_queue_map.insert(
-          std::make_pair(kMp2tAudioTrackId, queue_with_config.audio_queue));
-    if (!queue_with_config.video_queue.empty())
-      buffer_queue_map.insert(
-          std::make_pair(kMp2tVideoTrackId, queue_with_config.video_queue));
-
-    if (!buffer_queue_map.empty() && !new_buffers_cb_.Run(buffer_queue_map))
+    if (!queue_with_config.buffer_queues.empty() &&
+        !new_buffers_cb_.Run(queue_with_config.buffer_queues))
       return false;
 
     buffer_queue_chain_.pop_front();
@@ -743,7 +856,7 @@ bool Mp2tStreamParser::EmitRemainingBuffers() {
   // Push an empty queue with the last audio/video config
   // so that buffers with the same config can be added later on.
   BufferQueueWithConfig queue_with_config(
-      true, last_audio_config, last_video_config);
+      true, last_audio_configs, last_video_configs);
   buffer_queue_chain_.push_back(queue_with_config);
 
   return true;
@@ -10,6 +10,7 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <set>
 
 #include "base/macros.h"
 #include "base/memory/ref_counted.h"
@@ -25,18 +26,30 @@
 namespace media {
 
 class DecryptConfig;
+class MediaTracks;
 class StreamParserBuffer;
 
 namespace mp2t {
 
 class Descriptors;
 class PidState;
+class TsPacket;
 
 class MEDIA_EXPORT Mp2tStreamParser : public StreamParser {
  public:
   explicit Mp2tStreamParser(bool sbr_in_mimetype);
   ~Mp2tStreamParser() override;
 
+  // By default only the audio and video elementary streams with the lowest
+  // PIDs of the first program are output, since MSE supports a single program
+  // with one track of each type. This instead outputs every supported audio
+  // and video elementary stream of every program in the PAT, each as its own
+  // track whose bytestream track ID is its PID and whose label is its program
+  // number. If |pid_allow_list| isn't empty, only the elementary streams with
+  // those PIDs are output; the packets of all other PES PIDs are dropped as
+  // soon as their TS header has been parsed. Must be called before Parse().
+  void EnableMultiProgramOutput(const std::set<int>& pid_allow_list);
+
   // StreamParser implementation.
   void Init(const InitCB& init_cb,
             const NewConfigCB& config_cb,
@@ -50,20 +63,30 @@ class MEDIA_EXPORT Mp2tStreamParser : public StreamParser {
   bool Parse(const uint8_t* buf, int size) override;
 
  private:
+  typedef std::map<TrackId, AudioDecoderConfig> AudioConfigMap;
+  typedef std::map<TrackId, VideoDecoderConfig> VideoConfigMap;
+
   struct BufferQueueWithConfig {
     BufferQueueWithConfig(bool is_cfg_sent,
-                          const AudioDecoderConfig& audio_cfg,
-                          const VideoDecoderConfig& video_cfg);
+                          const AudioConfigMap& audio_cfgs,
+                          const VideoConfigMap& video_cfgs);
     BufferQueueWithConfig(const BufferQueueWithConfig& other);
     ~BufferQueueWithConfig();
 
     bool is_config_sent;
-    AudioDecoderConfig audio_config;
-    StreamParser::BufferQueue audio_queue;
-    VideoDecoderConfig video_config;
-    StreamParser::BufferQueue video_queue;
+    AudioConfigMap audio_configs;
+    VideoConfigMap video_configs;
+    StreamParser::BufferQueueMap buffer_queues;
   };
 
+  // Hands the payloads of |count| consecutive |ts_packets| to the section
+  // parsers of their PIDs. Returns false if parsing failed.
+  bool ProcessTsPackets(const TsPacket* ts_packets, int count);
+
+  // Returns the state of |pid|, creating it if |pid| is one which may appear
+  // before being registered, or NULL if |pid| is unknown.
+  PidState* GetOrCreatePidState(int pid);
+
   // Callback invoked to register a Program Map Table.
   // Note: Does nothing if the PID is already registered.
   void RegisterPmt(int program_number, int pmt_pid);
@@ -80,7 +103,8 @@ class MEDIA_EXPORT Mp2tStreamParser : public StreamParser {
 
   // Since the StreamParser interface allows only one audio & video streams,
   // an automatic PID filtering should be applied to select the audio & video
-  // streams.
+  // streams. Not used for multi-program output, which selects every PES PID
+  // as soon as it is registered.
   void UpdatePidFilter();
 
   // Callback invoked each time the audio/video decoder configuration is
@@ -90,6 +114,14 @@ class MEDIA_EXPORT Mp2tStreamParser : public StreamParser {
   void OnAudioConfigChanged(int pes_pid,
                             const AudioDecoderConfig& audio_decoder_config);
 
+  // Returns the tracks described by the configs of |queue_with_config|.
+  std::unique_ptr<MediaTracks> GenerateMediaTrackInfo(
+      const BufferQueueWithConfig& queue_with_config) const;
+
+  // Returns true if |queue_with_config| has a valid config for every
+  // selected track.
+  bool HasAllConfigs(const BufferQueueWithConfig& queue_with_config) const;
+
   // Invoke the initialization callback if needed.
   bool FinishInitializationIfNeeded();
 
@@ -136,12 +168,22 @@ class MEDIA_EXPORT Mp2tStreamParser : public StreamParser {
   // Bytes of the TS stream.
   ByteQueue ts_byte_queue_;
 
+  // Whether EnableMultiProgramOutput() was called, and the PES PIDs it
+  // allowed (all of them if empty).
+  bool multi_program_output_;
+  std::set<int> pid_allow_list_;
+
   // List of PIDs and their state.
   std::map<int, std::unique_ptr<PidState>> pids_;
 
-  // Selected audio and video PIDs.
-  int selected_audio_pid_;
-  int selected_video_pid_;
+  // Program numbers of the registered PMT PIDs, and the PMT PID of each
+  // registered PES PID.
+  std::map<int, int> program_numbers_;
+  std::map<int, int> pes_pmt_pids_;
+
+  // Selected audio and video PES PIDs, and the track IDs they are output as.
+  std::map<int, TrackId> selected_audio_pids_;
+  std::map<int, TrackId> selected_video_pids_;
 
   // Pending audio & video buffers.
   std::list<BufferQueueWithConfig> buffer_queue_chain_;
@@ -152,10 +194,11 @@ class MEDIA_EXPORT Mp2tStreamParser : public StreamParser {
   // Indicate whether a segment was started.
   bool segment_started_;
 
-  // Timestamp unroller.
+  // Timestamp unrollers, indexed by PMT PID.
   // Timestamps in PES packets must be unrolled using the same offset.
-  // So the unroller is global between PES pids.
-  TimestampUnroller timestamp_unroller_;
+  // So the unroller is shared between the PES pids of a program; different
+  // programs may use unrelated clocks.
+  std::map<int, std::unique_ptr<TimestampUnroller>> timestamp_unrollers_;
 
 #if BUILDFLAG(ENABLE_HLS_SAMPLE_AES)
   std::unique_ptr<DecryptConfig> decrypt_config_;
@@ -0,0 +1,117 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted.h"
+#include "base/time/time.h"
+#include "media/base/decoder_buffer.h"
+#include "media/base/media_log.h"
+#include "media/base/media_tracks.h"
+#include "media/base/stream_parser_buffer.h"
+#include "media/base/test_data_util.h"
+#include "media/formats/mp2t/mp2t_stream_parser.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+
+namespace media {
+namespace mp2t {
+
+// The stream is parsed until at least this many bytes have been processed.
+static const double kBenchmarkBytes = 256.0 * 1024 * 1024;
+
+static const int kTsPacketSize = 188;
+
+class Mp2tStreamParserPerfTest : public testing::Test {
+ public:
+  Mp2tStreamParserPerfTest() : parser_(new Mp2tStreamParser(false)) {
+    parser_->Init(
+        base::Bind(&Mp2tStreamParserPerfTest::OnInit, base::Unretained(this)),
+        base::Bind(&Mp2tStreamParserPerfTest::OnNewConfig,
+                   base::Unretained(this)),
+        base::Bind(&Mp2tStreamParserPerfTest::OnNewBuffers,
+                   base::Unretained(this)),
+        true,
+        base::Bind(&Mp2tStreamParserPerfTest::OnKeyNeeded,
+                   base::Unretained(this)),
+        base::Bind(&Mp2tStreamParserPerfTest::OnNewSegment,
+                   base::Unretained(this)),
+        base::Bind(&Mp2tStreamParserPerfTest::OnEndOfSegment,
+                   base::Unretained(this)),
+        new MediaLog());
+  }
+
+  // Appends |filename| to the parser in |append_size| byte pieces, flushing
+  // after each pass over the file, and reports the demux throughput in TS
+  // packets per second.
+  void RunParseBenchmark(const std::string& filename,
+                         size_t append_size,
+                         const std::string& trace_name) {
+    scoped_refptr<DecoderBuffer> stream = ReadTestDataFile(filename);
+    const uint8_t* const data = stream->data();
+    const size_t size = stream->data_size();
+
+    buffer_count_ = 0;
+    double total_bytes = 0;
+    base::TimeTicks start = base::TimeTicks::Now();
+    while (total_bytes < kBenchmarkBytes) {
+      for (size_t offset = 0; offset < size; offset += append_size) {
+        ASSERT_TRUE(parser_->Parse(data + offset,
+                                   std::min(append_size, size - offset)));
+      }
+      parser_->Flush();
+      total_bytes += size;
+    }
+    const double total_time_seconds =
+        (base::TimeTicks::Now() - start).InSecondsF();
+
+    EXPECT_GT(buffer_count_, 0u);
+    perf_test::PrintResult(
+        "mp2t_stream_parser_parse", "", trace_name,
+        total_bytes / kTsPacketSize / total_time_seconds, "packets/s", true);
+  }
+
+ private:
+  void OnInit(const StreamParser::InitParameters& params) {}
+
+  bool OnNewConfig(std::unique_ptr<MediaTracks> tracks,
+                   const StreamParser::TextTrackConfigMap& tc) {
+    return true;
+  }
+
+  bool OnNewBuffers(const StreamParser::BufferQueueMap& buffer_queue_map) {
+    for (const auto& it : buffer_queue_map)
+      buffer_count_ += it.second.size();
+    return true;
+  }
+
+  void OnKeyNeeded(EmeInitDataType type,
+                   const std::vector<uint8_t>& init_data) {}
+  void OnNewSegment() {}
+  void OnEndOfSegment() {}
+
+  std::unique_ptr<Mp2tStreamParser> parser_;
+  size_t buffer_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(Mp2tStreamParserPerfTest);
+};
+
+// Small appends exercise the partial-packet carry-over between Parse() calls;
+// large ones are the common case for segmented streams and keep whole batches
+// of packets available to the parser.
+TEST_F(Mp2tStreamParserPerfTest, Parse) {
+  RunParseBenchmark("bear-1280x720.ts", 4 * 1024, "append_4KB");
+  RunParseBenchmark("bear-1280x720.ts", 256 * 1024, "append_256KB");
+}
+
+}  // namespace mp2t
+}  // namespace media
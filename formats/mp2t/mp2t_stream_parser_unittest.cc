@@ -6,10 +6,14 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <algorithm>
+#include <map>
 #include <memory>
+#include <set>
 #include <string>
+#include <vector>
 
 #include "base/bind.h"
 #include "base/bind_helpers.h"
@@ -150,6 +154,115 @@ std::string DecryptBuffer(const StreamParserBuffer& buffer,
 }
 #endif
 
+const int kTsPacketSize = 188;
+
+// PIDs of bear-1280x720.ts.
+const int kBearPmtPid = 0x1000;
+const int kBearVideoPid = 0x100;
+const int kBearAudioPid = 0x101;
+
+// Offset between the PIDs of the first and second programs of the stream
+// built by MakeTwoProgramStream().
+const int kSecondProgramPidOffset = 0x10;
+
+int GetPid(const uint8_t* packet) {
+  return ((packet[1] & 0x1f) << 8) | packet[2];
+}
+
+// Moves the 13 bit PID at |pid_bytes| |kSecondProgramPidOffset| higher.
+void ShiftPid(uint8_t* pid_bytes) {
+  const int pid =
+      (((pid_bytes[0] & 0x1f) << 8) | pid_bytes[1]) + kSecondProgramPidOffset;
+  pid_bytes[0] = (pid_bytes[0] & 0xe0) | (pid >> 8);
+  pid_bytes[1] = pid & 0xff;
+}
+
+// Returns the PSI section starting in |packet|, which must have its
+// payload_unit_start_indicator set.
+uint8_t* GetPsiSection(uint8_t* packet) {
+  EXPECT_TRUE(packet[1] & 0x40);
+  int offset = 4;
+  if (packet[3] & 0x20)
+    offset += 1 + packet[4];
+  // Skip the pointer field.
+  return packet + offset + 1 + packet[offset];
+}
+
+int GetSectionLength(const uint8_t* section) {
+  return ((section[1] & 0x0f) << 8) | section[2];
+}
+
+// Recomputes the CRC_32 at the end of |section|.
+void UpdatePsiCrc(uint8_t* section) {
+  const int crc_offset = 3 + GetSectionLength(section) - 4;
+  uint32_t crc = 0xffffffffu;
+  for (int i = 0; i < crc_offset; i++) {
+    crc ^= static_cast<uint32_t>(section[i]) << 24;
+    for (int k = 0; k < 8; k++)
+      crc = (crc & 0x80000000u) ? (crc << 1) ^ 0x04c11db7u : crc << 1;
+  }
+  for (int i = 0; i < 4; i++)
+    section[crc_offset + i] = crc >> (24 - 8 * i);
+}
+
+// Replaces the single program of the PAT in |packet| with programs 1 and 2,
+// whose PMTs are on |kBearPmtPid| and the PID |kSecondProgramPidOffset|
+// above it.
+void AddSecondProgramToPat(uint8_t* packet) {
+  uint8_t* section = GetPsiSection(packet);
+  ASSERT_EQ(13, GetSectionLength(section));
+  const int second_pmt_pid = kBearPmtPid + kSecondProgramPidOffset;
+  const uint8_t program[] = {0x00, 0x02,
+                             static_cast<uint8_t>(0xe0 | second_pmt_pid >> 8),
+                             static_cast<uint8_t>(second_pmt_pid & 0xff)};
+  ASSERT_LE(section + 3 + 17, packet + kTsPacketSize);
+  // Insert the new program over the old CRC, which moves 4 bytes later.
+  memcpy(section + 12, program, sizeof(program));
+  section[2] = 17;
+  UpdatePsiCrc(section);
+}
+
+// Makes the PMT in |packet| that of program 2, with the PCR and elementary
+// stream PIDs moved |kSecondProgramPidOffset| higher.
+void MakeSecondProgramPmt(uint8_t* packet) {
+  uint8_t* section = GetPsiSection(packet);
+  section[4] = 0x02;
+  ShiftPid(section + 8);
+  const int program_info_length = ((section[10] & 0x0f) << 8) | section[11];
+  const int es_loop_end = 3 + GetSectionLength(section) - 4;
+  for (int pos = 12 + program_info_length; pos < es_loop_end;) {
+    ShiftPid(section + pos + 1);
+    pos += 5 + (((section[pos + 3] & 0x0f) << 8) | section[pos + 4]);
+  }
+  UpdatePsiCrc(section);
+}
+
+// Turns bear-1280x720.ts into a two program stream, where the second program
+// is a copy of the first on PIDs |kSecondProgramPidOffset| higher. Packets of
+// the second program follow those of the first which they copy.
+std::vector<uint8_t> MakeTwoProgramStream(const uint8_t* data, size_t size) {
+  std::vector<uint8_t> stream;
+  for (size_t offset = 0; offset + kTsPacketSize <= size;
+       offset += kTsPacketSize) {
+    const uint8_t* packet = data + offset;
+    const int pid = GetPid(packet);
+    stream.insert(stream.end(), packet, packet + kTsPacketSize);
+    if (pid == 0) {
+      AddSecondProgramToPat(&stream[stream.size() - kTsPacketSize]);
+      continue;
+    }
+    if (pid != kBearPmtPid && pid != kBearVideoPid && pid != kBearAudioPid)
+      continue;
+
+    stream.insert(stream.end(), packet, packet + kTsPacketSize);
+    uint8_t* copy = &stream[stream.size() - kTsPacketSize];
+    ShiftPid(copy + 1);
+    if (pid == kBearPmtPid)
+      MakeSecondProgramPmt(copy);
+  }
+  return stream;
+}
+
 }  // namespace
 
 class Mp2tStreamParserTest : public testing::Test {
@@ -193,6 +306,10 @@ class Mp2tStreamParserTest : public testing::Test {
   std::vector<scoped_refptr<StreamParserBuffer>> video_buffer_capture_;
   bool capture_buffers;
 
+  // Labels of all the tracks and number of buffers received for each of them.
+  std::map<StreamParser::TrackId, std::string> track_labels_;
+  std::map<StreamParser::TrackId, int> track_buffer_counts_;
+
   void ResetStats() {
     segment_count_ = 0;
     config_count_ = 0;
@@ -235,6 +352,7 @@ class Mp2tStreamParserTest : public testing::Test {
     bool found_video_track = false;
     for (const auto& track : tracks->tracks()) {
       const auto& track_id = track->bytestream_track_id();
+      track_labels_[track_id] = track->label();
       if (track->type() == MediaTrack::Audio) {
         audio_track_id_ = track_id;
         found_audio_track = true;
@@ -274,6 +392,7 @@ class Mp2tStreamParserTest : public testing::Test {
     // Ensure that track ids are properly assigned on all emitted buffers.
     for (const auto& it : buffer_queue_map) {
       DVLOG(3) << "Buffers for track_id=" << it.first;
+      track_buffer_counts_[it.first] += it.second.size();
       for (const auto& buf : it.second) {
         DVLOG(3) << "  track_id=" << buf->track_id()
                  << ", size=" << buf->data_size()
@@ -453,6 +572,68 @@ TEST_F(Mp2tStreamParserTest, AudioInPrivateStream1) {
   EXPECT_EQ(segment_count_, 1);
 }
 
+TEST_F(Mp2tStreamParserTest, MultiProgramOutputSingleProgram) {
+  // Tracks are identified by their PIDs rather than by type.
+  parser_->EnableMultiProgramOutput(std::set<int>());
+  InitializeParser();
+  ParseMpeg2TsFile("bear-1280x720.ts", 512);
+  parser_->Flush();
+  EXPECT_EQ(kBearAudioPid, audio_track_id_);
+  EXPECT_EQ(kBearVideoPid, video_track_id_);
+  EXPECT_EQ(video_frame_count_, 82);
+  EXPECT_EQ("1", track_labels_[kBearAudioPid]);
+  EXPECT_EQ("1", track_labels_[kBearVideoPid]);
+  EXPECT_EQ(config_count_, 1);
+  EXPECT_EQ(segment_count_, 1);
+}
+
+TEST_F(Mp2tStreamParserTest, MultiProgramOutput) {
+  parser_->EnableMultiProgramOutput(std::set<int>());
+  InitializeParser();
+  scoped_refptr<DecoderBuffer> buffer = ReadTestDataFile("bear-1280x720.ts");
+  std::vector<uint8_t> stream =
+      MakeTwoProgramStream(buffer->data(), buffer->data_size());
+  EXPECT_TRUE(AppendDataInPieces(stream.data(), stream.size(), 512));
+  parser_->Flush();
+
+  // Every stream of both programs is output.
+  const int second_audio_pid = kBearAudioPid + kSecondProgramPidOffset;
+  const int second_video_pid = kBearVideoPid + kSecondProgramPidOffset;
+  EXPECT_EQ(4u, track_labels_.size());
+  EXPECT_EQ("1", track_labels_[kBearAudioPid]);
+  EXPECT_EQ("1", track_labels_[kBearVideoPid]);
+  EXPECT_EQ("2", track_labels_[second_audio_pid]);
+  EXPECT_EQ("2", track_labels_[second_video_pid]);
+  EXPECT_EQ(82, track_buffer_counts_[kBearVideoPid]);
+  EXPECT_EQ(82, track_buffer_counts_[second_video_pid]);
+  EXPECT_GT(track_buffer_counts_[kBearAudioPid], 0);
+  EXPECT_EQ(track_buffer_counts_[kBearAudioPid],
+            track_buffer_counts_[second_audio_pid]);
+  EXPECT_EQ(config_count_, 1);
+}
+
+TEST_F(Mp2tStreamParserTest, MultiProgramOutputWithPidAllowList) {
+  const int second_audio_pid = kBearAudioPid + kSecondProgramPidOffset;
+  std::set<int> pid_allow_list;
+  pid_allow_list.insert(kBearVideoPid);
+  pid_allow_list.insert(second_audio_pid);
+  parser_->EnableMultiProgramOutput(pid_allow_list);
+  InitializeParser();
+  scoped_refptr<DecoderBuffer> buffer = ReadTestDataFile("bear-1280x720.ts");
+  std::vector<uint8_t> stream =
+      MakeTwoProgramStream(buffer->data(), buffer->data_size());
+  EXPECT_TRUE(AppendDataInPieces(stream.data(), stream.size(), 512));
+  parser_->Flush();
+
+  // Only the allowed streams are output, whichever program they are part of.
+  EXPECT_EQ(2u, track_labels_.size());
+  EXPECT_EQ("1", track_labels_[kBearVideoPid]);
+  EXPECT_EQ("2", track_labels_[second_audio_pid]);
+  EXPECT_EQ(82, track_buffer_counts_[kBearVideoPid]);
+  EXPECT_GT(track_buffer_counts_[second_audio_pid], 0);
+  EXPECT_EQ(2u, track_buffer_counts_.size());
+}
+
 #if BUILDFLAG(ENABLE_HLS_SAMPLE_AES)
 TEST_F(Mp2tStreamParserTest, HLSSampleAES) {
   std::vector<std::string> decrypted_video_buffers;
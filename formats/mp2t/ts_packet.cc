@@ -4,9 +4,8 @@
 
 #include "media/formats/mp2t/ts_packet.h"
 
-#include <memory>
+#include <algorithm>
 
-#include "media/base/bit_reader.h"
 #include "media/formats/mp2t/mp2t_common.h"
 
 namespace media {
@@ -44,11 +43,26 @@ int TsPacket::Sync(const uint8_t* buf, int size) {
 }
 
 // static
-TsPacket* TsPacket::Parse(const uint8_t* buf, int size) {
+int TsPacket::CountSyncedPackets(const uint8_t* buf, int size) {
+  DCHECK_EQ(Sync(buf, size), 0);
+
+  // Sync() accepts a packet when it and the (up to) three packets after it
+  // start with a syncword, so a packet is only synchronized if it's more than
+  // three packets before the first missing syncword.
+  const int num_packets = size / kPacketSize;
+  for (int k = 0, idx = 0; idx < size; k++, idx += kPacketSize) {
+    if (buf[idx] != kTsHeaderSyncword)
+      return std::min(num_packets, k - 3);
+  }
+  return num_packets;
+}
+
+// static
+bool TsPacket::Parse(const uint8_t* buf, int size, TsPacket* ts_packet) {
   if (size < kPacketSize) {
     DVLOG(1) << "Buffer does not hold one full TS packet:"
              << " buffer_size=" << size;
-    return NULL;
+    return false;
   }
 
   DCHECK_EQ(buf[0], kTsHeaderSyncword);
@@ -56,47 +70,41 @@ TsPacket* TsPacket::Parse(const uint8_t* buf, int size) {
     DVLOG(1) << "Not on a TS syncword:"
              << " buf[0]="
              << std::hex << static_cast<int>(buf[0]) << std::dec;
-    return NULL;
+    return false;
   }
 
-  std::unique_ptr<TsPacket> ts_packet(new TsPacket());
-  bool status = ts_packet->ParseHeader(buf);
-  if (!status) {
+  if (!ts_packet->ParseHeader(buf)) {
     DVLOG(1) << "Parsing header failed";
-    return NULL;
+    return false;
   }
-  return ts_packet.release();
+  return true;
 }
 
-TsPacket::TsPacket() {
-}
-
-TsPacket::~TsPacket() {
-}
+TsPacket::TsPacket()
+    : payload_(NULL),
+      payload_size_(0),
+      payload_unit_start_indicator_(false),
+      pid_(0),
+      continuity_counter_(0),
+      discontinuity_indicator_(false),
+      random_access_indicator_(false) {}
 
 bool TsPacket::ParseHeader(const uint8_t* buf) {
-  BitReader bit_reader(buf, kPacketSize);
-  payload_ = buf;
-  payload_size_ = kPacketSize;
-
   // Read the TS header: 4 bytes.
-  int syncword;
-  int transport_error_indicator;
-  int payload_unit_start_indicator;
-  int transport_priority;
-  int transport_scrambling_control;
-  int adaptation_field_control;
-  RCHECK(bit_reader.ReadBits(8, &syncword));
-  RCHECK(bit_reader.ReadBits(1, &transport_error_indicator));
-  RCHECK(bit_reader.ReadBits(1, &payload_unit_start_indicator));
-  RCHECK(bit_reader.ReadBits(1, &transport_priority));
-  RCHECK(bit_reader.ReadBits(13, &pid_));
-  RCHECK(bit_reader.ReadBits(2, &transport_scrambling_control));
-  RCHECK(bit_reader.ReadBits(2, &adaptation_field_control));
-  RCHECK(bit_reader.ReadBits(4, &continuity_counter_));
-  payload_unit_start_indicator_ = (payload_unit_start_indicator != 0);
-  payload_ += 4;
-  payload_size_ -= 4;
+  //   syncword                      8
+  //   transport_error_indicator     1
+  //   payload_unit_start_indicator  1
+  //   transport_priority            1
+  //   PID                          13
+  //   transport_scrambling_control  2
+  //   adaptation_field_control      2
+  //   continuity_counter            4
+  payload_unit_start_indicator_ = (buf[1] & 0x40) != 0;
+  pid_ = ((buf[1] & 0x1f) << 8) | buf[2];
+  const int adaptation_field_control = (buf[3] >> 4) & 0x3;
+  continuity_counter_ = buf[3] & 0xf;
+  payload_ = buf + 4;
+  payload_size_ = kPacketSize - 4;
 
   // Default values when no adaptation field.
   discontinuity_indicator_ = false;
@@ -107,8 +115,7 @@ bool TsPacket::ParseHeader(const uint8_t* buf) {
     return true;
 
   // Read the adaptation field if needed.
-  int adaptation_field_length;
-  RCHECK(bit_reader.ReadBits(8, &adaptation_field_length));
+  const int adaptation_field_length = buf[4];
   DVLOG(LOG_LEVEL_TS) << "adaptation_field_length=" << adaptation_field_length;
   payload_ += 1;
   payload_size_ -= 1;
@@ -131,86 +138,66 @@ bool TsPacket::ParseHeader(const uint8_t* buf) {
   if (adaptation_field_length == 0)
     return true;
 
-  bool status = ParseAdaptationField(&bit_reader, adaptation_field_length);
+  bool status = ParseAdaptationField(payload_, adaptation_field_length);
   payload_ += adaptation_field_length;
   payload_size_ -= adaptation_field_length;
   return status;
 }
 
-bool TsPacket::ParseAdaptationField(BitReader* bit_reader,
+bool TsPacket::ParseAdaptationField(const uint8_t* buf,
                                     int adaptation_field_length) {
   DCHECK_GT(adaptation_field_length, 0);
-  int adaptation_field_start_marker = bit_reader->bits_available() / 8;
-
-  int discontinuity_indicator;
-  int random_access_indicator;
-  int elementary_stream_priority_indicator;
-  int pcr_flag;
-  int opcr_flag;
-  int splicing_point_flag;
-  int transport_private_data_flag;
-  int adaptation_field_extension_flag;
-  RCHECK(bit_reader->ReadBits(1, &discontinuity_indicator));
-  RCHECK(bit_reader->ReadBits(1, &random_access_indicator));
-  RCHECK(bit_reader->ReadBits(1, &elementary_stream_priority_indicator));
-  RCHECK(bit_reader->ReadBits(1, &pcr_flag));
-  RCHECK(bit_reader->ReadBits(1, &opcr_flag));
-  RCHECK(bit_reader->ReadBits(1, &splicing_point_flag));
-  RCHECK(bit_reader->ReadBits(1, &transport_private_data_flag));
-  RCHECK(bit_reader->ReadBits(1, &adaptation_field_extension_flag));
-  discontinuity_indicator_ = (discontinuity_indicator != 0);
-  random_access_indicator_ = (random_access_indicator != 0);
-
-  if (pcr_flag) {
-    int64_t program_clock_reference_base;
-    int reserved;
-    int program_clock_reference_extension;
-    RCHECK(bit_reader->ReadBits(33, &program_clock_reference_base));
-    RCHECK(bit_reader->ReadBits(6, &reserved));
-    RCHECK(bit_reader->ReadBits(9, &program_clock_reference_extension));
-  }
-
-  if (opcr_flag) {
-    int64_t original_program_clock_reference_base;
-    int reserved;
-    int original_program_clock_reference_extension;
-    RCHECK(bit_reader->ReadBits(33, &original_program_clock_reference_base));
-    RCHECK(bit_reader->ReadBits(6, &reserved));
-    RCHECK(
-        bit_reader->ReadBits(9, &original_program_clock_reference_extension));
-  }
 
-  if (splicing_point_flag) {
-    int splice_countdown;
-    RCHECK(bit_reader->ReadBits(8, &splice_countdown));
+  // The length was checked against the packet size by the caller, so only
+  // reads past the end of the adaptation field need checking.
+  //   discontinuity_indicator               1
+  //   random_access_indicator               1
+  //   elementary_stream_priority_indicator  1
+  //   PCR_flag                              1
+  //   OPCR_flag                             1
+  //   splicing_point_flag                   1
+  //   transport_private_data_flag           1
+  //   adaptation_field_extension_flag       1
+  const int flags = buf[0];
+  discontinuity_indicator_ = (flags & 0x80) != 0;
+  random_access_indicator_ = (flags & 0x40) != 0;
+  int offset = 1;
+
+  // program_clock_reference_base (33), reserved (6), and
+  // program_clock_reference_extension (9).
+  if (flags & 0x10)
+    offset += 6;
+
+  // The same for the original_program_clock_reference.
+  if (flags & 0x08)
+    offset += 6;
+
+  // splice_countdown.
+  if (flags & 0x04)
+    offset += 1;
+
+  if (flags & 0x02) {
+    RCHECK(offset < adaptation_field_length);
+    const int transport_private_data_length = buf[offset];
+    offset += 1 + transport_private_data_length;
   }
 
-  if (transport_private_data_flag) {
-    int transport_private_data_length;
-    RCHECK(bit_reader->ReadBits(8, &transport_private_data_length));
-    RCHECK(bit_reader->SkipBits(8 * transport_private_data_length));
-  }
-
-  if (adaptation_field_extension_flag) {
-    int adaptation_field_extension_length;
-    RCHECK(bit_reader->ReadBits(8, &adaptation_field_extension_length));
-    RCHECK(bit_reader->SkipBits(8 * adaptation_field_extension_length));
+  if (flags & 0x01) {
+    RCHECK(offset < adaptation_field_length);
+    const int adaptation_field_extension_length = buf[offset];
+    offset += 1 + adaptation_field_extension_length;
   }
 
   // The rest of the adaptation field should be stuffing bytes.
-  int adaptation_field_remaining_size = adaptation_field_length -
-      (adaptation_field_start_marker - bit_reader->bits_available() / 8);
-  RCHECK(adaptation_field_remaining_size >= 0);
-  for (int k = 0; k < adaptation_field_remaining_size; k++) {
-    int stuffing_byte;
-    RCHECK(bit_reader->ReadBits(8, &stuffing_byte));
-    // Unfortunately, a lot of streams exist in the field that do not fill
-    // the remaining of the adaptation field with the expected stuffing value:
-    // do not fail if that's the case.
-    DVLOG_IF(1, stuffing_byte != 0xff)
-        << "Stream not compliant: invalid stuffing byte "
-        << std::hex << stuffing_byte;
-  }
+  RCHECK(offset <= adaptation_field_length);
+  // Unfortunately, a lot of streams exist in the field that do not fill
+  // the remaining of the adaptation field with the expected stuffing value:
+  // do not fail if that's the case.
+  DVLOG_IF(1, std::any_of(buf + offset, buf + adaptation_field_length,
+                          [](uint8_t stuffing_byte) {
+                            return stuffing_byte != 0xff;
+                          }))
+      << "Stream not compliant: invalid stuffing byte";
 
   DVLOG(LOG_LEVEL_TS) << "random_access_indicator=" << random_access_indicator_;
   return true;
@@ -218,4 +205,3 @@ bool TsPacket::ParseAdaptationField(BitReader* bit_reader,
 
 }  // namespace mp2t
 }  // namespace media
-
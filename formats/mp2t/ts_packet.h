@@ -7,14 +7,12 @@
 
 #include <stdint.h>
 
-#include "base/macros.h"
-
 namespace media {
-
-class BitReader;
-
 namespace mp2t {
 
+// A parsed TS packet header. This is a plain value which refers to the
+// packet's payload in the input buffer, so packets can be parsed in batches
+// into arrays on the stack without allocating.
 class TsPacket {
  public:
   static const int kPacketSize = 188;
@@ -23,12 +21,16 @@ class TsPacket {
   // to be synchronized on a TS syncword.
   static int Sync(const uint8_t* buf, int size);
 
-  // Parse a TS packet.
-  // Return a TsPacket only when parsing was successful.
-  // Return NULL otherwise.
-  static TsPacket* Parse(const uint8_t* buf, int size);
+  // Return the number of whole packets at the start of |buf| which are
+  // synchronized, i.e. which Sync() would accept one after the other without
+  // skipping any bytes. |buf| must already be synchronized.
+  static int CountSyncedPackets(const uint8_t* buf, int size);
 
-  ~TsPacket();
+  // Parse a TS packet into |ts_packet|.
+  // Return true only when parsing was successful.
+  static bool Parse(const uint8_t* buf, int size, TsPacket* ts_packet);
+
+  TsPacket();
 
   // TS header accessors.
   bool payload_unit_start_indicator() const {
@@ -44,13 +46,12 @@ class TsPacket {
   int payload_size() const { return payload_size_; }
 
  private:
-  TsPacket();
-
   // Parse an Mpeg2 TS header.
   // The buffer size should be at least |kPacketSize|
   bool ParseHeader(const uint8_t* buf);
-  bool ParseAdaptationField(BitReader* bit_reader,
-                            int adaptation_field_length);
+
+  // Parse the |adaptation_field_length| bytes of adaptation field at |buf|.
+  bool ParseAdaptationField(const uint8_t* buf, int adaptation_field_length);
 
   // Size of the payload.
   const uint8_t* payload_;
@@ -64,8 +65,6 @@ class TsPacket {
   // Params from the adaptation field.
   bool discontinuity_indicator_;
   bool random_access_indicator_;
-
-  DISALLOW_COPY_AND_ASSIGN(TsPacket);
 };
 
 }  // namespace mp2t
@@ -13,8 +13,10 @@
 namespace media {
 namespace mp2t {
 
-TsSectionPat::TsSectionPat(const RegisterPmtCb& register_pmt_cb)
+TsSectionPat::TsSectionPat(const RegisterPmtCb& register_pmt_cb,
+                           bool allow_multiple_programs)
     : register_pmt_cb_(register_pmt_cb),
+      allow_multiple_programs_(allow_multiple_programs),
       version_number_(-1) {
 }
 
@@ -85,7 +87,7 @@ bool TsSectionPat::ParsePsiSection(BitReader* bit_reader) {
 
   // Both the MSE and the HLS spec specifies that TS streams should convey
   // exactly one program.
-  if (pmt_pid_count > 1) {
+  if (pmt_pid_count > 1 && !allow_multiple_programs_) {
     DVLOG(1) << "Multiple programs detected in the Mpeg2 TS stream";
     return false;
   }
@@ -103,9 +105,9 @@ bool TsSectionPat::ParsePsiSection(BitReader* bit_reader) {
     if (program_number_array[k] != 0) {
       // Program numbers different from 0 correspond to PMT.
       register_pmt_cb_.Run(program_number_array[k], pmt_pid_array[k]);
-      // Even if there are multiple programs, only one can be supported now.
       // HLS: "Transport Stream segments MUST contain a single MPEG-2 Program."
-      break;
+      if (!allow_multiple_programs_)
+        break;
     }
   }
   version_number_ = version_number;
@@ -18,7 +18,11 @@ class TsSectionPat : public TsSectionPsi {
   // RegisterPmtCb::Run(int program_number, int pmt_pid);
   typedef base::Callback<void(int, int)> RegisterPmtCb;
 
-  explicit TsSectionPat(const RegisterPmtCb& register_pmt_cb);
+  // Only the first program of the PAT is registered unless
+  // |allow_multiple_programs| is true; otherwise a PAT with several programs
+  // is an error, as both MSE and HLS require a single program.
+  TsSectionPat(const RegisterPmtCb& register_pmt_cb,
+               bool allow_multiple_programs);
   ~TsSectionPat() override;
 
   // TsSectionPsi implementation.
@@ -27,6 +31,7 @@ class TsSectionPat : public TsSectionPsi {
 
  private:
   RegisterPmtCb register_pmt_cb_;
+  const bool allow_multiple_programs_;
 
   // Parameters from the PAT.
   int version_number_;
@@ -184,7 +184,16 @@ ChannelLayout AAC::GetChannelLayout(bool sbr_in_mimetype) const {
 }
 
 bool AAC::ConvertEsdsToADTS(std::vector<uint8_t>* buffer) const {
-  size_t size = buffer->size() + kADTSHeaderMinSize;
+  uint8_t header[kADTSHeaderMinSize];
+  if (!WriteADTSHeader(buffer->size(), header))
+    return false;
+
+  buffer->insert(buffer->begin(), header, header + kADTSHeaderMinSize);
+  return true;
+}
+
+bool AAC::WriteADTSHeader(size_t frame_size, uint8_t* header) const {
+  size_t size = frame_size + kADTSHeaderMinSize;
 
   DCHECK(profile_ >= 1 && profile_ <= 4 && frequency_index_ != 0xf &&
          channel_config_ <= 7);
@@ -193,9 +202,7 @@ bool AAC::ConvertEsdsToADTS(std::vector<uint8_t>* buffer) const {
   if (size >= (1 << 13))
     return false;
 
-  std::vector<uint8_t>& adts = *buffer;
-
-  adts.insert(buffer->begin(), kADTSHeaderMinSize, 0);
+  uint8_t* adts = header;
   adts[0] = 0xff;
   adts[1] = 0xf1;
   adts[2] = ((profile_ - 1) << 6) + (frequency_index_ << 2) +
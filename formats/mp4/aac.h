@@ -5,6 +5,7 @@
 #ifndef MEDIA_FORMATS_MP4_AAC_H_
 #define MEDIA_FORMATS_MP4_AAC_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include <vector>
@@ -57,6 +58,11 @@ class MEDIA_EXPORT AAC {
   // unchanged.
   bool ConvertEsdsToADTS(std::vector<uint8_t>* buffer) const;
 
+  // Writes the ADTS header for a raw AAC frame of |frame_size| bytes into
+  // |header|, which must hold kADTSHeaderMinSize bytes. Returns false if the
+  // frame is too large for an ADTS header.
+  bool WriteADTSHeader(size_t frame_size, uint8_t* header) const;
+
 #if defined(OS_ANDROID)
   // Returns the codec specific data needed by android MediaCodec.
   std::vector<uint8_t> codec_specific_data() const {
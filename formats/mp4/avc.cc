@@ -4,6 +4,8 @@
 
 #include "media/formats/mp4/avc.h"
 
+#include <string.h>
+
 #include <algorithm>
 #include <memory>
 #include <utility>
@@ -20,6 +22,14 @@ namespace mp4 {
 static const uint8_t kAnnexBStartCode[] = {0, 0, 0, 1};
 static const int kAnnexBStartCodeSize = 4;
 
+// Reads the big-endian length of |length_size| bytes preceding a NALU.
+static size_t ReadNALULength(const uint8_t* data, int length_size) {
+  size_t nal_length = 0;
+  for (int i = 0; i < length_size; ++i)
+    nal_length = (nal_length << 8) + data[i];
+  return nal_length;
+}
+
 static bool ConvertAVCToAnnexBInPlaceForLengthSize4(std::vector<uint8_t>* buf) {
   const int kLengthSize = 4;
   size_t pos = 0;
@@ -175,6 +185,106 @@ bool AVC::ConvertConfigToAnnexB(const AVCDecoderConfigurationRecord& avc_config,
   return true;
 }
 
+// static
+bool AVC::GetAnnexBFrameSize(int length_size,
+                             const uint8_t* frame,
+                             size_t frame_size,
+                             size_t param_sets_size,
+                             size_t* annexb_size) {
+  RCHECK(length_size == 1 || length_size == 2 || length_size == 4);
+
+  size_t num_nalus = 0;
+  size_t pos = 0;
+  while (pos + length_size < frame_size) {
+    const size_t nal_length = ReadNALULength(frame + pos, length_size);
+    pos += length_size;
+
+    if (nal_length == 0) {
+      DVLOG(3) << "nal_length is 0";
+      return false;
+    }
+
+    RCHECK(nal_length <= frame_size - pos);
+    pos += nal_length;
+    ++num_nalus;
+  }
+  RCHECK(pos == frame_size);
+
+  *annexb_size = frame_size +
+                 num_nalus * (kAnnexBStartCodeSize - length_size) +
+                 param_sets_size;
+  return true;
+}
+
+// static
+bool AVC::WriteFrameAsAnnexB(int length_size,
+                             const uint8_t* frame,
+                             size_t frame_size,
+                             const uint8_t* param_sets,
+                             size_t param_sets_size,
+                             bool param_sets_after_first_nalu,
+                             uint8_t* output,
+                             size_t output_size,
+                             std::vector<SubsampleEntry>* subsamples) {
+  size_t annexb_size = 0;
+  RCHECK(GetAnnexBFrameSize(length_size, frame, frame_size, param_sets_size,
+                            &annexb_size));
+  RCHECK(annexb_size == output_size);
+
+  // Where each subsample ends in |frame|. The bytes added in front of a NALU
+  // are clear bytes of the subsample holding its length.
+  std::vector<size_t> subsample_ends;
+  if (subsamples) {
+    size_t subsample_end = 0;
+    for (const SubsampleEntry& subsample : *subsamples) {
+      subsample_end += subsample.clear_bytes + subsample.cypher_bytes;
+      subsample_ends.push_back(subsample_end);
+    }
+  }
+  size_t subsample_index = 0;
+
+  uint8_t* out = output;
+  bool param_sets_pending = param_sets_size > 0;
+  size_t pos = 0;
+  while (true) {
+    if (!subsample_ends.empty()) {
+      while (subsample_index + 1 < subsample_ends.size() &&
+             subsample_ends[subsample_index] <= pos) {
+        ++subsample_index;
+      }
+    }
+
+    if (param_sets_pending &&
+        (pos > 0 || !param_sets_after_first_nalu || pos == frame_size)) {
+      memcpy(out, param_sets, param_sets_size);
+      out += param_sets_size;
+      if (!subsample_ends.empty())
+        (*subsamples)[subsample_index].clear_bytes += param_sets_size;
+      param_sets_pending = false;
+    }
+
+    if (pos == frame_size)
+      break;
+
+    const size_t nal_length = ReadNALULength(frame + pos, length_size);
+    pos += length_size;
+    memcpy(out, kAnnexBStartCode, kAnnexBStartCodeSize);
+    out += kAnnexBStartCodeSize;
+    if (!subsample_ends.empty()) {
+      // We've replaced NALU size value with an AnnexB start code.
+      (*subsamples)[subsample_index].clear_bytes +=
+          kAnnexBStartCodeSize - length_size;
+    }
+
+    memcpy(out, frame + pos, nal_length);
+    out += nal_length;
+    pos += nal_length;
+  }
+
+  DCHECK_EQ(output + output_size, out);
+  return true;
+}
+
 // Verifies AnnexB NALU order according to ISO/IEC 14496-10 Section 7.4.1.2.3
 bool AVC::IsValidAnnexB(const std::vector<uint8_t>& buffer,
                         const std::vector<SubsampleEntry>& subsamples) {
@@ -316,8 +426,13 @@ bool AVC::IsValidAnnexB(const uint8_t* buffer,
 
 AVCBitstreamConverter::AVCBitstreamConverter(
     std::unique_ptr<AVCDecoderConfigurationRecord> avc_config)
-    : avc_config_(std::move(avc_config)) {
+    : avc_config_(std::move(avc_config)), param_sets_valid_(false) {
   DCHECK(avc_config_);
+  param_sets_valid_ = AVC::ConvertConfigToAnnexB(*avc_config_, &param_sets_);
+  if (!param_sets_valid_) {
+    DVLOG(1) << "Failed to convert avcC to Annex B";
+    param_sets_.clear();
+  }
 }
 
 AVCBitstreamConverter::~AVCBitstreamConverter() {
@@ -327,6 +442,8 @@ bool AVCBitstreamConverter::ConvertFrame(
     std::vector<uint8_t>* frame_buf,
     bool is_keyframe,
     std::vector<SubsampleEntry>* subsamples) const {
+  RCHECK(param_sets_valid_ || !is_keyframe);
+
   // Convert the AVC NALU length fields to Annex B headers, as expected by
   // decoding libraries. Since this may enlarge the size of the buffer, we also
   // update the clear byte count for each subsample if encryption is used to
@@ -346,5 +463,39 @@ bool AVCBitstreamConverter::ConvertFrame(
   return true;
 }
 
+bool AVCBitstreamConverter::GetConvertedFrameSize(const uint8_t* frame,
+                                                  size_t frame_size,
+                                                  bool is_keyframe,
+                                                  size_t* output_size) const {
+  RCHECK(param_sets_valid_ || !is_keyframe);
+  return AVC::GetAnnexBFrameSize(avc_config_->length_size, frame, frame_size,
+                                 is_keyframe ? param_sets_.size() : 0,
+                                 output_size);
+}
+
+bool AVCBitstreamConverter::WriteConvertedFrame(
+    const uint8_t* frame,
+    size_t frame_size,
+    bool is_keyframe,
+    uint8_t* output,
+    size_t output_size,
+    std::vector<SubsampleEntry>* subsamples) const {
+  RCHECK(param_sets_valid_ || !is_keyframe);
+
+  // As in ConvertFrame(), SPS and PPS are (re-)injected at the start of
+  // keyframes, after the access unit delimiter if there is one.
+  const int length_size = avc_config_->length_size;
+  const bool starts_with_aud =
+      frame_size > static_cast<size_t>(length_size) &&
+      (frame[length_size] & 0x1f) == H264NALU::kAUD;
+  RCHECK(AVC::WriteFrameAsAnnexB(
+      length_size, frame, frame_size, param_sets_.data(),
+      is_keyframe ? param_sets_.size() : 0, starts_with_aud, output,
+      output_size, subsamples));
+
+  DCHECK(AVC::IsValidAnnexB(output, output_size, *subsamples));
+  return true;
+}
+
 }  // namespace mp4
 }  // namespace media
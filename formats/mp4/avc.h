@@ -42,6 +42,32 @@ class MEDIA_EXPORT AVC {
       const AVCDecoderConfigurationRecord& avc_config,
       std::vector<uint8_t>* buffer);
 
+  // Single copy alternative to ConvertFrameToAnnexB() followed by
+  // InsertParamSetsAnnexB(), for H.264 as well as H.265. Sets |annexb_size|
+  // to the size of |frame|, NALUs each preceded by its |length_size| byte
+  // length, once converted to Annex B with |param_sets_size| bytes of
+  // parameter sets inserted.
+  static bool GetAnnexBFrameSize(int length_size,
+                                 const uint8_t* frame,
+                                 size_t frame_size,
+                                 size_t param_sets_size,
+                                 size_t* annexb_size);
+
+  // Writes |frame| converted to Annex B into |output|, which must be of the
+  // size returned by GetAnnexBFrameSize(). The Annex B |param_sets|, if any,
+  // are inserted before the first NALU, or after it if
+  // |param_sets_after_first_nalu|, e.g. when it is an access unit delimiter.
+  // |subsamples| describes |frame| and is updated to describe |output|.
+  static bool WriteFrameAsAnnexB(int length_size,
+                                 const uint8_t* frame,
+                                 size_t frame_size,
+                                 const uint8_t* param_sets,
+                                 size_t param_sets_size,
+                                 bool param_sets_after_first_nalu,
+                                 uint8_t* output,
+                                 size_t output_size,
+                                 std::vector<SubsampleEntry>* subsamples);
+
   // Verifies that the contents of |buffer| conform to
   // Section 7.4.1.2.3 of ISO/IEC 14496-10.
   // |subsamples| contains the information about what parts of the buffer are
@@ -75,10 +101,28 @@ class AVCBitstreamConverter : public BitstreamConverter {
   bool ConvertFrame(std::vector<uint8_t>* frame_buf,
                     bool is_keyframe,
                     std::vector<SubsampleEntry>* subsamples) const override;
+  bool GetConvertedFrameSize(const uint8_t* frame,
+                             size_t frame_size,
+                             bool is_keyframe,
+                             size_t* output_size) const override;
+  bool WriteConvertedFrame(
+      const uint8_t* frame,
+      size_t frame_size,
+      bool is_keyframe,
+      uint8_t* output,
+      size_t output_size,
+      std::vector<SubsampleEntry>* subsamples) const override;
 
  private:
   ~AVCBitstreamConverter() override;
   std::unique_ptr<AVCDecoderConfigurationRecord> avc_config_;
+
+  // The SPS and PPS of |avc_config_| in Annex B format.
+  std::vector<uint8_t> param_sets_;
+
+  // False if |avc_config_| couldn't be converted to Annex B, in which case
+  // |param_sets_| is empty and keyframes can't be converted.
+  bool param_sets_valid_;
 };
 
 }  // namespace mp4
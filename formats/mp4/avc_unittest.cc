@@ -6,7 +6,11 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <memory>
+#include <utility>
+
 #include "base/macros.h"
+#include "base/memory/ref_counted.h"
 #include "base/strings/string_split.h"
 #include "base/strings/string_util.h"
 #include "media/base/decrypt_config.h"
@@ -223,6 +227,31 @@ class AVCConversionTest : public testing::TestWithParam<int> {
     buf->insert(buf->end(), kNALU2, kNALU2 + sizeof(kNALU2));
   }
 
+  // Makes a frame of NALUs preceded by their |length_size| byte lengths from
+  // |str|, which is formatted as for StringToAnnexB(). Each subsample is
+  // clear.
+  void StringToAVC(int length_size,
+                   const std::string& str,
+                   std::vector<uint8_t>* buf,
+                   std::vector<SubsampleEntry>* subsamples) {
+    buf->clear();
+    subsamples->clear();
+    for (const std::string& subsample_spec : base::SplitString(
+             str, " ", base::KEEP_WHITESPACE, base::SPLIT_WANT_NONEMPTY)) {
+      const size_t start = buf->size();
+      for (const std::string& nalu : base::SplitString(
+               subsample_spec, ",", base::KEEP_WHITESPACE,
+               base::SPLIT_WANT_NONEMPTY)) {
+        WriteLength(length_size, 4, buf);
+        buf->push_back(StringToNALUType(nalu));
+        // Junk payload, as in StringToAnnexB().
+        buf->push_back(0x32);
+        buf->push_back(0x12);
+        buf->push_back(0x67);
+      }
+      subsamples->push_back(SubsampleEntry(buf->size() - start, 0));
+    }
+  }
 };
 
 TEST_P(AVCConversionTest, ParseCorrectly) {
@@ -241,6 +270,9 @@ TEST_P(AVCConversionTest, NALUSizeTooLarge) {
   std::vector<uint8_t> buf;
   WriteLength(GetParam(), 10 * sizeof(kNALU1), &buf);
   buf.insert(buf.end(), kNALU1, kNALU1 + sizeof(kNALU1));
+  size_t annexb_size = 0;
+  EXPECT_FALSE(AVC::GetAnnexBFrameSize(GetParam(), buf.data(), buf.size(), 0,
+                                       &annexb_size));
   EXPECT_FALSE(AVC::ConvertFrameToAnnexB(GetParam(), &buf, nullptr));
 }
 
@@ -256,6 +288,9 @@ TEST_P(AVCConversionTest, NALUSizeIsZero) {
   WriteLength(GetParam(), sizeof(kNALU2), &buf);
   buf.insert(buf.end(), kNALU2, kNALU2 + sizeof(kNALU2));
 
+  size_t annexb_size = 0;
+  EXPECT_FALSE(AVC::GetAnnexBFrameSize(GetParam(), buf.data(), buf.size(), 0,
+                                       &annexb_size));
   EXPECT_FALSE(AVC::ConvertFrameToAnnexB(GetParam(), &buf, nullptr));
 }
 
@@ -319,6 +354,61 @@ TEST_P(AVCConversionTest, ParseEmpty) {
   EXPECT_EQ(0u, buf.size());
 }
 
+TEST_P(AVCConversionTest, WriteConvertedFrameMatchesConvertFrame) {
+  static const char* test_cases[] = {
+    "I",
+    "P P",
+    "AUD I",
+    "AUD,SEI I",
+    "AUD,SPS,PPS,I P",
+  };
+
+  std::unique_ptr<AVCDecoderConfigurationRecord> avc_config(
+      new AVCDecoderConfigurationRecord());
+  avc_config->length_size = GetParam();
+  avc_config->sps_list.resize(1);
+  avc_config->sps_list[0].push_back(0x67);
+  avc_config->sps_list[0].push_back(0x12);
+  avc_config->pps_list.resize(1);
+  avc_config->pps_list[0].push_back(0x68);
+  avc_config->pps_list[0].push_back(0x56);
+  scoped_refptr<BitstreamConverter> converter(
+      new AVCBitstreamConverter(std::move(avc_config)));
+
+  for (const char* test_case : test_cases) {
+    for (bool is_keyframe : {false, true}) {
+      SCOPED_TRACE(std::string(test_case) +
+                   (is_keyframe ? " keyframe" : " non-keyframe"));
+      std::vector<uint8_t> frame;
+      std::vector<SubsampleEntry> subsamples;
+      StringToAVC(GetParam(), test_case, &frame, &subsamples);
+
+      std::vector<uint8_t> expected(frame);
+      std::vector<SubsampleEntry> expected_subsamples(subsamples);
+      ASSERT_TRUE(converter->ConvertFrame(&expected, is_keyframe,
+                                          &expected_subsamples));
+
+      size_t output_size = 0;
+      ASSERT_TRUE(converter->GetConvertedFrameSize(
+          frame.data(), frame.size(), is_keyframe, &output_size));
+      ASSERT_EQ(expected.size(), output_size);
+      std::vector<uint8_t> output(output_size);
+      ASSERT_TRUE(converter->WriteConvertedFrame(
+          frame.data(), frame.size(), is_keyframe, output.data(),
+          output.size(), &subsamples));
+      EXPECT_EQ(expected, output);
+
+      ASSERT_EQ(expected_subsamples.size(), subsamples.size());
+      for (size_t i = 0; i < subsamples.size(); ++i) {
+        EXPECT_EQ(expected_subsamples[i].clear_bytes,
+                  subsamples[i].clear_bytes);
+        EXPECT_EQ(expected_subsamples[i].cypher_bytes,
+                  subsamples[i].cypher_bytes);
+      }
+    }
+  }
+}
+
 INSTANTIATE_TEST_CASE_P(AVCConversionTestValues,
                         AVCConversionTest,
                         ::testing::Values(1, 2, 4));
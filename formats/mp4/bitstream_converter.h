@@ -5,6 +5,7 @@
 #ifndef MEDIA_FORMATS_MP4_BITSTREAM_CONVERTER_H_
 #define MEDIA_FORMATS_MP4_BITSTREAM_CONVERTER_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
 #include <vector>
@@ -37,6 +38,24 @@ class BitstreamConverter
                             bool is_keyframe,
                             std::vector<SubsampleEntry>* subsamples) const = 0;
 
+  // Single copy alternative to ConvertFrame(). GetConvertedFrameSize() sets
+  // |output_size| to the size of |frame| of |frame_size| bytes once
+  // converted, then WriteConvertedFrame() writes the converted frame into
+  // |output|, which must be of that size, e.g. the storage of the buffer the
+  // frame is emitted in. |subsamples| describes |frame| and is updated as for
+  // ConvertFrame(). Both return true iff |frame| could be converted.
+  virtual bool GetConvertedFrameSize(const uint8_t* frame,
+                                     size_t frame_size,
+                                     bool is_keyframe,
+                                     size_t* output_size) const = 0;
+  virtual bool WriteConvertedFrame(
+      const uint8_t* frame,
+      size_t frame_size,
+      bool is_keyframe,
+      uint8_t* output,
+      size_t output_size,
+      std::vector<SubsampleEntry>* subsamples) const = 0;
+
  protected:
   friend class base::RefCountedThreadSafe<BitstreamConverter>;
   virtual ~BitstreamConverter();
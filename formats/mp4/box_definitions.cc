@@ -375,6 +375,7 @@ TrackHeader::TrackHeader()
       layer(-1),
       alternate_group(-1),
       volume(-1),
+      display_matrix(),
       width(0),
       height(0) {}
 TrackHeader::TrackHeader(const TrackHeader& other) = default;
@@ -401,9 +402,10 @@ bool TrackHeader::Parse(BoxReader* reader) {
          reader->Read2s(&layer) &&
          reader->Read2s(&alternate_group) &&
          reader->Read2s(&volume) &&
-         reader->SkipBytes(2) &&  // reserved
-         reader->SkipBytes(36) &&  // matrix
-         reader->Read4(&width) &&
+         reader->SkipBytes(2));  // reserved
+  for (int32_t& value : display_matrix)
+    RCHECK(reader->Read4s(&value));
+  RCHECK(reader->Read4(&width) &&
          reader->Read4(&height));
 
   // Round width and height to the nearest number.
@@ -441,6 +443,88 @@ bool SampleDescription::Parse(BoxReader* reader) {
   return true;
 }
 
+SampleTableEntries::SampleTableEntries() : entry_count(0) {}
+SampleTableEntries::SampleTableEntries(const SampleTableEntries& other) =
+    default;
+SampleTableEntries::~SampleTableEntries() {}
+
+bool SampleTableEntries::ReadEntries(BoxReader* reader, size_t entry_size) {
+  RCHECK(reader->Read4(&entry_count) &&
+         reader->ReadVec(&entries,
+                         static_cast<uint64_t>(entry_count) * entry_size));
+  return true;
+}
+
+DecodingTimeToSample::DecodingTimeToSample() {}
+DecodingTimeToSample::DecodingTimeToSample(const DecodingTimeToSample& other) =
+    default;
+DecodingTimeToSample::~DecodingTimeToSample() {}
+FourCC DecodingTimeToSample::BoxType() const { return FOURCC_STTS; }
+
+bool DecodingTimeToSample::Parse(BoxReader* reader) {
+  return reader->ReadFullBoxHeader() && ReadEntries(reader, kEntrySize);
+}
+
+CompositionOffset::CompositionOffset() {}
+CompositionOffset::CompositionOffset(const CompositionOffset& other) = default;
+CompositionOffset::~CompositionOffset() {}
+FourCC CompositionOffset::BoxType() const { return FOURCC_CTTS; }
+
+bool CompositionOffset::Parse(BoxReader* reader) {
+  return reader->ReadFullBoxHeader() && ReadEntries(reader, kEntrySize);
+}
+
+SyncSample::SyncSample() : is_present(false) {}
+SyncSample::SyncSample(const SyncSample& other) = default;
+SyncSample::~SyncSample() {}
+FourCC SyncSample::BoxType() const { return FOURCC_STSS; }
+
+bool SyncSample::Parse(BoxReader* reader) {
+  is_present = true;
+  return reader->ReadFullBoxHeader() && ReadEntries(reader, kEntrySize);
+}
+
+SampleToChunk::SampleToChunk() {}
+SampleToChunk::SampleToChunk(const SampleToChunk& other) = default;
+SampleToChunk::~SampleToChunk() {}
+FourCC SampleToChunk::BoxType() const { return FOURCC_STSC; }
+
+bool SampleToChunk::Parse(BoxReader* reader) {
+  return reader->ReadFullBoxHeader() && ReadEntries(reader, kEntrySize);
+}
+
+SampleSize::SampleSize() : sample_size(0), sample_count(0) {}
+SampleSize::SampleSize(const SampleSize& other) = default;
+SampleSize::~SampleSize() {}
+FourCC SampleSize::BoxType() const { return FOURCC_STSZ; }
+
+bool SampleSize::Parse(BoxReader* reader) {
+  RCHECK(reader->ReadFullBoxHeader() && reader->Read4(&sample_size));
+  if (sample_size != 0)
+    return reader->Read4(&sample_count);
+  RCHECK(ReadEntries(reader, kEntrySize));
+  sample_count = entry_count;
+  return true;
+}
+
+ChunkOffset::ChunkOffset() {}
+ChunkOffset::ChunkOffset(const ChunkOffset& other) = default;
+ChunkOffset::~ChunkOffset() {}
+FourCC ChunkOffset::BoxType() const { return FOURCC_STCO; }
+
+bool ChunkOffset::Parse(BoxReader* reader) {
+  return reader->ReadFullBoxHeader() && ReadEntries(reader, kEntrySize);
+}
+
+ChunkLargeOffset::ChunkLargeOffset() {}
+ChunkLargeOffset::ChunkLargeOffset(const ChunkLargeOffset& other) = default;
+ChunkLargeOffset::~ChunkLargeOffset() {}
+FourCC ChunkLargeOffset::BoxType() const { return FOURCC_CO64; }
+
+bool ChunkLargeOffset::Parse(BoxReader* reader) {
+  return reader->ReadFullBoxHeader() && ReadEntries(reader, kEntrySize);
+}
+
 SampleTable::SampleTable() {}
 SampleTable::SampleTable(const SampleTable& other) = default;
 
@@ -460,6 +544,13 @@ bool SampleTable::Parse(BoxReader* reader) {
       break;
     sample_group_description.entries.clear();
   }
+  RCHECK(reader->MaybeReadChild(&decoding_time_to_sample) &&
+         reader->MaybeReadChild(&composition_offset) &&
+         reader->MaybeReadChild(&sync_sample) &&
+         reader->MaybeReadChild(&sample_to_chunk) &&
+         reader->MaybeReadChild(&sample_size) &&
+         reader->MaybeReadChild(&chunk_offset) &&
+         reader->MaybeReadChild(&chunk_large_offset));
   return true;
 }
 
@@ -1008,10 +1099,9 @@ bool Movie::Parse(BoxReader* reader) {
   RCHECK(reader->ScanChildren() && reader->ReadChild(&header) &&
          reader->ReadChildren(&tracks));
 
-  RCHECK_MEDIA_LOGGED(reader->ReadChild(&extends), reader->media_log(),
-                      "Detected unfragmented MP4. Media Source Extensions "
-                      "require ISO BMFF moov to contain mvex to indicate that "
-                      "Movie Fragments are to be expected.");
+  fragmented = reader->HasChild(&extends);
+  if (fragmented)
+    RCHECK(reader->ReadChild(&extends));
 
   return reader->MaybeReadChildren(&pssh);
 }
@@ -180,6 +180,9 @@ struct MEDIA_EXPORT TrackHeader : Box {
   int16_t layer;
   int16_t alternate_group;
   int16_t volume;
+  // The transformation matrix {a, b, u, c, d, v, x, y, w}, where u, v and w
+  // are 2.30 fixed-point values and the others 16.16.
+  int32_t display_matrix[9];
   uint32_t width;
   uint32_t height;
 };
@@ -321,15 +324,97 @@ struct MEDIA_EXPORT SampleGroupDescription : Box {  // 'sgpd'.
   std::vector<CencSampleEncryptionInfoEntry> entries;
 };
 
+// The tables of the sample table box which describe the samples of
+// progressive (non-fragmented) files. Rather than being expanded into vectors
+// of structs, entries are kept as laid out in the file, i.e. as big-endian
+// fields of |entry_size| bytes, and SampleTableIterator decodes them on
+// demand. This keeps multi-hour files at a few bytes per sample.
+struct MEDIA_EXPORT SampleTableEntries : Box {
+  SampleTableEntries();
+  SampleTableEntries(const SampleTableEntries& other);
+  ~SampleTableEntries() override;
+
+  // Reads the entry count, followed by entries of |entry_size| bytes.
+  bool ReadEntries(BoxReader* reader, size_t entry_size);
+
+  uint32_t entry_count;
+  std::vector<uint8_t> entries;
+};
+
+struct MEDIA_EXPORT DecodingTimeToSample : SampleTableEntries {  // 'stts'.
+  DECLARE_BOX_METHODS(DecodingTimeToSample);
+
+  // Entries are a sample count and a sample delta.
+  enum { kEntrySize = 8 };
+};
+
+struct MEDIA_EXPORT CompositionOffset : SampleTableEntries {  // 'ctts'.
+  DECLARE_BOX_METHODS(CompositionOffset);
+
+  // Entries are a sample count and a sample offset. The offset is unsigned in
+  // version 0 boxes, but is read as signed for all versions since that's how
+  // many muxers write it.
+  enum { kEntrySize = 8 };
+};
+
+struct MEDIA_EXPORT SyncSample : SampleTableEntries {  // 'stss'.
+  DECLARE_BOX_METHODS(SyncSample);
+
+  // Entries are the one-based, increasing numbers of the sync samples.
+  enum { kEntrySize = 4 };
+
+  // When the box is absent, every sample is a sync sample.
+  bool is_present;
+};
+
+struct MEDIA_EXPORT SampleToChunk : SampleTableEntries {  // 'stsc'.
+  DECLARE_BOX_METHODS(SampleToChunk);
+
+  // Entries are the one-based number of the first chunk they apply to, the
+  // number of samples per chunk and the one-based sample description index.
+  enum { kEntrySize = 12 };
+};
+
+struct MEDIA_EXPORT SampleSize : SampleTableEntries {  // 'stsz'.
+  DECLARE_BOX_METHODS(SampleSize);
+
+  // Entries are sample sizes, present only if |sample_size| is zero.
+  enum { kEntrySize = 4 };
+
+  // If nonzero, the size of every sample.
+  uint32_t sample_size;
+  uint32_t sample_count;
+};
+
+struct MEDIA_EXPORT ChunkOffset : SampleTableEntries {  // 'stco'.
+  DECLARE_BOX_METHODS(ChunkOffset);
+
+  // Entries are the file offsets of the chunks.
+  enum { kEntrySize = 4 };
+};
+
+struct MEDIA_EXPORT ChunkLargeOffset : SampleTableEntries {  // 'co64'.
+  DECLARE_BOX_METHODS(ChunkLargeOffset);
+
+  // Entries are the 64-bit file offsets of the chunks.
+  enum { kEntrySize = 8 };
+};
+
 struct MEDIA_EXPORT SampleTable : Box {
   DECLARE_BOX_METHODS(SampleTable);
 
-  // Media Source specific: we ignore many of the sub-boxes in this box,
-  // including some that are required to be present in the BMFF spec. This
-  // includes the 'stts', 'stsc', and 'stco' boxes, which must contain no
-  // samples in order to be compliant files.
+  // Media Source ignores the 'stts', 'stsc', 'stco' and similar boxes, which
+  // must contain no samples in fragmented files. Progressive files describe
+  // all of their samples with them.
   SampleDescription description;
   SampleGroupDescription sample_group_description;
+  DecodingTimeToSample decoding_time_to_sample;
+  CompositionOffset composition_offset;
+  SyncSample sync_sample;
+  SampleToChunk sample_to_chunk;
+  SampleSize sample_size;
+  ChunkOffset chunk_offset;
+  ChunkLargeOffset chunk_large_offset;
 };
 
 struct MEDIA_EXPORT MediaHeader : Box {
@@ -227,8 +227,13 @@ bool HEVC::IsValidAnnexB(const uint8_t* buffer,
 
 HEVCBitstreamConverter::HEVCBitstreamConverter(
     std::unique_ptr<HEVCDecoderConfigurationRecord> hevc_config)
-    : hevc_config_(std::move(hevc_config)) {
+    : hevc_config_(std::move(hevc_config)), param_sets_valid_(false) {
   DCHECK(hevc_config_);
+  param_sets_valid_ = HEVC::ConvertConfigToAnnexB(*hevc_config_, &param_sets_);
+  if (!param_sets_valid_) {
+    DVLOG(1) << "Failed to convert hvcC to Annex B";
+    param_sets_.clear();
+  }
 }
 
 HEVCBitstreamConverter::~HEVCBitstreamConverter() {
@@ -238,6 +243,7 @@ bool HEVCBitstreamConverter::ConvertFrame(
     std::vector<uint8_t>* frame_buf,
     bool is_keyframe,
     std::vector<SubsampleEntry>* subsamples) const {
+  RCHECK(param_sets_valid_ || !is_keyframe);
   RCHECK(AVC::ConvertFrameToAnnexB(hevc_config_->lengthSizeMinusOne + 1,
                                    frame_buf, subsamples));
 
@@ -252,5 +258,40 @@ bool HEVCBitstreamConverter::ConvertFrame(
   return true;
 }
 
+bool HEVCBitstreamConverter::GetConvertedFrameSize(const uint8_t* frame,
+                                                   size_t frame_size,
+                                                   bool is_keyframe,
+                                                   size_t* output_size) const {
+  RCHECK(param_sets_valid_ || !is_keyframe);
+  return AVC::GetAnnexBFrameSize(hevc_config_->lengthSizeMinusOne + 1, frame,
+                                 frame_size,
+                                 is_keyframe ? param_sets_.size() : 0,
+                                 output_size);
+}
+
+bool HEVCBitstreamConverter::WriteConvertedFrame(
+    const uint8_t* frame,
+    size_t frame_size,
+    bool is_keyframe,
+    uint8_t* output,
+    size_t output_size,
+    std::vector<SubsampleEntry>* subsamples) const {
+  RCHECK(param_sets_valid_ || !is_keyframe);
+
+  // As in ConvertFrame(), the parameter sets are (re-)injected at the start of
+  // keyframes, after the access unit delimiter if there is one.
+  const int length_size = hevc_config_->lengthSizeMinusOne + 1;
+  const bool starts_with_aud =
+      frame_size > static_cast<size_t>(length_size) &&
+      ((frame[length_size] >> 1) & 0x3f) == H265NALU::AUD_NUT;
+  RCHECK(AVC::WriteFrameAsAnnexB(
+      length_size, frame, frame_size, param_sets_.data(),
+      is_keyframe ? param_sets_.size() : 0, starts_with_aud, output,
+      output_size, subsamples));
+
+  DCHECK(HEVC::IsValidAnnexB(output, output_size, *subsamples));
+  return true;
+}
+
 }  // namespace mp4
 }  // namespace media
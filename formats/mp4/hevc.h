@@ -102,10 +102,28 @@ class HEVCBitstreamConverter : public BitstreamConverter {
   bool ConvertFrame(std::vector<uint8_t>* frame_buf,
                     bool is_keyframe,
                     std::vector<SubsampleEntry>* subsamples) const override;
+  bool GetConvertedFrameSize(const uint8_t* frame,
+                             size_t frame_size,
+                             bool is_keyframe,
+                             size_t* output_size) const override;
+  bool WriteConvertedFrame(
+      const uint8_t* frame,
+      size_t frame_size,
+      bool is_keyframe,
+      uint8_t* output,
+      size_t output_size,
+      std::vector<SubsampleEntry>* subsamples) const override;
 
  private:
   ~HEVCBitstreamConverter() override;
   std::unique_ptr<HEVCDecoderConfigurationRecord> hevc_config_;
+
+  // The parameter sets of |hevc_config_| in Annex B format.
+  std::vector<uint8_t> param_sets_;
+
+  // False if |hevc_config_| couldn't be converted to Annex B, in which case
+  // |param_sets_| is empty and keyframes can't be converted.
+  bool param_sets_valid_;
 };
 
 }  // namespace mp4
@@ -5,6 +5,7 @@
 #include "media/formats/mp4/mp4_stream_parser.h"
 
 #include <stddef.h>
+#include <string.h>
 
 #include <limits>
 #include <memory>
@@ -220,6 +221,10 @@ bool MP4StreamParser::ParseBox(bool* err) {
 bool MP4StreamParser::ParseMoov(BoxReader* reader) {
   moov_.reset(new Movie);
   RCHECK(moov_->Parse(reader));
+  RCHECK_MEDIA_LOGGED(moov_->fragmented, media_log_,
+                      "Detected unfragmented MP4. Media Source Extensions "
+                      "require ISO BMFF moov to contain mvex to indicate that "
+                      "Movie Fragments are to be expected.");
   runs_.reset();
   audio_track_ids_.clear();
   video_track_ids_.clear();
@@ -544,16 +549,18 @@ void MP4StreamParser::OnEncryptedMediaInitData(
 
 bool MP4StreamParser::PrepareAACBuffer(
     const AAC& aac_config,
-    std::vector<uint8_t>* frame_buf,
+    const uint8_t* frame,
+    size_t frame_size,
+    uint8_t* output,
     std::vector<SubsampleEntry>* subsamples) const {
-  // Append an ADTS header to every audio sample.
-  RCHECK(aac_config.ConvertEsdsToADTS(frame_buf));
+  // Prepend an ADTS header to every audio sample.
+  RCHECK(aac_config.WriteADTSHeader(frame_size, output));
+  memcpy(output + kADTSHeaderMinSize, frame, frame_size);
 
   // As above, adjust subsample information to account for the headers. AAC is
   // not required to use subsample encryption, so we may need to add an entry.
   if (subsamples->empty()) {
-    subsamples->push_back(SubsampleEntry(
-        kADTSHeaderMinSize, frame_buf->size() - kADTSHeaderMinSize));
+    subsamples->push_back(SubsampleEntry(kADTSHeaderMinSize, frame_size));
   } else {
     (*subsamples)[0].clear_bytes += kADTSHeaderMinSize;
   }
@@ -641,29 +648,51 @@ bool MP4StreamParser::EnqueueSample(BufferQueueMap* buffers, bool* err) {
     subsamples = decrypt_config->subsamples();
   }
 
-  std::vector<uint8_t> frame_buf(buf, buf + runs_->sample_size());
-  if (video) {
-    if (runs_->video_description().video_codec == kCodecH264 ||
-        runs_->video_description().video_codec == kCodecHEVC) {
-      DCHECK(runs_->video_description().frame_bitstream_converter);
-      if (!runs_->video_description().frame_bitstream_converter->ConvertFrame(
-              &frame_buf, runs_->is_keyframe(), &subsamples)) {
-        MEDIA_LOG(ERROR, media_log_)
-            << "Failed to prepare video sample for decode";
-        *err = true;
-        return false;
-      }
-    }
-  }
+  StreamParserBuffer::Type buffer_type = audio ? DemuxerStream::AUDIO :
+      DemuxerStream::VIDEO;
 
-  if (audio) {
-    if (ESDescriptor::IsAAC(runs_->audio_description().esds.object_type) &&
-        !PrepareAACBuffer(runs_->audio_description().esds.aac,
-                          &frame_buf, &subsamples)) {
+  // Samples which need converting are written straight into the storage of
+  // the buffer they're emitted in, which is sized up front.
+  scoped_refptr<StreamParserBuffer> stream_buf;
+  const int sample_size = runs_->sample_size();
+  if (video && (runs_->video_description().video_codec == kCodecH264 ||
+                runs_->video_description().video_codec == kCodecHEVC)) {
+    const BitstreamConverter* converter =
+        runs_->video_description().frame_bitstream_converter.get();
+    DCHECK(converter);
+    size_t converted_size = 0;
+    bool converted = converter->GetConvertedFrameSize(
+        buf, sample_size, runs_->is_keyframe(), &converted_size);
+    if (converted) {
+      stream_buf = StreamParserBuffer::Create(
+          static_cast<int>(converted_size), runs_->is_keyframe(), buffer_type,
+          runs_->track_id());
+      converted = converter->WriteConvertedFrame(
+          buf, sample_size, runs_->is_keyframe(), stream_buf->writable_data(),
+          converted_size, &subsamples);
+    }
+    if (!converted) {
+      MEDIA_LOG(ERROR, media_log_)
+          << "Failed to prepare video sample for decode";
+      *err = true;
+      return false;
+    }
+  } else if (audio &&
+             ESDescriptor::IsAAC(runs_->audio_description().esds.object_type)) {
+    stream_buf = StreamParserBuffer::Create(
+        kADTSHeaderMinSize + sample_size, runs_->is_keyframe(), buffer_type,
+        runs_->track_id());
+    if (!PrepareAACBuffer(runs_->audio_description().esds.aac, buf,
+                          sample_size, stream_buf->writable_data(),
+                          &subsamples)) {
       MEDIA_LOG(ERROR, media_log_) << "Failed to prepare AAC sample for decode";
       *err = true;
       return false;
     }
+  } else {
+    stream_buf = StreamParserBuffer::CopyFrom(
+        buf, sample_size, runs_->is_keyframe(), buffer_type,
+        runs_->track_id());
   }
 
   if (decrypt_config) {
@@ -680,13 +709,6 @@ bool MP4StreamParser::EnqueueSample(BufferQueueMap* buffers, bool* err) {
         new DecryptConfig("1", "", std::vector<SubsampleEntry>()));
   }
 
-  StreamParserBuffer::Type buffer_type = audio ? DemuxerStream::AUDIO :
-      DemuxerStream::VIDEO;
-
-  scoped_refptr<StreamParserBuffer> stream_buf = StreamParserBuffer::CopyFrom(
-      &frame_buf[0], frame_buf.size(), runs_->is_keyframe(), buffer_type,
-      runs_->track_id());
-
   if (decrypt_config)
     stream_buf->set_decrypt_config(std::move(decrypt_config));
 
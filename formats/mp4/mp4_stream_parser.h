@@ -70,8 +70,12 @@ class MEDIA_EXPORT MP4StreamParser : public StreamParser {
   void ChangeState(State new_state);
 
   bool EmitConfigs();
+  // Writes the ADTS header, then |frame|, into |output|, which must hold
+  // kADTSHeaderMinSize + |frame_size| bytes.
   bool PrepareAACBuffer(const AAC& aac_config,
-                        std::vector<uint8_t>* frame_buf,
+                        const uint8_t* frame,
+                        size_t frame_size,
+                        uint8_t* output,
                         std::vector<SubsampleEntry>* subsamples) const;
   bool EnqueueSample(BufferQueueMap* buffers, bool* err);
   bool SendAndFlushSamples(BufferQueueMap* buffers);
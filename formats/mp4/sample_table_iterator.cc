@@ -0,0 +1,397 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/formats/mp4/sample_table_iterator.h"
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
+#include "base/big_endian.h"
+#include "base/logging.h"
+#include "media/formats/mp4/rcheck.h"
+#include "media/formats/mp4/track_run_iterator.h"
+
+namespace media {
+namespace mp4 {
+
+namespace {
+
+// Reads the big-endian field at |offset| of a table's |entries|.
+template <typename T>
+T ReadField(const std::vector<uint8_t>& entries, size_t offset) {
+  DCHECK_LE(offset + sizeof(T), entries.size());
+  T value;
+  base::ReadBigEndian(reinterpret_cast<const char*>(&entries[offset]), &value);
+  return value;
+}
+
+uint32_t ReadEntry32(const SampleTableEntries& table,
+                     size_t entry_size,
+                     uint32_t index,
+                     size_t field) {
+  return ReadField<uint32_t>(table.entries, index * entry_size + field * 4);
+}
+
+}  // namespace
+
+SampleTableIterator::SampleTableIterator(const Track& track)
+    : track_(track),
+      table_(track.media.information.sample_table),
+      timescale_(track.media.header.timescale),
+      edit_list_offset_(0),
+      sample_count_(0),
+      chunk_count_(0),
+      sample_index_(0),
+      sample_offset_(0),
+      sample_size_(0),
+      stsc_index_(0),
+      chunk_index_(0),
+      next_stsc_first_chunk_(0),
+      samples_per_chunk_(0),
+      sample_in_chunk_(0),
+      description_index_(0),
+      stts_index_(0),
+      stts_samples_left_(0),
+      sample_delta_(0),
+      sample_dts_(0),
+      ctts_index_(0),
+      ctts_samples_left_(0),
+      composition_offset_(0),
+      stss_index_(0) {}
+
+SampleTableIterator::~SampleTableIterator() {}
+
+bool SampleTableIterator::Init() {
+  RCHECK(timescale_ > 0);
+
+  // Like TrackRunIterator, only a single edit with a nonnegative media time is
+  // supported, which removes the CTS offset introduced by B-frames.
+  const std::vector<EditListEntry>& edits = track_.edit.list.edits;
+  if (!edits.empty()) {
+    if (edits.size() > 1)
+      DVLOG(1) << "Multi-entry edit box detected; some components ignored.";
+    if (edits[0].media_time >= 0)
+      edit_list_offset_ = -edits[0].media_time;
+  }
+
+  sample_count_ = table_.sample_size.sample_count;
+  chunk_count_ = table_.chunk_offset.entry_count > 0
+                     ? table_.chunk_offset.entry_count
+                     : table_.chunk_large_offset.entry_count;
+  if (sample_count_ == 0)
+    return true;
+
+  RCHECK(chunk_count_ > 0 && table_.sample_to_chunk.entry_count > 0);
+  RCHECK(SeekToSample(0));
+  return true;
+}
+
+bool SampleTableIterator::IsValid() const {
+  return sample_index_ < sample_count_;
+}
+
+void SampleTableIterator::Advance() {
+  DCHECK(IsValid());
+
+  ++sample_index_;
+  if (!IsValid())
+    return;
+
+  sample_dts_ += sample_delta_;
+  if (stts_samples_left_ > 1)
+    --stts_samples_left_;
+  else
+    LoadSttsEntry();
+  if (ctts_samples_left_ > 1)
+    --ctts_samples_left_;
+  else
+    LoadCttsEntry();
+
+  const SyncSample& stss = table_.sync_sample;
+  while (stss_index_ < stss.entry_count &&
+         SyncSampleAt(stss_index_) < sample_index_) {
+    ++stss_index_;
+  }
+
+  sample_offset_ += sample_size_;
+  if (++sample_in_chunk_ >= samples_per_chunk_) {
+    ++chunk_index_;
+    if (!StartChunk()) {
+      DVLOG(1) << "Sample tables end at sample " << sample_index_ << " of "
+               << sample_count_;
+      sample_count_ = sample_index_;
+      return;
+    }
+  }
+  sample_size_ = SampleSizeAt(sample_index_);
+}
+
+bool SampleTableIterator::Seek(base::TimeDelta time) {
+  if (sample_count_ == 0)
+    return false;
+
+  // Find the last sample decoded at or before |time|.
+  const int64_t target = time.InMicroseconds() * timescale_ /
+                             base::Time::kMicrosecondsPerSecond -
+                         edit_list_offset_;
+  const DecodingTimeToSample& stts = table_.decoding_time_to_sample;
+  uint64_t first_sample = 0;
+  int64_t first_dts = 0;
+  uint32_t delta = 0;
+  for (uint32_t i = 0; i < stts.entry_count; ++i) {
+    const uint32_t count =
+        ReadEntry32(stts, DecodingTimeToSample::kEntrySize, i, 0);
+    delta = ReadEntry32(stts, DecodingTimeToSample::kEntrySize, i, 1);
+    const int64_t end_dts = first_dts + static_cast<int64_t>(count) * delta;
+    if (target < end_dts)
+      break;
+    first_sample += count;
+    first_dts = end_dts;
+  }
+  // Past the end of the table, samples keep the last delta.
+  uint64_t sample_index = first_sample;
+  if (target > first_dts && delta > 0)
+    sample_index += (target - first_dts) / delta;
+  sample_index = std::min<uint64_t>(sample_index, sample_count_ - 1);
+
+  const uint32_t sync_sample = FindSyncSample(sample_index);
+  if (sync_sample >= sample_count_)
+    return false;
+  return SeekToSample(sync_sample);
+}
+
+bool SampleTableIterator::is_keyframe() const {
+  const SyncSample& stss = table_.sync_sample;
+  if (!stss.is_present)
+    return true;
+  return stss_index_ < stss.entry_count &&
+         SyncSampleAt(stss_index_) == sample_index_;
+}
+
+base::TimeDelta SampleTableIterator::dts() const {
+  return TimeDeltaFromRational(sample_dts_, timescale_);
+}
+
+base::TimeDelta SampleTableIterator::cts() const {
+  return TimeDeltaFromRational(
+      sample_dts_ + composition_offset_ + edit_list_offset_, timescale_);
+}
+
+base::TimeDelta SampleTableIterator::duration() const {
+  return TimeDeltaFromRational(sample_delta_, timescale_);
+}
+
+bool SampleTableIterator::SeekToSample(uint32_t sample_index) {
+  DCHECK_LT(sample_index, sample_count_);
+
+  // Find the chunk holding the sample by walking the sample-to-chunk runs.
+  RCHECK(LoadStscEntry(0));
+  uint64_t first_sample = 0;
+  while (true) {
+    const uint32_t first_chunk = ReadEntry32(
+        table_.sample_to_chunk, SampleToChunk::kEntrySize, stsc_index_, 0);
+    RCHECK(first_chunk <= chunk_count_);
+    const uint64_t end_chunk = std::min<uint64_t>(
+        next_stsc_first_chunk_, static_cast<uint64_t>(chunk_count_) + 1);
+    const uint64_t samples = (end_chunk - first_chunk) * samples_per_chunk_;
+    if (sample_index - first_sample < samples) {
+      const uint64_t sample_in_run = sample_index - first_sample;
+      chunk_index_ = first_chunk - 1 + sample_in_run / samples_per_chunk_;
+      sample_in_chunk_ = sample_in_run % samples_per_chunk_;
+      break;
+    }
+    first_sample += samples;
+    RCHECK(LoadStscEntry(stsc_index_ + 1));
+  }
+
+  sample_index_ = sample_index;
+  sample_offset_ = ChunkOffsetAt(chunk_index_);
+  if (table_.sample_size.sample_size != 0) {
+    sample_offset_ +=
+        static_cast<int64_t>(sample_in_chunk_) * table_.sample_size.sample_size;
+  } else {
+    for (uint32_t i = sample_index - sample_in_chunk_; i < sample_index; ++i)
+      sample_offset_ += SampleSizeAt(i);
+  }
+  sample_size_ = SampleSizeAt(sample_index);
+
+  // Walk the time-to-sample runs up to the sample.
+  stts_index_ = 0;
+  stts_samples_left_ = 0;
+  sample_delta_ = 0;
+  sample_dts_ = 0;
+  uint32_t samples_left = sample_index;
+  while (true) {
+    LoadSttsEntry();
+    if (samples_left < stts_samples_left_ ||
+        stts_index_ >= table_.decoding_time_to_sample.entry_count) {
+      break;
+    }
+    samples_left -= stts_samples_left_;
+    sample_dts_ += static_cast<int64_t>(stts_samples_left_) * sample_delta_;
+  }
+  if (samples_left < stts_samples_left_)
+    stts_samples_left_ -= samples_left;
+  else
+    stts_samples_left_ = 0;
+  sample_dts_ += static_cast<int64_t>(samples_left) * sample_delta_;
+
+  // And the composition offset runs.
+  ctts_index_ = 0;
+  ctts_samples_left_ = 0;
+  composition_offset_ = 0;
+  samples_left = sample_index;
+  while (true) {
+    LoadCttsEntry();
+    if (samples_left < ctts_samples_left_ ||
+        ctts_index_ >= table_.composition_offset.entry_count) {
+      break;
+    }
+    samples_left -= ctts_samples_left_;
+  }
+  if (samples_left < ctts_samples_left_) {
+    ctts_samples_left_ -= samples_left;
+  } else {
+    ctts_samples_left_ = 0;
+    composition_offset_ = 0;
+  }
+
+  // Binary search for the first sync sample at or after the sample.
+  const SyncSample& stss = table_.sync_sample;
+  uint32_t low = 0;
+  uint32_t high = stss.entry_count;
+  while (low < high) {
+    const uint32_t middle = low + (high - low) / 2;
+    if (SyncSampleAt(middle) < sample_index)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  stss_index_ = low;
+  return true;
+}
+
+bool SampleTableIterator::StartChunk() {
+  while (chunk_index_ < chunk_count_) {
+    if (chunk_index_ + 1 >= next_stsc_first_chunk_) {
+      if (!LoadStscEntry(stsc_index_ + 1))
+        return false;
+      continue;
+    }
+    if (samples_per_chunk_ > 0) {
+      sample_in_chunk_ = 0;
+      sample_offset_ = ChunkOffsetAt(chunk_index_);
+      return true;
+    }
+    ++chunk_index_;
+  }
+  return false;
+}
+
+bool SampleTableIterator::LoadStscEntry(uint32_t stsc_index) {
+  const SampleToChunk& stsc = table_.sample_to_chunk;
+  if (stsc_index >= stsc.entry_count)
+    return false;
+
+  const uint32_t first_chunk =
+      ReadEntry32(stsc, SampleToChunk::kEntrySize, stsc_index, 0);
+  RCHECK(first_chunk > 0);
+  next_stsc_first_chunk_ = std::numeric_limits<uint32_t>::max();
+  if (stsc_index + 1 < stsc.entry_count) {
+    next_stsc_first_chunk_ =
+        ReadEntry32(stsc, SampleToChunk::kEntrySize, stsc_index + 1, 0);
+    RCHECK(next_stsc_first_chunk_ > first_chunk);
+  }
+
+  stsc_index_ = stsc_index;
+  samples_per_chunk_ =
+      ReadEntry32(stsc, SampleToChunk::kEntrySize, stsc_index, 1);
+  // Sample description indices are one-based.
+  description_index_ =
+      ReadEntry32(stsc, SampleToChunk::kEntrySize, stsc_index, 2);
+  if (description_index_ > 0)
+    --description_index_;
+  return true;
+}
+
+void SampleTableIterator::LoadSttsEntry() {
+  const DecodingTimeToSample& stts = table_.decoding_time_to_sample;
+  while (stts_index_ < stts.entry_count) {
+    const uint32_t count =
+        ReadEntry32(stts, DecodingTimeToSample::kEntrySize, stts_index_, 0);
+    const uint32_t delta =
+        ReadEntry32(stts, DecodingTimeToSample::kEntrySize, stts_index_, 1);
+    ++stts_index_;
+    if (count > 0) {
+      stts_samples_left_ = count;
+      sample_delta_ = delta;
+      return;
+    }
+  }
+}
+
+void SampleTableIterator::LoadCttsEntry() {
+  const CompositionOffset& ctts = table_.composition_offset;
+  while (ctts_index_ < ctts.entry_count) {
+    const uint32_t count =
+        ReadEntry32(ctts, CompositionOffset::kEntrySize, ctts_index_, 0);
+    const uint32_t offset =
+        ReadEntry32(ctts, CompositionOffset::kEntrySize, ctts_index_, 1);
+    ++ctts_index_;
+    if (count > 0) {
+      ctts_samples_left_ = count;
+      composition_offset_ = static_cast<int32_t>(offset);
+      return;
+    }
+  }
+  composition_offset_ = 0;
+}
+
+uint32_t SampleTableIterator::FindSyncSample(uint32_t sample_index) const {
+  const SyncSample& stss = table_.sync_sample;
+  if (!stss.is_present)
+    return sample_index;
+  if (stss.entry_count == 0)
+    return sample_count_;
+
+  // Binary search for the last sync sample at or before |sample_index|.
+  uint32_t low = 0;
+  uint32_t high = stss.entry_count;
+  while (low < high) {
+    const uint32_t middle = low + (high - low) / 2;
+    if (SyncSampleAt(middle) <= sample_index)
+      low = middle + 1;
+    else
+      high = middle;
+  }
+  return SyncSampleAt(low > 0 ? low - 1 : 0);
+}
+
+uint32_t SampleTableIterator::SampleSizeAt(uint32_t sample_index) const {
+  const SampleSize& stsz = table_.sample_size;
+  if (stsz.sample_size != 0)
+    return stsz.sample_size;
+  return ReadEntry32(stsz, SampleSize::kEntrySize, sample_index, 0);
+}
+
+int64_t SampleTableIterator::ChunkOffsetAt(uint32_t chunk_index) const {
+  if (table_.chunk_offset.entry_count > 0) {
+    return ReadEntry32(table_.chunk_offset, ChunkOffset::kEntrySize,
+                       chunk_index, 0);
+  }
+  return static_cast<int64_t>(ReadField<uint64_t>(
+      table_.chunk_large_offset.entries,
+      chunk_index * ChunkLargeOffset::kEntrySize));
+}
+
+uint32_t SampleTableIterator::SyncSampleAt(uint32_t stss_index) const {
+  // Sync sample numbers are one-based.
+  const uint32_t sample_number =
+      ReadEntry32(table_.sync_sample, SyncSample::kEntrySize, stss_index, 0);
+  return sample_number > 0 ? sample_number - 1 : 0;
+}
+
+}  // namespace mp4
+}  // namespace media
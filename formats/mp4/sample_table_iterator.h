@@ -0,0 +1,132 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#ifndef MEDIA_FORMATS_MP4_SAMPLE_TABLE_ITERATOR_H_
+#define MEDIA_FORMATS_MP4_SAMPLE_TABLE_ITERATOR_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "base/macros.h"
+#include "base/time/time.h"
+#include "media/base/media_export.h"
+#include "media/formats/mp4/box_definitions.h"
+
+namespace media {
+namespace mp4 {
+
+// Iterates through the samples of a track of a progressive (non-fragmented)
+// file, as described by the tables of its sample table box. The tables are
+// run-length coded and are decoded on demand while iterating, so no per-sample
+// state is built up front. Seeking only walks the run-length coded tables and
+// binary searches the sync sample table.
+//
+// Running out of entries in the time-to-sample or composition offset tables
+// is tolerated, as it is by other demuxers; iteration ends early if the chunk
+// tables describe fewer samples than the sample size table.
+class MEDIA_EXPORT SampleTableIterator {
+ public:
+  // |track| must outlive the iterator.
+  explicit SampleTableIterator(const Track& track);
+  ~SampleTableIterator();
+
+  // Checks the tables are usable and positions the iterator at the first
+  // sample. Returns false if the tables are malformed.
+  bool Init();
+
+  // Returns whether the iterator refers to a sample.
+  bool IsValid() const;
+
+  // Advances the iterator to the next sample. Only valid if IsValid().
+  void Advance();
+
+  // Positions the iterator at the last sync sample whose decode time is at
+  // or before |time|, or at the first sync sample if there's none. Returns
+  // false if the track has no sync samples.
+  bool Seek(base::TimeDelta time);
+
+  // Properties of the current sample. Only valid if IsValid().
+  uint32_t sample_index() const { return sample_index_; }
+  int64_t sample_offset() const { return sample_offset_; }
+  uint32_t sample_size() const { return sample_size_; }
+  bool is_keyframe() const;
+  // Zero-based index into the entries of the sample description box.
+  uint32_t sample_description_index() const { return description_index_; }
+  base::TimeDelta dts() const;
+  base::TimeDelta cts() const;
+  base::TimeDelta duration() const;
+
+  uint32_t sample_count() const { return sample_count_; }
+
+ private:
+  // Positions the iterator at the sample with |sample_index|. Returns false
+  // if the chunk tables don't describe that sample.
+  bool SeekToSample(uint32_t sample_index);
+
+  // Moves |chunk_index_| on to the first chunk holding samples, starting at
+  // the current one, and sets up the sample-to-chunk cursor and
+  // |sample_offset_| for it. Returns false if there's no such chunk.
+  bool StartChunk();
+
+  // Loads the stsc entry at |stsc_index|. Returns false if there's no such
+  // entry or it is malformed.
+  bool LoadStscEntry(uint32_t stsc_index);
+
+  // Load the next entry of the time-to-sample and composition offset tables.
+  // Past the end of their tables, the last sample delta is kept and the
+  // composition offset is zero.
+  void LoadSttsEntry();
+  void LoadCttsEntry();
+
+  // Returns the sample index of the last sync sample at or before
+  // |sample_index|, or the first sync sample if there's none.
+  uint32_t FindSyncSample(uint32_t sample_index) const;
+
+  // Readers of the fields of table entries.
+  uint32_t SampleSizeAt(uint32_t sample_index) const;
+  int64_t ChunkOffsetAt(uint32_t chunk_index) const;
+  uint32_t SyncSampleAt(uint32_t stss_index) const;
+
+  const Track& track_;
+  const SampleTable& table_;
+  const int64_t timescale_;
+  int64_t edit_list_offset_;
+
+  uint32_t sample_count_;
+  uint32_t chunk_count_;
+
+  // The current sample.
+  uint32_t sample_index_;
+  int64_t sample_offset_;
+  uint32_t sample_size_;
+
+  // Sample-to-chunk cursor. |chunk_index_| is zero-based.
+  uint32_t stsc_index_;
+  uint32_t chunk_index_;
+  uint32_t next_stsc_first_chunk_;
+  uint32_t samples_per_chunk_;
+  uint32_t sample_in_chunk_;
+  uint32_t description_index_;
+
+  // Time-to-sample cursor, in |timescale_| units.
+  uint32_t stts_index_;
+  uint32_t stts_samples_left_;
+  uint32_t sample_delta_;
+  int64_t sample_dts_;
+
+  // Composition offset cursor.
+  uint32_t ctts_index_;
+  uint32_t ctts_samples_left_;
+  int32_t composition_offset_;
+
+  // Index of the first sync sample entry at or after the current sample.
+  uint32_t stss_index_;
+
+  DISALLOW_COPY_AND_ASSIGN(SampleTableIterator);
+};
+
+}  // namespace mp4
+}  // namespace media
+
+#endif  // MEDIA_FORMATS_MP4_SAMPLE_TABLE_ITERATOR_H_
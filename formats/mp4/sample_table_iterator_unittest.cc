@@ -0,0 +1,258 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include "media/formats/mp4/sample_table_iterator.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <vector>
+
+#include "base/macros.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace media {
+namespace mp4 {
+
+namespace {
+
+const int kTimescale = 1000;
+
+// Ten samples in four chunks of three, three, two and two samples.
+const uint32_t kSampleSizes[] = {100, 101, 102, 103, 104,
+                                 105, 106, 107, 108, 109};
+const int64_t kSampleOffsets[] = {1000, 1100, 1201, 2000, 2103,
+                                  2207, 3000, 3106, 4000, 4108};
+const uint32_t kChunkOffsets[] = {1000, 2000, 3000, 4000};
+const int64_t kSampleDts[] = {0, 10, 20, 30, 40, 60, 80, 100, 120, 140};
+const int64_t kSampleCts[] = {10, 10, 20, 35, 45, 65, 85, 105, 125, 145};
+const bool kSampleIsKeyframe[] = {true,  false, false, false, false,
+                                  false, false, true,  false, false};
+
+void AppendU32(std::vector<uint8_t>* entries, uint32_t value) {
+  for (int shift = 24; shift >= 0; shift -= 8)
+    entries->push_back(static_cast<uint8_t>(value >> shift));
+}
+
+void AppendU64(std::vector<uint8_t>* entries, uint64_t value) {
+  AppendU32(entries, static_cast<uint32_t>(value >> 32));
+  AppendU32(entries, static_cast<uint32_t>(value));
+}
+
+void SetEntries(SampleTableEntries* table,
+                const std::vector<uint32_t>& fields,
+                size_t fields_per_entry) {
+  table->entry_count = fields.size() / fields_per_entry;
+  table->entries.clear();
+  for (uint32_t field : fields)
+    AppendU32(&table->entries, field);
+}
+
+}  // namespace
+
+class SampleTableIteratorTest : public testing::Test {
+ public:
+  SampleTableIteratorTest() {
+    track_.media.header.timescale = kTimescale;
+
+    SampleTable* table = &track_.media.information.sample_table;
+    SetEntries(&table->sample_size,
+               std::vector<uint32_t>(kSampleSizes,
+                                     kSampleSizes + arraysize(kSampleSizes)),
+               1);
+    table->sample_size.sample_count = arraysize(kSampleSizes);
+    SetEntries(&table->chunk_offset,
+               std::vector<uint32_t>(kChunkOffsets,
+                                     kChunkOffsets + arraysize(kChunkOffsets)),
+               1);
+    SetEntries(&table->sample_to_chunk, {1, 3, 1, 3, 2, 1}, 3);
+    SetEntries(&table->decoding_time_to_sample, {4, 10, 6, 20}, 2);
+    SetEntries(&table->composition_offset, {1, 10, 2, 0, 7, 5}, 2);
+    SetEntries(&table->sync_sample, {1, 8}, 1);
+    table->sync_sample.is_present = true;
+  }
+
+ protected:
+  SampleTable* table() { return &track_.media.information.sample_table; }
+
+  void ExpectSample(const SampleTableIterator& iterator, size_t index) {
+    ASSERT_TRUE(iterator.IsValid());
+    EXPECT_EQ(index, iterator.sample_index());
+    EXPECT_EQ(kSampleOffsets[index], iterator.sample_offset());
+    EXPECT_EQ(kSampleSizes[index], iterator.sample_size());
+    EXPECT_EQ(base::TimeDelta::FromMilliseconds(kSampleDts[index]),
+              iterator.dts());
+    EXPECT_EQ(base::TimeDelta::FromMilliseconds(kSampleCts[index]),
+              iterator.cts());
+    EXPECT_EQ(kSampleIsKeyframe[index], iterator.is_keyframe());
+  }
+
+  Track track_;
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(SampleTableIteratorTest);
+};
+
+TEST_F(SampleTableIteratorTest, EmptyTables) {
+  Track track;
+  track.media.header.timescale = kTimescale;
+  SampleTableIterator iterator(track);
+  EXPECT_TRUE(iterator.Init());
+  EXPECT_FALSE(iterator.IsValid());
+  EXPECT_FALSE(iterator.Seek(base::TimeDelta()));
+}
+
+TEST_F(SampleTableIteratorTest, Advance) {
+  SampleTableIterator iterator(track_);
+  ASSERT_TRUE(iterator.Init());
+  EXPECT_EQ(arraysize(kSampleSizes), iterator.sample_count());
+  for (size_t i = 0; i < arraysize(kSampleSizes); ++i) {
+    ExpectSample(iterator, i);
+    EXPECT_EQ(0u, iterator.sample_description_index());
+    iterator.Advance();
+  }
+  EXPECT_FALSE(iterator.IsValid());
+}
+
+TEST_F(SampleTableIteratorTest, Seek) {
+  SampleTableIterator iterator(track_);
+  ASSERT_TRUE(iterator.Init());
+
+  // Sample 6 is decoded at 80 ms; the sync sample before it is sample 0.
+  ASSERT_TRUE(iterator.Seek(base::TimeDelta::FromMilliseconds(85)));
+  ExpectSample(iterator, 0);
+
+  ASSERT_TRUE(iterator.Seek(base::TimeDelta::FromMilliseconds(100)));
+  ExpectSample(iterator, 7);
+  for (size_t i = 8; i < arraysize(kSampleSizes); ++i) {
+    iterator.Advance();
+    ExpectSample(iterator, i);
+  }
+  iterator.Advance();
+  EXPECT_FALSE(iterator.IsValid());
+
+  // Seeking past the end lands on the last sync sample.
+  ASSERT_TRUE(iterator.Seek(base::TimeDelta::FromSeconds(10)));
+  ExpectSample(iterator, 7);
+
+  ASSERT_TRUE(iterator.Seek(base::TimeDelta()));
+  ExpectSample(iterator, 0);
+}
+
+TEST_F(SampleTableIteratorTest, SeekWithoutSyncSampleBox) {
+  table()->sync_sample = SyncSample();
+  SampleTableIterator iterator(track_);
+  ASSERT_TRUE(iterator.Init());
+
+  // Every sample is a sync sample.
+  ASSERT_TRUE(iterator.Seek(base::TimeDelta::FromMilliseconds(85)));
+  EXPECT_EQ(6u, iterator.sample_index());
+  EXPECT_EQ(kSampleOffsets[6], iterator.sample_offset());
+  EXPECT_TRUE(iterator.is_keyframe());
+}
+
+TEST_F(SampleTableIteratorTest, SeekWithEmptySyncSampleBox) {
+  table()->sync_sample.entry_count = 0;
+  table()->sync_sample.entries.clear();
+  SampleTableIterator iterator(track_);
+  ASSERT_TRUE(iterator.Init());
+  EXPECT_FALSE(iterator.is_keyframe());
+  EXPECT_FALSE(iterator.Seek(base::TimeDelta()));
+}
+
+TEST_F(SampleTableIteratorTest, ConstantSampleSize) {
+  table()->sample_size.sample_size = 50;
+  table()->sample_size.entry_count = 0;
+  table()->sample_size.entries.clear();
+  SampleTableIterator iterator(track_);
+  ASSERT_TRUE(iterator.Init());
+
+  const int64_t kOffsets[] = {1000, 1050, 1100, 2000, 2050,
+                              2100, 3000, 3050, 4000, 4050};
+  for (size_t i = 0; i < arraysize(kOffsets); ++i) {
+    ASSERT_TRUE(iterator.IsValid());
+    EXPECT_EQ(kOffsets[i], iterator.sample_offset());
+    EXPECT_EQ(50u, iterator.sample_size());
+    iterator.Advance();
+  }
+  EXPECT_FALSE(iterator.IsValid());
+}
+
+TEST_F(SampleTableIteratorTest, LargeChunkOffsets) {
+  const uint64_t kBase = 0x100000000ull;
+  table()->chunk_offset = ChunkOffset();
+  table()->chunk_large_offset.entry_count = arraysize(kChunkOffsets);
+  for (uint32_t offset : kChunkOffsets)
+    AppendU64(&table()->chunk_large_offset.entries, kBase + offset);
+
+  SampleTableIterator iterator(track_);
+  ASSERT_TRUE(iterator.Init());
+  ASSERT_TRUE(iterator.Seek(base::TimeDelta::FromMilliseconds(100)));
+  EXPECT_EQ(static_cast<int64_t>(kBase) + kSampleOffsets[7],
+            iterator.sample_offset());
+}
+
+TEST_F(SampleTableIteratorTest, ShortTimeTables) {
+  // The last sample delta is used past the end of the time-to-sample table,
+  // and a zero composition offset past the end of the composition offset
+  // table.
+  SetEntries(&table()->decoding_time_to_sample, {2, 10}, 2);
+  SetEntries(&table()->composition_offset, {1, 10}, 2);
+  SampleTableIterator iterator(track_);
+  ASSERT_TRUE(iterator.Init());
+  for (int i = 0; i < 9; ++i)
+    iterator.Advance();
+  ASSERT_TRUE(iterator.IsValid());
+  EXPECT_EQ(base::TimeDelta::FromMilliseconds(90), iterator.dts());
+  EXPECT_EQ(base::TimeDelta::FromMilliseconds(90), iterator.cts());
+
+  // Sample 7 is decoded at 70 ms, and is a sync sample.
+  ASSERT_TRUE(iterator.Seek(base::TimeDelta::FromMilliseconds(75)));
+  EXPECT_EQ(7u, iterator.sample_index());
+  EXPECT_EQ(base::TimeDelta::FromMilliseconds(70), iterator.cts());
+}
+
+TEST_F(SampleTableIteratorTest, TruncatedChunkTable) {
+  // The chunks describe only the first eight samples.
+  SetEntries(&table()->chunk_offset, {1000, 2000, 3000}, 1);
+  SampleTableIterator iterator(track_);
+  ASSERT_TRUE(iterator.Init());
+  size_t samples = 0;
+  for (; iterator.IsValid(); iterator.Advance())
+    ++samples;
+  EXPECT_EQ(8u, samples);
+}
+
+TEST_F(SampleTableIteratorTest, EditList) {
+  EditListEntry edit;
+  edit.segment_duration = 0;
+  edit.media_time = 10;
+  edit.media_rate_integer = 1;
+  edit.media_rate_fraction = 0;
+  track_.edit.list.edits.push_back(edit);
+
+  SampleTableIterator iterator(track_);
+  ASSERT_TRUE(iterator.Init());
+  EXPECT_EQ(base::TimeDelta(), iterator.cts());
+
+  // Seek times are presentation times.
+  ASSERT_TRUE(iterator.Seek(base::TimeDelta::FromMilliseconds(95)));
+  EXPECT_EQ(7u, iterator.sample_index());
+  EXPECT_EQ(base::TimeDelta::FromMilliseconds(95), iterator.cts());
+}
+
+TEST_F(SampleTableIteratorTest, MalformedSampleToChunk) {
+  // Chunk numbers are one-based.
+  SetEntries(&table()->sample_to_chunk, {0, 3, 1}, 3);
+  SampleTableIterator iterator(track_);
+  EXPECT_FALSE(iterator.Init());
+
+  // First chunks must increase.
+  SetEntries(&table()->sample_to_chunk, {1, 3, 1, 1, 2, 1}, 3);
+  SampleTableIterator other_iterator(track_);
+  EXPECT_FALSE(other_iterator.Init());
+}
+
+}  // namespace mp4
+}  // namespace media
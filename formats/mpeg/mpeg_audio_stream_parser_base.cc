@@ -4,6 +4,7 @@
 
 #include "media/formats/mpeg/mpeg_audio_stream_parser_base.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "base/bind.h"
@@ -106,10 +107,11 @@ bool MPEGAudioStreamParserBase::Parse(const uint8_t* buf, int size) {
 
   bool end_of_segment = true;
   BufferQueue buffers;
+  int min_peek_size = 4;
   for (;;) {
     const uint8_t* data;
     int data_size;
-    queue_.Peek(&data, &data_size);
+    queue_.PeekAtLeast(min_peek_size, &data, &data_size);
 
     if (data_size < 4)
       break;
@@ -145,7 +147,12 @@ bool MPEGAudioStreamParserBase::Parse(const uint8_t* buf, int size) {
       ChangeState(PARSE_ERROR);
       return false;
     } else if (bytes_read == 0) {
-      // Need more data.
+      // Need more data. The view only covers the front chunk of the queue, so
+      // widen it before giving up if more bytes are already queued.
+      if (data_size < queue_.size()) {
+        min_peek_size = std::min(2 * data_size, queue_.size());
+        continue;
+      }
       break;
     }
 
@@ -154,6 +161,7 @@ bool MPEGAudioStreamParserBase::Parse(const uint8_t* buf, int size) {
       return false;
 
     queue_.Pop(bytes_read);
+    min_peek_size = 4;
     end_of_segment = true;
   }
 
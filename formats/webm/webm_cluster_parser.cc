@@ -4,6 +4,7 @@
 
 #include "media/formats/webm/webm_cluster_parser.h"
 
+#include <algorithm>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -34,6 +35,62 @@ enum {
   kMaxDurationEstimateLogs = 10,
 };
 
+// Lacing modes, from bits 1-2 of the flags of a Block. See
+// http://www.matroska.org/technical/specs/index.html#lacing
+enum {
+  kLacingXiph = 1,
+  kLacingFixedSize = 2,
+  kLacingEbml = 3,
+};
+
+// Reads a Xiph lace size at |*cur|, and advances |*cur| past it. Returns -1
+// if the size runs past |end|.
+static int64_t ReadXiphLaceSize(const uint8_t** cur, const uint8_t* end) {
+  int64_t size = 0;
+  uint8_t byte;
+  do {
+    if (*cur == end)
+      return -1;
+    byte = *(*cur)++;
+    size += byte;
+  } while (byte == 0xff);
+  return size;
+}
+
+// Reads an EBML lace size at |*cur|, and advances |*cur| past it. The first
+// size is an unsigned EBML integer, the others are signed differences to
+// |previous_size|. Returns -1 if the size is invalid or runs past |end|.
+static int64_t ReadEbmlLaceSize(const uint8_t** cur,
+                                const uint8_t* end,
+                                bool first,
+                                int64_t previous_size) {
+  if (*cur == end)
+    return -1;
+
+  // The number of leading zero bits gives the length of the integer.
+  int length = 1;
+  uint8_t mask = 0x80;
+  while (mask && !(**cur & mask)) {
+    mask >>= 1;
+    ++length;
+  }
+  if (!mask || end - *cur < length)
+    return -1;
+
+  int64_t value = **cur & (mask - 1);
+  for (int i = 1; i < length; ++i)
+    value = (value << 8) | (*cur)[i];
+  *cur += length;
+
+  if (first)
+    return value;
+
+  // Signed differences are biased by half the range of their length.
+  int64_t size =
+      previous_size + value - ((INT64_C(1) << (7 * length - 1)) - 1);
+  return size < 0 ? -1 : size;
+}
+
 WebMClusterParser::WebMClusterParser(
     int64_t timecode_scale,
     int audio_track_num,
@@ -73,6 +130,7 @@ void WebMClusterParser::Reset() {
   cluster_start_time_ = kNoTimestamp;
   cluster_ended_ = false;
   parser_.Reset();
+  ClearBlockGroupData();
   audio_.Reset();
   video_.Reset();
   ResetTextTracks();
@@ -87,6 +145,9 @@ int WebMClusterParser::Parse(const uint8_t* buf, int size) {
 
   int result = parser_.Parse(buf, size);
 
+  // |buf| may be gone by the next call.
+  RetainBlockGroupData();
+
   if (result < 0) {
     cluster_ended_ = false;
     return result;
@@ -262,15 +323,15 @@ WebMParserClient* WebMClusterParser::OnListStart(int id) {
     cluster_timecode_ = -1;
     cluster_start_time_ = kNoTimestamp;
   } else if (id == kWebMIdBlockGroup) {
-    block_data_.reset();
-    block_data_size_ = -1;
+    ClearBlockGroupData();
     block_duration_ = -1;
     discard_padding_ = -1;
     discard_padding_set_ = false;
     reference_block_set_ = false;
   } else if (id == kWebMIdBlockAdditions) {
     block_add_id_ = -1;
-    block_additional_data_.reset();
+    block_additional_data_ = nullptr;
+    block_additional_data_storage_.reset();
     block_additional_data_size_ = 0;
   }
 
@@ -288,15 +349,12 @@ bool WebMClusterParser::OnListEnd(int id) {
   }
 
   bool result = ParseBlock(
-      false, block_data_.get(), block_data_size_, block_additional_data_.get(),
+      false, block_data_, block_data_size_, block_additional_data_,
       block_additional_data_size_, block_duration_,
       discard_padding_set_ ? discard_padding_ : 0, reference_block_set_);
-  block_data_.reset();
-  block_data_size_ = -1;
+  ClearBlockGroupData();
   block_duration_ = -1;
   block_add_id_ = -1;
-  block_additional_data_.reset();
-  block_additional_data_size_ = 0;
   discard_padding_ = -1;
   discard_padding_set_ = false;
   reference_block_set_ = false;
@@ -347,12 +405,6 @@ bool WebMClusterParser::ParseBlock(bool is_simple_block,
   int flags = buf[3] & 0xff;
   int lacing = (flags >> 1) & 0x3;
 
-  if (lacing) {
-    MEDIA_LOG(ERROR, media_log_) << "Lacing " << lacing
-                                 << " is not supported yet.";
-    return false;
-  }
-
   // Sign extend negative timecode offsets.
   if (timecode & 0x8000)
     timecode |= ~0xffff;
@@ -366,9 +418,77 @@ bool WebMClusterParser::ParseBlock(bool is_simple_block,
 
   const uint8_t* frame_data = buf + 4;
   int frame_size = size - (frame_data - buf);
-  return OnBlock(is_simple_block, track_num, timecode, duration, frame_data,
-                 frame_size, additional, additional_size, discard_padding,
-                 is_keyframe);
+  if (!lacing) {
+    return OnBlock(is_simple_block, track_num, timecode, duration, frame_data,
+                   frame_size, additional, additional_size, discard_padding,
+                   is_keyframe, base::TimeDelta());
+  }
+
+  if (ignored_tracks_.find(track_num) != ignored_tracks_.end())
+    return true;
+
+  // Only the first frame of a lace has a timecode; the others follow at the
+  // DefaultDuration of the track.
+  const Track* track = NULL;
+  if (track_num == audio_.track_num())
+    track = &audio_;
+  else if (track_num == video_.track_num())
+    track = &video_;
+  if (!track || track->default_duration() == kNoTimestamp) {
+    MEDIA_LOG(ERROR, media_log_)
+        << "Lacing is only supported on audio and video tracks with a "
+           "DefaultDuration.";
+    return false;
+  }
+  if (additional) {
+    MEDIA_LOG(ERROR, media_log_)
+        << "Lacing with a BlockAdditional is not supported.";
+    return false;
+  }
+  if (frame_size < 1)
+    return false;
+
+  // The lace header gives the number of frames, then the sizes of all but the
+  // last one, which takes up the rest of the Block.
+  const int frame_count = frame_data[0] + 1;
+  const uint8_t* cur = frame_data + 1;
+  const uint8_t* const end = buf + size;
+  int64_t frame_sizes[256];
+  if (lacing == kLacingFixedSize) {
+    if ((end - cur) % frame_count)
+      return false;
+    std::fill(frame_sizes, frame_sizes + frame_count,
+              (end - cur) / frame_count);
+  } else {
+    int64_t laced_size = 0;
+    for (int i = 0; i < frame_count - 1; ++i) {
+      frame_sizes[i] =
+          lacing == kLacingXiph
+              ? ReadXiphLaceSize(&cur, end)
+              : ReadEbmlLaceSize(&cur, end, i == 0, i ? frame_sizes[i - 1] : 0);
+      if (frame_sizes[i] < 0)
+        return false;
+      laced_size += frame_sizes[i];
+      if (laced_size > end - cur)
+        return false;
+    }
+    frame_sizes[frame_count - 1] = (end - cur) - laced_size;
+  }
+
+  // The frames are handed out in place; only the discard padding of the Block
+  // applies to its last frame.
+  for (int i = 0; i < frame_count; ++i) {
+    if (frame_sizes[i] <= 0)
+      return false;
+    if (!OnBlock(is_simple_block, track_num, timecode, -1, cur,
+                 static_cast<int>(frame_sizes[i]), NULL, 0,
+                 i == frame_count - 1 ? discard_padding : 0, is_keyframe,
+                 track->default_duration() * i)) {
+      return false;
+    }
+    cur += frame_sizes[i];
+  }
+  return true;
 }
 
 bool WebMClusterParser::OnBinary(int id, const uint8_t* data, int size) {
@@ -383,13 +503,12 @@ bool WebMClusterParser::OnBinary(int id, const uint8_t* data, int size) {
                "supported.";
         return false;
       }
-      block_data_.reset(new uint8_t[size]);
-      memcpy(block_data_.get(), data, size);
+      // Kept in place until the BlockGroup ends; see RetainBlockGroupData().
+      block_data_ = data;
       block_data_size_ = size;
       return true;
 
     case kWebMIdBlockAdditional: {
-      uint64_t block_add_id = base::HostToNet64(block_add_id_);
       if (block_additional_data_) {
         // TODO(vigneshv): Technically, more than 1 BlockAdditional is allowed
         // as per matroska spec. But for now we don't have a use case to
@@ -399,14 +518,9 @@ bool WebMClusterParser::OnBinary(int id, const uint8_t* data, int size) {
                                         "BlockGroup is not supported.";
         return false;
       }
-      // First 8 bytes of side_data in DecoderBuffer is the BlockAddID
-      // element's value in Big Endian format. This is done to mimic ffmpeg
-      // demuxer's behavior.
-      block_additional_data_size_ = size + sizeof(block_add_id);
-      block_additional_data_.reset(new uint8_t[block_additional_data_size_]);
-      memcpy(block_additional_data_.get(), &block_add_id,
-             sizeof(block_add_id));
-      memcpy(block_additional_data_.get() + 8, data, size);
+      block_additional_data_ = data;
+      block_additional_data_size_ = size;
+      block_additional_id_ = block_add_id_;
       return true;
     }
     case kWebMIdDiscardPadding: {
@@ -442,7 +556,8 @@ bool WebMClusterParser::OnBlock(bool is_simple_block,
                                 const uint8_t* additional,
                                 int additional_size,
                                 int64_t discard_padding,
-                                bool is_keyframe) {
+                                bool is_keyframe,
+                                base::TimeDelta timestamp_offset) {
   DCHECK_GE(size, 0);
   if (cluster_timecode_ == -1) {
     MEDIA_LOG(ERROR, media_log_) << "Got a block before cluster timecode.";
@@ -493,8 +608,10 @@ bool WebMClusterParser::OnBlock(bool is_simple_block,
 
   last_block_timecode_ = timecode;
 
-  base::TimeDelta timestamp = base::TimeDelta::FromMicroseconds(
-      (cluster_timecode_ + timecode) * timecode_multiplier_);
+  base::TimeDelta timestamp =
+      base::TimeDelta::FromMicroseconds((cluster_timecode_ + timecode) *
+                                        timecode_multiplier_) +
+      timestamp_offset;
 
   scoped_refptr<StreamParserBuffer> buffer;
   if (buffer_type != DemuxerStream::TEXT) {
@@ -517,9 +634,19 @@ bool WebMClusterParser::OnBlock(bool is_simple_block,
     // applicable. See https://crbug.com/341581.
     buffer = StreamParserBuffer::CopyFrom(
         data + data_offset, size - data_offset,
-        additional, additional_size,
         is_keyframe, buffer_type, track_num);
 
+    if (additional) {
+      // First 8 bytes of side_data in DecoderBuffer is the BlockAddID
+      // element's value in Big Endian format. This is done to mimic ffmpeg
+      // demuxer's behavior.
+      uint64_t block_add_id = base::HostToNet64(block_additional_id_);
+      uint8_t* side_data =
+          buffer->AllocateSideData(sizeof(block_add_id) + additional_size);
+      memcpy(side_data, &block_add_id, sizeof(block_add_id));
+      memcpy(side_data + sizeof(block_add_id), additional, additional_size);
+    }
+
     if (decrypt_config)
       buffer->set_decrypt_config(std::move(decrypt_config));
   } else {
@@ -601,6 +728,34 @@ bool WebMClusterParser::OnBlock(bool is_simple_block,
   return track->AddBuffer(buffer);
 }
 
+void WebMClusterParser::ClearBlockGroupData() {
+  block_data_ = nullptr;
+  block_data_storage_.reset();
+  block_data_size_ = -1;
+  block_additional_data_ = nullptr;
+  block_additional_data_storage_.reset();
+  block_additional_data_size_ = 0;
+  block_additional_id_ = -1;
+}
+
+void WebMClusterParser::RetainBlockGroupData() {
+  if (block_data_ && block_data_ != block_data_storage_.get()) {
+    block_data_storage_.reset(new uint8_t[block_data_size_]);
+    memcpy(block_data_storage_.get(), block_data_, block_data_size_);
+    block_data_ = block_data_storage_.get();
+    bytes_copied_ += block_data_size_;
+  }
+  if (block_additional_data_ &&
+      block_additional_data_ != block_additional_data_storage_.get()) {
+    block_additional_data_storage_.reset(
+        new uint8_t[block_additional_data_size_]);
+    memcpy(block_additional_data_storage_.get(), block_additional_data_,
+           block_additional_data_size_);
+    block_additional_data_ = block_additional_data_storage_.get();
+    bytes_copied_ += block_additional_data_size_;
+  }
+}
+
 WebMClusterParser::Track::Track(int track_num,
                                 bool is_video,
                                 base::TimeDelta default_duration,
@@ -202,6 +202,11 @@ class MEDIA_EXPORT WebMClusterParser : public WebMParserClient {
   // Returns true if the last Parse() call stopped at the end of a cluster.
   bool cluster_ended() const { return cluster_ended_; }
 
+  // Returns the number of bytes copied aside because a BlockGroup straddled
+  // two Parse() calls. Other Blocks are read straight out of the data passed
+  // to Parse(). Used to measure copy overhead.
+  int64_t bytes_copied() const { return bytes_copied_; }
+
  private:
   // WebMParserClient methods.
   WebMParserClient* OnListStart(int id) override;
@@ -217,6 +222,11 @@ class MEDIA_EXPORT WebMClusterParser : public WebMParserClient {
                   int duration,
                   int64_t discard_padding,
                   bool reference_block_set);
+
+  // Creates a buffer for one frame of a Block. |additional| is the payload of
+  // the BlockAdditional of the current BlockGroup, if any. |timestamp_offset|
+  // is added to the timestamp of the Block, to place the frames of a laced
+  // Block.
   bool OnBlock(bool is_simple_block,
                int track_num,
                int timecode,
@@ -226,7 +236,16 @@ class MEDIA_EXPORT WebMClusterParser : public WebMParserClient {
                const uint8_t* additional,
                int additional_size,
                int64_t discard_padding,
-               bool is_keyframe);
+               bool is_keyframe,
+               base::TimeDelta timestamp_offset);
+
+  // Forgets the Block and BlockAdditional of the current BlockGroup.
+  void ClearBlockGroupData();
+
+  // Copies the Block and BlockAdditional of the current BlockGroup aside if
+  // they still point into the data passed to Parse(), which the caller may
+  // release once Parse() returns.
+  void RetainBlockGroupData();
 
   // Resets the Track objects associated with each text track.
   void ResetTextTracks();
@@ -279,15 +298,25 @@ class MEDIA_EXPORT WebMClusterParser : public WebMParserClient {
   WebMListParser parser_;
 
   int64_t last_block_timecode_ = -1;
-  std::unique_ptr<uint8_t[]> block_data_;
+
+  // The Block of the current BlockGroup. Points into the data passed to
+  // Parse(), or into |block_data_storage_| once the BlockGroup straddles two
+  // Parse() calls.
+  const uint8_t* block_data_ = nullptr;
+  std::unique_ptr<uint8_t[]> block_data_storage_;
   int block_data_size_ = -1;
   int64_t block_duration_ = -1;
   int64_t block_add_id_ = -1;
 
-  std::unique_ptr<uint8_t[]> block_additional_data_;
-  // Must be 0 if |block_additional_data_| is null. Must be > 0 if
-  // |block_additional_data_| is NOT null.
+  // The payload of the BlockAdditional of the current BlockGroup, kept like
+  // |block_data_|, and the BlockAddID it came with. Null if the BlockGroup
+  // has no BlockAdditional.
+  const uint8_t* block_additional_data_ = nullptr;
+  std::unique_ptr<uint8_t[]> block_additional_data_storage_;
   int block_additional_data_size_ = 0;
+  int64_t block_additional_id_ = -1;
+
+  int64_t bytes_copied_ = 0;
 
   int64_t discard_padding_ = -1;
   bool discard_padding_set_ = false;
@@ -6,6 +6,7 @@
 
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 
 #include <algorithm>
 #include <cstdlib>
@@ -566,6 +567,118 @@ TEST_F(WebMClusterParserTest, ParseBlockGroup) {
   ASSERT_TRUE(VerifyBuffers(parser_, kBlockInfo, block_count));
 }
 
+// Blocks of a BlockGroup which is still open when Parse() returns are kept
+// aside, so the caller may release the data it passed in.
+TEST_F(WebMClusterParserTest, ParseBlockGroupAcrossCalls) {
+  const uint8_t kClusterData[] = {
+    0x1F, 0x43, 0xB6, 0x75, 0x9B,  // Cluster(size=27)
+    0xE7, 0x81, 0x00,  // Timecode(size=1, value=0)
+    0xA0, 0x96,  // BlockGroup(size=22)
+    0xA1, 0x85, 0x82, 0x00, 0x00, 0x00, 0xaa,  // Block(size=5, track=2, ts=0)
+    0x9B, 0x81, 0x21,  // BlockDuration(size=1, value=33)
+    0x75, 0xA1, 0x89,  // BlockAdditions(size=9)
+    0xA6, 0x87,  // BlockMore(size=7)
+    0xEE, 0x81, 0x01,  // BlockAddID(size=1, value=1)
+    0xA5, 0x82, 0xbb, 0xcc,  // BlockAdditional(size=2)
+  };
+  const int kClusterSize = sizeof(kClusterData);
+  const uint8_t kExpectedSideData[] = {0x00, 0x00, 0x00, 0x00, 0x00,
+                                       0x00, 0x00, 0x01, 0xbb, 0xcc};
+
+  StreamParser::BufferQueueMap buffers;
+  std::vector<uint8_t> scratch;
+  int offset = 0;
+  int parse_size = 1;
+  while (offset < kClusterSize) {
+    scratch.assign(kClusterData + offset, kClusterData + offset + parse_size);
+    int result = parser_->Parse(scratch.data(), scratch.size());
+    ASSERT_GE(result, 0);
+    std::fill(scratch.begin(), scratch.end(), 0xff);
+
+    if (result == 0) {
+      // The parser needs more data.
+      parse_size = std::min(parse_size + 1, kClusterSize - offset);
+      continue;
+    }
+
+    StreamParser::BufferQueueMap bqm;
+    parser_->GetBuffers(&bqm);
+    for (const auto& it : bqm)
+      AppendToEnd(it.second, &buffers[it.first]);
+
+    offset += result;
+    parse_size = 1;
+  }
+
+  const BlockInfo kBlockInfo[] = {
+      {kVideoTrackNum, 0, 33, false, NULL, 0, true},
+  };
+  ASSERT_TRUE(VerifyBuffers(buffers, kBlockInfo, arraysize(kBlockInfo)));
+  scoped_refptr<StreamParserBuffer> buffer = buffers[kVideoTrackNum][0];
+  ASSERT_EQ(1u, buffer->data_size());
+  EXPECT_EQ(0xaa, buffer->data()[0]);
+  ASSERT_EQ(sizeof(kExpectedSideData), buffer->side_data_size());
+  EXPECT_EQ(0, memcmp(kExpectedSideData, buffer->side_data(),
+                      sizeof(kExpectedSideData)));
+  EXPECT_GT(parser_->bytes_copied(), 0);
+}
+
+// The frames of a laced Block follow each other at the DefaultDuration of
+// their track.
+TEST_F(WebMClusterParserTest, ParseLacedBlocks) {
+  ResetParserToHaveDefaultDurations();
+
+  // Xiph lacing of frames of 1, 2 and 3 bytes.
+  uint8_t xiph_data[1 + 2 + 6] = {0x02, 0x01, 0x02};
+  // EBML lacing of frames of 300, 200 and 50 bytes. The second size is coded
+  // as the difference -100 to the first one.
+  uint8_t ebml_data[1 + 4 + 550] = {0x02, 0x41, 0x2C, 0x5F, 0x9B};
+  // Fixed-size lacing of two frames of 4 bytes.
+  uint8_t fixed_data[1 + 8] = {0x01};
+
+  ClusterBuilder cb;
+  cb.SetClusterTimecode(0);
+  cb.AddSimpleBlock(kVideoTrackNum, 0, 0x82, xiph_data, sizeof(xiph_data));
+  cb.AddSimpleBlock(kVideoTrackNum, 51, 0x86, ebml_data, sizeof(ebml_data));
+  cb.AddSimpleBlock(kVideoTrackNum, 102, 0x84, fixed_data,
+                    sizeof(fixed_data));
+  std::unique_ptr<Cluster> cluster(cb.Finish());
+
+  int result = parser_->Parse(cluster->data(), cluster->size());
+  EXPECT_EQ(cluster->size(), result);
+
+  const int kDuration = kTestVideoFrameDefaultDurationInMs;
+  const BlockInfo kBlockInfo[] = {
+      {kVideoTrackNum, 0, kDuration, true, NULL, 0, true},
+      {kVideoTrackNum, kDuration, kDuration, true, NULL, 0, true},
+      {kVideoTrackNum, 2 * kDuration, kDuration, true, NULL, 0, true},
+      {kVideoTrackNum, 51, kDuration, true, NULL, 0, true},
+      {kVideoTrackNum, 51 + kDuration, kDuration, true, NULL, 0, true},
+      {kVideoTrackNum, 51 + 2 * kDuration, kDuration, true, NULL, 0, true},
+      {kVideoTrackNum, 102, kDuration, true, NULL, 0, true},
+      {kVideoTrackNum, 102 + kDuration, kDuration, true, NULL, 0, true},
+  };
+  const size_t kFrameSizes[] = {1, 2, 3, 300, 200, 50, 4, 4};
+
+  StreamParser::BufferQueueMap buffers;
+  parser_->GetBuffers(&buffers);
+  ASSERT_TRUE(VerifyBuffers(buffers, kBlockInfo, arraysize(kBlockInfo)));
+  const StreamParser::BufferQueue& video_buffers = buffers[kVideoTrackNum];
+  for (size_t i = 0; i < arraysize(kFrameSizes); ++i)
+    EXPECT_EQ(kFrameSizes[i], video_buffers[i]->data_size());
+}
+
+TEST_F(WebMClusterParserTest, ParseLacedBlockWithoutDefaultDuration) {
+  uint8_t xiph_data[1 + 2 + 6] = {0x02, 0x01, 0x02};
+  ClusterBuilder cb;
+  cb.SetClusterTimecode(0);
+  cb.AddSimpleBlock(kVideoTrackNum, 0, 0x82, xiph_data, sizeof(xiph_data));
+  std::unique_ptr<Cluster> cluster(cb.Finish());
+
+  EXPECT_MEDIA_LOG(HasSubstr("Lacing is only supported"));
+  EXPECT_EQ(-1, parser_->Parse(cluster->data(), cluster->size()));
+}
+
 TEST_F(WebMClusterParserTest, ParseSimpleBlockAndBlockGroupMixture) {
   const BlockInfo kBlockInfo[] = {
       {kAudioTrackNum, 0, 23, true, NULL, 0, false},
@@ -4,6 +4,7 @@
 
 #include "media/formats/webm/webm_stream_parser.h"
 
+#include <algorithm>
 #include <memory>
 #include <string>
 
@@ -22,9 +23,14 @@
 
 namespace media {
 
+// The smallest piece of an appended buffer queued behind an element which
+// straddles appends.
+static const int kMinQueuedPushSize = 16 * 1024;
+
 WebMStreamParser::WebMStreamParser()
     : state_(kWaitingForInit),
-      unknown_segment_size_(false) {
+      unknown_segment_size_(false),
+      cluster_bytes_copied_(0) {
 }
 
 WebMStreamParser::~WebMStreamParser() {
@@ -75,48 +81,125 @@ bool WebMStreamParser::Parse(const uint8_t* buf, int size) {
   if (state_ == kError)
     return false;
 
-  byte_queue_.Push(buf, size);
+  // Bytes left over from earlier calls start an element which straddles into
+  // |buf|. Queue |buf| behind them in pieces of doubling size until the
+  // element is complete, so that only a bounded prefix of |buf| is copied.
+  int offset = 0;
+  while (byte_queue_.size() > 0 && offset < size) {
+    const int push_size = std::min(
+        size - offset, std::max(byte_queue_.size(), kMinQueuedPushSize));
+    byte_queue_.Push(buf + offset, push_size);
+    offset += push_size;
+    if (!ParseQueue())
+      return false;
+
+    // Once all queued bytes come from |buf|, parse the rest of it in place.
+    const int queued = byte_queue_.size();
+    if (queued <= offset) {
+      byte_queue_.Pop(queued);
+      offset -= queued;
+      break;
+    }
+  }
+  if (byte_queue_.size() > 0)
+    return true;
+
+  // Elements which are complete in |buf| are parsed without copying them;
+  // only the tail which starts an incomplete element is queued.
+  const int bytes_parsed = ParseBytes(buf + offset, size - offset);
+  if (bytes_parsed < 0)
+    return false;
+  offset += bytes_parsed;
+  if (offset < size)
+    byte_queue_.Push(buf + offset, size - offset);
+  return true;
+}
 
-  int result = 0;
+int64_t WebMStreamParser::bytes_copied() const {
+  return byte_queue_.bytes_copied() + cluster_bytes_copied_ +
+         (cluster_parser_ ? cluster_parser_->bytes_copied() : 0);
+}
+
+bool WebMStreamParser::ParseQueue() {
   int bytes_parsed = 0;
   const uint8_t* cur = NULL;
   int cur_size = 0;
 
-  byte_queue_.Peek(&cur, &cur_size);
+  // Parse directly out of the front chunk of |byte_queue_|. Only when an
+  // element straddles the end of the current view is the view widened, which
+  // copies just the bytes needed to make it contiguous.
+  byte_queue_.PeekAtLeast(1, &cur, &cur_size);
   while (cur_size > 0) {
     State oldState = state_;
-    switch (state_) {
-      case kParsingHeaders:
-        result = ParseInfoAndTracks(cur, cur_size);
-        break;
+    int result = ParseElements(cur, cur_size);
+    if (result < 0)
+      return false;
 
-      case kParsingClusters:
-        result = ParseCluster(cur, cur_size);
+    if (state_ == oldState && result == 0) {
+      const int queued = byte_queue_.size() - bytes_parsed;
+      if (cur_size >= queued)
         break;
 
-      case kWaitingForInit:
-      case kError:
-        return false;
-    }
-
-    if (result < 0) {
-      ChangeState(kError);
-      return false;
+      byte_queue_.Pop(bytes_parsed);
+      bytes_parsed = 0;
+      byte_queue_.PeekAtLeast(std::min(2 * cur_size, queued), &cur,
+                              &cur_size);
+      continue;
     }
 
-    if (state_ == oldState && result == 0)
-      break;
-
     DCHECK_GE(result, 0);
     cur += result;
     cur_size -= result;
     bytes_parsed += result;
+
+    if (cur_size == 0 && bytes_parsed < byte_queue_.size()) {
+      byte_queue_.Pop(bytes_parsed);
+      bytes_parsed = 0;
+      byte_queue_.PeekAtLeast(1, &cur, &cur_size);
+    }
   }
 
   byte_queue_.Pop(bytes_parsed);
   return true;
 }
 
+int WebMStreamParser::ParseBytes(const uint8_t* data, int size) {
+  int bytes_parsed = 0;
+  while (bytes_parsed < size) {
+    State oldState = state_;
+    int result = ParseElements(data + bytes_parsed, size - bytes_parsed);
+    if (result < 0)
+      return -1;
+
+    if (state_ == oldState && result == 0)
+      break;
+
+    bytes_parsed += result;
+  }
+  return bytes_parsed;
+}
+
+int WebMStreamParser::ParseElements(const uint8_t* data, int size) {
+  int result = -1;
+  switch (state_) {
+    case kParsingHeaders:
+      result = ParseInfoAndTracks(data, size);
+      break;
+
+    case kParsingClusters:
+      result = ParseCluster(data, size);
+      break;
+
+    case kWaitingForInit:
+    case kError:
+      return -1;
+  }
+
+  if (result < 0)
+    ChangeState(kError);
+  return result;
+}
+
 void WebMStreamParser::ChangeState(State new_state) {
   DVLOG(1) << "ChangeState() : " << state_ << " -> " << new_state;
   state_ = new_state;
@@ -233,6 +316,8 @@ int WebMStreamParser::ParseInfoAndTracks(const uint8_t* data, int size) {
     return -1;
   }
 
+  if (cluster_parser_)
+    cluster_bytes_copied_ += cluster_parser_->bytes_copied();
   cluster_parser_.reset(new WebMClusterParser(
       info_parser.timecode_scale(), tracks_parser.audio_track_num(),
       tracks_parser.GetAudioDefaultDuration(timecode_scale_in_us),
@@ -39,6 +39,12 @@ class MEDIA_EXPORT WebMStreamParser : public StreamParser {
   void Flush() override;
   bool Parse(const uint8_t* buf, int size) override;
 
+  // Returns the number of bytes copied into the queue of incomplete elements
+  // and aside by the cluster parser since construction. Buffers parsed out of
+  // complete elements are read straight from the data passed to Parse(). Used
+  // to measure copy overhead.
+  int64_t bytes_copied() const;
+
  private:
   enum State {
     kWaitingForInit,
@@ -49,6 +55,19 @@ class MEDIA_EXPORT WebMStreamParser : public StreamParser {
 
   void ChangeState(State new_state);
 
+  // Parses as much of |byte_queue_| as possible, and pops what was parsed.
+  // Returns false if the parse fails.
+  bool ParseQueue();
+
+  // Parses as much of |data| as possible. Returns the number of bytes parsed,
+  // or -1 if the parse fails.
+  int ParseBytes(const uint8_t* data, int size);
+
+  // Parses the elements at the front of |data| that the current state looks
+  // for, and moves to kError if that fails. Returns the same values as
+  // ParseInfoAndTracks() and ParseCluster().
+  int ParseElements(const uint8_t* data, int size);
+
   // Parses WebM Header, Info, Tracks elements. It also skips other level 1
   // elements that are not used right now. Once the Info & Tracks elements have
   // been parsed, this method will transition the parser from PARSING_HEADERS to
@@ -87,6 +106,9 @@ class MEDIA_EXPORT WebMStreamParser : public StreamParser {
   std::unique_ptr<WebMClusterParser> cluster_parser_;
   ByteQueue byte_queue_;
 
+  // Bytes copied aside by cluster parsers replaced since construction.
+  int64_t cluster_bytes_copied_;
+
   DISALLOW_COPY_AND_ASSIGN(WebMStreamParser);
 };
 
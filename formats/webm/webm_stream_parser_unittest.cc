@@ -4,6 +4,7 @@
 
 #include "media/formats/webm/webm_stream_parser.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "base/bind.h"
@@ -24,13 +25,32 @@ namespace media {
 class WebMStreamParserTest : public testing::Test {
  public:
   WebMStreamParserTest()
-      : media_log_(new testing::StrictMock<MockMediaLog>()) {}
+      : media_log_(new testing::StrictMock<MockMediaLog>()),
+        buffer_count_(0),
+        buffer_bytes_(0) {}
 
  protected:
   void ParseWebMFile(const std::string& filename,
                      const StreamParser::InitParameters& expected_params) {
     scoped_refptr<DecoderBuffer> buffer = ReadTestDataFile(filename);
+    InitParser(expected_params);
+    bool result = parser_->Parse(buffer->data(), buffer->data_size());
+    EXPECT_TRUE(result);
+  }
+
+  // Appends |buffer| to the parser |append_size| bytes at a time.
+  void AppendInPieces(const DecoderBuffer& buffer, int append_size) {
+    const int size = buffer.data_size();
+    for (int offset = 0; offset < size; offset += append_size) {
+      EXPECT_TRUE(parser_->Parse(buffer.data() + offset,
+                                 std::min(append_size, size - offset)));
+    }
+  }
+
+  void InitParser(const StreamParser::InitParameters& expected_params) {
     parser_.reset(new WebMStreamParser());
+    buffer_count_ = 0;
+    buffer_bytes_ = 0;
     Demuxer::EncryptedMediaInitDataCB encrypted_media_init_data_cb =
         base::Bind(&WebMStreamParserTest::OnEncryptedMediaInitData,
                    base::Unretained(this));
@@ -38,9 +58,6 @@ class WebMStreamParserTest : public testing::Test {
     EXPECT_CALL(*this, InitCB(_));
     EXPECT_CALL(*this, NewMediaSegmentCB()).Times(testing::AnyNumber());
     EXPECT_CALL(*this, EndMediaSegmentCB()).Times(testing::AnyNumber());
-    EXPECT_CALL(*this, NewBuffersCB(_))
-        .Times(testing::AnyNumber())
-        .WillRepeatedly(testing::Return(true));
     parser_->Init(
         base::Bind(&WebMStreamParserTest::InitF, base::Unretained(this),
                    expected_params),
@@ -53,8 +70,6 @@ class WebMStreamParserTest : public testing::Test {
         base::Bind(&WebMStreamParserTest::EndMediaSegmentCB,
                    base::Unretained(this)),
         media_log_);
-    bool result = parser_->Parse(buffer->data(), buffer->data_size());
-    EXPECT_TRUE(result);
   }
 
   // Verifies only the detected track counts by track type, then chains to the
@@ -79,7 +94,15 @@ class WebMStreamParserTest : public testing::Test {
     return true;
   }
 
-  MOCK_METHOD1(NewBuffersCB, bool(const StreamParser::BufferQueueMap&));
+  bool NewBuffersCB(const StreamParser::BufferQueueMap& buffer_queue_map) {
+    for (const auto& it : buffer_queue_map) {
+      buffer_count_ += it.second.size();
+      for (const auto& buffer : it.second)
+        buffer_bytes_ += buffer->data_size();
+    }
+    return true;
+  }
+
   MOCK_METHOD2(OnEncryptedMediaInitData,
                void(EmeInitDataType init_data_type,
                     const std::vector<uint8_t>& init_data));
@@ -89,6 +112,10 @@ class WebMStreamParserTest : public testing::Test {
   scoped_refptr<testing::StrictMock<MockMediaLog>> media_log_;
   std::unique_ptr<WebMStreamParser> parser_;
   std::unique_ptr<MediaTracks> media_tracks_;
+
+  // Number and total size of the buffers emitted since InitParser().
+  size_t buffer_count_;
+  size_t buffer_bytes_;
 };
 
 TEST_F(WebMStreamParserTest, VerifyMediaTrackMetadata) {
@@ -153,6 +180,34 @@ TEST_F(WebMStreamParserTest, VerifyDetectedTracks_AVText) {
   EXPECT_EQ(media_tracks_->tracks()[1]->type(), MediaTrack::Audio);
 }
 
+TEST_F(WebMStreamParserTest, AppendSizeDoesNotChangeBuffers) {
+  EXPECT_MEDIA_LOG(testing::HasSubstr("Estimating WebM block duration"))
+      .Times(testing::AnyNumber());
+  StreamParser::InitParameters params(kInfiniteDuration);
+  params.detected_audio_track_count = 1;
+  params.detected_video_track_count = 1;
+  params.detected_text_track_count = 0;
+  scoped_refptr<DecoderBuffer> file = ReadTestDataFile("bear.webm");
+
+  // A file appended at once is parsed in place.
+  InitParser(params);
+  AppendInPieces(*file, file->data_size());
+  EXPECT_EQ(0, parser_->bytes_copied());
+  const size_t buffer_count = buffer_count_;
+  const size_t buffer_bytes = buffer_bytes_;
+  EXPECT_GT(buffer_count, 0u);
+
+  // Elements which straddle appends are put back together.
+  const int kAppendSizes[] = {1, 7, 4096};
+  for (int append_size : kAppendSizes) {
+    InitParser(params);
+    AppendInPieces(*file, append_size);
+    EXPECT_EQ(buffer_count, buffer_count_);
+    EXPECT_EQ(buffer_bytes, buffer_bytes_);
+    EXPECT_GT(parser_->bytes_copied(), 0);
+  }
+}
+
 TEST_F(WebMStreamParserTest, ColourElement) {
   EXPECT_MEDIA_LOG(testing::HasSubstr("Estimating WebM block duration"))
       .Times(testing::AnyNumber());
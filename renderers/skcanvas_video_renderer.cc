@@ -5,13 +5,19 @@
 #include "media/renderers/skcanvas_video_renderer.h"
 
 #include <GLES3/gl3.h>
+
+#include <algorithm>
 #include <limits>
 
+#include "base/bind.h"
 #include "base/macros.h"
+#include "base/sys_info.h"
+#include "base/threading/worker_pool.h"
 #include "gpu/GLES2/gl2extchromium.h"
 #include "gpu/command_buffer/client/gles2_interface.h"
 #include "gpu/command_buffer/common/mailbox_holder.h"
 #include "media/base/data_buffer.h"
+#include "media/base/parallel_row_bands.h"
 #include "media/base/video_frame.h"
 #include "media/base/yuv_convert.h"
 #include "skia/ext/texture_handle.h"
@@ -19,12 +25,14 @@
 #include "third_party/skia/include/core/SkCanvas.h"
 #include "third_party/skia/include/core/SkImage.h"
 #include "third_party/skia/include/core/SkImageGenerator.h"
+#include "third_party/skia/include/core/SkMatrix44.h"
 #include "third_party/skia/include/gpu/GrContext.h"
 #include "third_party/skia/include/gpu/GrPaint.h"
 #include "third_party/skia/include/gpu/GrTexture.h"
 #include "third_party/skia/include/gpu/GrTextureProvider.h"
 #include "third_party/skia/include/gpu/SkGr.h"
 #include "third_party/skia/include/gpu/gl/GrGLTypes.h"
+#include "ui/gfx/color_space.h"
 #include "ui/gfx/geometry/rect_f.h"
 #include "ui/gfx/skia_util.h"
 
@@ -446,84 +454,160 @@ void SkCanvasVideoRenderer::Copy(const scoped_refptr<VideoFrame>& video_frame,
 
 namespace {
 
-// libyuv doesn't support 9- and 10-bit video frames yet. This function
-// creates a regular 8-bit video frame which we can give to libyuv.
-scoped_refptr<VideoFrame> DownShiftHighbitVideoFrame(
-    const VideoFrame* video_frame) {
-  VideoPixelFormat format;
-  int shift = 1;
-  switch (video_frame->format()) {
-    case PIXEL_FORMAT_YUV420P12:
-      shift = 4;
-      format = PIXEL_FORMAT_I420;
-      break;
+// Frames with at least this many visible pixels are converted in row bands on
+// the worker pool as well as the calling thread.
+const int kMinParallelConversionPixels = 1280 * 720;
+
+// Maximum number of threads, including the calling thread, converting a frame.
+const int kMaxConversionThreads = 4;
+
+// Everything needed to convert rows of a frame to ARGB. The high bit depth
+// fields are only set for 9, 10 and 12 bit frames.
+struct RGBConversion {
+  const VideoFrame* video_frame;
+  uint8_t* rgb_pixels;
+  size_t row_bytes;
+  int bit_depth;
+  int uv_width_shift;
+  int uv_height_shift;
+  double yuv_to_rgb_matrix[3][4];
+};
 
+int GetHighBitDepth(VideoPixelFormat format) {
+  switch (format) {
+    case PIXEL_FORMAT_YUV420P9:
+    case PIXEL_FORMAT_YUV422P9:
+    case PIXEL_FORMAT_YUV444P9:
+      return 9;
     case PIXEL_FORMAT_YUV420P10:
-      shift = 2;
-      format = PIXEL_FORMAT_I420;
-      break;
+    case PIXEL_FORMAT_YUV422P10:
+    case PIXEL_FORMAT_YUV444P10:
+      return 10;
+    case PIXEL_FORMAT_YUV420P12:
+    case PIXEL_FORMAT_YUV422P12:
+    case PIXEL_FORMAT_YUV444P12:
+      return 12;
+    default:
+      return 0;
+  }
+}
 
-    case PIXEL_FORMAT_YUV420P9:
-      shift = 1;
-      format = PIXEL_FORMAT_I420;
-      break;
+// Fills |matrix| with the transform from normalized YUV of |video_frame|, and
+// 1, to normalized RGB. Frames without a color space are treated as Rec. 601,
+// as libyuv does for 8 bit frames. Only the YUV matrix and range are taken
+// into account: HDR transfer functions such as PQ and HLG aren't tone mapped.
+void GetYUVToRGBMatrix(const VideoFrame* video_frame, double matrix[3][4]) {
+  gfx::ColorSpace color_space = video_frame->ColorSpace();
+  if (color_space == gfx::ColorSpace())
+    color_space = gfx::ColorSpace::CreateREC601();
+
+  SkMatrix44 transfer_matrix(SkMatrix44::kIdentity_Constructor);
+  SkMatrix44 range_adjust_matrix(SkMatrix44::kIdentity_Constructor);
+  color_space.GetTransferMatrix(&transfer_matrix);
+  color_space.GetRangeAdjustMatrix(&range_adjust_matrix);
+
+  SkMatrix44 yuv_to_rgb(SkMatrix44::kIdentity_Constructor);
+  bool invertible = transfer_matrix.invert(&yuv_to_rgb);
+  DCHECK(invertible);
+  yuv_to_rgb.preConcat(range_adjust_matrix);
+  for (int i = 0; i < 3; ++i) {
+    for (int j = 0; j < 4; ++j)
+      matrix[i][j] = yuv_to_rgb.get(i, j);
+  }
+}
 
-    case PIXEL_FORMAT_YUV422P12:
-      shift = 4;
-      format = PIXEL_FORMAT_YV16;
-      break;
+// Returns the visible data of |plane| of |video_frame| starting at visible
+// frame row |row|, which must be the first row of a sample of |plane|.
+const uint8_t* GetVisibleRowData(const VideoFrame* video_frame,
+                                 size_t plane,
+                                 int row) {
+  const int sample_height =
+      VideoFrame::SampleSize(video_frame->format(), plane).height();
+  DCHECK_EQ(0, row % sample_height);
+  return video_frame->visible_data(plane) +
+         row / sample_height * video_frame->stride(plane);
+}
 
-    case PIXEL_FORMAT_YUV422P10:
-      shift = 2;
-      format = PIXEL_FORMAT_YV16;
-      break;
+// Converts the visible rows [begin_row, end_row) of |conversion|'s frame.
+// |begin_row| must be the first row of a chroma sample.
+void ConvertVideoFrameRowsToRGBPixels(const RGBConversion* conversion,
+                                      int begin_row,
+                                      int end_row) {
+  const VideoFrame* video_frame = conversion->video_frame;
+  const uint8_t* y_data =
+      GetVisibleRowData(video_frame, VideoFrame::kYPlane, begin_row);
+  const uint8_t* u_data =
+      GetVisibleRowData(video_frame, VideoFrame::kUPlane, begin_row);
+  const uint8_t* v_data =
+      GetVisibleRowData(video_frame, VideoFrame::kVPlane, begin_row);
+  const int y_stride = video_frame->stride(VideoFrame::kYPlane);
+  const int u_stride = video_frame->stride(VideoFrame::kUPlane);
+  const int v_stride = video_frame->stride(VideoFrame::kVPlane);
+  uint8_t* rgb_pixels =
+      conversion->rgb_pixels + begin_row * conversion->row_bytes;
+  const int row_bytes = static_cast<int>(conversion->row_bytes);
+  const int width = video_frame->visible_rect().width();
+  const int height = end_row - begin_row;
 
-    case PIXEL_FORMAT_YUV422P9:
-      shift = 1;
-      format = PIXEL_FORMAT_YV16;
+  switch (video_frame->format()) {
+    case PIXEL_FORMAT_YV12:
+    case PIXEL_FORMAT_I420:
+      if (CheckColorSpace(video_frame, COLOR_SPACE_JPEG)) {
+        LIBYUV_J420_TO_ARGB(y_data, y_stride, u_data, u_stride, v_data,
+                            v_stride, rgb_pixels, row_bytes, width, height);
+      } else if (CheckColorSpace(video_frame, COLOR_SPACE_HD_REC709)) {
+        LIBYUV_H420_TO_ARGB(y_data, y_stride, u_data, u_stride, v_data,
+                            v_stride, rgb_pixels, row_bytes, width, height);
+      } else {
+        LIBYUV_I420_TO_ARGB(y_data, y_stride, u_data, u_stride, v_data,
+                            v_stride, rgb_pixels, row_bytes, width, height);
+      }
+      break;
+    case PIXEL_FORMAT_YV16:
+    case PIXEL_FORMAT_I422:
+      LIBYUV_I422_TO_ARGB(y_data, y_stride, u_data, u_stride, v_data, v_stride,
+                          rgb_pixels, row_bytes, width, height);
       break;
 
-    case PIXEL_FORMAT_YUV444P12:
-      shift = 4;
-      format = PIXEL_FORMAT_YV24;
+    case PIXEL_FORMAT_YV12A:
+      LIBYUV_I420ALPHA_TO_ARGB(
+          y_data, y_stride, u_data, u_stride, v_data, v_stride,
+          GetVisibleRowData(video_frame, VideoFrame::kAPlane, begin_row),
+          video_frame->stride(VideoFrame::kAPlane), rgb_pixels, row_bytes,
+          width, height,
+          1);  // 1 = enable RGB premultiplication by Alpha.
       break;
 
-    case PIXEL_FORMAT_YUV444P10:
-      shift = 2;
-      format = PIXEL_FORMAT_YV24;
+    case PIXEL_FORMAT_YV24:
+      LIBYUV_I444_TO_ARGB(y_data, y_stride, u_data, u_stride, v_data, v_stride,
+                          rgb_pixels, row_bytes, width, height);
       break;
 
+    // libyuv doesn't support 9, 10 and 12 bit frames, so they are converted
+    // to ARGB in a single pass rather than shifted down to an 8 bit frame
+    // first.
+    case PIXEL_FORMAT_YUV420P9:
+    case PIXEL_FORMAT_YUV422P9:
     case PIXEL_FORMAT_YUV444P9:
-      shift = 1;
-      format = PIXEL_FORMAT_YV24;
+    case PIXEL_FORMAT_YUV420P10:
+    case PIXEL_FORMAT_YUV422P10:
+    case PIXEL_FORMAT_YUV444P10:
+    case PIXEL_FORMAT_YUV420P12:
+    case PIXEL_FORMAT_YUV422P12:
+    case PIXEL_FORMAT_YUV444P12:
+      DCHECK_EQ(u_stride, v_stride);
+      ConvertHighBitDepthYUVToARGB(
+          reinterpret_cast<const uint16_t*>(y_data),
+          reinterpret_cast<const uint16_t*>(u_data),
+          reinterpret_cast<const uint16_t*>(v_data), rgb_pixels, width, height,
+          y_stride, u_stride, row_bytes, conversion->uv_width_shift,
+          conversion->uv_height_shift, conversion->bit_depth,
+          conversion->yuv_to_rgb_matrix);
       break;
 
     default:
       NOTREACHED();
-      return nullptr;
   }
-  scoped_refptr<VideoFrame> ret = VideoFrame::CreateFrame(
-      format, video_frame->coded_size(), video_frame->visible_rect(),
-      video_frame->natural_size(), video_frame->timestamp());
-
-  // Copy all metadata.
-  // (May be enough to copy color space)
-  ret->metadata()->MergeMetadataFrom(video_frame->metadata());
-
-  for (int plane = VideoFrame::kYPlane; plane <= VideoFrame::kVPlane; ++plane) {
-    int width = ret->row_bytes(plane);
-    const uint16_t* src =
-        reinterpret_cast<const uint16_t*>(video_frame->data(plane));
-    uint8_t* dst = ret->data(plane);
-    for (int row = 0; row < video_frame->rows(plane); row++) {
-      for (int x = 0; x < width; x++) {
-        dst[x] = src[x] >> shift;
-      }
-      src += video_frame->stride(plane) / 2;
-      dst += ret->stride(plane);
-    }
-  }
-  return ret;
 }
 
 // Converts 16-bit data to |out| buffer of specified GL |type|.
@@ -628,6 +712,26 @@ void SkCanvasVideoRenderer::ConvertVideoFrameToRGBPixels(
     const VideoFrame* video_frame,
     void* rgb_pixels,
     size_t row_bytes) {
+  const gfx::Rect& visible_rect = video_frame->visible_rect();
+  int max_tasks = 0;
+  if (visible_rect.width() * visible_rect.height() >=
+      kMinParallelConversionPixels) {
+    max_tasks = std::min(base::SysInfo::NumberOfProcessors(),
+                         kMaxConversionThreads) -
+                1;
+  }
+  ConvertVideoFrameToRGBPixels(video_frame, rgb_pixels, row_bytes,
+                               base::WorkerPool::GetTaskRunner(true).get(),
+                               max_tasks);
+}
+
+// static
+void SkCanvasVideoRenderer::ConvertVideoFrameToRGBPixels(
+    const VideoFrame* video_frame,
+    void* rgb_pixels,
+    size_t row_bytes,
+    base::TaskRunner* task_runner,
+    int max_tasks) {
   if (!video_frame->IsMappable()) {
     NOTREACHED() << "Cannot extract pixels from non-CPU frame formats.";
     return;
@@ -636,79 +740,10 @@ void SkCanvasVideoRenderer::ConvertVideoFrameToRGBPixels(
   switch (video_frame->format()) {
     case PIXEL_FORMAT_YV12:
     case PIXEL_FORMAT_I420:
-      if (CheckColorSpace(video_frame, COLOR_SPACE_JPEG)) {
-        LIBYUV_J420_TO_ARGB(video_frame->visible_data(VideoFrame::kYPlane),
-                            video_frame->stride(VideoFrame::kYPlane),
-                            video_frame->visible_data(VideoFrame::kUPlane),
-                            video_frame->stride(VideoFrame::kUPlane),
-                            video_frame->visible_data(VideoFrame::kVPlane),
-                            video_frame->stride(VideoFrame::kVPlane),
-                            static_cast<uint8_t*>(rgb_pixels), row_bytes,
-                            video_frame->visible_rect().width(),
-                            video_frame->visible_rect().height());
-      } else if (CheckColorSpace(video_frame, COLOR_SPACE_HD_REC709)) {
-        LIBYUV_H420_TO_ARGB(video_frame->visible_data(VideoFrame::kYPlane),
-                            video_frame->stride(VideoFrame::kYPlane),
-                            video_frame->visible_data(VideoFrame::kUPlane),
-                            video_frame->stride(VideoFrame::kUPlane),
-                            video_frame->visible_data(VideoFrame::kVPlane),
-                            video_frame->stride(VideoFrame::kVPlane),
-                            static_cast<uint8_t*>(rgb_pixels), row_bytes,
-                            video_frame->visible_rect().width(),
-                            video_frame->visible_rect().height());
-      } else {
-        LIBYUV_I420_TO_ARGB(video_frame->visible_data(VideoFrame::kYPlane),
-                            video_frame->stride(VideoFrame::kYPlane),
-                            video_frame->visible_data(VideoFrame::kUPlane),
-                            video_frame->stride(VideoFrame::kUPlane),
-                            video_frame->visible_data(VideoFrame::kVPlane),
-                            video_frame->stride(VideoFrame::kVPlane),
-                            static_cast<uint8_t*>(rgb_pixels), row_bytes,
-                            video_frame->visible_rect().width(),
-                            video_frame->visible_rect().height());
-      }
-      break;
     case PIXEL_FORMAT_YV16:
     case PIXEL_FORMAT_I422:
-      LIBYUV_I422_TO_ARGB(video_frame->visible_data(VideoFrame::kYPlane),
-                          video_frame->stride(VideoFrame::kYPlane),
-                          video_frame->visible_data(VideoFrame::kUPlane),
-                          video_frame->stride(VideoFrame::kUPlane),
-                          video_frame->visible_data(VideoFrame::kVPlane),
-                          video_frame->stride(VideoFrame::kVPlane),
-                          static_cast<uint8_t*>(rgb_pixels), row_bytes,
-                          video_frame->visible_rect().width(),
-                          video_frame->visible_rect().height());
-      break;
-
     case PIXEL_FORMAT_YV12A:
-      LIBYUV_I420ALPHA_TO_ARGB(
-          video_frame->visible_data(VideoFrame::kYPlane),
-          video_frame->stride(VideoFrame::kYPlane),
-          video_frame->visible_data(VideoFrame::kUPlane),
-          video_frame->stride(VideoFrame::kUPlane),
-          video_frame->visible_data(VideoFrame::kVPlane),
-          video_frame->stride(VideoFrame::kVPlane),
-          video_frame->visible_data(VideoFrame::kAPlane),
-          video_frame->stride(VideoFrame::kAPlane),
-          static_cast<uint8_t*>(rgb_pixels), row_bytes,
-          video_frame->visible_rect().width(),
-          video_frame->visible_rect().height(),
-          1);  // 1 = enable RGB premultiplication by Alpha.
-      break;
-
     case PIXEL_FORMAT_YV24:
-      LIBYUV_I444_TO_ARGB(video_frame->visible_data(VideoFrame::kYPlane),
-                          video_frame->stride(VideoFrame::kYPlane),
-                          video_frame->visible_data(VideoFrame::kUPlane),
-                          video_frame->stride(VideoFrame::kUPlane),
-                          video_frame->visible_data(VideoFrame::kVPlane),
-                          video_frame->stride(VideoFrame::kVPlane),
-                          static_cast<uint8_t*>(rgb_pixels), row_bytes,
-                          video_frame->visible_rect().width(),
-                          video_frame->visible_rect().height());
-      break;
-
     case PIXEL_FORMAT_YUV420P9:
     case PIXEL_FORMAT_YUV422P9:
     case PIXEL_FORMAT_YUV444P9:
@@ -718,10 +753,25 @@ void SkCanvasVideoRenderer::ConvertVideoFrameToRGBPixels(
     case PIXEL_FORMAT_YUV420P12:
     case PIXEL_FORMAT_YUV422P12:
     case PIXEL_FORMAT_YUV444P12: {
-      scoped_refptr<VideoFrame> temporary_frame =
-          DownShiftHighbitVideoFrame(video_frame);
-      ConvertVideoFrameToRGBPixels(temporary_frame.get(), rgb_pixels,
-                                   row_bytes);
+      RGBConversion conversion;
+      conversion.video_frame = video_frame;
+      conversion.rgb_pixels = static_cast<uint8_t*>(rgb_pixels);
+      conversion.row_bytes = row_bytes;
+      const gfx::Size uv_sample_size =
+          VideoFrame::SampleSize(video_frame->format(), VideoFrame::kUPlane);
+      conversion.bit_depth = GetHighBitDepth(video_frame->format());
+      conversion.uv_width_shift = uv_sample_size.width() / 2;
+      conversion.uv_height_shift = uv_sample_size.height() / 2;
+      if (conversion.bit_depth)
+        GetYUVToRGBMatrix(video_frame, conversion.yuv_to_rgb_matrix);
+
+      // Bands start on the first row of a chroma sample, so that no chroma
+      // row is shared between bands.
+      const gfx::Rect& visible_rect = video_frame->visible_rect();
+      RunInParallelRowBands(
+          visible_rect.height(), static_cast<size_t>(visible_rect.width()) * 4,
+          uv_sample_size.height(), task_runner, max_tasks,
+          base::Bind(&ConvertVideoFrameRowsToRGBPixels, &conversion));
       break;
     }
 
@@ -23,6 +23,10 @@
 
 class SkCanvas;
 
+namespace base {
+class TaskRunner;
+}
+
 namespace gfx {
 class RectF;
 }
@@ -62,6 +66,15 @@ class MEDIA_EXPORT SkCanvasVideoRenderer {
                                            void* rgb_pixels,
                                            size_t row_bytes);
 
+  // Like the above, but large frames are converted in bands of rows by the
+  // calling thread and by up to |max_tasks| tasks posted to |task_runner|, see
+  // RunInParallelRowBands(). The above uses the worker pool for large frames.
+  static void ConvertVideoFrameToRGBPixels(const media::VideoFrame* video_frame,
+                                           void* rgb_pixels,
+                                           size_t row_bytes,
+                                           base::TaskRunner* task_runner,
+                                           int max_tasks);
+
   // Copy the contents of texture of |video_frame| to texture |texture|.
   // |level|, |internal_format|, |type| specify target texture |texture|.
   // The format of |video_frame| must be VideoFrame::NATIVE_TEXTURE.
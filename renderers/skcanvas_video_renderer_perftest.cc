@@ -0,0 +1,127 @@
+// Copyright 2017 The Chromium Authors. All rights reserved.
+// Use of this source code is governed by a BSD-style license that can be
+// found in the LICENSE file.
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <memory>
+#include <string>
+
+#include "base/macros.h"
+#include "base/strings/stringprintf.h"
+#include "base/threading/worker_pool.h"
+#include "base/time/time.h"
+#include "media/base/video_frame.h"
+#include "media/renderers/skcanvas_video_renderer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "testing/perf/perf_test.h"
+#include "ui/gfx/color_space.h"
+#include "ui/gfx/geometry/rect.h"
+#include "ui/gfx/geometry/size.h"
+
+namespace media {
+
+// Each frame is converted until at least this many pixels have been output.
+static const double kBenchmarkPixels = 256.0 * 1024 * 1024;
+
+static const int kWidth = 3840;
+static const int kHeight = 2160;
+
+class SkCanvasVideoRendererPerfTest : public testing::Test {
+ public:
+  SkCanvasVideoRendererPerfTest()
+      : rgb_pixels_(new uint8_t[kWidth * kHeight * 4]) {}
+
+  // Converts a 4K |format| frame in |color_space| to ARGB and reports the
+  // throughput in megapixels per second. Conversions run on the calling
+  // thread and |max_tasks| worker pool tasks, or as in production if
+  // |max_tasks| is negative.
+  void RunConvertBenchmark(VideoPixelFormat format,
+                           int bit_depth,
+                           const gfx::ColorSpace& color_space,
+                           const std::string& trace_name,
+                           int max_tasks = -1) {
+    const gfx::Size size(kWidth, kHeight);
+    scoped_refptr<VideoFrame> frame = VideoFrame::CreateFrame(
+        format, size, gfx::Rect(size), size, base::TimeDelta());
+    ASSERT_TRUE(frame);
+    frame->set_color_space(color_space);
+    for (size_t plane = VideoFrame::kYPlane; plane <= VideoFrame::kVPlane;
+         ++plane) {
+      if (bit_depth == 8) {
+        uint8_t* data = frame->data(plane);
+        const size_t samples = frame->stride(plane) * frame->rows(plane);
+        for (size_t i = 0; i < samples; ++i)
+          data[i] = static_cast<uint8_t>((i * 2654435761u) >> 24);
+        continue;
+      }
+      uint16_t* data = reinterpret_cast<uint16_t*>(frame->data(plane));
+      const size_t samples = frame->stride(plane) / 2 * frame->rows(plane);
+      for (size_t i = 0; i < samples; ++i)
+        data[i] = static_cast<uint16_t>((i * 2654435761u) >> (32 - bit_depth));
+    }
+
+    double total_pixels = 0;
+    base::TimeTicks start = base::TimeTicks::Now();
+    while (total_pixels < kBenchmarkPixels) {
+      if (max_tasks < 0) {
+        SkCanvasVideoRenderer::ConvertVideoFrameToRGBPixels(
+            frame.get(), rgb_pixels_.get(), kWidth * 4);
+      } else {
+        SkCanvasVideoRenderer::ConvertVideoFrameToRGBPixels(
+            frame.get(), rgb_pixels_.get(), kWidth * 4,
+            base::WorkerPool::GetTaskRunner(true).get(), max_tasks);
+      }
+      total_pixels += kWidth * kHeight;
+    }
+    const double total_time_seconds =
+        (base::TimeTicks::Now() - start).InSecondsF();
+
+    perf_test::PrintResult("skcanvas_video_renderer_convert", "", trace_name,
+                           total_pixels / total_time_seconds / 1000000,
+                           "megapixels/s", true);
+  }
+
+ private:
+  std::unique_ptr<uint8_t[]> rgb_pixels_;
+
+  DISALLOW_COPY_AND_ASSIGN(SkCanvasVideoRendererPerfTest);
+};
+
+TEST_F(SkCanvasVideoRendererPerfTest, HighBitDepth) {
+  const gfx::ColorSpace rec709 = gfx::ColorSpace::CreateREC709();
+  RunConvertBenchmark(PIXEL_FORMAT_YUV420P9, 9, rec709, "yuv420p9");
+  RunConvertBenchmark(PIXEL_FORMAT_YUV422P9, 9, rec709, "yuv422p9");
+  RunConvertBenchmark(PIXEL_FORMAT_YUV444P9, 9, rec709, "yuv444p9");
+  RunConvertBenchmark(PIXEL_FORMAT_YUV420P10, 10, rec709, "yuv420p10");
+  RunConvertBenchmark(PIXEL_FORMAT_YUV422P10, 10, rec709, "yuv422p10");
+  RunConvertBenchmark(PIXEL_FORMAT_YUV444P10, 10, rec709, "yuv444p10");
+  RunConvertBenchmark(PIXEL_FORMAT_YUV420P12, 12, rec709, "yuv420p12");
+  RunConvertBenchmark(PIXEL_FORMAT_YUV422P12, 12, rec709, "yuv422p12");
+  RunConvertBenchmark(PIXEL_FORMAT_YUV444P12, 12, rec709, "yuv444p12");
+}
+
+// HDR10 content: 10 bit Rec. 2020 with the SMPTE ST 2084 transfer function.
+TEST_F(SkCanvasVideoRendererPerfTest, HDR10) {
+  const gfx::ColorSpace hdr10(gfx::ColorSpace::PrimaryID::BT2020,
+                              gfx::ColorSpace::TransferID::SMPTEST2084,
+                              gfx::ColorSpace::MatrixID::BT2020_NCL,
+                              gfx::ColorSpace::RangeID::LIMITED);
+  RunConvertBenchmark(PIXEL_FORMAT_YUV420P10, 10, hdr10, "yuv420p10_hdr10");
+}
+
+// Scaling of 8 and 10 bit conversions in row bands from 1 to 4 threads.
+TEST_F(SkCanvasVideoRendererPerfTest, RowBands) {
+  const gfx::ColorSpace rec709 = gfx::ColorSpace::CreateREC709();
+  for (int threads = 1; threads <= 4; ++threads) {
+    RunConvertBenchmark(PIXEL_FORMAT_I420, 8, rec709,
+                        base::StringPrintf("i420_%d_threads", threads),
+                        threads - 1);
+    RunConvertBenchmark(PIXEL_FORMAT_YUV420P10, 10, rec709,
+                        base::StringPrintf("yuv420p10_%d_threads", threads),
+                        threads - 1);
+  }
+}
+
+}  // namespace media